@@ -16,26 +16,87 @@
 
 #include <string.h>
 #include "parse.h"
+#include "read.h"
+#include "vstring.h"
+
+/*
+*   DATA DEFINITIONS
+*/
+typedef enum {
+	K_PROJECT, K_TARGET
+} antKind;
+
+static kindOption AntKinds [] = {
+	{ TRUE, 'p', "project", "projects" },
+	{ TRUE, 't', "target",  "targets" }
+};
 
 /*
 *   FUNCTION DEFINITIONS
 */
 
-static void installAntRegex (const langType language)
+static const unsigned char *skipBlanks (const unsigned char *cp)
 {
-	addTagRegex (language,
-		"^[ \t]*<[ \t]*project.*name=\"([^\"]+)\".*", "\\1", "p,project,projects", NULL);
-	addTagRegex (language,
-		"^[ \t]*<[ \t]*target.*name=\"([^\"]+)\".*", "\\1", "t,target,targets", NULL);
+	while (*cp == ' '  ||  *cp == '\t')
+		++cp;
+	return cp;
+}
+
+/*  Makes a tag for a line beginning with the "element", taking its name
+ *  from the last attribute of the line of the form name="name".
+ */
+static boolean findElement (
+		const unsigned char *cp, const char *const element,
+		vString *const name, const antKind kind)
+{
+	const size_t length = strlen (element);
+	boolean result = FALSE;
+	if (strncmp ((const char*) cp, element, length) == 0)
+	{
+		const char *attribute = strstr ((const char*) cp + length, "name=\"");
+		result = TRUE;
+		vStringClear (name);
+		while (attribute != NULL)
+		{
+			const char *const value = attribute + 6;
+			const char *const end = strchr (value, '"');
+			if (end != NULL  &&  end > value)
+				vStringNCopyS (name, value, end - value);
+			attribute = strstr (attribute + 1, "name=\"");
+		}
+		vStringStripLeading (name);
+		vStringStripTrailing (name);
+		makeSimpleTag (name, AntKinds, kind);
+	}
+	return result;
+}
+
+static void findAntTags (void)
+{
+	vString *const name = vStringNew ();
+	const unsigned char *line;
+
+	while ((line = fileReadLine ()) != NULL)
+	{
+		const unsigned char *cp = skipBlanks (line);
+		if (*cp == '<')
+		{
+			cp = skipBlanks (cp + 1);
+			if (! findElement (cp, "project", name, K_PROJECT))
+				findElement (cp, "target", name, K_TARGET);
+		}
+	}
+	vStringDelete (name);
 }
 
 extern parserDefinition* AntParser ()
 {
 	static const char *const extensions [] = { "build.xml", NULL };
 	parserDefinition* const def = parserNew ("Ant");
+	def->kinds      = AntKinds;
+	def->kindCount  = KIND_COUNT (AntKinds);
 	def->extensions = extensions;
-	def->initialize = installAntRegex;
-	def->regex      = TRUE;
+	def->parser     = findAntTags;
 	return def;
 }
 
@@ -0,0 +1,578 @@
+/*
+*   $Id$
+*
+*   Copyright (c) 2026, Exuberant Ctags contributors
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License.
+*
+*   This module contains functions to tag the source files held within zip
+*   and tar archives (see --archives). Each member is read into memory as it
+*   is tagged and supplied to the parser in place of a file, so that the
+*   archive is never extracted to disk.
+*
+*   A zip archive, as is a jar file, is read through its central directory,
+*   which ends the archive and gives for each member its name, its method of
+*   compression and the offset of its local header, after which its bytes
+*   follow. A tar archive is read from its start, as a header of 512 bytes
+*   before the bytes of each member, padded to a multiple of 512 bytes.
+*/
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#include <string.h>
+#include <stdio.h>
+#ifdef HAVE_STDLIB_H
+# include <stdlib.h>  /* to declare strtoul () */
+#endif
+#ifdef HAVE_ZLIB
+# include <zlib.h>
+#endif
+
+#include "archive.h"
+#include "debug.h"
+#include "options.h"
+#include "parse.h"
+#include "read.h"
+#include "routines.h"
+#include "vstring.h"
+
+/*
+*   MACROS
+*/
+#define MEMBER_SEPARATOR        "!/"  /* between archive and member names */
+
+#define ZIP_END_SIGNATURE       "PK\005\006"
+#define ZIP_ENTRY_SIGNATURE     "PK\001\002"
+#define ZIP_LOCAL_SIGNATURE     "PK\003\004"
+#define ZIP64_MARKER            0xffffffffUL  /* value moved to zip64 field */
+
+#define TAR_USTAR_MAGIC         "ustar"
+
+/*
+*   DATA DECLARATIONS
+*/
+typedef enum {
+	ARCHIVE_NONE, ARCHIVE_ZIP, ARCHIVE_TAR, ARCHIVE_TAR_GZIP
+} archiveType;
+
+enum eArchiveLimits {
+	ZipEndSize = 22,         /* bytes in end of central directory record */
+	ZipCommentMax = 0xffff,  /* bytes in comment of archive, at most */
+	ZipEntrySize = 46,       /* bytes in directory entry, before its name */
+	ZipLocalSize = 30,       /* bytes in local header, before its name */
+	ZipStored = 0,           /* methods of compression of a member */
+	ZipDeflated = 8,
+	TarBlockSize = 512
+};
+
+#ifdef HAVE_ZLIB
+typedef gzFile tarStream;  /* reads a tar archive, compressed or not */
+#else
+typedef FILE *tarStream;
+#endif
+
+typedef struct sArchive {
+	const char *name;
+	FILE *fp;
+	vString *member;         /* name of member being read, as tagged */
+	unsigned char *bytes;    /* contents of member being read */
+	size_t size;             /* allocated to bytes */
+	unsigned char *packed;   /* compressed contents of zip member */
+	size_t packedSize;       /* allocated to packed */
+	boolean resize;          /* was tag file resized by any member? */
+} archive;
+
+/*
+*   DATA DEFINITIONS
+*/
+static const struct sArchiveSuffix {
+	const char *suffix;
+	archiveType type;
+} ArchiveSuffixes [] = {
+	{ ".zip",       ARCHIVE_ZIP      },
+	{ ".jar",       ARCHIVE_ZIP      },
+	{ ".tar",       ARCHIVE_TAR      },
+	{ ".tar.gz",    ARCHIVE_TAR_GZIP },
+	{ ".tgz",       ARCHIVE_TAR_GZIP }
+};
+
+/*
+*   FUNCTION DEFINITIONS
+*/
+
+static archiveType getArchiveType (const char *const fileName)
+{
+	const size_t length = strlen (fileName);
+	archiveType result = ARCHIVE_NONE;
+	unsigned int i;
+	for (i = 0  ;  i < sizeof (ArchiveSuffixes) / sizeof (ArchiveSuffixes [0])
+			&&  result == ARCHIVE_NONE  ;  ++i)
+	{
+		const size_t suffixLength = strlen (ArchiveSuffixes [i].suffix);
+		if (length > suffixLength  &&  struppercmp (
+				fileName + length - suffixLength, ArchiveSuffixes [i].suffix) == 0)
+			result = ArchiveSuffixes [i].type;
+	}
+	return result;
+}
+
+extern boolean isArchiveFile (const char *const fileName)
+{
+	return (boolean) (Option.archives  &&
+			getArchiveType (fileName) != ARCHIVE_NONE);
+}
+
+static unsigned long readLittleEndian (
+		const unsigned char *const p, const unsigned int bytes)
+{
+	unsigned long result = 0;
+	unsigned int i;
+	for (i = bytes  ;  i > 0  ;  --i)
+		result = (result << 8) | p [i - 1];
+	return result;
+}
+
+/*  Ensures that "buffer" holds at least "length" bytes and a terminator.
+ */
+static void reserveBytes (
+		unsigned char **const buffer, size_t *const size, const size_t length)
+{
+	if (length + 1 > *size)
+	{
+		*size = length + 1;
+		*buffer = xRealloc (*buffer, *size, unsigned char);
+	}
+}
+
+/*  Names the member "name" of the archive as it is to be tagged, returning
+ *  the language in which it is to be parsed, or LANG_IGNORE if it is not to
+ *  be parsed at all. Its language is determined from its name alone, so
+ *  that members which are not source files are never read.
+ */
+static langType nameMember (
+		archive *const a, const char *name, size_t length)
+{
+	langType language = LANG_IGNORE;
+
+	while (length > 2  &&  strncmp (name, "./", 2) == 0)
+	{
+		name += 2;
+		length -= 2;
+	}
+	vStringCopyS (a->member, a->name);
+	vStringCatS (a->member, MEMBER_SEPARATOR);
+	vStringNCatS (a->member, name, length);
+	if (vStringLast (a->member) == '/')
+		;  /* directory */
+	else if (isExcludedFile (vStringValue (a->member)))
+		verbose ("excluding \"%s\"\n", vStringValue (a->member));
+	else if (Option.language != LANG_AUTO)
+		language = Option.language;
+	else
+		language = getFileNameLanguage (vStringValue (a->member));
+	return language;
+}
+
+/*  Parses the "length" bytes of the member just read.
+ */
+static void tagMember (
+		archive *const a, const langType language, const size_t length)
+{
+	a->bytes [length] = '\0';
+	fileSupplyContents (vStringValue (a->member), a->bytes, length);
+	a->resize |= parseFileAs (vStringValue (a->member), language);
+	fileReleaseContents ();
+}
+
+/*
+*   Zip archives
+*/
+
+static boolean readBytesAt (
+		FILE *const fp, const unsigned long offset,
+		unsigned char *const buffer, const size_t length)
+{
+	return (boolean) (fseek (fp, (long) offset, SEEK_SET) == 0  &&
+			fread (buffer, 1, length, fp) == length);
+}
+
+/*  Finds the record which ends the archive, and which may be followed only
+ *  by a comment, to read the size and offset of its central directory.
+ */
+static boolean findZipDirectory (
+		archive *const a, unsigned long *const offset,
+		unsigned long *const size, unsigned long *const count)
+{
+	boolean found = FALSE;
+	long archiveSize;
+
+	if (fseek (a->fp, 0L, SEEK_END) == 0  &&
+		(archiveSize = ftell (a->fp)) >= ZipEndSize)
+	{
+		const size_t tail = (size_t) archiveSize < ZipEndSize + ZipCommentMax ?
+				(size_t) archiveSize : ZipEndSize + ZipCommentMax;
+		unsigned char *const buffer = xMalloc (tail, unsigned char);
+
+		if (readBytesAt (a->fp, (unsigned long) archiveSize - tail, buffer, tail))
+		{
+			size_t i;
+			for (i = tail - ZipEndSize + 1  ;  i > 0  &&  ! found  ;  --i)
+			{
+				const unsigned char *const end = buffer + i - 1;
+				if (memcmp (end, ZIP_END_SIGNATURE, 4) == 0)
+				{
+					*count  = readLittleEndian (end + 10, 2);
+					*size   = readLittleEndian (end + 12, 4);
+					*offset = readLittleEndian (end + 16, 4);
+					found = TRUE;
+				}
+			}
+		}
+		eFree (buffer);
+	}
+	return found;
+}
+
+#ifdef HAVE_ZLIB
+static boolean inflateMember (
+		const unsigned char *const packed, const size_t packedLength,
+		unsigned char *const bytes, const size_t length)
+{
+	boolean result = FALSE;
+	z_stream stream;
+
+	memset (&stream, 0, sizeof (stream));
+	if (inflateInit2 (&stream, -MAX_WBITS) == Z_OK)  /* raw deflate data */
+	{
+		stream.next_in   = (Bytef *) packed;
+		stream.avail_in  = (uInt) packedLength;
+		stream.next_out  = bytes;
+		stream.avail_out = (uInt) length;
+		result = (boolean) (inflate (&stream, Z_FINISH) == Z_STREAM_END  &&
+				stream.total_out == length);
+		inflateEnd (&stream);
+	}
+	return result;
+}
+#endif
+
+/*  Reads into a->bytes the member described by "entry" of the central
+ *  directory, storing its length in "length".
+ */
+static boolean readZipMember (
+		archive *const a, const unsigned char *const entry,
+		size_t *const length)
+{
+	const unsigned long flags = readLittleEndian (entry + 8, 2);
+	const unsigned long method = readLittleEndian (entry + 10, 2);
+	const unsigned long packedLength = readLittleEndian (entry + 20, 4);
+	const unsigned long unpackedLength = readLittleEndian (entry + 24, 4);
+	const unsigned long local = readLittleEndian (entry + 42, 4);
+	const char *const name = vStringValue (a->member);
+	unsigned char header [ZipLocalSize];
+	boolean result = FALSE;
+
+	if (flags & 0x0001)
+		error (WARNING, "%s: encrypted, so skipped", name);
+	else if (packedLength == ZIP64_MARKER  ||  unpackedLength == ZIP64_MARKER  ||
+			 local == ZIP64_MARKER)
+		error (WARNING, "%s: too large for zip format, so skipped", name);
+	else if (method != ZipStored  &&  method != ZipDeflated)
+		error (WARNING, "%s: compression method %lu is not supported", name,
+				method);
+#ifndef HAVE_ZLIB
+	else if (method == ZipDeflated)
+		error (WARNING, "%s: cannot decompress on this host", name);
+#endif
+	else if (! readBytesAt (a->fp, local, header, ZipLocalSize)  ||
+			 memcmp (header, ZIP_LOCAL_SIGNATURE, 4) != 0)
+		error (WARNING, "%s: not a valid zip member", name);
+	else
+	{
+		const unsigned long start = local + ZipLocalSize +
+				readLittleEndian (header + 26, 2) +
+				readLittleEndian (header + 28, 2);
+
+		reserveBytes (&a->bytes, &a->size, unpackedLength);
+		*length = unpackedLength;
+		if (method == ZipStored)
+			result = readBytesAt (a->fp, start, a->bytes, unpackedLength);
+#ifdef HAVE_ZLIB
+		else if (unpackedLength == 0)
+			result = TRUE;
+		else
+		{
+			reserveBytes (&a->packed, &a->packedSize, packedLength);
+			result = (boolean) (
+					readBytesAt (a->fp, start, a->packed, packedLength)  &&
+					inflateMember (a->packed, packedLength,
+							a->bytes, unpackedLength));
+		}
+#endif
+		if (! result)
+			error (WARNING, "%s: cannot read zip member", name);
+	}
+	return result;
+}
+
+static void parseZipDirectory (
+		archive *const a, const unsigned char *const directory,
+		const unsigned long size, const unsigned long count)
+{
+	const unsigned char *p = directory;
+	const unsigned char *const end = directory + size;
+	unsigned long i;
+
+	for (i = 0  ;  i < count  &&  p + ZipEntrySize <= end  &&
+			memcmp (p, ZIP_ENTRY_SIGNATURE, 4) == 0  ;  ++i)
+	{
+		const size_t nameLength = readLittleEndian (p + 28, 2);
+		const unsigned char *const next = p + ZipEntrySize + nameLength +
+				readLittleEndian (p + 30, 2) + readLittleEndian (p + 32, 2);
+		if (next <= end)
+		{
+			const langType language = nameMember (a,
+					(const char *) p + ZipEntrySize, nameLength);
+			size_t length;
+			if (language != LANG_IGNORE  &&  readZipMember (a, p, &length))
+				tagMember (a, language, length);
+		}
+		p = next;
+	}
+	if (i < count)
+		error (WARNING, "%s: zip directory is not valid", a->name);
+}
+
+static void parseZipArchive (archive *const a)
+{
+	unsigned long offset, size, count;
+
+	if (! findZipDirectory (a, &offset, &size, &count))
+		error (WARNING, "%s: not a zip archive", a->name);
+	else if (offset == ZIP64_MARKER  ||  count == 0xffff)
+		error (WARNING, "%s: zip64 archives are not supported", a->name);
+	else
+	{
+		unsigned char *const directory = xMalloc (size + 1, unsigned char);
+		if (! readBytesAt (a->fp, offset, directory, size))
+			error (WARNING, "%s: cannot read zip directory", a->name);
+		else
+			parseZipDirectory (a, directory, size, count);
+		eFree (directory);
+	}
+}
+
+/*
+*   Tar archives
+*/
+
+static tarStream openTarStream (const char *const fileName)
+{
+#ifdef HAVE_ZLIB
+	return gzopen (fileName, "rb");  /* reads uncompressed files as they are */
+#else
+	return fopen (fileName, "rb");
+#endif
+}
+
+static boolean readTarBytes (
+		tarStream stream, unsigned char *const buffer, const size_t length)
+{
+#ifdef HAVE_ZLIB
+	return (boolean) (gzread (stream, buffer, (unsigned) length) == (int) length);
+#else
+	return (boolean) (fread (buffer, 1, length, stream) == length);
+#endif
+}
+
+static boolean skipTarBytes (tarStream stream, const unsigned long length)
+{
+#ifdef HAVE_ZLIB
+	return (boolean) (gzseek (stream, (z_off_t) length, SEEK_CUR) != -1);
+#else
+	return (boolean) (fseek (stream, (long) length, SEEK_CUR) == 0);
+#endif
+}
+
+static void closeTarStream (tarStream stream)
+{
+#ifdef HAVE_ZLIB
+	gzclose (stream);
+#else
+	fclose (stream);
+#endif
+}
+
+static unsigned long readOctal (const unsigned char *p, size_t length)
+{
+	unsigned long result = 0;
+	for (  ;  length > 0  &&  *p == ' '  ;  --length)
+		++p;
+	for (  ;  length > 0  &&  *p >= '0'  &&  *p <= '7'  ;  --length)
+		result = (result << 3) | (unsigned long) (*p++ - '0');
+	return result;
+}
+
+/*  Reads the name given to the next member by a GNU long name header ('L')
+ *  or a POSIX extended header ('x'), of which "bytes" are the contents.
+ */
+static void readLongName (
+		vString *const longName, const int type,
+		const unsigned char *const bytes, const unsigned long length)
+{
+	if (type == 'L')
+		vStringNCopyS (longName, (const char *) bytes, length);
+	else
+	{
+		/*  Each record is "<length> <keyword>=<value>\n".
+		 */
+		const char *p = (const char *) bytes;
+		const char *const end = p + length;
+		while (p < end)
+		{
+			char *keyword;
+			const unsigned long recordLength = strtoul (p, &keyword, 10);
+			if (recordLength == 0  ||  p + recordLength > end)
+				break;
+			++keyword;
+			if (strncmp (keyword, "path=", 5) == 0)
+				vStringNCopyS (longName, keyword + 5,
+						(size_t) (p + recordLength - 1 - (keyword + 5)));
+			p += recordLength;
+		}
+	}
+}
+
+/*  Names the member described by "header", by its long name, if any, or
+ *  else by the name in the header and any prefix to it.
+ */
+static langType nameTarMember (
+		archive *const a, const unsigned char *const header,
+		const vString *const longName)
+{
+	vString *const name = vStringNew ();
+	langType language;
+
+	if (vStringLength (longName) > 0)
+		vStringCopy (name, longName);
+	else
+	{
+		if (memcmp (header + 257, TAR_USTAR_MAGIC, 5) == 0  &&
+			header [345] != '\0')
+		{
+			vStringNCatS (name, (const char *) header + 345, 155);
+			vStringPut (name, '/');
+		}
+		vStringNCatS (name, (const char *) header, 100);
+	}
+	language = nameMember (a, vStringValue (name), vStringLength (name));
+	vStringDelete (name);
+	return language;
+}
+
+/*  Determines whether "block" is of zeroes, as is the end of an archive.
+ *  A header may begin with a null character, when its name is wholly
+ *  within the prefix field.
+ */
+static boolean isZeroBlock (const unsigned char *const block)
+{
+	unsigned int i;
+	for (i = 0  ;  i < TarBlockSize  &&  block [i] == '\0'  ;  ++i)
+		;
+	return (boolean) (i == TarBlockSize);
+}
+
+static void parseTarArchive (archive *const a)
+{
+	tarStream stream = openTarStream (a->name);
+	if (stream == NULL)
+		error (WARNING | PERROR, "cannot open \"%s\"", a->name);
+	else
+	{
+		vString *const longName = vStringNew ();
+		unsigned char header [TarBlockSize];
+		boolean ok = TRUE;
+
+		while (ok  &&  readTarBytes (stream, header, TarBlockSize)  &&
+			   ! isZeroBlock (header))
+		{
+			const int type = header [156];
+			const unsigned long length = readOctal (header + 124, 12);
+			const unsigned long padded = (length + TarBlockSize - 1) &
+					~ (unsigned long) (TarBlockSize - 1);
+			langType language = LANG_IGNORE;
+
+			if (type == '0'  ||  type == '\0'  ||  type == '7')
+				language = nameTarMember (a, header, longName);
+			if (type == 'L'  ||  type == 'x'  ||  language != LANG_IGNORE)
+			{
+				reserveBytes (&a->bytes, &a->size, padded);
+				ok = readTarBytes (stream, a->bytes, padded);
+			}
+			else
+				ok = skipTarBytes (stream, padded);
+
+			if (! ok)
+				;
+			else if (type == 'L'  ||  type == 'x')
+				readLongName (longName, type, a->bytes, length);
+			else
+			{
+				if (language != LANG_IGNORE)
+					tagMember (a, language, length);
+				vStringClear (longName);
+			}
+		}
+		if (! ok)
+			error (WARNING, "%s: archive ends early", a->name);
+		vStringDelete (longName);
+		closeTarStream (stream);
+	}
+}
+
+/*  Tags each member of the archive "archiveName" which is a source file,
+ *  as parseFile () would tag a file. Returns TRUE if the tag file was
+ *  resized.
+ */
+extern boolean parseArchive (const char *const archiveName)
+{
+	const archiveType type = getArchiveType (archiveName);
+	archive a;
+
+	memset (&a, 0, sizeof (a));
+	a.name = archiveName;
+	a.member = vStringNew ();
+	verbose ("OPENING %s as archive\n", archiveName);
+	if (type == ARCHIVE_ZIP)
+	{
+		a.fp = fopen (archiveName, "rb");
+		if (a.fp == NULL)
+			error (WARNING | PERROR, "cannot open \"%s\"", archiveName);
+		else
+		{
+			parseZipArchive (&a);
+			fclose (a.fp);
+		}
+	}
+#ifndef HAVE_ZLIB
+	else if (type == ARCHIVE_TAR_GZIP)
+		error (WARNING, "cannot decompress \"%s\" on this host", archiveName);
+#endif
+	else
+	{
+		Assert (type == ARCHIVE_TAR  ||  type == ARCHIVE_TAR_GZIP);
+		parseTarArchive (&a);
+	}
+	if (a.bytes != NULL)
+		eFree (a.bytes);
+	if (a.packed != NULL)
+		eFree (a.packed);
+	vStringDelete (a.member);
+	return a.resize;
+}
+
+/* vi:set tabstop=4 shiftwidth=4: */
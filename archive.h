@@ -0,0 +1,27 @@
+/*
+*   $Id$
+*
+*   Copyright (c) 2026, Exuberant Ctags contributors
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License.
+*
+*   External interface to archive.c
+*/
+#ifndef _ARCHIVE_H
+#define _ARCHIVE_H
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+/*
+*   FUNCTION PROTOTYPES
+*/
+extern boolean isArchiveFile (const char *const fileName);
+extern boolean parseArchive (const char *const archiveName);
+
+#endif  /* _ARCHIVE_H */
+
+/* vi:set tabstop=4 shiftwidth=4: */
@@ -0,0 +1,453 @@
+#!/bin/sh
+#	$Id$
+#
+#	Copyright (c) 2026, Exuberant Ctags contributors
+#
+#	This source code is released for free distribution under the terms of the
+#	GNU General Public License.
+#
+#	Measures the throughput of the parsers of ctags (see "make bench"), of
+#	the making, sorting and writing of tags (see "make bench-sort"), or of
+#	the parsers on pathological input (see "make bench-adversarial").
+#
+#	Usage: bench.sh [-s|-a] [ctags]
+#
+#	A fixed corpus of source files is generated for each language, the same
+#	on every machine and for every build, into the directory named by
+#	BENCH_CORPUS (default "bench-corpus"). Each language is then tagged
+#	BENCH_RUNS times (default 3) by the ctags given (default "./ctags"),
+#	which must support --totals=json, and one line is printed for it:
+#
+#	  language  files  bytes  tags  allocations  peak-kB  MB/s  tags/s
+#
+#	The files, bytes, tags and allocations depend only upon the corpus and
+#	the parser, so that they may be compared between builds with diff. The
+#	peak resident memory, in kB, and the rates, taken from the fastest of
+#	the runs, depend also upon the machine.
+#
+#	With -s, no source files are parsed. Instead, for each count of tags in
+#	BENCH_SORT_SIZES (default "1000000 10000000 50000000"), that many
+#	synthetic tags (see --synthetic-tags) are made and sorted into a tag
+#	file BENCH_RUNS times, with any further options in BENCH_SORT_OPTIONS
+#	(such as --sort-memory=0), and one line is printed for it:
+#
+#	  tags  bytes  peak-kB  make-s  sort-s  make-tags/s  sort-tags/s  sort-MB/s
+#
+#	where bytes is the size of the tag file written. The largest count
+#	needs about 9 gigabytes for its tag file and as much again to sort it.
+#
+#	With -a, for each case of pathological input in ADVERSARIAL, and for
+#	each depth of it in BENCH_ADVERSARIAL_SIZES (default "1000 2000 4000
+#	8000"), one file is generated and tagged once, with --max-file-time set
+#	to BENCH_ADVERSARIAL_TIME seconds (default 10), and one line is printed:
+#
+#	  case  depth  bytes  tags  seconds  growth  stopped
+#
+#	where growth is the ratio of the seconds to those of the depth before,
+#	which is about 2 for a parser working in time linear in the depth and 4
+#	for one working in time quadratic in it, and stopped tells whether the
+#	file was stopped by --max-file-time. Since tags name their enclosing
+#	scopes, the size of the tags of deeply nested definitions is itself
+#	quadratic in the depth.
+
+if [ "$1" = "-s" ]; then
+	SORT=yes
+	shift
+elif [ "$1" = "-a" ]; then
+	ADVERSE=yes
+	shift
+fi
+CTAGS=${1-./ctags}
+CORPUS=${BENCH_CORPUS-bench-corpus}
+RUNS=${BENCH_RUNS-3}
+SIZES=${BENCH_SORT_SIZES-"1000000 10000000 50000000"}
+DEPTHS=${BENCH_ADVERSARIAL_SIZES-"1000 2000 4000 8000"}
+LIMIT=${BENCH_ADVERSARIAL_TIME-10}
+TAGS=$CORPUS/tags
+FILES=40	# for each language
+UNITS=60	# in each file
+
+# Languages benchmarked, as "name:extension"
+LANGUAGES="C:c C++:cpp Fortran:f90 Java:java JavaScript:js Perl:pl PHP:php \
+Python:py Ruby:rb Sh:sh SQL:sql"
+
+# Cases of pathological input, as "name:extension"
+ADVERSARIAL="braces:c conditionals:c parentheses:c classes:java \
+functions:js definitions:py modules:rb backtracking:c"
+
+# Options with which each case is tagged
+BACKTRACKING='--regex-c=/^(a*)*(a*)\2\2\2$/\2/x,stuck/'
+
+# Writes to the standard output each unit of a source file of the language
+# having the given extension, whose names are made unique by unit number.
+generate ()
+{
+	awk -v ext="$1" -v file="$2" -v units="$UNITS" '
+	function c(n) {
+		printf "/* Unit %d: records of kind %d. */\n", n, n % 7
+		printf "#define LIMIT_%d (%d * 4)\n\n", n, n
+		printf "typedef struct sRecord%d {\n\tint count;\n\tchar *name;\n", n
+		printf "\tstruct sRecord%d *next;\n} record%d;\n\n", n, n
+		printf "enum eState%d { STATE_IDLE_%d, STATE_BUSY_%d };\n\n", n, n, n
+		printf "static int Table%d [LIMIT_%d];\n\n", n, n
+		printf "static int lookup%d (const record%d *const r, int key)\n{\n", n, n
+		printf "\tint i, total = 0;\n\tfor (i = 0  ;  i < LIMIT_%d  ;  ++i)\n", n
+		printf "\t{\n\t\tif (Table%d [i] == key  &&  r != NULL)\n", n
+		printf "\t\t\ttotal += r->count;  /* { unbalanced in comment */\n\t}\n"
+		printf "\treturn total;\n}\n\n"
+		printf "extern const char *name%d (const record%d *r)\n{\n", n, n
+		printf "\treturn r == NULL ? \"none {\" : r->name;\n}\n\n"
+	}
+	function cpp(n) {
+		printf "namespace unit%d {\n\n", n
+		printf "template <typename T>\nclass Store%d : public Base\n{\npublic:\n", n
+		printf "\tStore%d () : count_ (0) {}\n\tvirtual ~Store%d () {}\n", n, n
+		printf "\tvoid add (const T &item) { items_.push_back (item); ++count_; }\n"
+		printf "\tint count () const { return count_; }\nprivate:\n"
+		printf "\tstd::vector<T> items_;\n\tint count_;\n};\n\n"
+		printf "int Store%d<int>::total (int limit)\n{\n", n
+		printf "\tint sum = 0;\n\tfor (int i = 0; i < limit; ++i)\n"
+		printf "\t\tsum += i * %d;\n\treturn sum;\n}\n\n", n
+		printf "static const int Limit%d = %d;\n\n} // namespace unit%d\n\n", n, n, n
+	}
+	function fortran(n) {
+		printf "module unit%d\n  implicit none\n", n
+		printf "  integer, parameter :: limit%d = %d\n", n, n
+		printf "  type :: record%d\n    integer :: count\n", n
+		printf "    real :: weight\n  end type record%d\ncontains\n", n
+		printf "  subroutine update%d (r, k)\n", n
+		printf "    type(record%d), intent(inout) :: r\n", n
+		printf "    integer, intent(in) :: k\n    integer :: i\n"
+		printf "    do i = 1, limit%d\n      r%%count = r%%count + k\n", n
+		printf "    end do\n  end subroutine update%d\n", n
+		printf "  function total%d (r) result (t)\n", n
+		printf "    type(record%d), intent(in) :: r\n    real :: t\n", n
+		printf "    t = r%%count * r%%weight\n  end function total%d\n", n
+		printf "end module unit%d\n\n", n
+	}
+	function java(n) {
+		printf "\t/** Records of kind %d. */\n", n % 7
+		printf "\tpublic static class Record%d implements Comparable<Record%d> {\n", n, n
+		printf "\t\tprivate int count;\n\t\tprivate String name = \"{\";\n"
+		printf "\t\tpublic static final int LIMIT = %d;\n\n", n
+		printf "\t\tpublic Record%d(int count) {\n\t\t\tthis.count = count;\n\t\t}\n\n", n
+		printf "\t\tpublic int compareTo(Record%d other) {\n", n
+		printf "\t\t\treturn count - other.count;\n\t\t}\n\n"
+		printf "\t\tint lookup%d(int[] table, int key) {\n", n
+		printf "\t\t\tint total = 0;\n\t\t\tfor (int i = 0; i < LIMIT; ++i)\n"
+		printf "\t\t\t\tif (table[i] == key)\n\t\t\t\t\ttotal += count;\n"
+		printf "\t\t\treturn total;\n\t\t}\n\t}\n\n"
+	}
+	function js(n) {
+		printf "// Records of kind %d.\n", n % 7
+		printf "var Limit%d = %d;\n\n", n, n
+		printf "function lookup%d(table, key) {\n\tvar total = 0;\n", n
+		printf "\tfor (var i = 0; i < Limit%d; ++i) {\n", n
+		printf "\t\tif (table[i] === key) { total += 1; }\n\t}\n"
+		printf "\treturn total;\n}\n\n"
+		printf "function Record%d(count) {\n\tthis.count = count;\n}\n\n", n
+		printf "Record%d.prototype.name = function () {\n", n
+		printf "\treturn \"{\" + this.count;\n};\n\n"
+		printf "var Store%d = {\n\tadd: function (item) { this.items.push(item); },\n", n
+		printf "\tclear: function () { this.items = []; },\n\titems: []\n};\n\n"
+	}
+	function perl(n) {
+		printf "# Records of kind %d.\npackage Unit%d;\n\n", n % 7, n
+		printf "use constant LIMIT%d => %d;\n\n", n, n
+		printf "sub new {\n\tmy ($class, %%args) = @_;\n"
+		printf "\treturn bless { count => 0, %%args }, $class;\n}\n\n"
+		printf "sub lookup%d {\n\tmy ($self, $key) = @_;\n\tmy $total = 0;\n", n
+		printf "\tfor my $i (0 .. LIMIT%d) {\n", n
+		printf "\t\t$total += $self->{count} if $i == $key;\n\t}\n"
+		printf "\treturn $total;  # { in comment\n}\n\n"
+	}
+	function php(n) {
+		printf "/** Records of kind %d. */\n", n % 7
+		printf "define('LIMIT_%d', %d);\n\n", n, n
+		printf "class Record%d extends Base\n{\n", n
+		printf "\tprivate $count = 0;\n\tpublic $name = \"{\";\n\n"
+		printf "\tpublic function lookup%d($table, $key)\n\t{\n", n
+		printf "\t\t$total = 0;\n\t\tfor ($i = 0; $i < LIMIT_%d; ++$i) {\n", n
+		printf "\t\t\tif ($table[$i] == $key) { $total += $this->count; }\n"
+		printf "\t\t}\n\t\treturn $total;\n\t}\n}\n\n"
+		printf "function name%d($r)\n{\n\treturn $r->name;\n}\n\n", n
+	}
+	function python(n) {
+		printf "LIMIT_%d = %d\n\n\n", n, n
+		printf "class Record%d(Base):\n", n
+		printf "    \"\"\"Records of kind %d.\n\n    def not_a_method(self):\n", n % 7
+		printf "    \"\"\"\n\n    def __init__(self, count):\n"
+		printf "        self.count = count\n\n"
+		printf "    def lookup%d(self, table, key):\n        total = 0\n", n
+		printf "        for i in range(LIMIT_%d):\n", n
+		printf "            if table[i] == key:\n                total += self.count\n"
+		printf "        return total\n\n"
+		printf "    def name(self):\n        def quoted(s):\n"
+		printf "            return \"\\\"\" + s\n        return quoted(str(self.count))\n\n\n"
+		printf "def name%d(r):\n    return r.name()\n\n\n", n
+	}
+	function ruby(n) {
+		printf "# Records of kind %d.\nmodule Unit%d\n", n % 7, n
+		printf "  LIMIT = %d\n\n  class Record%d < Base\n", n, n
+		printf "    attr_reader :count\n\n"
+		printf "    def initialize(count)\n      @count = count\n    end\n\n"
+		printf "    def lookup%d(table, key)\n      total = 0\n", n
+		printf "      LIMIT.times do |i|\n        total += count if table[i] == key\n"
+		printf "      end\n      total\n    end\n\n"
+		printf "    def self.name%d\n      \"{\"\n    end\n  end\nend\n\n", n
+	}
+	function sh(n) {
+		printf "# Records of kind %d.\nLIMIT_%d=%d\n\n", n % 7, n, n
+		printf "lookup%d ()\n{\n\ttotal=0\n", n
+		printf "\tfor i in $(seq 1 $LIMIT_%d); do\n", n
+		printf "\t\tif [ \"$i\" = \"$1\" ]; then total=$((total + 1)); fi\n"
+		printf "\tdone\n\techo \"$total\"\n}\n\n"
+		printf "function name%d {\n\techo \"{ $1\"\n}\n\n", n
+	}
+	function sql(n) {
+		printf "-- Records of kind %d.\n", n % 7
+		printf "CREATE TABLE record%d (\n\tid INTEGER PRIMARY KEY,\n", n
+		printf "\tcount INTEGER NOT NULL,\n\tname VARCHAR(40)\n);\n\n"
+		printf "CREATE INDEX record%d_name ON record%d (name);\n\n", n, n
+		printf "CREATE VIEW busy%d AS\n\tSELECT id, name FROM record%d\n", n, n
+		printf "\tWHERE count > %d;\n\n", n
+		printf "CREATE OR REPLACE PROCEDURE update%d (k IN INTEGER) IS\n", n
+		printf "BEGIN\n\tUPDATE record%d SET count = count + k;\n", n
+		printf "END update%d;\n/\n\n", n
+	}
+	BEGIN {
+		first = file * units
+		if (ext == "java")
+			printf "package bench;\n\npublic class Unit%d {\n\n", file
+		else if (ext == "php")
+			printf "<?php\n\n"
+		else if (ext == "pl")
+			printf "use strict;\nuse warnings;\n\n"
+		else if (ext == "sh")
+			printf "#!/bin/sh\n\n"
+		for (n = first  ;  n < first + units  ;  ++n)
+		{
+			if (ext == "c")        c(n)
+			else if (ext == "cpp") cpp(n)
+			else if (ext == "f90") fortran(n)
+			else if (ext == "java") java(n)
+			else if (ext == "js")  js(n)
+			else if (ext == "pl")  perl(n)
+			else if (ext == "php") php(n)
+			else if (ext == "py")  python(n)
+			else if (ext == "rb")  ruby(n)
+			else if (ext == "sh")  sh(n)
+			else if (ext == "sql") sql(n)
+		}
+		if (ext == "java")
+			printf "}\n"
+		else if (ext == "php")
+			printf "?>\n"
+		else if (ext == "pl")
+			printf "1;\n"
+	}'
+}
+
+# Writes to the standard output a file of the named case of pathological
+# input, nested to the given depth.
+adverse ()
+{
+	awk -v name="$1" -v depth="$2" '
+	function repeat(text, n,    i) {
+		for (i = 0  ;  i < n  ;  ++i)
+			printf "%s", text
+	}
+	BEGIN {
+		if (name == "braces") {
+			printf "static int outer (int x)\n{\n"
+			repeat("\t{ x++;\n", depth)
+			repeat("\t}\n", depth)
+			printf "\treturn x;\n}\n\nint after;\n"
+		} else if (name == "conditionals") {
+			for (i = 0  ;  i < depth  ;  ++i)
+				printf "#if LEVEL > %d\nint level%d;\n", i, i
+			repeat("#endif\n", depth)
+			printf "int after;\n"
+		} else if (name == "parentheses") {
+			printf "int value = "
+			repeat("(1 + ", depth)
+			printf "1"
+			repeat(")", depth)
+			printf ";\nint after;\n"
+		} else if (name == "classes") {
+			for (i = 0  ;  i < depth  ;  ++i)
+				printf "class C%d {\n", i
+			repeat("}\n", depth)
+		} else if (name == "functions") {
+			for (i = 0  ;  i < depth  ;  ++i)
+				printf "function f%d() {\n", i
+			repeat("}\n", depth)
+		} else if (name == "definitions") {
+			for (i = 0  ;  i < depth  ;  ++i) {
+				repeat(" ", i)
+				printf "def f%d():\n", i
+			}
+			repeat(" ", depth)
+			printf "pass\n\n\ndef after():\n    pass\n"
+		} else if (name == "modules") {
+			for (i = 0  ;  i < depth  ;  ++i)
+				printf "module M%d\n", i
+			repeat("end\n", depth)
+		} else if (name == "backtracking") {
+			for (i = 0  ;  i < depth  ;  ++i)
+				printf "aaaaaaaaaaaaaaaaaaaaaaaa%d\n", i
+		}
+	}'
+}
+
+# Writes the corpus for the language having the given extension, unless it
+# has already been written.
+makeCorpus ()
+{
+	dir=$CORPUS/$1
+	if [ ! -f "$dir/list" ]; then
+		mkdir -p "$dir" || exit 1
+		i=0
+		: > "$dir/list.new"
+		while [ $i -lt $FILES ]; do
+			name=$dir/unit$i.$1
+			generate "$1" $i > "$name" || exit 1
+			echo "$name" >> "$dir/list.new"
+			i=`expr $i + 1`
+		done
+		mv "$dir/list.new" "$dir/list"
+	fi
+}
+
+# Prints the value of a numeric member of the JSON totals in the given file,
+# or of the totals of its language, which must be the only one tagged.
+member ()
+{
+	sed -n -e "s/^  \"$1\": \([0-9.]*\),\$/\1/p" \
+		-e "s/^    {\"name\": .* \"$1\": \([0-9.]*\),.*/\1/p" "$2"
+}
+
+if [ ! -x "$CTAGS" ]; then
+	echo "bench.sh: cannot run \"$CTAGS\"" >&2
+	exit 1
+fi
+mkdir -p "$CORPUS" || exit 1
+
+if [ "$SORT" = yes ]; then
+	totals=$CORPUS/totals
+	printf "%10s %12s %8s %7s %7s %11s %11s %9s\n" tags bytes peak-kB \
+		make-s sort-s make-tags/s sort-tags/s sort-MB/s
+	for size in $SIZES; do
+		best=
+		run=0
+		while [ $run -lt $RUNS ]; do
+			rm -f "$TAGS"
+			"$CTAGS" --synthetic-tags=$size $BENCH_SORT_OPTIONS \
+				--totals=json -f "$TAGS" 2> "$totals.run" || exit 1
+			sed -n '/^{$/,/^}$/p' "$totals.run" > "$totals"
+			phases=`sed -n 's/^  "phases": {"scan": \([0-9.]*\),.* "sort": \([0-9.]*\)}$/\1 \2/p' "$totals"`
+			elapsed=`echo "$phases" | awk '{ print $1 + $2 }'`
+			if [ -z "$best" ] || \
+			   [ `echo "$elapsed $best" | awk '{ print ($1 < $2) }'` = 1 ]; then
+				best=$elapsed
+				bestPhases=$phases
+				bytes=`wc -c < "$TAGS"`
+				cp "$totals" "$totals.best"
+			fi
+			run=`expr $run + 1`
+		done
+		tags=`member tagFileTags "$totals.best"`
+		peak=`member peakResident "$totals.best"`
+		echo "$tags $bytes $peak $bestPhases" | awk '{
+			makeRate = ($4 > 0) ? $1 / $4 : 0
+			sortRate = ($5 > 0) ? $1 / $5 : 0
+			byteRate = ($5 > 0) ? $2 / $5 / 1048576 : 0
+			printf "%10d %12d %8d %7.2f %7.2f %11.0f %11.0f %9.1f\n",
+				$1, $2, $3, $4, $5, makeRate, sortRate, byteRate
+		}'
+		rm -f "$totals.run" "$totals" "$totals.best"
+	done
+	rm -f "$TAGS"
+	exit 0
+fi
+
+if [ "$ADVERSE" = yes ]; then
+	dir=$CORPUS/adversarial
+	mkdir -p "$dir" || exit 1
+	printf "%-13s %6s %10s %7s %8s %6s %7s\n" \
+		case depth bytes tags seconds growth stopped
+	for entry in $ADVERSARIAL; do
+		case=${entry%%:*}
+		ext=${entry#*:}
+		options=
+		if [ "$case" = backtracking ]; then
+			options=$BACKTRACKING
+		fi
+		previous=
+		for depth in $DEPTHS; do
+			name=$dir/$case$depth.$ext
+			totals=$dir/totals
+			if [ ! -f "$name" ]; then
+				adverse $case $depth > "$name.new" || exit 1
+				mv "$name.new" "$name"
+			fi
+			rm -f "$TAGS"
+			"$CTAGS" --max-file-time=$LIMIT --totals=json ${options:+"$options"} \
+				-f "$TAGS" "$name" 2> "$totals.run" || exit 1
+			sed -n '/^{$/,/^}$/p' "$totals.run" > "$totals"
+			stopped=no
+			if grep "not read within" "$totals.run" > /dev/null; then
+				stopped=yes
+			fi
+			bytes=`member bytes "$totals" | sed -n 2p`
+			tags=`member tags "$totals" | sed -n 2p`
+			elapsed=`sed -n 's/^    {"name": .* "elapsed": \([0-9.]*\),.*/\1/p' "$totals"`
+			echo "$case $depth $bytes $tags $elapsed ${previous:-0} $stopped" | awk '{
+				growth = ($6 > 0) ? sprintf ("%6.1f", $5 / $6) : sprintf ("%6s", "-")
+				printf "%-13s %6d %10d %7d %8.3f %s %7s\n",
+					$1, $2, $3, $4, $5, growth, $7
+			}'
+			previous=$elapsed
+			rm -f "$totals.run" "$totals"
+		done
+	done
+	rm -f "$TAGS"
+	exit 0
+fi
+
+printf "%-12s %5s %9s %7s %11s %8s %7s %9s\n" \
+	language files bytes tags allocations peak-kB MB/s tags/s
+for entry in $LANGUAGES; do
+	language=${entry%%:*}
+	ext=${entry#*:}
+	makeCorpus $ext
+	totals=$CORPUS/$ext/totals
+	best=
+	run=0
+	while [ $run -lt $RUNS ]; do
+		rm -f "$TAGS"
+		"$CTAGS" --totals=json -f "$TAGS" -L "$CORPUS/$ext/list" \
+			2> "$totals.run" || exit 1
+		sed -n '/^{$/,/^}$/p' "$totals.run" > "$totals"
+		elapsed=`sed -n 's/^    {"name": .* "elapsed": \([0-9.]*\),.*/\1/p' "$totals"`
+		if [ -z "$best" ] || \
+		   [ `echo "$elapsed $best" | awk '{ print ($1 < $2) }'` = 1 ]; then
+			best=$elapsed
+			cp "$totals" "$totals.best"
+		fi
+		run=`expr $run + 1`
+	done
+	files=`member files "$totals.best" | sed -n 2p`
+	bytes=`member bytes "$totals.best" | sed -n 2p`
+	tags=`member tags "$totals.best" | sed -n 2p`
+	allocations=`member allocations "$totals.best" | sed -n 2p`
+	peak=`member peakResident "$totals.best"`
+	echo "$language $files $bytes $tags $allocations $peak $best" | awk '{
+		rate = ($7 > 0) ? $3 / $7 / 1048576 : 0
+		tagRate = ($7 > 0) ? $4 / $7 : 0
+		printf "%-12s %5d %9d %7d %11d %8d %7.1f %9.0f\n",
+			$1, $2, $3, $4, $5, $6, rate, tagRate
+	}'
+	rm -f "$totals.run"
+done
+rm -f "$TAGS"
@@ -260,7 +260,15 @@ static langType Lang_vera;
 static vString *Signature;
 static boolean CollectingSignature;
 
-/* Number used to uniquely identify anonymous structs and unions. */
+/*  Tokens and statements no longer in use, kept for reuse until the end of
+ *  the file, so that nested blocks do not allocate afresh.
+ */
+static tokenInfo **SpareTokens = NULL;
+static unsigned int SpareTokenCount = 0;
+static unsigned int SpareTokenMax = 0;
+static statementInfo *SpareStatements = NULL;  /* linked by parent */
+
+/* Number used to identify anonymous structs and unions within a file. */
 static int AnonymousID = 0;
 
 /* Used to index into the CKinds table. */
@@ -526,18 +534,36 @@ static void retardToken (statementInfo *const st)
 
 static tokenInfo *newToken (void)
 {
-	tokenInfo *const token = xMalloc (1, tokenInfo);
-	token->name = vStringNew ();
+	tokenInfo *token;
+	if (SpareTokenCount > 0)
+		token = SpareTokens [--SpareTokenCount];
+	else
+	{
+		token = xMalloc (1, tokenInfo);
+		token->name = vStringNew ();
+	}
 	initToken (token);
 	return token;
 }
 
+static void freeToken (tokenInfo *const token)
+{
+	vStringDelete (token->name);
+	eFree (token);
+}
+
+/*  Keeps a token no longer in use for reuse by newToken ().
+ */
 static void deleteToken (tokenInfo *const token)
 {
 	if (token != NULL)
 	{
-		vStringDelete (token->name);
-		eFree (token);
+		if (SpareTokenCount == SpareTokenMax)
+		{
+			SpareTokenMax = SpareTokenMax == 0 ? 16 : SpareTokenMax * 2;
+			SpareTokens = xRealloc (SpareTokens, SpareTokenMax, tokenInfo*);
+		}
+		SpareTokens [SpareTokenCount++] = token;
 	}
 }
 
@@ -1030,7 +1056,7 @@ static void addOtherFields (tagEntryInfo* const tag, const tagType type,
 
 	/* Add typename info, type of the tag and name of struct/union/etc. */
 	if ((type == TAG_TYPEDEF || type == TAG_VARIABLE || type == TAG_MEMBER)
-			&& isContextualStatement(st))
+			&& isContextualStatement(st)  &&  isTagFieldWanted (FIELD_TYPEREF))
 	{
 		char *p;
 
@@ -1060,39 +1086,48 @@ static void addOtherFields (tagEntryInfo* const tag, const tagType type,
 	}
 }
 
-static void findScopeHierarchy (vString *const string,
-								const statementInfo *const st)
+/*  Appends to "string" the names of the scopes opened by "s" and the
+ *  statements enclosing it, outermost first, each followed by a separator
+ *  if any name is to follow it, as "inner" tells for the innermost. Each
+ *  name is copied once, however deep the nesting.
+ */
+static void appendScopeHierarchy (vString *const string,
+								  const statementInfo *const s,
+								  const boolean inner)
 {
-	vStringClear (string);
-	if (isType (st->context, TOKEN_NAME))
-		vStringCopy (string, st->context->name);
-	if (st->parent != NULL)
-	{
-		vString *temp = vStringNew ();
-		const statementInfo *s;
-		for (s = st->parent  ;  s != NULL  ;  s = s->parent)
+	if (s == NULL)
+		;
+	else if (isContextualStatement (s) ||
+			 s->declaration == DECL_NAMESPACE ||
+			 s->declaration == DECL_PROGRAM)
+	{
+		const boolean hasContext = (boolean) (isType (s->context, TOKEN_NAME)  &&
+				vStringLength (s->context->name) > 0);
+		Assert (isType (s->blockName, TOKEN_NAME));
+		appendScopeHierarchy (string, s->parent, (boolean) (inner  ||
+				hasContext  ||  vStringLength (s->blockName->name) > 0));
+		if (hasContext)
 		{
-			if (isContextualStatement (s) ||
-				s->declaration == DECL_NAMESPACE ||
-				s->declaration == DECL_PROGRAM)
-			{
-				vStringCopy (temp, string);
-				vStringClear (string);
-				Assert (isType (s->blockName, TOKEN_NAME));
-				if (isType (s->context, TOKEN_NAME) &&
-					vStringLength (s->context->name) > 0)
-				{
-					vStringCat (string, s->context->name);
-					addContextSeparator (string);
-				}
-				vStringCat (string, s->blockName->name);
-				if (vStringLength (temp) > 0)
-					addContextSeparator (string);
-				vStringCat (string, temp);
-			}
+			vStringCat (string, s->context->name);
+			addContextSeparator (string);
 		}
-		vStringDelete (temp);
+		vStringCat (string, s->blockName->name);
+		if (inner)
+			addContextSeparator (string);
 	}
+	else
+		appendScopeHierarchy (string, s->parent, inner);
+}
+
+static void findScopeHierarchy (vString *const string,
+								const statementInfo *const st)
+{
+	const boolean named = (boolean) (isType (st->context, TOKEN_NAME)  &&
+			vStringLength (st->context->name) > 0);
+	vStringClear (string);
+	appendScopeHierarchy (string, st->parent, named);
+	if (named)
+		vStringCat (string, st->context->name);
 }
 
 static void makeExtraTagEntry (const tagType type, tagEntryInfo *const e,
@@ -1154,7 +1189,13 @@ static void makeTag (const tokenInfo *const token,
 		e.kindName		= tagName (type);
 		e.kind			= tagLetter (type);
 
-		findScopeHierarchy (scope, st);
+		/*  The scope is needed only for fields and qualified tags.
+		 */
+		if (Option.include.qualifiedTags  ||
+			isTagFieldWanted (FIELD_SCOPE)  ||  isTagFieldWanted (FIELD_TYPEREF))
+		{
+			findScopeHierarchy (scope, st);
+		}
 		addOtherFields (&e, type, st, scope, typeRef);
 
 		makeTagEntry (&e);
@@ -1658,12 +1699,17 @@ static void discardTypeList (tokenInfo *const token)
 
 static void addParentClass (statementInfo *const st, tokenInfo *const token)
 {
-	if (vStringLength (token->name) > 0  &&
-		vStringLength (st->parentClasses) > 0)
+	if (! isTagFieldWanted (FIELD_INHERITANCE))
+		;  /* parent classes are only reported as inheritance */
+	else
 	{
-		vStringPut (st->parentClasses, ',');
+		if (vStringLength (token->name) > 0  &&
+			vStringLength (st->parentClasses) > 0)
+		{
+			vStringPut (st->parentClasses, ',');
+		}
+		vStringCat (st->parentClasses, token->name);
 	}
-	vStringCat (st->parentClasses, token->name);
 }
 
 static void readParents (statementInfo *const st, const int qualifier)
@@ -2110,14 +2156,18 @@ static int parseParens (statementInfo *const st, parenInfo *const info)
 	boolean firstChar = TRUE;
 	int nextChar = '\0';
 
-	CollectingSignature = TRUE;
+	/*  The signature is collected only if it will be reported.
+	 */
+	CollectingSignature = isTagFieldWanted (FIELD_SIGNATURE);
 	vStringClear (Signature);
-	vStringPut (Signature, '(');
+	if (CollectingSignature)
+		vStringPut (Signature, '(');
 	info->parameterCount = 1;
 	do
 	{
 		int c = skipToNonWhite ();
-		vStringPut (Signature, c);
+		if (CollectingSignature)
+			vStringPut (Signature, c);
 
 		switch (c)
 		{
@@ -2150,7 +2200,7 @@ static int parseParens (statementInfo *const st, parenInfo *const info)
 						cppUngetc (c);
 						info->isKnrParamList = FALSE;
 					}
-					else
+					else if (CollectingSignature)
 						vStringCatS (Signature, "..."); /* variable arg list */
 				}
 				break;
@@ -2560,15 +2610,21 @@ static statementInfo *CurrentStatement = NULL;
 
 static statementInfo *newStatement (statementInfo *const parent)
 {
-	statementInfo *const st = xMalloc (1, statementInfo);
+	statementInfo *st = SpareStatements;
 	unsigned int i;
 
-	for (i = 0  ;  i < (unsigned int) NumTokens  ;  ++i)
-		st->token [i] = newToken ();
+	if (st != NULL)
+		SpareStatements = st->parent;  /* its tokens are kept with it */
+	else
+	{
+		st = xMalloc (1, statementInfo);
+		for (i = 0  ;  i < (unsigned int) NumTokens  ;  ++i)
+			st->token [i] = newToken ();
 
-	st->context = newToken ();
-	st->blockName = newToken ();
-	st->parentClasses = vStringNew ();
+		st->context = newToken ();
+		st->blockName = newToken ();
+		st->parentClasses = vStringNew ();
+	}
 
 	initStatement (st, parent);
 	CurrentStatement = st;
@@ -2576,21 +2632,43 @@ static statementInfo *newStatement (statementInfo *const parent)
 	return st;
 }
 
+/*  Keeps the current statement, with its tokens, for reuse by
+ *  newStatement ().
+ */
 static void deleteStatement (void)
 {
 	statementInfo *const st = CurrentStatement;
 	statementInfo *const parent = st->parent;
+
+	st->parent = SpareStatements;
+	SpareStatements = st;
+	CurrentStatement = parent;
+}
+
+/*  Frees the statements and tokens kept for reuse, once a file is done.
+ */
+static void freeSpares (void)
+{
 	unsigned int i;
 
-	for (i = 0  ;  i < (unsigned int) NumTokens  ;  ++i)
+	while (SpareStatements != NULL)
 	{
-		deleteToken (st->token [i]);       st->token [i] = NULL;
+		statementInfo *const st = SpareStatements;
+		SpareStatements = st->parent;
+		for (i = 0  ;  i < (unsigned int) NumTokens  ;  ++i)
+			freeToken (st->token [i]);
+		freeToken (st->blockName);
+		freeToken (st->context);
+		vStringDelete (st->parentClasses);
+		eFree (st);
 	}
-	deleteToken (st->blockName);           st->blockName = NULL;
-	deleteToken (st->context);             st->context = NULL;
-	vStringDelete (st->parentClasses);     st->parentClasses = NULL;
-	eFree (st);
-	CurrentStatement = parent;
+	for (i = 0  ;  i < SpareTokenCount  ;  ++i)
+		freeToken (SpareTokens [i]);
+	if (SpareTokens != NULL)
+		eFree (SpareTokens);
+	SpareTokens = NULL;
+	SpareTokenCount = 0;
+	SpareTokenMax = 0;
 }
 
 static void deleteAllStatements (void)
@@ -2801,6 +2879,12 @@ static boolean findCTags (const unsigned int passCount)
 	Assert (passCount < 3);
 	cppInit ((boolean) (passCount > 1), isLanguage (Lang_csharp));
 	Signature = vStringNew ();
+	/*  Anonymous names are numbered afresh in each file, so that they depend
+	 *  only upon the file itself and not upon the files parsed before it,
+	 *  which differ with --jobs, --incremental and --cache-dir. They are
+	 *  therefore unique only within a file.
+	 */
+	AnonymousID = 0;
 
 	exception = (exception_t) setjmp (Exception);
 	retry = FALSE;
@@ -2817,6 +2901,7 @@ static boolean findCTags (const unsigned int passCount)
 		}
 	}
 	vStringDelete (Signature);
+	freeSpares ();
 	cppTerminate ();
 	return retry;
 }
@@ -0,0 +1,760 @@
+/*
+*   $Id$
+*
+*   Copyright (c) 2026, Exuberant Ctags contributors
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License.
+*
+*   This module contains functions to keep a cache of the tag lines generated
+*   for each source file (see --cache-dir). Each entry of the cache is a file
+*   whose name is derived from a hash of the contents of the source file, its
+*   language, the name recorded for it in the tag file, the options which
+*   affect its tags, and a stamp of the version of ctags and its parsers.
+*   When an entry exists for a source file, its tag lines are copied from the
+*   entry, and the file is not parsed at all.
+*
+*   The cache may be shared by many instances of ctags at once, even on
+*   different hosts. An entry is named by 24 hexadecimal digits, and begins
+*   with a line giving its stamp, language, tag path and the length of the
+*   tag lines which follow. It is written under a name of its own, and then
+*   renamed, so that it appears whole; an entry which is nevertheless found
+*   to be incomplete is ignored, and written again. Readers take no locks.
+*   Entries are touched when used, so that when the cache grows beyond
+*   --cache-size, those used least recently are removed.
+*
+*   Within a run, whether or not there is a cache, the tag lines of the files
+*   parsed are also kept in memory, up to a limit, so that a later file found
+*   to be a copy of one of them need not be parsed either. A copy must have
+*   the same size, base name, language and contents; sizes are compared
+*   first, and only files of equal size are hashed. The tag lines of the
+*   earlier file are then written again, naming the copy instead.
+*/
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#include <string.h>
+#include <stdio.h>
+#ifdef HAVE_STDLIB_H
+# include <stdlib.h>  /* to declare qsort () */
+#endif
+
+#ifdef HAVE_UNISTD_H
+# include <unistd.h>  /* to declare getpid () */
+#endif
+#ifdef CACHE_TRIMMING_SUPPORTED
+# ifdef HAVE_SYS_TYPES_H
+#  include <sys/types.h>  /* required by dirent.h */
+# endif
+# include <dirent.h>
+# include <time.h>
+# include <utime.h>
+#endif
+
+#include "cache.h"
+#include "ctags.h"
+#include "debug.h"
+#include "entry.h"
+#include "options.h"
+#include "parse.h"
+#include "read.h"
+#include "routines.h"
+#include "vstring.h"
+
+/*
+*   MACROS
+*/
+#define CACHE_HEADER  "!_CTAGS_CACHE"
+
+/*
+*   DATA DECLARATIONS
+*/
+enum eCacheLimits {
+	CacheVersion = 2,         /* format of cache entries */
+	EntryNameLength = 3 * 8,  /* hexadecimal digits naming an entry */
+	TouchInterval = 60 * 60,  /* seconds before a used entry is touched */
+	StaleInterval = 24 * 60 * 60,  /* seconds before a partial entry is stale */
+	InitialSeenTableSize = 256,    /* must be a power of 2 */
+	SeenLinesLimit = 64 * 1024 * 1024  /* bytes of tag lines kept in a run */
+};
+
+/*  A file parsed earlier in the run, of which the contents are hashed only
+ *  once another file of the same size is met.
+ */
+typedef struct sSeenFile {
+	char *name;
+	char *tagPath;        /* as named in its tag lines */
+	unsigned long size;
+	unsigned long fingerprint;  /* of the options in effect */
+	langType language;
+	boolean hashed;
+	unsigned long fnv;
+	unsigned long sdbm;
+	char *lines;          /* tag lines generated for the file */
+	size_t length;
+	int next;             /* index of next file in hash chain, or -1 */
+} seenFile;
+
+#ifdef CACHE_TRIMMING_SUPPORTED
+typedef struct sCachedFile {
+	char *name;
+	unsigned long size;
+	unsigned long modified;
+} cachedFile;
+#endif
+
+/*
+*   DATA DEFINITIONS
+*/
+static vString *EntryName = NULL;  /* entry for the file being tagged */
+static vString *Header = NULL;     /* expected start of that entry */
+static vString *Recorded = NULL;   /* tag lines generated for the file */
+static boolean Missed = FALSE;     /* was the file absent from the cache? */
+static boolean Recording = FALSE;
+static char Stamp [8 + 1] = "";    /* of ctags and its parsers */
+
+static seenFile *SeenFiles = NULL;
+static unsigned int SeenCount = 0;
+static unsigned int SeenMax = 0;
+static int *SeenTable = NULL;
+static unsigned int SeenTableSize = 0;
+static unsigned long SeenLength = 0;  /* of the tag lines of all files */
+static seenFile Current;           /* the file being tagged */
+static boolean Noting = FALSE;     /* is it to be noted as seen? */
+
+/*
+*   FUNCTION DEFINITIONS
+*/
+
+static void freeSeenFiles (void)
+{
+	unsigned int i;
+	for (i = 0  ;  i < SeenCount  ;  ++i)
+	{
+		eFree (SeenFiles [i].name);
+		eFree (SeenFiles [i].tagPath);
+		if (SeenFiles [i].lines != NULL)
+			eFree (SeenFiles [i].lines);
+	}
+	if (SeenFiles != NULL)
+		eFree (SeenFiles);
+	if (SeenTable != NULL)
+		eFree (SeenTable);
+	SeenFiles = NULL;
+	SeenCount = 0;
+	SeenMax = 0;
+	SeenTable = NULL;
+	SeenTableSize = 0;
+	SeenLength = 0;
+	if (Current.name != NULL)
+		eFree (Current.name);
+	if (Current.tagPath != NULL)
+		eFree (Current.tagPath);
+	memset (&Current, 0, sizeof (Current));
+	Noting = FALSE;
+}
+
+extern void freeCacheResources (void)
+{
+	if (EntryName != NULL)
+		vStringDelete (EntryName);
+	if (Header != NULL)
+		vStringDelete (Header);
+	if (Recorded != NULL)
+		vStringDelete (Recorded);
+	EntryName = NULL;
+	Header = NULL;
+	Recorded = NULL;
+	Missed = FALSE;
+	Recording = FALSE;
+	freeSeenFiles ();
+}
+
+/*  Hashes the contents of a file twice, by FNV-1a and by sdbm, so that two
+ *  different files are very unlikely to share an entry.
+ */
+static void hashContents (
+		const char *const fileName, unsigned long *const pFnv,
+		unsigned long *const pSdbm, unsigned long *const pSize)
+{
+	FILE *const fp = fopen (fileName, "rb");
+	*pFnv = INITIAL_HASH;
+	*pSdbm = 0;
+	*pSize = 0;
+	if (fp != NULL)
+	{
+		unsigned char buffer [BUFSIZ];
+		size_t length;
+		while ((length = fread (buffer, 1, sizeof (buffer), fp)) > 0)
+		{
+			unsigned long sdbm = *pSdbm;
+			size_t i;
+			for (i = 0  ;  i < length  ;  ++i)
+				sdbm = (buffer [i] + (sdbm << 6) + (sdbm << 16) - sdbm) &
+						0xffffffffUL;
+			*pSdbm = sdbm;
+			*pFnv = hashBytes (*pFnv, buffer, length);
+			*pSize += length;
+		}
+		fclose (fp);
+	}
+}
+
+static unsigned long hashString (const unsigned long hash, const char *const s)
+{
+	/* include the terminator, so that consecutive strings stay distinct */
+	return hashBytes (hash, (const unsigned char *) s, strlen (s) + 1);
+}
+
+/*  Returns the stamp of this build of ctags, so that entries made by builds
+ *  with other versions or other sets of parsers are never used.
+ */
+static const char *cacheStamp (void)
+{
+	if (Stamp [0] == '\0')
+	{
+		char number [24];
+		unsigned long hash;
+		sprintf (number, "%d %lu", (int) CacheVersion, parserFingerprint ());
+		hash = hashString (INITIAL_HASH, number);
+		hash = hashString (hash, PROGRAM_VERSION);
+		sprintf (Stamp, "%08lx", hash);
+	}
+	return Stamp;
+}
+
+/*  Names the cache entry for the source file just opened, and the header
+ *  which that entry must begin with to be used.
+ */
+static void nameEntry (const char *const fileName, const langType language)
+{
+	const char *const tagPath = getSourceFileTagPath ();
+	unsigned long fnv, sdbm, size, hash;
+	char number [48];
+
+	hashContents (fileName, &fnv, &sdbm, &size);
+	sprintf (number, "%lu %lu", size, optionFingerprint ());
+	hash = hashString (INITIAL_HASH, number);
+	hash = hashString (hash, cacheStamp ());
+	hash = hashString (hash, getLanguageName (language));
+	hash = hashString (hash, tagPath);
+
+	if (EntryName == NULL)
+		EntryName = vStringNew ();
+	if (Header == NULL)
+		Header = vStringNew ();
+	vStringCopyS (EntryName, Option.cacheDir);
+	vStringPut (EntryName, OUTPUT_PATH_SEPARATOR);
+	sprintf (number, "%08lx%08lx%08lx", fnv, sdbm, hash);
+	vStringCatS (EntryName, number);
+
+	vStringCopyS (Header, CACHE_HEADER);
+	vStringPut (Header, '\t');
+	vStringCatS (Header, cacheStamp ());
+	vStringPut (Header, '\t');
+	vStringCatS (Header, getLanguageName (language));
+	vStringPut (Header, '\t');
+	vStringCatS (Header, tagPath);
+	vStringPut (Header, '\t');
+}
+
+/*  Marks a cache entry as recently used. So as not to burden a shared cache,
+ *  an entry is touched only if it has not been for some time.
+ */
+static void touchEntry (const char *const name)
+{
+#ifdef CACHE_TRIMMING_SUPPORTED
+	fileStatus *const status = eStat (name);
+	const unsigned long now = (unsigned long) time (NULL);
+	if (status->exists  &&  status->modified + TouchInterval < now)
+		utime (name, NULL);
+	eStatFree (status);
+#endif
+}
+
+/*  Reads the tag lines of a cache entry, of which the header has been read,
+ *  returning NULL unless all of the lines expected were read.
+ */
+static char *readEntryLines (FILE *const fp, const unsigned long length)
+{
+	char *lines = xMalloc (length + 1, char);
+	if (fread (lines, 1, length, fp) != length  ||  getc (fp) != EOF  ||
+		(length > 0  &&  lines [length - 1] != '\n'))
+	{
+		eFree (lines);
+		lines = NULL;
+	}
+	else
+		lines [length] = '\0';
+	return lines;
+}
+
+/*
+ *  Copies of files within a run
+ */
+
+static unsigned int seenIndex (const unsigned long size)
+{
+	const unsigned long hash = hashBytes (INITIAL_HASH,
+			(const unsigned char *) &size, sizeof (size));
+	return (unsigned int) (hash & (SeenTableSize - 1));
+}
+
+static void rehashSeenFiles (void)
+{
+	unsigned int i;
+	SeenTableSize = (SeenTableSize == 0) ?
+			InitialSeenTableSize : SeenTableSize * 2;
+	if (SeenTable != NULL)
+		eFree (SeenTable);
+	SeenTable = xMalloc (SeenTableSize, int);
+	for (i = 0  ;  i < SeenTableSize  ;  ++i)
+		SeenTable [i] = -1;
+	for (i = 0  ;  i < SeenCount  ;  ++i)
+	{
+		const unsigned int k = seenIndex (SeenFiles [i].size);
+		SeenFiles [i].next = SeenTable [k];
+		SeenTable [k] = (int) i;
+	}
+}
+
+/*  Hashes the contents of a file, if not done already, returning whether it
+ *  still has the size it had when it was tagged.
+ */
+static boolean hashSeenFile (seenFile *const file, const char *const fileName)
+{
+	unsigned long size = file->size;
+	if (! file->hashed)
+	{
+		hashContents (fileName, &file->fnv, &file->sdbm, &size);
+		file->hashed = TRUE;
+	}
+	return (boolean) (size == file->size);
+}
+
+static boolean isCopy (
+		seenFile *const seen, const char *const fileName,
+		const langType language)
+{
+	return (boolean) (seen->size == Current.size  &&
+			seen->language == language  &&
+			seen->fingerprint == Current.fingerprint  &&
+			seen->lines != NULL  &&
+			strcmp (baseFilename (seen->name), baseFilename (fileName)) == 0  &&
+			hashSeenFile (&Current, fileName)  &&
+			hashSeenFile (seen, seen->name)  &&
+			seen->fnv == Current.fnv  &&  seen->sdbm == Current.sdbm);
+}
+
+/*  Returns the end of the file name of a tag line if it is "tagPath".
+ */
+static const char *namesFile (
+		const char *const line, const char *const end,
+		const char *const tagPath, const size_t length)
+{
+	const char *const tab = memchr (line, '\t', (size_t) (end - line));
+	const char *result = NULL;
+	if (tab != NULL  &&  tab + 1 + length < end  &&  tab [1 + length] == '\t'  &&
+		strncmp (tab + 1, tagPath, length) == 0)
+	{
+		result = tab + 1 + length;
+	}
+	return result;
+}
+
+/*  Determines whether all of the tag lines recorded name the source file
+ *  just tagged, rather than, say, a file named by a #line directive, which
+ *  could not be rewritten for a copy of the file.
+ */
+static boolean allNameFile (const char *const tagPath)
+{
+	const size_t length = strlen (tagPath);
+	const char *line = vStringValue (Recorded);
+	const char *const limit = line + vStringLength (Recorded);
+	boolean result = TRUE;
+	while (line < limit  &&  result)
+	{
+		const char *const end = strchr (line, '\n') + 1;
+		result = (boolean) (namesFile (line, end, tagPath, length) != NULL);
+		line = end;
+	}
+	return result;
+}
+
+/*  Writes the tag lines of a file seen earlier for the source file just
+ *  opened, replacing its name in each line.
+ */
+static void writeCopiedTags (const seenFile *const seen)
+{
+	const char *const tagPath = getSourceFileTagPath ();
+	const size_t length = strlen (seen->tagPath);
+	const char *const limit = seen->lines + seen->length;
+	vString *const copy = vStringNew ();
+	const char *line = seen->lines;
+	while (line < limit)
+	{
+		const char *const end = strchr (line, '\n') + 1;
+		const char *const rest = namesFile (line, end, seen->tagPath, length);
+		const char *const tab = rest - length - 1;
+		Assert (rest != NULL);
+		vStringNCopyS (copy, line, (size_t) (tab + 1 - line));
+		vStringCatS (copy, tagPath);
+		vStringNCatS (copy, rest, (size_t) (end - rest));
+		writeTagLine (vStringValue (copy), vStringLength (copy));
+		line = end;
+	}
+	vStringDelete (copy);
+}
+
+/*  Writes the tag lines of a file seen earlier in the run of which the source
+ *  file just opened is a copy, if there is one, returning whether it was
+ *  found. Otherwise the file is to be noted as seen once it is tagged.
+ */
+static boolean tagsFromCopy (const char *const fileName, const langType language)
+{
+	fileStatus *const status = eStat (fileName);
+	boolean result = FALSE;
+
+	if (Current.name != NULL)
+		eFree (Current.name);
+	if (Current.tagPath != NULL)
+		eFree (Current.tagPath);
+	memset (&Current, 0, sizeof (Current));
+	Current.name = eStrdup (fileName);
+	Current.tagPath = eStrdup (getSourceFileTagPath ());
+	Current.size = status->size;
+	Current.fingerprint = optionFingerprint ();
+	Current.language = language;
+	eStatFree (status);
+	if (SeenTable != NULL)
+	{
+		int i = SeenTable [seenIndex (Current.size)];
+		for (  ;  i != -1  &&  ! result  ;  i = SeenFiles [i].next)
+		{
+			if (isCopy (&SeenFiles [i], fileName, language))
+			{
+				verbose ("  copying tags of identical %s\n", SeenFiles [i].name);
+				writeCopiedTags (&SeenFiles [i]);
+				result = TRUE;
+			}
+		}
+	}
+	Noting = (boolean) ! result;
+	return result;
+}
+
+/*  Notes the source file just tagged as seen, with the tag lines recorded
+ *  for it, unless those would exceed the memory allowed.
+ */
+static void noteSeenFile (void)
+{
+	const size_t length = vStringLength (Recorded);
+	if (SeenLength + length <= (unsigned long) SeenLinesLimit  &&
+		allNameFile (Current.tagPath))
+	{
+		seenFile *file;
+		if (SeenCount == SeenMax)
+		{
+			SeenMax = (SeenMax == 0) ? 64 : SeenMax * 2;
+			SeenFiles = xRealloc (SeenFiles, SeenMax, seenFile);
+		}
+		file = &SeenFiles [SeenCount++];
+		*file = Current;
+		Current.name = NULL;
+		Current.tagPath = NULL;
+		file->lines = xMalloc (length + 1, char);
+		memcpy (file->lines, vStringValue (Recorded), length + 1);
+		file->length = length;
+		SeenLength += length;
+		if (2 * SeenCount > SeenTableSize)
+			rehashSeenFiles ();
+		else
+		{
+			const unsigned int k = seenIndex (file->size);
+			file->next = SeenTable [k];
+			SeenTable [k] = (int) (SeenCount - 1);
+		}
+	}
+}
+
+/*
+ *  Cache entries
+ */
+
+/*  Writes the tag lines of the cache entry for the source file just opened,
+ *  "fileName", if there is one, returning whether it was found.
+ */
+extern boolean tagsFromCache (const char *const fileName, const langType language)
+{
+	boolean result = FALSE;
+	Missed = FALSE;
+	Noting = FALSE;
+	Recording = FALSE;
+	if (isTagSinkSet ()  ||  Option.extraOutputs != NULL)
+		;  /* tags are wanted other than as lines to be kept */
+	else if (File.supplied)
+		;  /* contents are not those of any file named */
+	else if (! Option.etags  &&  ! Option.xref  &&  ! Option.json  &&
+			! isLanguageSerial (language))
+		result = tagsFromCopy (fileName, language);
+	if (! result  &&  Option.cacheDir != NULL  &&  ! isTagSinkSet ()  &&
+		Option.extraOutputs == NULL  &&  ! File.supplied)
+	{
+		FILE *fp;
+		nameEntry (fileName, language);
+		fp = fopen (vStringValue (EntryName), "rb");
+		if (fp != NULL)
+		{
+			vString *const vLine = vStringNew ();
+			unsigned long length;
+			char *lines = NULL;
+			if (readLine (vLine, fp) != NULL  &&
+				strncmp (vStringValue (vLine), vStringValue (Header),
+						vStringLength (Header)) == 0  &&
+				sscanf (vStringValue (vLine) + vStringLength (Header),
+						"%lu", &length) == 1)
+			{
+				lines = readEntryLines (fp, length);
+			}
+			vStringDelete (vLine);
+			fclose (fp);
+			if (lines != NULL)
+			{
+				const char *line = lines;
+				verbose ("  using cached tags %s\n", vStringValue (EntryName));
+				while (*line != '\0')
+				{
+					const char *const end = strchr (line, '\n') + 1;
+					writeTagLine (line, (size_t) (end - line));
+					line = end;
+				}
+				eFree (lines);
+				touchEntry (vStringValue (EntryName));
+				result = TRUE;
+			}
+		}
+		Missed = (boolean) ! result;
+	}
+	return result;
+}
+
+/*  Starts recording the tag lines generated for the source file just opened,
+ *  if it was absent from the cache or is to be noted as seen. This is
+ *  repeated for each pass a parser makes over the file.
+ */
+extern void beginCachedTags (void)
+{
+	if (Missed  ||  Noting)
+	{
+		if (Recorded == NULL)
+			Recorded = vStringNew ();
+		vStringClear (Recorded);
+		Recording = TRUE;
+	}
+}
+
+extern void recordCachedTag (const char *const line, const size_t length)
+{
+	if (Recording)
+		vStringNCatS (Recorded, line, length);
+}
+
+/*  Stops recording, because some of the tags of the file were not generated
+ *  by this process.
+ */
+extern void abandonCachedTags (void)
+{
+	Recording = FALSE;
+}
+
+/*  Names the file under which an entry is written before being renamed.
+ *  This is distinct for each process, lest two processes sharing the cache
+ *  write the same entry at once.
+ */
+static vString *storedName (void)
+{
+	vString *const name = vStringNewCopy (EntryName);
+	char number [24];
+#ifdef HAVE_UNISTD_H
+	sprintf (number, ".%lu", (unsigned long) getpid ());
+#else
+	strcpy (number, ".new");
+#endif
+	vStringCatS (name, number);
+	return name;
+}
+
+/*  Writes the tag lines recorded for the source file just tagged as its cache
+ *  entry.
+ */
+static void writeEntry (void)
+{
+	vString *const stored = storedName ();
+	FILE *const fp = fopen (vStringValue (stored), "wb");
+	if (fp == NULL)
+		error (WARNING | PERROR, "cannot write cache entry \"%s\"",
+				vStringValue (stored));
+	else
+	{
+		boolean ok;
+		fputs (vStringValue (Header), fp);
+		fprintf (fp, "%lu\n", (unsigned long) vStringLength (Recorded));
+		fwrite (vStringValue (Recorded), 1, vStringLength (Recorded), fp);
+		ok = (boolean) (! ferror (fp));
+		if (fclose (fp) != 0)
+			ok = FALSE;
+		if (ok  &&  rename (vStringValue (stored), vStringValue (EntryName)) != 0)
+		{
+			/* some hosts will not rename over an existing file */
+			remove (vStringValue (EntryName));
+			ok = (boolean) (rename (vStringValue (stored),
+						vStringValue (EntryName)) == 0);
+		}
+		if (! ok)
+		{
+			error (WARNING | PERROR, "cannot write cache entry \"%s\"",
+					vStringValue (EntryName));
+			remove (vStringValue (stored));
+		}
+	}
+	vStringDelete (stored);
+}
+
+/*  Stores the tag lines recorded for the source file just tagged as its cache
+ *  entry, and notes the file as seen in this run.
+ */
+extern void storeCachedTags (void)
+{
+	if (Recording)
+	{
+		if (Missed)
+			writeEntry ();
+		if (Noting)
+			noteSeenFile ();
+		Recording = FALSE;
+	}
+	Missed = FALSE;
+	Noting = FALSE;
+}
+
+/*
+ *  Cache trimming
+ */
+
+#ifdef CACHE_TRIMMING_SUPPORTED
+
+static boolean isEntryName (const char *const name)
+{
+	size_t i;
+	for (i = 0  ;  i < EntryNameLength  ;  ++i)
+		if (strchr ("0123456789abcdef", name [i]) == NULL  ||  name [i] == '\0')
+			break;
+	return (boolean) (i == EntryNameLength  &&
+			(name [i] == '\0'  ||  name [i] == '.'));
+}
+
+static int compareCachedFiles (const void *const one, const void *const two)
+{
+	const cachedFile *const a = (const cachedFile *) one;
+	const cachedFile *const b = (const cachedFile *) two;
+	int result = 0;
+	if (a->modified < b->modified)
+		result = -1;
+	else if (a->modified > b->modified)
+		result = 1;
+	return result;
+}
+
+/*  Lists the entries of the cache, removing on the way any partly written
+ *  entry left long ago by a process which failed.
+ */
+static cachedFile *listCachedFiles (
+		unsigned int *const pCount, unsigned long *const pTotal)
+{
+	DIR *const dir = opendir (Option.cacheDir);
+	cachedFile *files = NULL;
+	unsigned int count = 0, size = 0;
+	*pTotal = 0;
+	if (dir == NULL)
+		error (WARNING | PERROR, "cannot read cache directory \"%s\"",
+				Option.cacheDir);
+	else
+	{
+		const unsigned long now = (unsigned long) time (NULL);
+		struct dirent *entry;
+		while ((entry = readdir (dir)) != NULL)
+		{
+			if (isEntryName (entry->d_name))
+			{
+				vString *const path = combinePathAndFile (Option.cacheDir,
+						entry->d_name);
+				fileStatus *const status = eStat (vStringValue (path));
+				if (! status->exists  ||  ! status->isNormalFile)
+					;
+				else if (entry->d_name [EntryNameLength] == '.')
+				{
+					if (status->modified + StaleInterval < now)
+						remove (vStringValue (path));
+				}
+				else
+				{
+					if (count == size)
+					{
+						size = (size == 0) ? 256 : 2 * size;
+						files = xRealloc (files, size, cachedFile);
+					}
+					files [count].name = eStrdup (vStringValue (path));
+					files [count].size = status->size;
+					files [count].modified = status->modified;
+					*pTotal += status->size;
+					++count;
+				}
+				eStatFree (status);
+				vStringDelete (path);
+			}
+		}
+		closedir (dir);
+	}
+	*pCount = count;
+	return files;
+}
+
+#endif
+
+/*  Removes the entries used least recently while the cache is larger than
+ *  --cache-size. It is trimmed to a little below that, so that it need not
+ *  be trimmed again by every run which adds to it.
+ */
+extern void trimCache (void)
+{
+#ifdef CACHE_TRIMMING_SUPPORTED
+	if (Option.cacheDir != NULL  &&  Option.cacheSize > 0)
+	{
+		const unsigned long limit = Option.cacheSize * 1024 * 1024;
+		unsigned long total;
+		unsigned int count, i;
+		cachedFile *const files = listCachedFiles (&count, &total);
+		if (total > limit)
+		{
+			const unsigned long target = limit - limit / 10;
+			verbose ("trimming cache of %lu bytes to %lu\n", total, target);
+			qsort (files, count, sizeof (cachedFile), compareCachedFiles);
+			for (i = 0  ;  i < count  &&  total > target  ;  ++i)
+			{
+				/* another process may have removed it already */
+				remove (files [i].name);
+				total -= files [i].size;
+			}
+		}
+		for (i = 0  ;  i < count  ;  ++i)
+			eFree (files [i].name);
+		if (files != NULL)
+			eFree (files);
+	}
+#endif
+}
+
+/* vi:set tabstop=4 shiftwidth=4: */
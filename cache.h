@@ -0,0 +1,34 @@
+/*
+*   $Id$
+*
+*   Copyright (c) 2026, Exuberant Ctags contributors
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License.
+*
+*   External interface to cache.c
+*/
+#ifndef _CACHE_H
+#define _CACHE_H
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#include "parse.h"
+
+/*
+*   FUNCTION PROTOTYPES
+*/
+extern boolean tagsFromCache (const char *const fileName, const langType language);
+extern void beginCachedTags (void);
+extern void recordCachedTag (const char *const line, const size_t length);
+extern void abandonCachedTags (void);
+extern void storeCachedTags (void);
+extern void trimCache (void);
+extern void freeCacheResources (void);
+
+#endif  /* _CACHE_H */
+
+/* vi:set tabstop=4 shiftwidth=4: */
@@ -14,26 +14,155 @@
 *   INCLUDE FILES
 */
 #include "general.h"	/* must always come first */
+
+#include <string.h>
+
 #include "parse.h"
+#include "read.h"
+#include "vstring.h"
+
+/*
+*   DATA DEFINITIONS
+*/
+typedef enum {
+	K_DATA, K_FILE, K_GROUP, K_PARAGRAPH, K_PROGRAM, K_SECTION
+} cobolKind;
+
+static kindOption CobolKinds [] = {
+	{ TRUE, 'd', "data",      "data items" },
+	{ TRUE, 'f', "file",      "file descriptions (FD, SD, RD)" },
+	{ TRUE, 'g', "group",     "group items" },
+	{ TRUE, 'p', "paragraph", "paragraphs" },
+	{ TRUE, 'P', "program",   "program ids" },
+	{ TRUE, 's', "section",   "sections" }
+};
+
+/*  The clauses which may follow the name of a data item. */
+static const char *const DataClauses [] = {
+	"BLANK", "OCCURS", "IS", "JUST", "PIC", "REDEFINES", "RENAMES", "SIGN",
+	"SYNC", "USAGE", "VALUE", NULL
+};
 
 /*
 *   FUNCTION DEFINITIONS
 */
 
-static void installCobolRegex (const langType language)
+static boolean isBlank (const int c)
+{
+	return (boolean) (c == ' '  ||  c == '\t');
+}
+
+static boolean isDigit (const int c)
+{
+	return (boolean) (c >= '0'  &&  c <= '9');
+}
+
+static boolean isNameInitial (const int c)
+{
+	return (boolean) ((c >= 'A'  &&  c <= 'Z')  ||  (c >= 'a'  &&  c <= 'z')  ||
+			isDigit (c));
+}
+
+static const unsigned char *skipBlanks (const unsigned char *cp)
+{
+	while (isBlank ((int) *cp))
+		++cp;
+	return cp;
+}
+
+/*  Returns the end of the name beginning at "cp", or NULL if there is none. */
+static const unsigned char *skipName (const unsigned char *cp)
 {
-   addTagRegex (language, "^[ \t]*[0-9]+[ \t]+([A-Z0-9][A-Z0-9-]*)[ \t]+(BLANK|OCCURS|IS|JUST|PIC|REDEFINES|RENAMES|SIGN|SYNC|USAGE|VALUE)",
-		"\\1", "d,data,data items", "i");
-	addTagRegex (language, "^[ \t]*[FSR]D[ \t]+([A-Z0-9][A-Z0-9-]*)\\.",
-		"\\1", "f,file,file descriptions (FD, SD, RD)", "i");
-	addTagRegex (language, "^[ \t]*[0-9]+[ \t]+([A-Z0-9][A-Z0-9-]*)\\.",
-		"\\1", "g,group,group items", "i");
-	addTagRegex (language, "^[ \t]*([A-Z0-9][A-Z0-9-]*)\\.",
-		"\\1", "p,paragraph,paragraphs", "i");
-	addTagRegex (language, "^[ \t]*PROGRAM-ID\\.[ \t]+([A-Z0-9][A-Z0-9-]*)\\.",
-		"\\1", "P,program,program ids", "i");
-	addTagRegex (language, "^[ \t]*([A-Z0-9][A-Z0-9-]*)[ \t]+SECTION\\.",
-		"\\1", "s,section,sections", "i");
+	const unsigned char *result = NULL;
+	if (isNameInitial ((int) *cp))
+	{
+		while (isNameInitial ((int) *cp)  ||  *cp == '-')
+			++cp;
+		result = cp;
+	}
+	return result;
+}
+
+static boolean isDataClause (const unsigned char *const cp)
+{
+	boolean result = FALSE;
+	int i;
+	for (i = 0  ;  ! result  &&  DataClauses [i] != NULL  ;  ++i)
+		result = (boolean) (strncasecmp ((const char*) cp, DataClauses [i],
+				strlen (DataClauses [i])) == 0);
+	return result;
+}
+
+static void makeCobolTag (
+		vString *const name, const unsigned char *const start,
+		const unsigned char *const end, const cobolKind kind)
+{
+	vStringNCopyS (name, (const char*) start, end - start);
+	makeSimpleTag (name, CobolKinds, kind);
+}
+
+/*  Makes the tags for a line, which may be one of
+ *      level-number name clause ...
+ *      FD name.
+ *      level-number name.
+ *      name.
+ *      PROGRAM-ID. name.
+ *      name SECTION.
+ *  where letters may be of either case.
+ */
+static void findCobolTags (void)
+{
+	vString *const name = vStringNew ();
+	const unsigned char *line;
+
+	while ((line = fileReadLine ()) != NULL)
+	{
+		const unsigned char *const cp = skipBlanks (line);
+		const unsigned char *item = NULL;
+		const unsigned char *itemEnd = NULL;
+		const unsigned char *const nameEnd = skipName (cp);
+		const unsigned char *end;
+
+		if (isDigit ((int) *cp))
+		{
+			const unsigned char *p = cp;
+			while (isDigit ((int) *p))
+				++p;
+			if (isBlank ((int) *p))
+			{
+				item = skipBlanks (p);
+				itemEnd = skipName (item);
+			}
+		}
+		if (itemEnd != NULL  &&  isBlank ((int) *itemEnd)  &&
+			isDataClause (skipBlanks (itemEnd)))
+			makeCobolTag (name, item, itemEnd, K_DATA);
+		if (strchr ("FSRfsr", (int) cp [0]) != NULL  &&  cp [0] != '\0'  &&
+			(cp [1] == 'D'  ||  cp [1] == 'd')  &&  isBlank ((int) cp [2]))
+		{
+			const unsigned char *const file = skipBlanks (cp + 2);
+			end = skipName (file);
+			if (end != NULL  &&  *end == '.')
+				makeCobolTag (name, file, end, K_FILE);
+		}
+		if (itemEnd != NULL  &&  *itemEnd == '.')
+			makeCobolTag (name, item, itemEnd, K_GROUP);
+		if (nameEnd != NULL  &&  *nameEnd == '.')
+			makeCobolTag (name, cp, nameEnd, K_PARAGRAPH);
+		if (strncasecmp ((const char*) cp, "PROGRAM-ID.", (size_t) 11) == 0  &&
+			isBlank ((int) cp [11]))
+		{
+			const unsigned char *const program = skipBlanks (cp + 11);
+			end = skipName (program);
+			if (end != NULL  &&  *end == '.')
+				makeCobolTag (name, program, end, K_PROGRAM);
+		}
+		if (nameEnd != NULL  &&  isBlank ((int) *nameEnd)  &&
+			strncasecmp ((const char*) skipBlanks (nameEnd), "SECTION.",
+					(size_t) 8) == 0)
+			makeCobolTag (name, cp, nameEnd, K_SECTION);
+	}
+	vStringDelete (name);
 }
 
 extern parserDefinition* CobolParser ()
@@ -41,9 +170,10 @@ extern parserDefinition* CobolParser ()
 	static const char *const extensions [] = {
 			"cbl", "cob", "CBL", "COB", NULL };
 	parserDefinition* def = parserNew ("Cobol");
+	def->kinds      = CobolKinds;
+	def->kindCount  = KIND_COUNT (CobolKinds);
 	def->extensions = extensions;
-	def->initialize = installCobolRegex;
-	def->regex      = TRUE;
+	def->parser     = findCobolTags;
 	return def;
 }
 
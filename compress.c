@@ -0,0 +1,277 @@
+/*
+*   $Id$
+*
+*   Copyright (c) 2026, Exuberant Ctags contributors
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License.
+*
+*   This module contains functions to compress a complete tag file in place
+*   (see --compress), in blocks compressed independently by zlib, so that
+*   readtags can search it by decompressing only the blocks it reads.
+*
+*   All numbers are unsigned and stored least significant byte first. The
+*   compressed tag file begins with a header of:
+*
+*       magic     8 bytes, COMPRESSED_MAGIC
+*       version   4 bytes, CompressedVersion
+*       count     4 bytes, number of blocks
+*       size      8 bytes, size of the tag file uncompressed
+*       table     8 bytes, offset of the table of blocks
+*
+*   followed by the blocks, each the zlib stream of whole lines of the tag
+*   file, at most BlockSize bytes of them unless a single line is longer,
+*   and then by the table, holding for each block in 8 bytes each the offset
+*   of its first line in the tag file and its own offset. Each block ends
+*   where the next begins, and the last where the table begins.
+*/
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#include <string.h>
+#include <stdio.h>
+#ifdef HAVE_UNISTD_H
+# include <unistd.h>  /* to declare getpid () */
+#endif
+#ifdef HAVE_ZLIB
+# include <zlib.h>
+#endif
+
+#include "compress.h"
+#include "debug.h"
+#include "options.h"
+#include "routines.h"
+#include "vstring.h"
+
+/*
+*   DATA DECLARATIONS
+*/
+enum eCompressedLimits {
+	CompressedVersion = 1,     /* format of compressed tag file */
+	HeaderSize = 32,           /* bytes in header */
+	BlockSize = 64 * 1024      /* bytes of lines in each block, at most */
+};
+
+#ifdef HAVE_ZLIB
+
+typedef struct sBlockEntry {
+	unsigned long start;   /* offset of first line in tag file */
+	unsigned long offset;  /* offset of block in compressed file */
+} blockEntry;
+
+typedef struct sCompressor {
+	FILE *fp;
+	unsigned char *packed;  /* compressed block */
+	size_t packedSize;
+	blockEntry *table;
+	unsigned long count, size;  /* blocks written and allocated */
+	unsigned long start;        /* of next block in tag file */
+} compressor;
+
+#endif
+
+/*
+*   FUNCTION DEFINITIONS
+*/
+
+extern boolean isCompressedTagFile (const char *const fileName)
+{
+	char magic [COMPRESSED_MAGIC_LENGTH];
+	FILE *const fp = fopen (fileName, "rb");
+	boolean result = FALSE;
+	if (fp != NULL)
+	{
+		result = (boolean) (fread (magic, 1, sizeof (magic), fp) ==
+				sizeof (magic)  &&
+				memcmp (magic, COMPRESSED_MAGIC, sizeof (magic)) == 0);
+		fclose (fp);
+	}
+	return result;
+}
+
+#ifdef HAVE_ZLIB
+
+static void writeNumber (FILE *const fp, unsigned long value,
+						 const unsigned int bytes)
+{
+	unsigned int i;
+	for (i = 0  ;  i < bytes  ;  ++i)
+	{
+		putc ((int) (value & 0xff), fp);
+		value >>= 8;
+	}
+}
+
+/*  Compresses and writes the "length" bytes of whole lines at "lines" as
+ *  the next block.
+ */
+static boolean writeBlock (
+		compressor *const c, const unsigned char *const lines,
+		const size_t length)
+{
+	uLongf packedLength = compressBound ((uLong) length);
+	boolean result;
+
+	if ((size_t) packedLength > c->packedSize)
+	{
+		c->packedSize = (size_t) packedLength;
+		c->packed = xRealloc (c->packed, c->packedSize, unsigned char);
+	}
+	if (c->count == c->size)
+	{
+		c->size = c->size == 0 ? 1024 : c->size * 2;
+		c->table = xRealloc (c->table, c->size, blockEntry);
+	}
+	c->table [c->count].start = c->start;
+	c->table [c->count].offset = (unsigned long) ftell (c->fp);
+	result = (boolean) (compress2 (c->packed, &packedLength,
+			lines, (uLong) length, Z_DEFAULT_COMPRESSION) == Z_OK  &&
+			fwrite (c->packed, 1, (size_t) packedLength, c->fp) ==
+				(size_t) packedLength);
+	++c->count;
+	c->start += (unsigned long) length;
+	return result;
+}
+
+/*  Writes the lines read from "in" in blocks, each ending at the last line
+ *  end within BlockSize bytes, unless the line is longer.
+ */
+static boolean writeBlocks (compressor *const c, FILE *const in)
+{
+	size_t size = BlockSize;   /* of buffer */
+	size_t limit = BlockSize;  /* of block being read */
+	unsigned char *buffer = xMalloc (size, unsigned char);
+	size_t used = 0;
+	boolean atEnd = FALSE;
+	boolean result = TRUE;
+
+	while (result  &&  ! (atEnd  &&  used == 0))
+	{
+		size_t cut;
+
+		if (! atEnd  &&  used < limit)
+		{
+			used += fread (buffer + used, 1, limit - used, in);
+			atEnd = (boolean) (used < limit);
+		}
+		for (cut = used  ;  cut > 0  &&  buffer [cut - 1] != '\n'  ;  --cut)
+			;
+		if (cut == 0  &&  ! atEnd)
+		{
+			/*  A line longer than a block is given a block of its own.
+			 */
+			limit *= 2;
+			if (limit > size)
+			{
+				size = limit;
+				buffer = xRealloc (buffer, size, unsigned char);
+			}
+		}
+		else
+		{
+			if (cut == 0)
+				cut = used;  /* last line has no newline */
+			result = writeBlock (c, buffer, cut);
+			memmove (buffer, buffer + cut, used - cut);
+			used -= cut;
+			limit = BlockSize;
+		}
+	}
+	eFree (buffer);
+	return result;
+}
+
+static void writeHeader (const compressor *const c, const unsigned long table)
+{
+	fwrite (COMPRESSED_MAGIC, 1, COMPRESSED_MAGIC_LENGTH, c->fp);
+	writeNumber (c->fp, CompressedVersion, 4);
+	writeNumber (c->fp, c->count, 4);
+	writeNumber (c->fp, c->start, 8);
+	writeNumber (c->fp, table, 8);
+}
+
+static boolean writeCompressed (compressor *const c, FILE *const in)
+{
+	boolean result;
+	unsigned long table;
+	unsigned long i;
+
+	writeHeader (c, 0);  /* rewritten once complete */
+	result = writeBlocks (c, in);
+	table = (unsigned long) ftell (c->fp);
+	for (i = 0  ;  i < c->count  ;  ++i)
+	{
+		writeNumber (c->fp, c->table [i].start, 8);
+		writeNumber (c->fp, c->table [i].offset, 8);
+	}
+	rewind (c->fp);
+	writeHeader (c, table);
+	return (boolean) (result  &&  ! ferror (in)  &&  ! ferror (c->fp));
+}
+
+#endif
+
+/*  Replaces the named tag file, once complete, by its compressed form. It
+ *  is written under another name first, and then renamed, so that readers
+ *  never see it incomplete. Should it not be written, the tag file is left
+ *  uncompressed.
+ */
+extern void compressTagFile (const char *const tagFileName)
+{
+#ifdef HAVE_ZLIB
+	vString *const written = vStringNewInit (tagFileName);
+	FILE *in = fopen (tagFileName, "rb");
+	compressor c;
+	char number [24];
+
+#ifdef HAVE_UNISTD_H
+	sprintf (number, ".%lu", (unsigned long) getpid ());
+#else
+	strcpy (number, ".new");
+#endif
+	vStringCatS (written, number);
+	memset (&c, 0, sizeof (c));
+	verbose ("compressing tag file \"%s\"\n", tagFileName);
+	if (in == NULL)
+		error (WARNING | PERROR, "cannot read tag file \"%s\"", tagFileName);
+	else if ((c.fp = fopen (vStringValue (written), "wb")) == NULL)
+		error (WARNING | PERROR, "cannot write \"%s\"", vStringValue (written));
+	else
+	{
+		boolean ok = writeCompressed (&c, in);
+		if (fclose (c.fp) != 0)
+			ok = FALSE;
+		fclose (in);
+		in = NULL;
+		if (ok  &&  rename (vStringValue (written), tagFileName) != 0)
+		{
+			/* some hosts will not rename over an existing file */
+			remove (tagFileName);
+			ok = (boolean) (rename (vStringValue (written), tagFileName) == 0);
+		}
+		if (! ok)
+		{
+			error (WARNING | PERROR, "cannot compress tag file \"%s\"",
+					tagFileName);
+			remove (vStringValue (written));
+		}
+		else
+			verbose ("compressed %lu bytes into %lu blocks\n",
+					c.start, c.count);
+	}
+	if (in != NULL)
+		fclose (in);
+	if (c.packed != NULL)
+		eFree (c.packed);
+	if (c.table != NULL)
+		eFree (c.table);
+	vStringDelete (written);
+#else
+	error (WARNING, "cannot compress \"%s\" on this host", tagFileName);
+#endif
+}
+
+/* vi:set tabstop=4 shiftwidth=4: */
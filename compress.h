@@ -0,0 +1,33 @@
+/*
+*   $Id$
+*
+*   Copyright (c) 2026, Exuberant Ctags contributors
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License.
+*
+*   External interface to compress.c
+*/
+#ifndef _COMPRESS_H
+#define _COMPRESS_H
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+/*
+*   MACROS
+*/
+#define COMPRESSED_MAGIC  "CTAGSZIP"
+#define COMPRESSED_MAGIC_LENGTH  8
+
+/*
+*   FUNCTION PROTOTYPES
+*/
+extern boolean isCompressedTagFile (const char *const fileName);
+extern void compressTagFile (const char *const tagFileName);
+
+#endif  /* _COMPRESS_H */
+
+/* vi:set tabstop=4 shiftwidth=4: */
@@ -0,0 +1,308 @@
+/*
+*   $Id$
+*
+*   Copyright (c) 2026, Exuberant Ctags contributors
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License.
+*
+*   This module contains functions to watch the directories whose source
+*   files are tagged for changes (see --daemon), using inotify(7). Changes
+*   are collected until none has occurred for a moment, so that a burst of
+*   them, such as when switching branches, is handled at once. A source file
+*   named explicitly is watched through its directory, as editors commonly
+*   save a file by replacing it, but changes to the other files there are
+*   ignored.
+*/
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#include <string.h>
+#include <stdio.h>
+
+#ifdef DAEMON_SUPPORTED
+# include <errno.h>
+# include <poll.h>
+# include <unistd.h>
+# include <sys/inotify.h>
+#endif
+
+#include "daemon.h"
+#include "debug.h"
+#include "options.h"
+#include "routines.h"
+#include "strlist.h"
+#include "vstring.h"
+
+#ifdef DAEMON_SUPPORTED
+
+/*
+*   MACROS
+*/
+#define WATCHED_EVENTS  (IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | \
+						 IN_MOVED_FROM | IN_MOVED_TO)
+
+/*
+*   DATA DECLARATIONS
+*/
+enum eDaemonLimits {
+	SettleTime = 500,          /* milliseconds without change before tagging */
+	EventBufferSize = 64 * 1024
+};
+
+/*  A watched directory.
+ */
+typedef struct sWatch {
+	vString *dirName;
+	stringList *fileNames;  /* files watched within it, or NULL for all */
+} watch;
+
+/*
+*   DATA DEFINITIONS
+*/
+static int Inotify = -1;
+static watch *Watches = NULL;  /* indexed by watch descriptor */
+static int WatchCount = 0;
+static boolean Overflowed = FALSE;    /* were changes lost? */
+
+/*
+*   FUNCTION DEFINITIONS
+*/
+
+/*  Watches a directory, returning the watch for it, or NULL if it cannot be
+ *  watched.
+ */
+static watch *addWatch (const char *const dirName)
+{
+	watch *result = NULL;
+	int wd;
+
+	if (Inotify == -1)
+	{
+		Inotify = inotify_init ();
+		if (Inotify == -1)
+			error (FATAL | PERROR, "cannot watch source directories");
+	}
+	wd = inotify_add_watch (Inotify, dirName, WATCHED_EVENTS);
+	if (wd == -1)
+		error (WARNING | PERROR, "cannot watch directory \"%s\"", dirName);
+	else
+	{
+		if (wd >= WatchCount)
+		{
+			const int count = (wd + 1 > 2 * WatchCount) ?
+					wd + 1 : 2 * WatchCount;
+			int i;
+			Watches = xRealloc (Watches, count, watch);
+			for (i = WatchCount  ;  i < count  ;  ++i)
+			{
+				Watches [i].dirName = NULL;
+				Watches [i].fileNames = NULL;
+			}
+			WatchCount = count;
+		}
+		result = &Watches [wd];
+		if (result->dirName == NULL)
+		{
+			result->dirName = vStringNewInit (dirName);
+			result->fileNames = stringListNewIndexed ();
+		}
+	}
+	return result;
+}
+
+/*  Watches all of the files in a directory recursed into.
+ */
+extern void watchDirectory (const char *const dirName)
+{
+	watch *const w = addWatch (dirName);
+	if (w != NULL)
+	{
+		vStringCopyS (w->dirName, dirName);
+		if (w->fileNames != NULL)
+			stringListDelete (w->fileNames);
+		w->fileNames = NULL;
+	}
+}
+
+/*  Watches a source file named explicitly, rather than found by recursing.
+ */
+extern void watchFile (const char *const fileName)
+{
+	const char *const name = baseFilename (fileName);
+	vString *const dirName = vStringNew ();
+	watch *w;
+
+	if (name == fileName)
+		vStringCopyS (dirName, ".");
+	else
+		vStringNCopyS (dirName, fileName, name - fileName);
+	w = addWatch (vStringValue (dirName));
+	if (w != NULL  &&  w->fileNames != NULL  &&
+		! stringListHas (w->fileNames, name))
+	{
+		stringListAdd (w->fileNames, vStringNewInit (name));
+	}
+	vStringDelete (dirName);
+}
+
+/*  Adds a path, named as when recursing, to the changes unless present.
+ */
+static void addChange (stringList *const changes, vString *const path)
+{
+	if (stringListHas (changes, vStringValue (path)))
+		vStringDelete (path);
+	else
+		stringListAdd (changes, path);
+}
+
+/*  Adds the path of a file within a watched directory to the changes.
+ */
+static void addFileChange (
+		stringList *const changes, const watch *const w,
+		const char *const fileName)
+{
+	const char *const dirName = vStringValue (w->dirName);
+	if (strcmp (dirName, ".") == 0)
+		addChange (changes, vStringNewInit (fileName));
+	else
+		addChange (changes, combinePathAndFile (dirName, fileName));
+}
+
+static void addEventChange (
+		stringList *const changes, const struct inotify_event *const event)
+{
+	if (event->wd >= 0  &&  event->wd < WatchCount  &&
+		Watches [event->wd].dirName != NULL  &&  event->len > 0)
+	{
+		const watch *const w = &Watches [event->wd];
+		if (w->fileNames == NULL  ||  stringListHas (w->fileNames, event->name))
+			addFileChange (changes, w, event->name);
+	}
+}
+
+static void readEvents (stringList *const changes)
+{
+	union {
+		struct inotify_event event;  /* for alignment */
+		char bytes [EventBufferSize];
+	} buffer;
+	const ssize_t length = read (Inotify, buffer.bytes, sizeof (buffer.bytes));
+
+	if (length < 0)
+	{
+		if (errno != EINTR)
+			error (FATAL | PERROR, "cannot read changes to source directories");
+	}
+	else
+	{
+		const char *p = buffer.bytes;
+		while (p < buffer.bytes + length)
+		{
+			const struct inotify_event *const event =
+					(const struct inotify_event *) p;
+			if ((event->mask & IN_Q_OVERFLOW) != 0)
+				Overflowed = TRUE;
+			else
+				addEventChange (changes, event);
+			p += sizeof (struct inotify_event) + event->len;
+		}
+	}
+}
+
+/*  Waits for changes within the watched directories, returning the paths
+ *  changed, created or deleted once no further change occurs for a moment.
+ *  Should changes have been lost, the watched directories themselves are
+ *  returned, so that all of their files are examined again.
+ */
+extern stringList *waitForChangedFiles (void)
+{
+	stringList *const changes = stringListNewIndexed ();
+	int timeout = -1;  /* wait for the first change as long as it takes */
+	boolean settled = FALSE;
+	struct pollfd fds;
+
+	if (Inotify == -1)
+		error (FATAL, "no source files to watch");
+	fds.fd = Inotify;
+	fds.events = POLLIN;
+	while (! settled)
+	{
+		const int ready = poll (&fds, 1, timeout);
+		if (ready > 0)
+		{
+			readEvents (changes);
+			if (stringListCount (changes) > 0  ||  Overflowed)
+				timeout = SettleTime;
+		}
+		else if (ready == 0)
+			settled = TRUE;
+		else if (errno != EINTR)
+			error (FATAL | PERROR, "cannot wait for changes to source directories");
+	}
+	if (Overflowed)
+	{
+		int wd;
+		unsigned int i;
+		error (WARNING, "too many changes at once; examining all files");
+		for (wd = 0  ;  wd < WatchCount  ;  ++wd)
+		{
+			const watch *const w = &Watches [wd];
+			if (w->dirName != NULL  &&  w->fileNames == NULL)
+				addChange (changes, vStringNewCopy (w->dirName));
+			else if (w->dirName != NULL)
+			{
+				for (i = 0  ;  i < stringListCount (w->fileNames)  ;  ++i)
+					addFileChange (changes, w,
+							vStringValue (stringListItem (w->fileNames, i)));
+			}
+		}
+		Overflowed = FALSE;
+	}
+	return changes;
+}
+
+extern void freeDaemonResources (void)
+{
+	int wd;
+	for (wd = 0  ;  wd < WatchCount  ;  ++wd)
+	{
+		if (Watches [wd].dirName != NULL)
+			vStringDelete (Watches [wd].dirName);
+		if (Watches [wd].fileNames != NULL)
+			stringListDelete (Watches [wd].fileNames);
+	}
+	if (Watches != NULL)
+		eFree (Watches);
+	Watches = NULL;
+	WatchCount = 0;
+	if (Inotify != -1)
+		close (Inotify);
+	Inotify = -1;
+}
+
+#else
+
+extern void watchDirectory (const char *const dirName __unused__)
+{
+}
+
+extern void watchFile (const char *const fileName __unused__)
+{
+}
+
+extern stringList *waitForChangedFiles (void)
+{
+	return stringListNew ();
+}
+
+extern void freeDaemonResources (void)
+{
+}
+
+#endif  /* DAEMON_SUPPORTED */
+
+/* vi:set tabstop=4 shiftwidth=4: */
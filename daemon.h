@@ -0,0 +1,31 @@
+/*
+*   $Id$
+*
+*   Copyright (c) 2026, Exuberant Ctags contributors
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License.
+*
+*   External interface to daemon.c
+*/
+#ifndef _DAEMON_H
+#define _DAEMON_H
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#include "strlist.h"
+
+/*
+*   FUNCTION PROTOTYPES
+*/
+extern void watchDirectory (const char *const dirName);
+extern void watchFile (const char *const fileName);
+extern stringList *waitForChangedFiles (void);
+extern void freeDaemonResources (void);
+
+#endif  /* _DAEMON_H */
+
+/* vi:set tabstop=4 shiftwidth=4: */
@@ -16,26 +16,104 @@
 
 #include <string.h>
 #include "parse.h"
+#include "read.h"
+#include "vstring.h"
+
+/*
+*   DATA DEFINITIONS
+*/
+typedef enum {
+	K_LABEL, K_VARIABLE
+} dosBatchKind;
+
+static kindOption DosBatchKinds [] = {
+	{ TRUE, 'l', "label",    "labels" },
+	{ TRUE, 'v', "variable", "variables" }
+};
 
 /*
 *   FUNCTION DEFINITIONS
 */
 
-static void installDosBatchRegex (const langType language)
+static boolean isNameChar (const int c)
+{
+	return (boolean) ((c >= 'A'  &&  c <= 'Z')  ||  (c >= 'a'  &&  c <= 'z')  ||
+			(c >= '0'  &&  c <= '9')  ||  c == '_');
+}
+
+static const unsigned char *skipBlanks (const unsigned char *cp)
+{
+	while (*cp == ' '  ||  *cp == '\t')
+		++cp;
+	return cp;
+}
+
+static const unsigned char *skipName (const unsigned char *cp)
 {
-	addTagRegex (language,
-		"^:([A-Za-z_0-9]+)", "\\1", "l,label,labels", NULL);
-	addTagRegex (language,
-		"set[ \t]+([A-Za-z_0-9]+)[ \t]*=", "\\1", "v,variable,variables", NULL);
+	while (isNameChar ((int) *cp))
+		++cp;
+	return cp;
+}
+
+/*  Makes a tag for a line beginning with
+ *  :label
+ */
+static void findLabel (const unsigned char *const line, vString *const name)
+{
+	if (line [0] == ':')
+	{
+		const unsigned char *const end = skipName (line + 1);
+		vStringNCopyS (name, (const char*) line + 1, end - line - 1);
+		makeSimpleTag (name, DosBatchKinds, K_LABEL);
+	}
+}
+
+/*  Makes a tag for the first part of the line of the form
+ *  set variable=
+ */
+static void findVariable (const unsigned char *const line, vString *const name)
+{
+	const char *set = strstr ((const char*) line, "set");
+	boolean found = FALSE;
+	while (! found  &&  set != NULL)
+	{
+		const unsigned char *cp = (const unsigned char*) set + 3;
+		if (*cp == ' '  ||  *cp == '\t')
+		{
+			const unsigned char *const start = skipBlanks (cp);
+			cp = skipName (start);
+			if (cp > start  &&  *skipBlanks (cp) == '=')
+			{
+				vStringNCopyS (name, (const char*) start, cp - start);
+				makeSimpleTag (name, DosBatchKinds, K_VARIABLE);
+				found = TRUE;
+			}
+		}
+		set = strstr (set + 1, "set");
+	}
+}
+
+static void findDosBatchTags (void)
+{
+	vString *const name = vStringNew ();
+	const unsigned char *line;
+
+	while ((line = fileReadLine ()) != NULL)
+	{
+		findLabel (line, name);
+		findVariable (line, name);
+	}
+	vStringDelete (name);
 }
 
 extern parserDefinition* DosBatchParser ()
 {
 	static const char *const extensions [] = { "bat", "cmd", NULL };
 	parserDefinition* const def = parserNew ("DosBatch");
+	def->kinds      = DosBatchKinds;
+	def->kindCount  = KIND_COUNT (DosBatchKinds);
 	def->extensions = extensions;
-	def->initialize = installDosBatchRegex;
-	def->regex      = TRUE;
+	def->parser     = findDosBatchTags;
 	return def;
 }
 
@@ -1265,8 +1265,8 @@ extern parserDefinition* EiffelParser (void)
 
 static void findReferences (void)
 {
-	ReferencedTypes = stringListNew ();
-	GenericNames = stringListNew ();
+	ReferencedTypes = stringListNewIndexed ();
+	GenericNames = stringListNewIndexed ();
 	initialize (0);
 
 	findEiffelTags ();
@@ -38,15 +38,20 @@
 # include <io.h>
 #endif
 
+#include "cache.h"
+#include "compress.h"
 #include "debug.h"
 #include "ctags.h"
 #include "entry.h"
 #include "main.h"
+#include "manifest.h"
 #include "options.h"
 #include "read.h"
 #include "routines.h"
 #include "sort.h"
 #include "strlist.h"
+#include "tagindex.h"
+#include "trace.h"
 
 /*
 *   MACROS
@@ -55,6 +60,15 @@
 
 #define includeExtensionFlags()         (Option.tagFileFormat > 1)
 
+/*  Smallest block of memory allocated to hold tag lines.
+ */
+#define MinimumSlabSize                 (1024 * 1024)
+
+/*  Most bytes of tag lines collected for the file being parsed before they
+ *  are written out early.
+ */
+#define MaxCollectedFileTags            (4 * 1024 * 1024)
+
 /*
  *  Portability defines
  */
@@ -71,6 +85,22 @@
 # define O_RDWR         _O_RDWR
 #endif
 
+/*
+*   DATA DECLARATIONS
+*/
+
+typedef enum eOutputFormat {
+	OUTPUT_ETAGS, OUTPUT_XREF, OUTPUT_JSON
+} outputFormat;
+
+/*  An output written alongside the tag file (see --extra-output).
+ */
+typedef struct sExtraOutput {
+	outputFormat format;
+	FILE *fp;
+	vString *fileTags;  /* entries for the source file being tagged */
+} extraOutput;
+
 /*
 *   DATA DEFINITIONS
 */
@@ -81,11 +111,31 @@ tagFile TagFile = {
     NULL,               /* file pointer */
     { 0, 0 },           /* numTags */
     { 0, 0, 0 },        /* max */
-    { NULL, NULL, 0 },  /* etags */
-    NULL                /* vLine */
+    { NULL },           /* etags */
+    NULL,               /* vLine */
+    NULL,               /* vEntry */
+    { FALSE, NULL, NULL, 0, 0, NULL, 0, 0, NULL, 0 },  /* held */
+    { FALSE, 0 }        /* append */
 };
 
 static boolean TagsToStdout = FALSE;
+static boolean TagsInMemory = FALSE;  /* filter mode holds tags of each file */
+static tagSink TagSink = NULL;  /* receives tags in place of the tag file */
+
+static vString *FileTags = NULL;  /* collected tags of file being parsed */
+static boolean CollectingFileTags = FALSE;
+static unsigned long FileTagsFlushes = 0;  /* times collected tags written */
+
+static extraOutput *ExtraOutputs = NULL;
+static unsigned int ExtraOutputCount = 0;
+static boolean ExtraJsonOutput = FALSE;  /* is any extra output JSON? */
+
+/*  The pattern of the source line of the last tag located by a pattern,
+ *  reused by the tags which follow it on the same line.
+ */
+static vString *LinePattern = NULL;
+static fpos_t LinePatternPosition;
+static boolean LinePatternValid = FALSE;
 
 /*
 *   FUNCTION PROTOTYPES
@@ -98,6 +148,11 @@ extern int truncate (const char *path, off_t length);
 extern int ftruncate (int fd, off_t length);
 #endif
 
+static void openExtraOutputs (void);
+static void closeExtraOutputs (void);
+static void endExtraOutputFile (void);
+static void discardExtraOutputFile (void);
+
 /*
 *   FUNCTION DEFINITIONS
 */
@@ -107,6 +162,14 @@ extern void freeTagFileResources (void)
 	if (TagFile.directory != NULL)
 		eFree (TagFile.directory);
 	vStringDelete (TagFile.vLine);
+	vStringDelete (TagFile.vEntry);
+	vStringDelete (FileTags);
+	FileTags = NULL;
+	vStringDelete (LinePattern);
+	LinePattern = NULL;
+	vStringDelete (TagFile.etags.section);
+	TagFile.etags.section = NULL;
+	discardHeldTags ();
 }
 
 extern const char *tagFileName (void)
@@ -233,7 +296,13 @@ static long unsigned int updatePseudoTags (FILE *const fp)
 				tab == '\t')
 			{
 				if (strcmp (classType, "_SORTED") == 0)
+				{
+					const char *const flag = strchr (line, '\t') + 1;
+					TagFile.append.sorted = (boolean) (
+						Option.sorted != SO_UNSORTED  &&
+						*flag - '0' == (int) Option.sorted);
 					updateSortedFlag (line, fp, startOfLine);
+				}
 			}
 			fgetpos (fp, &startOfLine);
 		}
@@ -330,7 +399,9 @@ static boolean isTagFile (const char *const filename)
 		if (line == NULL)
 			ok = TRUE;
 		else
-			ok = (boolean) (isCtagsLine (line) || isEtagsLine (line));
+			ok = (boolean) (isCtagsLine (line) || isEtagsLine (line) ||
+					strncmp (line, COMPRESSED_MAGIC,
+							COMPRESSED_MAGIC_LENGTH) == 0);
 		fclose (fp);
 	}
 	return ok;
@@ -374,17 +445,430 @@ extern void copyFile (const char *const from, const char *const to, const long s
 	}
 }
 
+/*
+ *  Tags held in memory
+ *
+ *  When ctags sorts the tags itself, the formatted tag lines are held in
+ *  memory instead of being written to the tag file, only to be read back in
+ *  again to be sorted. Should they come to occupy more memory than allowed
+ *  by --sort-memory, they are written out to the tag file, to be read back
+ *  in with its other contents when sorting.
+ *
+ *  In filter and server modes, the tags of each file are always held,
+ *  whether or not they are to be sorted, and are written straight to the
+ *  standard output once the file is parsed, so that no tag file is written
+ *  at all.
+ */
+
+static boolean isHoldingPossible (void)
+{
+	return (boolean) (Option.sorted != SO_UNSORTED  &&  Option.sortMemory > 0  &&
+		! Option.etags  &&  ! Option.xref  &&  ! Option.json  &&  ! Option.merge);
+}
+
+/*  Returns space for "length" bytes in the slab most recently allocated,
+ *  allocating a new one when it has too little left. Slabs are sized to
+ *  hold many of the longest lines seen so far.
+ */
+static char *allocateHeldBytes (const size_t length)
+{
+	struct sHeld *const held = &TagFile.held;
+	char *result;
+
+	if (held->slabs == NULL  ||
+		held->slabs->used + length > held->slabs->size)
+	{
+		tagSlab *const slab = xMalloc (1, tagSlab);
+		size_t size = 64 * TagFile.max.line;
+		if (size < MinimumSlabSize)
+			size = MinimumSlabSize;
+		if (size < length)
+			size = length;
+		slab->buffer = xMalloc (size, char);
+		slab->size = size;
+		slab->used = 0;
+		slab->next = held->slabs;
+		held->slabs = slab;
+		held->memory += size;
+	}
+	result = held->slabs->buffer + held->slabs->used;
+	held->slabs->used += length;
+	return result;
+}
+
+/*  Returns the index of the hash chain of a held file name.
+ */
+static unsigned int heldNameIndex (const char *const name, const size_t length)
+{
+	const unsigned long hash = hashBytes (INITIAL_HASH,
+			(const unsigned char *) name, length);
+	return (unsigned int) (hash & (TagFile.held.nameTableSize - 1));
+}
+
+static void rehashHeldNames (void)
+{
+	struct sHeld *const held = &TagFile.held;
+	heldName **const old = held->names;
+	const unsigned int oldSize = held->nameTableSize;
+	unsigned int i;
+
+	held->nameTableSize = oldSize == 0 ? 256 : oldSize * 2;
+	held->names = xCalloc (held->nameTableSize, heldName *);
+	held->memory += (held->nameTableSize - oldSize) * sizeof (heldName *);
+	for (i = 0  ;  i < oldSize  ;  ++i)
+	{
+		heldName *name = old [i];
+		while (name != NULL)
+		{
+			heldName *const next = name->next;
+			const unsigned int k = heldNameIndex (name->text, name->length);
+			name->next = held->names [k];
+			held->names [k] = name;
+			name = next;
+		}
+	}
+	if (old != NULL)
+		eFree (old);
+}
+
+/*  Returns the single held copy of a file name, or of a file name and
+ *  pattern. Since the tags of a file are held together, the name is usually
+ *  that of the last line held.
+ */
+static const heldName *holdFileName (const char *const name, const size_t length)
+{
+	struct sHeld *const held = &TagFile.held;
+	heldName *result;
+	unsigned int k;
+
+	if (held->lastName != NULL  &&  held->lastName->length == length  &&
+		memcmp (held->lastName->text, name, length) == 0)
+	{
+		return held->lastName;
+	}
+	if (held->names == NULL)
+		rehashHeldNames ();
+	k = heldNameIndex (name, length);
+	result = held->names [k];
+	while (result != NULL  &&  ! (result->length == length  &&
+			memcmp (result->text, name, length) == 0))
+		result = result->next;
+	if (result == NULL)
+	{
+		result = (heldName *) eMalloc (sizeof (heldName) + length);
+		memcpy (result->text, name, length);
+		result->text [length] = '\0';
+		result->length = (unsigned int) length;
+		result->next = held->names [k];
+		held->names [k] = result;
+		held->memory += sizeof (heldName) + length;
+		if (++held->nameCount > held->nameTableSize)
+			rehashHeldNames ();
+	}
+	held->lastName = result;
+	return result;
+}
+
+/*  Holds a tag line, which must end with a newline, for sorting. The file
+ *  field, being the same for every tag of a file, is held apart, together
+ *  with the "shared" characters following it, which are the pattern of a
+ *  tag sharing its source line with the tag before it.
+ */
+static void holdTagLineSharing (
+		const char *const line, const size_t length, const size_t shared)
+{
+	struct sHeld *const held = &TagFile.held;
+	const char *const tab1 = memchr (line, '\t', length);
+	const char *tab2 = tab1 == NULL ? NULL :
+			memchr (tab1 + 1, '\t', length - (tab1 + 1 - line));
+	tagLine *entry;
+	char *copy;
+
+	if (held->count == held->size)
+	{
+		held->memory -= held->size * sizeof (tagLine);
+		held->size = held->size == 0 ? 4096 : held->size * 2;
+		held->lines = xRealloc (held->lines, held->size, tagLine);
+		held->memory += held->size * sizeof (tagLine);
+	}
+	entry = &held->lines [held->count];
+	if (tab2 != NULL  &&  shared > 0  &&
+		(size_t) (tab2 + 1 - line) + shared < length)
+	{
+		tab2 += 1 + shared;
+	}
+	if (tab2 == NULL)
+	{
+		copy = allocateHeldBytes (length + 1);
+		memcpy (copy, line, length);
+		entry->file = NULL;
+		entry->length = (unsigned int) length;
+		entry->split = entry->length + 1;
+	}
+	else
+	{
+		const size_t split = tab1 + 1 - line;
+		const size_t fileLength = tab2 - (tab1 + 1);
+		entry->file = holdFileName (tab1 + 1, fileLength);
+		entry->length = (unsigned int) (length - fileLength);
+		entry->split = (unsigned int) split;
+		copy = allocateHeldBytes (entry->length + 1);
+		memcpy (copy, line, split);
+		memcpy (copy + split, tab2, length - (tab2 - line));
+	}
+	copy [entry->length] = '\0';
+	entry->line = copy;
+	memset (entry->prefix, '\0', TAG_LINE_PREFIX_LENGTH);
+	memcpy (entry->prefix, line,
+			length < TAG_LINE_PREFIX_LENGTH ? length : TAG_LINE_PREFIX_LENGTH);
+	++held->count;
+}
+
+extern void holdTagLine (const char *const line, const size_t length)
+{
+	holdTagLineSharing (line, length, 0);
+}
+
+/*  Appends a held tag line to "buffer", restoring its file field.
+ */
+extern void appendHeldLine (vString *const buffer, const tagLine *const line)
+{
+	if (line->file == NULL)
+		vStringNCatS (buffer, line->line, line->length);
+	else
+	{
+		vStringNCatS (buffer, line->line, line->split);
+		vStringNCatS (buffer, line->file->text, line->file->length);
+		vStringNCatS (buffer, line->line + line->split,
+				line->length - line->split);
+	}
+}
+
+/*  Writes a held tag line, restoring its file field.
+ */
+extern boolean writeHeldLine (const tagLine *const line, FILE *const fp)
+{
+	boolean result;
+	if (line->file == NULL)
+		result = (boolean) (fwrite (line->line, 1, line->length, fp) ==
+				line->length);
+	else
+	{
+		const size_t rest = line->length - line->split;
+		result = (boolean) (
+			fwrite (line->line, 1, line->split, fp) == line->split  &&
+			fwrite (line->file->text, 1, line->file->length, fp) ==
+					line->file->length  &&
+			fwrite (line->line + line->split, 1, rest, fp) == rest);
+	}
+	return result;
+}
+
+/*  Forgets all held tags, releasing their memory.
+ */
+extern void discardHeldTags (void)
+{
+	struct sHeld *const held = &TagFile.held;
+	while (held->slabs != NULL)
+	{
+		tagSlab *const next = held->slabs->next;
+		eFree (held->slabs->buffer);
+		eFree (held->slabs);
+		held->slabs = next;
+	}
+	if (held->lines != NULL)
+		eFree (held->lines);
+	if (held->names != NULL)
+	{
+		unsigned int i;
+		for (i = 0  ;  i < held->nameTableSize  ;  ++i)
+		{
+			heldName *name = held->names [i];
+			while (name != NULL)
+			{
+				heldName *const next = name->next;
+				eFree (name);
+				name = next;
+			}
+		}
+		eFree (held->names);
+	}
+	held->lines = NULL;
+	held->count = 0;
+	held->size = 0;
+	held->names = NULL;
+	held->nameCount = 0;
+	held->nameTableSize = 0;
+	held->lastName = NULL;
+	held->memory = 0;
+}
+
+/*  Determines whether tags are written to a tag file, even a temporary one,
+ *  rather than held in memory for filter mode or passed to a sink.
+ */
+static boolean isTagFileWritten (void)
+{
+	return (boolean) (! TagsInMemory  &&  TagSink == NULL);
+}
+
+/*  Determines whether the whole tag file is sorted once complete, so that
+ *  tags may be written to it in any order, or merged into it as sorted runs
+ *  (see addSortedRun ()).
+ */
+extern boolean isTagFileSortedAtClose (void)
+{
+	return (boolean) (isTagFileWritten ()  &&  isHoldingPossible ()  &&
+		! Option.append  &&  ! Option.incremental  &&
+		Option.removeFiles == NULL  &&  Option.updateFiles == NULL);
+}
+
+/*  Writes the held tags out to the tag file, and holds no more.
+ */
+static void spillHeldTags (void)
+{
+	unsigned long i;
+
+	verbose ("writing %lu held tags to tag file\n", TagFile.held.count);
+	for (i = 0  ;  i < TagFile.held.count  ;  ++i)
+		writeHeldLine (&TagFile.held.lines [i], TagFile.fp);
+	discardHeldTags ();
+	TagFile.held.enabled = FALSE;
+}
+
+/*  Writes all tags from now on directly to the tag file, forgetting any
+ *  held tags, which belong to another process writing the same tag file.
+ */
+extern void stopHoldingTags (void)
+{
+	discardHeldTags ();
+	TagFile.held.enabled = FALSE;
+}
+
+/*
+ *  Tags collected for the file being parsed
+ *
+ *  When tags are not held in memory, the tag lines of the file being parsed
+ *  are collected in memory until it is done, so that tags discarded when a
+ *  parser asks to parse the file again are simply forgotten rather than
+ *  rewound out of the tag file. Only a file with a great many tags has them
+ *  written out before it is done, except when JSON lines are streamed to the
+ *  standard output, which cannot be rewound.
+ */
+
+static void writeTagBytes (const char *const line, const size_t length)
+{
+	if (! CollectingFileTags)
+		fwrite (line, 1, length, TagFile.fp);
+	else
+	{
+		vStringNCatS (FileTags, line, length);
+		if (vStringLength (FileTags) > MaxCollectedFileTags  &&  ! Option.json)
+			flushFileTags ();
+	}
+}
+
+/*  Begins collecting the tags of a file about to be parsed.
+ */
+extern void beginFileTags (void)
+{
+	CollectingFileTags = (boolean) (! TagFile.held.enabled  &&
+			TagSink == NULL  &&  ! Option.etags  &&  ! Option.xref);
+	if (CollectingFileTags  &&  FileTags == NULL)
+		FileTags = vStringNew ();
+	LinePatternValid = FALSE;
+}
+
+/*  Writes the tags collected so far out to the tag file.
+ */
+extern void flushFileTags (void)
+{
+	if (FileTags != NULL  &&  vStringLength (FileTags) > 0)
+	{
+		fwrite (vStringValue (FileTags), 1, vStringLength (FileTags),
+				TagFile.fp);
+		vStringClear (FileTags);
+		++FileTagsFlushes;
+	}
+}
+
+/*  Writes out the collected tags of a file which has been parsed, and
+ *  collects no more.
+ */
+extern void endFileTags (void)
+{
+	flushFileTags ();
+	CollectingFileTags = FALSE;
+	LinePatternValid = FALSE;
+	endExtraOutputFile ();
+}
+
+/*  Gets the current position of the tag file, to which tags written later
+ *  may be discarded using setTagFilePosition (). Held tags are written out
+ *  here, rather than while tags are written, if they occupy too much memory.
+ */
+extern void getTagFilePosition (tagFilePosition *const pos)
+{
+	if (TagFile.held.enabled  &&  isTagFileWritten ()  &&
+		TagFile.held.memory / (1024 * 1024) >= Option.sortMemory)
+	{
+		spillHeldTags ();
+	}
+	flushFileTags ();
+	if (isTagFileWritten ())
+		fgetpos (TagFile.fp, &pos->position);
+	pos->heldCount = TagFile.held.count;
+	pos->added = TagFile.numTags.added;
+	pos->flushes = FileTagsFlushes;
+	pos->etagsLength = TagFile.etags.section == NULL ? 0 :
+			vStringLength (TagFile.etags.section);
+}
+
+/*  Returns the tag file to a position obtained by getTagFilePosition (),
+ *  discarding the tags written since. The memory of discarded held tags is
+ *  only reclaimed after sorting. The tag file itself is only rewound when
+ *  collected tags have been written to it since.
+ */
+extern void setTagFilePosition (const tagFilePosition *const pos)
+{
+	if (FileTags != NULL)
+		vStringClear (FileTags);
+	discardExtraOutputFile ();
+	if (! isTagFileWritten ())
+		;  /* nothing written */
+	else if (! CollectingFileTags  ||  FileTagsFlushes != pos->flushes)
+		fsetpos (TagFile.fp, &pos->position);
+	if (Option.etags  &&  TagFile.etags.section != NULL)
+	{
+		vStringChar (TagFile.etags.section, pos->etagsLength) = '\0';
+		vStringSetLength (TagFile.etags.section);
+	}
+	TagFile.held.count = pos->heldCount;
+	TagFile.numTags.added = pos->added;
+}
+
 extern void openTagFile (void)
 {
 	setDefaultTagFileName ();
 	TagsToStdout = isDestinationStdout ();
+	TagsInMemory = (boolean) ((Option.filter  ||  Option.server)  &&
+			! Option.etags  &&  ! Option.xref  &&  ! Option.json  &&
+			! Option.merge);
 
 	if (TagFile.vLine == NULL)
 		TagFile.vLine = vStringNew ();
+	if (TagFile.vEntry == NULL)
+		TagFile.vEntry = vStringNew ();
+	TagFile.numTags.added = 0;
+	TagFile.numTags.prev = 0;
+	TagFile.append.sorted = FALSE;
 
 	/*  Open the tags file.
 	 */
-	if (TagsToStdout)
+	if (TagsInMemory)
+		TagFile.fp = NULL;
+	else if (Option.json)
+		TagFile.fp = stdout;  /* streamed, never sorted */
+	else if (TagsToStdout)
 		TagFile.fp = tempFile ("w", &TagFile.name);
 	else
 	{
@@ -407,15 +891,32 @@ extern void openTagFile (void)
 		}
 		else
 		{
-			if (Option.append  &&  fileExists)
+			if (fileExists  &&  (Option.append  ||  Option.incremental)  &&
+				isCompressedTagFile (TagFile.name))
+			{
+				error (FATAL, "\"%s\" is compressed, so cannot be updated",
+						TagFile.name);
+			}
+			if (fileExists  &&  (Option.append  ||
+				(Option.incremental  &&  loadManifest (TagFile.name))))
 			{
 				TagFile.fp = fopen (TagFile.name, "r+");
 				if (TagFile.fp != NULL)
 				{
 					TagFile.numTags.prev = updatePseudoTags (TagFile.fp);
 					fclose (TagFile.fp);
+					if (! TagFile.append.sorted  &&  (Option.removeFiles != NULL
+							||  Option.updateFiles != NULL))
+						error (FATAL,
+							"\"%s\" is not sorted as required to remove tags",
+							TagFile.name);
 					TagFile.fp = fopen (TagFile.name, "a+");
 				}
+				if (TagFile.fp != NULL)
+				{
+					fseek (TagFile.fp, 0L, SEEK_END);
+					TagFile.append.size = ftell (TagFile.fp);
+				}
 			}
 			else
 			{
@@ -430,10 +931,14 @@ extern void openTagFile (void)
 			exit (1);
 		}
 	}
+	if (TagFile.directory != NULL)
+		eFree (TagFile.directory);
 	if (TagsToStdout)
 		TagFile.directory = eStrdup (CurrentDirectory);
 	else
 		TagFile.directory = absoluteDirname (TagFile.name);
+	TagFile.held.enabled = (boolean) (TagsInMemory  ||  isHoldingPossible ());
+	openExtraOutputs ();
 }
 
 #ifdef USE_REPLACEMENT_TRUNCATE
@@ -457,9 +962,18 @@ static int replacementTruncate (const char *const name, const long size)
 
 static void sortTagFile (void)
 {
-	if (TagFile.numTags.added > 0L)
+	const boolean obsolete = hasObsoleteTags ();
+
+	if (TagFile.numTags.added > 0L  ||  obsolete)
 	{
-		if (Option.sorted != SO_UNSORTED)
+		if (Option.sorted != SO_UNSORTED  &&  ! Option.merge  &&
+			TagFile.append.sorted)
+		{
+			verbose ("merging appended tags into tag file\n");
+			mergeAppendedTags (TagFile.append.size,
+					obsolete ? isObsoleteTagLine : NULL);
+		}
+		else if (Option.sorted != SO_UNSORTED  &&  ! Option.merge)
 		{
 			verbose ("sorting tag file\n");
 #ifdef EXTERNAL_SORT
@@ -519,7 +1033,21 @@ static void writeEtagsIncludes (FILE *const fp)
 	}
 }
 
-extern void closeTagFile (const boolean resize)
+/*  Writes the held tags of the file just parsed in filter or server mode to
+ *  the standard output.
+ */
+static void writeFilterTags (void)
+{
+	PushMemoryAccount (MEMORY_SORT);
+	TracePoint1 (sort__begin, "-");
+	writeHeldTags ();
+	TracePoint1 (sort__end, "-");
+	PopMemoryAccount ();
+}
+
+/*  Completes the tag file written, sorting it and writing its index.
+ */
+static void finishTagFile (const boolean resize)
 {
 	long desiredSize, size;
 
@@ -536,79 +1064,103 @@ extern void closeTagFile (const boolean resize)
 				TagFile.name, size, desiredSize); )
 		resizeTagFile (desiredSize);
 	}
+	PushMemoryAccount (MEMORY_SORT);
+	TracePoint1 (sort__begin, TagFile.name);
 	sortTagFile ();
+	TracePoint1 (sort__end, TagFile.name);
+	checkRemovedFiles ();
+	if (Option.tagIndex  ||  Option.tagBloom)
+	{
+		TracePoint1 (index__begin, TagFile.name);
+		writeTagIndex (TagFile.name);
+		TracePoint1 (index__end, TagFile.name);
+	}
+	else if (! TagsToStdout  &&  ! Option.etags  &&  ! Option.xref)
+		removeTagIndex (TagFile.name);
+	PopMemoryAccount ();
+	if (Option.compress)
+		compressTagFile (TagFile.name);
+	if (Option.incremental)
+		writeManifest (TagFile.name);
+	freeManifestResources ();
 	eFree (TagFile.name);
 	TagFile.name = NULL;
 }
 
+extern void closeTagFile (const boolean resize)
+{
+	closeExtraOutputs ();
+	if (TagsInMemory)
+		writeFilterTags ();
+	else if (Option.json)
+		fflush (TagFile.fp);
+	else
+		finishTagFile (resize);
+}
+
+/*  Begins the etags section of a source file. Its entries are formatted in
+ *  memory, since the header of the section, written first, holds their
+ *  size in bytes.
+ */
 extern void beginEtagsFile (void)
 {
-	TagFile.etags.fp = tempFile ("w+b", &TagFile.etags.name);
-	TagFile.etags.byteCount = 0;
+	if (TagFile.etags.section == NULL)
+		TagFile.etags.section = vStringNew ();
+	vStringClear (TagFile.etags.section);
 }
 
 extern void endEtagsFile (const char *const name)
 {
-	const char *line;
+	vString *const section = TagFile.etags.section;
 
-	fprintf (TagFile.fp, "\f\n%s,%ld\n", name, (long) TagFile.etags.byteCount);
-	if (TagFile.etags.fp != NULL)
-	{
-		rewind (TagFile.etags.fp);
-		while ((line = readLine (TagFile.vLine, TagFile.etags.fp)) != NULL)
-			fputs (line, TagFile.fp);
-		fclose (TagFile.etags.fp);
-		remove (TagFile.etags.name);
-		eFree (TagFile.etags.name);
-		TagFile.etags.fp = NULL;
-		TagFile.etags.name = NULL;
-	}
+	fprintf (TagFile.fp, "\f\n%s,%ld\n", name, (long) vStringLength (section));
+	fwrite (vStringValue (section), 1, vStringLength (section), TagFile.fp);
+	vStringClear (section);
 }
 
 /*
  *  Tag entry management
  */
 
-/*  This function copies the current line out to a specified file. It has no
- *  effect on the fileGetc () function.  During copying, any '\' characters
- *  are doubled and a leading '^' or trailing '$' is also quoted. End of line
+/*  This function appends the current line to a tag entry. It has no effect
+ *  on the fileGetc () function.  During copying, any '\' characters are
+ *  doubled and a leading '^' or trailing '$' is also quoted. End of line
  *  characters (line feed or carriage return) are dropped.
  */
-static size_t writeSourceLine (FILE *const fp, const char *const line)
+static void appendSourceLine (vString *const entry, const char *const line)
 {
-	size_t length = 0;
-	const char *p;
+	const char *const special = Option.backward ? "\r\n\\?$" : "\r\n\\/$";
+	const char *p = line;
 
-	/*  Write everything up to, but not including, a line end character.
+	/*  Copy everything up to, but not including, a line end character,
+	 *  copying runs of ordinary characters at once.
 	 */
-	for (p = line  ;  *p != '\0'  ;  ++p)
+	for (;;)
 	{
-		const int next = *(p + 1);
-		const int c = *p;
+		const size_t span = strcspn (p, special);
+		int c, next;
 
-		if (c == CRETURN  ||  c == NEWLINE)
+		vStringNCatS (entry, p, span);
+		p += span;
+		c = *p;
+		if (c == '\0'  ||  c == CRETURN  ||  c == NEWLINE)
 			break;
 
 		/*  If character is '\', or a terminal '$', then quote it.
 		 */
-		if (c == BACKSLASH  ||  c == (Option.backward ? '?' : '/')  ||
-			(c == '$'  &&  (next == NEWLINE  ||  next == CRETURN)))
-		{
-			putc (BACKSLASH, fp);
-			++length;
-		}
-		putc (c, fp);
-		++length;
+		next = *(p + 1);
+		if (c != '$'  ||  next == NEWLINE  ||  next == CRETURN)
+			vStringPut (entry, BACKSLASH);
+		vStringPut (entry, c);
+		++p;
 	}
-	return length;
 }
 
-/*  Writes "line", stripping leading and duplicate white space.
+/*  Appends "line", stripping leading and duplicate white space.
  */
-static size_t writeCompactSourceLine (FILE *const fp, const char *const line)
+static void appendCompactSourceLine (vString *const entry, const char *const line)
 {
 	boolean lineStarted = FALSE;
-	size_t  length = 0;
 	const char *p;
 	int c;
 
@@ -630,33 +1182,49 @@ static size_t writeCompactSourceLine (FILE *const fp, const char *const line)
 				c = ' ';  /* force space character for any white space */
 			}
 			if (c != CRETURN  ||  *(p + 1) != NEWLINE)
-			{
-				putc (c, fp);
-				++length;
-			}
+				vStringPut (entry, c);
 		}
 	}
-	return length;
 }
 
-static int writeXrefEntry (const tagEntryInfo *const tag)
+/*  Appends "string" followed by a space, padded with spaces to at least
+ *  "width" characters before the space, as printf () would with "%-*s ".
+ */
+static void appendPadded (
+		vString *const entry, const char *const string, const size_t width)
+{
+	size_t length = strlen (string);
+	vStringCatS (entry, string);
+	for ( ;  length < width  ;  ++length)
+		vStringPut (entry, ' ');
+	vStringPut (entry, ' ');
+}
+
+static void appendXrefEntry (vString *const entry, const tagEntryInfo *const tag)
 {
 	const char *const line =
 			readSourceLine (TagFile.vLine, tag->filePosition, NULL);
-	int length;
+	char lineNumber [3 * sizeof (unsigned long) + 2];
+
+	sprintf (lineNumber, "%4lu", tag->lineNumber);
+	appendPadded (entry, tag->name, 16);
+	if (Option.tagFileFormat != 1)
+		appendPadded (entry, tag->kindName, 10);
+	appendPadded (entry, lineNumber, 0);
+	appendPadded (entry, tag->sourceFileName, 16);
+	appendCompactSourceLine (entry, line);
+	vStringPut (entry, NEWLINE);
+}
 
-	if (Option.tagFileFormat == 1)
-		length = fprintf (TagFile.fp, "%-16s %4lu %-16s ", tag->name,
-				tag->lineNumber, tag->sourceFileName);
-	else
-		length = fprintf (TagFile.fp, "%-16s %-10s %4lu %-16s ", tag->name,
-				tag->kindName, tag->lineNumber, tag->sourceFileName);
+static int writeXrefEntry (const tagEntryInfo *const tag)
+{
+	vString *const entry = TagFile.vEntry;
 
-	length += writeCompactSourceLine (TagFile.fp, line);
-	putc (NEWLINE, TagFile.fp);
-	++length;
+	vStringClear (entry);
+	appendXrefEntry (entry, tag);
+	writeTagBytes (vStringValue (entry), vStringLength (entry));
 
-	return length;
+	return (int) vStringLength (entry);
 }
 
 /*  Truncates the text line containing the tag at the character following the
@@ -676,162 +1244,603 @@ static void truncateTagLine (
 	}
 }
 
-static int writeEtagsEntry (const tagEntryInfo *const tag)
+/*  Appends the decimal representation of "number" to a tag entry.
+ */
+static void appendNumber (vString *const entry, unsigned long number)
 {
-	int length;
+	char digits [3 * sizeof (number) + 1];
+	size_t i = sizeof (digits);
+
+	do
+	{
+		digits [--i] = (char) ('0' + number % 10);
+		number /= 10;
+	} while (number > 0);
+	vStringNCatS (entry, digits + i, sizeof (digits) - i);
+}
+
+/*  Appends the entry of a tag to the etags section of its source file.
+ */
+static int appendEtagsEntry (
+		vString *const section, const tagEntryInfo *const tag)
+{
+	const size_t start = vStringLength (section);
 
 	if (tag->isFileEntry)
-		length = fprintf (TagFile.etags.fp, "\177%s\001%lu,0\n",
-				tag->name, tag->lineNumber);
+	{
+		vStringPut (section, '\177');
+		vStringCatS (section, tag->name);
+		vStringPut (section, '\001');
+		appendNumber (section, tag->lineNumber);
+		vStringCatS (section, ",0\n");
+	}
 	else
 	{
 		long seekValue;
-		char *const line =
-				readSourceLine (TagFile.vLine, tag->filePosition, &seekValue);
+		boolean truncated;
+		char *const line = readSourceLineHead (TagFile.vLine,
+				tag->filePosition, Option.patternLengthLimit, &seekValue,
+				&truncated);
 
 		if (tag->truncateLine)
 			truncateTagLine (line, tag->name, TRUE);
-		else
+		else if (! truncated)
 			line [strlen (line) - 1] = '\0';
 
-		length = fprintf (TagFile.etags.fp, "%s\177%s\001%lu,%ld\n", line,
-				tag->name, tag->lineNumber, seekValue);
+		vStringCatS (section, line);
+		vStringPut (section, '\177');
+		vStringCatS (section, tag->name);
+		vStringPut (section, '\001');
+		appendNumber (section, tag->lineNumber);
+		vStringPut (section, ',');
+		appendNumber (section, (unsigned long) seekValue);
+		vStringPut (section, NEWLINE);
 	}
-	TagFile.etags.byteCount += length;
+	return (int) (vStringLength (section) - start);
+}
 
-	return length;
+/*  Appends an extension field to a tag entry, where "key" includes the ':'
+ *  which separates it from the value, if any.
+ */
+static void appendField (
+		vString *const entry, const char *const separator,
+		const char *const key, const char *const value)
+{
+	vStringCatS (entry, separator);
+	vStringPut (entry, '\t');
+	vStringCatS (entry, key);
+	vStringCatS (entry, value);
 }
 
-static int addExtensionFields (const tagEntryInfo *const tag)
+static void addExtensionFields (vString *const entry, const tagEntryInfo *const tag)
 {
 	const char* const kindKey = Option.extensionFields.kindKey ? "kind:" : "";
 	boolean first = TRUE;
 	const char* separator = ";\"";
 	const char* const empty = "";
-	int length = 0;
 /* "sep" returns a value only the first time it is evaluated */
 #define sep (first ? (first = FALSE, separator) : empty)
 
 	if (tag->kindName != NULL && (Option.extensionFields.kindLong  ||
 		 (Option.extensionFields.kind  && tag->kind == '\0')))
-		length += fprintf (TagFile.fp,"%s\t%s%s", sep, kindKey, tag->kindName);
+		appendField (entry, sep, kindKey, tag->kindName);
 	else if (tag->kind != '\0'  && (Option.extensionFields.kind  ||
 			(Option.extensionFields.kindLong  &&  tag->kindName == NULL)))
-		length += fprintf (TagFile.fp, "%s\t%s%c", sep, kindKey, tag->kind);
+	{
+		appendField (entry, sep, kindKey, "");
+		vStringPut (entry, tag->kind);
+	}
 
 	if (Option.extensionFields.lineNumber)
-		length += fprintf (TagFile.fp, "%s\tline:%ld", sep, tag->lineNumber);
+	{
+		appendField (entry, sep, "line:", "");
+		appendNumber (entry, tag->lineNumber);
+	}
 
 	if (Option.extensionFields.language  &&  tag->language != NULL)
-		length += fprintf (TagFile.fp, "%s\tlanguage:%s", sep, tag->language);
+		appendField (entry, sep, "language:", tag->language);
 
 	if (Option.extensionFields.scope  &&
 			tag->extensionFields.scope [0] != NULL  &&
 			tag->extensionFields.scope [1] != NULL)
-		length += fprintf (TagFile.fp, "%s\t%s:%s", sep,
-				tag->extensionFields.scope [0],
-				tag->extensionFields.scope [1]);
+	{
+		appendField (entry, sep, tag->extensionFields.scope [0], ":");
+		vStringCatS (entry, tag->extensionFields.scope [1]);
+	}
 
 	if (Option.extensionFields.typeRef  &&
 			tag->extensionFields.typeRef [0] != NULL  &&
 			tag->extensionFields.typeRef [1] != NULL)
-		length += fprintf (TagFile.fp, "%s\ttyperef:%s:%s", sep,
-				tag->extensionFields.typeRef [0],
-				tag->extensionFields.typeRef [1]);
+	{
+		appendField (entry, sep, "typeref:", tag->extensionFields.typeRef [0]);
+		vStringPut (entry, ':');
+		vStringCatS (entry, tag->extensionFields.typeRef [1]);
+	}
 
 	if (Option.extensionFields.fileScope  &&  tag->isFileScope)
-		length += fprintf (TagFile.fp, "%s\tfile:", sep);
+		appendField (entry, sep, "file:", "");
 
 	if (Option.extensionFields.inheritance  &&
 			tag->extensionFields.inheritance != NULL)
-		length += fprintf (TagFile.fp, "%s\tinherits:%s", sep,
+		appendField (entry, sep, "inherits:",
 				tag->extensionFields.inheritance);
 
 	if (Option.extensionFields.access  &&  tag->extensionFields.access != NULL)
-		length += fprintf (TagFile.fp, "%s\taccess:%s", sep,
-				tag->extensionFields.access);
+		appendField (entry, sep, "access:", tag->extensionFields.access);
 
 	if (Option.extensionFields.implementation  &&
 			tag->extensionFields.implementation != NULL)
-		length += fprintf (TagFile.fp, "%s\timplementation:%s", sep,
+		appendField (entry, sep, "implementation:",
 				tag->extensionFields.implementation);
 
 	if (Option.extensionFields.signature  &&
 			tag->extensionFields.signature != NULL)
-		length += fprintf (TagFile.fp, "%s\tsignature:%s", sep,
+		appendField (entry, sep, "signature:",
 				tag->extensionFields.signature);
-
-	return length;
 #undef sep
 }
 
-static int writePatternEntry (const tagEntryInfo *const tag)
+/*  Appends the pattern locating a tag. A line longer than
+ *  --pattern-length-limit yields a pattern matching only its start, so that
+ *  the size of the entry does not grow with the length of the line.
+ */
+static void formatPattern (vString *const entry, const tagEntryInfo *const tag)
 {
-	char *const line = readSourceLine (TagFile.vLine, tag->filePosition, NULL);
+	boolean truncated;
+	char *const line = readSourceLineHead (TagFile.vLine, tag->filePosition,
+			Option.patternLengthLimit, NULL, &truncated);
 	const int searchChar = Option.backward ? '?' : '/';
 	boolean newlineTerminated;
-	int length = 0;
 
 	if (tag->truncateLine)
 		truncateTagLine (line, tag->name, FALSE);
-	newlineTerminated = (boolean) (line [strlen (line) - 1] == '\n');
-
-	length += fprintf (TagFile.fp, "%c^", searchChar);
-	length += writeSourceLine (TagFile.fp, line);
-	length += fprintf (TagFile.fp, "%s%c", newlineTerminated ? "$":"", searchChar);
-
-	return length;
+	else if (truncated  &&  vStringLength (TagFile.vLine) > 0  &&
+			vStringLast (TagFile.vLine) == '$')
+	{
+		vStringChop (TagFile.vLine);  /* would anchor the end of the line */
+	}
+	newlineTerminated = (boolean) (line [0] != '\0'  &&
+			line [strlen (line) - 1] == '\n');
+
+	vStringPut (entry, searchChar);
+	vStringPut (entry, '^');
+	appendSourceLine (entry, line);
+	if (newlineTerminated)
+		vStringPut (entry, '$');
+	vStringPut (entry, searchChar);
 }
 
-static int writeLineNumberEntry (const tagEntryInfo *const tag)
+/*  Appends the pattern locating a tag, reusing that of the tag before it
+ *  when on the same source line, as are the enumerators or declarators
+ *  of one line, rather than reading and escaping the line again. Returns
+ *  TRUE if reused.
+ */
+static boolean addPatternEntry (vString *const entry, const tagEntryInfo *const tag)
 {
-	return fprintf (TagFile.fp, "%lu", tag->lineNumber);
+	boolean reused = FALSE;
+	if (tag->truncateLine)
+		formatPattern (entry, tag);  /* differs for each tag of the line */
+	else if (LinePatternValid  &&  memcmp (&tag->filePosition,
+			&LinePatternPosition, sizeof (fpos_t)) == 0)
+	{
+		vStringNCatS (entry, vStringValue (LinePattern),
+				vStringLength (LinePattern));
+		reused = TRUE;
+	}
+	else
+	{
+		if (LinePattern == NULL)
+			LinePattern = vStringNew ();
+		vStringClear (LinePattern);
+		formatPattern (LinePattern, tag);
+		vStringNCatS (entry, vStringValue (LinePattern),
+				vStringLength (LinePattern));
+		LinePatternPosition = tag->filePosition;
+		LinePatternValid = TRUE;
+	}
+	return reused;
 }
 
+/*  Formats the whole entry in a buffer, so that it may be written at once.
+ */
 static int writeCtagsEntry (const tagEntryInfo *const tag)
 {
-	int length = fprintf (TagFile.fp, "%s\t%s\t",
-		tag->name, tag->sourceFileName);
+	vString *const entry = TagFile.vEntry;
+	size_t shared = 0;  /* length of pattern shared with the tag before */
+
+	vStringClear (entry);
+	vStringCatS (entry, tag->name);
+	vStringPut (entry, '\t');
+	vStringCatS (entry, tag->sourceFileName);
+	vStringPut (entry, '\t');
 
 	if (tag->lineNumberEntry)
-		length += writeLineNumberEntry (tag);
-	else
-		length += writePatternEntry (tag);
+		appendNumber (entry, tag->lineNumber);
+	else if (addPatternEntry (entry, tag))
+		shared = vStringLength (LinePattern);
 
 	if (includeExtensionFlags ())
-		length += addExtensionFields (tag);
+		addExtensionFields (entry, tag);
+
+	vStringPut (entry, NEWLINE);
+	if (TagFile.held.enabled)
+		holdTagLineSharing (vStringValue (entry), vStringLength (entry),
+				shared);
+	else
+		writeTagBytes (vStringValue (entry), vStringLength (entry));
+	recordCachedTag (vStringValue (entry), vStringLength (entry));
 
-	length += fprintf (TagFile.fp, "\n");
+	return (int) vStringLength (entry);
+}
+
+/*  Returns the length of the well-formed UTF-8 sequence of more than one
+ *  byte beginning at "p", or 0 if there is none there.
+ */
+static size_t utf8SequenceLength (const unsigned char *const p)
+{
+	unsigned int low = 0x80, high = 0xbf;
+	size_t length = 0;
+	size_t i;
 
+	if (*p >= 0xc2  &&  *p <= 0xdf)
+		length = 2;
+	else if (*p >= 0xe0  &&  *p <= 0xef)
+	{
+		length = 3;
+		if (*p == 0xe0)
+			low = 0xa0;             /* overlong */
+		else if (*p == 0xed)
+			high = 0x9f;            /* surrogate */
+	}
+	else if (*p >= 0xf0  &&  *p <= 0xf4)
+	{
+		length = 4;
+		if (*p == 0xf0)
+			low = 0x90;             /* overlong */
+		else if (*p == 0xf4)
+			high = 0x8f;            /* beyond U+10FFFF */
+	}
+	for (i = 1  ;  i < length  ;  ++i)
+	{
+		if (p [i] < low  ||  p [i] > high)
+			length = 0;
+		low = 0x80;
+		high = 0xbf;
+	}
 	return length;
 }
 
+/*  Appends "string" to a tag entry as a JSON string. Runs of characters
+ *  needing no escape are copied at once, as are well-formed UTF-8
+ *  sequences. Any other byte is escaped as the Latin-1 character of the
+ *  same value, so that the output is valid JSON whatever the encoding of
+ *  the source file.
+ */
+static void appendJsonString (vString *const entry, const char *const string)
+{
+	static const char hexDigits [] = "0123456789abcdef";
+	const unsigned char *p = (const unsigned char *) string;
+
+	vStringPut (entry, '"');
+	for (;;)
+	{
+		const unsigned char *const start = p;
+		size_t length = 0;
+		int c;
+
+		while (*p >= 0x20  &&  *p < 0x80  &&  *p != '"'  &&  *p != BACKSLASH)
+			++p;
+		vStringNCatS (entry, (const char *) start, (size_t) (p - start));
+		if (*p >= 0x80)
+			length = utf8SequenceLength (p);
+		if (length > 0)
+		{
+			vStringNCatS (entry, (const char *) p, length);
+			p += length;
+			continue;
+		}
+		c = *p++;
+		if (c == '\0')
+			break;
+		vStringPut (entry, BACKSLASH);
+		switch (c)
+		{
+			case '"':       vStringPut (entry, '"');       break;
+			case BACKSLASH: vStringPut (entry, BACKSLASH); break;
+			case '\b':      vStringPut (entry, 'b');       break;
+			case '\f':      vStringPut (entry, 'f');       break;
+			case NEWLINE:   vStringPut (entry, 'n');       break;
+			case CRETURN:   vStringPut (entry, 'r');       break;
+			case '\t':      vStringPut (entry, 't');       break;
+			default:
+				vStringCatS (entry, "u00");
+				vStringPut (entry, hexDigits [c >> 4]);
+				vStringPut (entry, hexDigits [c & 0xf]);
+				break;
+		}
+	}
+	vStringPut (entry, '"');
+}
+
+/*  Appends a member of a JSON object, unless "value" is NULL. The "key"
+ *  includes the separating comma and quotes (e.g. ",\"kind\":").
+ */
+static void appendJsonField (
+		vString *const entry, const char *const key, const char *const value)
+{
+	if (value != NULL)
+	{
+		vStringCatS (entry, key);
+		appendJsonString (entry, value);
+	}
+}
+
+/*  Appends the source line of a tag, without its line end, nor anything
+ *  following the tag if its line is to be truncated.
+ */
+static void appendJsonSourceLine (
+		vString *const entry, const tagEntryInfo *const tag)
+{
+	boolean truncated;
+	char *const line = readSourceLineHead (TagFile.vLine, tag->filePosition,
+			Option.patternLengthLimit, NULL, &truncated);
+	size_t length;
+
+	if (tag->truncateLine)
+		truncateTagLine (line, tag->name, TRUE);
+	length = strlen (line);
+	while (length > 0  &&  (line [length - 1] == NEWLINE  ||
+			line [length - 1] == CRETURN))
+		line [--length] = '\0';
+	appendJsonField (entry, ",\"text\":", line);
+}
+
+/*  Appends a tag as a single line holding a JSON object with every field of
+ *  the tag, whatever --fields selects. Fields without a value are left out,
+ *  as are "fileScope" and "fileEntry" unless true, and "text", the source
+ *  line, when tags are located by line number. Lines are written in the
+ *  order found, so that they are streamed as files are parsed.
+ */
+static void appendJsonEntry (vString *const entry, const tagEntryInfo *const tag)
+{
+	char kindLetter [2];
+
+	kindLetter [0] = tag->kind;
+	kindLetter [1] = '\0';
+	appendJsonField (entry, "{\"name\":", tag->name);
+	appendJsonField (entry, ",\"file\":", tag->sourceFileName);
+	appendJsonField (entry, ",\"language\":", tag->language);
+	vStringCatS (entry, ",\"line\":");
+	appendNumber (entry, tag->lineNumber);
+	appendJsonField (entry, ",\"kind\":", tag->kindName);
+	if (tag->kind != '\0')
+		appendJsonField (entry, ",\"kindLetter\":", kindLetter);
+	if (tag->isFileScope)
+		vStringCatS (entry, ",\"fileScope\":true");
+	if (tag->isFileEntry)
+		vStringCatS (entry, ",\"fileEntry\":true");
+	if (! tag->lineNumberEntry)
+		appendJsonSourceLine (entry, tag);
+	appendJsonField (entry, ",\"access\":", tag->extensionFields.access);
+	appendJsonField (entry, ",\"implementation\":",
+			tag->extensionFields.implementation);
+	appendJsonField (entry, ",\"inheritance\":",
+			tag->extensionFields.inheritance);
+	if (tag->extensionFields.scope [1] != NULL)
+	{
+		appendJsonField (entry, ",\"scopeKind\":",
+				tag->extensionFields.scope [0]);
+		appendJsonField (entry, ",\"scope\":", tag->extensionFields.scope [1]);
+	}
+	appendJsonField (entry, ",\"signature\":",
+			tag->extensionFields.signature);
+	if (tag->extensionFields.typeRef [1] != NULL)
+	{
+		appendJsonField (entry, ",\"typeRefKind\":",
+				tag->extensionFields.typeRef [0]);
+		appendJsonField (entry, ",\"typeRef\":",
+				tag->extensionFields.typeRef [1]);
+	}
+	vStringCatS (entry, "}\n");
+}
+
+static int writeJsonEntry (const tagEntryInfo *const tag)
+{
+	vString *const entry = TagFile.vEntry;
+
+	vStringClear (entry);
+	appendJsonEntry (entry, tag);
+	writeTagBytes (vStringValue (entry), vStringLength (entry));
+
+	return (int) vStringLength (entry);
+}
+
+/*
+ *  Extra outputs
+ *
+ *  Each output named by --extra-output is written from the same tags as the
+ *  tag file, as they are made, so that each source file is parsed once
+ *  however many formats are wanted. The entries of the file being parsed
+ *  are formatted in memory until it is done, since those of a pass which is
+ *  retried must be discarded, and an etags section is headed by its size.
+ */
+
+static void openExtraOutputs (void)
+{
+	const stringList *const list = Option.extraOutputs;
+	unsigned int i;
+
+	if (list == NULL  ||  ExtraOutputs != NULL)
+		return;
+	ExtraOutputCount = stringListCount (list);
+	ExtraOutputs = xMalloc (ExtraOutputCount, extraOutput);
+	for (i = 0  ;  i < ExtraOutputCount  ;  ++i)
+	{
+		extraOutput *const output = &ExtraOutputs [i];
+		const char *const parameter = vStringValue (stringListItem (list, i));
+		const char *const name = strchr (parameter, ':') + 1;
+
+		if (strncmp (parameter, "etags:", 6) == 0)
+			output->format = OUTPUT_ETAGS;
+		else if (strncmp (parameter, "xref:", 5) == 0)
+			output->format = OUTPUT_XREF;
+		else
+			output->format = OUTPUT_JSON;
+		if (output->format == OUTPUT_JSON)
+			ExtraJsonOutput = TRUE;
+
+		if (strcmp (name, "-") == 0)
+			output->fp = stdout;
+		else if (Option.tagFileName != NULL  &&
+				 strcmp (name, Option.tagFileName) == 0)
+			error (FATAL, "extra output \"%s\" is the tag file", name);
+		else
+		{
+			output->fp = fopen (name,
+					output->format == OUTPUT_ETAGS ? "wb" : "w");
+			if (output->fp == NULL)
+				error (FATAL | PERROR, "cannot open output file \"%s\"", name);
+		}
+		output->fileTags = vStringNew ();
+	}
+}
+
+static void closeExtraOutputs (void)
+{
+	unsigned int i;
+
+	for (i = 0  ;  i < ExtraOutputCount  ;  ++i)
+	{
+		extraOutput *const output = &ExtraOutputs [i];
+		if (output->fp == stdout)
+			fflush (output->fp);
+		else
+			fclose (output->fp);
+		vStringDelete (output->fileTags);
+	}
+	if (ExtraOutputs != NULL)
+		eFree (ExtraOutputs);
+	ExtraOutputs = NULL;
+	ExtraOutputCount = 0;
+}
+
+static void writeExtraOutputs (const tagEntryInfo *const tag)
+{
+	unsigned int i;
+
+	for (i = 0  ;  i < ExtraOutputCount  ;  ++i)
+	{
+		extraOutput *const output = &ExtraOutputs [i];
+		switch (output->format)
+		{
+			case OUTPUT_ETAGS:
+				appendEtagsEntry (output->fileTags, tag);
+				break;
+			case OUTPUT_XREF:
+				if (! tag->isFileEntry)
+					appendXrefEntry (output->fileTags, tag);
+				break;
+			case OUTPUT_JSON:
+				appendJsonEntry (output->fileTags, tag);
+				break;
+		}
+	}
+}
+
+/*  Writes out the entries of the file just parsed.
+ */
+static void endExtraOutputFile (void)
+{
+	unsigned int i;
+
+	for (i = 0  ;  i < ExtraOutputCount  ;  ++i)
+	{
+		extraOutput *const output = &ExtraOutputs [i];
+		const size_t length = vStringLength (output->fileTags);
+
+		if (output->format == OUTPUT_ETAGS)
+			fprintf (output->fp, "\f\n%s,%ld\n",
+					getSourceFileTagPath (), (long) length);
+		fwrite (vStringValue (output->fileTags), 1, length, output->fp);
+		vStringClear (output->fileTags);
+	}
+}
+
+/*  Forgets the entries of the file being parsed, as when it is parsed
+ *  again. Positions in the tag file are only taken before the first tag of
+ *  a file is made, so that its entries are forgotten entirely.
+ */
+static void discardExtraOutputFile (void)
+{
+	unsigned int i;
+
+	for (i = 0  ;  i < ExtraOutputCount  ;  ++i)
+		vStringClear (ExtraOutputs [i].fileTags);
+}
+
 extern void makeTagEntry (const tagEntryInfo *const tag)
 {
 	Assert (tag->name != NULL);
 	if (tag->name [0] == '\0')
 		error (WARNING, "ignoring null tag in %s", vStringValue (File.name));
+	else if (File.outline  &&  tag->extensionFields.scope [0] != NULL)
+		;  /* only top-level definitions are tagged in an outline */
+	else if (File.outline  &&  ! tag->lineNumberEntry)
+	{
+		/*  An outline is addressed by line number, so that no source line
+		 *  need be read again to form a pattern.
+		 */
+		tagEntryInfo outline = *tag;
+		outline.lineNumberEntry = TRUE;
+		makeTagEntry (&outline);
+	}
 	else
 	{
 		int length = 0;
 
+		PushMemoryAccount (MEMORY_ENTRY);
 		DebugStatement ( debugEntry (tag); )
-		if (Option.xref)
+		if (TagSink != NULL)
+			(*TagSink) (tag);
+		else if (Option.xref)
 		{
 			if (! tag->isFileEntry)
 				length = writeXrefEntry (tag);
 		}
 		else if (Option.etags)
-			length = writeEtagsEntry (tag);
+			length = appendEtagsEntry (TagFile.etags.section, tag);
+		else if (Option.json)
+			length = writeJsonEntry (tag);
 		else
 			length = writeCtagsEntry (tag);
+		if (ExtraOutputs != NULL)
+			writeExtraOutputs (tag);
 
 		++TagFile.numTags.added;
+		TracePoint2 (tag__entry, tag->name, tag->sourceFileName);
 		rememberMaxLengths (strlen (tag->name), (size_t) length);
-		DebugStatement ( fflush (TagFile.fp); )
+		DebugStatement ( if (TagFile.fp != NULL) fflush (TagFile.fp); )
+		PopMemoryAccount ();
 	}
 }
 
+/*  Writes a tag line formatted earlier, as when read from the cache, which
+ *  must end with a newline.
+ */
+extern void writeTagLine (const char *const line, const size_t length)
+{
+	const char *const tab = memchr (line, '\t', length);
+	PushMemoryAccount (MEMORY_ENTRY);
+	if (TagFile.held.enabled)
+		holdTagLine (line, length);
+	else
+		writeTagBytes (line, length);
+	PopMemoryAccount ();
+
+	++TagFile.numTags.added;
+	rememberMaxLengths (tab == NULL ? length : (size_t) (tab - line), length);
+}
+
 extern void initTagEntry (tagEntryInfo *const e, const char *const name)
 {
 	Assert (File.source.name != NULL);
@@ -844,4 +1853,48 @@ extern void initTagEntry (tagEntryInfo *const e, const char *const name)
 	e->name            = name;
 }
 
+/*  Tells a parser whether an extension field of its tags will be used, so
+ *  that it may skip computing the field otherwise. Every field is used when
+ *  tags are written as JSON, even as an extra output, or passed to a tag
+ *  sink, and none when they are written without extension fields.
+ */
+extern boolean isTagFieldWanted (const tagField field)
+{
+	boolean result = FALSE;
+
+	if (Option.json  ||  ExtraJsonOutput  ||  TagSink != NULL)
+		result = TRUE;
+	else if (Option.etags  ||  Option.xref  ||  ! includeExtensionFlags ())
+		result = FALSE;
+	else switch (field)
+	{
+		case FIELD_ACCESS:
+			result = Option.extensionFields.access;         break;
+		case FIELD_IMPLEMENTATION:
+			result = Option.extensionFields.implementation; break;
+		case FIELD_INHERITANCE:
+			result = Option.extensionFields.inheritance;    break;
+		case FIELD_SCOPE:
+			result = Option.extensionFields.scope;          break;
+		case FIELD_SIGNATURE:
+			result = Option.extensionFields.signature;      break;
+		case FIELD_TYPEREF:
+			result = Option.extensionFields.typeRef;        break;
+	}
+	return result;
+}
+
+/*  Passes each tag made from now on to "sink", if not NULL, instead of
+ *  writing it to the tag file.
+ */
+extern void setTagSink (const tagSink sink)
+{
+	TagSink = sink;
+}
+
+extern boolean isTagSinkSet (void)
+{
+	return (boolean) (TagSink != NULL);
+}
+
 /* vi:set tabstop=4 shiftwidth=4: */
@@ -24,11 +24,43 @@
 *   MACROS
 */
 #define WHOLE_FILE  -1L
+#define TAG_LINE_PREFIX_LENGTH  8  /* leading bytes of tag line kept for sort */
 
 /*
 *   DATA DECLARATIONS
 */
 
+/*  A source file name held once for all the tag lines naming it, or a file
+ *  name and pattern held once for the tags of a source line.
+ */
+typedef struct sHeldName {
+	struct sHeldName *next;  /* in hash chain */
+	unsigned int length;
+	char text [1];           /* allocated to hold the name */
+} heldName;
+
+/*  A tag line held in memory, including its newline. The file field is held
+ *  apart, so that the name of a file is held only once, however many tags
+ *  it has; the line is written with "file" restored at offset "split". The
+ *  tags following the first of a source line also hold their pattern apart
+ *  with the file field, so that the same line may be held either way.
+ */
+typedef struct sTagLine {
+	const char *line;      /* line less its file field */
+	const heldName *file;  /* file field, perhaps with pattern, or NULL */
+	unsigned int length;   /* of "line" */
+	unsigned int split;    /* where "file" belongs, or beyond end of line */
+	char prefix [TAG_LINE_PREFIX_LENGTH];  /* copy of start of whole line */
+} tagLine;
+
+/*  A block of memory holding the text of many tag lines.
+ */
+typedef struct sTagSlab {
+	struct sTagSlab *next;
+	char *buffer;
+	size_t size, used;
+} tagSlab;
+
 /*  Maintains the state of the tag file.
  */
 typedef struct eTagFile {
@@ -38,13 +70,36 @@ typedef struct eTagFile {
 	struct sNumTags { unsigned long added, prev; } numTags;
 	struct sMax { size_t line, tag, file; } max;
 	struct sEtags {
-		char *name;
-		FILE *fp;
-		size_t byteCount;
+		vString *section;  /* entries for the source file being tagged */
 	} etags;
 	vString *vLine;
+	vString *vEntry;  /* tag entry being formatted */
+	struct sHeld {    /* tag lines held in memory until sorted */
+		boolean enabled;
+		tagSlab *slabs;        /* most recently allocated first */
+		tagLine *lines;        /* lines in the order they were held */
+		unsigned long count, size;  /* lines used and allocated */
+		heldName **names;      /* hash table of file names of lines */
+		unsigned int nameCount, nameTableSize;
+		const heldName *lastName;  /* file name of last line held */
+		size_t memory;         /* bytes allocated for slabs, lines and names */
+	} held;
+	struct sAppend {  /* existing tag file being appended to */
+		boolean sorted;  /* were its tags sorted as now required? */
+		long size;       /* its size, where the appended tags begin */
+	} append;
 } tagFile;
 
+/*  A position in the tag file, including any tags held in memory.
+ */
+typedef struct sTagFilePosition {
+	fpos_t position;
+	unsigned long heldCount;
+	unsigned long added;
+	unsigned long flushes;  /* of tags collected for the file being parsed */
+	size_t etagsLength;     /* of the etags section of the file being parsed */
+} tagFilePosition;
+
 typedef struct sTagFields {
 	unsigned int count;        /* number of additional extension flags */
 	const char *const *label;  /* list of labels for extension flags */
@@ -79,6 +134,22 @@ typedef struct sTagEntryInfo {
 	} extensionFields;  /* list of extension fields*/
 } tagEntryInfo;
 
+/*  Extension fields which a parser need not compute unless they are wanted
+ *  (see isTagFieldWanted ()).
+ */
+typedef enum eTagField {
+	FIELD_ACCESS,
+	FIELD_IMPLEMENTATION,
+	FIELD_INHERITANCE,
+	FIELD_SCOPE,
+	FIELD_SIGNATURE,
+	FIELD_TYPEREF
+} tagField;
+
+/*  Receives each tag made in place of the tag file, as for libctags.
+ */
+typedef void (*tagSink) (const tagEntryInfo *const tag);
+
 /*
 *   GLOBAL VARIABLES
 */
@@ -93,10 +164,25 @@ extern void copyBytes (FILE* const fromFp, FILE* const toFp, const long size);
 extern void copyFile (const char *const from, const char *const to, const long size);
 extern void openTagFile (void);
 extern void closeTagFile (const boolean resize);
+extern void holdTagLine (const char *const line, const size_t length);
+extern void appendHeldLine (vString *const buffer, const tagLine *const line);
+extern boolean writeHeldLine (const tagLine *const line, FILE *const fp);
+extern void discardHeldTags (void);
+extern void stopHoldingTags (void);
+extern boolean isTagFileSortedAtClose (void);
+extern void beginFileTags (void);
+extern void flushFileTags (void);
+extern void endFileTags (void);
+extern void getTagFilePosition (tagFilePosition *const pos);
+extern void setTagFilePosition (const tagFilePosition *const pos);
 extern void beginEtagsFile (void);
 extern void endEtagsFile (const char *const name);
 extern void makeTagEntry (const tagEntryInfo *const tag);
+extern void writeTagLine (const char *const line, const size_t length);
 extern void initTagEntry (tagEntryInfo *const e, const char *const name);
+extern boolean isTagFieldWanted (const tagField field);
+extern void setTagSink (const tagSink sink);
+extern boolean isTagSinkSet (void);
 
 #endif  /* _ENTRY_H */
 
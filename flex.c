@@ -29,6 +29,7 @@
 #include "debug.h"
 #include "entry.h"
 #include "keyword.h"
+#include "lexer.h"
 #include "parse.h"
 #include "read.h"
 #include "routines.h"
@@ -136,6 +137,7 @@ typedef struct sTokenInfo {
  */
 
 static langType Lang_js;
+static lexClasses FlexClasses;
 
 static jmp_buf Exception;
 
@@ -199,9 +201,7 @@ static boolean parseActionScript (tokenInfo *const token);
 
 static boolean isIdentChar (const int c)
 {
-	return (boolean)
-		(isalpha (c) || isdigit (c) || c == '$' || 
-		 c == '@' || c == '_' || c == '#');
+	return (boolean) lexIsIdentChar (&FlexClasses, c);
 }
 
 static void buildFlexKeywordHash (void)
@@ -380,23 +380,7 @@ static void makeFunctionTag (tokenInfo *const token)
 
 static void parseString (vString *const string, const int delimiter)
 {
-	boolean end = FALSE;
-	while (! end)
-	{
-		int c = fileGetc ();
-		if (c == EOF)
-			end = TRUE;
-		else if (c == '\\')
-		{
-			c = fileGetc(); /* This maybe a ' or ". */
-			vStringPut(string, c);
-		}
-		else if (c == delimiter)
-			end = TRUE;
-		else
-			vStringPut (string, c);
-	}
-	vStringTerminate (string);
+	lexReadString (string, delimiter, '\\');
 }
 
 /*	Read a C identifier beginning with "firstChar" and places it into
@@ -404,14 +388,9 @@ static void parseString (vString *const string, const int delimiter)
  */
 static void parseIdentifier (vString *const string, const int firstChar)
 {
-	int c = firstChar;
-	Assert (isIdentChar (c));
-	do
-	{
-		vStringPut (string, c);
-		c = fileGetc ();
-	} while (isIdentChar (c));
-	vStringTerminate (string);
+	int c;
+	Assert (isIdentChar (firstChar));
+	c = lexReadIdentifier (&FlexClasses, string, firstChar);
 	if (!isspace (c))
 		fileUngetc (c);		/* unget non-identifier character */
 }
@@ -425,13 +404,9 @@ static void readToken (tokenInfo *const token)
 	vStringClear (token->string);
 
 getNextChar:
-	do
-	{
-		c = fileGetc ();
-		token->lineNumber   = getSourceLineNumber ();
-		token->filePosition = getInputFilePosition ();
-	}
-	while (c == '\t'  ||  c == ' ' ||  c == '\n');
+	c = lexSkipSpace (&FlexClasses);
+	token->lineNumber   = getSourceLineNumber ();
+	token->filePosition = getInputFilePosition ();
 
 	switch (c)
 	{
@@ -2202,6 +2177,7 @@ static void initialize (const langType language)
 {
 	Assert (sizeof (FlexKinds) / sizeof (FlexKinds [0]) == FLEXTAG_COUNT);
 	Lang_js = language;
+	lexInitClasses (&FlexClasses, "$@_#", " \t\n");
 	buildFlexKeywordHash ();
 }
 
@@ -2210,8 +2186,8 @@ static void findFlexTags (void)
 	tokenInfo *const token = newToken ();
 	exception_t exception;
 	
-	ClassNames = stringListNew ();
-	FunctionNames = stringListNew ();
+	ClassNames = stringListNewIndexed ();
+	FunctionNames = stringListNewIndexed ();
 	
 	exception = (exception_t) (setjmp (Exception));
 	while (exception == ExceptionNone)
@@ -59,6 +59,16 @@ typedef enum eFortranLineType {
 	LTYPE_SHORT
 } lineType;
 
+/*  What the start of a file shows of its source form.
+ */
+typedef enum eSourceForm {
+	FORM_UNKNOWN, FORM_FIXED, FORM_FREE
+} sourceForm;
+
+/*  Number of lines at the start of a file examined to choose its source form.
+ */
+enum { SourceFormSampleLines = 200 };
+
 /*  Used to specify type of keyword.
  */
 typedef enum eKeywordId {
@@ -2138,6 +2148,125 @@ static void parseProgramUnit (tokenInfo *const token)
 	} while (TRUE);
 }
 
+/*
+*   Source form detection
+*/
+
+/*  Determines what a line shows of the source form of its file. A line
+ *  shows free source form only when reading it as fixed source form is
+ *  certain to fail, just as in getLineType () and getFixedFormChar (), and
+ *  shows fixed source form when it is a comment which could not begin a
+ *  statement in free source form.
+ */
+static sourceForm lineSourceForm (
+		const unsigned char *const line, const size_t length)
+{
+	sourceForm form = FORM_UNKNOWN;
+	boolean code = FALSE;
+	boolean label = FALSE;
+	boolean done = FALSE;
+	size_t i;
+
+	if (length > 0  &&  strchr ("*Cc!#$Dd", line [0]) != NULL)
+	{
+		if (line [0] == '*'  ||  ((line [0] == 'C'  ||  line [0] == 'c')  &&
+				(length == 1  ||  line [1] == ' ')))
+			form = FORM_FIXED;
+		done = TRUE;
+	}
+	for (i = 0  ;  ! done  ;  ++i)
+	{
+		const int c = (i < length) ? line [i] : '\n';
+		if (c == '\t')
+		{
+			code = TRUE;
+			done = TRUE;
+		}
+		else if (i == 5)
+		{
+			code = (boolean) (c == ' '  ||  c == '0'  ||  ! label);
+			done = TRUE;
+		}
+		else if (c == ' ')
+			;
+		else if (c == '\n')
+			done = TRUE;
+		else if (isdigit (c))
+			label = TRUE;
+		else
+			done = TRUE;
+		if (done  &&  ! code  &&  c != '\n')
+			form = FORM_FREE;
+	}
+	if (code)
+	{
+		/*  The first character of the statement may escape the check for a
+		 *  trailing ampersand, and one after a '!' may be in a comment.
+		 */
+		size_t end = length;
+#ifdef STRICT_FIXED_FORM
+		if (end > 72)
+			end = 72;
+#endif
+		while (i < end  &&  isBlank (line [i]))
+			++i;
+		for (++i  ;  i < end  &&  line [i] != '!'  ;  ++i)
+		{
+			if (line [i] == '&'  &&  i + 1 == length)
+				form = FORM_FREE;
+		}
+	}
+	return form;
+}
+
+/*  Determines whether the input file should first be parsed as free source
+ *  form, from a sample of its first lines and then from its extension, so
+ *  that it is seldom parsed twice. Reading the file as fixed source form
+ *  remains the fallback when it cannot be sampled.
+ */
+static boolean isFreeSourceForm (void)
+{
+	size_t length;
+	const unsigned char *p = fileMappedRemainder (&length);
+	boolean result = FALSE;
+
+	if (p != NULL)
+	{
+		const unsigned char *const end = p + length;
+		boolean fixed = FALSE;
+		unsigned int lines = 0;
+
+		while (p < end  &&  *p != '\0'  &&  lines < SourceFormSampleLines  &&
+			   ! result)
+		{
+			const unsigned char *q = p;
+			sourceForm form;
+			while (q < end  &&  *q != '\n'  &&  *q != '\r'  &&  *q != '\0')
+				++q;
+			form = lineSourceForm (p, (size_t) (q - p));
+			if (form == FORM_FREE)
+				result = TRUE;
+			else if (form == FORM_FIXED)
+				fixed = TRUE;
+			if (q < end  &&  *q == '\r')
+				++q;
+			if (q < end  &&  *q == '\n')
+				++q;
+			p = q;
+			++lines;
+		}
+		if (! result  &&  ! fixed)
+		{
+			const char *const extension = fileExtension (getInputFileName ());
+			result = (boolean) (strcasecmp (extension, "f90") == 0  ||
+								strcasecmp (extension, "f95") == 0);
+		}
+		if (result)
+			verbose ("%s: parsing as free source form\n", getInputFileName ());
+	}
+	return result;
+}
+
 static boolean findFortranTags (const unsigned int passCount)
 {
 	tokenInfo *token;
@@ -2147,8 +2276,10 @@ static boolean findFortranTags (const unsigned int passCount)
 	Assert (passCount < 3);
 	Parent = newToken ();
 	token = newToken ();
-	FreeSourceForm = (boolean) (passCount > 1);
+	FreeSourceForm = (boolean) (passCount > 1  ||  isFreeSourceForm ());
 	Column = 0;
+	Ungetc = '\0';
+	ParsingString = FALSE;
 	exception = (exception_t) setjmp (Exception);
 	if (exception == ExceptionEOF)
 		retry = FALSE;
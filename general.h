@@ -53,6 +53,30 @@
 # define HAVE_REGEX 1
 #endif
 
+/* Define parallel jobs if supported */
+#if defined (HAVE_FORK) && defined (HAVE_WAITPID) && defined (HAVE_PIPE) && \
+	defined (HAVE_SYS_WAIT_H)
+# define JOBS_SUPPORTED 1
+#endif
+
+/* Define read-ahead of upcoming input files if supported */
+#if defined (HAVE_POSIX_FADVISE) && defined (HAVE_FCNTL_H) && \
+	defined (HAVE_UNISTD_H)
+# define READ_AHEAD_SUPPORTED 1
+#endif
+
+/* Define watching of source directories for changes if supported */
+#if defined (HAVE_INOTIFY_INIT) && defined (HAVE_SYS_INOTIFY_H) && \
+	defined (HAVE_UNISTD_H)
+# define DAEMON_SUPPORTED 1
+#endif
+
+/* Define trimming of the tag cache to a size if supported */
+#if defined (HAVE_OPENDIR) && defined (HAVE_DIRENT_H) && \
+	defined (HAVE_UTIME) && defined (HAVE_UTIME_H)
+# define CACHE_TRIMMING_SUPPORTED 1
+#endif
+
 /*  This is a helpful internal feature of later versions (> 2.7) of GCC
  *  to prevent warnings about unused variables.
  */
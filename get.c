@@ -434,29 +434,51 @@ static Comment isComment (void)
 	return comment;
 }
 
+/*  Reads up to and including the next of the characters "stops", returning
+ *  it, or EOF. The characters before it are passed over a line at a time
+ *  rather than read one by one.
+ */
+static int skipToAnyOf (const char *const stops)
+{
+	int c;
+	do
+	{
+		size_t length;
+		const unsigned char *const span = fileLineSpan (&length);
+		c = '\0';
+		if (span == NULL)
+			c = fileGetc ();
+		else
+		{
+			const size_t skip = strcspn ((const char *) span, stops);
+			fileSkipBytes (skip);
+			if (skip < length)
+				c = fileGetc ();
+		}
+	} while (c != EOF  &&  (c == '\0'  ||  strchr (stops, c) == NULL));
+	return c;
+}
+
 /*  Skips over a C style comment. According to ANSI specification a comment
  *  is treated as white space, so we perform this substitution.
  */
 int skipOverCComment (void)
 {
-	int c = fileGetc ();
+	int c = skipToAnyOf ("*");
 
 	while (c != EOF)
 	{
-		if (c != '*')
-			c = fileGetc ();
-		else
-		{
-			const int next = fileGetc ();
+		const int next = fileGetc ();
 
-			if (next != '/')
-				c = next;
-			else
-			{
-				c = SPACE;  /* replace comment with space */
-				break;
-			}
+		if (next == '/')
+		{
+			c = SPACE;  /* replace comment with space */
+			break;
 		}
+		else if (next == EOF)
+			c = EOF;
+		else if (next != '*')
+			c = skipToAnyOf ("*");
 	}
 	return c;
 }
@@ -467,7 +489,7 @@ static int skipOverCplusComment (void)
 {
 	int c;
 
-	while ((c = fileGetc ()) != EOF)
+	while ((c = skipToAnyOf ("\\\n")) != EOF)
 	{
 		if (c == BACKSLASH)
 			fileGetc ();  /* throw away next character, too */
@@ -482,11 +504,12 @@ static int skipOverCplusComment (void)
  */
 static int skipToEndOfString (boolean ignoreBackslash)
 {
+	const char *const stops = ignoreBackslash ? "\"" : "\\\"";
 	int c;
 
-	while ((c = fileGetc ()) != EOF)
+	while ((c = skipToAnyOf (stops)) != EOF)
 	{
-		if (c == BACKSLASH && ! ignoreBackslash)
+		if (c == BACKSLASH)
 			fileGetc ();  /* throw away next character, too */
 		else if (c == DOUBLE_QUOTE)
 			break;
@@ -526,6 +549,34 @@ static int skipToEndOfChar (void)
 	return CHAR_SYMBOL;  /* symbolic representation of character */
 }
 
+/*  Determines whether a line within an ignored branch may be passed over
+ *  whole: it neither begins with a directive, nor holds anything which might
+ *  begin a comment or string, or join it to the next line.
+ */
+static boolean isPlainLine (const char *const line)
+{
+	const char *p = line;
+	while (isspacetab (*p))
+		++p;
+	return (boolean) (*p != '#'  &&  strpbrk (p, "/\"'\\?") == NULL);
+}
+
+/*  While ignoring a branch at the start of a line, passes over the plain
+ *  lines which follow, examining each line only once rather than reading
+ *  it character by character.
+ */
+static void skipIgnoredLines (void)
+{
+	const unsigned char *line;
+	size_t length;
+
+	while ((line = fileLineSpan (&length)) != NULL  &&
+			isPlainLine ((const char *) line))
+	{
+		fileSkipBytes (length);
+	}
+}
+
 /*  This function returns the next character, stripping out comments,
  *  C pre-processor directives, and the contents of single and double
  *  quoted strings. In short, strip anything which places a burden upon
@@ -546,6 +597,11 @@ extern int cppGetc (void)
 	}
 	else do
 	{
+		if (ignore  &&  Cpp.directive.accept  &&
+			Cpp.directive.state == DRCTV_NONE)
+		{
+			skipIgnoredLines ();
+		}
 		c = fileGetc ();
 process:
 		switch (c)
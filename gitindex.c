@@ -0,0 +1,367 @@
+/*
+*   $Id$
+*
+*   Copyright (c) 2026, Exuberant Ctags contributors
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License.
+*
+*   This module contains functions to read the names of the files tracked by
+*   git from the index of the working tree holding the current directory (see
+*   --git-files). Files ignored by git, such as build trees, are then never
+*   visited, and the whole list costs the reading of one file, without a
+*   process being started to run git.
+*
+*   The index is a header, followed by an entry for each file, sorted by
+*   name, then by extensions. Each entry holds the status of the file when
+*   git last looked at it, its object name, flags and its name. Versions 2
+*   and 3 pad each entry to a multiple of eight bytes; version 4 instead
+*   omits the part of each name shared with the name before it.
+*/
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#include <string.h>
+
+#include "debug.h"
+#include "gitindex.h"
+#include "options.h"
+#include "read.h"
+#include "routines.h"
+#include "vstring.h"
+
+/*
+*   MACROS
+*/
+#define INDEX_SIGNATURE         "DIRC"
+#define INDEX_HEADER_SIZE       12
+#define ENTRY_STATUS_SIZE       40    /* times, device, inode, mode, ... */
+#define ENTRY_MODE_OFFSET       24
+
+#define ENTRY_EXTENDED          0x4000  /* extended flags follow flags */
+#define ENTRY_STAGE             0x3000  /* stage of merge, if any */
+#define ENTRY_SKIP_WORKTREE     0x4000  /* extended: file not checked out */
+
+#define MODE_TYPE               0170000
+#define MODE_REGULAR            0100000
+#define MODE_SYMLINK            0120000
+
+/*
+*   DATA DECLARATIONS
+*/
+typedef struct sGitIndex {
+	const unsigned char *start;
+	const unsigned char *end;   /* start of trailing checksum */
+	unsigned int version;
+	unsigned long count;        /* of entries */
+	size_t hashSize;            /* of object names */
+} gitIndex;
+
+/*
+*   FUNCTION DEFINITIONS
+*/
+
+static unsigned long readBigEndian (
+		const unsigned char *const p, const unsigned int bytes)
+{
+	unsigned long result = 0;
+	unsigned int i;
+	for (i = 0  ;  i < bytes  ;  ++i)
+		result = (result << 8) | p [i];
+	return result;
+}
+
+/*  Reads the variable length number which begins each name in a version 4
+ *  index, advancing "p" past it.
+ */
+static unsigned long readVarint (const unsigned char **const p)
+{
+	const unsigned char *q = *p;
+	unsigned char c = *q++;
+	unsigned long result = c & 0x7f;
+	while ((c & 0x80) != 0)
+	{
+		c = *q++;
+		result = ((result + 1) << 7) | (c & 0x7f);
+	}
+	*p = q;
+	return result;
+}
+
+/*  Reads the directory named by a ".git" file, as in a linked working tree
+ *  or a submodule, into "gitDir", which names the file.
+ */
+static boolean readGitFile (vString *const gitDir, const vString *const top)
+{
+	FILE *const fp = fopen (vStringValue (gitDir), "r");
+	boolean result = FALSE;
+	if (fp != NULL)
+	{
+		vString *const line = vStringNew ();
+		if (readLine (line, fp) != NULL  &&
+			strncmp (vStringValue (line), "gitdir: ", 8) == 0)
+		{
+			vString *const path = vStringNewInit (vStringValue (line) + 8);
+			vStringStripTrailing (path);
+			if (isAbsolutePath (vStringValue (path)))
+				vStringCopy (gitDir, path);
+			else
+			{
+				vStringCopy (gitDir, top);
+				vStringCat (gitDir, path);
+			}
+			vStringDelete (path);
+			result = TRUE;
+		}
+		vStringDelete (line);
+		fclose (fp);
+	}
+	return result;
+}
+
+/*  Finds the git directory of the working tree holding the current
+ *  directory, and the path of the current directory within the tree, which
+ *  is empty or ends with a separator.
+ */
+static boolean findGitDirectory (vString *const gitDir, vString *const prefix)
+{
+	vString *const top = vStringNewInit (CurrentDirectory);
+	boolean found = FALSE;
+
+	while (! found  &&  vStringLength (top) > 0)
+	{
+		fileStatus *const status = (vStringCopy (gitDir, top),
+				vStringCatS (gitDir, ".git"), eStat (vStringValue (gitDir)));
+		if (! status->exists)
+			;
+		else if (status->isDirectory)
+			found = TRUE;
+		else
+			found = readGitFile (gitDir, top);
+		if (! found)
+		{
+			/*  Go up to the parent directory, keeping its separator.
+			 */
+			vStringChop (top);
+			while (vStringLength (top) > 0  &&
+				   vStringLast (top) != OUTPUT_PATH_SEPARATOR  &&
+				   vStringLast (top) != PATH_SEPARATOR)
+			{
+				vStringChop (top);
+			}
+		}
+	}
+	if (found)
+		vStringCopyS (prefix, CurrentDirectory + vStringLength (top));
+	vStringDelete (top);
+	return found;
+}
+
+/*  Determines the size of object names, which is larger in a repository
+ *  using SHA-256 rather than SHA-1.
+ */
+static size_t objectHashSize (const vString *const gitDir)
+{
+	vString *const name = combinePathAndFile (vStringValue (gitDir), "config");
+	FILE *const fp = fopen (vStringValue (name), "r");
+	size_t result = 20;
+	if (fp != NULL)
+	{
+		vString *const line = vStringNew ();
+		vString *const lower = vStringNew ();
+		while (readLine (line, fp) != NULL)
+		{
+			const char *key;
+			vStringCopyToLower (lower, line);
+			key = strstr (vStringValue (lower), "objectformat");
+			if (key != NULL  &&  strstr (key, "sha256") != NULL)
+				result = 32;
+		}
+		vStringDelete (lower);
+		vStringDelete (line);
+		fclose (fp);
+	}
+	vStringDelete (name);
+	return result;
+}
+
+/*  Reads the whole index into memory, returning NULL if it is absent.
+ */
+static unsigned char *readIndex (const vString *const gitDir, size_t *const size)
+{
+	vString *const name = combinePathAndFile (vStringValue (gitDir), "index");
+	FILE *const fp = fopen (vStringValue (name), "rb");
+	unsigned char *result = NULL;
+	if (fp != NULL)
+	{
+		const fileStatus *const status = eStat (vStringValue (name));
+		*size = (size_t) status->size;
+		result = xMalloc (*size + 1, unsigned char);
+		if (fread (result, 1, *size, fp) != *size)
+			error (FATAL | PERROR, "cannot read git index \"%s\"",
+					vStringValue (name));
+		fclose (fp);
+	}
+	vStringDelete (name);
+	return result;
+}
+
+/*  Checks the header and the extensions of the index, since an index split
+ *  in two, or holding whole directories outside a sparse checkout, does not
+ *  name every file in its entries.
+ */
+static void checkIndex (gitIndex *const index, const size_t size)
+{
+	const unsigned char *p;
+	unsigned long i;
+
+	if (size < INDEX_HEADER_SIZE + index->hashSize  ||
+		memcmp (index->start, INDEX_SIGNATURE, 4) != 0)
+	{
+		error (FATAL, "git index is not valid");
+	}
+	index->version = (unsigned int) readBigEndian (index->start + 4, 4);
+	index->count = readBigEndian (index->start + 8, 4);
+	index->end = index->start + size - index->hashSize;
+	if (index->version < 2  ||  index->version > 4)
+		error (FATAL, "git index version %u is not supported", index->version);
+
+	/*  Extensions follow the last entry, so that the entries must be
+	 *  skipped to find them.
+	 */
+	p = index->start + INDEX_HEADER_SIZE;
+	for (i = 0  ;  i < index->count  &&  p < index->end  ;  ++i)
+	{
+		const unsigned char *const flags =
+				p + ENTRY_STATUS_SIZE + index->hashSize;
+		const unsigned char *name = flags + 2;
+		if (readBigEndian (flags, 2) & ENTRY_EXTENDED)
+			name += 2;
+		if (index->version == 4)
+		{
+			readVarint (&name);
+			p = name + strlen ((const char *) name) + 1;
+		}
+		else
+		{
+			const size_t length = name - p + strlen ((const char *) name);
+			p += (length + 8) & ~ (size_t) 7;
+		}
+	}
+	while (p + 8 <= index->end)
+	{
+		if (memcmp (p, "link", 4) == 0)
+			error (FATAL, "split git index is not supported");
+		if (memcmp (p, "sdir", 4) == 0)
+			error (FATAL, "sparse git index is not supported");
+		p += 8 + readBigEndian (p + 4, 4);
+	}
+}
+
+/*  Calls "action" for each file named in the index which lies within the
+ *  current directory, and is checked out as a regular file or symbolic
+ *  link, naming it relative to the current directory. A file in conflict,
+ *  named once for each stage of the merge, is named once.
+ */
+static boolean actOnEntries (
+		const gitIndex *const index, const vString *const prefix,
+		const gitFileAction action)
+{
+	vString *const name = vStringNew ();
+	vString *const previous = vStringNew ();
+	const unsigned char *p = index->start + INDEX_HEADER_SIZE;
+	boolean resize = FALSE;
+	unsigned long i;
+
+	for (i = 0  ;  i < index->count  &&  p < index->end  ;  ++i)
+	{
+		const unsigned long mode = readBigEndian (p + ENTRY_MODE_OFFSET, 4);
+		const unsigned char *const flagBytes =
+				p + ENTRY_STATUS_SIZE + index->hashSize;
+		const unsigned long flags = readBigEndian (flagBytes, 2);
+		unsigned long extended = 0;
+		const unsigned char *text = flagBytes + 2;
+
+		if (flags & ENTRY_EXTENDED)
+		{
+			extended = readBigEndian (text, 2);
+			text += 2;
+		}
+		if (index->version == 4)
+		{
+			const unsigned long strip = readVarint (&text);
+			if (strip > vStringLength (name))
+				error (FATAL, "git index is not valid");
+			vStringChar (name, vStringLength (name) - strip) = '\0';
+			vStringSetLength (name);
+			vStringCatS (name, (const char *) text);
+			p = text + strlen ((const char *) text) + 1;
+		}
+		else
+		{
+			const size_t length = strlen ((const char *) text);
+			vStringCopyS (name, (const char *) text);
+			p += ((size_t) (text - p) + length + 8) & ~ (size_t) 7;
+		}
+
+		if ((mode & MODE_TYPE) != MODE_REGULAR  &&
+			(mode & MODE_TYPE) != MODE_SYMLINK)
+			;  /* submodule or sparse directory */
+		else if (extended & ENTRY_SKIP_WORKTREE)
+			;  /* not checked out */
+		else if ((flags & ENTRY_STAGE) != 0  &&
+				 strcmp (vStringValue (name), vStringValue (previous)) == 0)
+			;  /* another stage of a file in conflict */
+		else if (strncmp (vStringValue (name), vStringValue (prefix),
+				vStringLength (prefix)) == 0)
+		{
+			resize |= (*action) (vStringValue (name) + vStringLength (prefix),
+					(boolean) ((mode & MODE_TYPE) == MODE_SYMLINK));
+		}
+		vStringCopy (previous, name);
+	}
+	vStringDelete (previous);
+	vStringDelete (name);
+	return resize;
+}
+
+/*  Calls "action" for each file tracked by git within the current
+ *  directory. Returns TRUE if any call does.
+ */
+extern boolean forEachGitFile (const gitFileAction action)
+{
+	vString *const gitDir = vStringNew ();
+	vString *const prefix = vStringNew ();
+	boolean resize = FALSE;
+
+	if (! findGitDirectory (gitDir, prefix))
+		error (FATAL, "not within a git working tree");
+	else
+	{
+		gitIndex index;
+		size_t size = 0;
+		unsigned char *const contents = readIndex (gitDir, &size);
+
+		if (contents == NULL)
+			verbose ("no git index in \"%s\"\n", vStringValue (gitDir));
+		else
+		{
+			contents [size] = '\0';
+			index.start = contents;
+			index.hashSize = objectHashSize (gitDir);
+			checkIndex (&index, size);
+			verbose ("reading %lu entries of git index in \"%s\"\n",
+					index.count, vStringValue (gitDir));
+			resize = actOnEntries (&index, prefix, action);
+			eFree (contents);
+		}
+	}
+	vStringDelete (prefix);
+	vStringDelete (gitDir);
+	return resize;
+}
+
+/* vi:set tabstop=4 shiftwidth=4: */
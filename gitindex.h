@@ -0,0 +1,36 @@
+/*
+*   $Id$
+*
+*   Copyright (c) 2026, Exuberant Ctags contributors
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License.
+*
+*   External interface to gitindex.c
+*/
+#ifndef _GITINDEX_H
+#define _GITINDEX_H
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+/*
+*   DATA DECLARATIONS
+*/
+
+/*  Called for each file tracked by git, named relative to the current
+ *  directory, with whether it is a symbolic link. Returns TRUE if the tag
+ *  file needs to be resized.
+ */
+typedef boolean (*gitFileAction) (const char *const fileName, const boolean isLink);
+
+/*
+*   FUNCTION PROTOTYPES
+*/
+extern boolean forEachGitFile (const gitFileAction action);
+
+#endif  /* _GITINDEX_H */
+
+/* vi:set tabstop=4 shiftwidth=4: */
@@ -0,0 +1,400 @@
+/*
+*   $Id$
+*
+*   Copyright (c) 2026, Exuberant Ctags contributors
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License.
+*
+*   This module contains functions to match a file name against many file
+*   name patterns at once, as for --exclude and the pattern maps of
+*   --langmap. Each pattern is added with a value, and a match yields the
+*   value of the first pattern added which matches the name, just as though
+*   the patterns were tried in turn.
+*
+*   Patterns are sorted as they are added. Literal names are kept in a hash
+*   table, patterns of the form "text*" in a trie of their prefixes, and
+*   patterns of the form "*text" in a trie of their reversed suffixes, so
+*   that each of these kinds is matched in a single pass over the name,
+*   however many patterns there are. Only the remaining patterns are tried
+*   one at a time through fnmatch(). Where fnmatch() is not available, every
+*   pattern is a literal name, as in stringListFileMatched().
+*/
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#include <string.h>
+#ifdef HAVE_FNMATCH_H
+# include <fnmatch.h>
+#endif
+
+#include "debug.h"
+#include "globset.h"
+#include "routines.h"
+
+/*
+*   MACROS
+*/
+#if ! defined (HAVE_FNMATCH) && defined (CASE_INSENSITIVE_FILENAMES)
+# define FOLD_LITERALS 1
+#endif
+
+/*
+*   DATA DECLARATIONS
+*/
+enum eGlobSetLimits {
+	InitialLiteralTableSize = 64  /* must be a power of 2 */
+};
+
+/*  A pattern is ranked by the order in which it was added, so that the first
+ *  pattern added which matches wins, whichever kind of pattern it is.
+ */
+typedef struct sGlobLiteral {
+	char *name;
+	unsigned int rank;
+	int value;
+	int next;  /* index of next literal in hash chain, or -1 */
+} globLiteral;
+
+typedef struct sGlobNode {
+	struct sGlobNode *child;
+	struct sGlobNode *sibling;
+	unsigned char c;
+	boolean terminal;  /* a pattern ends here */
+	unsigned int rank;
+	int value;
+} globNode;
+
+typedef struct sGlobPattern {
+	char *pattern;
+	unsigned int rank;
+	int value;
+} globPattern;
+
+struct sGlobSet {
+	unsigned int count;  /* of patterns added, for ranking */
+
+	globLiteral *literals;
+	unsigned int literalCount;
+	unsigned int literalMax;
+	int *literalTable;
+	unsigned int literalTableSize;
+
+	globNode *prefixes;
+	globNode *suffixes;
+
+	globPattern *patterns;
+	unsigned int patternCount;
+	unsigned int patternMax;
+};
+
+typedef struct sGlobMatch {
+	boolean found;
+	unsigned int rank;
+	int value;
+} globMatch;
+
+/*
+*   FUNCTION DEFINITIONS
+*/
+
+static void noteMatch (
+		globMatch *const match, const unsigned int rank, const int value)
+{
+	if (! match->found  ||  rank < match->rank)
+	{
+		match->found = TRUE;
+		match->rank = rank;
+		match->value = value;
+	}
+}
+
+/*
+*   Literal names
+*/
+
+static unsigned int literalIndex (
+		const globSet *const set, const char *const name)
+{
+	unsigned long hash = INITIAL_HASH;
+	const char *p;
+	for (p = name  ;  *p != '\0'  ;  ++p)
+	{
+#ifdef FOLD_LITERALS
+		const unsigned char c = (unsigned char) tolower ((int) *p);
+#else
+		const unsigned char c = (unsigned char) *p;
+#endif
+		hash = hashBytes (hash, &c, 1);
+	}
+	return (unsigned int) (hash & (set->literalTableSize - 1));
+}
+
+static boolean literalsEqual (const char *const a, const char *const b)
+{
+#ifdef FOLD_LITERALS
+	return (boolean) (strcasecmp (a, b) == 0);
+#else
+	return (boolean) (strcmp (a, b) == 0);
+#endif
+}
+
+static int findLiteral (const globSet *const set, const char *const name)
+{
+	int i = -1;
+	if (set->literalTable != NULL)
+	{
+		i = set->literalTable [literalIndex (set, name)];
+		while (i != -1  &&  ! literalsEqual (set->literals [i].name, name))
+			i = set->literals [i].next;
+	}
+	return i;
+}
+
+static void rehashLiterals (globSet *const set)
+{
+	unsigned int i;
+	set->literalTableSize = (set->literalTableSize == 0) ?
+			InitialLiteralTableSize : set->literalTableSize * 2;
+	if (set->literalTable != NULL)
+		eFree (set->literalTable);
+	set->literalTable = xMalloc (set->literalTableSize, int);
+	for (i = 0  ;  i < set->literalTableSize  ;  ++i)
+		set->literalTable [i] = -1;
+	for (i = 0  ;  i < set->literalCount  ;  ++i)
+	{
+		const unsigned int k = literalIndex (set, set->literals [i].name);
+		set->literals [i].next = set->literalTable [k];
+		set->literalTable [k] = (int) i;
+	}
+}
+
+static void addLiteral (
+		globSet *const set, const char *const name,
+		const unsigned int rank, const int value)
+{
+	/*  A later copy of a name can never match first, so is dropped. */
+	if (findLiteral (set, name) == -1)
+	{
+		globLiteral *literal;
+		unsigned int k;
+		if (set->literalCount == set->literalMax)
+		{
+			set->literalMax = (set->literalMax == 0) ? 16 : set->literalMax * 2;
+			set->literals = xRealloc (set->literals, set->literalMax, globLiteral);
+		}
+		literal = &set->literals [set->literalCount++];
+		literal->name = eStrdup (name);
+		literal->rank = rank;
+		literal->value = value;
+		if (2 * set->literalCount > set->literalTableSize)
+			rehashLiterals (set);
+		else
+		{
+			k = literalIndex (set, name);
+			literal->next = set->literalTable [k];
+			set->literalTable [k] = (int) (set->literalCount - 1);
+		}
+	}
+}
+
+/*
+*   Tries of prefixes and suffixes
+*/
+
+static globNode *childNode (globNode *const node, const unsigned char c)
+{
+	globNode *child = node->child;
+	while (child != NULL  &&  child->c != c)
+		child = child->sibling;
+	if (child == NULL)
+	{
+		child = xCalloc (1, globNode);
+		child->c = c;
+		child->sibling = node->child;
+		node->child = child;
+	}
+	return child;
+}
+
+static const globNode *findChild (const globNode *const node, const unsigned char c)
+{
+	const globNode *child = node->child;
+	while (child != NULL  &&  child->c != c)
+		child = child->sibling;
+	return child;
+}
+
+/*  Adds the "length" characters of "text" to the trie rooted at "root",
+ *  reading them backwards when "reverse" is set.
+ */
+static void addToTrie (
+		globNode **const root, const char *const text, const size_t length,
+		const boolean reverse, const unsigned int rank, const int value)
+{
+	globNode *node;
+	size_t i;
+	if (*root == NULL)
+		*root = xCalloc (1, globNode);
+	node = *root;
+	for (i = 0  ;  i < length  ;  ++i)
+	{
+		const size_t at = reverse ? length - 1 - i : i;
+		node = childNode (node, (unsigned char) text [at]);
+	}
+	if (! node->terminal)
+	{
+		node->terminal = TRUE;
+		node->rank = rank;
+		node->value = value;
+	}
+}
+
+static void matchTrie (
+		const globNode *const root, const char *const name,
+		const boolean reverse, globMatch *const match)
+{
+	const size_t length = strlen (name);
+	const globNode *node = root;
+	size_t i;
+	for (i = 0  ;  node != NULL  ;  ++i)
+	{
+		if (node->terminal)
+			noteMatch (match, node->rank, node->value);
+		if (i == length)
+			node = NULL;
+		else
+		{
+			const size_t at = reverse ? length - 1 - i : i;
+			node = findChild (node, (unsigned char) name [at]);
+		}
+	}
+}
+
+static void deleteTrie (globNode *const node)
+{
+	if (node != NULL)
+	{
+		deleteTrie (node->child);
+		deleteTrie (node->sibling);
+		eFree (node);
+	}
+}
+
+/*
+*   General patterns
+*/
+
+static void addPattern (
+		globSet *const set, const char *const pattern,
+		const unsigned int rank, const int value)
+{
+	globPattern *p;
+	if (set->patternCount == set->patternMax)
+	{
+		set->patternMax = (set->patternMax == 0) ? 8 : set->patternMax * 2;
+		set->patterns = xRealloc (set->patterns, set->patternMax, globPattern);
+	}
+	p = &set->patterns [set->patternCount++];
+	p->pattern = eStrdup (pattern);
+	p->rank = rank;
+	p->value = value;
+}
+
+/*
+*   Glob set interface
+*/
+
+extern globSet *globSetNew (void)
+{
+	globSet *const set = xCalloc (1, globSet);
+	return set;
+}
+
+extern void globSetDelete (globSet *const set)
+{
+	if (set != NULL)
+	{
+		unsigned int i;
+		for (i = 0  ;  i < set->literalCount  ;  ++i)
+			eFree (set->literals [i].name);
+		if (set->literals != NULL)
+			eFree (set->literals);
+		if (set->literalTable != NULL)
+			eFree (set->literalTable);
+		deleteTrie (set->prefixes);
+		deleteTrie (set->suffixes);
+		for (i = 0  ;  i < set->patternCount  ;  ++i)
+			eFree (set->patterns [i].pattern);
+		if (set->patterns != NULL)
+			eFree (set->patterns);
+		eFree (set);
+	}
+}
+
+extern void globSetAdd (
+		globSet *const set, const char *const pattern, const int value)
+{
+	const unsigned int rank = set->count++;
+#ifdef HAVE_FNMATCH
+	const size_t length = strlen (pattern);
+	const char *const special = strpbrk (pattern, "*?[\\");
+	Assert (pattern != NULL);
+	if (special == NULL)
+		addLiteral (set, pattern, rank, value);
+	else if (special == pattern + length - 1  &&  *special == '*')
+		addToTrie (&set->prefixes, pattern, length - 1, FALSE, rank, value);
+	else if (special == pattern  &&  *special == '*'  &&
+			strpbrk (pattern + 1, "*?[\\") == NULL)
+		addToTrie (&set->suffixes, pattern + 1, length - 1, TRUE, rank, value);
+	else
+		addPattern (set, pattern, rank, value);
+#else
+	Assert (pattern != NULL);
+	addLiteral (set, pattern, rank, value);
+#endif
+}
+
+extern void globSetAddList (
+		globSet *const set, const stringList *const list, const int value)
+{
+	unsigned int i;
+	for (i = 0  ;  list != NULL  &&  i < stringListCount (list)  ;  ++i)
+		globSetAdd (set, vStringValue (stringListItem (list, i)), value);
+}
+
+/*  Returns the value of the first pattern added to "set" which matches
+ *  "fileName", or -1 if none does.
+ */
+extern int globSetMatch (const globSet *const set, const char *const fileName)
+{
+	globMatch match;
+	int i;
+
+	match.found = FALSE;
+	match.rank = 0;
+	match.value = -1;
+	i = findLiteral (set, fileName);
+	if (i != -1)
+		noteMatch (&match, set->literals [i].rank, set->literals [i].value);
+	matchTrie (set->prefixes, fileName, FALSE, &match);
+	matchTrie (set->suffixes, fileName, TRUE, &match);
+#ifdef HAVE_FNMATCH
+	{
+		unsigned int j;
+		for (j = 0  ;  j < set->patternCount  &&  ! (match.found  &&
+				set->patterns [j].rank > match.rank)  ;  ++j)
+		{
+			const globPattern *const p = &set->patterns [j];
+			if (fnmatch (p->pattern, fileName, 0) == 0)
+				noteMatch (&match, p->rank, p->value);
+		}
+	}
+#endif
+	return match.value;
+}
+
+/* vi:set tabstop=4 shiftwidth=4: */
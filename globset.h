@@ -0,0 +1,37 @@
+/*
+*   $Id$
+*
+*   Copyright (c) 2026, Exuberant Ctags contributors
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License.
+*
+*   External interface to globset.c
+*/
+#ifndef _GLOBSET_H
+#define _GLOBSET_H
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#include "strlist.h"
+
+/*
+*   DATA DECLARATIONS
+*/
+typedef struct sGlobSet globSet;
+
+/*
+*   FUNCTION PROTOTYPES
+*/
+extern globSet *globSetNew (void);
+extern void globSetDelete (globSet *const set);
+extern void globSetAdd (globSet *const set, const char *const pattern, const int value);
+extern void globSetAddList (globSet *const set, const stringList *const list, const int value);
+extern int globSetMatch (const globSet *const set, const char *const fileName);
+
+#endif  /* _GLOBSET_H */
+
+/* vi:set tabstop=4 shiftwidth=4: */
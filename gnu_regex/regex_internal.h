@@ -45,11 +45,30 @@
 #if defined HAVE_STDINT_H || defined _LIBC
 # include <stdint.h>
 #endif /* HAVE_STDINT_H || _LIBC */
+/* The state cache of a DFA grows as it is matched, so where one compiled
+   pattern may be matched by several threads at once (REGEX_THREADS), each
+   match holds the lock of the DFA.  Everything else a match changes is
+   private to it, so a pattern need not be compiled again for each thread.  */
 #if defined _LIBC
 # include <bits/libc-lock.h>
+#elif defined REGEX_THREADS && defined _WIN32
+# include <windows.h>
+# define __libc_lock_define(CLASS,NAME) CLASS CRITICAL_SECTION NAME;
+# define __libc_lock_init(NAME) InitializeCriticalSection (&(NAME))
+# define __libc_lock_fini(NAME) DeleteCriticalSection (&(NAME))
+# define __libc_lock_lock(NAME) EnterCriticalSection (&(NAME))
+# define __libc_lock_unlock(NAME) LeaveCriticalSection (&(NAME))
+#elif defined REGEX_THREADS
+# include <pthread.h>
+# define __libc_lock_define(CLASS,NAME) CLASS pthread_mutex_t NAME;
+# define __libc_lock_init(NAME) pthread_mutex_init (&(NAME), NULL)
+# define __libc_lock_fini(NAME) pthread_mutex_destroy (&(NAME))
+# define __libc_lock_lock(NAME) pthread_mutex_lock (&(NAME))
+# define __libc_lock_unlock(NAME) pthread_mutex_unlock (&(NAME))
 #else
 # define __libc_lock_define(CLASS,NAME)
 # define __libc_lock_init(NAME) do { } while (0)
+# define __libc_lock_fini(NAME) do { } while (0)
 # define __libc_lock_lock(NAME) do { } while (0)
 # define __libc_lock_unlock(NAME) do { } while (0)
 #endif
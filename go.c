@@ -7,6 +7,7 @@
 #include "debug.h"
 #include "entry.h"
 #include "keyword.h"
+#include "lexer.h"
 #include "read.h"
 #include "main.h"
 #include "routines.h"
@@ -82,6 +83,7 @@ typedef struct sTokenInfo {
 
 static int Lang_go;
 static jmp_buf Exception;
+static lexClasses GoClasses;
 static vString *scope;
 
 typedef enum {
@@ -118,20 +120,15 @@ static keywordDesc GoKeywordTable[] = {
 *   FUNCTION DEFINITIONS
 */
 
-// XXX UTF-8
-static boolean isIdentChar (const int c)
-{
-    return (boolean)
-        (isalpha (c) || isdigit (c) || c == '$' ||
-         c == '@' || c == '_' || c == '#' || c > 128);
-}
-
 static void initialize (const langType language)
 {
     size_t i;
     const size_t count =
         sizeof (GoKeywordTable) / sizeof (GoKeywordTable[0]);
     Lang_go = language;
+    lexInitClasses (&GoClasses, "$@_#", "");
+    // XXX UTF-8
+    lexAddClass (&GoClasses, 129, 255, LEX_IDENT);
     for (i = 0; i < count; ++i)
     {
         const keywordDesc *const p = &GoKeywordTable[i];
@@ -165,35 +162,13 @@ static void deleteToken (tokenInfo * const token)
 
 static void parseString (vString *const string, const int delimiter)
 {
-    boolean end = FALSE;
-    while (!end)
-    {
-        int c = fileGetc ();
-        if (c == EOF)
-            end = TRUE;
-        else if (c == '\\' && delimiter != '`')
-        {
-            c = fileGetc ();    /* This maybe a ' or ". */
-            vStringPut (string, c);
-        }
-        else if (c == delimiter)
-            end = TRUE;
-        else
-            vStringPut (string, c);
-    }
-    vStringTerminate (string);
+    /* raw strings have no escapes */
+    lexReadString (string, delimiter, delimiter == '`' ? '\0' : '\\');
 }
 
 static void parseIdentifier (vString *const string, const int firstChar)
 {
-    int c = firstChar;
-    //Assert (isIdentChar (c));
-    do
-    {
-        vStringPut (string, c);
-        c = fileGetc ();
-    } while (isIdentChar (c));
-    vStringTerminate (string);
+    const int c = lexReadIdentifier (&GoClasses, string, firstChar);
     fileUngetc (c);     /* always unget, LF might add a semicolon */
 }
 
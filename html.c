@@ -14,25 +14,251 @@
 *   INCLUDE FILES
 */
 #include "general.h"  /* must always come first */
+
+#include <string.h>
+
 #include "parse.h"
+#include "read.h"
+#include "routines.h"
+#include "vstring.h"
+
+/*
+*   DATA DEFINITIONS
+*/
+typedef enum {
+	K_ANCHOR, K_FUNCTION
+} htmlKind;
+
+static kindOption HtmlKinds [] = {
+	{ TRUE, 'a', "anchor",   "named anchors" },
+	{ TRUE, 'f', "function", "JavaScript functions" }
+};
+
+/*  Marks for each character of an anchor element whether its attributes can
+ *  reach it from the start of the element, and whether the element can be
+ *  closed from it by further attributes.
+ */
+static boolean *Reached;
+static boolean *Closable;
+static size_t MarksSize;
 
 /*
 *   FUNCTION DEFINITIONS
 */
 
-static void installHtmlRegex (const langType language)
+static boolean isBlank (const int c)
+{
+	return (boolean) (c == ' '  ||  c == '\t');
+}
+
+static boolean isLetter (const int c)
+{
+	return (boolean) ((c >= 'A'  &&  c <= 'Z')  ||  (c >= 'a'  &&  c <= 'z'));
+}
+
+static boolean isIdentChar (const int c)
+{
+	return (boolean) (isLetter (c)  ||  (c >= '0'  &&  c <= '9')  ||  c == '_');
+}
+
+/*  Matches the start of an attribute, blanks, a name and "=", at "i",
+ *  returning the position of its value or 0 if there is none.
+ */
+static size_t attributeValue (const unsigned char *const s, size_t i)
+{
+	size_t result = 0;
+	if (isBlank ((int) s [i]))
+	{
+		while (isBlank ((int) s [i]))
+			++i;
+		if (isLetter ((int) s [i]))
+		{
+			while (isLetter ((int) s [i]))
+				++i;
+			if (s [i] == '=')
+				result = i + 1;
+		}
+	}
+	return result;
+}
+
+/*  Returns the end of the longest value, optionally quoted, beginning at
+ *  "value" in an element closed at "close". A value may end anywhere from
+ *  "value" to this end, not counting a closing quote.
+ */
+static size_t valueEnd (
+		const unsigned char *const s, const size_t value, const size_t close)
+{
+	size_t i = (s [value] == '"') ? value + 1 : value;
+	while (i < close  &&  s [i] != '"')
+		++i;
+	return i;
+}
+
+static void growMarks (const size_t size)
+{
+	if (size > MarksSize)
+	{
+		MarksSize = size;
+		Reached = xRealloc (Reached, MarksSize, boolean);
+		Closable = xRealloc (Closable, MarksSize, boolean);
+	}
+}
+
+/*  Marks the positions of the element from "start" to "close" which its
+ *  leading attributes may reach, and those from which it may be closed by
+ *  trailing attributes and blanks.
+ */
+static void markAttributes (
+		const unsigned char *const s, const size_t start, const size_t close)
+{
+	size_t i, j;
+	for (i = start  ;  i <= close  ;  ++i)
+		Reached [i] = FALSE;
+	Reached [start] = TRUE;
+	for (i = start  ;  i < close  ;  ++i)
+	{
+		const size_t value = Reached [i] ? attributeValue (s, i) : 0;
+		if (value > 0)
+		{
+			const size_t end = valueEnd (s, value, close);
+			for (j = value  ;  j <= end  ;  ++j)
+				Reached [j] = TRUE;
+			if (end < close)
+				Reached [end + 1] = TRUE;
+		}
+	}
+	Closable [close] = TRUE;
+	for (i = close  ;  i-- > start  ;  )
+	{
+		const size_t value = attributeValue (s, i);
+		Closable [i] = (boolean) (isBlank ((int) s [i])  &&  Closable [i + 1]);
+		if (value > 0  &&  ! Closable [i])
+		{
+			const size_t end = valueEnd (s, value, close);
+			for (j = value  ;  j <= end  &&  ! Closable [i]  ;  ++j)
+				Closable [i] = Closable [j];
+			if (end < close  &&  Closable [end + 1])
+				Closable [i] = TRUE;
+		}
+	}
+}
+
+/*  Finds the name of the anchor element from "start", following "<a", to
+ *  "close", at its ">". Where the attributes can be read in more than one
+ *  way, the last "name=" attribute which can be read as such is chosen, with
+ *  the longest value it can have.
+ */
+static boolean findAnchorName (
+		const unsigned char *const s, const size_t start, const size_t close,
+		vString *const name)
+{
+	boolean result = FALSE;
+	size_t i;
+	growMarks (close + 2);
+	markAttributes (s, start, close);
+	for (i = close  ;  ! result  &&  i-- > start + 1  ;  )
+	{
+		boolean reached = FALSE;
+		size_t j;
+		if (isBlank ((int) s [i - 1])  &&  i + 5 <= close  &&
+			strncasecmp ((const char*) s + i, "name=", (size_t) 5) == 0)
+		{
+			for (j = i - 1  ;  ! reached  &&  j >= start  &&
+					isBlank ((int) s [j])  ;  --j)
+				reached = Reached [j];
+		}
+		if (reached)
+		{
+			const size_t value = (s [i + 5] == '"') ? i + 6 : i + 5;
+			size_t end = value;
+			while (end < close  &&  s [end] != '"')
+				++end;
+			for (j = end  ;  ! result  &&  j > value  ;  --j)
+			{
+				if (Closable [j]  ||  (s [j] == '"'  &&  Closable [j + 1]))
+				{
+					vStringNCopyS (name, (const char*) s + value, j - value);
+					result = TRUE;
+				}
+			}
+		}
+	}
+	return result;
+}
+
+/*  Makes a tag for the first element of the line of the form
+ *  <a ... name="anchor" ...>
+ */
+static void findAnchor (const unsigned char *const line, vString *const name)
+{
+	const unsigned char *cp = line;
+	const unsigned char *close = NULL;
+	boolean found = FALSE;
+	while (! found  &&
+		   (cp = (const unsigned char*) strchr ((const char*) cp, '<')) != NULL)
+	{
+		if (close < cp)
+			close = (const unsigned char*) strchr ((const char*) cp, '>');
+		if (close == NULL)
+			break;
+		if (cp [1] == 'a'  ||  cp [1] == 'A')
+			found = findAnchorName (line, cp + 2 - line, close - line, name);
+		++cp;
+	}
+	if (found)
+	{
+		vStringStripLeading (name);
+		vStringStripTrailing (name);
+		makeSimpleTag (name, HtmlKinds, K_ANCHOR);
+	}
+}
+
+/*  Makes a tag for a line of the form
+ *  function name (
+ */
+static void findFunction (const unsigned char *cp, vString *const name)
+{
+	while (isBlank ((int) *cp))
+		++cp;
+	if (strncmp ((const char*) cp, "function", (size_t) 8) == 0)
+	{
+		const unsigned char *start;
+		cp += 8;
+		while (isBlank ((int) *cp))
+			++cp;
+		start = cp;
+		while (isIdentChar ((int) *cp))
+			++cp;
+		if (cp > start)
+		{
+			vStringNCopyS (name, (const char*) start, cp - start);
+			while (isBlank ((int) *cp))
+				++cp;
+			if (*cp == '(')
+				makeSimpleTag (name, HtmlKinds, K_FUNCTION);
+		}
+	}
+}
+
+static void findHtmlTags (void)
 {
-#define POSSIBLE_ATTRIBUTES "([ \t]+[a-z]+=\"?[^>\"]*\"?)*"
-	addTagRegex (language,
-		"<a"
-		POSSIBLE_ATTRIBUTES
-		"[ \t]+name=\"?([^>\"]+)\"?"
-		POSSIBLE_ATTRIBUTES
-		"[ \t]*>",
-		"\\2", "a,anchor,named anchors", "i");
+	vString *const name = vStringNew ();
+	const unsigned char *line;
 
-	addTagRegex (language, "^[ \t]*function[ \t]*([A-Za-z0-9_]+)[ \t]*\\(",
-		"\\1", "f,function,JavaScript functions", NULL);
+	while ((line = fileReadLine ()) != NULL)
+	{
+		findAnchor (line, name);
+		findFunction (line, name);
+	}
+	vStringDelete (name);
+	if (Reached != NULL)
+	{
+		eFree (Reached);
+		eFree (Closable);
+		Reached = Closable = NULL;
+		MarksSize = 0;
+	}
 }
 
 /* Create parser definition stucture */
@@ -40,9 +266,10 @@ extern parserDefinition* HtmlParser (void)
 {
 	static const char *const extensions [] = { "htm", "html", NULL };
 	parserDefinition *const def = parserNew ("HTML");
+	def->kinds      = HtmlKinds;
+	def->kindCount  = KIND_COUNT (HtmlKinds);
 	def->extensions = extensions;
-	def->initialize = installHtmlRegex;
-	def->regex      = TRUE;
+	def->parser     = findHtmlTags;
 	return def;
 }
 
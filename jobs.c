@@ -0,0 +1,977 @@
+/*
+*   $Id$
+*
+*   Copyright (c) 2026, Exuberant Ctags contributors
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License.
+*
+*   This module contains functions to generate tags for a batch of source
+*   files using several worker processes (see --jobs). Because the state of
+*   the source file, tag file and parsers is global, each worker is a forked
+*   copy of the process which writes its tags to a private temporary file.
+*   The tags are then copied into the real tag file in the order in which
+*   the source files were queued, so that the output is identical to that
+*   produced when tagging the files one at a time. When the tag file is to
+*   be sorted anyway, each worker instead sorts its own tags as it finishes,
+*   while the others are still tagging, and the sorted files are merged
+*   when the tag file is sorted, rather than copied. Files whose parser keeps
+*   state from one file to the next are all tagged, in order, by the first
+*   worker. The other files are handed out largest first, so that a few huge
+*   files queued late do not leave one worker busy long after the rest have
+*   finished. A single large file tagged only by regular expressions, which
+*   match each line independently, is instead divided into chunks of whole
+*   lines which are tagged concurrently and then joined in line order.
+*   When tagging one file at a time, the next few files named are held back
+*   briefly so that the operating system can read them in ahead of time.
+*/
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#if defined (HAVE_STDLIB_H)
+# include <stdlib.h>  /* to declare qsort () and exit () */
+#endif
+#include <string.h>
+#include <stdio.h>
+
+#ifdef JOBS_SUPPORTED
+# include <errno.h>
+# include <signal.h>
+# ifdef HAVE_SYS_TYPES_H
+#  include <sys/types.h>
+# endif
+# include <sys/wait.h>
+# ifdef HAVE_UNISTD_H
+#  include <unistd.h>
+# endif
+# ifdef HAVE_GETTIMEOFDAY
+#  define JOB_TIMING_AVAILABLE
+# endif
+#endif
+
+#include "debug.h"
+#include "entry.h"
+#include "jobs.h"
+#include "main.h"
+#include "options.h"
+#include "parse.h"
+#include "read.h"
+#include "routines.h"
+#include "sort.h"
+#include "strlist.h"
+
+/*
+*   DATA DECLARATIONS
+*/
+enum eJobLimits {
+	/*  Smallest chunk of a file worth tagging by a separate job.
+	 */
+	MinimumChunkSize = 1024 * 1024,
+
+	/*  Number of files named in advance of the one being tagged, when
+	 *  tagging one file at a time, so that they may be read ahead.
+	 */
+	ReadAheadDistance = 8
+};
+
+/*  Information used to schedule a queued file.
+ */
+typedef struct sQueuedFile {
+	boolean serial;      /* must be parsed in order with its language? */
+	unsigned long size;  /* size of file, used to predict its cost, or 0 */
+} queuedFile;
+
+#ifdef JOBS_SUPPORTED
+
+/*  Describes the tags written by a worker for a single source file.
+ */
+typedef struct sJobResult {
+	unsigned int fileIndex;  /* index of source file in queue */
+	long offset;             /* location of tags in worker tag file */
+	long length;             /* length of tags in worker tag file */
+	unsigned long tags;      /* number of tags written */
+} jobResult;
+
+/*  Statistics collected by a worker, reported back to the parent.
+ */
+typedef struct sJobSummary {
+	unsigned long files, lines, bytes;  /* additions to totals */
+	size_t maxLine, maxTag;             /* longest line and tag seen */
+	double busy;                        /* seconds spent tagging files */
+	double elapsed;                     /* seconds from start to finish */
+	unsigned long allocations;          /* blocks of memory allocated */
+} jobSummary;
+
+/*  Cumulative statistics for each worker, for --totals.
+ */
+typedef struct sJobTotals {
+	unsigned long files;
+	unsigned long allocations;
+	double busy;
+	double elapsed;
+} jobTotals;
+
+typedef struct sWorker {
+	pid_t pid;
+	char *tagName;     /* temporary file receiving tags */
+	char *resultName;  /* temporary file receiving summary and results */
+} worker;
+
+/*  Describes a chunk of the input file, and the tags written for it.
+ */
+typedef struct sChunk {
+	size_t start, end;         /* range of bytes in input file */
+	unsigned long lineNumber;  /* line number of first line */
+	unsigned long tags;        /* number of tags written */
+	size_t maxLine, maxTag;    /* longest line and tag seen */
+} chunk;
+
+/*  Where to find the tags for each queued file once the workers finish.
+ */
+typedef struct sJobSource {
+	unsigned int worker;
+	long offset;
+	long length;
+} jobSource;
+
+#endif
+
+/*
+*   DATA DEFINITIONS
+*/
+static stringList *QueuedFiles = NULL;
+static queuedFile *QueuedInfo = NULL;  /* parallel to QueuedFiles */
+static unsigned int QueuedInfoSize = 0;
+static unsigned int SerialFileCount = 0;
+static vString *ReadAhead [ReadAheadDistance];  /* ring of files to tag */
+static unsigned int ReadAheadFirst = 0;
+static unsigned int ReadAheadCount = 0;
+#ifdef JOBS_SUPPORTED
+static boolean InWorker = FALSE;
+static boolean SortedRuns = FALSE;  /* do workers sort their tags? */
+static jobTotals *WorkerTotals = NULL;
+static unsigned int WorkerTotalsCount = 0;
+#endif
+
+/*
+*   FUNCTION DEFINITIONS
+*/
+
+extern boolean jobsEnabled (void)
+{
+	return (boolean) (Option.jobs > 1  &&  ! Option.filter  &&
+			Option.extraOutputs == NULL);
+}
+
+/*  Determines whether a file belongs to the share of files selected by
+ *  --shard. The share is chosen by a hash of the file name (FNV-1a), which
+ *  is the same on every host, so the shards together cover each file once.
+ */
+extern boolean isFileInShard (const char *const fileName)
+{
+	boolean result = TRUE;
+	if (Option.shard.count > 1)
+	{
+		unsigned long hash = 2166136261UL;
+		const unsigned char *p;
+
+		for (p = (const unsigned char *) fileName  ;  *p != '\0'  ;  ++p)
+		{
+			hash ^= *p;
+			hash = (hash * 16777619UL) & 0xffffffffUL;
+		}
+		result = (boolean) (hash % Option.shard.count ==
+				Option.shard.index - 1);
+	}
+	return result;
+}
+
+extern boolean readAheadEnabled (void)
+{
+#ifdef READ_AHEAD_SUPPORTED
+	return (boolean) (! Option.filter);
+#else
+	return FALSE;
+#endif
+}
+
+static boolean tagOldestReadAheadFile (void)
+{
+	vString *const name = ReadAhead [ReadAheadFirst];
+	boolean resize;
+
+	ReadAheadFirst = (ReadAheadFirst + 1) % ReadAheadDistance;
+	--ReadAheadCount;
+	resize = parseFile (vStringValue (name));
+	vStringDelete (name);
+	return resize;
+}
+
+/*  Tags files one at a time, but only once several later files have been
+ *  named, so that each may be read ahead from the moment it is named.
+ */
+extern boolean tagFileReadingAhead (const char *const fileName)
+{
+	boolean resize = FALSE;
+	if (ReadAheadCount == ReadAheadDistance)
+		resize = tagOldestReadAheadFile ();
+	fileReadAhead (fileName);
+	ReadAhead [(ReadAheadFirst + ReadAheadCount) % ReadAheadDistance] =
+			vStringNewInit (fileName);
+	++ReadAheadCount;
+	return resize;
+}
+
+/*  Queues a file to be tagged by the next free worker. Its size, by which
+ *  the files are scheduled, is taken from its status if this was looked up
+ *  as the file was found, but is not otherwise sought, since a call to
+ *  stat () for each file found by readdir () would undo the savings made
+ *  by not calling it (see createTagsForDirectoryEntry ()).
+ */
+extern void queueFileForTagging (
+		const char *const fileName, const fileStatus *const status)
+{
+	queuedFile *info;
+
+	if (QueuedFiles == NULL)
+		QueuedFiles = stringListNew ();
+	stringListAdd (QueuedFiles, vStringNewInit (fileName));
+	if (stringListCount (QueuedFiles) > QueuedInfoSize)
+	{
+		QueuedInfoSize = QueuedInfoSize == 0 ? 64 : QueuedInfoSize * 2;
+		QueuedInfo = xRealloc (QueuedInfo, QueuedInfoSize, queuedFile);
+	}
+	info = &QueuedInfo [stringListCount (QueuedFiles) - 1];
+	info->size = (status == NULL) ? 0 : status->size;
+	info->serial = isSerialParsingRequired (fileName);
+	if (info->serial)
+		++SerialFileCount;
+}
+
+extern void freeJobsResources (void)
+{
+	if (QueuedFiles != NULL)
+		stringListDelete (QueuedFiles);
+	QueuedFiles = NULL;
+	if (QueuedInfo != NULL)
+		eFree (QueuedInfo);
+	QueuedInfo = NULL;
+	QueuedInfoSize = 0;
+	SerialFileCount = 0;
+	while (ReadAheadCount > 0)
+	{
+		vStringDelete (ReadAhead [ReadAheadFirst]);
+		ReadAheadFirst = (ReadAheadFirst + 1) % ReadAheadDistance;
+		--ReadAheadCount;
+	}
+#ifdef JOBS_SUPPORTED
+	if (WorkerTotals != NULL)
+		eFree (WorkerTotals);
+	WorkerTotals = NULL;
+	WorkerTotalsCount = 0;
+#endif
+}
+
+#ifdef JOBS_SUPPORTED
+
+/*
+*   Worker process
+*/
+
+static void writeJobRecord (
+		FILE *const fp, const void *const record, const size_t size)
+{
+	if (fwrite (record, size, 1, fp) != 1)
+		error (FATAL | PERROR, "cannot write job results");
+}
+
+static void tagQueuedFile (
+		FILE *const results, const unsigned int index,
+		jobSummary *const summary)
+{
+	const unsigned long tags = TagFile.numTags.added;
+	const double start = elapsedTime ();
+	jobResult result;
+
+	result.fileIndex = index;
+	result.offset = ftell (TagFile.fp);
+	parseFile (vStringValue (stringListItem (QueuedFiles, index)));
+	result.length = ftell (TagFile.fp) - result.offset;
+	result.tags = TagFile.numTags.added - tags;
+	writeJobRecord (results, &result, sizeof (result));
+	summary->busy += elapsedTime () - start;
+}
+
+/*  Generates tags into a private tag file for each file whose queue index
+ *  is read from "taskFd", until the parent closes the other end. The first
+ *  worker begins by tagging the files which must be parsed in order.
+ */
+static void runWorker (
+		const int taskFd, const worker *const self, const boolean first)
+{
+	FILE *const results = fopen (self->resultName, "wb");
+	const double start = elapsedTime ();
+	const unsigned long allocations = allocationCount ();
+	unsigned long files, lines, bytes;
+	jobSummary summary;
+	unsigned int index;
+
+	InWorker = TRUE;
+	if (results == NULL)
+		error (FATAL | PERROR, "cannot open \"%s\"", self->resultName);
+	TagFile.fp = fopen (self->tagName, "wb");
+	if (TagFile.fp == NULL)
+		error (FATAL | PERROR, "cannot open \"%s\"", self->tagName);
+	stopHoldingTags ();
+	fileReleaseHead ();  /* its stream is shared with the parent */
+	TagFile.numTags.added = 0;
+	getTotals (&files, &lines, &bytes);
+	if (Option.profileRegex)
+		clearRegexProfile ();
+	if (Option.printTotals)
+		clearLanguageTotals ();
+#ifdef MEMORY_ACCOUNTING
+	clearMemoryTotals ();
+#endif
+
+	memset (&summary, 0, sizeof (summary));
+	writeJobRecord (results, &summary, sizeof (summary));
+	if (first)
+	{
+		for (index = 0  ;  index < stringListCount (QueuedFiles)  ;  ++index)
+		{
+			if (QueuedInfo [index].serial)
+				tagQueuedFile (results, index, &summary);
+		}
+	}
+	while (read (taskFd, &index, sizeof (index)) == sizeof (index))
+		tagQueuedFile (results, index, &summary);
+	getTotals (&summary.files, &summary.lines, &summary.bytes);
+	summary.files -= files;
+	summary.lines -= lines;
+	summary.bytes -= bytes;
+	summary.maxLine = TagFile.max.line;
+	summary.maxTag = TagFile.max.tag;
+	summary.elapsed = elapsedTime () - start;
+	summary.allocations = allocationCount () - allocations;
+	if (Option.profileRegex  ||  Option.printTotals)
+	{
+		jobResult last;
+		memset (&last, 0, sizeof (last));
+		last.fileIndex = (unsigned int) -1;  /* statistics follow */
+		writeJobRecord (results, &last, sizeof (last));
+		if (Option.profileRegex)
+			writeRegexProfile (results);
+		if (Option.printTotals)
+			writeLanguageTotals (results);
+#ifdef MEMORY_ACCOUNTING
+		if (Option.printTotals)
+			writeMemoryTotals (results);
+#endif
+	}
+	rewind (results);
+	writeJobRecord (results, &summary, sizeof (summary));
+
+	if (fclose (TagFile.fp) != 0  ||  fclose (results) != 0)
+		error (FATAL | PERROR, "cannot write job results");
+	if (SortedRuns)
+		sortJobTags (self->tagName);
+	exit (0);
+}
+
+/*
+*   Parent process
+*/
+
+static void createWorkerFiles (worker *const workers, const unsigned int count)
+{
+	unsigned int i;
+	for (i = 0  ;  i < count  ;  ++i)
+	{
+		workers [i].pid = (pid_t) -1;
+		workers [i].tagName = NULL;
+		workers [i].resultName = NULL;
+		fclose (tempFile ("wb", &workers [i].tagName));
+		fclose (tempFile ("wb", &workers [i].resultName));
+	}
+}
+
+static void removeWorkerFiles (worker *const workers, const unsigned int count)
+{
+	unsigned int i;
+	for (i = 0  ;  i < count  ;  ++i)
+	{
+		if (workers [i].tagName != NULL)
+		{
+			remove (workers [i].tagName);
+			eFree (workers [i].tagName);
+		}
+		remove (workers [i].resultName);
+		eFree (workers [i].resultName);
+	}
+}
+
+static int compareQueuedFiles (const void *const one, const void *const two)
+{
+	const unsigned int index1 = *(const unsigned int *) one;
+	const unsigned int index2 = *(const unsigned int *) two;
+	const unsigned long size1 = QueuedInfo [index1].size;
+	const unsigned long size2 = QueuedInfo [index2].size;
+	int result;
+
+	if (size1 != size2)
+		result = (size1 > size2) ? -1 : 1;
+	else
+		result = (index1 < index2) ? -1 : (index1 > index2);
+	return result;
+}
+
+/*  Returns the queue indexes of the files which may be tagged concurrently,
+ *  ordered from largest file to smallest, followed by those of unknown size
+ *  in the order queued.
+ */
+static unsigned int *scheduleQueuedFiles (
+		const unsigned int fileCount, unsigned int *const pCount)
+{
+	unsigned int *const order = xMalloc (fileCount, unsigned int);
+	unsigned int count = 0;
+	unsigned int i;
+
+	for (i = 0  ;  i < fileCount  ;  ++i)
+	{
+		if (! QueuedInfo [i].serial)
+			order [count++] = i;
+	}
+	qsort (order, count, sizeof (*order), compareQueuedFiles);
+	*pCount = count;
+	return order;
+}
+
+/*  Hands out the queue indexes of the files to tag through a pipe, from
+ *  which each idle worker takes the next one.
+ */
+static boolean startWorkers (
+		worker *const workers, const unsigned int count,
+		const unsigned int fileCount)
+{
+	boolean ok = TRUE;
+	unsigned int orderCount;
+	unsigned int *const order = scheduleQueuedFiles (fileCount, &orderCount);
+	unsigned int i;
+	int fds [2];
+
+	if (pipe (fds) == -1)
+		error (FATAL | PERROR, "cannot create pipe for jobs");
+	fflush (NULL);
+	for (i = 0  ;  i < count  ;  ++i)
+	{
+		workers [i].pid = fork ();
+		if (workers [i].pid == (pid_t) -1)
+			error (FATAL | PERROR, "cannot start job");
+		else if (workers [i].pid == 0)
+		{
+			close (fds [1]);
+			runWorker (fds [0], &workers [i], (boolean) (i == 0));
+		}
+	}
+	close (fds [0]);
+	for (i = 0  ;  ok  &&  i < orderCount  ;  ++i)
+	{
+		if (write (fds [1], &order [i], sizeof (*order)) != sizeof (*order))
+			ok = FALSE;  /* all workers have died */
+	}
+	close (fds [1]);
+	eFree (order);
+	return ok;
+}
+
+/*  Waits for a worker to exit, returning whether it succeeded.
+ */
+static boolean waitForProcess (const pid_t pid)
+{
+	int status;
+	pid_t result;
+	do
+		result = waitpid (pid, &status, 0);
+	while (result == (pid_t) -1  &&  errno == EINTR);
+	return (boolean) (result != (pid_t) -1  &&  WIFEXITED (status)  &&
+			WEXITSTATUS (status) == 0);
+}
+
+static boolean waitForWorkers (worker *const workers, const unsigned int count)
+{
+	boolean ok = TRUE;
+	unsigned int i;
+	for (i = 0  ;  i < count  ;  ++i)
+	{
+		if (! waitForProcess (workers [i].pid))
+			ok = FALSE;
+	}
+	return ok;
+}
+
+static void addWorkerTotals (
+		const unsigned int index, const jobSummary *const summary)
+{
+	if (index >= WorkerTotalsCount)
+	{
+		WorkerTotals = xRealloc (WorkerTotals, index + 1, jobTotals);
+		memset (WorkerTotals + WorkerTotalsCount, 0,
+				(index + 1 - WorkerTotalsCount) * sizeof (jobTotals));
+		WorkerTotalsCount = index + 1;
+	}
+	WorkerTotals [index].files += summary->files;
+	WorkerTotals [index].allocations += summary->allocations;
+	WorkerTotals [index].busy += summary->busy;
+	WorkerTotals [index].elapsed += summary->elapsed;
+}
+
+/*  Reads the results of each worker, recording where the tags for each
+ *  file are found and adding the statistics of the worker to ours.
+ */
+static boolean readWorkerResults (
+		const worker *const workers, const unsigned int count,
+		jobSource *const sources, const unsigned int fileCount)
+{
+	boolean ok = TRUE;
+	unsigned int i;
+
+	for (i = 0  ;  i < fileCount  ;  ++i)
+		sources [i].length = -1;
+	for (i = 0  ;  ok  &&  i < count  ;  ++i)
+	{
+		FILE *const fp = fopen (workers [i].resultName, "rb");
+		jobSummary summary;
+		jobResult result;
+
+		if (fp == NULL  ||  fread (&summary, sizeof (summary), 1, fp) != 1)
+			ok = FALSE;
+		else
+		{
+			addTotals (summary.files, summary.lines, summary.bytes);
+			addWorkerTotals (i, &summary);
+			if (summary.maxLine > TagFile.max.line)
+				TagFile.max.line = summary.maxLine;
+			if (summary.maxTag > TagFile.max.tag)
+				TagFile.max.tag = summary.maxTag;
+			while (fread (&result, sizeof (result), 1, fp) == 1  &&
+				   result.fileIndex < fileCount)
+			{
+				jobSource *const source = &sources [result.fileIndex];
+				source->worker = i;
+				source->offset = result.offset;
+				source->length = result.length;
+				TagFile.numTags.added += result.tags;
+			}
+			if (Option.profileRegex  &&  ! readRegexProfile (fp))
+				ok = FALSE;
+			if (Option.printTotals  &&  ! readLanguageTotals (fp))
+				ok = FALSE;
+#ifdef MEMORY_ACCOUNTING
+			if (Option.printTotals  &&  ! readMemoryTotals (fp))
+				ok = FALSE;
+#endif
+		}
+		if (fp != NULL)
+			fclose (fp);
+	}
+	for (i = 0  ;  ok  &&  i < fileCount  ;  ++i)
+	{
+		if (sources [i].length < 0)
+			ok = FALSE;  /* a worker died before tagging this file */
+	}
+	return ok;
+}
+
+static void copyTags (FILE *const from, const jobSource *const source)
+{
+	char buffer [BUFSIZ];
+	long remaining = source->length;
+
+	if (fseek (from, source->offset, SEEK_SET) == -1)
+		error (FATAL | PERROR, "cannot read job results");
+	while (remaining > 0)
+	{
+		const size_t wanted = remaining < (long) sizeof (buffer) ?
+				(size_t) remaining : sizeof (buffer);
+		const size_t got = fread (buffer, 1, wanted, from);
+		if (got == 0)
+			error (FATAL, "job results truncated");
+		fwrite (buffer, 1, got, TagFile.fp);
+		remaining -= (long) got;
+	}
+}
+
+/*  Copies the tags written by the workers into the tag file in the order
+ *  in which the source files were queued.
+ */
+static void mergeWorkerTags (
+		const worker *const workers, const unsigned int count,
+		const jobSource *const sources, const unsigned int fileCount)
+{
+	FILE **const fps = xMalloc (count, FILE*);
+	unsigned int i;
+
+	for (i = 0  ;  i < count  ;  ++i)
+	{
+		fps [i] = fopen (workers [i].tagName, "rb");
+		if (fps [i] == NULL)
+			error (FATAL | PERROR, "cannot open \"%s\"", workers [i].tagName);
+	}
+	for (i = 0  ;  i < fileCount  ;  ++i)
+	{
+		if (sources [i].length > 0)
+			copyTags (fps [sources [i].worker], &sources [i]);
+	}
+	for (i = 0  ;  i < count  ;  ++i)
+		fclose (fps [i]);
+	eFree (fps);
+}
+
+static void runJobs (const unsigned int fileCount)
+{
+	const unsigned int count =
+			fileCount < Option.jobs ? fileCount : Option.jobs;
+	worker *const workers = xMalloc (count, worker);
+	jobSource *const sources = xMalloc (fileCount, jobSource);
+	void (*previousHandler) (int);
+	boolean ok;
+
+	verbose ("tagging %u files using %u jobs\n", fileCount, count);
+	SortedRuns = isTagFileSortedAtClose ();
+	createWorkerFiles (workers, count);
+	previousHandler = signal (SIGPIPE, SIG_IGN);
+	ok = startWorkers (workers, count, fileCount);
+	signal (SIGPIPE, previousHandler);
+	ok = (boolean) (waitForWorkers (workers, count)  &&  ok);
+	ok = (boolean) (ok  &&  readWorkerResults (workers, count, sources, fileCount));
+	if (ok  &&  SortedRuns)
+	{
+		unsigned int i;
+		for (i = 0  ;  i < count  ;  ++i)
+		{
+			addSortedRun (workers [i].tagName);
+			workers [i].tagName = NULL;
+		}
+	}
+	else if (ok)
+		mergeWorkerTags (workers, count, sources, fileCount);
+	removeWorkerFiles (workers, count);
+	eFree (workers);
+	eFree (sources);
+	if (! ok)
+		error (FATAL, "parallel tagging job failed");
+}
+
+/*
+*   Chunked tagging of a single file
+*/
+
+/*  Counts the lines begun in "length" bytes of "text".
+ */
+static unsigned long countLines (
+		const unsigned char *const text, const size_t length)
+{
+	const unsigned char *const end = text + length;
+	const unsigned char *p = text;
+	unsigned long count = 0;
+
+	while (p < end  &&  (p = memchr (p, '\n', end - p)) != NULL)
+	{
+		++count;
+		++p;
+	}
+	if (length > 0  &&  text [length - 1] != '\n')
+		++count;  /* unterminated last line */
+	return count;
+}
+
+/*  Divides the mapped input file into "count" chunks of roughly equal size,
+ *  each ending just after a newline, returning the number of non-empty
+ *  chunks.
+ */
+static unsigned int divideInput (chunk *const chunks, const unsigned int count)
+{
+	const unsigned char *const text = File.mapped;
+	const size_t size = File.mappedSize;
+	unsigned long lineNumber = 1;
+	size_t start = 0;
+	unsigned int n = 0;
+
+	while (start < size  &&  n < count)
+	{
+		size_t end = size;
+		if (n + 1 < count  &&  start + size / count < size)
+		{
+			const unsigned char *const newline = memchr (text + start + size / count,
+					'\n', size - start - size / count);
+			if (newline != NULL)
+				end = (size_t) (newline - text) + 1;
+		}
+		chunks [n].start = start;
+		chunks [n].end = end;
+		chunks [n].lineNumber = lineNumber;
+		chunks [n].tags = 0;
+		lineNumber += countLines (text + start, end - start);
+		start = end;
+		++n;
+	}
+	return n;
+}
+
+static void tagChunk (const simpleParser parser, chunk *const part)
+{
+	const unsigned long tags = TagFile.numTags.added;
+	fileRestrictRange (part->start, part->end, part->lineNumber);
+	parser ();
+	part->tags = TagFile.numTags.added - tags;
+	part->maxLine = TagFile.max.line;
+	part->maxTag = TagFile.max.tag;
+}
+
+static void runChunkWorker (
+		const simpleParser parser, chunk *const part, const worker *const self)
+{
+	FILE *results;
+
+	InWorker = TRUE;
+	TagFile.fp = fopen (self->tagName, "wb");
+	if (TagFile.fp == NULL)
+		error (FATAL | PERROR, "cannot open \"%s\"", self->tagName);
+	stopHoldingTags ();
+	if (Option.profileRegex)
+		clearRegexProfile ();
+	tagChunk (parser, part);
+	results = fopen (self->resultName, "wb");
+	if (results == NULL)
+		error (FATAL | PERROR, "cannot open \"%s\"", self->resultName);
+	writeJobRecord (results, part, sizeof (*part));
+	if (Option.profileRegex)
+		writeRegexProfile (results);
+	if (fclose (TagFile.fp) != 0  ||  fclose (results) != 0)
+		error (FATAL | PERROR, "cannot write job results");
+	exit (0);
+}
+
+static boolean readChunkResult (const worker *const self, chunk *const part)
+{
+	FILE *const fp = fopen (self->resultName, "rb");
+	boolean ok = (boolean) (fp != NULL  &&
+			fread (part, sizeof (*part), 1, fp) == 1);
+	if (ok  &&  Option.profileRegex)
+		ok = readRegexProfile (fp);
+	if (fp != NULL)
+		fclose (fp);
+	if (ok)
+	{
+		TagFile.numTags.added += part->tags;
+		if (part->maxLine > TagFile.max.line)
+			TagFile.max.line = part->maxLine;
+		if (part->maxTag > TagFile.max.tag)
+			TagFile.max.tag = part->maxTag;
+	}
+	return ok;
+}
+
+static void appendChunkTags (const worker *const self)
+{
+	FILE *const fp = fopen (self->tagName, "rb");
+	char buffer [BUFSIZ];
+	size_t got;
+
+	if (fp == NULL)
+		error (FATAL | PERROR, "cannot open \"%s\"", self->tagName);
+	while ((got = fread (buffer, 1, sizeof (buffer), fp)) > 0)
+		fwrite (buffer, 1, got, TagFile.fp);
+	fclose (fp);
+}
+
+/*  Tags the first chunk ourselves while workers tag the rest, then appends
+ *  their tags in order.
+ */
+static void tagChunks (
+		const simpleParser parser, chunk *const chunks, const unsigned int count)
+{
+	worker *const workers = xMalloc (count, worker);  /* first is unused */
+	boolean ok = TRUE;
+	unsigned int i;
+
+	verbose ("tagging %s in %u chunks\n", vStringValue (File.name), count);
+	createWorkerFiles (workers + 1, count - 1);
+	fflush (NULL);
+	for (i = 1  ;  i < count  ;  ++i)
+	{
+		workers [i].pid = fork ();
+		if (workers [i].pid == (pid_t) -1)
+			error (FATAL | PERROR, "cannot start job");
+		else if (workers [i].pid == 0)
+			runChunkWorker (parser, &chunks [i], &workers [i]);
+	}
+	tagChunk (parser, &chunks [0]);
+	flushFileTags ();  /* to precede the tags of the workers */
+	ok = waitForWorkers (workers + 1, count - 1);
+	for (i = 1  ;  ok  &&  i < count  ;  ++i)
+		ok = readChunkResult (&workers [i], &chunks [i]);
+	for (i = 1  ;  ok  &&  i < count  ;  ++i)
+		appendChunkTags (&workers [i]);
+	removeWorkerFiles (workers + 1, count - 1);
+	eFree (workers);
+	if (! ok)
+		error (FATAL, "parallel tagging job failed");
+}
+
+/*
+*   Concurrent tasks
+*/
+
+/*  Runs "task" concurrently for each index from 0 to "count" - 1, the
+ *  first in this process and the others in forked workers, returning
+ *  whether all of them completed. The workers share only memory mapped
+ *  as shared before the call.
+ */
+extern boolean runConcurrentTasks (
+		const unsigned int count, void (*const task) (const unsigned int))
+{
+	pid_t *const pids = xMalloc (count, pid_t);
+	boolean ok = TRUE;
+	unsigned int i;
+
+	fflush (NULL);
+	for (i = 1  ;  i < count  ;  ++i)
+	{
+		pids [i] = fork ();
+		if (pids [i] == (pid_t) -1)
+			error (FATAL | PERROR, "cannot start job");
+		else if (pids [i] == 0)
+		{
+			InWorker = TRUE;
+			task (i);
+			exit (0);
+		}
+	}
+	task (0);
+	for (i = 1  ;  i < count  ;  ++i)
+	{
+		if (! waitForProcess (pids [i]))
+			ok = FALSE;
+	}
+	eFree (pids);
+	return ok;
+}
+
+#endif
+
+/*  Generates tags for the open input file using "parser", which must
+ *  examine each line independently of the others, by dividing the file
+ *  into chunks tagged concurrently. Returns FALSE without doing anything
+ *  if the file is not worth dividing or the options in effect require
+ *  that it be read from start to finish.
+ */
+extern boolean tagInputInChunks (const simpleParser parser __unused__)
+{
+	boolean result = FALSE;
+#ifdef JOBS_SUPPORTED
+	if (Option.jobs > 1  &&  ! InWorker  &&  ! Option.etags  &&
+		! Option.lineDirectives  &&  Option.extraOutputs == NULL  &&
+		File.mapped != NULL  &&  File.mappedSize >= 2 * (size_t) MinimumChunkSize)
+	{
+		const size_t most = File.mappedSize / MinimumChunkSize;
+		chunk *const chunks = xMalloc (Option.jobs, chunk);
+		const unsigned int count = divideInput (chunks,
+				most < Option.jobs ? (unsigned int) most : Option.jobs);
+		if (count > 1)
+		{
+			const chunk *const last = &chunks [count - 1];
+			tagChunks (parser, chunks, count);
+			fileRestrictRange (File.mappedSize, File.mappedSize,
+				last->lineNumber + countLines (File.mapped + last->start,
+						last->end - last->start));
+			result = TRUE;
+		}
+		eFree (chunks);
+	}
+#endif
+	return result;
+}
+
+/*  Prints, for --totals, how evenly the work was spread over the jobs.
+ */
+extern void printJobTotals (void)
+{
+#ifdef JOBS_SUPPORTED
+	unsigned int i;
+	for (i = 0  ;  i < WorkerTotalsCount  ;  ++i)
+	{
+		const jobTotals *const totals = &WorkerTotals [i];
+		fprintf (errout, "job %u: %lu file%s, %lu allocation%s", i + 1,
+				totals->files, totals->files == 1 ? "" : "s",
+				totals->allocations, totals->allocations == 1 ? "" : "s");
+# ifdef JOB_TIMING_AVAILABLE
+		fprintf (errout, ", busy %.02f seconds, idle %.02f seconds",
+				totals->busy, totals->elapsed - totals->busy);
+# endif
+		fputc ('\n', errout);
+	}
+#endif
+}
+
+/*  Prints, for --totals=json, the member of the totals object describing
+ *  each job.
+ */
+extern void printJobTotalsJson (FILE *const fp)
+{
+	unsigned int count = 0;
+	fputs ("  \"jobs\": [", fp);
+#ifdef JOBS_SUPPORTED
+	{
+		unsigned int i;
+		for (i = 0  ;  i < WorkerTotalsCount  ;  ++i)
+		{
+			const jobTotals *const totals = &WorkerTotals [i];
+			fprintf (fp, "%s\n    {\"files\": %lu, \"allocations\": %lu, "
+					"\"busy\": %.6f, \"idle\": %.6f}", i == 0 ? "" : ",",
+					totals->files, totals->allocations,
+					totals->busy, totals->elapsed - totals->busy);
+		}
+		count = WorkerTotalsCount;
+	}
+#endif
+	fputs (count == 0 ? "],\n" : "\n  ],\n", fp);
+}
+
+/*  Generates tags for the files queued or read ahead since the last call,
+ *  returning whether the tag file requires truncation.
+ */
+extern boolean tagQueuedFiles (void)
+{
+	boolean resize = FALSE;
+	const unsigned int count =
+			(QueuedFiles == NULL) ? 0 : stringListCount (QueuedFiles);
+
+	while (ReadAheadCount > 0)
+		resize |= tagOldestReadAheadFile ();
+#ifdef JOBS_SUPPORTED
+	if (count > 1  &&  SerialFileCount < count)
+		runJobs (count);
+	else
+#endif
+	{
+		unsigned int i;
+		for (i = 0  ;  i < count  ;  ++i)
+		{
+			if (readAheadEnabled ()  &&  i + ReadAheadDistance < count)
+				fileReadAhead (vStringValue (
+						stringListItem (QueuedFiles, i + ReadAheadDistance)));
+			resize |= parseFile (vStringValue (stringListItem (QueuedFiles, i)));
+		}
+	}
+	if (QueuedFiles != NULL)
+		stringListClear (QueuedFiles);
+	SerialFileCount = 0;
+	return resize;
+}
+
+/* vi:set tabstop=4 shiftwidth=4: */
@@ -0,0 +1,42 @@
+/*
+*   $Id$
+*
+*   Copyright (c) 2026, Exuberant Ctags contributors
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License.
+*
+*   External interface to jobs.c
+*/
+#ifndef _JOBS_H
+#define _JOBS_H
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#include "parse.h"
+#include "routines.h"
+
+/*
+*   FUNCTION PROTOTYPES
+*/
+extern boolean jobsEnabled (void);
+extern boolean readAheadEnabled (void);
+extern boolean tagFileReadingAhead (const char *const fileName);
+extern boolean isFileInShard (const char *const fileName);
+extern void queueFileForTagging (
+		const char *const fileName, const fileStatus *const status);
+extern boolean tagQueuedFiles (void);
+extern boolean tagInputInChunks (const simpleParser parser);
+#ifdef JOBS_SUPPORTED
+extern boolean runConcurrentTasks (const unsigned int count, void (*const task) (const unsigned int));
+#endif
+extern void printJobTotals (void);
+extern void printJobTotalsJson (FILE *const fp);
+extern void freeJobsResources (void);
+
+#endif  /* _JOBS_H */
+
+/* vi:set tabstop=4 shiftwidth=4: */
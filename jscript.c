@@ -28,6 +28,7 @@
 #include "debug.h"
 #include "entry.h"
 #include "keyword.h"
+#include "lexer.h"
 #include "parse.h"
 #include "read.h"
 #include "routines.h"
@@ -119,9 +120,26 @@ typedef struct sTokenInfo {
  */
 
 static langType Lang_js;
+static lexClasses JsClasses;
 
 static jmp_buf Exception;
 
+/*
+ * Tokens and saved scopes no longer in use, kept for reuse until the end
+ * of the file, so that each statement and block does not allocate afresh.
+ */
+static tokenInfo **SpareTokens = NULL;
+static unsigned int SpareTokenCount = 0;
+static unsigned int SpareTokenMax = 0;
+static vString **SpareScopes = NULL;
+static unsigned int SpareScopeCount = 0;
+static unsigned int SpareScopeMax = 0;
+
+/*
+ * Holds the qualified name of a token while it is checked or tagged
+ */
+static vString *FullName = NULL;
+
 typedef enum {
 	JSTAG_FUNCTION,
 	JSTAG_CLASS,
@@ -171,9 +189,7 @@ static boolean parseLine (tokenInfo *const token, boolean is_inside_class);
 
 static boolean isIdentChar (const int c)
 {
-	return (boolean)
-		(isalpha (c) || isdigit (c) || c == '$' || 
-		 c == '@' || c == '_' || c == '#');
+	return (boolean) lexIsIdentChar (&JsClasses, c);
 }
 
 static void buildJsKeywordHash (void)
@@ -190,12 +206,22 @@ static void buildJsKeywordHash (void)
 
 static tokenInfo *newToken (void)
 {
-	tokenInfo *const token = xMalloc (1, tokenInfo);
+	tokenInfo *token;
 
+	if (SpareTokenCount > 0)
+	{
+		token = SpareTokens [--SpareTokenCount];
+		vStringClear (token->string);
+		vStringClear (token->scope);
+	}
+	else
+	{
+		token = xMalloc (1, tokenInfo);
+		token->string	= vStringNew ();
+		token->scope	= vStringNew ();
+	}
 	token->type			= TOKEN_UNDEFINED;
 	token->keyword		= KEYWORD_NONE;
-	token->string		= vStringNew ();
-	token->scope		= vStringNew ();
 	token->nestLevel	= 0;
 	token->ignoreTag	= FALSE;
 	token->lineNumber   = getSourceLineNumber ();
@@ -204,13 +230,87 @@ static tokenInfo *newToken (void)
 	return token;
 }
 
-static void deleteToken (tokenInfo *const token)
+static void freeToken (tokenInfo *const token)
 {
 	vStringDelete (token->string);
 	vStringDelete (token->scope);
 	eFree (token);
 }
 
+/*
+ * Keeps a token no longer in use for reuse by newToken ()
+ */
+static void deleteToken (tokenInfo *const token)
+{
+	if (SpareTokenCount == SpareTokenMax)
+	{
+		SpareTokenMax = SpareTokenMax == 0 ? 16 : SpareTokenMax * 2;
+		SpareTokens = xRealloc (SpareTokens, SpareTokenMax, tokenInfo*);
+	}
+	SpareTokens [SpareTokenCount++] = token;
+}
+
+/*
+ * Returns an empty string in which to save the scope of a token
+ */
+static vString *newScope (void)
+{
+	vString *scope;
+
+	if (SpareScopeCount > 0)
+	{
+		scope = SpareScopes [--SpareScopeCount];
+		vStringClear (scope);
+	}
+	else
+		scope = vStringNew ();
+	return scope;
+}
+
+static void deleteScope (vString *const scope)
+{
+	if (SpareScopeCount == SpareScopeMax)
+	{
+		SpareScopeMax = SpareScopeMax == 0 ? 16 : SpareScopeMax * 2;
+		SpareScopes = xRealloc (SpareScopes, SpareScopeMax, vString*);
+	}
+	SpareScopes [SpareScopeCount++] = scope;
+}
+
+/*
+ * Frees the tokens and scopes kept for reuse, once a file is done
+ */
+static void freeSpares (void)
+{
+	while (SpareTokenCount > 0)
+		freeToken (SpareTokens [--SpareTokenCount]);
+	while (SpareScopeCount > 0)
+		vStringDelete (SpareScopes [--SpareScopeCount]);
+	if (SpareTokens != NULL)
+		eFree (SpareTokens);
+	if (SpareScopes != NULL)
+		eFree (SpareScopes);
+	SpareTokens = NULL;
+	SpareTokenMax = 0;
+	SpareScopes = NULL;
+	SpareScopeMax = 0;
+}
+
+/*
+ * Sets FullName to the name of a token qualified by its scope
+ */
+static void buildFullName (const tokenInfo *const token)
+{
+	if (vStringLength (token->scope) > 0)
+	{
+		vStringCopy (FullName, token->scope);
+		vStringPut (FullName, '.');
+		vStringCat (FullName, token->string);
+	}
+	else
+		vStringCopy (FullName, token->string);
+}
+
 /*
  *	 Tag generation functions
  */
@@ -234,8 +334,6 @@ static void makeConstTag (tokenInfo *const token, const jsKind kind)
 
 static void makeJsTag (tokenInfo *const token, const jsKind kind)
 {
-	vString *	fulltag;
-
 	if (JsKinds [kind].enabled && ! token->ignoreTag )
 	{
 		/*
@@ -244,13 +342,8 @@ static void makeJsTag (tokenInfo *const token, const jsKind kind)
 		 */
 		if ( vStringLength(token->scope) > 0 )
 		{
-			fulltag = vStringNew ();
-			vStringCopy(fulltag, token->scope);
-			vStringCatS (fulltag, ".");
-			vStringCatS (fulltag, vStringValue(token->string));
-			vStringTerminate(fulltag);
-			vStringCopy(token->string, fulltag);
-			vStringDelete (fulltag);
+			buildFullName (token);
+			vStringCopy(token->string, FullName);
 		}
 		makeConstTag (token, kind);
 	}
@@ -258,55 +351,27 @@ static void makeJsTag (tokenInfo *const token, const jsKind kind)
 
 static void makeClassTag (tokenInfo *const token)
 { 
-	vString *	fulltag;
-
 	if ( ! token->ignoreTag )
 	{
-		fulltag = vStringNew ();
-		if (vStringLength (token->scope) > 0)
-		{
-			vStringCopy(fulltag, token->scope);
-			vStringCatS (fulltag, ".");
-			vStringCatS (fulltag, vStringValue(token->string));
-		}
-		else
-		{
-			vStringCopy(fulltag, token->string);
-		}
-		vStringTerminate(fulltag);
-		if ( ! stringListHas(ClassNames, vStringValue (fulltag)) )
+		buildFullName (token);
+		if ( ! stringListHas(ClassNames, vStringValue (FullName)) )
 		{
-			stringListAdd (ClassNames, vStringNewCopy (fulltag));
+			stringListAdd (ClassNames, vStringNewCopy (FullName));
 			makeJsTag (token, JSTAG_CLASS);
 		}
-		vStringDelete (fulltag);
 	}
 }
 
 static void makeFunctionTag (tokenInfo *const token)
 { 
-	vString *	fulltag;
-
 	if ( ! token->ignoreTag )
 	{
-		fulltag = vStringNew ();
-		if (vStringLength (token->scope) > 0)
-		{
-			vStringCopy(fulltag, token->scope);
-			vStringCatS (fulltag, ".");
-			vStringCatS (fulltag, vStringValue(token->string));
-		}
-		else
-		{
-			vStringCopy(fulltag, token->string);
-		}
-		vStringTerminate(fulltag);
-		if ( ! stringListHas(FunctionNames, vStringValue (fulltag)) )
+		buildFullName (token);
+		if ( ! stringListHas(FunctionNames, vStringValue (FullName)) )
 		{
-			stringListAdd (FunctionNames, vStringNewCopy (fulltag));
+			stringListAdd (FunctionNames, vStringNewCopy (FullName));
 			makeJsTag (token, JSTAG_FUNCTION);
 		}
-		vStringDelete (fulltag);
 	}
 }
 
@@ -316,23 +381,7 @@ static void makeFunctionTag (tokenInfo *const token)
 
 static void parseString (vString *const string, const int delimiter)
 {
-	boolean end = FALSE;
-	while (! end)
-	{
-		int c = fileGetc ();
-		if (c == EOF)
-			end = TRUE;
-		else if (c == '\\')
-		{
-			c = fileGetc(); /* This maybe a ' or ". */
-			vStringPut(string, c);
-		}
-		else if (c == delimiter)
-			end = TRUE;
-		else
-			vStringPut (string, c);
-	}
-	vStringTerminate (string);
+	lexReadString (string, delimiter, '\\');
 }
 
 /*	Read a C identifier beginning with "firstChar" and places it into
@@ -340,14 +389,9 @@ static void parseString (vString *const string, const int delimiter)
  */
 static void parseIdentifier (vString *const string, const int firstChar)
 {
-	int c = firstChar;
-	Assert (isIdentChar (c));
-	do
-	{
-		vStringPut (string, c);
-		c = fileGetc ();
-	} while (isIdentChar (c));
-	vStringTerminate (string);
+	int c;
+	Assert (isIdentChar (firstChar));
+	c = lexReadIdentifier (&JsClasses, string, firstChar);
 	if (!isspace (c))
 		fileUngetc (c);		/* unget non-identifier character */
 }
@@ -361,13 +405,9 @@ static void readToken (tokenInfo *const token)
 	vStringClear (token->string);
 
 getNextChar:
-	do
-	{
-		c = fileGetc ();
-		token->lineNumber   = getSourceLineNumber ();
-		token->filePosition = getInputFilePosition ();
-	}
-	while (c == '\t'  ||  c == ' ' ||  c == '\n');
+	c = lexSkipSpace (&JsClasses);
+	token->lineNumber   = getSourceLineNumber ();
+	token->filePosition = getInputFilePosition ();
 
 	switch (c)
 	{
@@ -867,7 +907,7 @@ static boolean parseBlock (tokenInfo *const token, tokenInfo *const parent)
 {
 	boolean is_class = FALSE;
 	boolean read_next_token = TRUE;
-	vString * saveScope = vStringNew ();
+	vString * saveScope = newScope ();
 
 	token->nestLevel++;
 	/*
@@ -953,7 +993,7 @@ static boolean parseBlock (tokenInfo *const token, tokenInfo *const parent)
 		} while (! isType (token, TOKEN_CLOSE_CURLY) && read_next_token );
 	}
 
-	vStringDelete(saveScope);
+	deleteScope(saveScope);
 	token->nestLevel--;
 
 	return is_class;
@@ -1027,12 +1067,11 @@ static boolean parseStatement (tokenInfo *const token, boolean is_inside_class)
 {
 	tokenInfo *const name = newToken ();
 	tokenInfo *const secondary_name = newToken ();
-	vString * saveScope = vStringNew ();
+	vString * saveScope = newScope ();
 	boolean is_class = FALSE;
 	boolean is_terminated = TRUE;
 	boolean is_global = FALSE;
 	boolean is_prototype = FALSE;
-	vString *	fulltag;
 
 	vStringClear(saveScope);
 	/*
@@ -1406,26 +1445,14 @@ static boolean parseStatement (tokenInfo *const token, boolean is_inside_class)
 				 * This is a global variable:
 				 *	   var g_var = different_var_name;
 				 */
-				fulltag = vStringNew ();
-				if (vStringLength (token->scope) > 0)
-				{
-					vStringCopy(fulltag, token->scope);
-					vStringCatS (fulltag, ".");
-					vStringCatS (fulltag, vStringValue(token->string));
-				}
-				else
-				{
-					vStringCopy(fulltag, token->string);
-				}
-				vStringTerminate(fulltag);
-				if ( ! stringListHas(FunctionNames, vStringValue (fulltag)) &&
-						! stringListHas(ClassNames, vStringValue (fulltag)) )
+				buildFullName (token);
+				if ( ! stringListHas(FunctionNames, vStringValue (FullName)) &&
+						! stringListHas(ClassNames, vStringValue (FullName)) )
 				{
 					findCmdTerm (token);
 					if (isType (token, TOKEN_SEMICOLON)) 
 						makeJsTag (name, JSTAG_VARIABLE);
 				}
-				vStringDelete (fulltag);
 			}
 		}
 	}
@@ -1451,7 +1478,7 @@ cleanUp:
 	vStringCopy(token->scope, saveScope);
 	deleteToken (name);
 	deleteToken (secondary_name);
-	vStringDelete(saveScope);
+	deleteScope(saveScope);
 
 	return is_terminated;
 }
@@ -1531,6 +1558,7 @@ static void initialize (const langType language)
 {
 	Assert (sizeof (JsKinds) / sizeof (JsKinds [0]) == JSTAG_COUNT);
 	Lang_js = language;
+	lexInitClasses (&JsClasses, "$@_#", " \t\n");
 	buildJsKeywordHash ();
 }
 
@@ -1539,8 +1567,9 @@ static void findJsTags (void)
 	tokenInfo *const token = newToken ();
 	exception_t exception;
 	
-	ClassNames = stringListNew ();
-	FunctionNames = stringListNew ();
+	ClassNames = stringListNewIndexed ();
+	FunctionNames = stringListNewIndexed ();
+	FullName = vStringNew ();
 	
 	exception = (exception_t) (setjmp (Exception));
 	while (exception == ExceptionNone)
@@ -1550,7 +1579,10 @@ static void findJsTags (void)
 	stringListDelete (FunctionNames);
 	ClassNames = NULL;
 	FunctionNames = NULL;
+	vStringDelete (FullName);
+	FullName = NULL;
 	deleteToken (token);
+	freeSpares ();
 }
 
 /* Create parser definition stucture */
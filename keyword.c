@@ -6,7 +6,13 @@
 *   This source code is released for free distribution under the terms of the
 *   GNU General Public License.
 *
-*   Manages a keyword hash.
+*   Manages a keyword table for each language.
+*
+*   The keywords of a language are collected as added, and arranged into a
+*   perfect hash table when first looked up after being added: the keywords
+*   are divided among buckets by their hash, and each bucket is given the
+*   displacement which sends its keywords to slots not already taken, so
+*   that looking a keyword up takes one probe and one comparison.
 */
 
 /*
@@ -15,6 +21,10 @@
 #include "general.h"  /* must always come first */
 
 #include <string.h>
+#include <ctype.h>
+#ifdef HAVE_STDLIB_H
+# include <stdlib.h>  /* to declare qsort () */
+#endif
 
 #include "debug.h"
 #include "keyword.h"
@@ -24,233 +34,383 @@
 /*
 *   MACROS
 */
-#define HASH_EXPONENT 7  /* must be less than 17 */
+#define MIN_SLOTS         16    /* must be a power of 2 */
+#define MAX_DISPLACEMENT  4096  /* tried for each bucket */
 
 /*
 *   DATA DECLARATIONS
 */
-typedef struct sHashEntry {
-	struct sHashEntry *next;
-	const char *string;
-	langType language;
+typedef struct sKeyword {
+	const char *string;  /* NULL in an empty slot */
+	unsigned long hash;
 	int value;
-} hashEntry;
+} keywordEntry;
+
+typedef struct sKeywordTable {
+	keywordEntry *keywords;        /* in the order added */
+	unsigned int count;
+	unsigned int max;
+	boolean arranged;              /* are all keywords added in slots? */
+	keywordEntry *slots;
+	unsigned long slotMask;        /* number of slots less one */
+	unsigned long *displacements;  /* of each bucket */
+	unsigned long bucketMask;      /* number of buckets less one */
+	keywordEntry *overflow;        /* keywords for which no slot was found */
+	unsigned int overflowCount;
+} keywordTable;
 
 /*
 *   DATA DEFINITIONS
 */
-static const unsigned int TableSize = 1 << HASH_EXPONENT;
-static hashEntry **HashTable = NULL;
+static keywordTable *Tables = NULL;  /* indexed by language */
+static unsigned int TableCount = 0;
 
 /*
 *   FUNCTION DEFINITIONS
 */
 
-static hashEntry **getHashTable (void)
+static keywordTable *getKeywordTable (const langType language)
 {
-	static boolean allocated = FALSE;
+	keywordTable *result = NULL;
+	if (language >= 0  &&  (unsigned int) language < TableCount)
+		result = &Tables [language];
+	return result;
+}
 
-	if (! allocated)
+static keywordTable *newKeywordTable (const langType language)
+{
+	Assert (language >= 0);
+	if ((unsigned int) language >= TableCount)
 	{
-		unsigned int i;
-
-		HashTable = xMalloc (TableSize, hashEntry*);
-
-		for (i = 0  ;  i < TableSize  ;  ++i)
-			HashTable [i] = NULL;
-
-		allocated = TRUE;
+		const unsigned int count = (unsigned int) language + 1;
+		Tables = xRealloc (Tables, count, keywordTable);
+		memset (Tables + TableCount, 0,
+				(count - TableCount) * sizeof (keywordTable));
+		TableCount = count;
 	}
-	return HashTable;
+	return &Tables [language];
 }
 
-static hashEntry *getHashTableEntry (unsigned long hashedValue)
+static unsigned long hashValue (const char *const string, const size_t length)
 {
-	hashEntry **const table = getHashTable ();
-	hashEntry *entry;
-
-	Assert (hashedValue < TableSize);
-	entry = table [hashedValue];
-
-	return entry;
+	Assert (string != NULL);
+	return hashBytes (INITIAL_HASH, (const unsigned char *) string, length);
 }
 
-static unsigned long hashValue (const char *const string)
+/*  Hashes "string" as hashValue() would once it had been copied into lower
+ *  case, as keywords are added, but without copying it.
+ */
+static unsigned long foldedHashValue (const char *const string,
+		const size_t length)
 {
-	unsigned long value = 0;
-	const unsigned char *p;
+	const unsigned char *p = (const unsigned char *) string;
+	const unsigned char *const end = p + length;
+	unsigned long hash = INITIAL_HASH;
 
 	Assert (string != NULL);
+	while (p < end)
+	{
+		hash ^= (unsigned long) (unsigned char) tolower ((int) *p++);
+		hash = (hash * 16777619UL) & 0xffffffffUL;
+	}
+	return hash;
+}
 
-	/*  We combine the various words of the multiword key using the method
-	 *  described on page 512 of Vol. 3 of "The Art of Computer Programming".
-	 */
-	for (p = (const unsigned char *) string  ;  *p != '\0'  ;  ++p)
+/*  Does "string" equal "keyword", once copied into lower case if "folded"?
+ */
+static boolean isKeyword (const char *const string, const char *const keyword,
+		const boolean folded)
+{
+	boolean result;
+	if (! folded)
+		result = (boolean) (strcmp (string, keyword) == 0);
+	else
 	{
-		value <<= 1;
-		if (value & 0x00000100L)
-			value = (value & 0x000000ffL) + 1L;
-		value ^= *p;
+		const unsigned char *s = (const unsigned char *) string;
+		const unsigned char *k = (const unsigned char *) keyword;
+		while (*k != '\0'  &&  (unsigned char) tolower ((int) *s) == *k)
+			++s, ++k;
+		result = (boolean) (*s == '\0'  &&  *k == '\0');
 	}
-	/*  Algorithm from page 509 of Vol. 3 of "The Art of Computer Programming"
-	 *  Treats "value" as a 16-bit integer plus 16-bit fraction.
-	 */
-	value *= 40503L;               /* = 2^16 * 0.6180339887 ("golden ratio") */
-	value &= 0x0000ffffL;          /* keep fractional part */
-	value >>= 16 - HASH_EXPONENT;  /* scale up by hash size and move down */
+	return result;
+}
 
-	return value;
+/*  Mixes the bits of "hash" with those of "displacement", so that keywords
+ *  sharing a bucket are scattered differently for each displacement tried.
+ */
+static unsigned long slotOf (const keywordTable *const table,
+		const unsigned long hash, const unsigned long displacement)
+{
+	unsigned long x = (hash ^ (displacement * 0x9e3779b9UL)) & 0xffffffffUL;
+	x ^= x >> 16;
+	x = (x * 0x85ebca6bUL) & 0xffffffffUL;
+	x ^= x >> 13;
+	x = (x * 0xc2b2ae35UL) & 0xffffffffUL;
+	x ^= x >> 16;
+	return x & table->slotMask;
 }
 
-static hashEntry *newEntry (
-		const char *const string, langType language, int value)
+static void clearArrangement (keywordTable *const table)
 {
-	hashEntry *const entry = xMalloc (1, hashEntry);
+	if (table->slots != NULL)
+		eFree (table->slots);
+	if (table->displacements != NULL)
+		eFree (table->displacements);
+	if (table->overflow != NULL)
+		eFree (table->overflow);
+	table->slots = NULL;
+	table->displacements = NULL;
+	table->overflow = NULL;
+	table->overflowCount = 0;
+	table->arranged = FALSE;
+}
 
-	entry->next     = NULL;
-	entry->string   = string;
-	entry->language = language;
-	entry->value    = value;
+static const keywordTable *SortedTable;  /* for compareBuckets () */
 
-	return entry;
+static int compareBuckets (const void *const a, const void *const b)
+{
+	const keywordEntry *const k1 =
+			&SortedTable->keywords [*(const unsigned int *) a];
+	const keywordEntry *const k2 =
+			&SortedTable->keywords [*(const unsigned int *) b];
+	const unsigned long b1 = k1->hash & SortedTable->bucketMask;
+	const unsigned long b2 = k2->hash & SortedTable->bucketMask;
+	int result;
+	if (b1 != b2)
+		result = (b1 < b2) ? -1 : 1;
+	else
+		result = (k1 < k2) ? -1 : (k1 > k2);
+	return result;
 }
 
-/*  Note that it is assumed that a "value" of zero means an undefined keyword
- *  and clients of this function should observe this. Also, all keywords added
- *  should be added in lower case. If we encounter a case-sensitive language
- *  whose keywords are in upper case, we will need to redesign this.
+/*  Can the "count" keywords numbered in "members" all be placed in empty
+ *  and distinct slots with "displacement"?
  */
-extern void addKeyword (const char *const string, langType language, int value)
+static boolean fitsBucket (const keywordTable *const table,
+		const unsigned int *const members, const unsigned int count,
+		const unsigned long displacement)
 {
-	const unsigned long hashedValue = hashValue (string);
-	hashEntry *entry = getHashTableEntry (hashedValue);
+	boolean result = TRUE;
+	unsigned int i, j;
+	for (i = 0  ;  result  &&  i < count  ;  ++i)
+	{
+		const unsigned long slot = slotOf (table,
+				table->keywords [members [i]].hash, displacement);
+		if (table->slots [slot].string != NULL)
+			result = FALSE;
+		for (j = 0  ;  result  &&  j < i  ;  ++j)
+		{
+			if (slotOf (table, table->keywords [members [j]].hash,
+						displacement) == slot)
+				result = FALSE;
+		}
+	}
+	return result;
+}
 
-	if (entry == NULL)
+static void placeBucket (keywordTable *const table,
+		const unsigned int *const members, const unsigned int count)
+{
+	const unsigned long bucket =
+			table->keywords [members [0]].hash & table->bucketMask;
+	unsigned long displacement = 0;
+	boolean found = FALSE;
+	unsigned int i;
+
+	while (! found  &&  displacement < MAX_DISPLACEMENT)
 	{
-		hashEntry **const table = getHashTable ();
-		table [hashedValue] = newEntry (string, language, value);
+		if (fitsBucket (table, members, count, displacement))
+			found = TRUE;
+		else
+			++displacement;
 	}
-	else
+	if (found)
 	{
-		hashEntry *prev = NULL;
-
-		while (entry != NULL)
+		table->displacements [bucket] = displacement;
+		for (i = 0  ;  i < count  ;  ++i)
 		{
-			if (language == entry->language  &&
-				strcmp (string, entry->string) == 0)
-			{
-				Assert (("Already in table" == NULL));
-			}
-			prev = entry;
-			entry = entry->next;
-		}
-		if (entry == NULL)
-		{
-			Assert (prev != NULL);
-			prev->next = newEntry (string, language, value);
+			const keywordEntry *const k = &table->keywords [members [i]];
+			table->slots [slotOf (table, k->hash, displacement)] = *k;
 		}
 	}
+	else for (i = 0  ;  i < count  ;  ++i)
+		table->overflow [table->overflowCount++] =
+				table->keywords [members [i]];
 }
 
-extern int lookupKeyword (const char *const string, langType language)
+/*  Arranges the keywords of "table" in its slots, placing the buckets
+ *  holding most keywords first, while the most slots are empty.
+ */
+static void arrangeTable (keywordTable *const table)
 {
-	const unsigned long hashedValue = hashValue (string);
-	hashEntry *entry = getHashTableEntry (hashedValue);
-	int result = -1;
+	const unsigned int count = table->count;
+	unsigned int *const order = xMalloc (count, unsigned int);
+	unsigned int *starts;
+	unsigned int bucketCount = 0;
+	unsigned long slots = MIN_SLOTS;
+	unsigned long buckets = 1;
+	unsigned int i;
 
-	while (entry != NULL)
+	clearArrangement (table);
+	while (slots < 2 * (unsigned long) count)
+		slots *= 2;
+	while (2 * buckets < (unsigned long) count)
+		buckets *= 2;
+	table->slotMask = slots - 1;
+	table->bucketMask = buckets - 1;
+	table->slots = xCalloc (slots, keywordEntry);
+	table->displacements = xCalloc (buckets, unsigned long);
+	table->overflow = xMalloc (count, keywordEntry);
+
+	for (i = 0  ;  i < count  ;  ++i)
+		order [i] = i;
+	SortedTable = table;
+	qsort (order, (size_t) count, sizeof (unsigned int), compareBuckets);
+
+	/*  Find where each bucket starts within "order", then place the buckets
+	 *  from the largest down, by repeated passes over descending sizes.
+	 */
+	starts = xMalloc (count + 1, unsigned int);
+	for (i = 0  ;  i < count  ;  ++i)
+	{
+		if (i == 0  ||  (table->keywords [order [i]].hash & table->bucketMask)
+			!= (table->keywords [order [i - 1]].hash & table->bucketMask))
+			starts [bucketCount++] = i;
+	}
+	starts [bucketCount] = count;
 	{
-		if (language == entry->language  &&  strcmp (string, entry->string) == 0)
+		unsigned int largest = 0;
+		unsigned int size;
+		for (i = 0  ;  i < bucketCount  ;  ++i)
 		{
-			result = entry->value;
-			break;
+			if (starts [i + 1] - starts [i] > largest)
+				largest = starts [i + 1] - starts [i];
+		}
+		for (size = largest  ;  size > 0  ;  --size)
+		{
+			for (i = 0  ;  i < bucketCount  ;  ++i)
+			{
+				if (starts [i + 1] - starts [i] == size)
+					placeBucket (table, order + starts [i], size);
+			}
 		}
-		entry = entry->next;
 	}
-	return result;
+	eFree (starts);
+	eFree (order);
+	table->arranged = TRUE;
 }
 
-extern void freeKeywordTable (void)
+/*  Note that it is assumed that a "value" of zero means an undefined keyword
+ *  and clients of this function should observe this. Also, all keywords added
+ *  should be added in lower case. If we encounter a case-sensitive language
+ *  whose keywords are in upper case, we will need to redesign this.
+ */
+extern void addKeyword (const char *const string, langType language, int value)
 {
-	if (HashTable != NULL)
+	keywordTable *const table = newKeywordTable (language);
+	keywordEntry *entry;
+
+	if (table->count == table->max)
 	{
-		unsigned int i;
+		table->max = (table->max == 0) ? 64 : 2 * table->max;
+		table->keywords = xRealloc (table->keywords, table->max, keywordEntry);
+	}
+	entry = &table->keywords [table->count++];
+	entry->string = string;
+	entry->hash   = hashValue (string, strlen (string));
+	entry->value  = value;
+	table->arranged = FALSE;
+}
 
-		for (i = 0  ;  i < TableSize  ;  ++i)
-		{
-			hashEntry *entry = HashTable [i];
+static int findKeyword (const char *const string, const size_t length,
+		const langType language, const boolean folded)
+{
+	keywordTable *const table = getKeywordTable (language);
+	int result = -1;
 
-			while (entry != NULL)
+	if (table != NULL  &&  table->count > 0)
+	{
+		const unsigned long hash = folded ? foldedHashValue (string, length)
+										  : hashValue (string, length);
+		const keywordEntry *entry;
+
+		if (! table->arranged)
+			arrangeTable (table);
+		entry = &table->slots [slotOf (table, hash,
+				table->displacements [hash & table->bucketMask])];
+		if (entry->string != NULL  &&  entry->hash == hash  &&
+			isKeyword (string, entry->string, folded))
+			result = entry->value;
+		else
+		{
+			unsigned int i;
+			for (i = 0  ;  result == -1  &&  i < table->overflowCount  ;  ++i)
 			{
-				hashEntry *next = entry->next;
-				eFree (entry);
-				entry = next;
+				entry = &table->overflow [i];
+				if (entry->hash == hash  &&
+					isKeyword (string, entry->string, folded))
+					result = entry->value;
 			}
 		}
-		eFree (HashTable);
 	}
-}
-
-extern int analyzeToken (vString *const name, langType language)
-{
-	vString *keyword = vStringNew ();
-	int result;
-	vStringCopyToLower (keyword, name);
-	result = lookupKeyword (vStringValue (keyword), language);
-	vStringDelete (keyword);
 	return result;
 }
 
-#ifdef DEBUG
-
-static void printEntry (const hashEntry *const entry)
+extern int lookupKeyword (const char *const string, langType language)
 {
-	printf ("  %-15s %-7s\n", entry->string, getLanguageName (entry->language));
+	return findKeyword (string, strlen (string), language, FALSE);
 }
 
-static unsigned int printBucket (const unsigned int i)
+extern void freeKeywordTable (void)
 {
-	hashEntry **const table = getHashTable ();
-	hashEntry *entry = table [i];
-	unsigned int measure = 1;
-	boolean first = TRUE;
-
-	printf ("%2d:", i);
-	if (entry == NULL)
-		printf ("\n");
-	else while (entry != NULL)
+	unsigned int i;
+
+	for (i = 0  ;  i < TableCount  ;  ++i)
 	{
-		if (! first)
-			printf ("    ");
-		else
-		{
-			printf (" ");
-			first = FALSE;
-		}
-		printEntry (entry);
-		entry = entry->next;
-		measure = 2 * measure;
+		clearArrangement (&Tables [i]);
+		if (Tables [i].keywords != NULL)
+			eFree (Tables [i].keywords);
 	}
-	return measure - 1;
+	if (Tables != NULL)
+		eFree (Tables);
+	Tables = NULL;
+	TableCount = 0;
 }
 
+/*  Looks up "name" as a keyword of a language whose keywords are not case
+ *  sensitive, folding its case as it goes rather than copying it.
+ */
+extern int analyzeToken (vString *const name, langType language)
+{
+	return findKeyword (vStringValue (name), vStringLength (name),
+			language, TRUE);
+}
+
+#ifdef DEBUG
+
 extern void printKeywordTable (void)
 {
-	unsigned long emptyBucketCount = 0;
-	unsigned long measure = 0;
 	unsigned int i;
 
-	for (i = 0  ;  i < TableSize  ;  ++i)
+	for (i = 0  ;  i < TableCount  ;  ++i)
 	{
-		const unsigned int pass = printBucket (i);
-
-		measure += pass;
-		if (pass == 0)
-			++emptyBucketCount;
+		keywordTable *const table = &Tables [i];
+		if (table->count > 0)
+		{
+			unsigned long slot;
+			if (! table->arranged)
+				arrangeTable (table);
+			printf ("%s: %u keywords, %lu slots, %lu buckets, %u overflowing\n",
+					getLanguageName ((langType) i), table->count,
+					table->slotMask + 1, table->bucketMask + 1,
+					table->overflowCount);
+			for (slot = 0  ;  slot <= table->slotMask  ;  ++slot)
+			{
+				if (table->slots [slot].string != NULL)
+					printf ("  %4lu: %s\n", slot, table->slots [slot].string);
+			}
+		}
 	}
-
-	printf ("spread measure = %ld\n", measure);
-	printf ("%ld empty buckets\n", emptyBucketCount);
 }
 
 #endif
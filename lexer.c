@@ -0,0 +1,212 @@
+/*
+*   $Id$
+*
+*   Copyright (c) 2026, Exuberant Ctags contributors
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License.
+*
+*   This module contains functions shared by the parsers which read their
+*   input as tokens through fileGetc (). Each such language describes its
+*   characters in a table of classes, so that an identifier character or a
+*   space is recognized by a single lookup. Runs of identifier characters,
+*   of spaces and of string contents are then taken from the current line
+*   at once, rather than one call of fileGetc () at a time, with the same
+*   result.
+*/
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#include <ctype.h>
+#include <string.h>
+
+#include "debug.h"
+#include "lexer.h"
+#include "read.h"
+
+/*
+*   FUNCTION DEFINITIONS
+*/
+
+/*  Prepares the classes of a language whose identifiers consist of letters,
+ *  digits and "identChars", and begin with any of these but a digit, and
+ *  whose tokens are separated by "spaceChars".
+ */
+extern void lexInitClasses (
+		lexClasses *const classes, const char *const identChars,
+		const char *const spaceChars)
+{
+	const char *p;
+	int c;
+
+	memset (classes->table, 0, sizeof (classes->table));
+	for (c = 0  ;  c < 256  ;  ++c)
+	{
+		if (isalpha (c))
+			classes->table [c] |= LEX_IDENT | LEX_IDENT_START;
+		else if (isdigit (c))
+			classes->table [c] |= LEX_IDENT;
+	}
+	for (p = identChars  ;  *p != '\0'  ;  ++p)
+		classes->table [(unsigned char) *p] |= LEX_IDENT | LEX_IDENT_START;
+	for (p = spaceChars  ;  *p != '\0'  ;  ++p)
+		classes->table [(unsigned char) *p] |= LEX_SPACE;
+}
+
+/*  Adds the characters from "first" to "last" to "class".
+ */
+extern void lexAddClass (
+		lexClasses *const classes, const int first, const int last,
+		const unsigned int class)
+{
+	int c;
+	Assert (0 <= first  &&  last < 256);
+	for (c = first  ;  c <= last  ;  ++c)
+		classes->table [c] |= class;
+}
+
+extern void lexRemoveClass (
+		lexClasses *const classes, const char *const chars,
+		const unsigned int class)
+{
+	const char *p;
+	for (p = chars  ;  *p != '\0'  ;  ++p)
+		classes->table [(unsigned char) *p] &= ~class;
+}
+
+/*  Returns the number of characters at the start of "span" which are all of
+ *  "class".
+ */
+static size_t spanOfClass (
+		const lexClasses *const classes, const unsigned char *const span,
+		const size_t length, const unsigned int class)
+{
+	size_t i = 0;
+	while (i < length  &&  (classes->table [span [i]] & class) != 0)
+		++i;
+	return i;
+}
+
+/*  Consumes the characters of "class" which come next in the current line.
+ */
+static const unsigned char *skipClass (
+		const lexClasses *const classes, const unsigned int class,
+		size_t *const count)
+{
+	size_t length;
+	const unsigned char *const span = fileLineSpan (&length);
+	*count = 0;
+	if (span != NULL)
+	{
+		*count = spanOfClass (classes, span, length, class);
+		if (*count > 0)
+			fileSkipBytes (*count);
+	}
+	return span;
+}
+
+/*  Skips any spaces, returning the first character which is not one. Most
+ *  tokens are preceded by one space or none, so the rest of the line is
+ *  only examined once a space is found.
+ */
+extern int lexSkipSpace (const lexClasses *const classes)
+{
+	int c = fileGetc ();
+	while (lexIsSpaceChar (classes, c))
+	{
+		size_t count;
+		skipClass (classes, LEX_SPACE, &count);
+		c = fileGetc ();
+	}
+	return c;
+}
+
+/*  Reads the identifier beginning with "firstChar" into "string", returning
+ *  the character which follows it.
+ */
+extern int lexReadIdentifier (
+		const lexClasses *const classes, vString *const string,
+		const int firstChar)
+{
+	int c = firstChar;
+	do
+	{
+		const unsigned char *span;
+		size_t count;
+		vStringPut (string, c);
+		span = skipClass (classes, LEX_IDENT, &count);
+		if (count > 0)
+			vStringNCatS (string, (const char *) span, count);
+		c = fileGetc ();
+	} while (lexIsIdentChar (classes, c));
+	vStringTerminate (string);
+	return c;
+}
+
+/*  Reads or, when "string" is NULL, skips the contents of a string, as
+ *  described for lexReadString ().
+ */
+static void scanString (
+		vString *const string, const int delimiter, const int escape)
+{
+	boolean end = FALSE;
+	char stops [3];
+
+	stops [0] = (char) delimiter;
+	stops [1] = (char) escape;
+	stops [2] = '\0';
+	while (! end)
+	{
+		size_t length;
+		const unsigned char *const span = fileLineSpan (&length);
+		int c;
+
+		if (span != NULL)
+		{
+			const size_t count = strcspn ((const char *) span, stops);
+			if (count > 0)
+			{
+				if (string != NULL)
+					vStringNCatS (string, (const char *) span, count);
+				fileSkipBytes (count);
+			}
+		}
+		c = fileGetc ();
+		if (c == EOF)
+			end = TRUE;
+		else if (c == escape  &&  escape != '\0')
+		{
+			c = fileGetc ();
+			if (c != EOF  &&  string != NULL)
+				vStringPut (string, c);
+		}
+		else if (c == delimiter)
+			end = TRUE;
+		else if (string != NULL)
+			vStringPut (string, c);
+	}
+	if (string != NULL)
+		vStringTerminate (string);
+}
+
+/*  Reads the contents of a string into "string", up to and including the
+ *  "delimiter" which ends it. A character following "escape" is taken as
+ *  it is, and the escape itself dropped; an escape of '\0' means none.
+ */
+extern void lexReadString (
+		vString *const string, const int delimiter, const int escape)
+{
+	scanString (string, delimiter, escape);
+}
+
+/*  Skips the contents of a string, as lexReadString () would read them.
+ */
+extern void lexSkipString (const int delimiter, const int escape)
+{
+	scanString (NULL, delimiter, escape);
+}
+
+/* vi:set tabstop=4 shiftwidth=4: */
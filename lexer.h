@@ -0,0 +1,58 @@
+/*
+*   $Id$
+*
+*   Copyright (c) 2026, Exuberant Ctags contributors
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License.
+*
+*   External interface to lexer.c
+*/
+#ifndef _LEXER_H
+#define _LEXER_H
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#include "vstring.h"
+
+/*
+*   MACROS
+*/
+#define lexIsClass(classes,c,class) \
+	((c) >= 0  &&  (c) < 256  &&  ((classes)->table [(c)] & (class)) != 0)
+#define lexIsIdentChar(classes,c)      lexIsClass (classes, c, LEX_IDENT)
+#define lexIsIdentStartChar(classes,c) lexIsClass (classes, c, LEX_IDENT_START)
+#define lexIsSpaceChar(classes,c)      lexIsClass (classes, c, LEX_SPACE)
+
+/*
+*   DATA DECLARATIONS
+*/
+enum eLexClass {
+	LEX_IDENT       = 1 << 0,  /* may continue an identifier */
+	LEX_IDENT_START = 1 << 1,  /* may begin an identifier */
+	LEX_SPACE       = 1 << 2   /* separates tokens */
+};
+
+/*  The class of each character, as a language's lexer sees it.
+ */
+typedef struct sLexClasses {
+	unsigned char table [256];
+} lexClasses;
+
+/*
+*   FUNCTION PROTOTYPES
+*/
+extern void lexInitClasses (lexClasses *const classes, const char *const identChars, const char *const spaceChars);
+extern void lexAddClass (lexClasses *const classes, const int first, const int last, const unsigned int class);
+extern void lexRemoveClass (lexClasses *const classes, const char *const chars, const unsigned int class);
+extern int lexSkipSpace (const lexClasses *const classes);
+extern int lexReadIdentifier (const lexClasses *const classes, vString *const string, const int firstChar);
+extern void lexReadString (vString *const string, const int delimiter, const int escape);
+extern void lexSkipString (const int delimiter, const int escape);
+
+#endif  /* _LEXER_H */
+
+/* vi:set tabstop=4 shiftwidth=4: */
@@ -0,0 +1,275 @@
+/*
+*   $Id$
+*
+*   Copyright (c) 2026, Exuberant Ctags contributors
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License.
+*
+*   This module contains the functions of the library libctags (see
+*   libctags.h), through which a program generates tags from the contents of
+*   source files held in memory without running ctags. Tags are taken from
+*   makeTagEntry () through a tag sink, rather than written to a tag file,
+*   and are kept until the file is parsed, since a parser may discard its
+*   tags to parse the file again.
+*/
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "debug.h"
+#include "entry.h"
+#include "keyword.h"
+#include "libctags.h"
+#include "options.h"
+#include "parse.h"
+#include "read.h"
+#include "routines.h"
+#include "vstring.h"
+
+/*
+*   DATA DECLARATIONS
+*/
+
+/*  The strings of a kept tag, each stored as an offset into KeptText.
+ */
+enum eKeptString {
+	KEPT_NAME, KEPT_FILE, KEPT_LANGUAGE, KEPT_KIND,
+	KEPT_ACCESS, KEPT_IMPLEMENTATION, KEPT_INHERITANCE,
+	KEPT_SCOPE_KIND, KEPT_SCOPE, KEPT_SIGNATURE,
+	KEPT_TYPEREF_KIND, KEPT_TYPEREF,
+	KEPT_STRING_COUNT
+};
+
+#define ABSENT  ((size_t) -1)  /* offset of a string which is NULL */
+
+typedef struct sKeptTag {
+	unsigned long index;  /* order in which tag was found */
+	unsigned long lineNumber;
+	char kindLetter;
+	boolean fileScope;
+	boolean fileEntry;
+	size_t strings [KEPT_STRING_COUNT];
+} keptTag;
+
+/*
+*   DATA DEFINITIONS
+*/
+static boolean Initialized = FALSE;
+static boolean Terminated = FALSE;  /* may not be initialized again */
+static keptTag *Kept = NULL;
+static unsigned long KeptCount = 0;
+static unsigned long KeptSize = 0;
+static vString *KeptText = NULL;
+static unsigned long BaseCount;  /* tags added before the file was parsed */
+
+/*
+*   FUNCTION DEFINITIONS
+*/
+
+static size_t keepString (const char *const string)
+{
+	size_t offset = ABSENT;
+	if (string != NULL)
+	{
+		offset = vStringLength (KeptText);
+		vStringCatS (KeptText, string);
+		vStringPut (KeptText, ' ');  /* counted in place of its terminator */
+		vStringLast (KeptText) = '\0';
+	}
+	return offset;
+}
+
+static const char *keptString (const keptTag *const kept, const int which)
+{
+	const size_t offset = kept->strings [which];
+	return offset == ABSENT ? NULL : vStringValue (KeptText) + offset;
+}
+
+/*  Keeps a copy of a tag made while parsing. Should the parser discard its
+ *  tags to parse the file again, the count of tags added is rewound, and
+ *  the copies of the discarded tags are replaced.
+ */
+static void keepTag (const tagEntryInfo *const tag)
+{
+	keptTag *kept;
+
+	KeptCount = TagFile.numTags.added - BaseCount;
+	if (KeptCount == KeptSize)
+	{
+		KeptSize = KeptSize == 0 ? 64 : KeptSize * 2;
+		Kept = xRealloc (Kept, KeptSize, keptTag);
+	}
+	kept = &Kept [KeptCount++];
+	kept->index      = KeptCount;
+	kept->lineNumber = tag->lineNumber;
+	kept->kindLetter = tag->kind;
+	kept->fileScope  = tag->isFileScope;
+	kept->fileEntry  = tag->isFileEntry;
+	kept->strings [KEPT_NAME]     = keepString (tag->name);
+	kept->strings [KEPT_FILE]     = keepString (tag->sourceFileName);
+	kept->strings [KEPT_LANGUAGE] = keepString (tag->language);
+	kept->strings [KEPT_KIND]     = keepString (tag->kindName);
+	kept->strings [KEPT_ACCESS]   = keepString (tag->extensionFields.access);
+	kept->strings [KEPT_IMPLEMENTATION] =
+			keepString (tag->extensionFields.implementation);
+	kept->strings [KEPT_INHERITANCE] =
+			keepString (tag->extensionFields.inheritance);
+	kept->strings [KEPT_SCOPE_KIND] =
+			keepString (tag->extensionFields.scope [0]);
+	kept->strings [KEPT_SCOPE]    = keepString (tag->extensionFields.scope [1]);
+	kept->strings [KEPT_SIGNATURE] =
+			keepString (tag->extensionFields.signature);
+	kept->strings [KEPT_TYPEREF_KIND] =
+			keepString (tag->extensionFields.typeRef [0]);
+	kept->strings [KEPT_TYPEREF]  =
+			keepString (tag->extensionFields.typeRef [1]);
+}
+
+static int compareKeptTags (const void *const one, const void *const two)
+{
+	const keptTag *const t1 = (const keptTag *) one;
+	const keptTag *const t2 = (const keptTag *) two;
+	const char *const name1 = keptString (t1, KEPT_NAME);
+	const char *const name2 = keptString (t2, KEPT_NAME);
+	int result = (Option.sorted == SO_FOLDSORTED) ?
+			struppercmp (name1, name2) : strcmp (name1, name2);
+	if (result == 0  &&  t1->lineNumber != t2->lineNumber)
+		result = t1->lineNumber < t2->lineNumber ? -1 : 1;
+	if (result == 0  &&  t1->index != t2->index)
+		result = t1->index < t2->index ? -1 : 1;
+	return result;
+}
+
+static void deliverKeptTags (const ctagsCallback callback, void *const data)
+{
+	unsigned long i;
+
+	if (Option.sorted != SO_UNSORTED)
+		qsort (Kept, KeptCount, sizeof (keptTag), compareKeptTags);
+	for (i = 0  ;  i < KeptCount  ;  ++i)
+	{
+		const keptTag *const kept = &Kept [i];
+		ctagsEntry entry;
+
+		entry.name       = keptString (kept, KEPT_NAME);
+		entry.file       = keptString (kept, KEPT_FILE);
+		entry.language   = keptString (kept, KEPT_LANGUAGE);
+		entry.lineNumber = kept->lineNumber;
+		entry.kind       = keptString (kept, KEPT_KIND);
+		entry.kindLetter = kept->kindLetter;
+		entry.fileScope  = (short) kept->fileScope;
+		entry.fileEntry  = (short) kept->fileEntry;
+		entry.fields.access         = keptString (kept, KEPT_ACCESS);
+		entry.fields.implementation = keptString (kept, KEPT_IMPLEMENTATION);
+		entry.fields.inheritance    = keptString (kept, KEPT_INHERITANCE);
+		entry.fields.scopeKind      = keptString (kept, KEPT_SCOPE_KIND);
+		entry.fields.scope          = keptString (kept, KEPT_SCOPE);
+		entry.fields.signature      = keptString (kept, KEPT_SIGNATURE);
+		entry.fields.typeRefKind    = keptString (kept, KEPT_TYPEREF_KIND);
+		entry.fields.typeRef        = keptString (kept, KEPT_TYPEREF);
+		(*callback) (&entry, data);
+	}
+}
+
+/*
+*   Library interface
+*/
+
+extern ctagsResult ctagsInitialize (const char *const *const options)
+{
+	ctagsResult result = CtagsFailure;
+	if (! Initialized  &&  ! Terminated)
+	{
+		static char *const noOptions [] = { NULL };
+		cookedArgs *args;
+
+		setCurrentDirectory ();
+		setExecutableName ("ctags");
+		checkRegex ();
+
+		args = cArgNewFromArgv (options == NULL ?
+				noOptions : (char *const *) options);
+		previewFirstOption (args);
+		initializeParsing ();
+		initOptions ();
+		readOptionConfiguration ();
+		parseOptions (args);
+		if (! cArgOff (args))
+			error (FATAL, "libctags takes no file names");
+		checkOptions ();
+		cArgDelete (args);
+
+		KeptText = vStringNew ();
+		setTagSink (keepTag);
+		Initialized = TRUE;
+		result = CtagsSuccess;
+	}
+	return result;
+}
+
+extern ctagsResult ctagsParseBuffer (
+		const char *const language, const char *const fileName,
+		const char *const contents, const size_t length,
+		const ctagsCallback callback, void *const data)
+{
+	ctagsResult result = CtagsFailure;
+	if (Initialized)
+	{
+		langType lang;
+
+		fileSupplyContents (fileName, (const unsigned char *) contents, length);
+		if (language != NULL)
+			lang = getNamedLanguage (language);
+		else if (Option.language != LANG_AUTO)
+			lang = Option.language;
+		else
+			lang = getFileLanguage (fileName);
+		if (lang != LANG_IGNORE)
+		{
+			BaseCount = TagFile.numTags.added;
+			KeptCount = 0;
+			vStringClear (KeptText);
+			parseFileAs (fileName, lang);
+			KeptCount = TagFile.numTags.added - BaseCount;
+			deliverKeptTags (callback, data);
+			result = CtagsSuccess;
+		}
+		fileReleaseHead ();
+		fileReleaseContents ();
+	}
+	return result;
+}
+
+extern void ctagsTerminate (void)
+{
+	if (Initialized)
+	{
+		setTagSink (NULL);
+		if (Kept != NULL)
+			eFree (Kept);
+		Kept = NULL;
+		KeptCount = 0;
+		KeptSize = 0;
+		vStringDelete (KeptText);
+		KeptText = NULL;
+
+		freeKeywordTable ();
+		freeRoutineResources ();
+		freeSourceFileResources ();
+		freeTagFileResources ();
+		freeOptionResources ();
+		freeParserResources ();
+		freeRegexResources ();
+		vStringReleaseSpares ();
+		Initialized = FALSE;
+		Terminated = TRUE;
+	}
+}
+
+/* vi:set tabstop=4 shiftwidth=4: */
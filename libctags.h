@@ -0,0 +1,119 @@
+/*
+*   $Id$
+*
+*   Copyright (c) 2026, Exuberant Ctags contributors
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License.
+*
+*   This file defines the public interface for generating tags from within a
+*   program, through the library libctags, rather than by running ctags and
+*   reading back the tag file it writes.
+*
+*   The library is initialized once with the options which ctags would be
+*   given on its command line. The contents of each source file, read from
+*   memory rather than from the file itself, are then parsed just as ctags
+*   would parse the file, each of its tags being passed to a function of the
+*   caller's as a structure instead of being written to a tag file. The
+*   library is not reentrant, and, like ctags, exits upon a fatal error.
+*/
+#ifndef LIBCTAGS_H
+#define LIBCTAGS_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+*  DATA DECLARATIONS
+*/
+
+typedef enum { CtagsFailure = 0, CtagsSuccess = 1 } ctagsResult;
+
+/* This structure contains information about a tag. Its strings are only
+ * valid until the function to which it is passed returns. */
+typedef struct {
+
+		/* name of tag */
+	const char *name;
+
+		/* path of source file containing definition of tag */
+	const char *file;
+
+		/* language of source file */
+	const char *language;
+
+		/* line number in source file of tag definition */
+	unsigned long lineNumber;
+
+		/* kind of tag (e.g. "function"), and its single letter */
+	const char *kind;
+	char kindLetter;
+
+		/* is tag of file-limited scope? */
+	short fileScope;
+
+		/* is tag just an entry for the source file (see --extra=+f)? */
+	short fileEntry;
+
+		/* extension fields of tag, each NULL if absent */
+	struct {
+		const char *access;
+		const char *implementation;
+		const char *inheritance;
+		const char *scopeKind;     /* e.g. "class" */
+		const char *scope;         /* e.g. the name of the class */
+		const char *signature;
+		const char *typeRefKind;   /* e.g. "struct" */
+		const char *typeRef;       /* e.g. the name of the struct */
+	} fields;
+
+} ctagsEntry;
+
+/* Function called for each tag found, with the data given to
+ * ctagsParseBuffer(). */
+typedef void (*ctagsCallback) (const ctagsEntry *const entry, void *const data);
+
+/*
+*  FUNCTION PROTOTYPES
+*/
+
+/*
+*  This function must be called once before any other. "options" is a list
+*  of options exactly as they would be given on the ctags command line (e.g.
+*  "--fields=+S", "--c-kinds=+p"), ending with a null pointer, or is null if
+*  there are none. As for ctags, options are first read from the usual
+*  option files and environment variables, unless the first option is
+*  "--options=NONE". No file names may be given. Returns CtagsFailure if
+*  the library was already initialized, or has been terminated.
+*/
+extern ctagsResult ctagsInitialize (const char *const *const options);
+
+/*
+*  Parses "length" bytes of "contents" as the contents of the source file
+*  "fileName", which need not exist, and is never read. "language" is the
+*  name of the language of the contents, as for the --language-force
+*  option, or is null if it is to be determined from the file name and
+*  contents, as ctags would determine it. The tags found are passed in turn
+*  to "callback", along with "data", sorted by name (ignoring case if
+*  --sort=foldcase was given), then by line number, or in the order found
+*  if --sort=no was given. Returns CtagsFailure if the language is unknown
+*  or cannot be determined, or the library is not initialized.
+*/
+extern ctagsResult ctagsParseBuffer (const char *const language, const char *const fileName, const char *const contents, const size_t length, const ctagsCallback callback, void *const data);
+
+/*
+*  Releases all resources held by the library, which may not be initialized
+*  again.
+*/
+extern void ctagsTerminate (void);
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif
+
+/* vi:set tabstop=4 shiftwidth=4: */
@@ -19,6 +19,9 @@
 #include "general.h"  /* must always come first */
 
 #include <string.h>
+#ifdef HAVE_STDLIB_H
+# include <stdlib.h>  /* to declare qsort () */
+#endif
 
 #ifdef HAVE_REGCOMP
 # include <ctype.h>
@@ -28,12 +31,18 @@
 # endif
 # include <regex.h>
 #endif
+#ifdef HAVE_PCRE2
+# define PCRE2_CODE_UNIT_WIDTH 8
+# include <pcre2.h>
+#endif
 
 #include "debug.h"
 #include "entry.h"
+#include "options.h"
 #include "parse.h"
 #include "read.h"
 #include "routines.h"
+#include "trace.h"
 
 #ifdef HAVE_REGEX
 
@@ -64,12 +73,69 @@ struct sKind {
 
 enum pType { PTRN_TAG, PTRN_CALLBACK };
 
+/*  Part of the name of a tag: either characters of the name pattern, or the
+ *  characters matched by a subexpression.
+ */
+typedef struct {
+	int reference;  /* number of subexpression, or 0 for characters */
+	size_t start;   /* of characters within name_text */
+	size_t length;
+} nameSegment;
+
+/*  A regular expression compiled by regcomp(), or by PCRE2 where it was
+ *  given the "p" flag.
+ */
+typedef struct {
+	regex_t *posix;
+#ifdef HAVE_PCRE2
+	pcre2_code *perl;
+	pcre2_match_data *data;  /* receives the matches of perl */
+#endif
+	boolean multiline;  /* matched against whole file, given "{mline}" */
+	boolean perlSyntax;  /* to be compiled by PCRE2, given "p" */
+} compiledRegex;
+
+/*  What trying a pattern has cost, kept for --profile-regex.
+ */
 typedef struct {
-	regex_t *pattern;
+	unsigned long calls;  /* to match the pattern */
+	unsigned long hits;   /* calls which found a match */
+	double seconds;       /* spent in all calls */
+	double worst;         /* seconds spent in the slowest call */
+	vString *worstFile;   /* in which the slowest call was made */
+	unsigned long worstLine;
+} regexProfile;
+
+/*  The profile of a pattern as passed from a worker process to the parent,
+ *  followed by the characters of the name of its worst file.
+ */
+typedef struct {
+	int language;  /* or -1, after the last record */
+	unsigned int index;  /* of pattern in set of language */
+	unsigned long calls, hits;
+	double seconds, worst;
+	unsigned long worstLine;
+	size_t worstFileLength;
+} profileRecord;
+
+typedef struct {
+	compiledRegex pattern;
 	enum pType type;
+	char *source;  /* regular expression, if a filter may include it */
+	int cflags;    /* with which it was compiled */
+	int filter;    /* index of filter including pattern, or -1 if none */
+	vString *required;  /* characters every matching line contains */
+	int literal;   /* index of them among literals of set, or -1 */
+	char *regexp;  /* as given, to report its profile */
+	boolean compiled;  /* has pattern been compiled, when first needed? */
+	boolean broken;    /* could it not be compiled? */
+	regexProfile profile;
 	union {
 		struct {
 			char *name_pattern;
+			char *name_text;  /* characters of name_pattern, unescaped */
+			nameSegment *segments;  /* into which name_pattern parses */
+			unsigned int segmentCount;
 			struct sKind kind;
 		} tag;
 		struct {
@@ -78,11 +144,44 @@ typedef struct {
 	} u;
 } regexPattern;
 
+/*  A pattern of some language, for sorting profiles by cost.
+ */
+typedef struct {
+	langType language;
+	const regexPattern *pattern;
+} profileEntry;
+
+/*  All of the patterns of a language compiled with the same flags, joined
+ *  as alternatives, so that one pass over a line shows whether any of them
+ *  can match it.
+ */
+typedef struct {
+	regex_t pattern;
+	int cflags;
+	boolean matched;  /* did the line last tried match? */
+} regexFilter;
+
+/*  Characters which every line matched by some of the patterns of a
+ *  language contains, folded to lower case where patterns ignore case.
+ */
+typedef struct {
+	vString *text;
+	boolean folded;
+	boolean found;  /* in the line last tried? */
+} requiredLiteral;
+
 #endif
 
 typedef struct {
 	regexPattern *patterns;
 	unsigned int count;
+	unsigned int size;  /* allocated to patterns */
+	regexFilter *filters;
+	unsigned int filterCount;
+	requiredLiteral *literals;
+	unsigned int literalCount;
+	boolean foldedLiterals;  /* is any of literals folded? */
+	boolean prepared;  /* filters and literals made since pattern added? */
 } patternSet;
 
 /*
@@ -95,29 +194,90 @@ static boolean regexBroken = FALSE;
 static patternSet* Sets = NULL;
 static int SetUpper = -1;  /* upper language index in list */
 
+static vString* FoldedLine = NULL;  /* line tried, in lower case */
+static vString* TagName = NULL;  /* of the tag last matched */
+static vString* Contents = NULL;  /* of file matched by multi-line patterns */
+
 /*
 *   FUNCTION DEFINITIONS
 */
 
+static void clearPrepared (patternSet* const set)
+{
+	unsigned int i;
+	for (i = 0  ;  i < set->filterCount  ;  ++i)
+	{
+#if defined (POSIX_REGEX)
+		regfree (&set->filters [i].pattern);
+#endif
+	}
+	for (i = 0  ;  i < set->literalCount  ;  ++i)
+		vStringDelete (set->literals [i].text);
+	for (i = 0  ;  i < set->count  ;  ++i)
+	{
+		set->patterns [i].filter = -1;
+		set->patterns [i].literal = -1;
+	}
+	if (set->filters != NULL)
+		eFree (set->filters);
+	if (set->literals != NULL)
+		eFree (set->literals);
+	set->filters = NULL;
+	set->filterCount = 0;
+	set->literals = NULL;
+	set->literalCount = 0;
+	set->foldedLiterals = FALSE;
+	set->prepared = FALSE;
+}
+
 static void clearPatternSet (const langType language)
 {
 	if (language <= SetUpper)
 	{
 		patternSet* const set = Sets + language;
 		unsigned int i;
+		clearPrepared (set);
 		for (i = 0  ;  i < set->count  ;  ++i)
 		{
 			regexPattern *p = &set->patterns [i];
+			if (p->pattern.posix != NULL)
+			{
 #if defined (POSIX_REGEX)
-			regfree (p->pattern);
+				regfree (p->pattern.posix);
+#endif
+				eFree (p->pattern.posix);
+				p->pattern.posix = NULL;
+			}
+#ifdef HAVE_PCRE2
+			if (p->pattern.perl != NULL)
+			{
+				pcre2_match_data_free (p->pattern.data);
+				pcre2_code_free (p->pattern.perl);
+				p->pattern.data = NULL;
+				p->pattern.perl = NULL;
+			}
 #endif
-			eFree (p->pattern);
-			p->pattern = NULL;
+			if (p->source != NULL)
+			{
+				eFree (p->source);
+				p->source = NULL;
+			}
+			vStringDelete (p->required);
+			p->required = NULL;
+			eFree (p->regexp);
+			p->regexp = NULL;
+			if (p->profile.worstFile != NULL)
+				vStringDelete (p->profile.worstFile);
+			p->profile.worstFile = NULL;
 
 			if (p->type == PTRN_TAG)
 			{
 				eFree (p->u.tag.name_pattern);
 				p->u.tag.name_pattern = NULL;
+				eFree (p->u.tag.name_text);
+				p->u.tag.name_text = NULL;
+				eFree (p->u.tag.segments);
+				p->u.tag.segments = NULL;
 				eFree (p->u.tag.kind.name);
 				p->u.tag.kind.name = NULL;
 				if (p->u.tag.kind.description != NULL)
@@ -131,6 +291,7 @@ static void clearPatternSet (const langType language)
 			eFree (set->patterns);
 		set->patterns = NULL;
 		set->count = 0;
+		set->size = 0;
 	}
 }
 
@@ -138,8 +299,12 @@ static void clearPatternSet (const langType language)
 *   Regex psuedo-parser
 */
 
+/*  Makes a tag for the current line or, if "position" is not NULL, for the
+ *  line "lineNumber" starting there.
+ */
 static void makeRegexTag (
-		const vString* const name, const struct sKind* const kind)
+		const vString* const name, const struct sKind* const kind,
+		const unsigned long lineNumber, const fpos_t* const position)
 {
 	if (kind->enabled)
 	{
@@ -147,6 +312,11 @@ static void makeRegexTag (
 		Assert (name != NULL  &&  vStringLength (name) > 0);
 		Assert (kind != NULL);
 		initTagEntry (&e, vStringValue (name));
+		if (position != NULL)
+		{
+			e.lineNumber   = lineNumber;
+			e.filePosition = *position;
+		}
 		e.kind     = kind->letter;
 		e.kindName = kind->name;
 		makeTagEntry (&e);
@@ -249,10 +419,216 @@ static boolean parseTagRegex (
 	return result;
 }
 
-static void addCompiledTagPattern (
-		const langType language, regex_t* const pattern,
-		char* const name, const char kind, char* const kindName,
-		char *const description)
+/*  Returns the character following the bracket expression starting at "p",
+ *  or NULL if it is not closed. Where "escapes" is set, as for PCRE2, a
+ *  backslash escapes the character following it.
+ */
+static const char* skipBracket (const char* p, const boolean escapes)
+{
+	++p;
+	if (*p == '^')
+		++p;
+	if (*p == ']')
+		++p;
+	while (*p != '\0'  &&  *p != ']')
+	{
+		if (*p == '['  &&  (p [1] == ':'  ||  p [1] == '.'  ||  p [1] == '='))
+		{
+			const char close = p [1];
+			p += 2;
+			while (*p != '\0'  &&  ! (p [0] == close  &&  p [1] == ']'))
+				++p;
+			if (*p != '\0')
+				p += 2;
+		}
+		else if (escapes  &&  *p == '\\'  &&  p [1] != '\0')
+			p += 2;
+		else
+			++p;
+	}
+	return (*p == '\0') ? NULL : p + 1;
+}
+
+/*  Can "regexp" be made one alternative of a filter by being enclosed in
+ *  parentheses, without changing what it matches? Not if it refers back to
+ *  its own subexpressions, which would be renumbered, nor if its
+ *  parentheses or brackets do not balance.
+ */
+static boolean isFilterable (const char* const regexp, const int cflags)
+{
+	boolean result = (boolean) ((cflags & REG_EXTENDED) != 0);
+	const char* p = regexp;
+	int depth = 0;
+	while (result  &&  *p != '\0')
+	{
+		if (*p == '\\')
+		{
+			++p;
+			if (*p == '\0'  ||  isdigit ((int) *p))
+				result = FALSE;
+			else
+				++p;
+		}
+		else if (*p == '[')
+		{
+			p = skipBracket (p, FALSE);
+			if (p == NULL)
+				result = FALSE;
+		}
+		else
+		{
+			if (*p == '(')
+				++depth;
+			else if (*p == ')'  &&  --depth < 0)
+				result = FALSE;
+			++p;
+		}
+	}
+	return (boolean) (result  &&  depth == 0);
+}
+
+typedef enum {
+	TOKEN_LITERAL, TOKEN_OPEN, TOKEN_CLOSE, TOKEN_ALTERNATION,
+	TOKEN_QUANTIFIER,
+	TOKEN_OTHER      /* matching a character not known, or none */
+} regexToken;
+
+/*  Returns the character following the interval starting at "p", where
+ *  "close" closes it, or NULL if it is not closed as expected.
+ */
+static const char* skipInterval (const char* p, const char* const close)
+{
+	p += strspn (p, "0123456789,");
+	if (strncmp (p, close, strlen (close)) == 0)
+		p += strlen (close);
+	else
+		p = NULL;
+	return p;
+}
+
+/*  Classifies the token of a regular expression at "p", storing the
+ *  character it matches in "c" if it is a literal, and returns the
+ *  character following it, or NULL if the expression cannot be followed.
+ *  For PCRE2 ("perl" set), NULL is also returned for any construct which
+ *  could change the meaning of what follows it, or match characters not
+ *  known here.
+ */
+static const char* nextToken (const char* p, const boolean extended,
+		const boolean perl, regexToken* const token, int* const c)
+{
+	*token = TOKEN_OTHER;
+	if (*p == '\\')
+	{
+		const int e = (unsigned char) p [1];
+		if (e == '\0')
+			p = NULL;
+		else if (perl  &&  isalnum (e)  &&  strchr ("dDsSwWbBhHvVAzZG", e) == NULL)
+			p = NULL;
+		else
+		{
+			p += 2;
+			if (! extended  &&  e == '(')
+				*token = TOKEN_OPEN;
+			else if (! extended  &&  e == ')')
+				*token = TOKEN_CLOSE;
+			else if (! extended  &&  e == '|')
+				*token = TOKEN_ALTERNATION;
+			else if (! extended  &&  (e == '?'  ||  e == '+'))
+				*token = TOKEN_QUANTIFIER;
+			else if (! extended  &&  e == '{')
+			{
+				*token = TOKEN_QUANTIFIER;
+				p = skipInterval (p, "\\}");
+			}
+			else if (! isalnum (e)  &&  strchr ("<>`'", e) == NULL)
+			{
+				*token = TOKEN_LITERAL;
+				*c = e;
+			}
+		}
+	}
+	else if (*p == '[')
+		p = skipBracket (p, perl);
+	else if (perl  &&  *p == '('  &&  (p [1] == '?'  ||  p [1] == '*'))
+		p = NULL;
+	else
+	{
+		const int e = (unsigned char) *p++;
+		if (e == '*'  ||  (extended  &&  (e == '?'  ||  e == '+')))
+			*token = TOKEN_QUANTIFIER;
+		else if (extended  &&  e == '{')
+		{
+			*token = TOKEN_QUANTIFIER;
+			p = skipInterval (p, "}");
+		}
+		else if (extended  &&  e == '(')
+			*token = TOKEN_OPEN;
+		else if (extended  &&  e == ')')
+			*token = TOKEN_CLOSE;
+		else if (extended  &&  e == '|')
+			*token = TOKEN_ALTERNATION;
+		else if (strchr (extended ? ".^$}]" : ".^$", e) == NULL)
+		{
+			*token = TOKEN_LITERAL;
+			*c = e;
+		}
+	}
+	return p;
+}
+
+/*  Finds into "literal" the longest run of characters which every line
+ *  matched by "regexp", compiled with "cflags" (by PCRE2 if "perl" is set)
+ *  contains, leaving it empty if none can be found. Only characters outside of any subexpression are
+ *  considered, and none at all if alternatives are outside of one.
+ */
+static void findRequiredLiteral (const char* const regexp, const int cflags,
+		const boolean perl, vString* const literal)
+{
+	const boolean extended = (boolean) (perl  ||  (cflags & REG_EXTENDED) != 0);
+	const boolean folded = (boolean) ((cflags & REG_ICASE) != 0);
+	vString* const run = vStringNew ();
+	const char* p = regexp;
+	boolean sound = TRUE;
+	int depth = 0;
+
+	vStringClear (literal);
+	while (sound  &&  p != NULL  &&  *p != '\0')
+	{
+		regexToken token;
+		int c = '\0';
+		p = nextToken (p, extended, perl, &token, &c);
+		if (token == TOKEN_OPEN)
+			++depth;
+		else if (token == TOKEN_CLOSE  &&  depth > 0)
+			--depth;
+		else if (token == TOKEN_ALTERNATION  &&  depth == 0)
+			sound = FALSE;
+		if (depth == 0  &&  token == TOKEN_LITERAL  &&  p != NULL)
+		{
+			regexToken following;
+			int ignored;
+			if (nextToken (p, extended, perl, &following, &ignored) == NULL)
+				following = TOKEN_QUANTIFIER;
+			if (following != TOKEN_QUANTIFIER)
+				vStringPut (run, folded ? tolower (c) : c);
+			if (following == TOKEN_LITERAL  ||  following == TOKEN_OPEN  ||
+				following == TOKEN_ALTERNATION)
+				continue;
+		}
+		if (vStringLength (run) > vStringLength (literal))
+			vStringCopy (literal, run);
+		vStringClear (run);
+	}
+	if (vStringLength (run) > vStringLength (literal))
+		vStringCopy (literal, run);
+	if (! sound  ||  p == NULL)
+		vStringClear (literal);
+	vStringDelete (run);
+}
+
+static regexPattern* newPattern (const langType language,
+		const compiledRegex* const pattern, const char* const regexp,
+		const int cflags)
 {
 	patternSet* set;
 	regexPattern *ptrn;
@@ -264,17 +640,106 @@ static void addCompiledTagPattern (
 		{
 			Sets [i].patterns = NULL;
 			Sets [i].count = 0;
+			Sets [i].size = 0;
+			Sets [i].filters = NULL;
+			Sets [i].filterCount = 0;
+			Sets [i].literals = NULL;
+			Sets [i].literalCount = 0;
+			Sets [i].foldedLiterals = FALSE;
+			Sets [i].prepared = FALSE;
 		}
 		SetUpper = language;
 	}
 	set = Sets + language;
-	set->patterns = xRealloc (set->patterns, (set->count + 1), regexPattern);
+	if (set->prepared)
+		clearPrepared (set);  /* filters and literals are made again */
+	if (set->count == set->size)
+	{
+		set->size = set->size == 0 ? 16 : set->size * 2;
+		set->patterns = xRealloc (set->patterns, set->size, regexPattern);
+	}
 	ptrn = &set->patterns [set->count];
 	set->count += 1;
 
-	ptrn->pattern = pattern;
+	ptrn->pattern = *pattern;
+	ptrn->source  = NULL;
+	ptrn->cflags  = cflags;
+	ptrn->filter  = -1;
+	ptrn->required = NULL;
+	ptrn->literal = -1;
+	ptrn->regexp  = eStrdup (regexp);
+	ptrn->compiled = FALSE;
+	ptrn->broken  = FALSE;
+	memset (&ptrn->profile, 0, sizeof (ptrn->profile));
+	ptrn->profile.worstFile = NULL;
+	return ptrn;
+}
+
+/*  Parses the name pattern of "ptrn" into segments, once, so that a tag
+ *  name is made of them without looking at the name pattern again. A
+ *  back-reference \1 through \9 is a segment of its own; other characters
+ *  are joined, after dropping line breaks and the backslash of any other
+ *  escape, into segments of characters.
+ */
+static void parseNamePattern (regexPattern* const ptrn)
+{
+	const char* p = ptrn->u.tag.name_pattern;
+	const size_t length = strlen (p);
+	char* const text = xMalloc (length + 1, char);
+	nameSegment* const segments = xMalloc (length + 1, nameSegment);
+	unsigned int count = 0;
+	size_t used = 0;
+
+	while (*p != '\0')
+	{
+		if (*p == '\\'  &&  isdigit ((int) p [1]))
+		{
+			const int dig = p [1] - '0';
+			if (0 < dig  &&  dig < BACK_REFERENCE_COUNT)
+			{
+				segments [count].reference = dig;
+				segments [count].start = 0;
+				segments [count].length = 0;
+				++count;
+			}
+			p += 2;
+		}
+		else
+		{
+			if (*p == '\\')
+				++p;
+			if (*p != '\0'  &&  *p != '\n'  &&  *p != '\r')
+			{
+				if (count == 0  ||  segments [count - 1].reference != 0)
+				{
+					segments [count].reference = 0;
+					segments [count].start = used;
+					segments [count].length = 0;
+					++count;
+				}
+				text [used++] = *p;
+				++segments [count - 1].length;
+			}
+			if (*p != '\0')
+				++p;
+		}
+	}
+	text [used] = '\0';
+	ptrn->u.tag.name_text = text;
+	ptrn->u.tag.segments = segments;
+	ptrn->u.tag.segmentCount = count;
+}
+
+static void addCompiledTagPattern (
+		const langType language, const compiledRegex* const pattern,
+		const char* const regexp, const int cflags,
+		char* const name, const char kind, char* const kindName,
+		char *const description)
+{
+	regexPattern *const ptrn = newPattern (language, pattern, regexp, cflags);
 	ptrn->type    = PTRN_TAG;
 	ptrn->u.tag.name_pattern = name;
+	parseNamePattern (ptrn);
 	ptrn->u.tag.kind.enabled = TRUE;
 	ptrn->u.tag.kind.letter  = kind;
 	ptrn->u.tag.kind.name    = kindName;
@@ -282,62 +747,150 @@ static void addCompiledTagPattern (
 }
 
 static void addCompiledCallbackPattern (
-		const langType language, regex_t* const pattern,
+		const langType language, const compiledRegex* const pattern,
+		const char* const regexp, const int cflags,
 		const regexCallback callback)
 {
-	patternSet* set;
-	regexPattern *ptrn;
-	if (language > SetUpper)
-	{
-		int i;
-		Sets = xRealloc (Sets, (language + 1), patternSet);
-		for (i = SetUpper + 1  ;  i <= language  ;  ++i)
-		{
-			Sets [i].patterns = NULL;
-			Sets [i].count = 0;
-		}
-		SetUpper = language;
-	}
-	set = Sets + language;
-	set->patterns = xRealloc (set->patterns, (set->count + 1), regexPattern);
-	ptrn = &set->patterns [set->count];
-	set->count += 1;
-
-	ptrn->pattern = pattern;
+	regexPattern *const ptrn = newPattern (language, pattern, regexp, cflags);
 	ptrn->type    = PTRN_CALLBACK;
 	ptrn->u.callback.function = callback;
 }
 
 #if defined (POSIX_REGEX)
 
-static regex_t* compileRegex (const char* const regexp, const char* const flags)
+#ifdef HAVE_PCRE2
+
+/*  Compiles "regexp" with PCRE2, and with its just-in-time compiler where
+ *  that is available, so that a line is matched by machine code.
+ */
+static boolean compilePerlRegex (const char* const regexp, const int cflags,
+		compiledRegex* const compiled)
 {
-	int cflags = REG_EXTENDED | REG_NEWLINE;
-	regex_t *result = NULL;
+	uint32_t options = PCRE2_MULTILINE;
 	int errcode;
+	PCRE2_SIZE offset;
+	if ((cflags & REG_ICASE) != 0)
+		options |= PCRE2_CASELESS;
+	compiled->perl = pcre2_compile ((PCRE2_SPTR) regexp, PCRE2_ZERO_TERMINATED,
+			options, &errcode, &offset, NULL);
+	if (compiled->perl == NULL)
+	{
+		PCRE2_UCHAR errmsg [256];
+		pcre2_get_error_message (errcode, errmsg, sizeof (errmsg));
+		error (WARNING, "pcre2_compile %s: %s at offset %lu", regexp,
+				(const char*) errmsg, (unsigned long) offset);
+	}
+	else
+	{
+		pcre2_jit_compile (compiled->perl, PCRE2_JIT_COMPLETE);
+		compiled->data = pcre2_match_data_create_from_pattern (
+				compiled->perl, NULL);
+	}
+	return (boolean) (compiled->perl != NULL);
+}
+
+#endif
+
+static boolean compilePosixRegex (const char* const regexp, const int cflags,
+		compiledRegex* const compiled)
+{
+	int errcode;
+	compiled->posix = xMalloc (1, regex_t);
+	errcode = regcomp (compiled->posix, regexp, cflags);
+	if (errcode != 0)
+	{
+		char errmsg[256];
+		regerror (errcode, compiled->posix, errmsg, 256);
+		error (WARNING, "regcomp %s: %s", regexp, errmsg);
+		regfree (compiled->posix);
+		eFree (compiled->posix);
+		compiled->posix = NULL;
+	}
+	return (boolean) (compiled->posix != NULL);
+}
+
+/*  Reads "flags" into "compiled" and "compiledFlags", to direct how
+ *  "regexp" is compiled when it is first needed.
+ */
+static void readRegexFlags (const char* const regexp, const char* const flags,
+		int* const compiledFlags, compiledRegex* const compiled)
+{
+	int cflags = REG_EXTENDED | REG_NEWLINE;
+	boolean perl = FALSE;
 	int i;
+	compiled->multiline = FALSE;
 	for (i = 0  ; flags != NULL  &&  flags [i] != '\0'  ;  ++i)
 	{
-		switch ((int) flags [i])
+		if (flags [i] == '{')
+		{
+			const char* const name = flags + i + 1;
+			const size_t length = strcspn (name, "}");
+			if (length == 5  &&  strncmp (name, "mline", length) == 0)
+				compiled->multiline = TRUE;
+			else
+				error (WARNING, "unknown regex flag: '{%.*s}'",
+						(int) length, name);
+			i += length + (name [length] == '}' ? 1 : 0);
+		}
+		else switch ((int) flags [i])
 		{
 			case 'b': cflags &= ~REG_EXTENDED; break;
 			case 'e': cflags |= REG_EXTENDED;  break;
 			case 'i': cflags |= REG_ICASE;     break;
+			case 'p': perl = TRUE;             break;
 			default: error (WARNING, "unknown regex flag: '%c'", *flags); break;
 		}
 	}
-	result = xMalloc (1, regex_t);
-	errcode = regcomp (result, regexp, cflags);
-	if (errcode != 0)
+#ifndef HAVE_PCRE2
+	if (perl)
 	{
-		char errmsg[256];
-		regerror (errcode, result, errmsg, 256);
-		error (WARNING, "regcomp %s: %s", regexp, errmsg);
-		regfree (result);
-		eFree (result);
-		result = NULL;
+		error (WARNING, "PCRE2 support not available; %s is compiled as a Posix extended regular expression",
+			   regexp);
+		cflags |= REG_EXTENDED;
+		perl = FALSE;
+	}
+#endif
+	*compiledFlags = cflags;
+	compiled->perlSyntax = perl;
+	compiled->posix = NULL;
+#ifdef HAVE_PCRE2
+	compiled->perl = NULL;
+	compiled->data = NULL;
+#endif
+}
+
+/*  Compiles "ptrn", and finds whether a filter may include it and the
+ *  literal it requires, which is put off until a file of its language is to
+ *  be matched, so that a run spends nothing on the patterns of languages it
+ *  does not meet. A pattern which cannot be compiled is left out of any
+ *  filter, and never matches.
+ */
+static void compilePattern (regexPattern* const ptrn)
+{
+	boolean ok;
+
+	ptrn->required = vStringNew ();
+	if (! ptrn->pattern.multiline)
+	{
+		if (! ptrn->pattern.perlSyntax  &&
+			isFilterable (ptrn->regexp, ptrn->cflags))
+			ptrn->source = eStrdup (ptrn->regexp);
+		findRequiredLiteral (ptrn->regexp, ptrn->cflags,
+				ptrn->pattern.perlSyntax, ptrn->required);
+	}
+#ifdef HAVE_PCRE2
+	if (ptrn->pattern.perlSyntax)
+		ok = compilePerlRegex (ptrn->regexp, ptrn->cflags, &ptrn->pattern);
+	else
+#endif
+		ok = compilePosixRegex (ptrn->regexp, ptrn->cflags, &ptrn->pattern);
+	ptrn->compiled = TRUE;
+	ptrn->broken = (boolean) ! ok;
+	if (ptrn->broken  &&  ptrn->source != NULL)
+	{
+		eFree (ptrn->source);
+		ptrn->source = NULL;
 	}
-	return result;
 }
 
 #endif
@@ -426,45 +979,57 @@ static void processLanguageRegex (const langType language,
 
 #if defined (POSIX_REGEX)
 
-static vString* substitute (
-		const char* const in, const char* out,
-		const int nmatch, const regmatch_t* const pmatch)
+/*  Makes into "name" the name of the tag for the segments of "patbuf" and
+ *  the subexpressions "pmatch" of "line" they refer to, without leading or
+ *  trailing white space.
+ */
+static void expandName (vString* const name, const char* const line,
+		const regexPattern* const patbuf, const regmatch_t* const pmatch)
 {
-	vString* result = vStringNew ();
-	const char* p;
-	for (p = out  ;  *p != '\0'  ;  p++)
+	unsigned int i;
+	vStringClear (name);
+	for (i = 0  ;  i < patbuf->u.tag.segmentCount  ;  ++i)
 	{
-		if (*p == '\\'  &&  isdigit ((int) *++p))
+		const nameSegment* const segment = &patbuf->u.tag.segments [i];
+		const char* s = NULL;
+		size_t length = 0;
+		if (segment->reference == 0)
 		{
-			const int dig = *p - '0';
-			if (0 < dig  &&  dig < nmatch  &&  pmatch [dig].rm_so != -1)
-			{
-				const int diglen = pmatch [dig].rm_eo - pmatch [dig].rm_so;
-				vStringNCatS (result, in + pmatch [dig].rm_so, diglen);
-			}
+			s = patbuf->u.tag.name_text + segment->start;
+			length = segment->length;
+		}
+		else if (pmatch [segment->reference].rm_so != -1)
+		{
+			const regmatch_t* const m = &pmatch [segment->reference];
+			s = line + m->rm_so;
+			length = m->rm_eo - m->rm_so;
 		}
-		else if (*p != '\n'  &&  *p != '\r')
-			vStringPut (result, *p);
+		while (vStringLength (name) == 0  &&  length > 0  &&
+			   isspace ((int) *s))
+		{
+			++s;
+			--length;
+		}
+		if (length > 0)
+			vStringNCatS (name, s, length);
 	}
-	vStringTerminate (result);
-	return result;
+	if (vStringLength (name) > 0)
+		vStringStripTrailing (name);
 }
 
 static void matchTagPattern (const vString* const line,
 		const regexPattern* const patbuf,
 		const regmatch_t* const pmatch)
 {
-	vString *const name = substitute (vStringValue (line),
-			patbuf->u.tag.name_pattern, BACK_REFERENCE_COUNT, pmatch);
-	vStringStripLeading (name);
-	vStringStripTrailing (name);
-	if (vStringLength (name) > 0)
-		makeRegexTag (name, &patbuf->u.tag.kind);
+	if (TagName == NULL)
+		TagName = vStringNew ();
+	expandName (TagName, vStringValue (line), patbuf, pmatch);
+	if (vStringLength (TagName) > 0)
+		makeRegexTag (TagName, &patbuf->u.tag.kind, 0, NULL);
 	else
 		error (WARNING, "%s:%ld: null expansion of name pattern \"%s\"",
 			getInputFileName (), getInputLineNumber (),
 			patbuf->u.tag.name_pattern);
-	vStringDelete (name);
 }
 
 static void matchCallbackPattern (
@@ -483,14 +1048,133 @@ static void matchCallbackPattern (
 	patbuf->u.callback.function (vStringValue (line), matches, count);
 }
 
+#ifdef HAVE_PCRE2
+
+/*  Matches the "length" characters of "text" from "start" against "pattern"
+ *  compiled by PCRE2, reporting the subexpressions matched in "pmatch" as
+ *  regexec() would, so that they are substituted alike.
+ */
+static boolean matchPerlRegex (const compiledRegex* const pattern,
+		const char* const text, const size_t start, const size_t length,
+		regmatch_t* const pmatch)
+{
+	const int count = pcre2_match (pattern->perl, (PCRE2_SPTR) text, length,
+			start, 0, pattern->data, NULL);
+	int i;
+	if (count >= 0)
+	{
+		const PCRE2_SIZE* const ovector =
+				pcre2_get_ovector_pointer (pattern->data);
+		const int pairs = (int) pcre2_get_ovector_count (pattern->data);
+		for (i = 0  ;  i < BACK_REFERENCE_COUNT  ;  ++i)
+		{
+			if (i < pairs  &&  ovector [2 * i] != PCRE2_UNSET)
+			{
+				pmatch [i].rm_so = (regoff_t) ovector [2 * i];
+				pmatch [i].rm_eo = (regoff_t) ovector [2 * i + 1];
+			}
+			else
+			{
+				pmatch [i].rm_so = -1;
+				pmatch [i].rm_eo = -1;
+			}
+		}
+	}
+	return (boolean) (count >= 0);
+}
+
+#endif
+
+/*  Matches the "length" characters of "text", which are null terminated,
+ *  from "start" against "pattern", reporting in "pmatch" subexpressions
+ *  matched at offsets from "text". A match from "start" begins a line only
+ *  if "text" has a newline before it.
+ */
+static boolean execPattern (const compiledRegex* const pattern,
+		const char* const text, const size_t start, const size_t length,
+		regmatch_t* const pmatch)
+{
+	boolean result;
+#ifdef HAVE_PCRE2
+	if (pattern->perl != NULL)
+		result = matchPerlRegex (pattern, text, start, length, pmatch);
+	else
+#endif
+#ifdef REG_STARTEND
+	{
+		/*  Spares regexec() finding the length of the rest of the text,
+		 *  which is long for a multi-line pattern.
+		 */
+		pmatch [0].rm_so = (regoff_t) start;
+		pmatch [0].rm_eo = (regoff_t) length;
+		result = (boolean) (regexec (pattern->posix, text,
+				BACK_REFERENCE_COUNT, pmatch, REG_STARTEND) == 0);
+	}
+#else
+	{
+		const int eflags =
+				(start > 0  &&  text [start - 1] != '\n') ? REG_NOTBOL : 0;
+		result = (boolean) (regexec (pattern->posix, text + start,
+				BACK_REFERENCE_COUNT, pmatch, eflags) == 0);
+		if (result)
+		{
+			int i;
+			for (i = 0  ;  i < BACK_REFERENCE_COUNT  ;  ++i)
+			{
+				if (pmatch [i].rm_so != -1)
+				{
+					pmatch [i].rm_so += start;
+					pmatch [i].rm_eo += start;
+				}
+			}
+		}
+	}
+#endif
+	return result;
+}
+
+/*  Matches "patbuf" as execPattern() does, adding the cost of doing so on
+ *  line "lineNumber" to its profile where --profile-regex is in effect.
+ */
+static boolean tryPattern (regexPattern* const patbuf,
+		const char* const text, const size_t start, const size_t length,
+		regmatch_t* const pmatch, const unsigned long lineNumber)
+{
+	boolean result;
+	if (patbuf->broken)
+		result = FALSE;
+	else if (! Option.profileRegex)
+		result = execPattern (&patbuf->pattern, text, start, length, pmatch);
+	else
+	{
+		regexProfile* const profile = &patbuf->profile;
+		const double begin = elapsedTime ();
+		double seconds;
+		result = execPattern (&patbuf->pattern, text, start, length, pmatch);
+		seconds = elapsedTime () - begin;
+		++profile->calls;
+		if (result)
+			++profile->hits;
+		profile->seconds += seconds;
+		if (profile->calls == 1  ||  seconds > profile->worst)
+		{
+			if (profile->worstFile == NULL)
+				profile->worstFile = vStringNew ();
+			vStringCopyS (profile->worstFile, getInputFileName ());
+			profile->worst = seconds;
+			profile->worstLine = lineNumber;
+		}
+	}
+	return result;
+}
+
 static boolean matchRegexPattern (const vString* const line,
-		const regexPattern* const patbuf)
+		regexPattern* const patbuf)
 {
 	boolean result = FALSE;
 	regmatch_t pmatch [BACK_REFERENCE_COUNT];
-	const int match = regexec (patbuf->pattern, vStringValue (line),
-							   BACK_REFERENCE_COUNT, pmatch, 0);
-	if (match == 0)
+	if (tryPattern (patbuf, vStringValue (line), 0, vStringLength (line),
+			pmatch, getInputLineNumber ()))
 	{
 		result = TRUE;
 		if (patbuf->type == PTRN_TAG)
@@ -506,12 +1190,225 @@ static boolean matchRegexPattern (const vString* const line,
 	return result;
 }
 
+/*  Finds the literal required by each pattern of "set", sharing each among
+ *  all the patterns requiring it.
+ */
+static void makeLiterals (patternSet* const set)
+{
+	unsigned int i, j;
+
+	set->literals = xMalloc (set->count, requiredLiteral);
+	for (i = 0  ;  i < set->count  ;  ++i)
+	{
+		regexPattern* const p = &set->patterns [i];
+		const boolean folded = (boolean) ((p->cflags & REG_ICASE) != 0);
+		const vString* const literal = p->required;
+		for (j = 0  ;  vStringLength (literal) > 0  &&  p->literal < 0  &&
+					j < set->literalCount  ;  ++j)
+		{
+			const requiredLiteral* const l = &set->literals [j];
+			if (l->folded == folded  &&
+				strcmp (vStringValue (l->text), vStringValue (literal)) == 0)
+				p->literal = (int) j;
+		}
+		if (vStringLength (literal) > 0  &&  p->literal < 0)
+		{
+			requiredLiteral* const l = &set->literals [set->literalCount];
+			l->text = vStringNewCopy (literal);
+			l->folded = folded;
+			l->found = FALSE;
+			if (folded)
+				set->foldedLiterals = TRUE;
+			p->literal = (int) set->literalCount++;
+		}
+	}
+}
+
+/*  Joins the filterable patterns of "set" compiled with the same flags,
+ *  where there are at least two, into a filter compiled without
+ *  subexpression reporting, which is all that is wanted of it.
+ */
+static void makeFilters (patternSet* const set)
+{
+	vString* const alternatives = vStringNew ();
+	unsigned int i, j;
+
+	set->filters = xMalloc (set->count, regexFilter);
+	for (i = 0  ;  i < set->count  ;  ++i)
+	{
+		regexPattern* const p = &set->patterns [i];
+		unsigned int members = 0;
+		if (p->source != NULL  &&  p->filter < 0)
+		{
+			vStringClear (alternatives);
+			for (j = i  ;  j < set->count  ;  ++j)
+			{
+				const regexPattern* const q = &set->patterns [j];
+				if (q->source != NULL  &&  q->cflags == p->cflags)
+				{
+					if (members++ > 0)
+						vStringPut (alternatives, '|');
+					vStringPut (alternatives, '(');
+					vStringCatS (alternatives, q->source);
+					vStringPut (alternatives, ')');
+				}
+			}
+		}
+		if (members > 1)
+		{
+			regexFilter* const filter = &set->filters [set->filterCount];
+			if (regcomp (&filter->pattern, vStringValue (alternatives),
+						 p->cflags | REG_NOSUB) == 0)
+			{
+				filter->cflags = p->cflags;
+				for (j = i  ;  j < set->count  ;  ++j)
+				{
+					regexPattern* const q = &set->patterns [j];
+					if (q->source != NULL  &&  q->cflags == p->cflags)
+						q->filter = (int) set->filterCount;
+				}
+				++set->filterCount;
+			}
+		}
+	}
+	vStringDelete (alternatives);
+}
+
+static void prepareSet (patternSet* const set)
+{
+	unsigned int i;
+	for (i = 0  ;  i < set->count  ;  ++i)
+	{
+		if (! set->patterns [i].compiled)
+			compilePattern (&set->patterns [i]);
+	}
+	clearPrepared (set);
+	if (! Option.profileRegex)
+		makeFilters (set);  /* which would hide the cost of each pattern */
+	makeLiterals (set);
+	set->prepared = TRUE;
+}
+
+/*  Does "text" contain the "length" characters at "literal"?
+ */
+static boolean containsLiteral (const vString* const text,
+		const char* const literal, const size_t length)
+{
+	const char* p = vStringValue (text);
+	const char* const last = p + vStringLength (text);
+	boolean result = FALSE;
+	while (! result  &&  (size_t) (last - p) >= length  &&
+		   (p = memchr (p, literal [0], (last - p) - length + 1)) != NULL)
+	{
+		if (memcmp (p, literal, length) == 0)
+			result = TRUE;
+		else
+			++p;
+	}
+	return result;
+}
+
+/*  Notes which of the literals of "set" are contained in "line".
+ */
+static void findLiterals (patternSet* const set, const vString* const line)
+{
+	unsigned int i;
+	if (set->foldedLiterals)
+	{
+		const char* p;
+		if (FoldedLine == NULL)
+			FoldedLine = vStringNew ();
+		vStringClear (FoldedLine);
+		for (p = vStringValue (line)  ;  *p != '\0'  ;  ++p)
+			vStringPut (FoldedLine, tolower ((unsigned char) *p));
+		vStringTerminate (FoldedLine);
+	}
+	for (i = 0  ;  i < set->literalCount  ;  ++i)
+	{
+		requiredLiteral* const l = &set->literals [i];
+		l->found = containsLiteral (l->folded ? FoldedLine : line,
+				vStringValue (l->text), vStringLength (l->text));
+	}
+}
+
+/*  Can "p" match the line for which literals were last found?
+ */
+static boolean isCandidate (const patternSet* const set,
+		const regexPattern* const p)
+{
+	return (boolean) (! p->pattern.multiline  &&
+			(p->literal < 0  ||  set->literals [p->literal].found));
+}
+
+/*  Advances "lineStart" and "lineNumber", which describe a line of
+ *  "contents", to the line containing "offset".
+ */
+static void advanceLine (const char* const contents, const size_t offset,
+		size_t* const lineStart, unsigned long* const lineNumber)
+{
+	const char* newline;
+	while ((newline = memchr (contents + *lineStart, '\n',
+			offset - *lineStart)) != NULL)
+	{
+		*lineStart = newline - contents + 1;
+		++*lineNumber;
+	}
+}
+
+/*  Makes a tag for each match of "patbuf" in "text", the contents of the
+ *  whole input file. Matches are found in order through the file, so the
+ *  line of each is found by counting the newlines since the one before.
+ */
+static void matchMultilinePattern (const vString* const text,
+		regexPattern* const patbuf)
+{
+	const char* const contents = vStringValue (text);
+	const size_t length = vStringLength (text);
+	regmatch_t pmatch [BACK_REFERENCE_COUNT];
+	size_t start = 0;
+	size_t lineStart = 0;
+	unsigned long lineNumber = 1;
+
+	while (start <= length  &&
+		   tryPattern (patbuf, contents, start, length, pmatch, lineNumber))
+	{
+		const size_t matchStart = pmatch [0].rm_so;
+		const size_t matchEnd = pmatch [0].rm_eo;
+		advanceLine (contents, matchStart, &lineStart, &lineNumber);
+		expandName (TagName, contents, patbuf, pmatch);
+		if (vStringLength (TagName) > 0)
+		{
+			fpos_t position;
+			fileOffsetPosition (lineStart, &position);
+			makeRegexTag (TagName, &patbuf->u.tag.kind, lineNumber, &position);
+		}
+		else
+			error (WARNING, "%s:%lu: null expansion of name pattern \"%s\"",
+				getInputFileName (), lineNumber, patbuf->u.tag.name_pattern);
+		start = (matchEnd > matchStart) ? matchEnd : matchStart + 1;
+		if (start <= length)
+			advanceLine (contents, start, &lineStart, &lineNumber);
+	}
+}
+
 #endif
 
 /* PUBLIC INTERFACE */
 
+/*  Determines whether any patterns are defined for "language", so that each
+ *  of its lines must be matched against them.
+ */
+extern boolean hasRegexPatterns (const langType language)
+{
+	return (boolean) (language != LANG_IGNORE  &&  language <= SetUpper  &&
+			Sets [language].count > 0);
+}
+
 /* Match against all patterns for specified language. Returns true if at least
- * on pattern matched.
+ * on pattern matched. The line is first searched for the literals which the
+ * patterns require, then each filter of the language joining any pattern
+ * whose literal was found is tried, so that a pattern is tried only if it
+ * can match.
  */
 extern boolean matchRegex (const vString* const line, const langType language)
 {
@@ -519,15 +1416,86 @@ extern boolean matchRegex (const vString* const line, const langType language)
 	if (language != LANG_IGNORE  &&  language <= SetUpper  &&
 		Sets [language].count > 0)
 	{
-		const patternSet* const set = Sets + language;
+		patternSet* const set = Sets + language;
 		unsigned int i;
+		TracePoint2 (regex__match, vStringValue (line), language);
+		PushMemoryAccount (MEMORY_REGEX);
+		if (! set->prepared)
+			prepareSet (set);
+		findLiterals (set, line);
+		for (i = 0  ;  i < set->filterCount  ;  ++i)
+			set->filters [i].matched = FALSE;
 		for (i = 0  ;  i < set->count  ;  ++i)
-			if (matchRegexPattern (line, set->patterns + i))
+		{
+			const regexPattern* const p = set->patterns + i;
+			if (p->filter >= 0  &&  isCandidate (set, p))
+				set->filters [p->filter].matched = TRUE;
+		}
+		for (i = 0  ;  i < set->filterCount  ;  ++i)
+		{
+			regexFilter* const filter = &set->filters [i];
+			if (filter->matched)
+				filter->matched = (boolean) (regexec (&filter->pattern,
+						vStringValue (line), 0, NULL, 0) == 0);
+		}
+		for (i = 0  ;  i < set->count  ;  ++i)
+		{
+			regexPattern* const p = set->patterns + i;
+			if (isCandidate (set, p)  &&
+				(p->filter < 0  ||  set->filters [p->filter].matched)  &&
+				matchRegexPattern (line, p))
 				result = TRUE;
+		}
+		PopMemoryAccount ();
 	}
 	return result;
 }
 
+/*  Matches the multi-line patterns of the language against the whole input
+ *  file, which is read once for all of them.
+ */
+extern void matchMultilineRegex (const langType language)
+{
+	if (language != LANG_IGNORE  &&  language <= SetUpper)
+	{
+		patternSet* const set = Sets + language;
+		boolean read = FALSE;
+		boolean unreadable = FALSE;
+		unsigned int i;
+		if (! set->prepared)
+			prepareSet (set);
+		for (i = 0  ;  i < set->count  &&  ! unreadable  ;  ++i)
+		{
+			regexPattern* const p = set->patterns + i;
+			if (p->pattern.multiline  &&  p->type == PTRN_TAG  &&
+				p->u.tag.kind.enabled)
+			{
+				if (! read)
+				{
+					if (Contents == NULL)
+						Contents = vStringNew ();
+					if (TagName == NULL)
+						TagName = vStringNew ();
+					unreadable = (boolean) ! fileReadContents (Contents);
+					read = TRUE;
+				}
+				if (! unreadable)
+					matchMultilinePattern (Contents, p);
+			}
+		}
+	}
+}
+
+/*  Compiles the patterns of a language, when its first file is to be parsed,
+ *  so that any worker processes matching them need not each do so.
+ */
+extern void prepareRegex (const langType language)
+{
+	if (language <= SetUpper  &&  ! Sets [language].prepared  &&
+		Sets [language].count > 0)
+		prepareSet (Sets + language);
+}
+
 extern void findRegexTags (void)
 {
 	/* merely read all lines of the file */
@@ -549,16 +1517,15 @@ extern void addTagRegex (
 	Assert (name != NULL);
 	if (! regexBroken)
 	{
-		regex_t* const cp = compileRegex (regex, flags);
-		if (cp != NULL)
-		{
-			char kind;
-			char* kindName;
-			char* description;
-			parseKinds (kinds, &kind, &kindName, &description);
-			addCompiledTagPattern (language, cp, eStrdup (name),
-					kind, kindName, description);
-		}
+		int cflags;
+		compiledRegex compiled;
+		char kind;
+		char* kindName;
+		char* description;
+		readRegexFlags (regex, flags, &cflags, &compiled);
+		parseKinds (kinds, &kind, &kindName, &description);
+		addCompiledTagPattern (language, &compiled, regex, cflags, eStrdup (name),
+				kind, kindName, description);
 	}
 #endif
 }
@@ -573,9 +1540,17 @@ extern void addCallbackRegex (
 	Assert (regex != NULL);
 	if (! regexBroken)
 	{
-		regex_t* const cp = compileRegex (regex, flags);
-		if (cp != NULL)
-			addCompiledCallbackPattern (language, cp, callback);
+		int cflags;
+		compiledRegex compiled;
+		readRegexFlags (regex, flags, &cflags, &compiled);
+		if (compiled.multiline)
+		{
+			error (WARNING, "regex flag '{mline}' ignored for callback %s",
+					regex);
+			compiled.multiline = FALSE;
+		}
+		addCompiledCallbackPattern (language, &compiled, regex, cflags,
+				callback);
 	}
 #endif
 }
@@ -684,6 +1659,194 @@ extern void freeRegexResources (void)
 		eFree (Sets);
 	Sets = NULL;
 	SetUpper = -1;
+	if (FoldedLine != NULL)
+		vStringDelete (FoldedLine);
+	FoldedLine = NULL;
+	if (TagName != NULL)
+		vStringDelete (TagName);
+	TagName = NULL;
+	if (Contents != NULL)
+		vStringDelete (Contents);
+	Contents = NULL;
+#endif
+}
+
+/*  Forgets the cost of trying each pattern so far, so that what a worker
+ *  process reports is only what it adds.
+ */
+extern void clearRegexProfile (void)
+{
+#ifdef HAVE_REGEX
+	int i;
+	unsigned int j;
+	for (i = 0  ;  i <= SetUpper  ;  ++i)
+	{
+		for (j = 0  ;  j < Sets [i].count  ;  ++j)
+		{
+			regexProfile* const profile = &Sets [i].patterns [j].profile;
+			profile->calls = 0;
+			profile->hits = 0;
+			profile->seconds = 0.0;
+			profile->worst = 0.0;
+			profile->worstLine = 0;
+		}
+	}
+#endif
+}
+
+/*  Writes the profile of each pattern which has been tried to "fp", for
+ *  readRegexProfile() in another process.
+ */
+extern void writeRegexProfile (FILE *const fp __unused__)
+{
+#ifdef HAVE_REGEX
+	boolean ok = TRUE;
+	profileRecord record;
+	int i;
+	unsigned int j;
+	for (i = 0  ;  i <= SetUpper  ;  ++i)
+	{
+		for (j = 0  ;  j < Sets [i].count  ;  ++j)
+		{
+			const regexProfile* const profile = &Sets [i].patterns [j].profile;
+			if (profile->calls > 0)
+			{
+				memset (&record, 0, sizeof (record));
+				record.language = i;
+				record.index = j;
+				record.calls = profile->calls;
+				record.hits = profile->hits;
+				record.seconds = profile->seconds;
+				record.worst = profile->worst;
+				record.worstLine = profile->worstLine;
+				record.worstFileLength = vStringLength (profile->worstFile);
+				if (fwrite (&record, sizeof (record), 1, fp) != 1  ||
+					fwrite (vStringValue (profile->worstFile), 1,
+							record.worstFileLength, fp) !=
+						record.worstFileLength)
+					ok = FALSE;
+			}
+		}
+	}
+	memset (&record, 0, sizeof (record));
+	record.language = -1;
+	if (fwrite (&record, sizeof (record), 1, fp) != 1)
+		ok = FALSE;
+	if (! ok)
+		error (FATAL | PERROR, "cannot write regex profile");
+#endif
+}
+
+/*  Adds the profiles written by writeRegexProfile() to "fp" to those of
+ *  our own patterns, returning whether they were read.
+ */
+extern boolean readRegexProfile (FILE *const fp __unused__)
+{
+	boolean ok = TRUE;
+#ifdef HAVE_REGEX
+	boolean done = FALSE;
+	profileRecord record;
+	while (ok  &&  ! done)
+	{
+		if (fread (&record, sizeof (record), 1, fp) != 1)
+			ok = FALSE;
+		else if (record.language < 0)
+			done = TRUE;
+		else if (record.language > SetUpper  ||
+				 record.index >= Sets [record.language].count)
+			ok = FALSE;
+		else
+		{
+			regexProfile* const profile =
+					&Sets [record.language].patterns [record.index].profile;
+			const boolean worse = (boolean)
+					(profile->calls == 0  ||  record.worst > profile->worst);
+			if (profile->worstFile == NULL)
+				profile->worstFile = vStringNew ();
+			if (worse)
+			{
+				vStringClear (profile->worstFile);
+				profile->worst = record.worst;
+				profile->worstLine = record.worstLine;
+			}
+			profile->calls += record.calls;
+			profile->hits += record.hits;
+			profile->seconds += record.seconds;
+			for (  ;  ok  &&  record.worstFileLength > 0  ;
+				 --record.worstFileLength)
+			{
+				const int c = getc (fp);
+				if (c == EOF)
+					ok = FALSE;
+				else if (worse)
+					vStringPut (profile->worstFile, c);
+			}
+			vStringTerminate (profile->worstFile);
+		}
+	}
+#endif
+	return ok;
+}
+
+#ifdef HAVE_REGEX
+static int compareProfiles (const void *const one, const void *const two)
+{
+	const regexProfile* const a = &((const profileEntry*) one)->pattern->profile;
+	const regexProfile* const b = &((const profileEntry*) two)->pattern->profile;
+	int result;
+	if (a->seconds != b->seconds)
+		result = (a->seconds < b->seconds) ? 1 : -1;
+	else if (a->calls != b->calls)
+		result = (a->calls < b->calls) ? 1 : -1;
+	else
+		result = 0;
+	return result;
+}
+#endif
+
+/*  Prints the cost of trying each pattern, most costly first, for
+ *  --profile-regex.
+ */
+extern void printRegexProfile (void)
+{
+#ifdef HAVE_REGEX
+	profileEntry* entries;
+	unsigned int count = 0;
+	unsigned int i, j;
+	int language;
+	for (language = 0  ;  language <= SetUpper  ;  ++language)
+		count += Sets [language].count;
+	if (count > 0)
+	{
+		entries = xMalloc (count, profileEntry);
+		i = 0;
+		for (language = 0  ;  language <= SetUpper  ;  ++language)
+		{
+			for (j = 0  ;  j < Sets [language].count  ;  ++j)
+			{
+				entries [i].language = language;
+				entries [i].pattern = &Sets [language].patterns [j];
+				++i;
+			}
+		}
+		qsort (entries, count, sizeof (profileEntry), compareProfiles);
+		fprintf (errout, "%9s %10s %10s %10s  %s\n",
+				"seconds", "calls", "hits", "worst ms", "pattern");
+		for (i = 0  ;  i < count  ;  ++i)
+		{
+			const regexPattern* const p = entries [i].pattern;
+			const regexProfile* const profile = &p->profile;
+			fprintf (errout, "%9.4f %10lu %10lu %10.3f  %s: /%s/",
+					profile->seconds, profile->calls, profile->hits,
+					profile->worst * 1000.0,
+					getLanguageName (entries [i].language), p->regexp);
+			if (profile->calls > 0)
+				fprintf (errout, " at %s:%lu",
+						vStringValue (profile->worstFile), profile->worstLine);
+			fputc ('\n', errout);
+		}
+		eFree (entries);
+	}
 #endif
 }
 
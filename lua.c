@@ -32,6 +32,9 @@ static kindOption LuaKinds [] = {
 	{ TRUE, 'f', "function", "functions" }
 };
 
+static const char *const LuaTriggerWords [] = { "function", NULL };
+static lineTriggers LuaTriggers = { LuaTriggerWords, 0, 0, { 0 } };
+
 /*
 *   FUNCTION DEFINITIONS
 */
@@ -94,7 +97,7 @@ static void findLuaTags (void)
 	vString *name = vStringNew ();
 	const unsigned char *line;
 
-	while ((line = fileReadLine ()) != NULL)
+	while ((line = fileReadLineContaining (&LuaTriggers)) != NULL)
 	{
 		const char *p, *q;
 
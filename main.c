@@ -76,12 +76,22 @@
 #endif
 
 
+#include "cache.h"
+#include "daemon.h"
 #include "debug.h"
+#include "gitindex.h"
+#include "jobs.h"
 #include "keyword.h"
 #include "main.h"
+#include "manifest.h"
 #include "options.h"
+#include "parse.h"
 #include "read.h"
 #include "routines.h"
+#include "server.h"
+#include "sort.h"
+#include "strlist.h"
+#include "synthetic.h"
 
 /*
 *   MACROS
@@ -104,11 +114,6 @@ static struct { long files, lines, bytes; } Totals = { 0, 0, 0 };
   " "AUTHOR_NAME" $";
 #endif
 
-/*
-*   FUNCTION PROTOTYPES
-*/
-static boolean createTagsForEntry (const char *const entryName);
-
 /*
 *   FUNCTION DEFINITIONS
 */
@@ -122,11 +127,20 @@ extern void addTotals (
 	Totals.bytes += bytes;
 }
 
+extern void getTotals (
+		long unsigned int *const files, long unsigned int *const lines,
+		long unsigned int *const bytes)
+{
+	*files = Totals.files;
+	*lines = Totals.lines;
+	*bytes = Totals.bytes;
+}
+
 extern boolean isDestinationStdout (void)
 {
 	boolean toStdout = FALSE;
 
-	if (Option.xref  ||  Option.filter  ||
+	if (Option.xref  ||  Option.json  ||  Option.filter  ||  Option.server  ||
 		(Option.tagFileName != NULL  &&  (strcmp (Option.tagFileName, "-") == 0
 #if defined (VMS)
 	|| strcmp (Option.tagFileName, "sys$output") == 0
@@ -138,7 +152,41 @@ extern boolean isDestinationStdout (void)
 	return toStdout;
 }
 
+/*  The rest of this module, which finds the files to tag and starts up
+ *  ctags, is left out of the library libctags.
+ */
+#ifndef CTAGS_LIBRARY
+
+static boolean createTagsForEntry (const char *const entryName);
+static boolean createTagsForRegularFile (
+		const char *const fileName, const fileStatus *const status);
+static boolean scanDirectory (const char *const dirName);
+
 #if defined (HAVE_OPENDIR)
+/*  Where readdir () reports the type of an entry, regular files and
+ *  directories are handled without a call to stat (), which is costly on
+ *  network file systems.
+ */
+static boolean createTagsForDirectoryEntry (
+		const char *const entryName, const struct dirent *const entry)
+{
+	boolean resize = FALSE;
+#if defined (DT_REG) && defined (DT_DIR)
+	if (entry->d_type == DT_REG  ||  entry->d_type == DT_DIR)
+	{
+		if (isExcludedFile (entryName))
+			verbose ("excluding \"%s\"\n", entryName);
+		else if (entry->d_type == DT_DIR)
+			resize = scanDirectory (entryName);
+		else
+			resize = createTagsForRegularFile (entryName, NULL);
+	}
+	else
+#endif
+		resize = createTagsForEntry (entryName);
+	return resize;
+}
+
 static boolean recurseUsingOpendir (const char *const dirName)
 {
 	boolean resize = FALSE;
@@ -147,21 +195,26 @@ static boolean recurseUsingOpendir (const char *const dirName)
 		error (WARNING | PERROR, "cannot recurse into directory \"%s\"", dirName);
 	else
 	{
+		/*  The path of each entry is built on that of the directory, which
+		 *  is worked out only once.
+		 */
+		vString *const filePath = strcmp (dirName, ".") == 0 ?
+				vStringNew () : combinePathAndFile (dirName, "");
+		const size_t dirLength = vStringLength (filePath);
 		struct dirent *entry;
 		while ((entry = readdir (dir)) != NULL)
 		{
 			if (strcmp (entry->d_name, ".") != 0  &&
 				strcmp (entry->d_name, "..") != 0)
 			{
-				vString *filePath;
-				if (strcmp (dirName, ".") == 0)
-					filePath = vStringNewInit (entry->d_name);
-				else
-					filePath = combinePathAndFile (dirName, entry->d_name);
-				resize |= createTagsForEntry (vStringValue (filePath));
-				vStringDelete (filePath);
+				vStringChar (filePath, dirLength) = '\0';
+				vStringSetLength (filePath);
+				vStringCatS (filePath, entry->d_name);
+				resize |= createTagsForDirectoryEntry (
+						vStringValue (filePath), entry);
 			}
 		}
+		vStringDelete (filePath);
 		closedir (dir);
 	}
 	return resize;
@@ -244,16 +297,16 @@ static boolean createTagsForAmigaWildcard (const char *const pattern)
 }
 #endif
 
-static boolean recurseIntoDirectory (const char *const dirName)
+static boolean scanDirectory (const char *const dirName)
 {
 	boolean resize = FALSE;
-	if (isRecursiveLink (dirName))
-		verbose ("ignoring \"%s\" (recursive link)\n", dirName);
-	else if (! Option.recurse)
+	if (! Option.recurse)
 		verbose ("ignoring \"%s\" (directory)\n", dirName);
 	else
 	{
 		verbose ("RECURSING into directory \"%s\"\n", dirName);
+		if (Option.daemon)
+			watchDirectory (dirName);
 #if defined (HAVE_OPENDIR)
 		resize = recurseUsingOpendir (dirName);
 #elif defined (HAVE_FINDFIRST) || defined (HAVE__FINDFIRST)
@@ -283,26 +336,90 @@ static boolean recurseIntoDirectory (const char *const dirName)
 	return resize;
 }
 
+static boolean recurseIntoDirectory (const char *const dirName)
+{
+	boolean resize = FALSE;
+	if (isRecursiveLink (dirName))
+		verbose ("ignoring \"%s\" (recursive link)\n", dirName);
+	else
+		resize = scanDirectory (dirName);
+	return resize;
+}
+
+/*  Tags a regular file, whose status is supplied if it has been looked up
+ *  already, or is otherwise NULL.
+ */
+static boolean createTagsForRegularFile (
+		const char *const fileName, const fileStatus *const status)
+{
+	boolean resize = FALSE;
+	if (! isFileInShard (fileName))
+		verbose ("ignoring \"%s\" (other shard)\n", fileName);
+	else if (Option.incremental  &&  isFileUpToDate (fileName))
+		verbose ("skipping \"%s\" (unchanged)\n", fileName);
+	else if (jobsEnabled ())
+		queueFileForTagging (fileName, status);
+	else if (readAheadEnabled ())
+		resize = tagFileReadingAhead (fileName);
+	else
+		resize = parseFile (fileName);
+	return resize;
+}
+
 static boolean createTagsForEntry (const char *const entryName)
 {
 	boolean resize = FALSE;
-	fileStatus *status = eStat (entryName);
 
 	Assert (entryName != NULL);
 	if (isExcludedFile (entryName))
 		verbose ("excluding \"%s\"\n", entryName);
-	else if (status->isSymbolicLink  &&  ! Option.followLinks)
-		verbose ("ignoring \"%s\" (symbolic link)\n", entryName);
-	else if (! status->exists)
-		error (WARNING | PERROR, "cannot open source file \"%s\"", entryName);
-	else if (status->isDirectory)
-		resize = recurseIntoDirectory (entryName);
-	else if (! status->isNormalFile)
-		verbose ("ignoring \"%s\" (special file)\n", entryName);
 	else
-		resize = parseFile (entryName);
+	{
+		fileStatus *status = eStat (entryName);
+
+		if (status->isSymbolicLink  &&  ! Option.followLinks)
+			verbose ("ignoring \"%s\" (symbolic link)\n", entryName);
+		else if (! status->exists)
+			error (WARNING | PERROR, "cannot open source file \"%s\"",
+					entryName);
+		else if (status->isDirectory)
+			resize = recurseIntoDirectory (entryName);
+		else if (! status->isNormalFile)
+			verbose ("ignoring \"%s\" (special file)\n", entryName);
+		else
+			resize = createTagsForRegularFile (entryName, status);
+
+		eStatFree (status);
+	}
+	return resize;
+}
+
+/*  Files named by the git index (see --git-files) are known to be regular
+ *  files or symbolic links, so that only links need a call to stat (). As
+ *  no directories are visited, those excluded are checked for in the name
+ *  of each file.
+ */
+static boolean createTagsForGitFile (
+		const char *const fileName, const boolean isLink)
+{
+	vString *const directory = vStringNew ();
+	boolean excluded = isExcludedFile (fileName);
+	boolean resize = FALSE;
+	const char *p;
 
-	eStatFree (status);
+	for (p = strchr (fileName, '/')  ;  p != NULL  &&  ! excluded  ;
+		 p = strchr (p + 1, '/'))
+	{
+		vStringNCopyS (directory, fileName, p - fileName);
+		excluded = isExcludedFile (vStringValue (directory));
+	}
+	if (excluded)
+		verbose ("excluding \"%s\"\n", fileName);
+	else if (isLink)
+		resize = createTagsForEntry (fileName);
+	else
+		resize = createTagsForRegularFile (fileName, NULL);
+	vStringDelete (directory);
 	return resize;
 }
 
@@ -332,6 +449,33 @@ static boolean createTagsForWildcardArg (const char *const arg)
 
 #endif
 
+/*  Files queued for tagging by parallel jobs, or waiting while they are
+ *  read ahead, must be tagged before any following options take effect.
+ */
+/*  Tags a file or directory named explicitly. In daemon mode, a source file
+ *  so named is then watched for changes, as is each directory recursed into.
+ */
+static boolean createTagsForNamedEntry (const char *const entryName)
+{
+	const boolean resize = createTagsForEntry (entryName);
+	if (Option.daemon  &&  ! isExcludedFile (entryName))
+	{
+		fileStatus *const status = eStat (entryName);
+		if (status->exists  &&  status->isNormalFile)
+			watchFile (entryName);
+		eStatFree (status);
+	}
+	return resize;
+}
+
+static boolean tagQueuedFilesBeforeOptions (cookedArgs *const args)
+{
+	boolean resize = FALSE;
+	if (! cArgOff (args)  &&  cArgIsOption (args))
+		resize = tagQueuedFiles ();
+	return resize;
+}
+
 static boolean createTagsForArgs (cookedArgs *const args)
 {
 	boolean resize = FALSE;
@@ -345,11 +489,13 @@ static boolean createTagsForArgs (cookedArgs *const args)
 #ifdef MANUAL_GLOBBING
 		resize |= createTagsForWildcardArg (arg);
 #else
-		resize |= createTagsForEntry (arg);
+		resize |= createTagsForNamedEntry (arg);
 #endif
 		cArgForth (args);
+		resize |= tagQueuedFilesBeforeOptions (args);
 		parseOptions (args);
 	}
+	resize |= tagQueuedFiles ();
 	return resize;
 }
 
@@ -364,7 +510,7 @@ static boolean createTagsFromFileInput (FILE *const fp, const boolean filter)
 		parseOptions (args);
 		while (! cArgOff (args))
 		{
-			resize |= createTagsForEntry (cArgItem (args));
+			resize |= createTagsForNamedEntry (cArgItem (args));
 			if (filter)
 			{
 				if (Option.filterTerminator != NULL)
@@ -372,8 +518,10 @@ static boolean createTagsFromFileInput (FILE *const fp, const boolean filter)
 				fflush (stdout);
 			}
 			cArgForth (args);
+			resize |= tagQueuedFilesBeforeOptions (args);
 			parseOptions (args);
 		}
+		resize |= tagQueuedFiles ();
 		cArgDelete (args);
 	}
 	return resize;
@@ -455,12 +603,151 @@ static void printTotals (const clock_t *const timeStamps)
 		fputc ('\n', errout);
 	}
 
+	fprintf (errout, "%lu memory allocation%s\n",
+			allocationCount (), plural (allocationCount ()));
+	if (peakResidentSize () > 0)
+		fprintf (errout, "%lu kB peak resident\n", peakResidentSize ());
+	printMemoryTotals (errout);
+	printLanguageRescans ();
+	printJobTotals ();
+
 #ifdef DEBUG
 	fprintf (errout, "longest tag line = %lu\n",
 			(unsigned long) TagFile.max.line);
 #endif
 }
 
+/*  Prints the totals as a JSON object, for --totals=json. Times are wall
+ *  clock seconds, but for those named "cpu". The "scan" phase, in which
+ *  files are found and tagged, includes the time spent parsing them, which
+ *  is also summed as "parse"; the "sort" phase is that in which the tag
+ *  file is sorted and written.
+ */
+static void printTotalsJson (const double *const wallStamps)
+{
+	FILE *const fp = errout;
+	const double scan = wallStamps [1] - wallStamps [0];
+	languageTotals sum;
+
+	sumLanguageTotals (&sum);
+	fputs ("{\n", fp);
+	fprintf (fp, "  \"files\": %ld,\n  \"lines\": %ld,\n  \"bytes\": %ld,\n",
+			Totals.files, Totals.lines, Totals.bytes);
+	fprintf (fp, "  \"tags\": %lu,\n  \"tagFileTags\": %lu,\n",
+			TagFile.numTags.added,
+			TagFile.numTags.added + TagFile.numTags.prev);
+	fprintf (fp, "  \"allocations\": %lu,\n", allocationCount ());
+	fprintf (fp, "  \"peakResident\": %lu,\n", peakResidentSize ());
+	fprintf (fp, "  \"bytesPerSecond\": %.0f,\n",
+			scan > 0.0 ? (double) Totals.bytes / scan : 0.0);
+	printMemoryTotalsJson (fp);
+	printLanguageTotalsJson (fp);
+	printJobTotalsJson (fp);
+	fprintf (fp, "  \"phases\": {\"scan\": %.6f, \"parse\": %.6f, "
+			"\"parseCpu\": %.6f, \"sort\": %.6f}\n",
+			scan, sum.elapsed, sum.cpu, wallStamps [2] - wallStamps [1]);
+	fputs ("}\n", fp);
+}
+
+/*  Merges the tag files named by the remaining arguments (see --merge).
+ */
+static void mergeTags (cookedArgs *args)
+{
+	stringList *const fileNames = stringListNew ();
+
+	if (cArgOff (args))
+		error (FATAL, "No tag files specified to merge. Try \"%s --help\".",
+			getExecutableName ());
+	while (! cArgOff (args))
+	{
+		stringListAdd (fileNames, vStringNewInit (cArgItem (args)));
+		cArgForth (args);
+		parseOptions (args);
+	}
+	openTagFile ();
+	mergeTagFiles (fileNames);
+	if (Option.printTotals)
+		fprintf (errout, "%lu tag%s merged from %u tag file%s\n",
+				TagFile.numTags.added, plural (TagFile.numTags.added),
+				stringListCount (fileNames),
+				plural (stringListCount (fileNames)));
+	closeTagFile (FALSE);
+	stringListDelete (fileNames);
+}
+
+/*  Tags again the files named by --update-file, once the tags of those and
+ *  of the files named by --remove-file are marked for removal.
+ */
+static boolean updateNamedFiles (void)
+{
+	boolean resize = FALSE;
+	unsigned int i;
+
+	if (Option.removeFiles != NULL)
+		for (i = 0  ;  i < stringListCount (Option.removeFiles)  ;  ++i)
+			removeFileTags (vStringValue (stringListItem (Option.removeFiles, i)));
+	if (Option.updateFiles != NULL)
+	{
+		for (i = 0  ;  i < stringListCount (Option.updateFiles)  ;  ++i)
+		{
+			const char *const name =
+					vStringValue (stringListItem (Option.updateFiles, i));
+			removeFileTags (name);
+			if (doesFileExist (name))
+				resize |= createTagsForEntry (name);
+		}
+		resize |= tagQueuedFiles ();
+	}
+	return resize;
+}
+
+/*  Tags again those of the changed paths which are directories or source
+ *  files, the manifest (see --incremental) revealing which of them are new
+ *  or have changed, and which have been deleted.
+ */
+static void tagChangedFiles (const stringList *const changes)
+{
+	boolean resize = FALSE;
+	boolean relevant = FALSE;
+	unsigned int i;
+
+	for (i = 0  ;  i < stringListCount (changes)  &&  ! relevant  ;  ++i)
+	{
+		const char *const name = vStringValue (stringListItem (changes, i));
+		fileStatus *const status = eStat (name);
+		relevant = (boolean) ((status->exists  &&  status->isDirectory)  ||
+				getFileLanguage (name) != LANG_IGNORE);
+		eStatFree (status);
+	}
+	if (relevant)
+	{
+		verbose ("Tagging changed files\n");
+		openTagFile ();
+		for (i = 0  ;  i < stringListCount (changes)  ;  ++i)
+		{
+			const char *const name = vStringValue (stringListItem (changes, i));
+			if (doesFileExist (name))
+				resize |= createTagsForEntry (name);
+		}
+		resize |= tagQueuedFiles ();
+		closeTagFile (resize);
+		trimCache ();
+	}
+}
+
+/*  Tags the source files again whenever they change (see --daemon).
+ */
+static void watchForChanges (void)
+{
+	verbose ("Watching for changes\n");
+	for (;;)
+	{
+		stringList *const changes = waitForChangedFiles ();
+		tagChangedFiles (changes);
+		stringListDelete (changes);
+	}
+}
+
 static boolean etagsInclude (void)
 {
 	return (boolean)(Option.etags && Option.etagsInclude != NULL);
@@ -469,9 +756,23 @@ static boolean etagsInclude (void)
 static void makeTags (cookedArgs *args)
 {
 	clock_t timeStamps [3];
+	double wallStamps [3];
 	boolean resize = FALSE;
-	boolean files = (boolean)(! cArgOff (args) || Option.fileList != NULL
-							  || Option.filter);
+	boolean files;
+
+	if (Option.server)
+	{
+		if (! cArgOff (args)  ||  Option.fileList != NULL)
+			error (FATAL, "server mode takes no file names");
+		verbose ("Serving requests\n");
+		serveRequests ();
+		return;
+	}
+	files = (boolean)(! cArgOff (args) || Option.fileList != NULL
+							  || Option.filter || Option.removeFiles != NULL
+							  || Option.updateFiles != NULL
+							  || Option.gitFiles
+							  || Option.syntheticTags > 0);
 
 	if (! files)
 	{
@@ -482,16 +783,22 @@ static void makeTags (cookedArgs *args)
 			return;
 	}
 
-#define timeStamp(n) timeStamps[(n)]=(Option.printTotals ? clock():(clock_t)0)
+#define timeStamp(n) timeStamps[(n)]=(Option.printTotals ? clock():(clock_t)0), \
+		wallStamps[(n)]=(Option.printTotals ? elapsedTime():0.0)
 	if (! Option.filter)
 		openTagFile ();
 
 	timeStamp (0);
 
+	if (Option.removeFiles != NULL  ||  Option.updateFiles != NULL)
+	{
+		verbose ("Updating named files\n");
+		resize = updateNamedFiles ();
+	}
 	if (! cArgOff (args))
 	{
 		verbose ("Reading command line arguments\n");
-		resize = createTagsForArgs (args);
+		resize = (boolean) (createTagsForArgs (args) || resize);
 	}
 	if (Option.fileList != NULL)
 	{
@@ -503,19 +810,41 @@ static void makeTags (cookedArgs *args)
 		verbose ("Reading filter input\n");
 		resize = (boolean) (createTagsFromFileInput (stdin, TRUE) || resize);
 	}
+	if (Option.gitFiles)
+	{
+		verbose ("Reading git index\n");
+		resize = (boolean) (forEachGitFile (createTagsForGitFile) || resize);
+		resize = (boolean) (tagQueuedFiles () || resize);
+	}
 	if (! files  &&  Option.recurse)
+	{
 		resize = recurseIntoDirectory (".");
+		resize = (boolean) (tagQueuedFiles () || resize);
+	}
+	if (Option.syntheticTags > 0)
+	{
+		verbose ("Making synthetic tags\n");
+		makeSyntheticTags (Option.syntheticTags);
+	}
 
 	timeStamp (1);
 
 	if (! Option.filter)
 		closeTagFile (resize);
+	trimCache ();
 
 	timeStamp (2);
 
-	if (Option.printTotals)
+	if (Option.printTotals == TOTALS_JSON)
+		printTotalsJson (wallStamps);
+	else if (Option.printTotals)
 		printTotals (timeStamps);
+	if (Option.profileRegex)
+		printRegexProfile ();
 #undef timeStamp
+
+	if (Option.daemon)
+		watchForChanges ();
 }
 
 /*
@@ -559,7 +888,10 @@ extern int main (int __unused__ argc, char **argv)
 	verbose ("Reading initial options from command line\n");
 	parseOptions (args);
 	checkOptions ();
-	makeTags (args);
+	if (Option.merge)
+		mergeTags (args);
+	else
+		makeTags (args);
 
 	/*  Clean up.
 	 */
@@ -571,9 +903,16 @@ extern int main (int __unused__ argc, char **argv)
 	freeOptionResources ();
 	freeParserResources ();
 	freeRegexResources ();
+	freeJobsResources ();
+	freeManifestResources ();
+	freeDaemonResources ();
+	freeCacheResources ();
+	vStringReleaseSpares ();
 
 	exit (0);
 	return 0;
 }
 
+#endif  /* CTAGS_LIBRARY */
+
 /* vi:set tabstop=4 shiftwidth=4: */
@@ -24,6 +24,7 @@
 *   FUNCTION PROTOTYPES
 */
 extern void addTotals (const unsigned int files, const long unsigned int lines, const long unsigned int bytes);
+extern void getTotals (long unsigned int *const files, long unsigned int *const lines, long unsigned int *const bytes);
 extern boolean isDestinationStdout (void);
 extern int main (int argc, char **argv);
 
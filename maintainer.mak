@@ -13,7 +13,7 @@ DSOURCES     := $(SOURCES) debug.c
 
 VERSION_FILES:= ctags.h ctags.1 NEWS
 
-LIB_FILES    := readtags.c readtags.h
+LIB_FILES    := readtags.c readtags.h libctags.c libctags.h
 
 ENVIRONMENT_MAKEFILES := \
 				mk_bc3.mak mk_bc5.mak mk_djg.mak mk_manx.mak mk_mingw.mak \
@@ -26,7 +26,7 @@ COMMON_FILES := COPYING EXTENDING.html FAQ INSTALL.oth MAINTAINERS NEWS README \
 
 UNIX_FILES   := $(COMMON_FILES) \
 				.indent.pro INSTALL configure.ac \
-				Makefile.in maintainer.mak \
+				Makefile.in maintainer.mak bench.sh \
 				descrip.mms mkinstalldirs magic.diff \
 				ctags.spec ctags.1
 
@@ -0,0 +1,512 @@
+/*
+*   $Id$
+*
+*   Copyright (c) 2026, Exuberant Ctags contributors
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License.
+*
+*   This module contains functions to keep a manifest of the source files
+*   whose tags are in the tag file (see --incremental). The manifest records
+*   the size, modification time and a hash of the contents of each source
+*   file as it was when tagged, and the size and modification time of the
+*   tag file it describes and a fingerprint of the options it was written
+*   with. When the tag file is still as described, only
+*   source files which are new or which have changed are parsed again, and
+*   the earlier tags of changed or deleted files are dropped while the new
+*   tags are merged into the tag file. The tags of source files named by
+*   --remove-file and --update-file are dropped in the same way.
+*/
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#include <string.h>
+#include <stdio.h>
+
+#include "debug.h"
+#include "entry.h"
+#include "manifest.h"
+#include "options.h"
+#include "parse.h"
+#include "read.h"
+#include "routines.h"
+#include "strlist.h"
+#include "vstring.h"
+
+/*
+*   MACROS
+*/
+#define MANIFEST_SUFFIX  ".manifest"
+#define MANIFEST_HEADER  "!_CTAGS_MANIFEST"
+
+/*
+*   DATA DECLARATIONS
+*/
+enum eManifestLimits {
+	ManifestVersion = 2,      /* format of manifest */
+	RemovedPathCount = 3,     /* names sought for each file removed */
+	InitialTableSize = 256    /* must be a power of 2 */
+};
+
+typedef enum eFileState {
+	FILE_UNSEEN,     /* not named so far */
+	FILE_UNCHANGED,  /* named, and unchanged since it was tagged */
+	FILE_CHANGED,    /* named, and tagged again */
+	FILE_NEW,        /* named, and tagged for the first time */
+	FILE_DELETED,    /* no longer exists */
+	FILE_REMOVED     /* tags to be removed from the tag file */
+} fileState;
+
+typedef struct sManifestEntry {
+	struct sManifestEntry *next;  /* next entry in hash chain */
+	char *fileName;           /* name by which source file was found */
+	char *tagPath;            /* name recorded for source file in tag file */
+	unsigned long size;
+	unsigned long modified;
+	unsigned long hash;       /* of contents */
+	unsigned long dropped;    /* lines dropped from tag file */
+	fileState state;
+} manifestEntry;
+
+/*
+*   DATA DEFINITIONS
+*/
+static manifestEntry **Table = NULL;
+static unsigned int TableSize = 0;
+static unsigned int EntryCount = 0;
+static boolean DeletionsChecked = FALSE;
+static boolean DeletionsFound = FALSE;
+
+/*
+*   FUNCTION DEFINITIONS
+*/
+
+static unsigned long hashFileContents (const char *const fileName)
+{
+	unsigned long hash = INITIAL_HASH;
+	FILE *const fp = fopen (fileName, "rb");
+	if (fp != NULL)
+	{
+		unsigned char buffer [BUFSIZ];
+		size_t length;
+		while ((length = fread (buffer, 1, sizeof (buffer), fp)) > 0)
+			hash = hashBytes (hash, buffer, length);
+		fclose (fp);
+	}
+	return hash;
+}
+
+static unsigned int tableIndex (const char *const path, const size_t length)
+{
+	const unsigned long hash =
+			hashBytes (INITIAL_HASH, (const unsigned char *) path, length);
+	return (unsigned int) (hash & (TableSize - 1));
+}
+
+static manifestEntry *findEntry (const char *const path, const size_t length)
+{
+	manifestEntry *entry = NULL;
+	if (Table != NULL)
+	{
+		entry = Table [tableIndex (path, length)];
+		while (entry != NULL  &&  ! (strncmp (entry->tagPath, path, length) == 0
+				&&  entry->tagPath [length] == '\0'))
+			entry = entry->next;
+	}
+	return entry;
+}
+
+static void insertEntry (manifestEntry *const entry)
+{
+	const unsigned int i = tableIndex (entry->tagPath, strlen (entry->tagPath));
+	entry->next = Table [i];
+	Table [i] = entry;
+}
+
+static void growTable (void)
+{
+	manifestEntry **const old = Table;
+	const unsigned int oldSize = TableSize;
+	unsigned int i;
+
+	TableSize = (TableSize == 0) ? InitialTableSize : TableSize * 2;
+	Table = xCalloc (TableSize, manifestEntry*);
+	for (i = 0  ;  i < oldSize  ;  ++i)
+	{
+		manifestEntry *entry = old [i];
+		while (entry != NULL)
+		{
+			manifestEntry *const next = entry->next;
+			insertEntry (entry);
+			entry = next;
+		}
+	}
+	if (old != NULL)
+		eFree (old);
+}
+
+static manifestEntry *addEntry (
+		const char *const fileName, const char *const tagPath)
+{
+	manifestEntry *const entry = xMalloc (1, manifestEntry);
+	entry->fileName = eStrdup (fileName);
+	entry->tagPath = eStrdup (tagPath);
+	entry->size = 0;
+	entry->modified = 0;
+	entry->hash = 0;
+	entry->dropped = 0;
+	entry->state = FILE_UNSEEN;
+	if (EntryCount >= TableSize)
+		growTable ();
+	insertEntry (entry);
+	++EntryCount;
+	return entry;
+}
+
+extern void freeManifestResources (void)
+{
+	unsigned int i;
+	for (i = 0  ;  i < TableSize  ;  ++i)
+	{
+		manifestEntry *entry = Table [i];
+		while (entry != NULL)
+		{
+			manifestEntry *const next = entry->next;
+			eFree (entry->fileName);
+			eFree (entry->tagPath);
+			eFree (entry);
+			entry = next;
+		}
+	}
+	if (Table != NULL)
+		eFree (Table);
+	Table = NULL;
+	TableSize = 0;
+	EntryCount = 0;
+	DeletionsChecked = FALSE;
+	DeletionsFound = FALSE;
+}
+
+static vString *manifestName (const char *const tagFileName)
+{
+	vString *const name = vStringNewInit (tagFileName);
+	vStringCatS (name, MANIFEST_SUFFIX);
+	return name;
+}
+
+/*  Reads a manifest entry, "size<TAB>modified<TAB>hash<TAB>tagPath<TAB>
+ *  fileName".
+ */
+static boolean readEntry (vString *const vLine)
+{
+	boolean result = FALSE;
+	unsigned long size, modified, hash;
+	int offset;
+
+	if (vStringLast (vLine) == '\n')
+		vStringChop (vLine);
+	if (sscanf (vStringValue (vLine), "%lu\t%lu\t%lx\t%n",
+			&size, &modified, &hash, &offset) == 3)
+	{
+		char *const tagPath = vStringValue (vLine) + offset;
+		char *const tab = strchr (tagPath, '\t');
+		if (tab != NULL  &&  tab != tagPath  &&  tab [1] != '\0')
+		{
+			manifestEntry *entry;
+			*tab = '\0';
+			entry = addEntry (tab + 1, tagPath);
+			entry->size = size;
+			entry->modified = modified;
+			entry->hash = hash;
+			result = TRUE;
+		}
+	}
+	return result;
+}
+
+/*  Reads the manifest of the named tag file, returning whether it describes
+ *  the tag file as it is, sorted as now required and written with the same
+ *  options affecting the tags of each file (see optionFingerprint ()), in
+ *  which case only new and changed source files need be tagged.
+ */
+extern boolean loadManifest (const char *const tagFileName)
+{
+	boolean result = FALSE;
+	vString *const name = manifestName (tagFileName);
+	FILE *const fp = fopen (vStringValue (name), "r");
+
+	if (fp != NULL)
+	{
+		vString *const vLine = vStringNew ();
+		fileStatus *const status = eStat (tagFileName);
+		unsigned int version;
+		unsigned long size, modified, fingerprint;
+		int sorted;
+
+		verbose ("reading manifest \"%s\"\n", vStringValue (name));
+		if (readLine (vLine, fp) != NULL  &&
+			sscanf (vStringValue (vLine),
+					MANIFEST_HEADER "\t%u\t%lu\t%lu\t%d\t%lx", &version,
+					&size, &modified, &sorted, &fingerprint) == 5  &&
+			version == ManifestVersion  &&  status->exists  &&
+			size == status->size  &&  modified == status->modified  &&
+			sorted == (int) Option.sorted  &&
+			fingerprint == optionFingerprint ())
+		{
+			result = TRUE;
+			while (result  &&  readLine (vLine, fp) != NULL)
+				result = readEntry (vLine);
+			if (! result)
+				error (WARNING, "ignoring invalid manifest \"%s\"",
+						vStringValue (name));
+		}
+		else
+			verbose ("manifest does not describe tag file; tagging all files\n");
+		if (! result)
+			freeManifestResources ();
+		vStringDelete (vLine);
+		fclose (fp);
+	}
+	vStringDelete (name);
+	return result;
+}
+
+static char *getTagPath (const char *const fileName)
+{
+	char *result;
+	if (! Option.tagRelative  ||  isAbsolutePath (fileName))
+		result = eStrdup (fileName);
+	else
+		result = relativeFilename (fileName, TagFile.directory);
+	return result;
+}
+
+/*  Determines whether the tags of the named source file, which exists, are
+ *  already in the tag file as it is to be written, recording its state.
+ *  Files not to be parsed are not recorded.
+ */
+extern boolean isFileUpToDate (const char *const fileName)
+{
+	boolean result = FALSE;
+	if (getFileLanguage (fileName) != LANG_IGNORE)
+	{
+		char *const tagPath = getTagPath (fileName);
+		const fileStatus *const status = eStat (fileName);
+		manifestEntry *entry = findEntry (tagPath, strlen (tagPath));
+
+		if (entry == NULL)
+		{
+			entry = addEntry (fileName, tagPath);
+			entry->state = FILE_NEW;
+			entry->hash = hashFileContents (fileName);
+		}
+		else if (entry->state != FILE_UNSEEN)
+			result = TRUE;  /* already named */
+		else if (status->size == entry->size  &&
+				 status->modified == entry->modified)
+		{
+			entry->state = FILE_UNCHANGED;
+			result = TRUE;
+		}
+		else
+		{
+			const unsigned long hash = hashFileContents (fileName);
+			entry->state = (hash == entry->hash) ? FILE_UNCHANGED : FILE_CHANGED;
+			entry->hash = hash;
+			result = (boolean) (entry->state == FILE_UNCHANGED);
+		}
+		if (strcmp (entry->fileName, fileName) != 0)
+		{
+			eFree (entry->fileName);
+			entry->fileName = eStrdup (fileName);
+		}
+		entry->size = status->size;
+		entry->modified = status->modified;
+		eFree (tagPath);
+	}
+	return result;
+}
+
+/*  Finds the names under which the tags of the named source file may be
+ *  recorded in the tag file, however the file is now named: the name it
+ *  would be recorded under now, and the name relative to the directory of
+ *  the tag file and the absolute name by which it was most likely tagged.
+ */
+static void getRemovedTagPaths (
+		const char *const fileName, char *paths [RemovedPathCount])
+{
+	paths [0] = getTagPath (fileName);
+	paths [1] = relativeFilename (fileName, TagFile.directory);
+	paths [2] = absoluteFilename (fileName);
+}
+
+/*  Drops the tags of the named source file from the tag file as it was.
+ */
+extern void removeFileTags (const char *const fileName)
+{
+	char *paths [RemovedPathCount];
+	unsigned int i;
+
+	verbose ("removing tags of \"%s\"\n", fileName);
+	getRemovedTagPaths (fileName, paths);
+	for (i = 0  ;  i < RemovedPathCount  ;  ++i)
+	{
+		manifestEntry *entry = findEntry (paths [i], strlen (paths [i]));
+		if (entry == NULL)
+			entry = addEntry (fileName, paths [i]);
+		entry->state = FILE_REMOVED;
+		eFree (paths [i]);
+	}
+}
+
+/*  Warns of the files named by --remove-file of which the tag file, as it
+ *  was, held no tags, as when they are named otherwise than when tagged.
+ */
+extern void checkRemovedFiles (void)
+{
+	unsigned int i, j, k;
+
+	for (i = 0  ;  Option.removeFiles != NULL  &&
+			i < stringListCount (Option.removeFiles)  ;  ++i)
+	{
+		const char *const fileName =
+				vStringValue (stringListItem (Option.removeFiles, i));
+		char *paths [RemovedPathCount];
+		const manifestEntry *found [RemovedPathCount];
+		unsigned long dropped = 0;
+
+		getRemovedTagPaths (fileName, paths);
+		for (j = 0  ;  j < RemovedPathCount  ;  ++j)
+		{
+			found [j] = findEntry (paths [j], strlen (paths [j]));
+			for (k = 0  ;  k < j  &&  found [k] != found [j]  ;  ++k)
+				;
+			if (found [j] != NULL  &&  k == j)  /* not counted already */
+				dropped += found [j]->dropped;
+			eFree (paths [j]);
+		}
+		if (dropped == 0)
+			error (WARNING, "no tags of \"%s\" found to remove", fileName);
+	}
+}
+
+/*  Marks as deleted those source files in the manifest which were not named
+ *  and no longer exist.
+ */
+static void findDeletedFiles (void)
+{
+	unsigned int i;
+
+	if (! DeletionsChecked)
+	{
+		for (i = 0  ;  i < TableSize  ;  ++i)
+		{
+			manifestEntry *entry;
+			for (entry = Table [i]  ;  entry != NULL  ;  entry = entry->next)
+			{
+				if (entry->state == FILE_UNSEEN  &&
+					! doesFileExist (entry->fileName))
+				{
+					verbose ("dropping tags of \"%s\" (deleted)\n",
+							entry->fileName);
+					entry->state = FILE_DELETED;
+					DeletionsFound = TRUE;
+				}
+			}
+		}
+		DeletionsChecked = TRUE;
+	}
+}
+
+/*  Determines whether the tag file holds tags of changed or deleted source
+ *  files, which are to be dropped.
+ */
+extern boolean hasObsoleteTags (void)
+{
+	boolean result = FALSE;
+	unsigned int i;
+
+	findDeletedFiles ();
+	result = DeletionsFound;
+	for (i = 0  ;  i < TableSize  &&  ! result  ;  ++i)
+	{
+		const manifestEntry *entry;
+		for (entry = Table [i]  ;  entry != NULL  ;  entry = entry->next)
+			if (entry->state == FILE_CHANGED  ||  entry->state == FILE_REMOVED)
+				result = TRUE;
+	}
+	return result;
+}
+
+/*  Determines whether a line of the tag file, as it was, is a tag of a
+ *  changed or deleted source file.
+ */
+extern boolean isObsoleteTagLine (const char *const line)
+{
+	boolean result = FALSE;
+	const char *const tab = strchr (line, '\t');
+
+	findDeletedFiles ();
+	if (tab != NULL  &&  strncmp (line, "!_TAG_", 6) != 0)
+	{
+		const char *const path = tab + 1;
+		const char *const end = strchr (path, '\t');
+		if (end != NULL)
+		{
+			manifestEntry *const entry = findEntry (path, end - path);
+			result = (boolean) (entry != NULL  &&
+				(entry->state == FILE_CHANGED  ||
+				 entry->state == FILE_DELETED  ||
+				 entry->state == FILE_REMOVED));
+			if (result)
+				++entry->dropped;
+		}
+	}
+	return result;
+}
+
+/*  Writes the manifest of the named tag file, once it has been written.
+ */
+extern void writeManifest (const char *const tagFileName)
+{
+	vString *const name = manifestName (tagFileName);
+	FILE *const fp = fopen (vStringValue (name), "w");
+	fileStatus *status;
+	unsigned int i;
+
+	/*  Discard any status of the tag file obtained before it was written.
+	 */
+	eStatFree (eStat (tagFileName));
+	status = eStat (tagFileName);
+	if (fp == NULL)
+		error (WARNING | PERROR, "cannot write manifest \"%s\"",
+				vStringValue (name));
+	else
+	{
+		findDeletedFiles ();
+		fprintf (fp, "%s\t%u\t%lu\t%lu\t%d\t%08lx\n", MANIFEST_HEADER,
+				(unsigned int) ManifestVersion, status->size, status->modified,
+				(int) Option.sorted, optionFingerprint ());
+		for (i = 0  ;  i < TableSize  ;  ++i)
+		{
+			const manifestEntry *entry;
+			for (entry = Table [i]  ;  entry != NULL  ;  entry = entry->next)
+			{
+				if (entry->state != FILE_DELETED  &&
+					entry->state != FILE_REMOVED)
+					fprintf (fp, "%lu\t%lu\t%08lx\t%s\t%s\n",
+							entry->size, entry->modified, entry->hash,
+							entry->tagPath, entry->fileName);
+			}
+		}
+		if (fclose (fp) != 0)
+			error (WARNING | PERROR, "cannot write manifest \"%s\"",
+					vStringValue (name));
+	}
+	vStringDelete (name);
+}
+
+/* vi:set tabstop=4 shiftwidth=4: */
@@ -0,0 +1,33 @@
+/*
+*   $Id$
+*
+*   Copyright (c) 2026, Exuberant Ctags contributors
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License.
+*
+*   External interface to manifest.c
+*/
+#ifndef _MANIFEST_H
+#define _MANIFEST_H
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+/*
+*   FUNCTION PROTOTYPES
+*/
+extern boolean loadManifest (const char *const tagFileName);
+extern boolean isFileUpToDate (const char *const fileName);
+extern void removeFileTags (const char *const fileName);
+extern void checkRemovedFiles (void);
+extern boolean hasObsoleteTags (void);
+extern boolean isObsoleteTagLine (const char *const line);
+extern void writeManifest (const char *const tagFileName);
+extern void freeManifestResources (void);
+
+#endif  /* _MANIFEST_H */
+
+/* vi:set tabstop=4 shiftwidth=4: */
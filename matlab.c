@@ -16,28 +16,120 @@
 
 #include <string.h>
 #include "parse.h"
+#include "read.h"
+#include "vstring.h"
+
+/*
+*   DATA DEFINITIONS
+*/
+typedef enum {
+	K_FUNCTION
+} matLabKind;
+
+static kindOption MatLabKinds [] = {
+	{ TRUE, 'f', "function", "functions" }
+};
 
 /*
 *   FUNCTION DEFINITIONS
 */
 
-static void installMatLabRegex (const langType language)
+static boolean isNameChar (const int c)
+{
+	return (boolean) ((c >= 'A'  &&  c <= 'Z')  ||  (c >= 'a'  &&  c <= 'z')  ||
+			(c >= '0'  &&  c <= '9')  ||  c == '_');
+}
+
+static const unsigned char *skipBlanks (const unsigned char *cp)
+{
+	while (*cp == ' '  ||  *cp == '\t')
+		++cp;
+	return cp;
+}
+
+static const unsigned char *skipName (const unsigned char *cp)
 {
-    /* function [x,y,z] = asdf */
-    addTagRegex (language, "^function[ \t]*\\[.*\\][ \t]*=[ \t]*([a-zA-Z0-9_]+)", "\\1", "f,function", NULL);
-    /* function x = asdf */
-    addTagRegex (language, "^function[ \t]*[a-zA-Z0-9_]+[ \t]*=[ \t]*([a-zA-Z0-9_]+)", "\\1", "f,function", NULL);
-    /* function asdf */
-    addTagRegex (language, "^function[ \t]*([a-zA-Z0-9_]+)[^=]*$", "\\1", "f,function", NULL);
+	while (isNameChar ((int) *cp))
+		++cp;
+	return cp;
+}
+
+/*  Finds the name assigned at "cp", of the form
+ *  = name
+ *  returning whether it was found.
+ */
+static boolean findAssigned (const unsigned char *cp, vString *const name)
+{
+	boolean result = FALSE;
+	cp = skipBlanks (cp);
+	if (*cp == '=')
+	{
+		const unsigned char *const start = skipBlanks (cp + 1);
+		cp = skipName (start);
+		if (cp > start)
+		{
+			vStringNCopyS (name, (const char*) start, cp - start);
+			result = TRUE;
+		}
+	}
+	return result;
+}
+
+/*  Makes a tag for a line of one of the forms
+ *      function [x,y,z] = asdf
+ *      function x = asdf
+ *      function asdf
+ *  The first is taken to end at the last "]" which can end it.
+ */
+static void findMatLabTags (void)
+{
+	vString *const name = vStringNew ();
+	const unsigned char *line;
+
+	while ((line = fileReadLine ()) != NULL)
+	{
+		const unsigned char *cp;
+		boolean found = FALSE;
+
+		if (strncmp ((const char*) line, "function", (size_t) 8) != 0)
+			continue;
+		cp = skipBlanks (line + 8);
+		if (*cp == '[')
+		{
+			const unsigned char *close = cp + strlen ((const char*) cp);
+			while (! found  &&  --close > cp)
+			{
+				if (*close == ']')
+					found = findAssigned (close + 1, name);
+			}
+		}
+		else
+		{
+			const unsigned char *const end = skipName (cp);
+			if (end > cp)
+			{
+				found = findAssigned (end, name);
+				if (! found  &&  strchr ((const char*) end, '=') == NULL)
+				{
+					vStringNCopyS (name, (const char*) cp, end - cp);
+					found = TRUE;
+				}
+			}
+		}
+		if (found)
+			makeSimpleTag (name, MatLabKinds, K_FUNCTION);
+	}
+	vStringDelete (name);
 }
 
 extern parserDefinition* MatLabParser ()
 {
 	static const char *const extensions [] = { "m", NULL };
 	parserDefinition* const def = parserNew ("MatLab");
+	def->kinds      = MatLabKinds;
+	def->kindCount  = KIND_COUNT (MatLabKinds);
 	def->extensions = extensions;
-	def->initialize = installMatLabRegex;
-	def->regex      = TRUE;
+	def->parser     = findMatLabTags;
 	return def;
 }
 
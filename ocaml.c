@@ -255,66 +255,60 @@ static void eatWhiteSpace (lexingState * st)
 	st->cp = cp;
 }
 
+/* Skips a string, which may run over several lines, without tokenizing
+ * it. At the end of input, st->cp is left NULL. */
 static void eatString (lexingState * st)
 {
-	boolean lastIsBackSlash = FALSE;
-	boolean unfinished = TRUE;
 	const unsigned char *c = st->cp + 1;
 
-	while (unfinished)
+	while (c != NULL && *c != '"')
 	{
-		/* end of line should never happen.
-		 * we tolerate it */
-		if (c == NULL || c[0] == '\0')
-			break;
-		else if (*c == '"' && !lastIsBackSlash)
-			unfinished = FALSE;
-		else
-			lastIsBackSlash = *c == '\\';
-
-		c++;
+		while (*c != '\0' && *c != '"' && *c != '\\')
+			c++;
+		if (*c == '\0')
+			c = fileReadLine ();
+		else if (*c == '\\')
+		{
+			/* an escaped character, or a line continuation */
+			c++;
+			if (*c != '\0')
+				c++;
+		}
 	}
 
-	st->cp = c;
+	st->cp = (c == NULL) ? NULL : c + 1;
 }
 
+/* Skips a comment, which may hold nested comments and run over several
+ * lines, without tokenizing it. At the end of input, st->cp is left NULL. */
 static void eatComment (lexingState * st)
 {
-	boolean unfinished = TRUE;
-	boolean lastIsStar = FALSE;
+	int depth = 1;
 	const unsigned char *c = st->cp + 2;
 
-	while (unfinished)
+	while (c != NULL && depth > 0)
 	{
+		while (*c != '\0' && *c != '(' && *c != '*')
+			c++;
 		/* we've reached the end of the line..
 		 * so we have to reload a line... */
-		if (c == NULL || *c == '\0')
+		if (*c == '\0')
+			c = fileReadLine ();
+		/* we've reached the end of a comment */
+		else if (c[0] == '*' && c[1] == ')')
 		{
-			st->cp = fileReadLine ();
-			/* WOOPS... no more input...
-			 * we return, next lexing read
-			 * will be null and ok */
-			if (st->cp == NULL)
-				return;
-			c = st->cp;
-			continue;
+			depth--;
+			c += 2;
 		}
-		/* we've reached the end of the comment */
-		else if (*c == ')' && lastIsStar)
-			unfinished = FALSE;
 		/* here we deal with imbricated comment, which
 		 * are allowed in OCaml */
 		else if (c[0] == '(' && c[1] == '*')
 		{
-			st->cp = c;
-			eatComment (st);
-			c = st->cp;
-			lastIsStar = FALSE;
+			depth++;
+			c += 2;
 		}
 		else
-			lastIsStar = '*' == *c;
-
-		c++;
+			c++;
 	}
 
 	st->cp = c;
@@ -452,6 +446,18 @@ static ocamlKeyword lex (lexingState * st)
 			st->cp++;
 			return Tok_CurlR;
 		case '\'':
+			/* a character literal holding a double quote must not be
+			 * taken for the start of a string */
+			if (st->cp[1] == '"' && st->cp[2] == '\'')
+			{
+				st->cp += 3;
+				return Tok_Val;
+			}
+			else if (st->cp[1] == '\\' && st->cp[2] == '"' && st->cp[3] == '\'')
+			{
+				st->cp += 4;
+				return Tok_Val;
+			}
 			st->cp++;
 			return Tok_Prime;
 		case ',':
@@ -1813,6 +1819,7 @@ static void findOcamlTags (void)
 	}
 
 	vStringDelete (name);
+	vStringDelete (st.name);
 	vStringDelete (voidName);
 	vStringDelete (tempIdent);
 	vStringDelete (lastModule);
@@ -1837,6 +1844,7 @@ extern parserDefinition *OcamlParser (void)
 	def->extensions = extensions;
 	def->parser = findOcamlTags;
 	def->initialize = ocamlInitialize;
+	def->serial = TRUE;  /* lexer and scope state is not reset between files */
 
 	return def;
 }
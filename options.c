@@ -21,6 +21,7 @@
 
 #include "ctags.h"
 #include "debug.h"
+#include "globset.h"
 #include "main.h"
 #define OPTION_WRITE
 #include "options.h"
@@ -53,6 +54,11 @@
 # define DEFAULT_FILE_FORMAT  2
 #endif
 
+/*  Upper limit of --jobs, which sizes tables of each job and of the chunks
+ *  of a file or tag file divided among them.
+ */
+#define MAX_JOBS  256
+
 #if defined (HAVE_OPENDIR) || defined (HAVE_FINDFIRST) || defined (HAVE__FINDFIRST) || defined (AMIGA)
 # define RECURSE_SUPPORTED
 #endif
@@ -87,6 +93,24 @@ typedef const struct {
 	boolean initOnly;   /* option must be specified before any files */
 } booleanOption;
 
+/*  A name looked up among the tokens of the ignore list, with what the
+ *  first token naming it asks to be done with it.
+ */
+typedef struct sIgnoreEntry {
+	const char *name;         /* within token; not terminated */
+	size_t length;
+	boolean ignoreParens;     /* token of the form "name+" */
+	const char *replacement;  /* of token "name=replacement", or NULL */
+	int next;                 /* index of next entry in hash chain, or -1 */
+} ignoreEntry;
+
+typedef struct sIgnoreTable {
+	ignoreEntry *entries;
+	unsigned int count, max;
+	int *chains;
+	unsigned int size;        /* of chains, a power of 2 */
+} ignoreTable;
+
 /*
 *   DATA DEFINITIONS
 */
@@ -94,8 +118,27 @@ typedef const struct {
 static boolean NonOptionEncountered;
 static stringList *OptionFiles;
 static stringList* Excluded;
+static globSet* ExcludedSet;  /* Excluded, compiled when first needed */
+static ignoreTable* IgnoreTable;  /* Option.ignore, built when first needed */
 static boolean FilesRequired = TRUE;
 static boolean SkipConfiguration;
+static unsigned long Fingerprint = INITIAL_HASH;  /* of options affecting tags */
+
+/*  Options which cannot change the tags generated for any one source file,
+ *  and so are left out of the fingerprint which keys the cache.
+ */
+static const char *const FingerprintNeutralOptions [] = {
+	"a", "f", "L", "o", "R", "u", "V", "w",
+	"append", "cache-dir", "cache-size", "compress", "daemon", "exclude",
+	"extra-output", "filter",
+	"filter-terminator", "git-files", "help", "incremental", "jobs",
+	"license", "links", "list-kinds", "list-languages", "list-maps", "merge",
+	"options",
+	"profile-regex", "recurse", "remove-file", "server", "shard", "sort",
+	"sort-memory",
+	"tag-bloom", "tag-index", "totals", "update-file", "verbose", "version",
+	NULL
+};
 
 static const char *const HeaderExtensions [] = {
 	"h", "H", "hh", "hpp", "hxx", "h++", "inc", "def", NULL
@@ -145,9 +188,34 @@ optionValues Option = {
 	TRUE,       /* --links */
 	FALSE,      /* --filter */
 	NULL,       /* --filter-terminator */
+	FALSE,      /* --server */
+	FALSE,      /* --json */
+	FALSE,      /* --git-files */
+	FALSE,      /* --archives */
+	FALSE,      /* --compress */
 	FALSE,      /* --tag-relative */
-	FALSE,      /* --totals */
+	TOTALS_NONE,/* --totals */
 	FALSE,      /* --line-directives */
+	1,          /* --jobs */
+	{ 0, 0 },   /* --shard */
+	FALSE,      /* --merge */
+	256,        /* --sort-memory */
+	FALSE,      /* --incremental */
+	FALSE,      /* --daemon */
+	NULL,       /* --remove-file */
+	NULL,       /* --update-file */
+	NULL,       /* --extra-output */
+	NULL,       /* --cache-dir */
+	0,          /* --cache-size */
+	FALSE,      /* --tag-index */
+	FALSE,      /* --tag-bloom */
+	FALSE,      /* --profile-regex */
+	0,          /* --max-file-size */
+	0,          /* --max-file-time */
+	0,          /* --min-file-rate */
+	FALSE,      /* --oversized */
+	1024,       /* --pattern-length-limit */
+	0,          /* --synthetic-tags */
 #ifdef DEBUG
 	0, 0        /* -D, -b */
 #endif
@@ -195,6 +263,30 @@ static optionDescription LongOptionDescription [] = {
  {1,"  -x   Print a tabular cross reference file to standard output."},
  {1,"  --append=[yes|no]"},
  {1,"       Should tags should be appended to existing tag file [no]?"},
+ {1,"  --archives=[yes|no]"},
+ {1,"       Tag the members of zip, jar and tar files, without extracting them [no]."},
+ {1,"  --cache-dir=directory"},
+ {1,"       Keep the tags of each file in 'directory', to be reused while the"},
+ {1,"       file and the options affecting its tags are unchanged."},
+ {1,"  --cache-size=megabytes"},
+#ifdef CACHE_TRIMMING_SUPPORTED
+ {1,"       Remove the cached tags used least recently beyond this size [0]."},
+#else
+ {1,"       Not supported on this platform."},
+#endif
+ {1,"  --compress=[yes|no]"},
+#ifdef HAVE_ZLIB
+ {1,"       Compress the tag file in blocks, as readtags can search it [no]."},
+#else
+ {1,"       Not supported on this platform."},
+#endif
+ {1,"  --daemon=[yes|no]"},
+#ifdef DAEMON_SUPPORTED
+ {1,"       Keep running, tagging files again as they change [no]."},
+ {1,"       Each update merges the changed tags into the whole tag file."},
+#else
+ {1,"       Not supported on this platform."},
+#endif
  {1,"  --etags-include=file"},
  {1,"      Include reference to 'file' in Emacs-style tag file (requires -e)."},
  {1,"  --exclude=pattern"},
@@ -207,6 +299,8 @@ static optionDescription LongOptionDescription [] = {
 #endif
  {1,"  --extra=[+|-]flags"},
  {1,"      Include extra tag entries for selected information (flags: \"fq\")."},
+ {1,"  --extra-output=format:file"},
+ {1,"      Also write the tags to 'file' as etags, xref or json would."},
  {1,"  --fields=[+|-]flags"},
  {1,"      Include selected extension fields (flags: \"afmikKlnsStz\") [fks]."},
  {1,"  --file-scope=[yes|no]"},
@@ -226,8 +320,20 @@ static optionDescription LongOptionDescription [] = {
 #endif
  {1,"  --help"},
  {1,"       Print this option summary."},
+ {1,"  --git-files=[yes|no]"},
+ {1,"       Tag the files tracked by git under the current directory [no]."},
  {1,"  --if0=[yes|no]"},
  {1,"       Should C code within #if 0 conditional branches be parsed [no]?"},
+ {1,"  --incremental=[yes|no]"},
+ {1,"       Should only new and changed files be tagged again [no]?"},
+ {1,"  --jobs=number"},
+#ifdef JOBS_SUPPORTED
+ {1,"       Number of source files to parse concurrently [1]."},
+#else
+ {1,"       Not supported on this platform."},
+#endif
+ {1,"  --json=[yes|no]"},
+ {1,"       Print each tag as a line of JSON to standard output [no]."},
  {1,"  --<LANG>-kinds=[+|-]kinds"},
  {1,"       Enable/disable tag kinds for language <LANG>."},
  {1,"  --langdef=name"},
@@ -252,8 +358,24 @@ static optionDescription LongOptionDescription [] = {
  {1,"       Output list of supported languages."},
  {1,"  --list-maps=[language|all]"},
  {1,"       Output list of language mappings."},
+ {1,"  --max-file-size=megabytes"},
+ {1,"       Tag only top-level definitions of larger files (see --oversized) [0]."},
+ {1,"  --max-file-time=seconds"},
+ {1,"       Stop reading a file after this time (see --oversized) [0]."},
+ {0,"  --merge=[yes|no]"},
+ {0,"       Merge the sorted tag files named on the command line [no]."},
+ {1,"  --min-file-rate=kilobytes"},
+ {1,"       Stop reading a file read more slowly, per second (see --oversized) [0]."},
  {1,"  --options=file"},
  {1,"       Specify file from which command line options should be read."},
+ {1,"  --oversized=outline|skip"},
+ {1,"       Treatment of files beyond --max-file-* or --min-file-rate [outline]."},
+ {0,"  --pattern-length-limit=bytes"},
+ {0,"       Match only the start of longer lines in tag patterns [1024]."},
+#ifdef HAVE_REGEX
+ {1,"  --profile-regex=[yes|no]"},
+ {1,"       Print the cost of each regex pattern on exit [no]."},
+#endif
  {1,"  --recurse=[yes|no]"},
 #ifdef RECURSE_SUPPORTED
  {1,"       Recurse into directories supplied on command line [no]."},
@@ -264,12 +386,29 @@ static optionDescription LongOptionDescription [] = {
  {1,"  --regex-<LANG>=/line_pattern/name_pattern/[flags]"},
  {1,"       Define regular expression for locating tags in specific language."},
 #endif
+ {0,"  --remove-file=file"},
+ {0,"       Remove the tags of file from the tag file."},
+ {1,"  --server=[yes|no]"},
+ {1,"       Answer requests on standard input, each giving the contents of a"},
+ {1,"       source file, with its tags on standard output [no]."},
+ {1,"  --shard=i/n"},
+ {1,"       Tag only the i'th of n shares of the source files."},
  {0,"  --sort=[yes|no|foldcase]"},
  {0,"       Should tags be sorted (optionally ignoring case) [yes]?."},
+ {0,"  --sort-memory=megabytes"},
+ {0,"       Memory in which tags may be held and sorted [256]."},
+ {0,"  --synthetic-tags=count"},
+ {0,"       Add count synthetic tags, to measure sorting and writing of tags."},
+ {0,"  --tag-bloom=[yes|no]"},
+ {0,"       Write a Bloom filter of tag names to skip files cheaply [no]."},
+ {0,"  --tag-index=[yes|no]"},
+ {0,"       Write an index of the tag file for fast lookups by readtags [no]."},
  {0,"  --tag-relative=[yes|no]"},
  {0,"       Should paths be relative to location of tag file [no; yes when -e]?"},
- {1,"  --totals=[yes|no]"},
- {1,"       Print statistics about source and tag files [no]."},
+ {1,"  --totals=[yes|no|json]"},
+ {1,"       Print statistics about source and tag files, optionally as JSON [no]."},
+ {0,"  --update-file=file"},
+ {0,"       Replace the tags of file in the tag file with its current tags."},
  {1,"  --verbose=[yes|no]"},
  {1,"       Enable verbose messages describing actions on each source file."},
  {1,"  --version"},
@@ -322,6 +461,24 @@ static const char *const Features [] = {
 #ifdef HAVE_REGEX
 	"regex",
 #endif
+#ifdef HAVE_PCRE2
+	"pcre2",
+#endif
+#ifdef HAVE_ZLIB
+	"zlib",
+#endif
+#ifdef ENABLE_TRACING
+	"tracing",
+#endif
+#ifdef MEMORY_ACCOUNTING
+	"memory-accounting",
+#endif
+#ifdef JOBS_SUPPORTED
+	"jobs",
+#endif
+#ifdef DAEMON_SUPPORTED
+	"daemon",
+#endif
 #ifndef EXTERNAL_SORT
 	"internal-sort",
 #endif
@@ -413,23 +570,165 @@ extern void checkOptions (void)
 			Option.include.fileNames = FALSE;
 		}
 	}
+	if (Option.removeFiles != NULL  ||  Option.updateFiles != NULL)
+	{
+		notice = "removing tags of files is not compatible with";
+		if (isDestinationStdout ())
+			error (FATAL, "%s tags to stdout", notice);
+		if (Option.etags)
+			error (FATAL, "%s Emacs style tags", notice);
+		if (Option.xref)
+			error (FATAL, "%s xref output", notice);
+		if (Option.filter)
+			error (FATAL, "%s filter mode", notice);
+		if (Option.sorted == SO_UNSORTED)
+			error (FATAL, "%s unsorted tags", notice);
+	}
 	if (Option.append)
 	{
 		notice = "append mode is not compatible with";
 		if (isDestinationStdout ())
 			error (FATAL, "%s tags to stdout", notice);
 	}
+	if (Option.json)
+	{
+		notice = "JSON output is not compatible with";
+		if (Option.etags)
+			error (FATAL, "%s Emacs style tags", notice);
+		if (Option.xref)
+			error (FATAL, "%s xref output", notice);
+	}
+	if (Option.extraOutputs != NULL)
+	{
+		notice = "extra outputs are not compatible with";
+		if (Option.filter)
+			error (FATAL, "%s filter mode", notice);
+		if (Option.server)
+			error (FATAL, "%s server mode", notice);
+		if (Option.merge)
+			error (FATAL, "%s merge mode", notice);
+		if (Option.incremental  ||  Option.daemon)
+			error (FATAL, "%s incremental mode", notice);
+		if (Option.removeFiles != NULL  ||  Option.updateFiles != NULL)
+			error (FATAL, "%s removing tags of files", notice);
+	}
+	if (Option.compress)
+	{
+#ifndef HAVE_ZLIB
+		error (FATAL, "compressed tag files are not supported on this host");
+#endif
+		notice = "a compressed tag file is not compatible with";
+		if (isDestinationStdout ())
+			error (FATAL, "%s tags to stdout", notice);
+		if (Option.etags)
+			error (FATAL, "%s Emacs style tags", notice);
+		if (Option.append)
+			error (FATAL, "%s append mode", notice);
+		if (Option.incremental  ||  Option.daemon)
+			error (FATAL, "%s incremental mode", notice);
+		if (Option.merge)
+			error (FATAL, "%s merge mode", notice);
+		if (Option.tagIndex  ||  Option.tagBloom)
+			error (FATAL, "%s the tag index", notice);
+	}
+	if (Option.cacheDir != NULL)
+	{
+		fileStatus *const status = eStat (Option.cacheDir);
+		notice = "the tag cache is not compatible with";
+		if (! status->isDirectory)
+			error (FATAL, "cache directory \"%s\" does not exist",
+					Option.cacheDir);
+		if (Option.etags)
+			error (FATAL, "%s Emacs style tags", notice);
+		if (Option.xref)
+			error (FATAL, "%s xref output", notice);
+		if (Option.json)
+			error (FATAL, "%s JSON output", notice);
+	}
+	if (Option.daemon)
+	{
+#ifndef DAEMON_SUPPORTED
+		error (FATAL, "daemon mode is not supported on this host");
+#endif
+		Option.incremental = TRUE;
+	}
+	if (Option.incremental)
+	{
+		notice = "incremental mode is not compatible with";
+		if (isDestinationStdout ())
+			error (FATAL, "%s tags to stdout", notice);
+		if (Option.etags)
+			error (FATAL, "%s Emacs style tags", notice);
+		if (Option.xref)
+			error (FATAL, "%s xref output", notice);
+		if (Option.append)
+			error (FATAL, "%s append mode", notice);
+		if (Option.filter)
+			error (FATAL, "%s filter mode", notice);
+		if (Option.sorted == SO_UNSORTED)
+			error (FATAL, "%s unsorted tags", notice);
+	}
+	if (Option.tagIndex  ||  Option.tagBloom)
+	{
+		if (Option.tagIndex)
+			notice = "the tag index is not compatible with";
+		else
+			notice = "the tag Bloom filter is not compatible with";
+		if (isDestinationStdout ())
+			error (FATAL, "%s tags to stdout", notice);
+		if (Option.etags)
+			error (FATAL, "%s Emacs style tags", notice);
+		if (Option.xref)
+			error (FATAL, "%s xref output", notice);
+		if (Option.filter)
+			error (FATAL, "%s filter mode", notice);
+	}
+	if (Option.merge)
+	{
+		notice = "merge mode is not compatible with";
+		if (Option.etags)
+			error (FATAL, "%s Emacs style tags", notice);
+		if (Option.xref)
+			error (FATAL, "%s xref output", notice);
+		if (Option.json)
+			error (FATAL, "%s JSON output", notice);
+		if (Option.append)
+			error (FATAL, "%s append mode", notice);
+		if (Option.incremental)
+			error (FATAL, "%s incremental mode", notice);
+		if (Option.filter)
+			error (FATAL, "%s filter mode", notice);
+	}
 	if (Option.filter)
 	{
 		notice = "filter mode";
 		if (Option.printTotals)
 		{
 			error (WARNING, "%s disables totals", notice);
-			Option.printTotals = FALSE;
+			Option.printTotals = TOTALS_NONE;
 		}
 		if (Option.tagFileName != NULL)
 			error (WARNING, "%s ignores output tag file name", notice);
 	}
+	if (Option.server)
+	{
+		notice = "server mode is not compatible with";
+		if (Option.etags)
+			error (FATAL, "%s Emacs style tags", notice);
+		if (Option.xref)
+			error (FATAL, "%s xref output", notice);
+		if (Option.filter)
+			error (FATAL, "%s filter mode", notice);
+		if (Option.merge)
+			error (FATAL, "%s merge mode", notice);
+		if (Option.printTotals)
+		{
+			error (WARNING, "server mode disables totals");
+			Option.printTotals = TOTALS_NONE;
+		}
+		if (Option.tagFileName != NULL)
+			error (WARNING, "server mode ignores output tag file name");
+	}
 }
 
 static void setEtagsMode (void)
@@ -729,10 +1028,63 @@ static void processEtagsInclude (
 	}
 }
 
+static void addNamedFile (
+		stringList **const list, const char *const option,
+		const char *const parameter)
+{
+	if (parameter [0] == '\0')
+		error (FATAL, "A file name must be specified for \"%s\" option", option);
+	if (*list == NULL)
+		*list = stringListNew ();
+	stringListAdd (*list, vStringNewInit (parameter));
+	Option.append = TRUE;
+}
+
+static void processRemoveFileOption (
+		const char *const option, const char *const parameter)
+{
+	addNamedFile (&Option.removeFiles, option, parameter);
+}
+
+static void processUpdateFileOption (
+		const char *const option, const char *const parameter)
+{
+	addNamedFile (&Option.updateFiles, option, parameter);
+}
+
+/*  Adds an output written from the same tags as the tag file, given as
+ *  "format:file", where the format is one of those which write each tag as
+ *  it is made.
+ */
+static void processExtraOutputOption (
+		const char *const option, const char *const parameter)
+{
+	static const char *const formats [] = { "etags", "xref", "json", NULL };
+	const char *const colon = strchr (parameter, ':');
+	boolean known = FALSE;
+	int i;
+
+	for (i = 0  ;  colon != NULL  &&  formats [i] != NULL  ;  ++i)
+		if (strlen (formats [i]) == (size_t) (colon - parameter)  &&
+			strncmp (parameter, formats [i], colon - parameter) == 0)
+			known = TRUE;
+	if (! known)
+		error (FATAL, "Unknown output format for \"%s\" option: \"%s\"",
+				option, parameter);
+	if (colon [1] == '\0')
+		error (FATAL, "A file name must be specified for \"%s\" option",
+				option);
+	if (Option.extraOutputs == NULL)
+		Option.extraOutputs = stringListNew ();
+	stringListAdd (Option.extraOutputs, vStringNewInit (parameter));
+}
+
 static void processExcludeOption (
 		const char *const option __unused__, const char *const parameter)
 {
 	const char *const fileName = parameter + 1;
+	globSetDelete (ExcludedSet);
+	ExcludedSet = NULL;
 	if (parameter [0] == '\0')
 		freeList (&Excluded);
 	else if (parameter [0] == '@')
@@ -762,9 +1114,14 @@ extern boolean isExcludedFile (const char* const name)
 	boolean result = FALSE;
 	if (Excluded != NULL)
 	{
-		result = stringListFileMatched (Excluded, base);
+		if (ExcludedSet == NULL)
+		{
+			ExcludedSet = globSetNew ();
+			globSetAddList (ExcludedSet, Excluded, 0);
+		}
+		result = (boolean) (globSetMatch (ExcludedSet, base) != -1);
 		if (! result  &&  name != base)
-			result = stringListFileMatched (Excluded, name);
+			result = (boolean) (globSetMatch (ExcludedSet, name) != -1);
 	}
 #ifdef AMIGA
 	/* not a good solution, but the only one which works often */
@@ -870,6 +1227,7 @@ static void processFilterTerminatorOption (
 		const char *const option __unused__, const char *const parameter)
 {
 	freeString (&Option.filterTerminator);
+	freeString (&Option.cacheDir);
 	Option.filterTerminator = stringCopy (parameter);
 }
 
@@ -886,6 +1244,143 @@ static void processFormatOption (
 		error (FATAL, "Unsupported value for \"%s\" option", option);
 }
 
+static void processJobsOption (
+		const char *const option, const char *const parameter)
+{
+	unsigned int jobs;
+	char extra;
+
+	if (parameter [0] == '-'  ||
+		sscanf (parameter, "%u%c", &jobs, &extra) != 1  ||  jobs < 1)
+		error (FATAL, "Invalid value for \"%s\" option", option);
+#ifndef JOBS_SUPPORTED
+	else if (jobs > 1)
+		error (WARNING, "%s option not supported on this host", option);
+#endif
+	else if (jobs > MAX_JOBS)
+	{
+		error (WARNING, "%s option limited to %d", option, MAX_JOBS);
+		Option.jobs = MAX_JOBS;
+	}
+	else
+		Option.jobs = jobs;
+}
+
+static void processCacheDirOption (
+		const char *const option __unused__, const char *const parameter)
+{
+	freeString (&Option.cacheDir);
+	Option.cacheDir = stringCopy (parameter);
+}
+
+static void processCacheSizeOption (
+		const char *const option, const char *const parameter)
+{
+	unsigned long megabytes;
+	char extra;
+
+	if (sscanf (parameter, "%lu%c", &megabytes, &extra) != 1)
+		error (FATAL, "Invalid value for \"%s\" option", option);
+#ifndef CACHE_TRIMMING_SUPPORTED
+	else if (megabytes > 0)
+		error (WARNING, "%s option not supported on this host", option);
+#endif
+	else
+		Option.cacheSize = megabytes;
+}
+
+static void processSortMemoryOption (
+		const char *const option, const char *const parameter)
+{
+	unsigned long megabytes;
+	char extra;
+
+	if (sscanf (parameter, "%lu%c", &megabytes, &extra) != 1)
+		error (FATAL, "Invalid value for \"%s\" option", option);
+	Option.sortMemory = megabytes;
+}
+
+static void processMaxFileSizeOption (
+		const char *const option, const char *const parameter)
+{
+	unsigned long megabytes;
+	char extra;
+
+	if (sscanf (parameter, "%lu%c", &megabytes, &extra) != 1)
+		error (FATAL, "Invalid value for \"%s\" option", option);
+	Option.maxFileSize = megabytes;
+}
+
+static void processMaxFileTimeOption (
+		const char *const option, const char *const parameter)
+{
+	unsigned long seconds;
+	char extra;
+
+	if (sscanf (parameter, "%lu%c", &seconds, &extra) != 1)
+		error (FATAL, "Invalid value for \"%s\" option", option);
+	Option.maxFileTime = seconds;
+}
+
+static void processMinFileRateOption (
+		const char *const option, const char *const parameter)
+{
+	unsigned long kilobytes;
+	char extra;
+
+	if (sscanf (parameter, "%lu%c", &kilobytes, &extra) != 1)
+		error (FATAL, "Invalid value for \"%s\" option", option);
+	Option.minFileRate = kilobytes;
+}
+
+static void processOversizedOption (
+		const char *const option, const char *const parameter)
+{
+	if (strcmp (parameter, "outline") == 0)
+		Option.skipOversized = FALSE;
+	else if (strcmp (parameter, "skip") == 0)
+		Option.skipOversized = TRUE;
+	else
+		error (FATAL, "Invalid value for \"%s\" option", option);
+}
+
+static void processPatternLengthLimitOption (
+		const char *const option, const char *const parameter)
+{
+	unsigned long bytes;
+	char extra;
+
+	if (sscanf (parameter, "%lu%c", &bytes, &extra) != 1)
+		error (FATAL, "Invalid value for \"%s\" option", option);
+	Option.patternLengthLimit = bytes;
+}
+
+static void processSyntheticTagsOption (
+		const char *const option, const char *const parameter)
+{
+	unsigned long count;
+	char extra;
+
+	if (sscanf (parameter, "%lu%c", &count, &extra) != 1)
+		error (FATAL, "Invalid value for \"%s\" option", option);
+	Option.syntheticTags = count;
+}
+
+static void processShardOption (
+		const char *const option, const char *const parameter)
+{
+	unsigned int index, count;
+	char extra;
+
+	if (sscanf (parameter, "%u/%u%c", &index, &count, &extra) != 2  ||
+		count < 1  ||  index < 1  ||  index > count)
+	{
+		error (FATAL, "Invalid value for \"%s\" option", option);
+	}
+	Option.shard.index = index;
+	Option.shard.count = count;
+}
+
 static void printInvocationDescription (void)
 {
 	printf (INVOCATION, getExecutableName ());
@@ -1214,6 +1709,19 @@ static void processSortOption (
 		error (FATAL, "Invalid value for \"%s\" option", option);
 }
 
+static void processTotalsOption (
+		const char *const option, const char *const parameter)
+{
+	if (parameter [0] == '\0'  ||  isTrue (parameter))
+		Option.printTotals = TOTALS_TEXT;
+	else if (isFalse (parameter))
+		Option.printTotals = TOTALS_NONE;
+	else if (strcasecmp (parameter, "json") == 0)
+		Option.printTotals = TOTALS_JSON;
+	else
+		error (FATAL, "Invalid value for \"%s\" option", option);
+}
+
 static void installHeaderListDefaults (void)
 {
 	Option.headerExt = stringListNewFromArgv (HeaderExtensions);
@@ -1254,6 +1762,105 @@ static void processHeaderListOption (const int option, const char *parameter)
  *  Token ignore processing
  */
 
+/*  The tokens of the ignore list are entered into a hash table, so that an
+ *  identifier is found among them in a single probe. A token "name" or
+ *  "name+" is entered under "name", as is one of the form "name=replacement",
+ *  and the first token entered under a name is the one which applies to it,
+ *  as when the list was searched in order.
+ */
+
+static unsigned int ignoreChain (
+		const ignoreTable *const table, const char *const name,
+		const size_t length)
+{
+	const unsigned long hash = hashBytes (INITIAL_HASH,
+			(const unsigned char *) name, length);
+	return (unsigned int) (hash & (table->size - 1));
+}
+
+static const ignoreEntry *findIgnoreEntry (
+		const ignoreTable *const table, const char *const name,
+		const size_t length)
+{
+	const ignoreEntry *result = NULL;
+	int i = table->chains [ignoreChain (table, name, length)];
+	while (i != -1  &&  result == NULL)
+	{
+		const ignoreEntry *const entry = &table->entries [i];
+		if (entry->length == length  &&  memcmp (entry->name, name, length) == 0)
+			result = entry;
+		else
+			i = entry->next;
+	}
+	return result;
+}
+
+static void addIgnoreEntry (
+		ignoreTable *const table, const char *const name, const size_t length,
+		const boolean ignoreParens, const char *const replacement)
+{
+	if (findIgnoreEntry (table, name, length) == NULL)
+	{
+		ignoreEntry *entry;
+		unsigned int k;
+		if (table->count == table->max)
+		{
+			table->max *= 2;
+			table->entries = xRealloc (table->entries, table->max, ignoreEntry);
+		}
+		entry = &table->entries [table->count];
+		k = ignoreChain (table, name, length);
+		entry->name = name;
+		entry->length = length;
+		entry->ignoreParens = ignoreParens;
+		entry->replacement = replacement;
+		entry->next = table->chains [k];
+		table->chains [k] = (int) table->count++;
+	}
+}
+
+static ignoreTable *buildIgnoreTable (const stringList *const list)
+{
+	ignoreTable *const table = xMalloc (1, ignoreTable);
+	const unsigned int count = stringListCount (list);
+	unsigned int i;
+
+	table->max = 2 * count + 1;
+	table->entries = xMalloc (table->max, ignoreEntry);
+	table->count = 0;
+	for (table->size = 16  ;  table->size < 4 * count  ;  table->size *= 2)
+		;
+	table->chains = xMalloc (table->size, int);
+	for (i = 0  ;  i < table->size  ;  ++i)
+		table->chains [i] = -1;
+	for (i = 0  ;  i < count  ;  ++i)
+	{
+		const vString *const token = stringListItem (list, i);
+		const char *const name = vStringValue (token);
+		const size_t length = vStringLength (token);
+		const char *equals;
+
+		addIgnoreEntry (table, name, length, FALSE, NULL);
+		if (length > 0  &&  name [length - 1] == '+')
+			addIgnoreEntry (table, name, length - 1, TRUE, NULL);
+		for (equals = strchr (name, '=')  ;  equals != NULL  ;
+				equals = strchr (equals + 1, '='))
+			addIgnoreEntry (table, name, equals - name, FALSE, equals + 1);
+	}
+	return table;
+}
+
+static void discardIgnoreTable (void)
+{
+	if (IgnoreTable != NULL)
+	{
+		eFree (IgnoreTable->entries);
+		eFree (IgnoreTable->chains);
+		eFree (IgnoreTable);
+		IgnoreTable = NULL;
+	}
+}
+
 /*  Determines whether or not "name" should be ignored, per the ignore list.
  */
 extern boolean isIgnoreToken (
@@ -1264,40 +1871,25 @@ extern boolean isIgnoreToken (
 
 	if (Option.ignore != NULL)
 	{
-		const size_t nameLen = strlen (name);
-		unsigned int i;
+		const ignoreEntry *entry;
 
 		if (pIgnoreParens != NULL)
 			*pIgnoreParens = FALSE;
-
-		for (i = 0  ;  i < stringListCount (Option.ignore)  ;  ++i)
+		if (IgnoreTable == NULL)
+			IgnoreTable = buildIgnoreTable (Option.ignore);
+		entry = findIgnoreEntry (IgnoreTable, name, strlen (name));
+		if (entry == NULL)
+			;
+		else if (entry->replacement != NULL)
 		{
-			vString *token = stringListItem (Option.ignore, i);
-
-			if (strncmp (vStringValue (token), name, nameLen) == 0)
-			{
-				const size_t tokenLen = vStringLength (token);
-
-				if (nameLen == tokenLen)
-				{
-					result = TRUE;
-					break;
-				}
-				else if (tokenLen == nameLen + 1  &&
-						vStringChar (token, tokenLen - 1) == '+')
-				{
-					result = TRUE;
-					if (pIgnoreParens != NULL)
-						*pIgnoreParens = TRUE;
-					break;
-				}
-				else if (vStringChar (token, nameLen) == '=')
-				{
-					if (replacement != NULL)
-						*replacement = vStringValue (token) + nameLen + 1;
-					break;
-				}
-			}
+			if (replacement != NULL)
+				*replacement = entry->replacement;
+		}
+		else
+		{
+			result = TRUE;
+			if (pIgnoreParens != NULL)
+				*pIgnoreParens = entry->ignoreParens;
 		}
 	}
 	return result;
@@ -1305,6 +1897,7 @@ extern boolean isIgnoreToken (
 
 static void saveIgnoreToken (vString *const ignoreToken)
 {
+	discardIgnoreTable ();
 	if (Option.ignore == NULL)
 		Option.ignore = stringListNew ();
 	stringListAdd (Option.ignore, ignoreToken);
@@ -1331,6 +1924,7 @@ static void addIgnoreListFromFile (const char *const fileName)
 	stringList* tokens = stringListNewFromFile (fileName);
 	if (tokens == NULL)
 		error (FATAL | PERROR, "cannot open \"%s\"", fileName);
+	discardIgnoreTable ();
 	if (Option.ignore == NULL)
 		Option.ignore = tokens;
 	else
@@ -1350,6 +1944,7 @@ static void processIgnoreOption (const char *const list)
 #endif
 	else if (strcmp (list, "-") == 0)
 	{
+		discardIgnoreTable ();
 		freeList (&Option.ignore);
 		verbose ("    clearing list\n");
 	}
@@ -1370,14 +1965,18 @@ static void processVersionOption (
  */
 
 static parametricOption ParametricOptions [] = {
+	{ "cache-dir",              processCacheDirOption,          TRUE    },
+	{ "cache-size",             processCacheSizeOption,         TRUE    },
 	{ "etags-include",          processEtagsInclude,            FALSE   },
 	{ "exclude",                processExcludeOption,           FALSE   },
 	{ "excmd",                  processExcmdOption,             FALSE   },
 	{ "extra",                  processExtraTagsOption,         FALSE   },
+	{ "extra-output",           processExtraOutputOption,       TRUE    },
 	{ "fields",                 processFieldsOption,            FALSE   },
 	{ "filter-terminator",      processFilterTerminatorOption,  TRUE    },
 	{ "format",                 processFormatOption,            TRUE    },
 	{ "help",                   processHelpOption,              TRUE    },
+	{ "jobs",                   processJobsOption,              TRUE    },
 	{ "lang",                   processLanguageForceOption,     FALSE   },
 	{ "language",               processLanguageForceOption,     FALSE   },
 	{ "language-force",         processLanguageForceOption,     FALSE   },
@@ -1388,25 +1987,46 @@ static parametricOption ParametricOptions [] = {
 	{ "list-kinds",             processListKindsOption,         TRUE    },
 	{ "list-maps",              processListMapsOption,          TRUE    },
 	{ "list-languages",         processListLanguagesOption,     TRUE    },
+	{ "max-file-size",          processMaxFileSizeOption,       FALSE   },
+	{ "max-file-time",          processMaxFileTimeOption,       FALSE   },
+	{ "min-file-rate",          processMinFileRateOption,       FALSE   },
 	{ "options",                processOptionFile,              FALSE   },
+	{ "oversized",              processOversizedOption,         FALSE   },
+	{ "pattern-length-limit",   processPatternLengthLimitOption, FALSE  },
+	{ "remove-file",            processRemoveFileOption,        TRUE    },
+	{ "shard",                  processShardOption,             TRUE    },
 	{ "sort",                   processSortOption,              TRUE    },
+	{ "sort-memory",            processSortMemoryOption,        TRUE    },
+	{ "synthetic-tags",         processSyntheticTagsOption,     TRUE    },
+	{ "totals",                 processTotalsOption,            TRUE    },
+	{ "update-file",            processUpdateFileOption,        TRUE    },
 	{ "version",                processVersionOption,           TRUE    },
 };
 
 static booleanOption BooleanOptions [] = {
 	{ "append",         &Option.append,                 TRUE    },
+	{ "archives",       &Option.archives,               FALSE   },
+	{ "compress",       &Option.compress,               TRUE    },
+	{ "daemon",         &Option.daemon,                 TRUE    },
 	{ "file-scope",     &Option.include.fileScope,      FALSE   },
 	{ "file-tags",      &Option.include.fileNames,      FALSE   },
 	{ "filter",         &Option.filter,                 TRUE    },
+	{ "git-files",      &Option.gitFiles,               TRUE    },
 	{ "if0",            &Option.if0,                    FALSE   },
+	{ "incremental",    &Option.incremental,            TRUE    },
+	{ "json",           &Option.json,                   TRUE    },
 	{ "kind-long",      &Option.kindLong,               TRUE    },
 	{ "line-directives",&Option.lineDirectives,         FALSE   },
 	{ "links",          &Option.followLinks,            FALSE   },
+	{ "merge",          &Option.merge,                  TRUE    },
+	{ "profile-regex",  &Option.profileRegex,           TRUE    },
+	{ "server",         &Option.server,                 TRUE    },
 #ifdef RECURSE_SUPPORTED
 	{ "recurse",        &Option.recurse,                FALSE   },
 #endif
+	{ "tag-bloom",      &Option.tagBloom,               TRUE    },
+	{ "tag-index",      &Option.tagIndex,               TRUE    },
 	{ "tag-relative",   &Option.tagRelative,            TRUE    },
-	{ "totals",         &Option.printTotals,            TRUE    },
 	{ "verbose",        &Option.verbose,                FALSE   },
 };
 
@@ -1479,6 +2099,30 @@ static boolean processBooleanOption (
 	return found;
 }
 
+/*  Adds an option to the fingerprint of those which affect the tags generated
+ *  for each source file.
+ */
+static void addToFingerprint (const char *const option, const char *const parameter)
+{
+	boolean neutral = FALSE;
+	int i;
+	for (i = 0  ;  FingerprintNeutralOptions [i] != NULL  &&  ! neutral  ;  ++i)
+		neutral = (boolean) (strcmp (option, FingerprintNeutralOptions [i]) == 0);
+	if (! neutral)
+	{
+		const char *const value = (parameter == NULL) ? "" : parameter;
+		Fingerprint = hashBytes (Fingerprint,
+				(const unsigned char *) option, strlen (option) + 1);
+		Fingerprint = hashBytes (Fingerprint,
+				(const unsigned char *) value, strlen (value) + 1);
+	}
+}
+
+extern unsigned long optionFingerprint (void)
+{
+	return Fingerprint;
+}
+
 static void processLongOption (
 		const char *const option, const char *const parameter)
 {
@@ -1487,6 +2131,7 @@ static void processLongOption (
 		verbose ("  Option: --%s\n", option);
 	else
 		verbose ("  Option: --%s=%s\n", option, parameter);
+	addToFingerprint (option, parameter);
 
 	if (processBooleanOption (option, parameter))
 		;
@@ -1511,6 +2156,7 @@ static void processShortOption (
 		verbose ("  Option: -%s\n", option);
 	else
 		verbose ("  Option: -%s %s\n", option, parameter);
+	addToFingerprint (option, parameter);
 
 	if (isCompoundOption (*option) && (parameter == NULL  ||  parameter [0] == '\0'))
 		error (FATAL, "Missing parameter for \"%s\" option", option);
@@ -1820,9 +2466,15 @@ extern void freeOptionResources (void)
 	freeString (&Option.filterTerminator);
 
 	freeList (&Excluded);
+	globSetDelete (ExcludedSet);
+	ExcludedSet = NULL;
+	discardIgnoreTable ();
 	freeList (&Option.ignore);
 	freeList (&Option.headerExt);
 	freeList (&Option.etagsInclude);
+	freeList (&Option.removeFiles);
+	freeList (&Option.updateFiles);
+	freeList (&Option.extraOutputs);
 	freeList (&OptionFiles);
 }
 
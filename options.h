@@ -59,6 +59,12 @@ typedef enum sortType {
 	SO_FOLDSORTED
 } sortType;
 
+typedef enum eTotalsType {
+	TOTALS_NONE,
+	TOTALS_TEXT,  /* --totals=yes */
+	TOTALS_JSON   /* --totals=json */
+} totalsType;
+
 struct sInclude {
 	boolean fileNames;      /* include tags for source file names */
 	boolean qualifiedTags;  /* include tags for qualified class members */
@@ -105,9 +111,34 @@ typedef struct sOptionValues {
 	boolean followLinks;    /* --link  follow symbolic links? */
 	boolean filter;         /* --filter  behave as filter: files in, tags out */
 	char* filterTerminator; /* --filter-terminator  string to output */
+	boolean server;         /* --server  answer requests: contents in, tags out */
+	boolean json;           /* --json  write tags as JSON lines instead */
+	boolean gitFiles;       /* --git-files  tag the files tracked by git */
+	boolean archives;       /* --archives  tag the members of archives */
+	boolean compress;       /* --compress  compress the tag file in blocks */
 	boolean tagRelative;    /* --tag-relative file paths relative to tag file */
-	boolean printTotals;    /* --totals  print cumulative statistics */
+	totalsType printTotals; /* --totals  print cumulative statistics */
 	boolean lineDirectives; /* --linedirectives  process #line directives */
+	unsigned int jobs;      /* --jobs  number of files to tag concurrently */
+	struct sShard { unsigned int index, count; } shard;/* --shard  share of files */
+	boolean merge;          /* --merge  merge sorted tag files */
+	unsigned long sortMemory;/* --sort-memory  megabytes of tags held to sort */
+	boolean incremental;    /* --incremental  re-tag only changed files */
+	boolean daemon;         /* --daemon  re-tag files as they change */
+	stringList* removeFiles;/* --remove-file  files whose tags are removed */
+	stringList* updateFiles;/* --update-file  files whose tags are replaced */
+	stringList* extraOutputs;/* --extra-output  "format:file" also written */
+	char* cacheDir;         /* --cache-dir  directory of cached tags */
+	unsigned long cacheSize;/* --cache-size  megabytes of cached tags kept */
+	boolean tagIndex;       /* --tag-index  write binary index of tag file */
+	boolean tagBloom;       /* --tag-bloom  write Bloom filter of tag names */
+	boolean profileRegex;   /* --profile-regex  report cost of regex patterns */
+	unsigned long maxFileSize;/* --max-file-size  megabytes of largest file tagged fully */
+	unsigned long maxFileTime;/* --max-file-time  seconds allowed to tag a file */
+	unsigned long minFileRate;/* --min-file-rate  kilobytes a second to read a file */
+	boolean skipOversized;  /* --oversized  skip files beyond these limits */
+	unsigned long patternLengthLimit;/* --pattern-length-limit  bytes of line in a pattern */
+	unsigned long syntheticTags;/* --synthetic-tags  number of synthetic tags made */
 #ifdef DEBUG
 	long debugLevel;        /* -D  debugging output */
 	unsigned long breakLine;/* -b  source line at which to call lineBreak() */
@@ -127,6 +158,7 @@ extern void freeList (stringList** const pString);
 extern void setDefaultTagFileName (void);
 extern void checkOptions (void);
 extern boolean filesRequired (void);
+extern unsigned long optionFingerprint (void);
 extern void testEtagsInvocation (void);
 
 extern cookedArgs* cArgNewFromString (const char* string);
@@ -17,16 +17,46 @@
 
 #include <string.h>
 
+#include "archive.h"
+#include "cache.h"
 #include "debug.h"
 #include "entry.h"
+#include "globset.h"
+#include "jobs.h"
 #include "main.h"
 #define OPTION_WRITE
 #include "options.h"
 #include "parsers.h" 
 #include "read.h"
 #include "routines.h"
+#include "trace.h"
 #include "vstring.h"
 
+/*
+*   DATA DECLARATIONS
+*/
+
+/*  An entry in the table mapping file extensions to languages. The extension
+ *  points into the currentExtensions of its language, so the table must be
+ *  rebuilt before use whenever any language map has changed, as must
+ *  PatternSet.
+ */
+typedef struct sExtensionEntry {
+	struct sExtensionEntry *next;  /* next entry in hash chain */
+	const char *extension;
+	langType language;
+} extensionEntry;
+
+/*  A file among those which took longest to parse, for --totals.
+ */
+typedef struct sSlowFile {
+	char *name;
+	langType language;
+	double elapsed;
+} slowFile;
+
+enum { SlowFileCount = 10 };  /* slowest files reported */
+
 /*
 *   DATA DEFINITIONS
 */
@@ -34,6 +64,14 @@ static parserDefinitionFunc* BuiltInParsers[] = { PARSER_LIST };
 static parserDefinition** LanguageTable = NULL;
 static unsigned int LanguageCount = 0;
 
+static extensionEntry **ExtensionTable = NULL;
+static extensionEntry *ExtensionEntries = NULL;
+static unsigned int ExtensionTableSize = 0;  /* always a power of 2 */
+static globSet *PatternSet = NULL;  /* currentPatterns of every language */
+static boolean LanguageMapsStale = TRUE;
+static slowFile SlowFiles [SlowFileCount];  /* slowest first */
+static unsigned int SlowFilesFound = 0;
+
 /*
 *   FUNCTION DEFINITIONS
 */
@@ -92,30 +130,120 @@ extern langType getNamedLanguage (const char *const name)
 	return result;
 }
 
-static langType getExtensionLanguage (const char *const extension)
+static unsigned int extensionIndex (const char *const extension)
 {
-	langType result = LANG_IGNORE;
-	unsigned int i;
-	for (i = 0  ;  i < LanguageCount  &&  result == LANG_IGNORE  ;  ++i)
+	unsigned long hash = INITIAL_HASH;
+	const char *p;
+	for (p = extension  ;  *p != '\0'  ;  ++p)
 	{
-		stringList* const exts = LanguageTable [i]->currentExtensions;
-		if (exts != NULL  &&  stringListExtensionMatched (exts, extension))
-			result = i;
+#ifdef CASE_INSENSITIVE_FILENAMES
+		const unsigned char c = (unsigned char) tolower ((int) *p);
+#else
+		const unsigned char c = (unsigned char) *p;
+#endif
+		hash = hashBytes (hash, &c, 1);
+	}
+	return (unsigned int) (hash & (ExtensionTableSize - 1));
+}
+
+static boolean extensionsEqual (const char *const a, const char *const b)
+{
+#ifdef CASE_INSENSITIVE_FILENAMES
+	return (boolean) (strcasecmp (a, b) == 0);
+#else
+	return (boolean) (strcmp (a, b) == 0);
+#endif
+}
+
+static extensionEntry *findExtensionEntry (const char *const extension)
+{
+	extensionEntry *entry = ExtensionTable [extensionIndex (extension)];
+	while (entry != NULL  &&  ! extensionsEqual (entry->extension, extension))
+		entry = entry->next;
+	return entry;
+}
+
+static void freeLanguageMapTables (void)
+{
+	globSetDelete (PatternSet);
+	PatternSet = NULL;
+	if (ExtensionTable != NULL)
+		eFree (ExtensionTable);
+	if (ExtensionEntries != NULL)
+		eFree (ExtensionEntries);
+	ExtensionTable = NULL;
+	ExtensionEntries = NULL;
+	ExtensionTableSize = 0;
+	LanguageMapsStale = TRUE;
+}
+
+/*  Rebuilds the extension table and pattern set from the current language
+ *  maps. Where a name is mapped to more than one language, the first
+ *  language in LanguageTable wins, as it did when the maps were searched in
+ *  turn.
+ */
+static void buildLanguageMapTables (void)
+{
+	unsigned int count = 0;
+	unsigned int used = 0;
+	unsigned int i, j;
+
+	freeLanguageMapTables ();
+	for (i = 0  ;  i < LanguageCount  ;  ++i)
+	{
+		const stringList* const exts = LanguageTable [i]->currentExtensions;
+		if (exts != NULL)
+			count += stringListCount (exts);
+	}
+	ExtensionTableSize = 16;
+	while (ExtensionTableSize < 2 * count)
+		ExtensionTableSize *= 2;
+	ExtensionTable = xCalloc (ExtensionTableSize, extensionEntry*);
+	if (count > 0)
+		ExtensionEntries = xMalloc (count, extensionEntry);
+	PatternSet = globSetNew ();
+	for (i = 0  ;  i < LanguageCount  ;  ++i)
+	{
+		const stringList* const exts = LanguageTable [i]->currentExtensions;
+		for (j = 0  ;  exts != NULL  &&  j < stringListCount (exts)  ;  ++j)
+		{
+			const char* const extension = vStringValue (stringListItem (exts, j));
+			if (findExtensionEntry (extension) == NULL)
+			{
+				extensionEntry* const entry = &ExtensionEntries [used++];
+				const unsigned int k = extensionIndex (extension);
+				entry->extension = extension;
+				entry->language = (langType) i;
+				entry->next = ExtensionTable [k];
+				ExtensionTable [k] = entry;
+			}
+		}
+		globSetAddList (PatternSet, LanguageTable [i]->currentPatterns, (int) i);
 	}
+	LanguageMapsStale = FALSE;
+}
+
+static langType getExtensionLanguage (const char *const extension)
+{
+	langType result = LANG_IGNORE;
+	const extensionEntry* entry;
+	if (LanguageMapsStale)
+		buildLanguageMapTables ();
+	entry = findExtensionEntry (extension);
+	if (entry != NULL)
+		result = entry->language;
 	return result;
 }
 
 static langType getPatternLanguage (const char *const fileName)
 {
 	langType result = LANG_IGNORE;
-	const char* base = baseFilename (fileName);
-	unsigned int i;
-	for (i = 0  ;  i < LanguageCount  &&  result == LANG_IGNORE  ;  ++i)
-	{
-		stringList* const ptrns = LanguageTable [i]->currentPatterns;
-		if (ptrns != NULL  &&  stringListFileMatched (ptrns, base))
-			result = i;
-	}
+	int language;
+	if (LanguageMapsStale)
+		buildLanguageMapTables ();
+	language = globSetMatch (PatternSet, baseFilename (fileName));
+	if (language != -1)
+		result = (langType) language;
 	return result;
 }
 
@@ -140,45 +268,62 @@ static vString* determineInterpreter (const char* const cmd)
 	return interpreter;
 }
 
+/*  The head of the file is read through fileReadHead (), which leaves the
+ *  file open for fileOpen () should the file then be parsed.
+ */
 static langType getInterpreterLanguage (const char *const fileName)
 {
 	langType result = LANG_IGNORE;
-	FILE* const fp = fopen (fileName, "r");
-	if (fp != NULL)
+	size_t length;
+	const char* const head = fileReadHead (fileName, &length);
+	if (head != NULL  &&  head [0] == '#'  &&  head [1] == '!')
 	{
-		vString* const vLine = vStringNew ();
-		const char* const line = readLine (vLine, fp);
-		if (line != NULL  &&  line [0] == '#'  &&  line [1] == '!')
-		{
-			const char* const lastSlash = strrchr (line, '/');
-			const char *const cmd = lastSlash != NULL ? lastSlash+1 : line+2;
-			vString* const interpreter = determineInterpreter (cmd);
-			result = getExtensionLanguage (vStringValue (interpreter));
-			if (result == LANG_IGNORE)
-				result = getNamedLanguage (vStringValue (interpreter));
-			vStringDelete (interpreter);
-		}
-		vStringDelete (vLine);
-		fclose (fp);
+		const char* const end = strpbrk (head, "\r\n");
+		vString* const line = vStringNew ();
+		const char* lastSlash;
+		const char* cmd;
+		vString* interpreter;
+
+		vStringNCopyS (line, head, end == NULL ? length : (size_t) (end - head));
+		lastSlash = strrchr (vStringValue (line), '/');
+		cmd = lastSlash != NULL ? lastSlash+1 : vStringValue (line) + 2;
+		interpreter = determineInterpreter (cmd);
+		result = getExtensionLanguage (vStringValue (interpreter));
+		if (result == LANG_IGNORE)
+			result = getNamedLanguage (vStringValue (interpreter));
+		vStringDelete (interpreter);
+		vStringDelete (line);
 	}
 	return result;
 }
 
 #endif
 
+/*  Determines the language of a file from its name alone, without reading
+ *  any of it.
+ */
+extern langType getFileNameLanguage (const char *const fileName)
+{
+	langType language = getExtensionLanguage (fileExtension (fileName));
+	if (language == LANG_IGNORE)
+		language = getPatternLanguage (fileName);
+	return language;
+}
+
 extern langType getFileLanguage (const char *const fileName)
 {
 	langType language = Option.language;
 	if (language == LANG_AUTO)
 	{
-		language = getExtensionLanguage (fileExtension (fileName));
-		if (language == LANG_IGNORE)
-			language = getPatternLanguage (fileName);
+		language = getFileNameLanguage (fileName);
 #ifdef SYS_INTERPRETER
 		if (language == LANG_IGNORE)
 		{
+			/*  A file which does not exist may yet have contents supplied
+			 *  for it (see fileSupplyContents ()).
+			 */
 			fileStatus *status = eStat (fileName);
-			if (status->isExecutable)
+			if (status->isExecutable  ||  ! status->exists)
 				language = getInterpreterLanguage (fileName);
 		}
 #endif
@@ -231,6 +376,7 @@ extern void installLanguageMapDefault (const langType language)
 		lang->currentExtensions =
 			stringListNewFromArgv (lang->extensions);
 	}
+	LanguageMapsStale = TRUE;
 	if (Option.verbose)
 		printLanguageMap (language);
 	verbose ("\n");
@@ -251,6 +397,7 @@ extern void clearLanguageMap (const langType language)
 	Assert (0 <= language  &&  language < (int) LanguageCount);
 	stringListClear (LanguageTable [language]->currentPatterns);
 	stringListClear (LanguageTable [language]->currentExtensions);
+	LanguageMapsStale = TRUE;
 }
 
 extern void addLanguagePatternMap (const langType language, const char* ptrn)
@@ -262,6 +409,7 @@ extern void addLanguagePatternMap (const langType language, const char* ptrn)
 	if (lang->currentPatterns == NULL)
 		lang->currentPatterns = stringListNew ();
 	stringListAdd (lang->currentPatterns, str);
+	LanguageMapsStale = TRUE;
 }
 
 extern boolean removeLanguageExtensionMap (const char *const extension)
@@ -274,6 +422,7 @@ extern boolean removeLanguageExtensionMap (const char *const extension)
 		if (exts != NULL  &&  stringListRemoveExtension (exts, extension))
 		{
 			verbose (" (removed from %s)", getLanguageName (i));
+			LanguageMapsStale = TRUE;
 			result = TRUE;
 		}
 	}
@@ -287,6 +436,7 @@ extern void addLanguageExtensionMap (
 	Assert (0 <= language  &&  language < (int) LanguageCount);
 	removeLanguageExtensionMap (extension);
 	stringListAdd (LanguageTable [language]->currentExtensions, str);
+	LanguageMapsStale = TRUE;
 }
 
 extern void enableLanguage (const langType language, const boolean state)
@@ -302,12 +452,24 @@ extern void enableLanguages (const boolean state)
 		enableLanguage (i, state);
 }
 
-static void initializeParsers (void)
+/*  Initializes the parser of a language, such as by building its keyword
+ *  table, when the first file of the language is to be parsed, so that a
+ *  run costs nothing for languages it does not meet.
+ */
+extern void initializeParser (const langType language)
 {
-	unsigned int i;
-	for (i = 0  ;  i < LanguageCount  ;  ++i)
-		if (LanguageTable [i]->initialize != NULL)
-			(LanguageTable [i]->initialize) ((langType) i);
+	parserDefinition* lang;
+	Assert (0 <= language  &&  language < (int) LanguageCount);
+	lang = LanguageTable [language];
+	if (! lang->initialized)
+	{
+		lang->initialized = TRUE;
+		if (lang->initialize != NULL)
+			(lang->initialize) (language);
+#ifdef HAVE_REGEX
+		prepareRegex (language);
+#endif
+	}
 }
 
 extern void initializeParsing (void)
@@ -350,7 +512,6 @@ extern void initializeParsing (void)
 	}
 	verbose ("\n");
 	enableLanguages (TRUE);
-	initializeParsers ();
 }
 
 extern void freeParserResources (void)
@@ -365,10 +526,14 @@ extern void freeParserResources (void)
 		lang->name = NULL;
 		eFree (lang);
 	}
+	for (i = 0  ;  i < SlowFilesFound  ;  ++i)
+		eFree (SlowFiles [i].name);
+	SlowFilesFound = 0;
 	if (LanguageTable != NULL)
 		eFree (LanguageTable);
 	LanguageTable = NULL;
 	LanguageCount = 0;
+	freeLanguageMapTables ();
 }
 
 /*
@@ -395,6 +560,7 @@ extern void processLanguageDefineOption (
 		def->id                = i;
 		LanguageTable = xRealloc (LanguageTable, i + 1, parserDefinition*);
 		LanguageTable [i] = def;
+		LanguageMapsStale = TRUE;
 	}
 #else
 	error (WARNING, "regex support not available; required for --%s option",
@@ -582,6 +748,65 @@ extern void printLanguageList (void)
 *   File parsing
 */
 
+/*  Returns a hash of the names and kinds of all of the parsers, which differs
+ *  between builds of ctags with different sets of parsers.
+ */
+extern unsigned long parserFingerprint (void)
+{
+	unsigned long hash = INITIAL_HASH;
+	unsigned int i, k;
+
+	for (i = 0  ;  i < LanguageCount  ;  ++i)
+	{
+		const parserDefinition* const lang = LanguageTable [i];
+		hash = hashBytes (hash, (const unsigned char *) lang->name,
+				strlen (lang->name) + 1);
+		for (k = 0  ;  k < lang->kindCount  ;  ++k)
+		{
+			const kindOption* const kind = lang->kinds + k;
+			const unsigned char letter = (unsigned char) kind->letter;
+			hash = hashBytes (hash, &letter, 1);
+			if (kind->name != NULL)
+				hash = hashBytes (hash, (const unsigned char *) kind->name,
+						strlen (kind->name) + 1);
+		}
+	}
+	return hash;
+}
+
+/*  Determines whether the parser of a language carries state from one file
+ *  to the next, so that the tags of a file may depend on those before it.
+ */
+extern boolean isLanguageSerial (const langType language)
+{
+	Assert (0 <= language  &&  language < (int) LanguageCount);
+	return LanguageTable [language]->serial;
+}
+
+/*  Determines whether a file must be parsed in sequence with the other files
+ *  of its language, rather than concurrently with them, because its parser
+ *  carries state from one file to the next.
+ */
+extern boolean isSerialParsingRequired (const char *const fileName)
+{
+	boolean result = FALSE;
+	boolean anySerial = FALSE;
+	unsigned int i;
+
+	for (i = 0  ;  i < LanguageCount  &&  ! anySerial  ;  ++i)
+		anySerial = (boolean) (LanguageTable [i]->serial  &&
+				LanguageTable [i]->enabled);
+	if (anySerial)
+	{
+		langType language = Option.language;
+		if (language == LANG_AUTO)
+			language = getFileLanguage (fileName);
+		if (language != LANG_IGNORE)
+			result = LanguageTable [language]->serial;
+	}
+	return result;
+}
+
 static void makeFileTag (const char *const fileName)
 {
 	if (Option.include.fileNames)
@@ -603,75 +828,358 @@ static boolean createTagsForFile (
 		const char *const fileName, const langType language,
 		const unsigned int passCount)
 {
+	const parserDefinition* lang;
 	boolean retried = FALSE;
 	Assert (0 <= language  &&  language < (int) LanguageCount);
-	if (fileOpen (fileName, language))
-	{
-		const parserDefinition* const lang = LanguageTable [language];
-		if (Option.etags)
-			beginEtagsFile ();
+	lang = LanguageTable [language];
+	if (Option.etags)
+		beginEtagsFile ();
 
+	if (passCount == 1  &&  tagsFromCache (fileName, language))
+		;  /* tags were copied from the cache */
+	else
+	{
+		beginCachedTags ();
 		makeFileTag (fileName);
 
-		if (lang->parser != NULL)
+		if (lang->regex  &&  tagInputInChunks (lang->parser))
+			abandonCachedTags ();  /* matched by several jobs */
+		else if (lang->parser != NULL)
 			lang->parser ();
 		else if (lang->parser2 != NULL)
 			retried = lang->parser2 (passCount);
 
-		if (Option.etags)
-			endEtagsFile (getSourceFileTagPath ());
-
-		fileClose ();
+		if (! retried)
+		{
+#ifdef HAVE_REGEX
+			matchMultilineRegex (language);
+#endif
+			if (File.stopped)
+				abandonCachedTags ();  /* depends upon the time taken */
+			storeCachedTags ();
+		}
 	}
 
+	if (Option.etags)
+		endEtagsFile (getSourceFileTagPath ());
+
 	return retried;
 }
 
+/*  Parses the file once, or again for as long as its parser asks to. The file
+ *  is opened only once, and the tags of a pass which is retried are
+ *  discarded, mostly without having been written to the tag file. So are
+ *  those of a file which was not read to its end within --max-file-time
+ *  or --min-file-rate, if such files are to be skipped.
+ */
 static boolean createTagsWithFallback (
 		const char *const fileName, const langType language)
 {
-	const unsigned long numTags	= TagFile.numTags.added;
-	fpos_t tagFilePosition;
+	tagFilePosition tagFilePosition;
 	unsigned int passCount = 0;
 	boolean tagFileResized = FALSE;
 
-	fgetpos (TagFile.fp, &tagFilePosition);
-	while (createTagsForFile (fileName, language, ++passCount))
+	initializeParser (language);
+	if (fileOpen (fileName, language))
 	{
-		/*  Restore prior state of tag file.
-		 */
-		fsetpos (TagFile.fp, &tagFilePosition);
-		TagFile.numTags.added = numTags;
-		tagFileResized = TRUE;
+		if (File.outline)
+			error (WARNING, "%s: larger than --max-file-size, %s", fileName,
+					"so tagging only top-level definitions");
+		beginFileTags ();
+		getTagFilePosition (&tagFilePosition);
+		while (createTagsForFile (fileName, language, ++passCount))
+		{
+			/*  Restore prior state of tag file.
+			 */
+			setTagFilePosition (&tagFilePosition);
+			fileRewind ();
+			tagFileResized = TRUE;
+			++LanguageTable [language]->totals.rescans;
+			TracePoint2 (parse__retry, fileName, passCount + 1);
+		}
+		if (File.stopped  &&  Option.skipOversized)
+		{
+			error (WARNING, "%s: not read within %s, so skipped",
+					fileName, File.stopLimit);
+			setTagFilePosition (&tagFilePosition);
+			tagFileResized = TRUE;
+		}
+		else if (File.stopped)
+			error (WARNING, "%s: not read within %s, %s %lu",
+					fileName, File.stopLimit, "so tagged only to line",
+					File.lineNumber);
+		endFileTags ();
+		fileClose ();
 	}
 	return tagFileResized;
 }
 
-extern boolean parseFile (const char *const fileName)
+/*  Notes a file which took "elapsed" seconds to parse, if it is among the
+ *  slowest so far.
+ */
+static void noteSlowFile (
+		const char *const fileName, const langType language,
+		const double elapsed)
+{
+	if (SlowFilesFound < SlowFileCount  ||
+		elapsed > SlowFiles [SlowFileCount - 1].elapsed)
+	{
+		unsigned int i;
+		if (SlowFilesFound == SlowFileCount)
+			eFree (SlowFiles [--SlowFilesFound].name);
+		for (i = SlowFilesFound  ;
+				i > 0  &&  SlowFiles [i - 1].elapsed < elapsed  ;  --i)
+			SlowFiles [i] = SlowFiles [i - 1];
+		SlowFiles [i].name = eStrdup (fileName);
+		SlowFiles [i].language = language;
+		SlowFiles [i].elapsed = elapsed;
+		++SlowFilesFound;
+	}
+}
+
+/*  Parses a file as createTagsWithFallback () does, adding what was spent on
+ *  it to the totals of its language.
+ */
+static boolean createTagsCounted (
+		const char *const fileName, const langType language)
+{
+	languageTotals *const totals = &LanguageTable [language]->totals;
+	const unsigned long tags = TagFile.numTags.added;
+	const unsigned long allocations = allocationCount ();
+	const double start = elapsedTime ();
+	const double cpu = processorTime ();
+	unsigned long files, lines, bytes, bytesBefore;
+	boolean resized;
+	double elapsed;
+
+	getTotals (&files, &lines, &bytesBefore);
+	resized = createTagsWithFallback (fileName, language);
+	elapsed = elapsedTime () - start;
+	getTotals (&files, &lines, &bytes);
+	++totals->files;
+	totals->bytes += bytes - bytesBefore;
+	totals->tags += TagFile.numTags.added - tags;
+	totals->allocations += allocationCount () - allocations;
+	totals->elapsed += elapsed;
+	totals->cpu += processorTime () - cpu;
+	noteSlowFile (fileName, language, elapsed);
+	return resized;
+}
+
+/*  Parses a file as a file of the given language, as parseFile () does.
+ */
+extern boolean parseFileAs (const char *const fileName, const langType language)
 {
 	boolean tagFileResized = FALSE;
-	langType language = Option.language;
-	if (Option.language == LANG_AUTO)
-		language = getFileLanguage (fileName);
 	Assert (language != LANG_AUTO);
 	if (language == LANG_IGNORE)
 		verbose ("ignoring %s (unknown language)\n", fileName);
 	else if (! LanguageTable [language]->enabled)
 		verbose ("ignoring %s (language disabled)\n", fileName);
+	else if (Option.skipOversized  &&  isOversizedFile (fileName))
+		error (WARNING, "%s: larger than --max-file-size, so skipped", fileName);
 	else
 	{
 		if (Option.filter)
 			openTagFile ();
 
-		tagFileResized = createTagsWithFallback (fileName, language);
+		TracePoint2 (parse__begin, fileName, language);
+		PushMemoryAccount (MEMORY_PARSER);
+		if (Option.printTotals)
+			tagFileResized = createTagsCounted (fileName, language);
+		else
+			tagFileResized = createTagsWithFallback (fileName, language);
+		PopMemoryAccount ();
+		TracePoint2 (parse__end, fileName, TagFile.numTags.added);
 
 		if (Option.filter)
 			closeTagFile (tagFileResized);
 		addTotals (1, 0L, 0L);
+	}
+	fileReleaseHead ();
+	return tagFileResized;
+}
 
-		return tagFileResized;
+extern boolean parseFile (const char *const fileName)
+{
+	boolean tagFileResized;
+	if (isArchiveFile (fileName))
+		tagFileResized = parseArchive (fileName);
+	else
+	{
+		langType language = Option.language;
+		if (Option.language == LANG_AUTO)
+			language = getFileLanguage (fileName);
+		tagFileResized = parseFileAs (fileName, language);
 	}
 	return tagFileResized;
 }
 
+/*  Forgets the totals of each language and the slowest files, so that what
+ *  a worker process reports is only what it adds.
+ */
+extern void clearLanguageTotals (void)
+{
+	unsigned int i;
+	for (i = 0  ;  i < LanguageCount  ;  ++i)
+		memset (&LanguageTable [i]->totals, 0, sizeof (languageTotals));
+	for (i = 0  ;  i < SlowFilesFound  ;  ++i)
+		eFree (SlowFiles [i].name);
+	SlowFilesFound = 0;
+}
+
+/*  Writes to "fp" the totals of each language and the slowest files, for
+ *  readLanguageTotals() in another process.
+ */
+extern void writeLanguageTotals (FILE *const fp)
+{
+	boolean ok = TRUE;
+	unsigned int i;
+	for (i = 0  ;  ok  &&  i < LanguageCount  ;  ++i)
+		ok = (boolean) (fwrite (&LanguageTable [i]->totals,
+				sizeof (languageTotals), 1, fp) == 1);
+	if (ok)
+		ok = (boolean) (fwrite (&SlowFilesFound,
+				sizeof (SlowFilesFound), 1, fp) == 1);
+	for (i = 0  ;  ok  &&  i < SlowFilesFound  ;  ++i)
+	{
+		const slowFile *const file = &SlowFiles [i];
+		const size_t length = strlen (file->name);
+		ok = (boolean) (
+			fwrite (&file->language, sizeof (file->language), 1, fp) == 1  &&
+			fwrite (&file->elapsed, sizeof (file->elapsed), 1, fp) == 1  &&
+			fwrite (&length, sizeof (length), 1, fp) == 1  &&
+			fwrite (file->name, 1, length, fp) == length);
+	}
+	if (! ok)
+		error (FATAL | PERROR, "cannot write language totals");
+}
+
+/*  Adds the totals written by writeLanguageTotals() to "fp" to our own,
+ *  returning whether they were read.
+ */
+extern boolean readLanguageTotals (FILE *const fp)
+{
+	boolean ok = TRUE;
+	unsigned int count = 0;
+	unsigned int i;
+	for (i = 0  ;  ok  &&  i < LanguageCount  ;  ++i)
+	{
+		languageTotals *const totals = &LanguageTable [i]->totals;
+		languageTotals added;
+		if (fread (&added, sizeof (added), 1, fp) != 1)
+			ok = FALSE;
+		else
+		{
+			totals->files += added.files;
+			totals->bytes += added.bytes;
+			totals->tags += added.tags;
+			totals->rescans += added.rescans;
+			totals->allocations += added.allocations;
+			totals->elapsed += added.elapsed;
+			totals->cpu += added.cpu;
+		}
+	}
+	if (ok  &&  fread (&count, sizeof (count), 1, fp) != 1)
+		ok = FALSE;
+	for (i = 0  ;  ok  &&  i < count  ;  ++i)
+	{
+		langType language;
+		double elapsed;
+		size_t length;
+		if (fread (&language, sizeof (language), 1, fp) != 1  ||
+			fread (&elapsed, sizeof (elapsed), 1, fp) != 1  ||
+			fread (&length, sizeof (length), 1, fp) != 1)
+		{
+			ok = FALSE;
+		}
+		else
+		{
+			char *const name = xMalloc (length + 1, char);
+			if (fread (name, 1, length, fp) != length)
+				ok = FALSE;
+			else
+			{
+				name [length] = '\0';
+				noteSlowFile (name, language, elapsed);
+			}
+			eFree (name);
+		}
+	}
+	return ok;
+}
+
+/*  Prints, for --totals, how many files of each language had to be parsed
+ *  more than once.
+ */
+extern void printLanguageRescans (void)
+{
+	unsigned int i;
+	for (i = 0  ;  i < LanguageCount  ;  ++i)
+	{
+		const unsigned long rescans = LanguageTable [i]->totals.rescans;
+		if (rescans > 0)
+			fprintf (errout, "%lu %s rescan%s\n", rescans,
+					LanguageTable [i]->name, rescans == 1 ? "" : "s");
+	}
+}
+
+/*  Adds up the totals of all languages.
+ */
+extern void sumLanguageTotals (languageTotals *const sum)
+{
+	unsigned int i;
+	memset (sum, 0, sizeof (languageTotals));
+	for (i = 0  ;  i < LanguageCount  ;  ++i)
+	{
+		const languageTotals *const totals = &LanguageTable [i]->totals;
+		sum->files += totals->files;
+		sum->bytes += totals->bytes;
+		sum->tags += totals->tags;
+		sum->rescans += totals->rescans;
+		sum->allocations += totals->allocations;
+		sum->elapsed += totals->elapsed;
+		sum->cpu += totals->cpu;
+	}
+}
+
+/*  Prints, for --totals=json, the members of the totals object describing
+ *  each language of which files were parsed, and the slowest files.
+ */
+extern void printLanguageTotalsJson (FILE *const fp)
+{
+	boolean first = TRUE;
+	unsigned int i;
+
+	fputs ("  \"languages\": [", fp);
+	for (i = 0  ;  i < LanguageCount  ;  ++i)
+	{
+		const languageTotals *const totals = &LanguageTable [i]->totals;
+		if (totals->files == 0)
+			continue;
+		fputs (first ? "\n    {\"name\": " : ",\n    {\"name\": ", fp);
+		printJsonString (fp, LanguageTable [i]->name);
+		fprintf (fp, ", \"files\": %lu, \"bytes\": %lu, \"tags\": %lu, "
+				"\"rescans\": %lu, \"allocations\": %lu, \"elapsed\": %.6f, "
+				"\"cpu\": %.6f, \"bytesPerSecond\": %.0f}",
+				totals->files, totals->bytes, totals->tags, totals->rescans,
+				totals->allocations, totals->elapsed, totals->cpu,
+				totals->elapsed > 0.0 ?
+					(double) totals->bytes / totals->elapsed : 0.0);
+		first = FALSE;
+	}
+	fputs (first ? "],\n" : "\n  ],\n", fp);
+
+	fputs ("  \"slowest\": [", fp);
+	for (i = 0  ;  i < SlowFilesFound  ;  ++i)
+	{
+		fputs (i == 0 ? "\n    {\"file\": " : ",\n    {\"file\": ", fp);
+		printJsonString (fp, SlowFiles [i].name);
+		fputs (", \"language\": ", fp);
+		printJsonString (fp, LanguageTable [SlowFiles [i].language]->name);
+		fprintf (fp, ", \"elapsed\": %.6f}", SlowFiles [i].elapsed);
+	}
+	fputs (SlowFilesFound == 0 ? "],\n" : "\n  ],\n", fp);
+}
+
 /* vi:set tabstop=4 shiftwidth=4 nowrap: */
@@ -15,6 +15,9 @@
 *   INCLUDE FILES
 */
 #include "general.h"  /* must always come first */
+
+#include <stdio.h>  /* to declare FILE */
+
 #include "parsers.h"  /* contains list of parsers */
 #include "strlist.h"
 
@@ -43,6 +46,15 @@ typedef struct sKindOption {
 	const char* description;  /* displayed in --help output */
 } kindOption;
 
+/*  What was spent on the files of a language, for --totals.
+ */
+typedef struct sLanguageTotals {
+	unsigned long files, bytes, tags;
+	unsigned long rescans;         /* files parsed again */
+	unsigned long allocations;     /* blocks of memory allocated */
+	double elapsed, cpu;           /* seconds spent parsing */
+} languageTotals;
+
 typedef struct {
 	/* defined by parser */
 	char* name;                    /* name of language */
@@ -54,12 +66,15 @@ typedef struct {
 	simpleParser parser;           /* simple parser (common case) */
 	rescanParser parser2;          /* rescanning parser (unusual case) */
 	boolean regex;                 /* is this a regex parser? */
+	boolean serial;                /* keeps state from one file to the next? */
 
 	/* used internally */
 	unsigned int id;               /* id assigned to language */
 	boolean enabled;               /* currently enabled? */
+	boolean initialized;           /* has initialize been called? */
 	stringList* currentPatterns;   /* current list of file name patterns */
 	stringList* currentExtensions; /* current list of extensions */
+	languageTotals totals;         /* for --totals */
 } parserDefinition;
 
 typedef parserDefinition* (parserDefinitionFunc) (void);
@@ -89,7 +104,11 @@ extern void makeSimpleTag (const vString* const name, kindOption* const kinds, c
 extern parserDefinition* parserNew (const char* name);
 extern const char *getLanguageName (const langType language);
 extern langType getNamedLanguage (const char *const name);
+extern langType getFileNameLanguage (const char *const fileName);
 extern langType getFileLanguage (const char *const fileName);
+extern unsigned long parserFingerprint (void);
+extern boolean isLanguageSerial (const langType language);
+extern boolean isSerialParsingRequired (const char *const fileName);
 extern void installLanguageMapDefault (const langType language);
 extern void installLanguageMapDefaults (void);
 extern void clearLanguageMap (const langType language);
@@ -101,6 +120,7 @@ extern void printLanguageMaps (const langType language);
 extern void enableLanguages (const boolean state);
 extern void enableLanguage (const langType language, const boolean state);
 extern void initializeParsing (void);
+extern void initializeParser (const langType language);
 extern void freeParserResources (void);
 extern void processLanguageDefineOption (const char *const option, const char *const parameter);
 extern boolean processKindOption (const char *const option, const char *const parameter);
@@ -108,11 +128,21 @@ extern void printKindOptions (void);
 extern void printLanguageKinds (const langType language);
 extern void printLanguageList (void);
 extern boolean parseFile (const char *const fileName);
+extern boolean parseFileAs (const char *const fileName, const langType language);
+extern void clearLanguageTotals (void);
+extern void writeLanguageTotals (FILE *const fp);
+extern boolean readLanguageTotals (FILE *const fp);
+extern void printLanguageRescans (void);
+extern void sumLanguageTotals (languageTotals *const sum);
+extern void printLanguageTotalsJson (FILE *const fp);
 
 /* Regex interface */
 #ifdef HAVE_REGEX
 extern void findRegexTags (void);
 extern boolean matchRegex (const vString* const line, const langType language);
+extern boolean hasRegexPatterns (const langType language);
+extern void matchMultilineRegex (const langType language);
+extern void prepareRegex (const langType language);
 #endif
 extern boolean processRegexOption (const char *const option, const char *const parameter);
 extern void addLanguageRegex (const langType language, const char* const regex);
@@ -123,6 +153,10 @@ extern boolean enableRegexKind (const langType language, const int kind, const b
 extern void printRegexKinds (const langType language, boolean indent);
 extern void freeRegexResources (void);
 extern void checkRegex (void);
+extern void clearRegexProfile (void);
+extern void writeRegexProfile (FILE *const fp);
+extern boolean readRegexProfile (FILE *const fp);
+extern void printRegexProfile (void);
 
 #endif  /* _PARSE_H */
 
@@ -7,8 +7,9 @@
 *   GNU General Public License.
 *
 *   This module contains functions for generating tags for the PHP web page
-*   scripting language. Only recognizes functions and classes, not methods or
-*   variables.
+*   scripting language. Only recognizes functions, classes, interfaces,
+*   constant definitions and variables, and the JavaScript functions of the
+*   page.
 *
 *   Parsing PHP defines by Pavel Hlousek <pavel.hlousek@seznam.cz>, Apr 2003.
 */
@@ -28,194 +29,320 @@
 *   DATA DEFINITIONS
 */
 typedef enum {
-	K_CLASS, K_DEFINE, K_FUNCTION, K_VARIABLE
+	K_CLASS, K_INTERFACE, K_DEFINE, K_FUNCTION, K_VARIABLE, K_JSFUNCTION
 } phpKind;
 
-#if 0
 static kindOption PhpKinds [] = {
-	{ TRUE, 'c', "class",    "classes" },
-	{ TRUE, 'd', "define",   "constant definitions" },
-	{ TRUE, 'f', "function", "functions" },
-	{ TRUE, 'v', "variable", "variables" }
+	{ TRUE, 'c', "class",      "classes" },
+	{ TRUE, 'i', "interface",  "interfaces" },
+	{ TRUE, 'd', "define",     "constant definitions" },
+	{ TRUE, 'f', "function",   "functions" },
+	{ TRUE, 'v', "variable",   "variables" },
+	{ TRUE, 'j', "jsfunction", "javascript functions" }
+};
+
+/*  The statements recognized, in the order in which their tags are made for
+ *  a line. Each statement is tagged at most once per line, where it first
+ *  begins at the start of the line or after a blank, as the regular
+ *  expressions which this parser replaced were.
+ */
+typedef enum {
+	S_CLASS, S_INTERFACE, S_DEFINE, S_FUNCTION, S_ASSIGNMENT, S_DECLARATION,
+	S_JS_FUNCTION, S_JS_MEMBER, STATEMENT_COUNT
+} phpStatement;
+
+typedef struct sPhpMatch {
+	boolean found;
+	const unsigned char *name;
+	size_t length;
+	const unsigned char *member;  /* last member of a dotted JavaScript name */
+} phpMatch;
+
+static const char *const Declarations [] = {
+	"var", "public", "protected", "private", "static", NULL
 };
-#endif
 
 /*
 *   FUNCTION DEFINITIONS
 */
 
-/* JavaScript patterns are duplicated in jscript.c */
-
-/*
- * Cygwin doesn't support non-ASCII characters in character classes.
- * This isn't a good solution to the underlying problem, because we're still
- * making assumptions about the character encoding.
- * Really, these regular expressions need to concentrate on what marks the
- * end of an identifier, and we need something like iconv to take into
- * account the user's locale (or an override on the command-line.)
- */
-#ifdef __CYGWIN__
-#define ALPHA "[:alpha:]"
-#define ALNUM "[:alnum:]"
-#else
-#define ALPHA "A-Za-z\x7f-\xff"
-#define ALNUM "0-9A-Za-z\x7f-\xff"
-#endif
-
-static void installPHPRegex (const langType language)
-{
-	addTagRegex(language, "(^|[ \t])class[ \t]+([" ALPHA "_][" ALNUM "_]*)",
-		"\\2", "c,class,classes", NULL);
-	addTagRegex(language, "(^|[ \t])interface[ \t]+([" ALPHA "_][" ALNUM "_]*)",
-		"\\2", "i,interface,interfaces", NULL);
-	addTagRegex(language, "(^|[ \t])define[ \t]*\\([ \t]*['\"]?([" ALPHA "_][" ALNUM "_]*)",
-		"\\2", "d,define,constant definitions", NULL);
-	addTagRegex(language, "(^|[ \t])function[ \t]+&?[ \t]*([" ALPHA "_][" ALNUM "_]*)",
-		"\\2", "f,function,functions", NULL);
-	addTagRegex(language, "(^|[ \t])(\\$|::\\$|\\$this->)([" ALPHA "_][" ALNUM "_]*)[ \t]*=",
-		"\\3", "v,variable,variables", NULL);
-	addTagRegex(language, "(^|[ \t])(var|public|protected|private|static)[ \t]+\\$([" ALPHA "_][" ALNUM "_]*)[ \t]*[=;]",
-		"\\3", "v,variable,variables", NULL);
-
-	/* function regex is covered by PHP regex */
-	addTagRegex (language, "(^|[ \t])([A-Za-z0-9_]+)[ \t]*[=:][ \t]*function[ \t]*\\(",
-		"\\2", "j,jsfunction,javascript functions", NULL);
-	addTagRegex (language, "(^|[ \t])([A-Za-z0-9_.]+)\\.([A-Za-z0-9_]+)[ \t]*=[ \t]*function[ \t]*\\(",
-		"\\2.\\3", "j,jsfunction,javascript functions", NULL);
-	addTagRegex (language, "(^|[ \t])([A-Za-z0-9_.]+)\\.([A-Za-z0-9_]+)[ \t]*=[ \t]*function[ \t]*\\(",
-		"\\3", "j,jsfunction,javascript functions", NULL);
-}
-
-/* Create parser definition structure */
-extern parserDefinition* PhpParser (void)
+static boolean isBlank (const int c)
 {
-	static const char *const extensions [] = { "php", "php3", "phtml", NULL };
-	parserDefinition* def = parserNew ("PHP");
-	def->extensions = extensions;
-	def->initialize = installPHPRegex;
-	def->regex      = TRUE;
-	return def;
+	return (boolean) (c == ' '  ||  c == '\t');
 }
 
-#if 0
+/*  Characters 127 to 255 are taken to be letters, whatever the encoding. */
+static boolean isIdentInitial (const int c)
+{
+	return (boolean) ((c >= 'A'  &&  c <= 'Z')  ||  (c >= 'a'  &&  c <= 'z')  ||
+			c == '_'  ||  c >= 0x7f);
+}
 
-static boolean isLetter(const int c)
+static boolean isIdentChar (const int c)
 {
-	return (boolean)(isalpha(c) || (c >= 127  &&  c <= 255));
+	return (boolean) (isIdentInitial (c)  ||  (c >= '0'  &&  c <= '9'));
 }
 
-static boolean isVarChar1(const int c)
+static boolean isJsIdentChar (const int c)
 {
-	return (boolean)(isLetter (c)  ||  c == '_');
+	return (boolean) ((c >= 'A'  &&  c <= 'Z')  ||  (c >= 'a'  &&  c <= 'z')  ||
+			(c >= '0'  &&  c <= '9')  ||  c == '_');
 }
 
-static boolean isVarChar(const int c)
+static const unsigned char *skipBlanks (const unsigned char *cp)
 {
-	return (boolean)(isVarChar1 (c) || isdigit (c));
+	while (isBlank ((int) *cp))
+		++cp;
+	return cp;
 }
 
-static void findPhpTags (void)
+static boolean matchWord (const unsigned char *const cp, const char *const word)
 {
-	vString *name = vStringNew ();
-	const unsigned char *line;
+	return (boolean) (strncmp ((const char *) cp, word, strlen (word)) == 0);
+}
 
-	while ((line = fileReadLine ()) != NULL)
+/*  Matches an identifier beginning at "cp", returning the position following
+ *  it, or NULL if there is none.
+ */
+static const unsigned char *matchIdentifier (
+		const unsigned char *cp, phpMatch *const match)
+{
+	const unsigned char *result = NULL;
+	if (isIdentInitial ((int) *cp))
 	{
-		const unsigned char *cp = line;
-		const char* f;
+		match->name = cp;
+		while (isIdentChar ((int) *cp))
+			++cp;
+		match->length = cp - match->name;
+		result = cp;
+	}
+	return result;
+}
 
-		while (isspace (*cp))
-			cp++;
+/*  Matches "class Name" or "interface Name". */
+static boolean matchKeywordName (
+		const unsigned char *cp, const char *const keyword,
+		phpMatch *const match)
+{
+	const size_t length = strlen (keyword);
+	boolean result = FALSE;
+	if (matchWord (cp, keyword)  &&  isBlank ((int) cp [length]))
+		result = (boolean) (matchIdentifier (skipBlanks (cp + length),
+				match) != NULL);
+	return result;
+}
 
-		if (*(const char*)cp == '$'  &&  isVarChar1 (*(const char*)(cp+1)))
+/*  Matches "define (" followed by an identifier, which may be quoted. */
+static boolean matchDefine (const unsigned char *cp, phpMatch *const match)
+{
+	boolean result = FALSE;
+	if (matchWord (cp, "define"))
+	{
+		cp = skipBlanks (cp + 6);
+		if (*cp == '(')
 		{
-			cp += 1;
-			vStringClear (name);
-			while (isVarChar ((int) *cp))
-			{
-				vStringPut (name, (int) *cp);
-				++cp;
-			}
-			while (isspace ((int) *cp))
+			cp = skipBlanks (cp + 1);
+			if (*cp == '\''  ||  *cp == '"')
 				++cp;
-			if (*(const char*) cp == '=')
-			{
-				vStringTerminate (name);
-				makeSimpleTag (name, PhpKinds, K_VARIABLE);
-				vStringClear (name);
-			}
+			result = (boolean) (matchIdentifier (cp, match) != NULL);
 		}
-		else if ((f = strstr ((const char*) cp, "function")) != NULL &&
-			(f == (const char*) cp || isspace ((int) f [-1])) &&
-			isspace ((int) f [8]))
-		{
-			cp = ((const unsigned char *) f) + 8;
+	}
+	return result;
+}
 
-			while (isspace ((int) *cp))
-				++cp;
+/*  Matches "function name" or "function &name". */
+static boolean matchFunction (const unsigned char *cp, phpMatch *const match)
+{
+	boolean result = FALSE;
+	if (matchWord (cp, "function")  &&  isBlank ((int) cp [8]))
+	{
+		cp = skipBlanks (cp + 8);
+		if (*cp == '&')
+			cp = skipBlanks (cp + 1);
+		result = (boolean) (matchIdentifier (cp, match) != NULL);
+	}
+	return result;
+}
 
-			if (*cp == '&')	/* skip reference character and following whitespace */
-			{
-				cp++;
+static boolean isAssignment (const unsigned char *const cp)
+{
+	return (boolean) (cp != NULL  &&  *skipBlanks (cp) == '=');
+}
 
-				while (isspace ((int) *cp))
-					++cp; 
-			}
+/*  Matches "$name =", "::$name =" or "$this->name =". */
+static boolean matchAssignment (const unsigned char *cp, phpMatch *const match)
+{
+	boolean result = FALSE;
+	if (*cp == '$')
+		result = isAssignment (matchIdentifier (cp + 1, match));
+	else if (matchWord (cp, "::$"))
+		result = isAssignment (matchIdentifier (cp + 3, match));
+	if (! result  &&  matchWord (cp, "$this->"))
+		result = isAssignment (matchIdentifier (cp + 7, match));
+	return result;
+}
 
-			vStringClear (name);
-			while (isalnum ((int) *cp)  ||  *cp == '_')
-			{
-				vStringPut (name, (int) *cp);
-				++cp;
-			}
-			vStringTerminate (name);
-			makeSimpleTag (name, PhpKinds, K_FUNCTION);
-			vStringClear (name);
-		} 
-		else if (strncmp ((const char*) cp, "class", (size_t) 5) == 0 &&
-				 isspace ((int) cp [5]))
+/*  Matches a declaration such as "var $name;" or "private $name =". */
+static boolean matchDeclaration (const unsigned char *cp, phpMatch *const match)
+{
+	boolean result = FALSE;
+	int i;
+	for (i = 0  ;  ! result  &&  Declarations [i] != NULL  ;  ++i)
+	{
+		const size_t length = strlen (Declarations [i]);
+		if (matchWord (cp, Declarations [i])  &&  isBlank ((int) cp [length]))
 		{
-			cp += 5;
-
-			while (isspace ((int) *cp))
-				++cp;
-			vStringClear (name);
-			while (isalnum ((int) *cp)  ||  *cp == '_')
+			const unsigned char *p = skipBlanks (cp + length);
+			if (*p == '$')
 			{
-				vStringPut (name, (int) *cp);
-				++cp;
+				p = matchIdentifier (p + 1, match);
+				if (p != NULL)
+				{
+					p = skipBlanks (p);
+					result = (boolean) (*p == '='  ||  *p == ';');
+				}
 			}
-			vStringTerminate (name);
-			makeSimpleTag (name, PhpKinds, K_CLASS);
-			vStringClear (name);
+			/* no other declaration begins with the same word */
+			break;
 		}
-		else if (strncmp ((const char*) cp, "define", (size_t) 6) == 0 &&
-				 ! isalnum ((int) cp [6]))
-		{
-			cp += 6;
+	}
+	return result;
+}
 
-			while (isspace ((int) *cp))
-				++cp;
-			if (*cp != '(')
-				continue;
-			++cp;
+static boolean isJsFunction (const unsigned char *cp)
+{
+	boolean result = FALSE;
+	cp = skipBlanks (cp);
+	if (matchWord (cp, "function"))
+		result = (boolean) (*skipBlanks (cp + 8) == '(');
+	return result;
+}
 
-			while (isspace ((int) *cp))
-				++cp;
-			if ((*cp == '\'') || (*cp == '"'))
-				++cp;
-			else if (! ((*cp == '_')  || isalnum ((int) *cp)))
-				continue;
-	      
-			vStringClear (name);
-			while (isalnum ((int) *cp)  ||  *cp == '_')
-			{
-				vStringPut (name, (int) *cp);
+/*  Matches "name = function (" or "name: function (". */
+static boolean matchJsFunction (const unsigned char *cp, phpMatch *const match)
+{
+	boolean result = FALSE;
+	match->name = cp;
+	while (isJsIdentChar ((int) *cp))
+		++cp;
+	match->length = cp - match->name;
+	if (match->length > 0)
+	{
+		cp = skipBlanks (cp);
+		if (*cp == '='  ||  *cp == ':')
+			result = isJsFunction (cp + 1);
+	}
+	return result;
+}
+
+/*  Matches "object.name = function (", where the object may itself be
+ *  dotted.
+ */
+static boolean matchJsMember (const unsigned char *cp, phpMatch *const match)
+{
+	boolean result = FALSE;
+	match->name = cp;
+	match->member = NULL;
+	for ( ;  isJsIdentChar ((int) *cp)  ||  *cp == '.'  ;  ++cp)
+	{
+		if (*cp == '.'  &&  cp > match->name)
+			match->member = cp + 1;
+	}
+	match->length = cp - match->name;
+	if (match->member != NULL  &&  match->member < cp)
+	{
+		cp = skipBlanks (cp);
+		if (*cp == '=')
+			result = isJsFunction (cp + 1);
+	}
+	return result;
+}
+
+/*  Matches each statement not yet found in the line at "cp", which begins
+ *  the line or follows a blank.
+ */
+static void matchStatements (const unsigned char *const cp, phpMatch *const m)
+{
+	switch (*cp)
+	{
+		case 'c':
+			if (! m [S_CLASS].found)
+				m [S_CLASS].found = matchKeywordName (cp, "class", &m [S_CLASS]);
+			break;
+		case 'd':
+			if (! m [S_DEFINE].found)
+				m [S_DEFINE].found = matchDefine (cp, &m [S_DEFINE]);
+			break;
+		case 'f':
+			if (! m [S_FUNCTION].found)
+				m [S_FUNCTION].found = matchFunction (cp, &m [S_FUNCTION]);
+			break;
+		case 'i':
+			if (! m [S_INTERFACE].found)
+				m [S_INTERFACE].found = matchKeywordName (cp, "interface",
+						&m [S_INTERFACE]);
+			break;
+		case 'p': case 's': case 'v':
+			if (! m [S_DECLARATION].found)
+				m [S_DECLARATION].found = matchDeclaration (cp,
+						&m [S_DECLARATION]);
+			break;
+		case '$': case ':':
+			if (! m [S_ASSIGNMENT].found)
+				m [S_ASSIGNMENT].found = matchAssignment (cp, &m [S_ASSIGNMENT]);
+			break;
+		default:
+			break;
+	}
+	if (isJsIdentChar ((int) *cp)  &&  ! m [S_JS_FUNCTION].found)
+		m [S_JS_FUNCTION].found = matchJsFunction (cp, &m [S_JS_FUNCTION]);
+	if ((isJsIdentChar ((int) *cp)  ||  *cp == '.')  &&  ! m [S_JS_MEMBER].found)
+		m [S_JS_MEMBER].found = matchJsMember (cp, &m [S_JS_MEMBER]);
+}
+
+static void makePhpTag (
+		vString *const name, const unsigned char *const start,
+		const size_t length, const phpKind kind)
+{
+	vStringNCopyS (name, (const char *) start, length);
+	makeSimpleTag (name, PhpKinds, kind);
+}
+
+static void findPhpTags (void)
+{
+	static const phpKind kinds [STATEMENT_COUNT] = {
+		K_CLASS, K_INTERFACE, K_DEFINE, K_FUNCTION, K_VARIABLE, K_VARIABLE,
+		K_JSFUNCTION, K_JSFUNCTION
+	};
+	vString *const name = vStringNew ();
+	const unsigned char *line;
+
+	while ((line = fileReadLine ()) != NULL)
+	{
+		phpMatch matches [STATEMENT_COUNT];
+		const unsigned char *cp = line;
+		int i;
+
+		for (i = 0  ;  i < STATEMENT_COUNT  ;  ++i)
+			matches [i].found = FALSE;
+		while (cp != NULL)
+		{
+			matchStatements (cp, matches);
+			cp = (const unsigned char *) strpbrk ((const char *) cp, " \t");
+			if (cp != NULL)
 				++cp;
-			}
-			vStringTerminate (name);
-			makeSimpleTag (name, PhpKinds, K_DEFINE);
-			vStringClear (name);
+		}
+		for (i = 0  ;  i < STATEMENT_COUNT  ;  ++i)
+		{
+			const phpMatch *const m = &matches [i];
+			if (m->found)
+				makePhpTag (name, m->name, m->length, kinds [i]);
+		}
+		if (matches [S_JS_MEMBER].found)
+		{
+			const phpMatch *const m = &matches [S_JS_MEMBER];
+			makePhpTag (name, m->member,
+					m->length - (m->member - m->name), K_JSFUNCTION);
 		}
 	}
 	vStringDelete (name);
@@ -232,6 +359,4 @@ extern parserDefinition* PhpParser (void)
 	return def;
 }
 
-#endif
-
 /* vi:set tabstop=4 shiftwidth=4: */
@@ -42,6 +42,8 @@ struct NestingLevels
 	NestingLevel *levels;
 	int n;					/* number of levels in use */
 	int allocated;
+	int joined;				/* levels in the last parent string, or -1 */
+	boolean joinedClass;	/* whether the last of those is a class */
 };
 
 typedef enum {
@@ -69,6 +71,7 @@ static char const * const doubletriple = "\"\"\"";
 static NestingLevels *nestingLevelsNew (void)
 {
 	NestingLevels *nls = xCalloc (1, NestingLevels);
+	nls->joined = -1;
 	return nls;
 }
 
@@ -95,6 +98,7 @@ static void nestingLevelsPush (NestingLevels *nls,
 	}
 	nl = &nls->levels[nls->n];
 	nls->n++;
+	nls->joined = -1;
 
 	vStringCopy(nl->name, name);
 	nl->type = type;
@@ -259,21 +263,6 @@ static const char *skipIdentifier (const char *cp)
 	return cp;
 }
 
-static const char *findDefinitionOrClass (const char *cp)
-{
-	while (*cp)
-	{
-		cp = skipEverything (cp);
-		if (!strncmp(cp, "def", 3) || !strncmp(cp, "class", 5) ||
-			!strncmp(cp, "cdef", 4) || !strncmp(cp, "cpdef", 5))
-		{
-			return cp;
-		}
-		cp = skipIdentifier (cp);
-	}
-	return NULL;
-}
-
 static const char *skipSpace (const char *cp)
 {
 	while (isspace ((int) *cp))
@@ -368,8 +357,9 @@ static void parseImports (const char *cp)
 
 /* modified from get.c getArglistFromStr().
  * warning: terminates rest of string past arglist!
+ * The arglist is returned in place rather than copied.
  * note: does not ignore brackets inside strings! */
-static char *parseArglist(const char *buf)
+static const char *parseArglist(char *const buf)
 {
 	char *start, *end;
 	int level;
@@ -387,18 +377,16 @@ static char *parseArglist(const char *buf)
 			-- level;
 	}
 	*end = '\0';
-	return strdup(start);
+	return start;
 }
 
+/* "cp" must point into a writable copy of the line; see parseArglist(). */
 static void parseFunction (const char *cp, vString *const def,
 	vString *const parent, int is_class_parent)
 {
-	char *arglist;
-
 	cp = parseIdentifier (cp, def);
-	arglist = parseArglist (cp);
-	makeFunctionTag (def, parent, is_class_parent, arglist);
-	eFree (arglist);
+	makeFunctionTag (def, parent, is_class_parent,
+		parseArglist ((char *) cp));
 }
 
 /* Get the combined name of a nested symbol. Classes are separated with ".",
@@ -418,12 +406,19 @@ static boolean constructParentString(NestingLevels *nls, int indent,
 	int i;
 	NestingLevel *prev = NULL;
 	int is_class = FALSE;
+
+	/* The levels joined do not change between most definitions, so the
+	 * string built last time is kept unless they have. */
+	for (i = 0; i < nls->n && nls->levels[i].indentation < indent; i++)
+		;
+	if (i == nls->joined)
+		return nls->joinedClass;
+	nls->joined = i;
+
 	vStringClear (result);
-	for (i = 0; i < nls->n; i++)
+	for (i = 0; i < nls->joined; i++)
 	{
 		NestingLevel *nl = nls->levels + i;
-		if (indent <= nl->indentation)
-			break;
 		if (prev)
 		{
 			vStringCatS(result, ".");	/* make Geany symbol list grouping work properly */
@@ -438,6 +433,7 @@ static boolean constructParentString(NestingLevels *nls, int indent,
 		is_class = (nl->type == K_CLASS);
 		prev = nl;
 	}
+	nls->joinedClass = is_class;
 	return is_class;
 }
 
@@ -459,6 +455,7 @@ static void checkParent(NestingLevels *nls, int indent, vString *parent)
 			{
 				/* remove this level by clearing its name */
 				vStringClear(n->name);
+				nls->joined = -1;
 			}
 			break;
 		}
@@ -488,6 +485,7 @@ static void addNestingLevel(NestingLevels *nls, int indentation,
 	}
 	nl->indentation = indentation;
 	nl->type = is_class ? K_CLASS : !K_CLASS;
+	nls->joined = -1;
 }
 
 /* Return a pointer to the start of the next triple string, or NULL. Store
@@ -518,6 +516,52 @@ static char const *find_triple_start(char const *string, char const **which)
 	return NULL;
 }
 
+/* Scans a line once, as both find_triple_start() and a search for the first
+ * identifier beginning with "def", "class", "cdef" or "cpdef" would. Returns
+ * the start of the first triple string, or NULL, storing its kind in
+ * "which"; the line is then not parsed for tags, so the keyword is only
+ * stored in "keyword" when there is none. As in skipEverything(), the
+ * character following a single or double quoted string is taken as the
+ * start of an identifier if it can be, and is otherwise passed over.
+ */
+static char const *scanLine(char const *string, char const **which,
+	char const **keyword)
+{
+	char const *cp = string;
+	char const *found = NULL;
+
+	for (; *cp; cp++)
+	{
+		if (*cp == '"' || *cp == '\'')
+		{
+			if (strncmp(cp, doubletriple, 3) == 0)
+			{
+				*which = doubletriple;
+				return cp;
+			}
+			if (strncmp(cp, singletriple, 3) == 0)
+			{
+				*which = singletriple;
+				return cp;
+			}
+			cp = skipString(cp);
+			if (!*cp) break;
+		}
+		if (isIdentifierFirstCharacter ((int) *cp))
+		{
+			if (found == NULL &&
+				(!strncmp(cp, "def", 3) || !strncmp(cp, "class", 5) ||
+				 !strncmp(cp, "cdef", 4) || !strncmp(cp, "cpdef", 5)))
+			{
+				found = cp;
+			}
+			cp = skipIdentifier (cp) - 1;
+		}
+	}
+	*keyword = found;
+	return NULL;
+}
+
 /* Find the end of a triple string as pointed to by "which", and update "which"
  * with any other triple strings following in the given string.
  */
@@ -625,6 +669,7 @@ static void findPythonTags (void)
 		const char *cp = line, *candidate;
 		char const *longstring;
 		char const *keyword, *variable;
+		size_t length;
 		int indent;
 
 		cp = skipSpace (cp);
@@ -636,18 +681,25 @@ static void findPythonTags (void)
 		if (*cp == '#' && !longStringLiteral)
 			continue;
 
-		/* Deal with line continuation. */
-		if (!line_skip) vStringClear(continuation);
-		vStringCatS(continuation, line);
-		vStringStripTrailing(continuation);
-		if (vStringLast(continuation) == '\\')
+		/* Deal with line continuation. A line which neither continues nor
+		 * ends in spaces is used as it is, rather than copied. */
+		length = strlen (line);
+		if (line_skip || isspace ((int) line[length - 1]) ||
+			line[length - 1] == '\\')
 		{
-			vStringChop(continuation);
-			vStringCatS(continuation, " ");
-			line_skip = 1;
-			continue;
+			if (!line_skip) vStringClear(continuation);
+			vStringCatS(continuation, line);
+			vStringStripTrailing(continuation);
+			if (vStringLast(continuation) == '\\')
+			{
+				vStringChop(continuation);
+				vStringCatS(continuation, " ");
+				line_skip = 1;
+				continue;
+			}
+			line = vStringValue(continuation);
 		}
-		cp = line = vStringValue(continuation);
+		cp = line;
 		cp = skipSpace (cp);
 		indent = cp - line;
 		line_skip = 0;
@@ -662,7 +714,7 @@ static void findPythonTags (void)
 		}
 
 		/* Deal with multiline string start. */
-		longstring = find_triple_start(cp, &longStringLiteral);
+		longstring = scanLine(cp, &longStringLiteral, &keyword);
 		if (longstring)
 		{
 			longstring += 3;
@@ -672,11 +724,19 @@ static void findPythonTags (void)
 		}
 
 		/* Deal with def and class keywords. */
-		keyword = findDefinitionOrClass (cp);
 		if (keyword)
 		{
 			boolean found = FALSE;
 			boolean is_class = FALSE;
+
+			/* Parsing may terminate the line or read the lines which
+			 * follow, so it must work on a copy. */
+			if (line != vStringValue(continuation))
+			{
+				vStringCopyS(continuation, line);
+				keyword = vStringValue(continuation) + (keyword - line);
+				line = vStringValue(continuation);
+			}
 			if (!strncmp (keyword, "def ", 4))
 			{
 				cp = skipSpace (keyword + 3);
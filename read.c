@@ -17,6 +17,22 @@
 
 #include <string.h>
 #include <ctype.h>
+#include <time.h>
+
+#if defined (HAVE_SYS_TYPES_H)
+# include <sys/types.h>
+#endif
+#ifdef HAVE_SYS_STAT_H
+# include <sys/stat.h>  /* to declare fstat () */
+#endif
+#if defined (HAVE_MMAP) && defined (HAVE_SYS_MMAN_H)
+# include <sys/mman.h>  /* to declare mmap () */
+# define USE_MAPPED_INPUT 1
+#endif
+#ifdef READ_AHEAD_SUPPORTED
+# include <fcntl.h>  /* to declare open () and posix_fadvise () */
+# include <unistd.h>  /* to declare close () */
+#endif
 
 #define FILE_WRITE
 #include "read.h"
@@ -25,12 +41,98 @@
 #include "main.h"
 #include "routines.h"
 #include "options.h"
+#include "trace.h"
+
+/*
+*   MACROS
+*/
+#ifdef VMS
+# define SOURCE_OPEN_MODE  "r"
+#else
+# define SOURCE_OPEN_MODE  "rb"
+#endif
+#ifdef USE_MAPPED_INPUT
+# ifndef S_ISREG
+#  define S_ISREG(mode)  ((mode) & S_IFREG)
+# endif
+# ifndef MAP_FAILED
+#  define MAP_FAILED  ((void *) -1)
+# endif
+#endif
+
+/*
+*   DATA DECLARATIONS
+*/
+enum eReadLimits {
+	/*  Largest file (in megabytes) which will be mapped into memory when
+	 *  the address space is only 32 bits wide. Larger files are read using
+	 *  stdio instead.
+	 */
+	MaxMappedMegabytes32 = 256,
+
+	/*  Bytes read from the start of a file to determine its language. */
+	FileHeadSize = 256,
+
+	/*  Most bytes read between checks of the time spent on a file, and
+	 *  checks sought in a second spent reading slowly.
+	 */
+	TimeCheckInterval = 16 * 1024,
+	TimeChecksPerSecond = 20,
+
+	/*  Seconds spent on a file before its rate of reading is judged. */
+	RateGraceTime = 1
+};
+
+/*  The head of the file whose language was last determined from its
+ *  contents. The file is left open, so that fileOpen () can read it without
+ *  opening it again.
+ */
+typedef struct sFileHead {
+	vString *name;
+	FILE *fp;
+	char bytes [FileHeadSize + 1];
+	size_t length;
+} fileHead;
+
+/*  Contents supplied in memory for a file, as by a client of server mode,
+ *  which are read in place of the file itself.
+ */
+typedef struct sSuppliedContents {
+	vString *name;
+	const unsigned char *bytes;
+	size_t length;
+} suppliedContents;
+
+/*  The path relative to the tag file of the directory of the last source
+ *  file whose path was worked out, which the other files of the directory,
+ *  usually tagged one after another, share.
+ */
+typedef struct sTagPathCache {
+	vString *directory;      /* directory part of source file name */
+	vString *tagPath;        /* that directory relative to the tag file */
+	char *tagDirectory;      /* directory of the tag file, if valid */
+} tagPathCache;
 
 /*
 *   DATA DEFINITIONS
 */
 inputFile File;  /* globally read through macros */
 static fpos_t StartOfLine;  /* holds deferred position of start of line */
+static boolean LineAltered;  /* current line not read exactly as in file? */
+static fileHead Head;
+static suppliedContents Supplied;
+static clock_t OpenClock;  /* processor time when input file was opened */
+static unsigned long BytesRead;     /* of input file, in lines read or passed */
+static unsigned long BytesChecked;  /* BytesRead at last check of time */
+static unsigned long CheckBytes;    /* to be read before next check */
+static clock_t CheckClock;          /* processor time at last check */
+static unsigned long Readings;  /* times reading has begun, in any file */
+static tagPathCache TagPaths;
+
+/*
+*   FUNCTION PROTOTYPES
+*/
+static void canonicalizeNewline (vString *const vLine);
 
 /*
 *   FUNCTION DEFINITIONS
@@ -38,6 +140,8 @@ static fpos_t StartOfLine;  /* holds deferred position of start of line */
 
 extern void freeSourceFileResources (void)
 {
+	unsigned int i;
+
 	if (File.name != NULL)
 		vStringDelete (File.name);
 	if (File.path != NULL)
@@ -48,6 +152,208 @@ extern void freeSourceFileResources (void)
 		eFree (File.source.tagPath);
 	if (File.line != NULL)
 		vStringDelete (File.line);
+	for (i = 0  ;  i < LineCacheSize  ;  ++i)
+	{
+		if (File.lineCache [i].line != NULL)
+			vStringDelete (File.lineCache [i].line);
+	}
+	if (TagPaths.directory != NULL)
+		vStringDelete (TagPaths.directory);
+	if (TagPaths.tagPath != NULL)
+		vStringDelete (TagPaths.tagPath);
+	if (TagPaths.tagDirectory != NULL)
+		eFree (TagPaths.tagDirectory);
+	memset (&TagPaths, 0, sizeof (TagPaths));
+	fileReleaseHead ();
+	fileReleaseContents ();
+}
+
+/*
+ *   Low level byte access
+ *
+ *   When the input file is mapped into memory, file positions are byte
+ *   offsets into the mapping stored inside an fpos_t. They are only ever
+ *   interpreted by this module, so the encoding remains private.
+ */
+
+static void offsetToPosition (fpos_t *const pos, const size_t offset)
+{
+	memset (pos, 0, sizeof (fpos_t));
+	memcpy (pos, &offset, sizeof (offset));
+}
+
+static size_t positionToOffset (const fpos_t *const pos)
+{
+	size_t offset;
+	memcpy (&offset, pos, sizeof (offset));
+	return offset;
+}
+
+static int readByte (void)
+{
+	int c;
+	if (File.mapped == NULL)
+		c = getc (File.fp);
+	else if (File.mappedOffset < File.mappedEnd)
+		c = File.mapped [File.mappedOffset++];
+	else
+		c = EOF;
+	return c;
+}
+
+static void unreadByte (int c)
+{
+	if (File.mapped == NULL)
+		ungetc (c, File.fp);
+	else if (c != EOF)
+	{
+		Assert (File.mappedOffset > 0);
+		--File.mappedOffset;
+	}
+}
+
+/*  Returns the number of bytes from the current position of a mapped file
+ *  up to the next newline, carriage return or null character, none of
+ *  which therefore need individual examination by iFileGetc ().
+ */
+static size_t mappedSpanLength (void)
+{
+	size_t length = 0;
+
+	if (File.mapped != NULL  &&  File.mappedOffset < File.mappedEnd)
+	{
+		const unsigned char *const start = File.mapped + File.mappedOffset;
+		const unsigned char *end;
+
+		length = File.mappedEnd - File.mappedOffset;
+		end = memchr (start, NEWLINE, length);
+		if (end != NULL)
+			length = end - start;
+		end = memchr (start, CRETURN, length);
+		if (end != NULL)
+			length = end - start;
+		end = memchr (start, '\0', length);
+		if (end != NULL)
+			length = end - start;
+	}
+	return length;
+}
+
+static void getBytePosition (fpos_t *const pos)
+{
+	if (File.mapped == NULL)
+		fgetpos (File.fp, pos);
+	else
+		offsetToPosition (pos, File.mappedOffset);
+}
+
+static void setBytePosition (const fpos_t *const pos)
+{
+	if (File.mapped == NULL)
+		fsetpos (File.fp, pos);
+	else
+		File.mappedOffset = positionToOffset (pos);
+}
+
+#ifdef USE_MAPPED_INPUT
+
+static boolean isMappableFile (const struct stat *const status)
+{
+	const unsigned long megabytes = (unsigned long) (status->st_size >> 20);
+	return (boolean) (S_ISREG (status->st_mode)  &&  status->st_size > 0  &&
+		(sizeof (size_t) > 4  ||  megabytes < MaxMappedMegabytes32)  &&
+		sizeof (fpos_t) >= sizeof (size_t));
+}
+
+/*  Maps the contents of the newly opened input file into memory, if
+ *  possible. Pipes, special files, files too large for the address space,
+ *  and files read in filter mode continue to be read through stdio.
+ */
+static void mapInputFile (void)
+{
+	struct stat status;
+	const int fd = fileno (File.fp);
+
+	if (! Option.filter  &&  fstat (fd, &status) == 0  &&
+		isMappableFile (&status))
+	{
+		const size_t size = (size_t) status.st_size;
+		void *const addr = mmap (NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (addr != MAP_FAILED)
+		{
+			File.mapped       = (const unsigned char *) addr;
+			File.mappedSize   = size;
+			File.mappedOffset = 0;
+			File.mappedEnd    = size;
+		}
+	}
+}
+
+#endif
+
+static void unmapInputFile (void)
+{
+	if (File.mapped != NULL)
+	{
+#ifdef USE_MAPPED_INPUT
+		if (! File.supplied)
+			munmap ((void *) File.mapped, File.mappedSize);
+#endif
+		File.mapped       = NULL;
+		File.mappedSize   = 0;
+		File.mappedOffset = 0;
+		File.mappedEnd    = 0;
+	}
+}
+
+/*
+ *   Recently read line cache
+ */
+
+static void clearLineCache (void)
+{
+	unsigned int i;
+	for (i = 0  ;  i < LineCacheSize  ;  ++i)
+		File.lineCache [i].valid = FALSE;
+	File.lineCacheNext = 0;
+}
+
+static boolean isSamePosition (const fpos_t *const pos1, const fpos_t *const pos2)
+{
+	return (boolean) (memcmp (pos1, pos2, sizeof (fpos_t)) == 0);
+}
+
+/*  Remembers a line just read from the file, starting at "position". Lines
+ *  read from a memory mapping are not cached, because they can be re-read
+ *  from memory just as cheaply.
+ */
+static void cacheLine (const vString *const line, const fpos_t *const position)
+{
+	if (File.mapped == NULL)
+	{
+		cachedLine *const entry = &File.lineCache [File.lineCacheNext];
+
+		if (entry->line == NULL)
+			entry->line = vStringNew ();
+		vStringCopy (entry->line, line);
+		canonicalizeNewline (entry->line);
+		entry->position = *position;
+		entry->valid = TRUE;
+		File.lineCacheNext = (File.lineCacheNext + 1) % LineCacheSize;
+	}
+}
+
+static const cachedLine *findCachedLine (const fpos_t *const position)
+{
+	const cachedLine *result = NULL;
+	unsigned int i;
+	for (i = 0  ;  i < LineCacheSize  &&  result == NULL  ;  ++i)
+	{
+		const cachedLine *const entry = &File.lineCache [i];
+		if (entry->valid  &&  isSamePosition (&entry->position, position))
+			result = entry;
+	}
+	return result;
 }
 
 /*
@@ -75,6 +381,64 @@ static void setInputFileName (const char *const fileName)
 	}
 }
 
+static boolean isTagPathCached (const char *const fileName, const size_t length)
+{
+	return (boolean) (TagPaths.tagDirectory != NULL  &&
+			vStringLength (TagPaths.directory) == length  &&
+			strncmp (vStringValue (TagPaths.directory), fileName, length) == 0  &&
+			strcmp (TagPaths.tagDirectory, TagFile.directory) == 0);
+}
+
+/*  Returns the path of the source file "fileName" relative to the tag file,
+ *  as relativeFilename () does. Only the name of the file need be appended
+ *  to the path of its directory, when that is the directory last seen.
+ */
+static char *relativeTagPath (const char *const fileName)
+{
+	const char *const base = baseFilename (fileName);
+	const size_t directoryLength = base - fileName;
+	const size_t baseLength = strlen (base);
+	char *result;
+
+	if (isTagPathCached (fileName, directoryLength))
+	{
+		const size_t length = vStringLength (TagPaths.tagPath);
+		result = xMalloc (length + baseLength + 1, char);
+		memcpy (result, vStringValue (TagPaths.tagPath), length);
+		memcpy (result + length, base, baseLength + 1);
+	}
+	else
+	{
+		size_t length;
+		result = relativeFilename (fileName, TagFile.directory);
+		length = strlen (result);
+		if (TagPaths.tagDirectory != NULL)
+			eFree (TagPaths.tagDirectory);
+		TagPaths.tagDirectory = NULL;
+
+		/*  The path of the directory is known only if the file name appears
+		 *  whole at the end of the relative path, which it does unless it
+		 *  is "." or "..".
+		 */
+		if (baseLength > 0  &&  length >= baseLength  &&
+			strcmp (result + length - baseLength, base) == 0  &&
+			strcmp (base, ".") != 0  &&  strcmp (base, "..") != 0  &&
+			(length == baseLength  ||
+			 result [length - baseLength - 1] == PATH_SEPARATOR))
+		{
+			if (TagPaths.directory == NULL)
+			{
+				TagPaths.directory = vStringNew ();
+				TagPaths.tagPath = vStringNew ();
+			}
+			vStringNCopyS (TagPaths.directory, fileName, directoryLength);
+			vStringNCopyS (TagPaths.tagPath, result, length - baseLength);
+			TagPaths.tagDirectory = eStrdup (TagFile.directory);
+		}
+	}
+	return result;
+}
+
 static void setSourceFileParameters (vString *const fileName)
 {
 	if (File.source.name != NULL)
@@ -86,14 +450,15 @@ static void setSourceFileParameters (vString *const fileName)
 	if (! Option.tagRelative || isAbsolutePath (vStringValue (fileName)))
 		File.source.tagPath = eStrdup (vStringValue (fileName));
 	else
-		File.source.tagPath =
-				relativeFilename (vStringValue (fileName), TagFile.directory);
+		File.source.tagPath = relativeTagPath (vStringValue (fileName));
 
 	if (vStringLength (fileName) > TagFile.max.file)
 		TagFile.max.file = vStringLength (fileName);
 
 	File.source.isHeader = isIncludeFile (vStringValue (fileName));
 	File.source.language = getFileLanguage (vStringValue (fileName));
+	if (File.source.language != LANG_IGNORE)
+		initializeParser (File.source.language);
 }
 
 static boolean setSourceFileName (vString *const fileName)
@@ -121,7 +486,7 @@ static int skipWhite (void)
 {
 	int c;
 	do
-		c = getc (File.fp);
+		c = readByte ();
 	while (c == ' '  ||  c == '\t');
 	return c;
 }
@@ -133,9 +498,9 @@ static unsigned long readLineNumber (void)
 	while (c != EOF  &&  isdigit (c))
 	{
 		lNum = (lNum * 10) + (c - '0');
-		c = getc (File.fp);
+		c = readByte ();
 	}
-	ungetc (c, File.fp);
+	unreadByte (c);
 	if (c != ' '  &&  c != '\t')
 		lNum = 0;
 
@@ -158,17 +523,17 @@ static vString *readFileName (void)
 
 	if (c == '"')
 	{
-		c = getc (File.fp);  /* skip double-quote */
+		c = readByte ();  /* skip double-quote */
 		quoteDelimited = TRUE;
 	}
 	while (c != EOF  &&  c != '\n'  &&
 			(quoteDelimited ? (c != '"') : (c != ' '  &&  c != '\t')))
 	{
 		vStringPut (fileName, c);
-		c = getc (File.fp);
+		c = readByte ();
 	}
 	if (c == '\n')
-		ungetc (c, File.fp);
+		unreadByte (c);
 	vStringPut (fileName, '\0');
 
 	return fileName;
@@ -182,13 +547,13 @@ static boolean parseLineDirective (void)
 
 	if (isdigit (c))
 	{
-		ungetc (c, File.fp);
+		unreadByte (c);
 		result = TRUE;
 	}
-	else if (c == 'l'  &&  getc (File.fp) == 'i'  &&
-			 getc (File.fp) == 'n'  &&  getc (File.fp) == 'e')
+	else if (c == 'l'  &&  readByte () == 'i'  &&
+			 readByte () == 'n'  &&  readByte () == 'e')
 	{
-		c = getc (File.fp);
+		c = readByte ();
 		if (c == ' '  ||  c == '\t')
 		{
 			DebugStatement ( lineStr = "line"; )
@@ -240,69 +605,409 @@ static boolean parseLineDirective (void)
  *   Source file I/O operations
  */
 
+/*  Returns the first bytes of the file "fileName", terminated by a null,
+ *  storing their number in "length", or NULL if the file cannot be opened.
+ *  The bytes are remembered until fileReleaseHead () is called, or until
+ *  the head of another file is read.
+ */
+extern const char *fileReadHead (
+		const char *const fileName, size_t *const length)
+{
+	const char *result = Head.bytes;
+	if (Head.name == NULL  ||  strcmp (vStringValue (Head.name), fileName) != 0)
+	{
+		fileReleaseHead ();
+		Head.fp = fopen (fileName, SOURCE_OPEN_MODE);
+		if (Head.fp == NULL)
+			result = NULL;
+		else
+		{
+			Head.name = vStringNewInit (fileName);
+			Head.length = fread (Head.bytes, 1, FileHeadSize, Head.fp);
+			if (fseek (Head.fp, 0L, SEEK_SET) != 0)
+			{
+				fclose (Head.fp);
+				Head.fp = NULL;
+			}
+		}
+	}
+	Head.bytes [Head.length] = '\0';
+	*length = Head.length;
+	return result;
+}
+
+/*  Forgets the head of any file read by fileReadHead (), closing the file
+ *  unless fileOpen () has taken it over.
+ */
+extern void fileReleaseHead (void)
+{
+	if (Head.fp != NULL)
+		fclose (Head.fp);
+	Head.fp = NULL;
+	if (Head.name != NULL)
+		vStringDelete (Head.name);
+	Head.name = NULL;
+	Head.length = 0;
+}
+
+/*  Returns the stream left open by fileReadHead () for "fileName", if any,
+ *  which the caller then owns.
+ */
+static FILE *takeHeadStream (const char *const fileName)
+{
+	FILE *fp = NULL;
+	if (Head.fp != NULL  &&  strcmp (vStringValue (Head.name), fileName) == 0)
+	{
+		fp = Head.fp;
+		Head.fp = NULL;
+	}
+	return fp;
+}
+
+/*  Supplies the contents of the file "fileName", which are then read in
+ *  its place, from its head to determine its language to the whole of it
+ *  when it is parsed, whether or not the file exists. The bytes must remain
+ *  until fileReleaseContents () is called.
+ */
+extern void fileSupplyContents (
+		const char *const fileName, const unsigned char *const bytes,
+		const size_t length)
+{
+	fileReleaseContents ();
+	fileReleaseHead ();
+	Supplied.name = vStringNewInit (fileName);
+	Supplied.bytes = bytes;
+	Supplied.length = length;
+
+	Head.name = vStringNewInit (fileName);
+	Head.length = length < FileHeadSize ? length : FileHeadSize;
+	memcpy (Head.bytes, bytes, Head.length);
+}
+
+/*  Forgets the contents supplied by fileSupplyContents ().
+ */
+extern void fileReleaseContents (void)
+{
+	if (Supplied.name != NULL)
+		vStringDelete (Supplied.name);
+	Supplied.name = NULL;
+	Supplied.bytes = NULL;
+	Supplied.length = 0;
+}
+
+static boolean isSuppliedFile (const char *const fileName)
+{
+	return (boolean) (Supplied.name != NULL  &&
+			strcmp (vStringValue (Supplied.name), fileName) == 0);
+}
+
+/*  Reads the supplied contents as though they were a file mapped into
+ *  memory.
+ */
+static void openSuppliedContents (void)
+{
+	File.mapped       = Supplied.bytes;
+	File.mappedSize   = Supplied.length;
+	File.mappedOffset = 0;
+	File.mappedEnd    = Supplied.length;
+	File.supplied     = TRUE;
+}
+
+/*  Closes the input file, or forgets the contents supplied for it.
+ */
+static void releaseInputFile (void)
+{
+	unmapInputFile ();
+	if (File.fp != NULL)
+		fclose (File.fp);
+	File.fp = NULL;
+	File.supplied = FALSE;
+}
+
+/*  Prepares to read the open input file from its start.
+ */
+static void resetInputFile (void)
+{
+	getBytePosition (&StartOfLine);
+	getBytePosition (&File.filePosition);
+	++Readings;
+	File.currentLine  = NULL;
+	File.lineNumber   = 0L;
+	File.ungetch      = '\0';
+	File.eof          = FALSE;
+	File.newLine      = TRUE;
+
+	if (File.line != NULL)
+		vStringClear (File.line);
+	clearLineCache ();
+
+	setSourceFileParameters (vStringNewCopy (File.name));
+	File.source.lineNumber = 0L;
+}
+
+/*  Determines whether a file exceeds --max-file-size.
+ */
+extern boolean isOversizedFile (const char *const fileName)
+{
+	boolean result = FALSE;
+	if (Option.maxFileSize > 0  &&  isSuppliedFile (fileName))
+		result = (boolean) (Supplied.length / (1024 * 1024) >= Option.maxFileSize);
+	else if (Option.maxFileSize > 0)
+	{
+		fileStatus *const status = eStat (fileName);
+		result = (boolean) (status->size / (1024 * 1024) >= Option.maxFileSize);
+		eStatFree (status);
+	}
+	return result;
+}
+
 /*  This function opens a source file, and resets the line counter.  If it
  *  fails, it will display an error message and leave the File.fp set to NULL.
  */
 extern boolean fileOpen (const char *const fileName, const langType language)
 {
-#ifdef VMS
-	const char *const openMode = "r";
-#else
-	const char *const openMode = "rb";
-#endif
 	boolean opened = FALSE;
 
+	PushMemoryAccount (MEMORY_READER);
 	/*	If another file was already open, then close it.
 	 */
-	if (File.fp != NULL)
+	if (File.fp != NULL  ||  File.supplied)
+		releaseInputFile ();
+
+	if (isSuppliedFile (fileName))
+		openSuppliedContents ();
+	else
 	{
-		fclose (File.fp);  /* close any open source file */
-		File.fp = NULL;
+		File.fp = takeHeadStream (fileName);
+		if (File.fp == NULL)
+			File.fp = fopen (fileName, SOURCE_OPEN_MODE);
 	}
-
-	File.fp = fopen (fileName, openMode);
-	if (File.fp == NULL)
+	if (File.fp == NULL  &&  ! File.supplied)
 		error (WARNING | PERROR, "cannot open \"%s\"", fileName);
 	else
 	{
 		opened = TRUE;
 
+#ifdef USE_MAPPED_INPUT
+		if (! File.supplied)
+			mapInputFile ();
+#endif
 		setInputFileName (fileName);
-		fgetpos (File.fp, &StartOfLine);
-		fgetpos (File.fp, &File.filePosition);
-		File.currentLine  = NULL;
 		File.language     = language;
-		File.lineNumber   = 0L;
-		File.eof          = FALSE;
-		File.newLine      = TRUE;
-
-		if (File.line != NULL)
-			vStringClear (File.line);
+		File.outline      = isOversizedFile (fileName);
+		File.stopped      = FALSE;
+		File.stopLimit    = NULL;
+		OpenClock         = clock ();
+		BytesRead         = 0;
+		BytesChecked      = 0;
+		CheckBytes        = 1;
+		CheckClock        = OpenClock;
+		resetInputFile ();
 
-		setSourceFileParameters (vStringNewInit (fileName));
-		File.source.lineNumber = 0L;
-
-		verbose ("OPENING %s as %s language %sfile\n", fileName,
+		TracePoint2 (file__open, fileName, language);
+		verbose ("OPENING %s as %s language %sfile%s\n", fileName,
 				getLanguageName (language),
-				File.source.isHeader ? "include " : "");
+				File.source.isHeader ? "include " : "",
+				File.supplied ? " (supplied)" :
+				File.mapped != NULL ? " (mapped)" : "");
 	}
+	PopMemoryAccount ();
 	return opened;
 }
 
 extern void fileClose (void)
 {
-	if (File.fp != NULL)
+	if (File.fp != NULL  ||  File.supplied)
 	{
 		/*  The line count of the file is 1 too big, since it is one-based
 		 *  and is incremented upon each newline.
 		 */
-		if (Option.printTotals)
+		if (Option.printTotals  &&  File.supplied)
+			addTotals (0, File.lineNumber - 1L, (unsigned long) File.mappedSize);
+		else if (Option.printTotals)
 		{
 			fileStatus *status = eStat (vStringValue (File.name));
 			addTotals (0, File.lineNumber - 1L, status->size);
 		}
-		fclose (File.fp);
-		File.fp = NULL;
+		TracePoint2 (file__close, vStringValue (File.name), File.lineNumber - 1L);
+		releaseInputFile ();
+	}
+	vStringReleaseSpares ();
+}
+
+/*  Stops reading the input file, as though its end had been reached.
+ *  Reading is counted afresh, so that no line triggers found beyond the new
+ *  end are used (see skipUntriggeredLines ()).
+ */
+static void stopReading (void)
+{
+	if (File.mapped != NULL)
+	{
+		File.mappedEnd = File.mappedOffset;
+		++Readings;
+	}
+	else
+		fseek (File.fp, 0L, SEEK_END);
+	File.stopped = TRUE;
+}
+
+/*  Stops reading the input file once the processor time spent on it reaches
+ *  --max-file-time, or once, after a grace time, it is being read more slowly
+ *  than --min-file-rate, as a parser whose work grows faster than its input
+ *  may be. The time is read only once CheckBytes more bytes are read. Their
+ *  number begins at one and doubles while they are quickly read, but is cut
+ *  when they take longer, so that a file whose lines are each slow to read,
+ *  as through a costly regular expression, is checked about
+ *  TimeChecksPerSecond times a second.
+ */
+static void checkReadingTime (void)
+{
+	if ((Option.maxFileTime > 0  ||  Option.minFileRate > 0)  &&
+		BytesRead - BytesChecked >= CheckBytes)
+	{
+		const clock_t now = clock ();
+		const double elapsed = (double) (now - OpenClock) / CLOCKS_PER_SEC;
+		const double since = (double) (now - CheckClock) / CLOCKS_PER_SEC;
+
+		if (since * TimeChecksPerSecond > 1.0)
+			CheckBytes = (unsigned long) ((BytesRead - BytesChecked) /
+					(since * TimeChecksPerSecond)) + 1;
+		else if (CheckBytes < TimeCheckInterval)
+			CheckBytes *= 2;
+		BytesChecked = BytesRead;
+		CheckClock = now;
+		if (Option.maxFileTime > 0  &&  elapsed >= (double) Option.maxFileTime)
+			File.stopLimit = "--max-file-time";
+		else if (Option.minFileRate > 0  &&  elapsed >= RateGraceTime  &&
+				 BytesRead / 1024.0 < Option.minFileRate * elapsed)
+			File.stopLimit = "--min-file-rate";
+		if (File.stopLimit != NULL)
+			stopReading ();
+	}
+}
+
+/*  Returns to the start of the open input file, so that it may be parsed
+ *  again without being opened and mapped again.
+ */
+extern void fileRewind (void)
+{
+	Assert (File.fp != NULL  ||  File.supplied);
+	if (File.mapped == NULL)
+		rewind (File.fp);
+	else
+	{
+		File.mappedOffset = 0;
+		File.mappedEnd    = File.mappedSize;
+	}
+	resetInputFile ();
+	if (File.stopped)
+		stopReading ();  /* the time allowed was already spent */
+}
+
+/*  Asks the operating system to begin reading the contents of a file which
+ *  will be opened soon, so that the reading overlaps the parsing of the
+ *  files before it. Does nothing where this is not supported.
+ */
+extern void fileReadAhead (const char *const fileName __unused__)
+{
+#ifdef READ_AHEAD_SUPPORTED
+	const int fd = open (fileName, O_RDONLY);
+	if (fd != -1)
+	{
+		posix_fadvise (fd, 0, 0, POSIX_FADV_WILLNEED);
+		close (fd);
+	}
+#endif
+}
+
+/*  Limits further reading of the mapped input file to the bytes from
+ *  "start" up to "end". The byte at "start" must begin a line, which is
+ *  taken to be line "lineNumber" of the file.
+ */
+extern void fileRestrictRange (
+		const size_t start, const size_t end, const unsigned long lineNumber)
+{
+	Assert (File.mapped != NULL);
+	Assert (start <= end  &&  end <= File.mappedSize);
+	File.mappedOffset = start;
+	File.mappedEnd    = end;
+	++Readings;
+	offsetToPosition (&StartOfLine, start);
+	File.filePosition = StartOfLine;
+	File.lineNumber   = lineNumber - 1;
+	File.source.lineNumber = lineNumber - 1;
+	File.ungetch      = '\0';
+	File.eof          = FALSE;
+	File.newLine      = TRUE;
+}
+
+/*  Copies into "contents" the whole input file, up to any null character,
+ *  for matching patterns which span lines, leaving the position from which
+ *  the file is being read unchanged. Returns FALSE if the file cannot be
+ *  read again from its start, as for a pipe.
+ */
+extern boolean fileReadContents (vString *const contents)
+{
+	boolean result = TRUE;
+	PushMemoryAccount (MEMORY_READER);
+	vStringClear (contents);
+	if (File.mapped != NULL)
+		vStringNCatS (contents, (const char *) File.mapped, File.mappedSize);
+	else
+	{
+		fpos_t originalPosition;
+		fgetpos (File.fp, &originalPosition);
+		if (fseek (File.fp, 0L, SEEK_SET) != 0)
+			result = FALSE;
+		else
+		{
+			char buffer [BUFSIZ];
+			size_t count;
+			while ((count = fread (buffer, 1, sizeof (buffer), File.fp)) > 0  &&
+				   memchr (buffer, '\0', count) == NULL)
+				vStringNCatS (contents, buffer, count);
+			if (count > 0)
+				vStringNCatS (contents, buffer, count);
+		}
+		clearerr (File.fp);
+		fsetpos (File.fp, &originalPosition);
+	}
+	vStringTerminate (contents);
+	PopMemoryAccount ();
+	return result;
+}
+
+/*  Returns the bytes of the input file which have yet to be read into a
+ *  line, storing their number in "length", so that a parser may look ahead
+ *  over them without reading them. Returns NULL if the file is not mapped
+ *  into memory.
+ */
+extern const unsigned char *fileMappedRemainder (size_t *const length)
+{
+	const unsigned char *result = NULL;
+	*length = 0;
+	if (File.mapped != NULL  &&  File.mappedOffset <= File.mappedEnd)
+	{
+		result = File.mapped + File.mappedOffset;
+		*length = File.mappedEnd - File.mappedOffset;
+	}
+	return result;
+}
+
+/*  Stores into "position" the file position of the byte at "offset" from
+ *  the start of the input file, as a tag entry records it.
+ */
+extern void fileOffsetPosition (const size_t offset, fpos_t *const position)
+{
+	if (File.mapped != NULL)
+		offsetToPosition (position, offset);
+	else
+	{
+		fpos_t originalPosition;
+		fgetpos (File.fp, &originalPosition);
+		fseek (File.fp, (long) offset, SEEK_SET);
+		fgetpos (File.fp, position);
+		fsetpos (File.fp, &originalPosition);
 	}
 }
 
@@ -330,7 +1035,7 @@ static int iFileGetc (void)
 {
 	int	c;
 readnext:
-	c = getc (File.fp);
+	c = readByte ();
 
 	/*	If previous character was a newline, then we're starting a line.
 	 */
@@ -340,11 +1045,14 @@ readnext:
 		if (c == '#'  &&  Option.lineDirectives)
 		{
 			if (parseLineDirective ())
+			{
+				LineAltered = TRUE;
 				goto readnext;
+			}
 			else
 			{
-				fsetpos (File.fp, &StartOfLine);
-				c = getc (File.fp);
+				setBytePosition (&StartOfLine);
+				c = readByte ();
 			}
 		}
 	}
@@ -354,7 +1062,7 @@ readnext:
 	else if (c == NEWLINE)
 	{
 		File.newLine = TRUE;
-		fgetpos (File.fp, &StartOfLine);
+		getBytePosition (&StartOfLine);
 	}
 	else if (c == CRETURN)
 	{
@@ -363,15 +1071,15 @@ readnext:
 		 * and CR-LF (MS-DOS) are converted into a generic newline.
 		 */
 #ifndef macintosh
-		const int next = getc (File.fp);  /* is CR followed by LF? */
+		const int next = readByte ();  /* is CR followed by LF? */
 		if (next != NEWLINE)
-			ungetc (next, File.fp);
+			unreadByte (next);
 		else
 #endif
 		{
 			c = NEWLINE;  /* convert CR into newline */
 			File.newLine = TRUE;
-			fgetpos (File.fp, &StartOfLine);
+			getBytePosition (&StartOfLine);
 		}
 	}
 	DebugStatement ( debugPutc (DEBUG_RAW, c); )
@@ -383,33 +1091,72 @@ extern void fileUngetc (int c)
 	File.ungetch = c;
 }
 
+/*  Appends to "vLine" the remainder of the current line of a mapped file in
+ *  a single copy, stopping before any character which iFileGetc () treats
+ *  specially.
+ */
+static void appendMappedSpan (vString *const vLine)
+{
+	const size_t length = mappedSpanLength ();
+
+	if (length > 0)
+	{
+		const char *const span = (const char *) File.mapped + File.mappedOffset;
+
+		vStringNCatS (vLine, span, length);
+		File.mappedOffset += length;
+		DebugStatement ( debugPrintf (DEBUG_RAW, "%.*s", (int) length, span); )
+	}
+}
+
 static vString *iFileGetLine (void)
 {
 	vString *result = NULL;
 	int c;
+	PushMemoryAccount (MEMORY_READER);
 	if (File.line == NULL)
 		File.line = vStringNew ();
 	vStringClear (File.line);
+	LineAltered = FALSE;
 	do
 	{
 		c = iFileGetc ();
+		if (c == '\0')
+			LineAltered = TRUE;  /* null characters are not retained */
 		if (c != EOF)
 			vStringPut (File.line, c);
 		if (c == '\n'  ||  (c == EOF  &&  vStringLength (File.line) > 0))
 		{
 			vStringTerminate (File.line);
+			if (! LineAltered)
+				cacheLine (File.line, &File.filePosition);
 #ifdef HAVE_REGEX
 			if (vStringLength (File.line) > 0)
 				matchRegex (File.line, File.source.language);
 #endif
+			BytesRead += vStringLength (File.line);
+			checkReadingTime ();
 			result = File.line;
 			break;
 		}
+		else if (c != EOF)
+			appendMappedSpan (File.line);
 	} while (c != EOF);
 	Assert (result != NULL  ||  File.eof);
+	PopMemoryAccount ();
 	return result;
 }
 
+/*  Makes "line" the one worked on by fileGetc (), noting where it ends so
+ *  that fileLineSpan () need not measure what is left of it on each call.
+ */
+static void setCurrentLine (vString *const line)
+{
+	File.currentLine = (unsigned char*) vStringValue (line);
+	File.currentLineEnd = File.currentLine +
+			strlen ((const char *) File.currentLine);
+}
+
 /*  Do not mix use of fileReadLine () and fileGetc () for the same file.
  */
 extern int fileGetc (void)
@@ -438,7 +1185,7 @@ extern int fileGetc (void)
 		{
 			vString* const line = iFileGetLine ();
 			if (line != NULL)
-				File.currentLine = (unsigned char*) vStringValue (line);
+				setCurrentLine (line);
 			if (File.currentLine == NULL)
 				c = EOF;
 			else
@@ -449,6 +1196,44 @@ extern int fileGetc (void)
 	return c;
 }
 
+/*  Returns the characters of the current line which fileGetc () has yet to
+ *  return, storing their number in "length", so that a caller may examine
+ *  them in bulk and then consume them with fileSkipBytes (). The next line
+ *  is read if the current one is done. Returns NULL when fileGetc () must
+ *  be called instead, as at end of file or when a character was ungotten.
+ */
+extern const unsigned char *fileLineSpan (size_t *const length)
+{
+	const unsigned char *result = NULL;
+	if (File.ungetch == '\0')
+	{
+		if (File.currentLine != NULL  &&  *File.currentLine == '\0')
+			File.currentLine = NULL;
+		if (File.currentLine == NULL)
+		{
+			vString* const line = iFileGetLine ();
+			if (line != NULL)
+				setCurrentLine (line);
+		}
+		if (File.currentLine != NULL  &&  *File.currentLine != '\0')
+		{
+			result = File.currentLine;
+			*length = (size_t) (File.currentLineEnd - result);
+		}
+	}
+	return result;
+}
+
+/*  Consumes "count" characters of the span returned by fileLineSpan ().
+ */
+extern void fileSkipBytes (const size_t count)
+{
+	Assert (File.currentLine != NULL);
+	DebugStatement ( debugPrintf (DEBUG_READ, "%.*s", (int) count,
+				(const char *) File.currentLine); )
+	File.currentLine += count;
+}
+
 extern int fileSkipToCharacter (int c)
 {
 	int d;
@@ -477,9 +1262,116 @@ extern const unsigned char *fileReadLine (void)
 	return result;
 }
 
+/*  Returns the offset of the first occurrence of "word" in the mapped file
+ *  from "offset", or File.mappedEnd if there is none. The library searches
+ *  for its first character, usually many bytes at a time.
+ */
+static size_t findMappedWord (const char *const word, const size_t offset)
+{
+	const size_t length = strlen (word);
+	const unsigned char *p = File.mapped + offset;
+	const unsigned char *const end = File.mapped + File.mappedEnd;
+	size_t result = File.mappedEnd;
+
+	while (p + length <= end  &&
+		   (p = memchr (p, word [0], (end - p) - length + 1)) != NULL)
+	{
+		if (memcmp (p, word, length) == 0)
+		{
+			result = p - File.mapped;
+			break;
+		}
+		++p;
+	}
+	return result;
+}
+
+/*  Passes over the whole lines of the mapped file before the first which
+ *  contains one of the words of "triggers", or before the last line of the
+ *  file if none does, counting them as iFileGetc () would.
+ */
+static void skipUntriggeredLines (lineTriggers *const triggers)
+{
+	const size_t offset = File.mappedOffset;
+	size_t next = File.mappedEnd;
+	size_t start;
+	unsigned int i;
+
+	/*  A word found at or beyond the offset need not be sought again, unless
+	 *  reading has started afresh since it was found.
+	 */
+	const boolean reset = (boolean) (triggers->reading != Readings  ||
+			offset < triggers->offset);
+	triggers->reading = Readings;
+	triggers->offset = offset;
+	for (i = 0  ;  triggers->words [i] != NULL  ;  ++i)
+	{
+		Assert (i < MaxLineTriggers);
+		if (reset  ||  triggers->found [i] < offset)
+			triggers->found [i] = findMappedWord (triggers->words [i], offset);
+		if (triggers->found [i] < next)
+			next = triggers->found [i];
+	}
+	for (start = next  ;  start > offset  ;  --start)
+		if (File.mapped [start - 1] == NEWLINE)
+			break;
+	if (start > offset)
+	{
+		const unsigned char *p = File.mapped + offset;
+		const unsigned char *const end = File.mapped + start;
+		while ((p = memchr (p, NEWLINE, end - p)) != NULL)
+		{
+			++p;
+			++File.lineNumber;
+			++File.source.lineNumber;
+		}
+		BytesRead += start - offset;
+		File.mappedOffset = start;
+		offsetToPosition (&StartOfLine, start);
+	}
+}
+
+/*  Like fileReadLine (), but may pass over, unread, lines of the file which
+ *  contain none of the words of "triggers", since they are of no interest
+ *  to the parser. Lines are only passed over when nothing else needs to see
+ *  them: the file is mapped, no regular expressions are defined for its
+ *  language and #line directives are not being interpreted.
+ */
+extern const unsigned char *fileReadLineContaining (
+		lineTriggers *const triggers)
+{
+	if (File.mapped != NULL  &&  File.newLine  &&  File.ungetch == '\0'  &&
+		! Option.lineDirectives
+#ifdef HAVE_REGEX
+		&&  ! hasRegexPatterns (File.source.language)
+#endif
+		)
+	{
+		skipUntriggeredLines (triggers);
+	}
+	return fileReadLine ();
+}
+
 /*
  *   Source file line reading with automatic buffer sizing
  */
+
+static void canonicalizeNewline (vString *const vLine)
+{
+	const size_t length = vStringLength (vLine);
+	char *const eol = vStringValue (vLine) + length - 1;
+	if (length == 0)
+		;  /* nothing to canonicalize */
+	else if (*eol == '\r')
+		*eol = '\n';
+	else if (length > 1  &&  *(eol - 1) == '\r'  &&  *eol == '\n')
+	{
+		*(eol - 1) = '\n';
+		*eol = '\0';
+		--vLine->length;
+	}
+}
+
 extern char *readLine (vString *const vLine, FILE *const fp)
 {
 	char *result = NULL;
@@ -522,43 +1414,149 @@ extern char *readLine (vString *const vLine, FILE *const fp)
 			}
 			else
 			{
-				char* eol;
 				vStringSetLength (vLine);
-				/* canonicalize new line */
-				eol = vStringValue (vLine) + vStringLength (vLine) - 1;
-				if (*eol == '\r')
-					*eol = '\n';
-				else if (*(eol - 1) == '\r'  &&  *eol == '\n')
-				{
-					*(eol - 1) = '\n';
-					*eol = '\0';
-					--vLine->length;
-				}
+				canonicalizeNewline (vLine);
 			}
 		} while (reReadLine);
 	}
 	return result;
 }
 
+/*  Reads from the mapped input file the line beginning at "offset", in the
+ *  same form as readLine () would have read it from the stream.
+ */
+static char *readMappedLine (vString *const vLine, const size_t offset)
+{
+	char *result = NULL;
+
+	vStringClear (vLine);
+	if (offset < File.mappedSize)
+	{
+		const unsigned char *const start = File.mapped + offset;
+		const size_t remaining = File.mappedSize - offset;
+		const unsigned char *const newline =
+				(const unsigned char *) memchr (start, NEWLINE, remaining);
+		const size_t length = (newline == NULL) ?
+				remaining : (size_t) (newline - start) + 1;
+
+		vStringNCatS (vLine, (const char *) start, length);
+		canonicalizeNewline (vLine);
+		result = vStringValue (vLine);
+	}
+	return result;
+}
+
 /*  Places into the line buffer the contents of the line referenced by
  *  "location".
  */
 extern char *readSourceLine (
 		vString *const vLine, fpos_t location, long *const pSeekValue)
 {
-	fpos_t orignalPosition;
 	char *result;
 
-	fgetpos (File.fp, &orignalPosition);
-	fsetpos (File.fp, &location);
-	if (pSeekValue != NULL)
-		*pSeekValue = ftell (File.fp);
-	result = readLine (vLine, File.fp);
+	if (File.mapped != NULL)
+	{
+		const size_t offset = positionToOffset (&location);
+		if (pSeekValue != NULL)
+			*pSeekValue = (long) offset;
+		result = readMappedLine (vLine, offset);
+	}
+	else
+	{
+		const cachedLine *const cached =
+				(pSeekValue == NULL) ? findCachedLine (&location) : NULL;
+		fpos_t orignalPosition;
+
+		if (cached != NULL)
+		{
+			vStringCopy (vLine, cached->line);
+			result = vStringValue (vLine);
+		}
+		else
+		{
+			fgetpos (File.fp, &orignalPosition);
+			fsetpos (File.fp, &location);
+			if (pSeekValue != NULL)
+				*pSeekValue = ftell (File.fp);
+			result = readLine (vLine, File.fp);
+			fsetpos (File.fp, &orignalPosition);
+		}
+	}
 	if (result == NULL)
 		error (FATAL, "Unexpected end of file: %s", vStringValue (File.name));
-	fsetpos (File.fp, &orignalPosition);
 
 	return result;
 }
 
+/*  Shortens the line in the line buffer to "limit" bytes, not counting its
+ *  newline, if it is longer, without splitting a UTF-8 character. Returns
+ *  whether it was shortened.
+ */
+static boolean cutLine (vString *const vLine, const size_t limit)
+{
+	const char *const line = vStringValue (vLine);
+	size_t length = vStringLength (vLine);
+	boolean cut = FALSE;
+
+	if (length > 0  &&  line [length - 1] == NEWLINE)
+		--length;
+	if (limit > 0  &&  length > limit)
+	{
+		length = limit;
+		while (length > 0  &&  (line [length] & 0xC0) == 0x80)
+			--length;
+		vLine->length = length;
+		vStringTerminate (vLine);
+		cut = TRUE;
+	}
+	return cut;
+}
+
+/*  Places into the line buffer no more than "limit" bytes of the line
+ *  referenced by "location", as readSourceLine () does, storing into
+ *  "truncated" whether the line was longer, in which case it has no
+ *  newline. A mapped line is not copied beyond the limit, so that the cost
+ *  does not grow with the length of the line. A limit of 0 reads the whole
+ *  line.
+ */
+extern char *readSourceLineHead (
+		vString *const vLine, fpos_t location, const size_t limit,
+		long *const pSeekValue, boolean *const truncated)
+{
+	char *result;
+
+	if (File.mapped != NULL  &&  limit > 0)
+	{
+		const size_t offset = positionToOffset (&location);
+		if (pSeekValue != NULL)
+			*pSeekValue = (long) offset;
+		vStringClear (vLine);
+		if (offset >= File.mappedSize)
+			error (FATAL, "Unexpected end of file: %s", vStringValue (File.name));
+		else
+		{
+			/* allow for a line end of two characters just beyond the limit */
+			const unsigned char *const start = File.mapped + offset;
+			const size_t remaining = File.mappedSize - offset;
+			const size_t scanned = (remaining > limit + 2) ? limit + 2 : remaining;
+			const unsigned char *const newline =
+					(const unsigned char *) memchr (start, NEWLINE, scanned);
+
+			if (newline == NULL)
+				vStringNCatS (vLine, (const char *) start, scanned);
+			else
+			{
+				vStringNCatS (vLine, (const char *) start,
+						(size_t) (newline - start) + 1);
+				canonicalizeNewline (vLine);
+			}
+		}
+	}
+	else
+		readSourceLine (vLine, location, pSeekValue);
+	*truncated = cutLine (vLine, limit);
+	result = vStringValue (vLine);
+	return result;
+}
+
 /* vi:set tabstop=4 shiftwidth=4: */
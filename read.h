@@ -64,6 +64,34 @@ enum eCharacters {
 	CHAR_SYMBOL   = ('C' + 0x80)
 };
 
+enum eLineCache {
+	LineCacheSize = 16  /* number of recently read lines retained */
+};
+
+/*  A recently read source line, retained so that tag entries for it can be
+ *  written without seeking back into the source file.
+ */
+typedef struct sCachedLine {
+	vString *line;             /* contents of line, newline canonicalized */
+	fpos_t   position;         /* file position of start of line */
+	boolean  valid;            /* does this slot hold a line? */
+} cachedLine;
+
+enum eLineTriggers {
+	MaxLineTriggers = 8  /* words in a lineTriggers, at most */
+};
+
+/*  Words, one of which each line of interest to a line oriented parser
+ *  contains, and where each was next found in the input file, so that the
+ *  lines between may be passed over (see fileReadLineContaining ()).
+ */
+typedef struct sLineTriggers {
+	const char *const *words;  /* NULL terminated list of words */
+	unsigned long reading;     /* reading of input file searched */
+	size_t offset;             /* offset from which words were sought */
+	size_t found [MaxLineTriggers];  /* offset at which each was found */
+} lineTriggers;
+
 /*  Maintains the state of the current source file.
  */
 typedef struct sInputFile {
@@ -71,13 +99,24 @@ typedef struct sInputFile {
 	vString    *path;          /* path of input file (if any) */
 	vString    *line;          /* last line read from file */
 	const unsigned char* currentLine;  /* current line being worked on */
+	const unsigned char* currentLineEnd;  /* end of current line */
 	FILE       *fp;            /* stream used for reading the file */
+	const unsigned char *mapped;  /* contents of file, if mapped into memory */
+	size_t      mappedSize;    /* size of mapped contents */
+	size_t      mappedOffset;  /* offset of next character in mapped contents */
+	size_t      mappedEnd;     /* offset at which reading of mapping stops */
 	unsigned long lineNumber;  /* line number in the input file */
 	fpos_t      filePosition;  /* file position of current line */
 	int         ungetch;       /* a single character that was ungotten */
 	boolean     eof;           /* have we reached the end of file? */
 	boolean     newLine;       /* will the next character begin a new line? */
 	langType    language;      /* language of input file */
+	boolean     outline;       /* tag only top-level definitions, by line? */
+	boolean     stopped;       /* was reading stopped by a limit of time? */
+	const char *stopLimit;     /* option setting that limit */
+	boolean     supplied;      /* is contents a buffer from fileSupplyContents ()? */
+	cachedLine  lineCache [LineCacheSize];  /* ring of recently read lines */
+	unsigned int lineCacheNext;  /* slot to receive next line read */
 
 	/*  Contains data pertaining to the original source file in which the tag
 	 *  was defined. This may be different from the input file when #line
@@ -104,12 +143,27 @@ extern void freeSourceFileResources (void);
 extern boolean fileOpen (const char *const fileName, const langType language);
 extern boolean fileEOF (void);
 extern void fileClose (void);
+extern boolean isOversizedFile (const char *const fileName);
+extern void fileRewind (void);
+extern void fileReadAhead (const char *const fileName);
+extern const char *fileReadHead (const char *const fileName, size_t *const length);
+extern void fileReleaseHead (void);
+extern void fileSupplyContents (const char *const fileName, const unsigned char *const bytes, const size_t length);
+extern void fileReleaseContents (void);
+extern void fileRestrictRange (const size_t start, const size_t end, const unsigned long lineNumber);
+extern boolean fileReadContents (vString *const contents);
+extern const unsigned char *fileMappedRemainder (size_t *const length);
+extern void fileOffsetPosition (const size_t offset, fpos_t *const position);
 extern int fileGetc (void);
+extern const unsigned char *fileLineSpan (size_t *const length);
+extern void fileSkipBytes (const size_t count);
 extern int fileSkipToCharacter (int c);
 extern void fileUngetc (int c);
 extern const unsigned char *fileReadLine (void);
+extern const unsigned char *fileReadLineContaining (lineTriggers *const triggers);
 extern char *readLine (vString *const vLine, FILE *const fp);
 extern char *readSourceLine (vString *const vLine, fpos_t location, long *const pSeekValue);
+extern char *readSourceLineHead (vString *const vLine, fpos_t location, const size_t limit, long *const pSeekValue, boolean *const truncated);
 
 #endif  /* _READ_H */
 
@@ -11,6 +11,10 @@
 /*
 *   INCLUDE FILES
 */
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
@@ -18,6 +22,38 @@
 #include <errno.h>
 #include <sys/types.h>  /* to declare off_t */
 
+/*  Tag files may be mapped into memory (see tagsOpenMapped()) where mmap() is
+ *  available. Define READTAGS_MMAP to use it when building without config.h.
+ */
+#if defined (HAVE_MMAP) && defined (HAVE_SYS_MMAN_H) && defined (HAVE_SYS_STAT_H)
+# define READTAGS_MMAP 1
+#endif
+#ifdef READTAGS_MMAP
+# include <sys/mman.h>  /* to declare mmap () */
+#endif
+#if defined (READTAGS_MMAP) || defined (HAVE_SYS_STAT_H)
+# include <sys/stat.h>  /* to declare fstat () */
+# define READTAGS_FSTAT 1
+#endif
+
+/*  The index written beside a tag file by "ctags --tag-index" is used where
+ *  the tag file can be checked to be as indexed.
+ */
+#ifdef READTAGS_FSTAT
+# define READTAGS_INDEX 1
+#endif
+
+/*  Tag files compressed by "ctags --compress" are read where zlib is
+ *  available. Define READTAGS_ZLIB to read them when building without
+ *  config.h, linking with zlib.
+ */
+#ifdef HAVE_ZLIB
+# define READTAGS_ZLIB 1
+#endif
+#ifdef READTAGS_ZLIB
+# include <zlib.h>
+#endif
+
 #include "readtags.h"
 
 /*
@@ -25,6 +61,45 @@
 */
 #define TAB '\t'
 
+/* Number of jump points, evenly spaced through a tag file, kept to narrow
+ * binary searches */
+#define SAMPLE_COUNT   256
+/* Leading characters of the name of the tag kept for each jump point */
+#define SAMPLE_PREFIX  16
+/* Smallest tag file, in bytes per jump point, for which they are kept */
+#define SAMPLE_SPACING 64
+/* Name and format of the index written by "ctags --tag-index", which is
+ * described in tagindex.c in its source */
+#define INDEX_SUFFIX   ".idx"
+#define INDEX_MAGIC    "CTAGSIDX"
+#define INDEX_VERSION  1
+#define INDEX_HEADER   32  /* bytes in header */
+#define INDEX_SECTION  20  /* bytes describing each section */
+#define INDEX_RECORD   28  /* bytes in each record */
+/* Offsets within each record */
+#define INDEX_RECORD_NAME    0
+#define INDEX_RECORD_OFFSET  20
+/* Characters in each trigram of the names in the index, and the number
+ * ending the list of trigrams */
+#define INDEX_TRIGRAM        3
+#define INDEX_TRIGRAM_END    0xffffffffUL
+/* Name and format of the Bloom filter written by "ctags --tag-bloom",
+ * which is also described in tagindex.c */
+#define BLOOM_SUFFIX   ".bloom"
+#define BLOOM_MAGIC    "CTAGSBLM"
+#define BLOOM_VERSION  1
+#define BLOOM_HEADER   32  /* bytes in header */
+#define BLOOM_LIMIT    ((off_t) 1 << 29)  /* bytes of bits at most */
+/* Format of a tag file compressed by "ctags --compress", which is described
+ * in compress.c in its source */
+#define ZIP_MAGIC      "CTAGSZIP"
+#define ZIP_VERSION    1
+#define ZIP_HEADER     32  /* bytes in header */
+#define ZIP_ENTRY      16  /* bytes describing each block */
+/* Distance, in bytes, of the first probe made past the previous tag found by
+ * tagsFindMany(); each further probe doubles it */
+#define GALLOP_STEP    4096
+
 
 /*
 *   DATA DECLARATIONS
@@ -34,6 +109,50 @@ typedef struct {
 	char *buffer;
 } vstring;
 
+/* The first line following a jump point, kept to narrow later searches */
+typedef struct {
+		/* has the line been read? */
+	short filled;
+		/* is there no line following the jump point? */
+	short atEnd;
+		/* file position of start of line */
+	off_t pos;
+		/* length of the whole name of its tag */
+	size_t length;
+		/* leading characters of the name */
+	char prefix [SAMPLE_PREFIX];
+} sample;
+
+/* A name passed to tagsFindMany() */
+typedef struct {
+		/* the name searched for */
+	const char *name;
+		/* its length */
+	size_t length;
+		/* its position among the names passed */
+	unsigned int index;
+} query;
+
+/* Tag files searched together (see tagsOpenChain()) */
+struct sTagChain {
+		/* the tag files, and their number */
+	tagFile **files;
+	unsigned int count;
+		/* the tag found next in each file, valid only where `found' */
+	tagEntry *entries;
+	short *found;
+		/* the file of the tag found last, or `count' if none */
+	unsigned int last;
+		/* are names in order ignoring case? */
+	short ignorecase;
+};
+
+/* A character of a mapped tag file overwritten to terminate a field */
+typedef struct {
+	char *at;
+	char was;
+} savedChar;
+
 /* Information about current tag file */
 struct sTagFile {
 		/* has the file been opened and this structure initialized? */
@@ -42,16 +161,38 @@ struct sTagFile {
 	short format;
 		/* how is the tag file sorted? */
 	sortType sortMethod;
-		/* pointer to file structure */
+		/* pointer to file structure (NULL if the file is mapped) */
 	FILE* fp;
 		/* file position of first character of `line' */
 	off_t pos;
 		/* size of tag file in seekable positions */
 	off_t size;
-		/* last line read */
+		/* modification time of tag file when `size' was measured */
+	long modified;
+		/* buffer for lines read from `fp' */
 	vstring line;
-		/* name of tag in last line read */
-	vstring name;
+		/* last line read, which is in `line' or in the mapped file */
+	char *lineText;
+		/* length of last line read, excluding any newline */
+	size_t lineLength;
+		/* length of name of tag in last line read */
+	size_t nameLength;
+		/* the tag file mapped into memory (see tagsOpenMapped()) */
+	struct {
+				/* first character of the file, or NULL if not mapped */
+			char *base;
+				/* file position of next line to read */
+			off_t next;
+				/* characters overwritten while parsing last line read */
+			savedChar *saved;
+				/* number of entries used and allocated in `saved' */
+			size_t count, max;
+				/* is the mapping owned by the handle it was shared from? */
+			short borrowed;
+				/* may other handles be reading the mapping, so that lines
+				 * must be copied before being parsed? */
+			short shared;
+	} map;
 		/* defines tag search state */
 	struct {
 				/* file position of last match for tag */
@@ -62,16 +203,114 @@ struct sTagFile {
 			size_t nameLength;
 				/* peforming partial match */
 			short partial;
+				/* matching names containing the name searched for, or its
+				 * characters in order without others between them
+				 * necessarily adjacent */
+			short substring;
+			short subsequence;
 				/* ignoring case */
 			short ignorecase;
+				/* record numbers of the index searched through, in the
+				 * order of the names matched, or NULL if not using it */
+			const unsigned char *order;
+				/* position within `order' of the last tag matched */
+			unsigned long position;
+				/* positions within `order' of the names which may contain
+				 * the name searched for, or NULL to try each of them */
+			const unsigned char *postings;
+				/* the next of those tried, and the number of them */
+			unsigned long candidate, candidates;
+				/* still reading the pseudo-tags at the head of the file,
+				 * which are left out of the index */
+			short pseudo;
 	} search;
+		/* jump points read by earlier binary searches */
+	sample samples [SAMPLE_COUNT];
 		/* miscellaneous extension fields */
 	struct {
 				/* number of entries in `list' */
 			unsigned short max;
 				/* list of key value pairs */
 			tagExtensionField *list;
+				/* null terminated keys of the fields to parse, or null
+				 * to parse all of them */
+			char **wanted;
 	} fields;
+		/* the index written beside the tag file by "ctags --tag-index" */
+	struct {
+				/* contents of the index, or NULL if there is none */
+			unsigned char *base;
+				/* size of the index */
+			size_t size;
+				/* is `base' mapped into memory rather than allocated? */
+			short mapped;
+				/* is the index owned by the handle it was shared from? */
+			short borrowed;
+				/* null terminated names, files, and kinds of the tags */
+			const char *strings;
+			size_t stringsLength;
+				/* records of the tags, and how many there are */
+			const unsigned char *records;
+			unsigned long count;
+				/* numbers of the records in order of name, and of name
+				 * ignoring case (NULL if not in the index) */
+			const unsigned char *names;
+			const unsigned char *folded;
+				/* hash table of the names, and its number of slots */
+			const unsigned char *slots;
+			unsigned long slotCount;
+				/* trigrams of the names, each with the position of its
+				 * postings, those positions within `names' of the names in
+				 * which it occurs (NULL if not in the index) */
+			const unsigned char *trigrams;
+			unsigned long trigramCount;
+			const unsigned char *postings;
+			unsigned long postingCount;
+	} index;
+		/* the Bloom filter of the names of the tags written beside the tag
+		 * file by "ctags --tag-bloom" */
+	struct {
+				/* bits of the filter, or NULL if there is none */
+			unsigned char *bits;
+				/* number of bits, a power of 2, less one */
+			unsigned long mask;
+				/* number of bits set for each name */
+			unsigned long probes;
+				/* are the bits owned by the handle they were shared from? */
+			short borrowed;
+	} bloom;
+		/* the blocks of a tag file compressed by "ctags --compress", each
+		 * decompressed only when a line is read from it */
+	struct {
+				/* file positions in the uncompressed tag file of the
+				 * blocks, and the offsets of the blocks, each followed by
+				 * that of the end of the last, or NULL if not compressed */
+			off_t *starts;
+			off_t *offsets;
+			unsigned long count;
+				/* file position of next line to read */
+			off_t next;
+				/* the block decompressed last, as `count' if none */
+			unsigned long current;
+				/* its contents, of `length' characters, in a buffer of
+				 * `size' */
+			char *text;
+			size_t length, size;
+				/* buffer for the compressed block */
+			unsigned char *packed;
+			size_t packedSize;
+	} zip;
+		/* path of tag file, from which tagsOpenCursor() reopens it */
+	char *path;
+		/* input operations made, as reported by "readtags -b" */
+	struct {
+				/* seeks within the tag file, if not mapped */
+			unsigned long seeks;
+				/* lines read from the tag file */
+			unsigned long lines;
+				/* blocks of a compressed tag file decompressed */
+			unsigned long blocks;
+	} io;
 		/* buffers to be freed at close */
 	struct {
 			/* name of program author */
@@ -95,33 +334,6 @@ const char *const PseudoTagPrefix = "!_";
 *   FUNCTION DEFINITIONS
 */
 
-/*
- * Compare two strings, ignoring case.
- * Return 0 for match, < 0 for smaller, > 0 for bigger
- * Make sure case is folded to uppercase in comparison (like for 'sort -f')
- * This makes a difference when one of the chars lies between upper and lower
- * ie. one of the chars [ \ ] ^ _ ` for ascii. (The '_' in particular !)
- */
-static int struppercmp (const char *s1, const char *s2)
-{
-	int result;
-	do
-	{
-		result = toupper ((int) *s1) - toupper ((int) *s2);
-	} while (result == 0  &&  *s1++ != '\0'  &&  *s2++ != '\0');
-	return result;
-}
-
-static int strnuppercmp (const char *s1, const char *s2, size_t n)
-{
-	int result;
-	do
-	{
-		result = toupper ((int) *s1) - toupper ((int) *s2);
-	} while (result == 0  &&  --n > 0  &&  *s1++ != '\0'  &&  *s2++ != '\0');
-	return result;
-}
-
 static int growString (vstring *s)
 {
 	int result = 0;
@@ -149,25 +361,62 @@ static int growString (vstring *s)
 	return result;
 }
 
-/* Copy name of tag out of tag line */
-static void copyName (tagFile *const file)
+/* Determine length of name of tag at start of last line read */
+static void measureName (tagFile *const file)
 {
-	size_t length;
-	const char *end = strchr (file->line.buffer, '\t');
-	if (end == NULL)
+	const char *const line = file->lineText;
+	size_t length = 0;
+	while (length < file->lineLength  &&  line [length] != TAB)
+		++length;
+	file->nameLength = length;
+}
+
+static int isPseudoTagLine (const tagFile *const file)
+{
+	const size_t prefixLength = strlen (PseudoTagPrefix);
+	return (file->nameLength >= prefixLength  &&
+			strncmp (file->lineText, PseudoTagPrefix, prefixLength) == 0);
+}
+
+/*  Terminate a field of the last line read at `p'. Because the same line of
+ *  a mapped file may be read again, the character overwritten is saved, to
+ *  be restored before the next line is read.
+ */
+static void terminateField (tagFile *const file, char *const p)
+{
+	if (file->map.base != NULL  &&  file->lineText != file->line.buffer  &&
+		*p != '\0')
 	{
-		end = strchr (file->line.buffer, '\n');
-		if (end == NULL)
-			end = strchr (file->line.buffer, '\r');
+		if (file->map.count == file->map.max)
+		{
+			const size_t newMax = (file->map.max == 0) ? 32 : 2 * file->map.max;
+			savedChar *const newSaved = (savedChar*) realloc (
+					file->map.saved, newMax * sizeof (savedChar));
+			if (newSaved == NULL)
+				perror ("too many extension fields");
+			else
+			{
+				file->map.saved = newSaved;
+				file->map.max = newMax;
+			}
+		}
+		if (file->map.count < file->map.max)
+		{
+			file->map.saved [file->map.count].at = p;
+			file->map.saved [file->map.count].was = *p;
+			++file->map.count;
+		}
+	}
+	*p = '\0';
+}
+
+static void restoreLine (tagFile *const file)
+{
+	while (file->map.count > 0)
+	{
+		const savedChar *const saved = &file->map.saved [--file->map.count];
+		*saved->at = saved->was;
 	}
-	if (end != NULL)
-		length = end - file->line.buffer;
-	else
-		length = strlen (file->line.buffer);
-	while (length >= file->name.size)
-		growString (&file->name);
-	strncpy (file->name.buffer, file->line.buffer, length);
-	file->name.buffer [length] = '\0';
 }
 
 static int readTagLineRaw (tagFile *const file)
@@ -213,20 +462,192 @@ static int readTagLineRaw (tagFile *const file)
 				file->line.buffer [i - 1] = '\0';
 				--i;
 			}
+			file->lineText = file->line.buffer;
+			file->lineLength = i;
 		}
 	} while (reReadLine  &&  result);
-	if (result)
-		copyName (file);
 	return result;
 }
 
+/*  Read the next line of a mapped file in place. The line is left
+ *  unterminated until it is parsed.
+ */
+static int readMappedLine (tagFile *const file)
+{
+	int result = 0;
+	file->pos = file->map.next;
+	if (file->map.next < file->size)
+	{
+		char *const start = file->map.base + file->map.next;
+		const size_t left = (size_t) (file->size - file->map.next);
+		const char *const end = (const char*) memchr (start, '\n', left);
+		size_t length = (end == NULL) ? left : (size_t) (end - start);
+		file->map.next += (end == NULL) ? left : length + 1;
+		while (length > 0  &&  (start [length - 1] == '\n' || start [length - 1] == '\r'))
+			--length;
+		if (end != NULL)
+		{
+			file->lineText = start;
+			result = 1;
+		}
+		else
+		{
+			/* the last line has no newline over which to terminate it */
+			result = 1;
+			while (result  &&  length >= file->line.size)
+				result = growString (&file->line);
+			if (result)
+			{
+				memcpy (file->line.buffer, start, length);
+				file->line.buffer [length] = '\0';
+				file->lineText = file->line.buffer;
+			}
+		}
+		file->lineLength = length;
+	}
+	return result;
+}
+
+#ifdef READTAGS_ZLIB
+
+/*  Decompress the block of a compressed tag file holding the file position
+ *  `pos', unless it is the block decompressed last.
+ */
+static int loadBlock (tagFile *const file, const off_t pos)
+{
+	unsigned long low = 0;
+	unsigned long high = file->zip.count;
+	int result = 1;
+	while (high - low > 1)
+	{
+		const unsigned long middle = low + (high - low) / 2;
+		if (file->zip.starts [middle] <= pos)
+			low = middle;
+		else
+			high = middle;
+	}
+	if (low != file->zip.current)
+	{
+		const size_t length = (size_t)
+				(file->zip.starts [low + 1] - file->zip.starts [low]);
+		const size_t packedLength = (size_t)
+				(file->zip.offsets [low + 1] - file->zip.offsets [low]);
+		uLongf textLength = (uLongf) length;
+		file->zip.current = file->zip.count;
+		result = 0;
+		if (length > file->zip.size)
+		{
+			char *const text = (char*) realloc (file->zip.text, length);
+			if (text != NULL)
+			{
+				file->zip.text = text;
+				file->zip.size = length;
+			}
+		}
+		if (packedLength > file->zip.packedSize)
+		{
+			unsigned char *const packed = (unsigned char*) realloc (
+					file->zip.packed, packedLength);
+			if (packed != NULL)
+			{
+				file->zip.packed = packed;
+				file->zip.packedSize = packedLength;
+			}
+		}
+		++file->io.seeks;
+		++file->io.blocks;
+		if (length <= file->zip.size  &&  packedLength <= file->zip.packedSize  &&
+			fseek (file->fp, file->zip.offsets [low], SEEK_SET) == 0  &&
+			fread (file->zip.packed, 1, packedLength, file->fp) == packedLength  &&
+			uncompress ((Bytef*) file->zip.text, &textLength,
+					file->zip.packed, (uLong) packedLength) == Z_OK  &&
+			(size_t) textLength == length)
+		{
+			file->zip.current = low;
+			file->zip.length = length;
+			result = 1;
+		}
+		else
+			perror ("readTagLine");
+	}
+	return result;
+}
+
+/*  Read the next line of a compressed tag file into the line buffer. No
+ *  line continues from one block into the next.
+ */
+static int readCompressedLine (tagFile *const file)
+{
+	int result = 0;
+	file->pos = file->zip.next;
+	if (file->zip.next < file->size  &&  loadBlock (file, file->zip.next))
+	{
+		const size_t offset = (size_t) (file->zip.next -
+				file->zip.starts [file->zip.current]);
+		const char *const start = file->zip.text + offset;
+		const size_t left = file->zip.length - offset;
+		const char *const end = (const char*) memchr (start, '\n', left);
+		size_t length = (end == NULL) ? left : (size_t) (end - start);
+		file->zip.next += (end == NULL) ? left : length + 1;
+		while (length > 0  &&  (start [length - 1] == '\n' || start [length - 1] == '\r'))
+			--length;
+		result = 1;
+		while (result  &&  length >= file->line.size)
+			result = growString (&file->line);
+		if (result)
+		{
+			memcpy (file->line.buffer, start, length);
+			file->line.buffer [length] = '\0';
+			file->lineText = file->line.buffer;
+			file->lineLength = length;
+		}
+	}
+	return result;
+}
+
+#endif
+
 static int readTagLine (tagFile *const file)
 {
 	int result;
 	do
 	{
-		result = readTagLineRaw (file);
-	} while (result && *file->name.buffer == '\0');
+		restoreLine (file);
+		if (file->map.base != NULL)
+			result = readMappedLine (file);
+#ifdef READTAGS_ZLIB
+		else if (file->zip.starts != NULL)
+			result = readCompressedLine (file);
+#endif
+		else
+			result = readTagLineRaw (file);
+		if (result)
+		{
+			++file->io.lines;
+			measureName (file);
+		}
+	} while (result && file->nameLength == 0);
+	return result;
+}
+
+static int seekTagFile (tagFile *const file, const off_t pos)
+{
+	int result = 0;
+	if (file->zip.starts != NULL)
+	{
+		file->zip.next = pos;
+		result = (pos <= file->size);
+	}
+	else if (file->map.base == NULL)
+	{
+		++file->io.seeks;
+		result = (fseek (file->fp, pos, SEEK_SET) == 0);
+	}
+	else if (pos <= file->size)
+	{
+		file->map.next = pos;
+		result = 1;
+	}
 	return result;
 }
 
@@ -247,6 +668,23 @@ static tagResult growFields (tagFile *const file)
 	return result;
 }
 
+/*  Is the extension field whose key is the `length' characters at `key' one
+ *  of those selected by tagsSetFields()?
+ */
+static int isFieldWanted (const tagFile *const file, const char *const key,
+						  const size_t length)
+{
+	int result = (file->fields.wanted == NULL);
+	int i;
+	for (i = 0  ;  ! result  &&  file->fields.wanted [i] != NULL  ;  ++i)
+	{
+		const char *const wanted = file->fields.wanted [i];
+		result = (strncmp (wanted, key, length) == 0  &&
+				  wanted [length] == '\0');
+	}
+	return result;
+}
+
 static void parseExtensionFields (tagFile *const file, tagEntry *const entry,
 								  char *const string)
 {
@@ -254,22 +692,31 @@ static void parseExtensionFields (tagFile *const file, tagEntry *const entry,
 	while (p != NULL  &&  *p != '\0')
 	{
 		while (*p == TAB)
-			*p++ = '\0';
+			terminateField (file, p++);
 		if (*p != '\0')
 		{
-			char *colon;
 			char *field = p;
+			char *colon;
+			size_t length;
 			p = strchr (p, TAB);
-			if (p != NULL)
-				*p++ = '\0';
-			colon = strchr (field, ':');
+			length = (p == NULL) ? strlen (field) : (size_t) (p - field);
+			colon = (char*) memchr (field, ':', length);
 			if (colon == NULL)
-				entry->kind = field;
-			else
+			{
+				if (isFieldWanted (file, "kind", 4))
+				{
+					if (p != NULL)
+						terminateField (file, p);
+					entry->kind = field;
+				}
+			}
+			else if (isFieldWanted (file, field, (size_t) (colon - field)))
 			{
 				const char *key = field;
 				const char *value = colon + 1;
-				*colon = '\0';
+				if (p != NULL)
+					terminateField (file, p);
+				terminateField (file, colon);
 				if (strcmp (key, "kind") == 0)
 					entry->kind = value;
 				else if (strcmp (key, "file") == 0)
@@ -285,15 +732,39 @@ static void parseExtensionFields (tagFile *const file, tagEntry *const entry,
 					++entry->fields.count;
 				}
 			}
+			if (p != NULL)
+				++p;
 		}
 	}
 }
 
+/*  Copy the last line read out of a mapping read by other handles, which
+ *  must not see its fields terminated.
+ */
+static void copyLine (tagFile *const file)
+{
+	int ok = 1;
+	while (ok  &&  file->lineLength >= file->line.size)
+		ok = growString (&file->line);
+	if (ok)
+	{
+		memcpy (file->line.buffer, file->lineText, file->lineLength);
+		file->line.buffer [file->lineLength] = '\0';
+		file->lineText = file->line.buffer;
+	}
+}
+
 static void parseTagLine (tagFile *file, tagEntry *const entry)
 {
 	int i;
-	char *p = file->line.buffer;
-	char *tab = strchr (p, TAB);
+	char *p;
+	char *tab;
+
+	if (file->map.shared  &&  file->lineText != file->line.buffer)
+		copyLine (file);
+	p = file->lineText;
+	terminateField (file, p + file->lineLength);
+	tab = strchr (p, TAB);
 
 	entry->fields.list = NULL;
 	entry->fields.count = 0;
@@ -303,14 +774,14 @@ static void parseTagLine (tagFile *file, tagEntry *const entry)
 	entry->name = p;
 	if (tab != NULL)
 	{
-		*tab = '\0';
+		terminateField (file, tab);
 		p = tab + 1;
 		entry->file = p;
 		tab = strchr (p, TAB);
 		if (tab != NULL)
 		{
 			int fieldsPresent;
-			*tab = '\0';
+			terminateField (file, tab);
 			p = tab + 1;
 			if (*p == '/'  ||  *p == '?')
 			{
@@ -318,11 +789,13 @@ static void parseTagLine (tagFile *file, tagEntry *const entry)
 				int delimiter = *(unsigned char*) p;
 				entry->address.lineNumber = 0;
 				entry->address.pattern = p;
-				do
+				for (++p  ;  *p != '\0'  &&  *p != delimiter  ;  ++p)
 				{
-					p = strchr (p + 1, delimiter);
-				} while (p != NULL  &&  *(p - 1) == '\\');
-				if (p == NULL)
+					/* skip escaped characters, including backslashes */
+					if (*p == '\\'  &&  p [1] != '\0')
+						++p;
+				}
+				if (*p == '\0')
 				{
 					/* invalid pattern */
 				}
@@ -342,8 +815,9 @@ static void parseTagLine (tagFile *file, tagEntry *const entry)
 				/* invalid pattern */
 			}
 			fieldsPresent = (strncmp (p, ";\"", 2) == 0);
-			*p = '\0';
-			if (fieldsPresent)
+			terminateField (file, p);
+			if (fieldsPresent  &&  (file->fields.wanted == NULL  ||
+									file->fields.wanted [0] != NULL))
 				parseExtensionFields (file, entry, p + 2);
 		}
 	}
@@ -370,7 +844,7 @@ static char *duplicate (const char *str)
 
 static void readPseudoTags (tagFile *const file, tagFileInfo *const info)
 {
-	fpos_t startOfLine;
+	off_t startOfLine;
 	const size_t prefixLength = strlen (PseudoTagPrefix);
 	if (info != NULL)
 	{
@@ -383,10 +857,11 @@ static void readPseudoTags (tagFile *const file, tagFileInfo *const info)
 	}
 	while (1)
 	{
-		fgetpos (file->fp, &startOfLine);
-		if (! readTagLine (file))
+		const int more = readTagLine (file);
+		startOfLine = file->pos;
+		if (! more)
 			break;
-		if (strncmp (file->line.buffer, PseudoTagPrefix, prefixLength) != 0)
+		if (! isPseudoTagLine (file))
 			break;
 		else
 		{
@@ -418,289 +893,1778 @@ static void readPseudoTags (tagFile *const file, tagFileInfo *const info)
 			}
 		}
 	}
-	fsetpos (file->fp, &startOfLine);
+	seekTagFile (file, startOfLine);
 }
 
 static void gotoFirstLogicalTag (tagFile *const file)
 {
-	fpos_t startOfLine;
-	const size_t prefixLength = strlen (PseudoTagPrefix);
-	rewind (file->fp);
+	off_t startOfLine;
+	seekTagFile (file, 0);
 	while (1)
 	{
-		fgetpos (file->fp, &startOfLine);
-		if (! readTagLine (file))
+		const int more = readTagLine (file);
+		startOfLine = file->pos;
+		if (! more)
 			break;
-		if (strncmp (file->line.buffer, PseudoTagPrefix, prefixLength) != 0)
+		if (! isPseudoTagLine (file))
 			break;
 	}
-	fsetpos (file->fp, &startOfLine);
+	seekTagFile (file, startOfLine);
 }
 
-static tagFile *initialize (const char *const filePath, tagFileInfo *const info)
+/*  Map the whole of an opened tag file into memory, privately, so that the
+ *  fields of each line may be terminated in place. Should the file not be
+ *  mapped, it is read as usual.
+ */
+static void mapTagFile (tagFile *const file)
 {
-	tagFile *result = (tagFile*) calloc ((size_t) 1, sizeof (tagFile));
-	if (result != NULL)
+#ifdef READTAGS_MMAP
+	struct stat status;
+	const int fd = fileno (file->fp);
+	if (fstat (fd, &status) == 0  &&  status.st_size > 0  &&
+		(off_t) (size_t) status.st_size == status.st_size)
 	{
-		growString (&result->line);
-		growString (&result->name);
-		result->fields.max = 20;
-		result->fields.list = (tagExtensionField*) calloc (
-			result->fields.max, sizeof (tagExtensionField));
-		result->fp = fopen (filePath, "r");
-		if (result->fp == NULL)
-		{
-			free (result);
-			result = NULL;
-			info->status.error_number = errno;
-		}
-		else
+		void *const base = mmap (NULL, (size_t) status.st_size,
+				PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+		if (base != MAP_FAILED)
 		{
-			fseek (result->fp, 0, SEEK_END);
-			result->size = ftell (result->fp);
-			rewind (result->fp);
-			readPseudoTags (result, info);
-			info->status.opened = 1;
-			result->initialized = 1;
+			fclose (file->fp);
+			file->fp = NULL;
+			file->map.base = (char*) base;
+			file->map.next = 0;
+			file->size = status.st_size;
 		}
 	}
-	return result;
+#endif
 }
 
-static void terminate (tagFile *const file)
-{
-	fclose (file->fp);
-
-	free (file->line.buffer);
-	free (file->name.buffer);
-	free (file->fields.list);
-
-	if (file->program.author != NULL)
-		free (file->program.author);
-	if (file->program.name != NULL)
-		free (file->program.name);
-	if (file->program.url != NULL)
-		free (file->program.url);
-	if (file->program.version != NULL)
-		free (file->program.version);
-	if (file->search.name != NULL)
-		free (file->search.name);
-
-	memset (file, 0, sizeof (tagFile));
-
-	free (file);
-}
+#ifdef READTAGS_INDEX
 
-static tagResult readNext (tagFile *const file, tagEntry *const entry)
+/*  Return the number stored in 4 bytes, least significant first, at `p'.
+ */
+static unsigned long indexNumber (const unsigned char *const p)
 {
-	tagResult result;
-	if (file == NULL  ||  ! file->initialized)
-		result = TagFailure;
-	else if (! readTagLine (file))
-		result = TagFailure;
-	else
-	{
-		if (entry != NULL)
-			parseTagLine (file, entry);
-		result = TagSuccess;
-	}
-	return result;
+	return (unsigned long) p [0]  |  ((unsigned long) p [1] << 8)  |
+		   ((unsigned long) p [2] << 16)  |  ((unsigned long) p [3] << 24);
 }
 
-static const char *readFieldValue (
-	const tagEntry *const entry, const char *const key)
+/*  Return the number stored in 8 bytes, least significant first, at `p'.
+ */
+static off_t indexOffset (const unsigned char *const p)
 {
-	const char *result = NULL;
+	off_t result = 0;
 	int i;
-	if (strcmp (key, "kind") == 0)
-		result = entry->kind;
-	else if (strcmp (key, "file") == 0)
-		result = EmptyString;
-	else for (i = 0  ;  i < entry->fields.count  &&  result == NULL  ;  ++i)
-		if (strcmp (entry->fields.list [i].key, key) == 0)
-			result = entry->fields.list [i].value;
-	return result;
-}
-
-static int readTagLineSeek (tagFile *const file, const off_t pos)
-{
-	int result = 0;
-	if (fseek (file->fp, pos, SEEK_SET) == 0)
-	{
-		result = readTagLine (file);  /* read probable partial line */
-		if (pos > 0  &&  result)
-			result = readTagLine (file);  /* read complete line */
-	}
+	for (i = 7  ;  i >= 0  ;  --i)
+		result = (result << 8) | p [i];
 	return result;
 }
 
-static int nameComparison (tagFile *const file)
+static void forgetIndex (tagFile *const file)
 {
-	int result;
-	if (file->search.ignorecase)
-	{
-		if (file->search.partial)
-			result = strnuppercmp (file->search.name, file->name.buffer,
-					file->search.nameLength);
-		else
-			result = struppercmp (file->search.name, file->name.buffer);
-	}
-	else
+	if (file->index.base != NULL  &&  ! file->index.borrowed)
 	{
-		if (file->search.partial)
-			result = strncmp (file->search.name, file->name.buffer,
-					file->search.nameLength);
+#ifdef READTAGS_MMAP
+		if (file->index.mapped)
+			munmap (file->index.base, file->index.size);
 		else
-			result = strcmp (file->search.name, file->name.buffer);
+#endif
+			free (file->index.base);
 	}
-	return result;
+	memset (&file->index, 0, sizeof (file->index));
 }
 
-static void findFirstNonMatchBefore (tagFile *const file)
+/*  Find the sections of the index, returning whether it is sound and
+ *  describes the tag file, whose status is `status'.
+ */
+static int parseIndex (tagFile *const file, const struct stat *const status)
 {
-#define JUMP_BACK 512
-	int more_lines;
-	int comp;
-	off_t start = file->pos;
-	off_t pos = start;
-	do
+	const unsigned char *const base = file->index.base;
+	const size_t size = file->index.size;
+	int result = (size >= INDEX_HEADER  &&
+			memcmp (base, INDEX_MAGIC, 8) == 0  &&
+			indexNumber (base + 8) == INDEX_VERSION  &&
+			indexOffset (base + 16) == (off_t) status->st_size  &&
+			indexOffset (base + 24) == (off_t) status->st_mtime);
+	off_t namesLength = 0;
+	off_t foldedLength = 0;
+	off_t trigramsLength = 0;
+	if (result)
+	{
+		const unsigned long count = indexNumber (base + 12);
+		unsigned long i;
+		result = (count <= (size - INDEX_HEADER) / INDEX_SECTION);
+		for (i = 0  ;  result  &&  i < count  ;  ++i)
+		{
+			const unsigned char *const entry =
+					base + INDEX_HEADER + i * INDEX_SECTION;
+			const off_t offset = indexOffset (entry + 4);
+			const off_t length = indexOffset (entry + 12);
+			result = (offset >= 0  &&  length >= 0  &&
+					  offset <= (off_t) size  &&  length <= (off_t) size - offset);
+			if (result  &&  memcmp (entry, "STRS", 4) == 0)
+			{
+				file->index.strings = (const char*) base + offset;
+				file->index.stringsLength = (size_t) length;
+			}
+			else if (result  &&  memcmp (entry, "RECS", 4) == 0)
+			{
+				file->index.records = base + offset;
+				file->index.count = (unsigned long) (length / INDEX_RECORD);
+				result = (length % INDEX_RECORD == 0);
+			}
+			else if (result  &&  memcmp (entry, "NAME", 4) == 0)
+			{
+				file->index.names = base + offset;
+				namesLength = length;
+			}
+			else if (result  &&  memcmp (entry, "HASH", 4) == 0)
+			{
+				file->index.slots = base + offset;
+				file->index.slotCount = (unsigned long) (length / 4);
+			}
+			else if (result  &&  memcmp (entry, "FOLD", 4) == 0)
+			{
+				file->index.folded = base + offset;
+				foldedLength = length;
+			}
+			else if (result  &&  memcmp (entry, "TRIG", 4) == 0)
+			{
+				file->index.trigrams = base + offset;
+				trigramsLength = length;
+			}
+			else if (result  &&  memcmp (entry, "POST", 4) == 0)
+			{
+				file->index.postings = base + offset;
+				file->index.postingCount = (unsigned long) (length / 4);
+			}
+		}
+	}
+	if (result)
+	{
+		/* each string must be terminated, each record named, and names
+		 * hashed into a table of a power of 2 slots, at least one empty */
+		const unsigned long slots = file->index.slotCount;
+		result = (file->index.strings != NULL  &&
+				  file->index.stringsLength > 0  &&
+				  file->index.strings [file->index.stringsLength - 1] == '\0'  &&
+				  file->index.records != NULL  &&  file->index.names != NULL  &&
+				  namesLength == (off_t) file->index.count * 4  &&
+				  file->index.slots != NULL  &&  slots > 0  &&
+				  (slots & (slots - 1)) == 0);
+	}
+	if (result  &&  foldedLength != (off_t) file->index.count * 4)
+		file->index.folded = NULL;
+	if (result)
+	{
+		/* the trigrams must be ended, and their postings present */
+		const unsigned char *const trigrams = file->index.trigrams;
+		if (trigrams != NULL  &&  file->index.postings != NULL  &&
+			trigramsLength >= 8  &&  trigramsLength % 8 == 0  &&
+			indexNumber (trigrams + trigramsLength - 8) == INDEX_TRIGRAM_END  &&
+			indexNumber (trigrams + trigramsLength - 4) ==
+					file->index.postingCount)
+			file->index.trigramCount = (unsigned long) (trigramsLength / 8) - 1;
+		else
+			file->index.trigrams = NULL;
+	}
+	return result;
+}
+
+/*  Read or map the index of the tag file at `filePath' into memory, where it
+ *  exists and describes the tag file, which is open as `file->fp'.
+ */
+static void loadIndex (tagFile *const file, const char *const filePath)
+{
+	struct stat status;
+	char *const name = (char*) malloc (strlen (filePath) + sizeof (INDEX_SUFFIX));
+	FILE *fp = NULL;
+	if (name != NULL  &&  fstat (fileno (file->fp), &status) == 0)
+	{
+		strcpy (name, filePath);
+		strcat (name, INDEX_SUFFIX);
+		fp = fopen (name, "rb");
+	}
+	if (fp != NULL)
+	{
+		struct stat indexStatus;
+		if (fstat (fileno (fp), &indexStatus) == 0  &&
+			indexStatus.st_size >= INDEX_HEADER  &&
+			(off_t) (size_t) indexStatus.st_size == indexStatus.st_size)
+		{
+			const size_t size = (size_t) indexStatus.st_size;
+#ifdef READTAGS_MMAP
+			void *const base = mmap (NULL, size, PROT_READ, MAP_SHARED,
+					fileno (fp), 0);
+			if (base != MAP_FAILED)
+			{
+				file->index.base = (unsigned char*) base;
+				file->index.mapped = 1;
+			}
+#endif
+			if (file->index.base == NULL)
+			{
+				file->index.base = (unsigned char*) malloc (size);
+				if (file->index.base != NULL  &&
+					fread (file->index.base, 1, size, fp) != size)
+				{
+					free (file->index.base);
+					file->index.base = NULL;
+				}
+			}
+			file->index.size = size;
+			if (file->index.base != NULL  &&  ! parseIndex (file, &status))
+				forgetIndex (file);
+		}
+		fclose (fp);
+	}
+	if (name != NULL)
+		free (name);
+}
+
+static void forgetBloom (tagFile *const file)
+{
+	if (file->bloom.bits != NULL  &&  ! file->bloom.borrowed)
+		free (file->bloom.bits);
+	memset (&file->bloom, 0, sizeof (file->bloom));
+}
+
+/*  Read the Bloom filter of the tag file at `filePath' into memory, where it
+ *  exists and describes the tag file, which is open as `file->fp'.
+ */
+static void loadBloom (tagFile *const file, const char *const filePath)
+{
+	struct stat status;
+	char *const name = (char*) malloc (strlen (filePath) + sizeof (BLOOM_SUFFIX));
+	FILE *fp = NULL;
+	if (name != NULL  &&  fstat (fileno (file->fp), &status) == 0)
+	{
+		strcpy (name, filePath);
+		strcat (name, BLOOM_SUFFIX);
+		fp = fopen (name, "rb");
+	}
+	if (fp != NULL)
+	{
+		unsigned char header [BLOOM_HEADER];
+		struct stat bloomStatus;
+		const off_t length = (fstat (fileno (fp), &bloomStatus) == 0) ?
+				bloomStatus.st_size - BLOOM_HEADER : 0;
+		if (length > 0  &&  length <= BLOOM_LIMIT  &&
+			(length & (length - 1)) == 0  &&
+			fread (header, 1, BLOOM_HEADER, fp) == BLOOM_HEADER  &&
+			memcmp (header, BLOOM_MAGIC, 8) == 0  &&
+			indexNumber (header + 8) == BLOOM_VERSION  &&
+			indexOffset (header + 16) == (off_t) status.st_size  &&
+			indexOffset (header + 24) == (off_t) status.st_mtime)
+		{
+			file->bloom.bits = (unsigned char*) malloc ((size_t) length);
+			if (file->bloom.bits != NULL  &&
+				fread (file->bloom.bits, 1, (size_t) length, fp) != (size_t) length)
+				forgetBloom (file);
+			else if (file->bloom.bits != NULL)
+			{
+				file->bloom.mask = (unsigned long) (8 * length - 1);
+				file->bloom.probes = indexNumber (header + 12);
+			}
+		}
+		fclose (fp);
+	}
+	if (name != NULL)
+		free (name);
+}
+
+/*  Extend a 32-bit FNV-1a hash with the `length' characters at `name',
+ *  folded to upper case.
+ */
+static unsigned long foldedHash (unsigned long hash, const char *const name,
+		const size_t length)
+{
+	size_t i;
+	for (i = 0  ;  i < length  ;  ++i)
+	{
+		hash ^= (unsigned long) toupper ((unsigned char) name [i]);
+		hash = (hash * 16777619UL) & 0xffffffffUL;
+	}
+	return hash;
+}
+
+#endif
+
+static void forgetSamples (tagFile *const file)
+{
+	int i;
+	for (i = 0  ;  i < SAMPLE_COUNT  ;  ++i)
+		file->samples [i].filled = 0;
+}
+
+/*  Measure the size of a tag file which is not mapped. The lines sampled
+ *  from it are forgotten should it have changed since last measured.
+ */
+static void measureTagFile (tagFile *const file)
+{
+	if (file->zip.starts != NULL)
+		return;  /* size is that given by the header */
+#ifdef READTAGS_FSTAT
+	struct stat status;
+	if (fstat (fileno (file->fp), &status) == 0)
+	{
+		if (status.st_size != file->size  ||
+			(long) status.st_mtime != file->modified)
+		{
+			forgetSamples (file);
+		}
+		file->size = status.st_size;
+		file->modified = (long) status.st_mtime;
+	}
+	else
+#endif
+	{
+		fseek (file->fp, 0, SEEK_END);
+		if (ftell (file->fp) != file->size)
+			forgetSamples (file);
+		file->size = ftell (file->fp);
+		rewind (file->fp);
+	}
+}
+
+static void forgetWantedFields (tagFile *const file)
+{
+	if (file->fields.wanted != NULL)
+	{
+		int i;
+		for (i = 0  ;  file->fields.wanted [i] != NULL  ;  ++i)
+			free (file->fields.wanted [i]);
+		free (file->fields.wanted);
+		file->fields.wanted = NULL;
+	}
+}
+
+static tagResult setWantedFields (tagFile *const file,
+								  const char *const *const keys)
+{
+	tagResult result = TagSuccess;
+	forgetWantedFields (file);
+	if (keys != NULL)
+	{
+		int count = 0;
+		while (keys [count] != NULL)
+			++count;
+		file->fields.wanted = (char**) calloc ((size_t) count + 1, sizeof (char*));
+		if (file->fields.wanted == NULL)
+		{
+			perror (NULL);
+			result = TagFailure;
+		}
+		else
+		{
+			int i;
+			for (i = 0  ;  i < count  &&  result == TagSuccess  ;  ++i)
+			{
+				file->fields.wanted [i] = duplicate (keys [i]);
+				if (file->fields.wanted [i] == NULL)
+					result = TagFailure;
+			}
+			if (result != TagSuccess)
+				forgetWantedFields (file);
+		}
+	}
+	return result;
+}
+
+#ifdef READTAGS_ZLIB
+
+static off_t readNumber (const unsigned char *const p, const int bytes)
+{
+	off_t result = 0;
+	int i;
+	for (i = bytes - 1  ;  i >= 0  ;  --i)
+		result = (result << 8) | p [i];
+	return result;
+}
+
+/*  Read the header and table of blocks of a compressed tag file, reopened
+ *  as binary.
+ */
+static int loadBlockTable (tagFile *const file)
+{
+	unsigned char header [ZIP_HEADER];
+	int result = 0;
+	if (fread (header, 1, sizeof (header), file->fp) == sizeof (header)  &&
+		readNumber (header + 8, 4) == ZIP_VERSION)
+	{
+		const unsigned long count = (unsigned long) readNumber (header + 12, 4);
+		const off_t table = readNumber (header + 24, 8);
+		file->zip.starts = (off_t*) calloc ((size_t) count + 1, sizeof (off_t));
+		file->zip.offsets = (off_t*) calloc ((size_t) count + 1, sizeof (off_t));
+		if (file->zip.starts != NULL  &&  file->zip.offsets != NULL  &&
+			fseek (file->fp, table, SEEK_SET) == 0)
+		{
+			unsigned char entry [ZIP_ENTRY];
+			unsigned long i;
+			result = 1;
+			for (i = 0  ;  i < count  &&  result  ;  ++i)
+			{
+				result = (fread (entry, 1, sizeof (entry), file->fp) ==
+						sizeof (entry));
+				file->zip.starts [i] = readNumber (entry, 8);
+				file->zip.offsets [i] = readNumber (entry + 8, 8);
+			}
+			file->zip.count = count;
+			file->zip.current = count;
+			file->size = readNumber (header + 16, 8);
+			file->zip.starts [count] = file->size;
+			file->zip.offsets [count] = table;
+		}
+	}
+	return result;
+}
+
+#endif
+
+static void forgetCompression (tagFile *const file)
+{
+	if (file->zip.starts != NULL)
+		free (file->zip.starts);
+	if (file->zip.offsets != NULL)
+		free (file->zip.offsets);
+	if (file->zip.text != NULL)
+		free (file->zip.text);
+	if (file->zip.packed != NULL)
+		free (file->zip.packed);
+	memset (&file->zip, 0, sizeof (file->zip));
+}
+
+/*  Check whether the tag file is compressed and, if so, load its table of
+ *  blocks. Returns 0, setting errno, if it cannot be read.
+ */
+static int loadCompression (tagFile *const file)
+{
+	char magic [sizeof (ZIP_MAGIC) - 1];
+	int result = 1;
+	if (fread (magic, 1, sizeof (magic), file->fp) == sizeof (magic)  &&
+		memcmp (magic, ZIP_MAGIC, sizeof (magic)) == 0)
+	{
+#ifdef READTAGS_ZLIB
+		file->fp = freopen (file->path, "rb", file->fp);
+		result = (file->fp != NULL  &&  loadBlockTable (file));
+		if (! result)
+			forgetCompression (file);
+#else
+		result = 0;
+#endif
+		if (! result)
+			errno = EINVAL;
+	}
+	else
+		rewind (file->fp);
+	return result;
+}
+
+static tagFile *allocate (void)
+{
+	tagFile *result = (tagFile*) calloc ((size_t) 1, sizeof (tagFile));
+	if (result != NULL)
+	{
+		growString (&result->line);
+		result->fields.max = 20;
+		result->fields.list = (tagExtensionField*) calloc (
+			result->fields.max, sizeof (tagExtensionField));
+	}
+	return result;
+}
+
+static tagFile *initialize (const char *const filePath, tagFileInfo *const info,
+							const int mapped)
+{
+	tagFile *result = allocate ();
+	if (result != NULL)
+	{
+		result->fp = fopen (filePath, "r");
+		if (result->fp != NULL)
+		{
+			result->path = duplicate (filePath);
+			if (! loadCompression (result))
+			{
+				if (result->fp != NULL)
+					fclose (result->fp);
+				result->fp = NULL;
+				free (result->path);
+			}
+		}
+		if (result->fp == NULL)
+		{
+			info->status.error_number = errno;
+			free (result->line.buffer);
+			free (result->fields.list);
+			free (result);
+			result = NULL;
+		}
+		else
+		{
+			/*  A compressed tag file is neither mapped nor indexed, since
+			 *  its lines do not lie at their positions in the file.
+			 */
+			if (result->zip.starts == NULL)
+			{
+#ifdef READTAGS_INDEX
+				loadIndex (result, filePath);
+				loadBloom (result, filePath);
+#endif
+				if (mapped)
+					mapTagFile (result);
+				if (result->map.base == NULL)
+					measureTagFile (result);
+			}
+			readPseudoTags (result, info);
+			info->status.opened = 1;
+			result->initialized = 1;
+		}
+	}
+	return result;
+}
+
+/*  Make a new handle sharing the mapping of `file', whose lines are copied
+ *  by both from then on before being parsed, because the mapping can no
+ *  longer be written to.
+ */
+static tagFile *shareMapping (tagFile *const file)
+{
+	tagFile *result = allocate ();
+	if (result != NULL)
+	{
+		restoreLine (file);
+		file->map.shared = 1;
+		result->format = file->format;
+		result->size = file->size;
+		result->map.base = file->map.base;
+		result->map.borrowed = 1;
+		result->map.shared = 1;
+		result->index = file->index;
+		result->index.borrowed = 1;
+		result->bloom = file->bloom;
+		result->bloom.borrowed = 1;
+		result->path = duplicate (file->path);
+		result->program.author = duplicate (file->program.author);
+		result->program.name = duplicate (file->program.name);
+		result->program.url = duplicate (file->program.url);
+		result->program.version = duplicate (file->program.version);
+		memcpy (result->samples, file->samples, sizeof (result->samples));
+		result->initialized = 1;
+	}
+	return result;
+}
+
+static tagFile *openCursor (tagFile *const file)
+{
+	tagFile *result;
+	if (file->map.base != NULL)
+		result = shareMapping (file);
+	else
+	{
+		tagFileInfo info;
+		result = initialize (file->path, &info, 0);
+	}
+	if (result != NULL)
+	{
+		result->sortMethod = file->sortMethod;
+		setWantedFields (result, (const char *const *) file->fields.wanted);
+	}
+	return result;
+}
+
+static void terminate (tagFile *const file)
+{
+#ifdef READTAGS_MMAP
+	if (file->map.base != NULL  &&  ! file->map.borrowed)
+		munmap (file->map.base, (size_t) file->size);
+#endif
+	if (file->fp != NULL)
+		fclose (file->fp);
+#ifdef READTAGS_INDEX
+	forgetIndex (file);
+	forgetBloom (file);
+#endif
+	forgetCompression (file);
+
+	free (file->line.buffer);
+	free (file->fields.list);
+	forgetWantedFields (file);
+	if (file->map.saved != NULL)
+		free (file->map.saved);
+
+	if (file->program.author != NULL)
+		free (file->program.author);
+	if (file->program.name != NULL)
+		free (file->program.name);
+	if (file->program.url != NULL)
+		free (file->program.url);
+	if (file->program.version != NULL)
+		free (file->program.version);
+	if (file->search.name != NULL)
+		free (file->search.name);
+	if (file->path != NULL)
+		free (file->path);
+
+	memset (file, 0, sizeof (tagFile));
+
+	free (file);
+}
+
+static tagResult readNext (tagFile *const file, tagEntry *const entry)
+{
+	tagResult result;
+	if (file == NULL  ||  ! file->initialized)
+		result = TagFailure;
+	else if (! readTagLine (file))
+		result = TagFailure;
+	else
+	{
+		if (entry != NULL)
+			parseTagLine (file, entry);
+		result = TagSuccess;
+	}
+	return result;
+}
+
+static const char *readFieldValue (
+	const tagEntry *const entry, const char *const key)
+{
+	const char *result = NULL;
+	int i;
+	if (strcmp (key, "kind") == 0)
+		result = entry->kind;
+	else if (strcmp (key, "file") == 0)
+		result = EmptyString;
+	else for (i = 0  ;  i < entry->fields.count  &&  result == NULL  ;  ++i)
+		if (strcmp (entry->fields.list [i].key, key) == 0)
+			result = entry->fields.list [i].value;
+	return result;
+}
+
+static int readTagLineSeek (tagFile *const file, const off_t pos)
+{
+	int result = 0;
+	if (seekTagFile (file, pos))
+	{
+		result = readTagLine (file);  /* read probable partial line */
+		if (pos > 0  &&  result)
+			result = readTagLine (file);  /* read complete line */
+	}
+	return result;
+}
+
+/*  Compare the name searched for with the name of the tag in the last line
+ *  read, which is not necessarily terminated.
+ *  Return 0 for match, < 0 for smaller, > 0 for bigger
+ *  When ignoring case, make sure case is folded to uppercase in comparison
+ *  (like for 'sort -f'). This makes a difference when one of the chars lies
+ *  between upper and lower ie. one of the chars [ \ ] ^ _ ` for ascii. (The
+ *  '_' in particular !)
+ */
+static int compareText (const char *const name, const size_t length,
+		const int partial, const int ignorecase,
+		const char *const text, const size_t textLength)
+{
+	const unsigned char *const search = (const unsigned char*) name;
+	const unsigned char *const line = (const unsigned char*) text;
+	const size_t limit = partial ? length : length + 1;
+	int result = 0;
+	size_t i;
+	for (i = 0  ;  result == 0  &&  i < limit  ;  ++i)
+	{
+		const int c1 = search [i];
+		const int c2 = (i < textLength) ? line [i] : '\0';
+		if (ignorecase)
+			result = toupper (c1) - toupper (c2);
+		else
+			result = c1 - c2;
+		if (c1 == '\0'  ||  c2 == '\0')
+			break;
+	}
+	return result;
+}
+
+static int compareName (const tagFile *const file, const char *const name,
+		const size_t length, const int partial, const int ignorecase)
+{
+	return compareText (name, length, partial, ignorecase,
+			file->lineText, file->nameLength);
+}
+
+/*  Return whether the text contains the name searched for or, for a
+ *  subsequence, its characters in order, though not necessarily adjacent.
+ */
+static int containsText (const char *const name, const size_t length,
+		const int subsequence, const int ignorecase,
+		const char *const text, const size_t textLength)
+{
+	int result = 0;
+	if (subsequence)
+	{
+		const unsigned char *const search = (const unsigned char*) name;
+		const unsigned char *const line = (const unsigned char*) text;
+		size_t i = 0;
+		size_t j;
+		for (j = 0  ;  i < length  &&  j < textLength  ;  ++j)
+		{
+			if (ignorecase ? toupper (search [i]) == toupper (line [j])
+						   : search [i] == line [j])
+				++i;
+		}
+		result = (i == length);
+	}
+	else
+	{
+		size_t start;
+		for (start = 0  ;  ! result  &&  start + length <= textLength  ;  ++start)
+			result = (compareText (name, length, 1, ignorecase,
+					text + start, textLength - start) == 0);
+	}
+	return result;
+}
+
+/*  Compare the text with the name searched for, as does compareText(),
+ *  except that only 0 is meaningful when searching for names containing it.
+ */
+static int searchComparison (const tagFile *const file,
+		const char *const text, const size_t textLength)
+{
+	int result;
+	if (file->search.substring  ||  file->search.subsequence)
+		result = ! containsText (file->search.name, file->search.nameLength,
+				file->search.subsequence, file->search.ignorecase,
+				text, textLength);
+	else
+		result = compareText (file->search.name, file->search.nameLength,
+				file->search.partial, file->search.ignorecase,
+				text, textLength);
+	return result;
+}
+
+static int nameComparison (tagFile *const file)
+{
+	return searchComparison (file, file->lineText, file->nameLength);
+}
+
+/*  Read a line before the last one read which does not match, returning
+ *  whether the line read instead matches, being the first of the file.
+ */
+static int findFirstNonMatchBefore (tagFile *const file)
+{
+#define JUMP_BACK 512
+	int more_lines;
+	int comp;
+	off_t start = file->pos;
+	off_t pos = start;
+	do
 	{
 		if (pos < (off_t) JUMP_BACK)
 			pos = 0;
 		else
-			pos = pos - JUMP_BACK;
-		more_lines = readTagLineSeek (file, pos);
-		comp = nameComparison (file);
-	} while (more_lines  &&  comp == 0  &&  pos > 0  &&  pos < start);
+			pos = pos - JUMP_BACK;
+		more_lines = readTagLineSeek (file, pos);
+		comp = nameComparison (file);
+	} while (more_lines  &&  comp == 0  &&  pos > 0  &&  pos < start);
+	return more_lines  &&  comp == 0;
+}
+
+static tagResult findFirstMatchBefore (tagFile *const file)
+{
+	tagResult result = TagFailure;
+	int more_lines;
+	off_t start = file->pos;
+	if (findFirstNonMatchBefore (file))
+		result = TagSuccess;
+	else
+	{
+		do
+		{
+			more_lines = readTagLine (file);
+			if (nameComparison (file) == 0)
+				result = TagSuccess;
+		} while (more_lines  &&  result != TagSuccess  &&  file->pos < start);
+	}
+	return result;
+}
+
+/*  Return jump point `i', reading the line following it if not yet read.
+ */
+static const sample *getSample (tagFile *const file, const int i)
+{
+	sample *const entry = &file->samples [i];
+	if (! entry->filled)
+	{
+		const off_t pos = (off_t) ((double) file->size * i / SAMPLE_COUNT);
+		entry->atEnd = ! readTagLineSeek (file, pos);
+		entry->pos = entry->atEnd ? file->size : file->pos;
+		entry->length = entry->atEnd ? 0 : file->nameLength;
+		if (! entry->atEnd)
+			memcpy (entry->prefix, file->lineText,
+				file->nameLength < SAMPLE_PREFIX ? file->nameLength : SAMPLE_PREFIX);
+		entry->filled = 1;
+	}
+	return entry;
+}
+
+/*  Compare the name searched for with the name of the tag of a jump point,
+ *  of which only the leading characters are known, returning 0 whenever it
+ *  is not certain which is smaller, or if the jump point could match.
+ */
+static int sampleComparison (const tagFile *const file, const sample *const entry)
+{
+	const unsigned char *const search =
+			(const unsigned char*) file->search.name;
+	const size_t known =
+			(entry->length < SAMPLE_PREFIX) ? entry->length : SAMPLE_PREFIX;
+	int result = 0;
+	size_t i;
+	for (i = 0  ;  result == 0  &&  i < known  &&  i < file->search.nameLength  ;  ++i)
+	{
+		const int c1 = search [i];
+		const int c2 = (unsigned char) entry->prefix [i];
+		if (file->search.ignorecase)
+			result = toupper (c1) - toupper (c2);
+		else
+			result = c1 - c2;
+	}
+	if (entry->atEnd)
+		result = -1;  /* as if the end of the file were a larger name */
+	else if (result != 0)
+		;
+	else if (i == file->search.nameLength)
+	{
+		/* name searched for is a prefix of the name of the jump point */
+		if (! file->search.partial  &&  entry->length > i)
+			result = -1;
+	}
+	else if (i == entry->length)
+		result = 1;  /* name of the jump point is a prefix of the name */
+	return result;
+}
+
+/*  Narrow the range of a binary search to lie between the closest jump
+ *  points on either side of the name searched for, themselves found by
+ *  binary searches of the jump points.
+ */
+static void narrowSearch (tagFile *const file, off_t *const lower, off_t *const upper)
+{
+	if (file->size >= (off_t) SAMPLE_COUNT * SAMPLE_SPACING)
+	{
+		int low = 0;             /* jump points before are all smaller */
+		int high = SAMPLE_COUNT; /* jump points from here on are all larger */
+		int i = 0, j;
+		while (i < high)
+		{
+			const int mid = i + (high - i) / 2;
+			if (sampleComparison (file, getSample (file, mid)) > 0)
+			{
+				low = mid;
+				i = mid + 1;
+			}
+			else
+				high = mid;
+		}
+		i = low + 1;
+		high = SAMPLE_COUNT;
+		for (j = SAMPLE_COUNT  ;  i < j  ;  )
+		{
+			const int mid = i + (j - i) / 2;
+			if (sampleComparison (file, getSample (file, mid)) < 0)
+				high = j = mid;
+			else
+				i = mid + 1;
+		}
+		if (low > 0)
+			*lower = file->samples [low].pos;
+		if (high < SAMPLE_COUNT)
+			*upper = file->samples [high].pos;
+	}
+}
+
+/*  Binary search for the first tag matching the name searched for between
+ *  `*lower', which is known to be followed by a smaller tag, and `upper',
+ *  known to be followed by a larger one. On return `*lower' has been advanced
+ *  as far as the search allowed, whether or not the tag was found.
+ */
+static tagResult findBinaryWithin (tagFile *const file,
+		off_t *const lower, off_t upper)
+{
+	tagResult result = TagFailure;
+	off_t last_pos = 0;
+	off_t pos = *lower + ((upper - *lower) / 2);
+	while (result != TagSuccess)
+	{
+		if (! readTagLineSeek (file, pos))
+		{
+			/* in case we fell off end of file */
+			result = findFirstMatchBefore (file);
+			break;
+		}
+		else if (pos == last_pos)
+		{
+			/* prevent infinite loop if we backed up to beginning of file */
+			break;
+		}
+		else
+		{
+			const int comp = nameComparison (file);
+			last_pos = pos;
+			if (comp < 0)
+			{
+				upper = pos;
+				pos = *lower + ((upper - *lower) / 2);
+			}
+			else if (comp > 0)
+			{
+				*lower = pos;
+				pos = *lower + ((upper - *lower) / 2);
+			}
+			else if (pos == 0)
+				result = TagSuccess;
+			else
+				result = findFirstMatchBefore (file);
+		}
+	}
+	return result;
+}
+
+static tagResult findBinary (tagFile *const file)
+{
+	off_t lower_limit = 0;
+	off_t upper_limit = file->size;
+	narrowSearch (file, &lower_limit, &upper_limit);
+	return findBinaryWithin (file, &lower_limit, upper_limit);
+}
+
+/*  Find the first tag matching the name searched for, which must sort no
+ *  earlier than the tag following `*lower', by probing forward from there in
+ *  doubling steps until a tag no smaller than the name is reached, then
+ *  searching the range this brackets. Queries made in sorted order thereby
+ *  cost in proportion to the distance between their tags rather than to the
+ *  size of the file.
+ */
+static tagResult findGalloping (tagFile *const file, off_t *const lower)
+{
+	tagResult result = TagFailure;
+	off_t step = GALLOP_STEP;
+	off_t upper = file->size;
+	int probing = 1;
+	while (probing)
+	{
+		const off_t pos = *lower + step;
+		if (pos >= file->size  ||  ! readTagLineSeek (file, pos))
+			probing = 0;
+		else
+		{
+			const int comp = nameComparison (file);
+			if (comp > 0)
+			{
+				*lower = pos;
+				step *= 2;
+			}
+			else
+			{
+				upper = pos;
+				probing = 0;
+				if (comp == 0)
+					result = findFirstMatchBefore (file);
+			}
+		}
+	}
+	if (result != TagSuccess)
+		result = findBinaryWithin (file, lower, upper);
+	return result;
+}
+
+static tagResult findSequential (tagFile *const file)
+{
+	tagResult result = TagFailure;
+	if (file->initialized)
+	{
+		while (result == TagFailure  &&  readTagLine (file))
+		{
+			if (nameComparison (file) == 0)
+				result = TagSuccess;
+		}
+	}
+	return result;
+}
+
+/*  Could names beginning with `prefix' be those of pseudo-tags, which are
+ *  left out of the index?
+ */
+static int isPseudoTagPrefix (const char *const prefix)
+{
+	const size_t length = strlen (prefix);
+	const size_t pseudoLength = strlen (PseudoTagPrefix);
+	return strncmp (prefix, PseudoTagPrefix,
+			length < pseudoLength ? length : pseudoLength) == 0;
+}
+
+#ifdef READTAGS_INDEX
+
+/*  Return the name of the tag of the record at `position' within the order
+ *  searched, which is empty if the index is unsound.
+ */
+static const char *indexedName (const tagFile *const file,
+		const unsigned long position)
+{
+	const char *result = EmptyString;
+	const unsigned long record =
+			indexNumber (file->search.order + 4 * position);
+	if (record < file->index.count)
+	{
+		const unsigned long name = indexNumber (file->index.records +
+				INDEX_RECORD * record + INDEX_RECORD_NAME);
+		if (name < file->index.stringsLength)
+			result = file->index.strings + name;
+	}
+	return result;
+}
+
+static int indexedNameComparison (const tagFile *const file,
+		const unsigned long position)
+{
+	const char *const name = indexedName (file, position);
+	return searchComparison (file, name, strlen (name));
+}
+
+/*  Return the position within the names of the index of the first name
+ *  which is the name searched for, or the number of records if none is.
+ */
+static unsigned long findIndexedName (tagFile *const file)
+{
+	const char *const search = file->search.name;
+	const unsigned long mask = file->index.slotCount - 1;
+	unsigned long hash = 2166136261UL;  /* 32-bit FNV-1a, as by ctags */
+	unsigned long result = file->index.count;
+	unsigned long slot;
+	unsigned long probes;
+	size_t i;
+	for (i = 0  ;  i < file->search.nameLength  ;  ++i)
+	{
+		hash ^= (unsigned char) search [i];
+		hash = (hash * 16777619UL) & 0xffffffffUL;
+	}
+	slot = hash & mask;
+	for (probes = 0  ;  probes <= mask  ;  ++probes)
+	{
+		const unsigned long entry = indexNumber (file->index.slots + 4 * slot);
+		if (entry == 0  ||  entry > file->index.count)
+			break;
+		else if (strcmp (indexedName (file, entry - 1), search) == 0)
+		{
+			result = entry - 1;
+			break;
+		}
+		slot = (slot + 1) & mask;
+	}
+	return result;
+}
+
+/*  Return the position within the order searched of the first name which
+ *  the name searched for does not follow or, if `past', which it precedes.
+ */
+static unsigned long findIndexedPrefix (tagFile *const file, const int past)
+{
+	unsigned long lower = 0;
+	unsigned long upper = file->index.count;
+	while (lower < upper)
+	{
+		const unsigned long middle = lower + (upper - lower) / 2;
+		const int comp = indexedNameComparison (file, middle);
+		if (past ? (comp >= 0) : (comp > 0))
+			lower = middle + 1;
+		else
+			upper = middle;
+	}
+	return lower;
 }
 
-static tagResult findFirstMatchBefore (tagFile *const file)
+/*  Return the position within the trigrams of the index of that of the
+ *  characters at `p', or the number of trigrams if it is not there.
+ */
+static unsigned long findTrigram (const tagFile *const file,
+		const char *const p)
+{
+	const unsigned char *const s = (const unsigned char*) p;
+	const unsigned long trigram = ((unsigned long) toupper (s [0]) << 16)  |
+			((unsigned long) toupper (s [1]) << 8)  |
+			(unsigned long) toupper (s [2]);
+	unsigned long lower = 0;
+	unsigned long upper = file->index.trigramCount;
+	while (lower < upper)
+	{
+		const unsigned long middle = lower + (upper - lower) / 2;
+		if (indexNumber (file->index.trigrams + 8 * middle) < trigram)
+			lower = middle + 1;
+		else
+			upper = middle;
+	}
+	if (lower < file->index.trigramCount  &&
+		indexNumber (file->index.trigrams + 8 * lower) != trigram)
+		lower = file->index.trigramCount;
+	return lower;
+}
+
+/*  Choose the names of the index to try for those containing the name
+ *  searched for: the postings of the rarest of its trigrams, if it is a
+ *  substring and long enough to have any, or else every name.
+ */
+static void chooseCandidates (tagFile *const file)
+{
+	file->search.postings = NULL;
+	file->search.candidate = 0;
+	file->search.candidates = file->index.count;
+	if (file->search.substring  &&  ! file->search.subsequence  &&
+		file->index.trigrams != NULL  &&
+		file->search.nameLength >= INDEX_TRIGRAM)
+	{
+		const unsigned char *const trigrams = file->index.trigrams;
+		size_t i;
+		file->search.postings = file->index.postings;
+		for (i = 0  ;  i + INDEX_TRIGRAM <= file->search.nameLength  &&
+					file->search.candidate < file->search.candidates  ;  ++i)
+		{
+			const unsigned long t = findTrigram (file, file->search.name + i);
+			unsigned long first = 0;
+			unsigned long last = 0;
+			if (t < file->index.trigramCount)
+			{
+				first = indexNumber (trigrams + 8 * t + 4);
+				last = indexNumber (trigrams + 8 * (t + 1) + 4);
+				if (last > file->index.postingCount)
+					last = file->index.postingCount;
+				if (first > last)
+					first = last;
+			}
+			if (i == 0  ||
+				last - first < file->search.candidates - file->search.candidate)
+			{
+				file->search.candidate = first;
+				file->search.candidates = last;
+			}
+		}
+	}
+}
+
+/*  Read the line of the tag at `position' within the order searched if it
+ *  matches the name searched for, checking the name on that line.
+ */
+static tagResult readIndexedTag (tagFile *const file,
+		const unsigned long position)
 {
 	tagResult result = TagFailure;
-	int more_lines;
-	off_t start = file->pos;
-	findFirstNonMatchBefore (file);
-	do
+	file->search.position = position;
+	if (position < file->index.count  &&
+		indexedNameComparison (file, position) == 0)
+	{
+		const unsigned long record =
+				indexNumber (file->search.order + 4 * position);
+		const off_t offset = indexOffset (file->index.records +
+				INDEX_RECORD * record + INDEX_RECORD_OFFSET);
+		if (seekTagFile (file, offset)  &&  readTagLine (file)  &&
+			nameComparison (file) == 0)
+			result = TagSuccess;
+	}
+	return result;
+}
+
+/*  Read the line of the next tag among the candidates chosen which contains
+ *  the name searched for.
+ */
+static tagResult findIndexedCandidate (tagFile *const file)
+{
+	tagResult result = TagFailure;
+	while (result != TagSuccess  &&
+		   file->search.candidate < file->search.candidates)
+	{
+		const unsigned long candidate = file->search.candidate++;
+		if (file->search.postings == NULL)
+			result = readIndexedTag (file, candidate);
+		else
+			result = readIndexedTag (file,
+					indexNumber (file->search.postings + 4 * candidate));
+	}
+	return result;
+}
+
+/*  Read the next of the pseudo-tags at the head of the tag file which
+ *  matches the name searched for. Being left out of the index, they are
+ *  read from the tag file itself, so that an index never changes the tags
+ *  found.
+ */
+static tagResult findPseudoTag (tagFile *const file)
+{
+	tagResult result = TagFailure;
+	while (result != TagSuccess  &&  file->search.pseudo)
+	{
+		if (readTagLine (file)  &&  isPseudoTagLine (file))
+		{
+			if (nameComparison (file) == 0)
+				result = TagSuccess;
+		}
+		else
+			file->search.pseudo = 0;
+	}
+	return result;
+}
+
+/*  Read the line of the first tag matched through the index, from the
+ *  position found by findIndexed().
+ */
+static tagResult findFirstIndexed (tagFile *const file)
+{
+	tagResult result;
+	if (file->search.substring  ||  file->search.subsequence)
+		result = findIndexedCandidate (file);
+	else
+		result = readIndexedTag (file, file->search.position);
+	return result;
+}
+
+static tagResult findIndexed (tagFile *const file)
+{
+	tagResult result = TagFailure;
+	if (file->search.substring  ||  file->search.subsequence)
+	{
+		file->search.order = file->index.names;
+		file->search.pseudo = 1;
+		chooseCandidates (file);
+	}
+	else
+	{
+		if (file->search.ignorecase)
+			file->search.order = file->index.folded;
+		else
+			file->search.order = file->index.names;
+		file->search.pseudo = isPseudoTagPrefix (file->search.name);
+		if (file->search.partial  ||  file->search.ignorecase)
+			file->search.position = findIndexedPrefix (file, 0);
+		else
+			file->search.position = findIndexedName (file);
+	}
+	if (file->search.pseudo)
+		result = findPseudoTag (file);
+	if (result != TagSuccess)
+		result = findFirstIndexed (file);
+	return result;
+}
+
+static tagResult findIndexedNext (tagFile *const file)
+{
+	tagResult result = TagFailure;
+	const unsigned long next = file->search.position + 1;
+	if (file->search.pseudo)
+	{
+		result = findPseudoTag (file);
+		if (result != TagSuccess)
+			result = findFirstIndexed (file);
+	}
+	else if (file->search.substring  ||  file->search.subsequence)
+	{
+		/* postings list only the first tag of each name */
+		if (file->search.postings != NULL  &&  next < file->index.count  &&
+			strcmp (indexedName (file, next),
+					indexedName (file, file->search.position)) == 0)
+			result = readIndexedTag (file, next);
+		if (result != TagSuccess)
+			result = findIndexedCandidate (file);
+	}
+	else if (file->search.position < file->index.count)
+		result = readIndexedTag (file, next);
+	return result;
+}
+
+#endif
+
+/*  Is the index to be searched for the name searched for?
+ */
+static int isIndexed (const tagFile *const file, const int ignorecase)
+{
+	int result = 0;
+#ifdef READTAGS_INDEX
+	result = (file->index.base != NULL  &&
+			  (! ignorecase  ||  file->index.folded != NULL));
+#else
+	(void) file;
+	(void) ignorecase;
+#endif
+	return result;
+}
+
+/*  Is the name of `length' characters at `name', matched according to
+ *  `options', shown by the Bloom filter not to be in the tag file? Only
+ *  whole names can be.
+ */
+static int isFilteredOut (const tagFile *const file, const char *const name,
+		const size_t length, const int options)
+{
+	int result = 0;
+#ifdef READTAGS_INDEX
+	const int whole = (options & (TAG_PARTIALMATCH | TAG_SUBSTRINGMATCH |
+			TAG_SUBSEQUENCEMATCH)) == 0;
+	if (file->bloom.bits != NULL  &&  whole)
+	{
+		const unsigned long h1 = foldedHash (2166136261UL, name, length);
+		const unsigned long h2 = foldedHash (h1, name, length) | 1;
+		unsigned long bit = h1;
+		unsigned long probe;
+		for (probe = 0  ;  ! result  &&  probe < file->bloom.probes  ;  ++probe)
+		{
+			const unsigned long b = bit & file->bloom.mask;
+			result = (file->bloom.bits [b / 8] & (1 << (b % 8))) == 0;
+			bit = (bit + h2) & 0xffffffffUL;
+		}
+	}
+#else
+	(void) file;
+	(void) name;
+	(void) length;
+	(void) options;
+#endif
+	return result;
+}
+
+static void setSearch (tagFile *const file, const char *const name,
+		const int options)
+{
+	if (file->search.name != NULL)
+		free (file->search.name);
+	file->search.name = duplicate (name);
+	file->search.nameLength = strlen (name);
+	file->search.partial = (options & TAG_PARTIALMATCH) != 0;
+	file->search.substring = (options & TAG_SUBSTRINGMATCH) != 0;
+	file->search.subsequence = (options & TAG_SUBSEQUENCEMATCH) != 0;
+	file->search.ignorecase = (options & TAG_IGNORECASE) != 0;
+	file->search.order = NULL;
+	file->search.postings = NULL;
+	file->search.pseudo = 0;
+	if (file->map.base == NULL)
+		measureTagFile (file);
+	seekTagFile (file, 0);
+}
+
+static int isSearchable (const tagFile *const file, const int ignorecase)
+{
+	return ((file->sortMethod == TAG_SORTED      && !ignorecase) ||
+			(file->sortMethod == TAG_FOLDSORTED  &&  ignorecase));
+}
+
+/*  Return the earliest file position from which readTagLineSeek() reads a
+ *  tag whose name is not before the boundary sought: the first tag which
+ *  the name searched for does not follow or, if `past', the first which it
+ *  precedes. The tag read from a position is never before that read from an
+ *  earlier one, so that the position, lying between `lower' and `upper', is
+ *  found by a binary search over positions rather than over tags.
+ */
+static off_t findBoundary (tagFile *const file, off_t lower, off_t upper,
+		const int past)
+{
+	while (lower < upper)
+	{
+		const off_t middle = lower + (upper - lower) / 2;
+		int before = 0;
+		if (readTagLineSeek (file, middle))
+		{
+			const int comp = nameComparison (file);
+			before = past ? (comp >= 0) : (comp > 0);
+		}
+		if (before)
+			lower = middle + 1;
+		else
+			upper = middle;
+	}
+	return lower;
+}
+
+/*  Return the file position of the tag read by readTagLineSeek() from `pos',
+ *  or the size of the file if there is none.
+ */
+static off_t tagPositionFrom (tagFile *const file, const off_t pos)
+{
+	off_t result = file->size;
+	if (readTagLineSeek (file, pos))
+		result = file->pos;
+	return result;
+}
+
+/*  Return the file position following the last line read.
+ */
+static off_t nextLinePosition (const tagFile *const file)
+{
+	off_t result;
+	if (file->map.base != NULL)
+		result = file->map.next;
+	else if (file->zip.starts != NULL)
+		result = file->zip.next;
+	else
+		result = ftell (file->fp);
+	return result;
+}
+
+static tagResult findRange (tagFile *const file, tagRange *const range,
+		const char *const prefix, const int options, const unsigned long limit)
+{
+	tagResult result = TagFailure;
+	const int ignorecase = (options & TAG_IGNORECASE) != 0;
+	memset (range, 0, sizeof (tagRange));
+	if (isSearchable (file, ignorecase))
+	{
+		off_t lower = 0;
+		off_t upper;
+		off_t first, last, start, end;
+		unsigned long count = 0;
+		setSearch (file, prefix, TAG_PARTIALMATCH | (options & TAG_IGNORECASE));
+		upper = file->size;
+		narrowSearch (file, &lower, &upper);
+		first = findBoundary (file, lower, upper, 0);
+		last = findBoundary (file, first, upper, 1);
+		start = tagPositionFrom (file, first);
+		end = (last == first) ? start : tagPositionFrom (file, last);
+		if (isIndexed (file, ignorecase)  &&  ! isPseudoTagPrefix (prefix))
+		{
+#ifdef READTAGS_INDEX
+			/*  The names of the index are counted without reading the
+			 *  tag file, being in order too.
+			 */
+			file->search.order = ignorecase ? file->index.folded
+											: file->index.names;
+			count = findIndexedPrefix (file, 1) - findIndexedPrefix (file, 0);
+			if (limit > 0  &&  count > limit)
+				count = limit;
+			file->search.order = NULL;
+#endif
+		}
+		else
+		{
+			seekTagFile (file, start);
+			while ((limit == 0  ||  count < limit)  &&
+				   readTagLine (file)  &&  file->pos < end)
+			{
+				++count;
+			}
+		}
+		range->start = (unsigned long) start;
+		range->end = (unsigned long) end;
+		range->count = count;
+		range->next = (unsigned long) start;
+		file->search.pos = file->size;
+		result = TagSuccess;
+	}
+	return result;
+}
+
+static tagResult nextName (tagFile *const file, tagRange *const range,
+		const char **const name)
+{
+	tagResult result = TagFailure;
+	if (range->next < range->end  &&
+		(nextLinePosition (file) == (off_t) range->next  ||
+		 seekTagFile (file, (off_t) range->next))  &&
+		readTagLine (file)  &&  file->pos < (off_t) range->end)
+	{
+		if (file->map.shared  &&  file->lineText != file->line.buffer)
+			copyLine (file);
+		terminateField (file, file->lineText + file->nameLength);
+		range->next = (unsigned long) nextLinePosition (file);
+		*name = file->lineText;
+		result = TagSuccess;
+	}
+	return result;
+}
+
+static tagResult find (tagFile *const file, tagEntry *const entry,
+					   const char *const name, const int options)
+{
+	tagResult result;
+	setSearch (file, name, options);
+	if (isFilteredOut (file, name, file->search.nameLength, options))
+	{
+#ifdef DEBUG
+		printf ("<name ruled out by Bloom filter>\n");
+#endif
+		seekTagFile (file, file->size);
+		result = TagFailure;
+	}
+	else if (isIndexed (file, file->search.ignorecase))
+	{
+#ifdef DEBUG
+		printf ("<performing indexed search>\n");
+#endif
+#ifdef READTAGS_INDEX
+		result = findIndexed (file);
+#endif
+	}
+	else if (! file->search.substring  &&  ! file->search.subsequence  &&
+			 isSearchable (file, file->search.ignorecase))
+	{
+#ifdef DEBUG
+		printf ("<performing binary search>\n");
+#endif
+		result = findBinary (file);
+	}
+	else
+	{
+#ifdef DEBUG
+		printf ("<performing sequential search>\n");
+#endif
+		result = findSequential (file);
+	}
+
+	if (result != TagSuccess)
+		file->search.pos = file->size;
+	else
+	{
+		file->search.pos = file->pos;
+		if (entry != NULL)
+			parseTagLine (file, entry);
+	}
+	return result;
+}
+
+static tagResult findNext (tagFile *const file, tagEntry *const entry)
+{
+	tagResult result = TagFailure;
+	if (file->search.order != NULL)
+	{
+#ifdef READTAGS_INDEX
+		result = findIndexedNext (file);
+#endif
+		if (result == TagSuccess  &&  entry != NULL)
+			parseTagLine (file, entry);
+	}
+	else if (! file->search.substring  &&  ! file->search.subsequence  &&
+			 isSearchable (file, file->search.ignorecase))
+	{
+		result = tagsNext (file, entry);
+		if (result == TagSuccess  && nameComparison (file) != 0)
+			result = TagFailure;
+	}
+	else
+	{
+		result = findSequential (file);
+		if (result == TagSuccess  &&  entry != NULL)
+			parseTagLine (file, entry);
+	}
+	return result;
+}
+
+/*  Compare two names in the order of sorted tag files, ignoring case as
+ *  for --sort=foldcase if `ignorecase'.
+ */
+static int nameOrder (const char *const name1, const char *const name2,
+		const int ignorecase)
+{
+	const unsigned char *s1 = (const unsigned char*) name1;
+	const unsigned char *s2 = (const unsigned char*) name2;
+	int result;
+	if (ignorecase)
+	{
+		while (*s1 != '\0'  &&  toupper (*s1) == toupper (*s2))
+			++s1, ++s2;
+		result = toupper (*s1) - toupper (*s2);
+	}
+	else
+	{
+		while (*s1 != '\0'  &&  *s1 == *s2)
+			++s1, ++s2;
+		result = (int) *s1 - (int) *s2;
+	}
+	return result;
+}
+
+static int queryComparison (const void *const a, const void *const b)
+{
+	return nameOrder (((const query*) a)->name, ((const query*) b)->name, 0);
+}
+
+static int foldedQueryComparison (const void *const a, const void *const b)
+{
+	return nameOrder (((const query*) a)->name, ((const query*) b)->name, 1);
+}
+
+/*  Answers queries, in sorted order, each searched for onward from where the
+ *  search for the one before it left off.
+ */
+static tagResult findManySorted (tagFile *const file,
+		const query *const queries, const unsigned int count,
+		const int options, tagCallback callback, void *const userData)
+{
+	tagResult result = TagFailure;
+	off_t lower = 0;
+	int stop = 0;
+	unsigned int i;
+	for (i = 0  ;  i < count  &&  ! stop  ;  ++i)
 	{
-		more_lines = readTagLine (file);
-		if (nameComparison (file) == 0)
+		setSearch (file, queries [i].name, options);
+		if (findGalloping (file, &lower) == TagSuccess)
+		{
 			result = TagSuccess;
-	} while (more_lines  &&  result != TagSuccess  &&  file->pos < start);
+			do
+			{
+				tagEntry entry;
+				parseTagLine (file, &entry);
+				if (callback (queries [i].index, &entry, userData) != TagSuccess)
+					stop = 1;
+			} while (! stop  &&  readTagLine (file)  &&
+					nameComparison (file) == 0);
+		}
+	}
 	return result;
 }
 
-static tagResult findBinary (tagFile *const file)
+/*  Answers queries against a file whose order cannot be searched, reading
+ *  it once and testing each tag against every query.
+ */
+static tagResult findManySequential (tagFile *const file,
+		const query *const queries, const unsigned int count,
+		const int options, tagCallback callback, void *const userData)
 {
+	const int partial = (options & TAG_PARTIALMATCH) != 0;
+	const int substring = (options & TAG_SUBSTRINGMATCH) != 0;
+	const int subsequence = (options & TAG_SUBSEQUENCEMATCH) != 0;
+	const int ignorecase = (options & TAG_IGNORECASE) != 0;
 	tagResult result = TagFailure;
-	off_t lower_limit = 0;
-	off_t upper_limit = file->size;
-	off_t last_pos = 0;
-	off_t pos = upper_limit / 2;
-	while (result != TagSuccess)
+	int stop = 0;
+	if (file->map.base == NULL)
+		measureTagFile (file);
+	seekTagFile (file, 0);
+	while (! stop  &&  readTagLine (file))
 	{
-		if (! readTagLineSeek (file, pos))
-		{
-			/* in case we fell off end of file */
-			result = findFirstMatchBefore (file);
-			break;
-		}
-		else if (pos == last_pos)
-		{
-			/* prevent infinite loop if we backed up to beginning of file */
-			break;
-		}
-		else
+		int parsed = 0;
+		tagEntry entry;
+		unsigned int i;
+		for (i = 0  ;  i < count  &&  ! stop  ;  ++i)
 		{
-			const int comp = nameComparison (file);
-			last_pos = pos;
-			if (comp < 0)
-			{
-				upper_limit = pos;
-				pos = lower_limit + ((upper_limit - lower_limit) / 2);
-			}
-			else if (comp > 0)
+			const int matched = (substring  ||  subsequence) ?
+					containsText (queries [i].name, queries [i].length,
+						subsequence, ignorecase,
+						file->lineText, file->nameLength) :
+					compareName (file, queries [i].name, queries [i].length,
+						partial, ignorecase) == 0;
+			if (matched)
 			{
-				lower_limit = pos;
-				pos = lower_limit + ((upper_limit - lower_limit) / 2);
-			}
-			else if (pos == 0)
+				if (! parsed)
+				{
+					parseTagLine (file, &entry);
+					parsed = 1;
+				}
 				result = TagSuccess;
-			else
-				result = findFirstMatchBefore (file);
+				if (callback (queries [i].index, &entry, userData) != TagSuccess)
+					stop = 1;
+			}
 		}
 	}
 	return result;
 }
 
-static tagResult findSequential (tagFile *const file)
+#ifdef READTAGS_INDEX
+
+/*  Answers queries through the index, each independently of the others.
+ */
+static tagResult findManyIndexed (tagFile *const file,
+		const query *const queries, const unsigned int count,
+		const int options, tagCallback callback, void *const userData)
 {
 	tagResult result = TagFailure;
-	if (file->initialized)
+	int stop = 0;
+	unsigned int i;
+	for (i = 0  ;  i < count  &&  ! stop  ;  ++i)
 	{
-		while (result == TagFailure  &&  readTagLine (file))
+		tagResult found;
+		setSearch (file, queries [i].name, options);
+		for (found = findIndexed (file)  ;  found == TagSuccess  &&  ! stop  ;
+			 found = findIndexedNext (file))
 		{
-			if (nameComparison (file) == 0)
-				result = TagSuccess;
+			tagEntry entry;
+			result = TagSuccess;
+			parseTagLine (file, &entry);
+			if (callback (queries [i].index, &entry, userData) != TagSuccess)
+				stop = 1;
 		}
 	}
 	return result;
 }
 
-static tagResult find (tagFile *const file, tagEntry *const entry,
-					   const char *const name, const int options)
-{
-	tagResult result;
-	if (file->search.name != NULL)
-		free (file->search.name);
-	file->search.name = duplicate (name);
-	file->search.nameLength = strlen (name);
-	file->search.partial = (options & TAG_PARTIALMATCH) != 0;
-	file->search.ignorecase = (options & TAG_IGNORECASE) != 0;
-	fseek (file->fp, 0, SEEK_END);
-	file->size = ftell (file->fp);
-	rewind (file->fp);
-	if ((file->sortMethod == TAG_SORTED      && !file->search.ignorecase) ||
-		(file->sortMethod == TAG_FOLDSORTED  &&  file->search.ignorecase))
-	{
-#ifdef DEBUG
-		printf ("<performing binary search>\n");
-#endif
-		result = findBinary (file);
-	}
-	else
-	{
-#ifdef DEBUG
-		printf ("<performing sequential search>\n");
 #endif
-		result = findSequential (file);
-	}
 
-	if (result != TagSuccess)
-		file->search.pos = file->size;
+static tagResult findMany (tagFile *const file,
+		const char *const *const names, const unsigned int count,
+		const int options, tagCallback callback, void *const userData)
+{
+	const int ignorecase = (options & TAG_IGNORECASE) != 0;
+	const int containing =
+			(options & (TAG_SUBSTRINGMATCH | TAG_SUBSEQUENCEMATCH)) != 0;
+	tagResult result = TagFailure;
+	query *const queries = (query*) malloc (count * sizeof (query));
+	if (queries == NULL)
+		perror (NULL);
 	else
 	{
-		file->search.pos = file->pos;
-		if (entry != NULL)
-			parseTagLine (file, entry);
+		unsigned int wanted = 0;
+		unsigned int i;
+		for (i = 0  ;  i < count  ;  ++i)
+		{
+			const size_t length = strlen (names [i]);
+			if (! isFilteredOut (file, names [i], length, options))
+			{
+				queries [wanted].name = names [i];
+				queries [wanted].length = length;
+				queries [wanted].index = i;
+				++wanted;
+			}
+		}
+		if (wanted == 0)
+			result = TagFailure;
+		else if (isIndexed (file, ignorecase))
+		{
+#ifdef READTAGS_INDEX
+			result = findManyIndexed (file, queries, wanted, options,
+					callback, userData);
+#endif
+		}
+		else if (! containing  &&  isSearchable (file, ignorecase))
+		{
+			qsort (queries, wanted, sizeof (query),
+					ignorecase ? foldedQueryComparison : queryComparison);
+			result = findManySorted (file, queries, wanted, options,
+					callback, userData);
+		}
+		else
+			result = findManySequential (file, queries, wanted, options,
+					callback, userData);
+		free (queries);
 	}
 	return result;
 }
 
-static tagResult findNext (tagFile *const file, tagEntry *const entry)
+/*  Return the tag found next in any file of the chain, searching the file
+ *  of the tag found last again first.
+ */
+static tagResult chainNext (tagChain *const chain, tagEntry *const entry)
 {
-	tagResult result;
-	if ((file->sortMethod == TAG_SORTED      && !file->search.ignorecase) ||
-		(file->sortMethod == TAG_FOLDSORTED  &&  file->search.ignorecase))
+	tagResult result = TagFailure;
+	unsigned int best = chain->count;
+	unsigned int i;
+	if (chain->last < chain->count)
 	{
-		result = tagsNext (file, entry);
-		if (result == TagSuccess  && nameComparison (file) != 0)
-			result = TagFailure;
+		const unsigned int last = chain->last;
+		chain->found [last] = (tagsFindNext (chain->files [last],
+				&chain->entries [last]) == TagSuccess);
 	}
-	else
+	for (i = 0  ;  i < chain->count  ;  ++i)
 	{
-		result = findSequential (file);
-		if (result == TagSuccess  &&  entry != NULL)
-			parseTagLine (file, entry);
+		if (chain->found [i]  &&  (best == chain->count  ||
+				nameOrder (chain->entries [i].name, chain->entries [best].name,
+						chain->ignorecase) < 0))
+			best = i;
+	}
+	chain->last = best;
+	if (best < chain->count)
+	{
+		result = TagSuccess;
+		if (entry != NULL)
+			*entry = chain->entries [best];
 	}
 	return result;
 }
@@ -711,7 +2675,20 @@ static tagResult findNext (tagFile *const file, tagEntry *const entry)
 
 extern tagFile *tagsOpen (const char *const filePath, tagFileInfo *const info)
 {
-	return initialize (filePath, info);
+	return initialize (filePath, info, 0);
+}
+
+extern tagFile *tagsOpenMapped (const char *const filePath, tagFileInfo *const info)
+{
+	return initialize (filePath, info, 1);
+}
+
+extern tagFile *tagsOpenCursor (tagFile *const file)
+{
+	tagFile *result = NULL;
+	if (file != NULL  &&  file->initialized)
+		result = openCursor (file);
+	return result;
 }
 
 extern tagResult tagsSetSortType (tagFile *const file, const sortType type)
@@ -720,11 +2697,21 @@ extern tagResult tagsSetSortType (tagFile *const file, const sortType type)
 	if (file != NULL  &&  file->initialized)
 	{
 		file->sortMethod = type;
+		forgetSamples (file);
 		result = TagSuccess;
 	}
 	return result;
 }
 
+extern tagResult tagsSetFields (tagFile *const file,
+							   const char *const *const keys)
+{
+	tagResult result = TagFailure;
+	if (file != NULL  &&  file->initialized)
+		result = setWantedFields (file, keys);
+	return result;
+}
+
 extern tagResult tagsFirst (tagFile *const file, tagEntry *const entry)
 {
 	tagResult result = TagFailure;
@@ -761,6 +2748,16 @@ extern tagResult tagsFind (tagFile *const file, tagEntry *const entry,
 	return result;
 }
 
+extern tagResult tagsFindMany (tagFile *const file,
+		const char *const *const names, const unsigned int count,
+		const int options, tagCallback callback, void *const userData)
+{
+	tagResult result = TagFailure;
+	if (file != NULL  &&  file->initialized  &&  count > 0)
+		result = findMany (file, names, count, options, callback, userData);
+	return result;
+}
+
 extern tagResult tagsFindNext (tagFile *const file, tagEntry *const entry)
 {
 	tagResult result = TagFailure;
@@ -769,6 +2766,91 @@ extern tagResult tagsFindNext (tagFile *const file, tagEntry *const entry)
 	return result;
 }
 
+extern tagResult tagsFindRange (tagFile *const file, tagRange *const range,
+		const char *const prefix, const int options, const unsigned long limit)
+{
+	tagResult result = TagFailure;
+	if (file != NULL  &&  file->initialized  &&  range != NULL)
+		result = findRange (file, range, prefix, options, limit);
+	return result;
+}
+
+extern tagResult tagsNextName (tagFile *const file, tagRange *const range,
+		const char **const name)
+{
+	tagResult result = TagFailure;
+	if (file != NULL  &&  file->initialized  &&  range != NULL)
+		result = nextName (file, range, name);
+	return result;
+}
+
+extern tagChain *tagsOpenChain (tagFile *const *const files,
+		const unsigned int count)
+{
+	tagChain *result = (tagChain*) calloc ((size_t) 1, sizeof (tagChain));
+	if (result != NULL)
+	{
+		result->files = (tagFile**) malloc ((count + 1) * sizeof (tagFile*));
+		result->entries = (tagEntry*) malloc ((count + 1) * sizeof (tagEntry));
+		result->found = (short*) calloc ((size_t) count + 1, sizeof (short));
+		if (result->files == NULL  ||  result->entries == NULL  ||
+			result->found == NULL)
+		{
+			tagsCloseChain (result);
+			result = NULL;
+		}
+		else
+		{
+			memcpy (result->files, files, count * sizeof (tagFile*));
+			result->count = count;
+			result->last = count;
+		}
+	}
+	return result;
+}
+
+extern tagResult tagsChainFind (tagChain *const chain, tagEntry *const entry,
+		const char *const name, const int options)
+{
+	unsigned int i;
+	chain->ignorecase = (options & TAG_IGNORECASE) != 0;
+	for (i = 0  ;  i < chain->count  ;  ++i)
+	{
+		chain->found [i] = (chain->files [i] != NULL  &&
+				tagsFind (chain->files [i], &chain->entries [i], name,
+						options) == TagSuccess);
+	}
+	chain->last = chain->count;
+	return chainNext (chain, entry);
+}
+
+extern tagResult tagsChainFindNext (tagChain *const chain, tagEntry *const entry)
+{
+	return chainNext (chain, entry);
+}
+
+extern unsigned int tagsChainFile (const tagChain *const chain)
+{
+	return chain->last;
+}
+
+extern tagResult tagsCloseChain (tagChain *const chain)
+{
+	tagResult result = TagFailure;
+	if (chain != NULL)
+	{
+		if (chain->files != NULL)
+			free (chain->files);
+		if (chain->entries != NULL)
+			free (chain->entries);
+		if (chain->found != NULL)
+			free (chain->found);
+		free (chain);
+		result = TagSuccess;
+	}
+	return result;
+}
+
 extern tagResult tagsClose (tagFile *const file)
 {
 	tagResult result = TagFailure;
@@ -786,11 +2868,27 @@ extern tagResult tagsClose (tagFile *const file)
 
 #ifdef READTAGS_MAIN
 
+#include <time.h>  /* to declare clock_gettime () */
+
 static const char *TagFileName = "tags";
 static const char *ProgramName;
 static int extensionFields;
 static int SortOverride;
 static sortType SortMethod;
+static int Mapped;
+static int Ranges;
+static unsigned long RangeLimit;
+static const char *const NoFields [] = { NULL };
+
+static tagFile *openTagFile (tagFileInfo *const info)
+{
+	tagFile *result;
+	if (Mapped)
+		result = tagsOpenMapped (TagFileName, info);
+	else
+		result = tagsOpen (TagFileName, info);
+	return result;
+}
 
 static void printTag (const tagEntry *entry)
 {
@@ -824,7 +2922,7 @@ static void findTag (const char *const name, const int options)
 {
 	tagFileInfo info;
 	tagEntry entry;
-	tagFile *const file = tagsOpen (TagFileName, &info);
+	tagFile *const file = openTagFile (&info);
 	if (file == NULL)
 	{
 		fprintf (stderr, "%s: cannot open tag file: %s: %s\n",
@@ -835,6 +2933,8 @@ static void findTag (const char *const name, const int options)
 	{
 		if (SortOverride)
 			tagsSetSortType (file, SortMethod);
+		if (! extensionFields)
+			tagsSetFields (file, NoFields);
 		if (tagsFind (file, &entry, name, options) == TagSuccess)
 		{
 			do
@@ -846,11 +2946,42 @@ static void findTag (const char *const name, const int options)
 	}
 }
 
+static void findTagRange (const char *const prefix, const int options)
+{
+	tagFileInfo info;
+	tagRange range;
+	const char *name;
+	unsigned long named = 0;
+	tagFile *const file = openTagFile (&info);
+	if (file == NULL)
+	{
+		fprintf (stderr, "%s: cannot open tag file: %s: %s\n",
+				ProgramName, strerror (info.status.error_number), TagFileName);
+		exit (1);
+	}
+	if (SortOverride)
+		tagsSetSortType (file, SortMethod);
+	if (tagsFindRange (file, &range, prefix, options, RangeLimit) != TagSuccess)
+	{
+		fprintf (stderr, "%s: tag file is not sorted for a range: %s\n",
+				ProgramName, TagFileName);
+		exit (1);
+	}
+	printf ("%lu %lu %lu\n", range.count, range.start, range.end);
+	while ((RangeLimit == 0  ||  named < RangeLimit)  &&
+		   tagsNextName (file, &range, &name) == TagSuccess)
+	{
+		puts (name);
+		++named;
+	}
+	tagsClose (file);
+}
+
 static void listTags (void)
 {
 	tagFileInfo info;
 	tagEntry entry;
-	tagFile *const file = tagsOpen (TagFileName, &info);
+	tagFile *const file = openTagFile (&info);
 	if (file == NULL)
 	{
 		fprintf (stderr, "%s: cannot open tag file: %s: %s\n",
@@ -859,20 +2990,207 @@ static void listTags (void)
 	}
 	else
 	{
+		if (! extensionFields)
+			tagsSetFields (file, NoFields);
 		while (tagsNext (file, &entry) == TagSuccess)
 			printTag (&entry);
 		tagsClose (file);
 	}
 }
 
+/*  Returns the time in seconds since an arbitrary point, as finely as it can
+ *  be measured.
+ */
+static double benchTime (void)
+{
+#ifdef CLOCK_MONOTONIC
+	struct timespec now;
+	if (clock_gettime (CLOCK_MONOTONIC, &now) == 0)
+		return (double) now.tv_sec + (double) now.tv_nsec / 1e9;
+#endif
+	return (double) clock () / CLOCKS_PER_SEC;
+}
+
+/*  Returns the number of read() system calls made so far by this process, or
+ *  -1 where this is not known (it is read from /proc on Linux).
+ */
+static long readCalls (void)
+{
+	long result = -1;
+	FILE *const fp = fopen ("/proc/self/io", "r");
+	if (fp != NULL)
+	{
+		char line [64];
+		while (fgets (line, (int) sizeof (line), fp) != NULL)
+		{
+			if (strncmp (line, "syscr:", 6) == 0)
+				result = atol (line + 6);
+		}
+		fclose (fp);
+	}
+	return result;
+}
+
+static int latencyComparison (const void *const a, const void *const b)
+{
+	const double x = *(const double *) a;
+	const double y = *(const double *) b;
+	return (x > y) - (x < y);
+}
+
+/*  Returns the latency, in microseconds, below which lie "percent" percent
+ *  of the "count" latencies sorted in "latencies".
+ */
+static double percentile (const double *const latencies, const size_t count,
+		const unsigned int percent)
+{
+	size_t rank = (count * percent + 99) / 100;
+	if (rank > 0)
+		--rank;
+	return latencies [rank] * 1e6;
+}
+
+/*  Reads from "fp" the queries of a log, one to a line, each a name to be
+ *  found, optionally preceded by options of the command line which set the
+ *  kind of match (as in "-ip name"). Each query is timed while finding every
+ *  tag matched, and the distribution of the times is reported with the input
+ *  operations which the queries made.
+ */
+static void benchmark (FILE *const fp, const int defaultOptions)
+{
+	tagFileInfo info;
+	tagEntry entry;
+	char line [1024];
+	double *latencies = NULL;
+	size_t count = 0, max = 0;
+	unsigned long matches = 0;
+	double total = 0.0;
+	long reads;
+	const double opening = benchTime ();
+	tagFile *const file = openTagFile (&info);
+	if (file == NULL)
+	{
+		fprintf (stderr, "%s: cannot open tag file: %s: %s\n",
+				ProgramName, strerror (info.status.error_number), TagFileName);
+		exit (1);
+	}
+	if (SortOverride)
+		tagsSetSortType (file, SortMethod);
+	if (! extensionFields)
+		tagsSetFields (file, NoFields);
+	printf ("opened %s in %.1f us\n", TagFileName,
+			(benchTime () - opening) * 1e6);
+	file->io.seeks = 0;
+	file->io.lines = 0;
+	file->io.blocks = 0;
+	reads = readCalls ();
+	while (fgets (line, (int) sizeof (line), fp) != NULL)
+	{
+		int options = defaultOptions;
+		int range = Ranges;
+		char *name = line;
+		double start;
+		line [strcspn (line, "\r\n")] = '\0';
+		if (name [0] == '-')
+		{
+			for (++name  ;  *name != '\0'  &&  *name != ' '  ;  ++name)
+			{
+				switch (*name)
+				{
+					case 'c': options |= TAG_SUBSTRINGMATCH;   break;
+					case 'f': options |= TAG_SUBSEQUENCEMATCH; break;
+					case 'i': options |= TAG_IGNORECASE;       break;
+					case 'p': options |= TAG_PARTIALMATCH;     break;
+					case 'r': range = 1;                       break;
+					default:
+						fprintf (stderr, "%s: unknown query option: %c\n",
+								ProgramName, *name);
+						exit (1);
+						break;
+				}
+			}
+			if (*name == ' ')
+				++name;
+		}
+		if (*name == '\0')
+			continue;
+		if (count == max)
+		{
+			max = (max == 0) ? 1024 : max * 2;
+			latencies = (double *) realloc (latencies, max * sizeof (double));
+			if (latencies == NULL)
+			{
+				fprintf (stderr, "%s: out of memory\n", ProgramName);
+				exit (1);
+			}
+		}
+		start = benchTime ();
+		if (range)
+		{
+			tagRange found;
+			const char *tagName;
+			unsigned long named = 0;
+			if (tagsFindRange (file, &found, name, options, RangeLimit) == TagSuccess)
+			{
+				while ((RangeLimit == 0  ||  named < RangeLimit)  &&
+					   tagsNextName (file, &found, &tagName) == TagSuccess)
+					++named;
+				matches += named;
+			}
+		}
+		else if (tagsFind (file, &entry, name, options) == TagSuccess)
+		{
+			do
+				++matches;
+			while (tagsFindNext (file, &entry) == TagSuccess);
+		}
+		latencies [count] = benchTime () - start;
+		total += latencies [count++];
+	}
+	if (reads >= 0)
+		reads = readCalls () - reads;
+	if (count == 0)
+		printf ("no queries\n");
+	else
+	{
+		qsort (latencies, count, sizeof (double), latencyComparison);
+		printf ("%lu queries, %lu matches, %.6f s\n",
+				(unsigned long) count, matches, total);
+		printf ("latency (us): min %.2f  p50 %.2f  p90 %.2f  p99 %.2f  "
+				"max %.2f  mean %.2f\n",
+				latencies [0] * 1e6, percentile (latencies, count, 50),
+				percentile (latencies, count, 90),
+				percentile (latencies, count, 99),
+				latencies [count - 1] * 1e6, total / count * 1e6);
+		printf ("per query: %.2f seeks, %.2f lines read",
+				(double) file->io.seeks / count,
+				(double) file->io.lines / count);
+		if (file->zip.starts != NULL)
+			printf (", %.2f blocks decompressed",
+					(double) file->io.blocks / count);
+		if (reads >= 0)
+			printf (", %.2f read calls", (double) reads / count);
+		putchar ('\n');
+	}
+	free (latencies);
+	tagsClose (file);
+}
+
 const char *const Usage =
 	"Find tag file entries matching specified names.\n\n"
-	"Usage: %s [-ilp] [-s[0|1]] [-t file] [name(s)]\n\n"
+	"Usage: %s [-cefilmp] [-r[count]] [-s[0|1]] [-t file] [-b log] [name(s)]\n\n"
 	"Options:\n"
+	"    -b log       Time the queries read from log (\"-\" for standard input),\n"
+	"                 one to a line, as a name preceded by any of -cfipr.\n"
+	"    -c           Match names containing the name given.\n"
 	"    -e           Include extension fields in output.\n"
+	"    -f           Match names containing its characters in order.\n"
 	"    -i           Perform case-insensitive matching.\n"
 	"    -l           List all tags.\n"
+	"    -m           Map the tag file into memory.\n"
 	"    -p           Perform partial matching.\n"
+	"    -r[count]    Print the number, start and end of the tags beginning with\n"
+	"                 each name, then their names (at most count of each).\n"
 	"    -s[0|1|2]    Override sort detection of tag file.\n"
 	"    -t file      Use specified tag file (default: \"tags\").\n"
 	"Note that options are acted upon as encountered, so order is significant.\n";
@@ -893,7 +3211,10 @@ extern int main (int argc, char **argv)
 		const char *const arg = argv [i];
 		if (arg [0] != '-')
 		{
-			findTag (arg, options);
+			if (Ranges)
+				findTagRange (arg, options);
+			else
+				findTag (arg, options);
 			actionSupplied = 1;
 		}
 		else
@@ -903,11 +3224,43 @@ extern int main (int argc, char **argv)
 			{
 				switch (arg [j])
 				{
+					case 'c': options |= TAG_SUBSTRINGMATCH; break;
 					case 'e': extensionFields = 1;         break;
+					case 'f': options |= TAG_SUBSEQUENCEMATCH; break;
 					case 'i': options |= TAG_IGNORECASE;   break;
 					case 'p': options |= TAG_PARTIALMATCH; break;
 					case 'l': listTags (); actionSupplied = 1; break;
-			
+					case 'm': Mapped = 1;                  break;
+
+					case 'b':
+					{
+						const char *log;
+						FILE *fp;
+						if (arg [j+1] != '\0')
+						{
+							log = arg + j + 1;
+							j += strlen (log);
+						}
+						else if (i + 1 < argc)
+							log = argv [++i];
+						else
+						{
+							fprintf (stderr, Usage, ProgramName);
+							exit (1);
+						}
+						fp = (strcmp (log, "-") == 0) ? stdin : fopen (log, "r");
+						if (fp == NULL)
+						{
+							fprintf (stderr, "%s: cannot open query log: %s: %s\n",
+									ProgramName, log, strerror (errno));
+							exit (1);
+						}
+						benchmark (fp, options);
+						if (fp != stdin)
+							fclose (fp);
+						actionSupplied = 1;
+						break;
+					}
 					case 't':
 						if (arg [j+1] != '\0')
 						{
@@ -922,6 +3275,12 @@ extern int main (int argc, char **argv)
 							exit (1);
 						}
 						break;
+					case 'r':
+						Ranges = 1;
+						RangeLimit = strtoul (arg + j + 1, NULL, 10);
+						while (isdigit ((int) (unsigned char) arg [j+1]))
+							++j;
+						break;
 					case 's':
 						SortOverride = 1;
 						++j;
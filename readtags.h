@@ -35,8 +35,10 @@ typedef enum {
 } sortType ;
 
 /* Options for tagsFind() */
-#define TAG_FULLMATCH     0x0
-#define TAG_PARTIALMATCH  0x1
+#define TAG_FULLMATCH         0x0
+#define TAG_PARTIALMATCH      0x1
+#define TAG_SUBSTRINGMATCH    0x4
+#define TAG_SUBSEQUENCEMATCH  0x8
 
 #define TAG_OBSERVECASE   0x0
 #define TAG_IGNORECASE    0x2
@@ -51,6 +53,10 @@ struct sTagFile;
 
 typedef struct sTagFile tagFile;
 
+struct sTagChain;
+
+typedef struct sTagChain tagChain;
+
 /* This structure contains information about the tag file. */
 typedef struct {
 
@@ -139,6 +145,28 @@ typedef struct {
 
 } tagEntry;
 
+/* This structure describes the tags whose names begin with a prefix, which
+ * lie together in a sorted tag file (see tagsFindRange()).
+ */
+typedef struct {
+
+		/* file position of the first tag of the range */
+	unsigned long start;
+
+		/* file position following the last tag of the range */
+	unsigned long end;
+
+		/* number of tags in the range, if no more than the limit given */
+	unsigned long count;
+
+		/* file position of the tag to be named next by tagsNextName() */
+	unsigned long next;
+
+} tagRange;
+
+/* Function called by tagsFindMany() for each tag found */
+typedef tagResult (*tagCallback) (unsigned int index, const tagEntry *entry, void *userData);
+
 
 /*
 *  FUNCTION PROTOTYPES
@@ -157,6 +185,36 @@ typedef struct {
 */
 extern tagFile *tagsOpen (const char *const filePath, tagFileInfo *const info);
 
+/*
+*  This function is equivalent to tagsOpen(), except that, where supported,
+*  the whole tag file is mapped into memory, and lines are read in place
+*  rather than copied, which makes lookups much faster. The strings of each
+*  tagEntry then point into the mapping, and remain valid only until the next
+*  call for the same tag file, as for tagsOpen(). A file opened this way must
+*  not be truncated or rewritten in place while it is open; a tag file which
+*  is replaced by renaming another over it is read as it was when opened.
+*  Where mapping is not supported, or fails, the file is read as by
+*  tagsOpen().
+*/
+extern tagFile *tagsOpenMapped (const char *const filePath, tagFileInfo *const info);
+
+/*
+*  This function returns a new handle, or cursor, for the tag file open as
+*  `file', which may be used with the other calls exactly as `file' itself,
+*  including tagsFindNext(), independently of it, and must be closed by
+*  tagsClose(). The sort type and fields selected for `file' are inherited.
+*  Where `file' was mapped by tagsOpenMapped(), the cursor shares the mapping,
+*  so that making one costs no more than a few small allocations, and does
+*  not reopen the file. Each thread may then use its own cursor concurrently
+*  with the others without locking, provided that `file' itself is not being
+*  used by another thread while a cursor is made from it, and is closed only
+*  after all cursors made from it. Entries read from `file' before the first
+*  cursor was made from it are no longer valid. Where `file' is not mapped,
+*  the cursor reopens the tag file by its path. If unsuccessful, the function
+*  will return null.
+*/
+extern tagFile *tagsOpenCursor (tagFile *const file);
+
 /*
 *  This function allows the client to override the normal automatic detection
 *  of how a tag file is sorted. Permissible values for `type' are
@@ -172,6 +230,20 @@ extern tagFile *tagsOpen (const char *const filePath, tagFileInfo *const info);
 */
 extern tagResult tagsSetSortType (tagFile *const file, const sortType type);
 
+/*
+*  This function selects which extension fields are parsed from the tags
+*  subsequently read from a tag file. `keys' is a null terminated list of the
+*  keys of the fields wanted, where "kind", "file", and "line" select the
+*  fields used to fill in `kind', `fileScope', and `address.lineNumber'; any
+*  other field is neither split apart nor returned by tagsField(), and members
+*  of an entry whose field is not selected are left empty. An empty list
+*  skips the extension fields altogether, which makes reading tags much
+*  cheaper for clients needing only names, files, and addresses, while a null
+*  `keys' restores the default of parsing every field. The function will
+*  return TagSuccess if called on an open tag file or TagFailure if not.
+*/
+extern tagResult tagsSetFields (tagFile *const file, const char *const *const keys);
+
 /*
 *  Reads the first tag in the file, if any. It is passed the handle to an
 *  opened tag file and a (possibly null) pointer to a structure which, if not
@@ -214,19 +286,70 @@ extern const char *tagsField (const tagEntry *const entry, const char *const key
 *    TAG_FULLMATCH
 *        Only tags whose full lengths match `name' will qualify.
 *
+*    TAG_SUBSTRINGMATCH
+*        Tags whose names contain `name' anywhere will qualify. This
+*        disables binary searches of the tag file.
+*
+*    TAG_SUBSEQUENCEMATCH
+*        Tags whose names contain the characters of `name' in the same order,
+*        though not necessarily adjacent, will qualify. This disables binary
+*        searches of the tag file.
+*
 *    TAG_IGNORECASE
 *        Matching will be performed in a case-insenstive manner. Note that
-*        this disables binary searches of the tag file.
+*        this disables binary searches of the tag file unless it is sorted
+*        ignoring case, or has an index (see below), in which case the tags
+*        found come in order of name ignoring case rather than in the order
+*        of the tag file.
 *
 *    TAG_OBSERVECASE
 *        Matching will be performed in a case-senstive manner. Note that
 *        this enables binary searches of the tag file.
 *
+*  Binary searches of a tag file left open are narrowed using lines read by
+*  earlier searches, which are forgotten should the size or modification
+*  time of the file change.
+*
+*  Where the tag file was written by "ctags --tag-index", and has not changed
+*  since, matches are found through the index written beside it without
+*  searching the tag file, whether or not the file is sorted, and whether or
+*  not case is ignored; the tags matching a partial name are then found in
+*  order of name, ignoring case if so matched. Names containing `name' are
+*  then found in order of name among those sharing its rarest trigram (run
+*  of 3 characters), or among all names of the index where it is shorter or
+*  a subsequence, each confirmed on the line read from the tag file. The
+*  pseudo-tags at the head of the tag file are left out of the index, so a
+*  name which could match one is first searched for among them, and these
+*  come before the tags found through the index.
+*
+*  Where the tag file was written by "ctags --tag-bloom", and has not changed
+*  since, a whole name which the Bloom filter written beside it shows not to
+*  be in the file is not searched for, saving the search of most tag files
+*  which do not hold the name, whether or not case is ignored.
+*
 *  The function will return TagSuccess if a tag matching the name is found, or
 *  TagFailure if not.
 */
 extern tagResult tagsFind (tagFile *const file, tagEntry *const entry, const char *const name, const int options);
 
+/*
+*  Find the tags matching each of the `count' names in `names', matched
+*  according to `options' as for tagsFind(). For each tag found, `callback'
+*  is called with the position of the name within `names', the tag found,
+*  and `userData'; the entry is only valid until the callback returns, which
+*  may return TagFailure to stop the search early. When the tag file may be
+*  searched with a binary search, the names are answered in sorted order by
+*  a single forward sweep through the file, each search starting from where
+*  the one before it left off, which is much cheaper than calling tagsFind()
+*  for each name when there are many of them. Otherwise the file is read
+*  once, the tags found being reported in the order they appear. The search
+*  made by tagsFindNext() is not defined after a call to this function.
+*
+*  The function will return TagSuccess if a tag matching any name is found,
+*  or TagFailure if none is.
+*/
+extern tagResult tagsFindMany (tagFile *const file, const char *const *const names, const unsigned int count, const int options, tagCallback callback, void *const userData);
+
 /*
 *  Find the next tag matching the name and options supplied to the most recent
 *  call to tagsFind() for the same tag file. The structure pointed to by
@@ -236,6 +359,34 @@ extern tagResult tagsFind (tagFile *const file, tagEntry *const entry, const cha
 */
 extern tagResult tagsFindNext (tagFile *const file, tagEntry *const entry);
 
+/*
+*  Find the range of the tags whose names begin with `prefix' in a tag file
+*  sorted as `options' require, which may include TAG_IGNORECASE for a file
+*  sorted ignoring case; other options are ignored. The start and end of the
+*  range are found by two binary searches of the tag file, without any tag
+*  being parsed, and stored into the structure pointed to by `range', the end
+*  being the start where no name begins with `prefix'. The tags of the range
+*  are then counted, unless `limit' is not zero, in which case counting stops
+*  once `limit' are, which costs only the reading of so many lines. Where the
+*  tag file has an index (see tagsFind()), they are counted by two binary
+*  searches of its names, without reading the tag file at all. This is
+*  much cheaper than finding and parsing each tag matching a partial name by
+*  tagsFind() and tagsFindNext(), as when completing a name as it is typed.
+*  The search made by tagsFindNext() is not defined after a call to this
+*  function. The function will return TagSuccess if the tag file may be
+*  searched so, whether or not the range is empty, or TagFailure if not.
+*/
+extern tagResult tagsFindRange (tagFile *const file, tagRange *const range, const char *const prefix, const int options, const unsigned long limit);
+
+/*
+*  Read the name of the next tag of a range found by tagsFindRange(), storing
+*  into `name' a pointer to it, which is valid until the next call for the
+*  same tag file. No other field of the tag is parsed. The function will
+*  return TagSuccess if another tag of the range is named, or TagFailure if
+*  not.
+*/
+extern tagResult tagsNextName (tagFile *const file, tagRange *const range, const char **const name);
+
 /*
 *  Call tagsTerminate() at completion of reading the tag file, which will
 *  close the file and free any internal memory allocated. The function will
@@ -243,6 +394,48 @@ extern tagResult tagsFindNext (tagFile *const file, tagEntry *const entry);
 */
 extern tagResult tagsClose (tagFile *const file);
 
+/*
+*  Make a chain through which the `count' tag files `files', opened by
+*  tagsOpen() or tagsOpenMapped(), are searched together, as when looking
+*  through the tags of a project and then of each of its dependencies. Null
+*  entries of `files', as for files which could not be opened, are passed
+*  over. The files stay open and owned by the caller, who must not search
+*  them otherwise, nor name one twice, until the chain is closed. Returns
+*  NULL if memory could not be allocated.
+*/
+extern tagChain *tagsOpenChain (tagFile *const *const files, const unsigned int count);
+
+/*
+*  Find the first tag matching `name', as by tagsFind(), among the files of
+*  `chain'. The tags found in each file by this function and then by
+*  tagsChainFindNext() are merged by name, ignoring case if so matched, the
+*  tags of names alike being found in the order of the files in the chain.
+*  A file whose Bloom filter shows it not to hold the name is not searched.
+*  The structure pointed to by `entry' is valid until the next search of the
+*  chain. The function will return TagSuccess if a tag is found, or
+*  TagFailure if not.
+*/
+extern tagResult tagsChainFind (tagChain *const chain, tagEntry *const entry, const char *const name, const int options);
+
+/*
+*  Find the next tag matching the name and options supplied to the most
+*  recent call to tagsChainFind() for the same chain. The function will
+*  return TagSuccess if another tag is found, or TagFailure if not.
+*/
+extern tagResult tagsChainFindNext (tagChain *const chain, tagEntry *const entry);
+
+/*
+*  Return the position within the files of `chain' of the file holding the
+*  tag found last, or the number of files if none was found.
+*/
+extern unsigned int tagsChainFile (const tagChain *const chain);
+
+/*
+*  Free the chain, leaving its files open. The function will return
+*  TagFailure if `chain' is NULL, TagSuccess otherwise.
+*/
+extern tagResult tagsCloseChain (tagChain *const chain);
+
 #ifdef __cplusplus
 };
 #endif
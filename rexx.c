@@ -14,25 +14,67 @@
 *   INCLUDE FILES
 */
 #include "general.h"  /* always include first */
+
+#include <string.h>
+
 #include "parse.h"    /* always include */
+#include "read.h"
+#include "vstring.h"
+
+/*
+*   DATA DEFINITIONS
+*/
+typedef enum {
+	K_SUBROUTINE
+} rexxKind;
+
+static kindOption RexxKinds [] = {
+	{ TRUE, 's', "subroutine", "subroutines" }
+};
 
 /*
 *   FUNCTION DEFINITIONS
 */
 
-static void installRexxRegex (const langType language)
+static boolean isLabelChar (const int c)
 {
-	addTagRegex (language, "^([A-Za-z0-9@#$\\.!?_]+)[ \t]*:",
-		"\\1", "s,subroutine,subroutines", NULL);
+	return (boolean) ((c >= 'A'  &&  c <= 'Z')  ||  (c >= 'a'  &&  c <= 'z')  ||
+			(c >= '0'  &&  c <= '9')  ||  strchr ("@#$\\.!?_", c) != NULL);
+}
+
+/*  Makes a tag for a line beginning with
+ *  label:
+ */
+static void findRexxTags (void)
+{
+	vString *const name = vStringNew ();
+	const unsigned char *line;
+
+	while ((line = fileReadLine ()) != NULL)
+	{
+		const unsigned char *cp = line;
+		while (*cp != '\0'  &&  isLabelChar ((int) *cp))
+			++cp;
+		if (cp > line)
+		{
+			vStringNCopyS (name, (const char*) line, cp - line);
+			while (*cp == ' '  ||  *cp == '\t')
+				++cp;
+			if (*cp == ':')
+				makeSimpleTag (name, RexxKinds, K_SUBROUTINE);
+		}
+	}
+	vStringDelete (name);
 }
 
 extern parserDefinition* RexxParser (void)
 {
 	static const char *const extensions [] = { "cmd", "rexx", "rx", NULL };
 	parserDefinition* const def = parserNew ("REXX");
+	def->kinds      = RexxKinds;
+	def->kindCount  = KIND_COUNT (RexxKinds);
 	def->extensions = extensions;
-	def->initialize = installRexxRegex;
-	def->regex      = TRUE;
+	def->parser     = findRexxTags;
 	return def;
 }
 
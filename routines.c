@@ -59,6 +59,15 @@
 #ifdef HAVE_IO_H
 # include <io.h>  /* to declare open() */
 #endif
+#ifdef HAVE_GETTIMEOFDAY
+# include <sys/time.h>  /* to declare gettimeofday() */
+#endif
+#ifdef HAVE_CLOCK
+# include <time.h>  /* to declare clock() */
+#endif
+#ifdef HAVE_GETRUSAGE
+# include <sys/resource.h>  /* to declare getrusage() */
+#endif
 #include "debug.h"
 #include "routines.h"
 
@@ -229,26 +238,308 @@ extern void error (
 		exit (1);
 }
 
+/*  Returns the elapsed (wall clock) time in seconds since an arbitrary
+ *  point in the past, or zero where the time is not available.
+ */
+extern double elapsedTime (void)
+{
+	double result = 0.0;
+#ifdef HAVE_GETTIMEOFDAY
+	struct timeval now;
+	if (gettimeofday (&now, NULL) == 0)
+		result = (double) now.tv_sec + (double) now.tv_usec / 1000000.0;
+#endif
+	return result;
+}
+
+/*  Returns the processor time in seconds used so far, or zero where it is
+ *  not available.
+ */
+extern double processorTime (void)
+{
+	double result = 0.0;
+#ifdef HAVE_CLOCK
+	result = (double) clock () / CLOCKS_PER_SEC;
+#endif
+	return result;
+}
+
+/*  Returns the most memory, in kB, resident at once in this process and in
+ *  any child processes waited for, or zero where it is not known.
+ */
+extern unsigned long peakResidentSize (void)
+{
+	unsigned long result = 0;
+#ifdef HAVE_GETRUSAGE
+	struct rusage usage;
+	if (getrusage (RUSAGE_SELF, &usage) == 0)
+		result = (unsigned long) usage.ru_maxrss;
+	if (getrusage (RUSAGE_CHILDREN, &usage) == 0  &&
+		(unsigned long) usage.ru_maxrss > result)
+		result = (unsigned long) usage.ru_maxrss;
+#endif
+	return result;
+}
+
+/*  Writes "string" to "fp" as a quoted JSON string.
+ */
+extern void printJsonString (FILE *const fp, const char *const string)
+{
+	const unsigned char *p;
+	putc ('"', fp);
+	for (p = (const unsigned char *) string  ;  *p != '\0'  ;  ++p)
+	{
+		if (*p == '"'  ||  *p == '\\')
+			fprintf (fp, "\\%c", *p);
+		else if (*p < 0x20)
+			fprintf (fp, "\\u%04x", (unsigned int) *p);
+		else
+			putc (*p, fp);
+	}
+	putc ('"', fp);
+}
+
 /*
  *  Memory allocation functions
  */
 
+static unsigned long Allocations = 0;  /* blocks allocated, for --totals */
+
+#ifdef MEMORY_ACCOUNTING
+
+/*  Each block allocated is preceded by a header recording its size and the
+ *  account charged, aligned as strictly as anything the block may hold.
+ */
+typedef union uMemoryHeader {
+	struct {
+		size_t size;
+		memoryAccount account;
+	} block;
+	long double alignDouble;
+	void *alignPointer;
+	long alignLong;
+} memoryHeader;
+
+typedef struct sMemoryUsage {
+	unsigned long calls;  /* to allocate or reallocate */
+	unsigned long bytes;  /* allocated or reallocated */
+	unsigned long live;   /* bytes in use */
+	unsigned long peak;   /* greatest bytes in use at once */
+} memoryUsage;
+
+enum { MemoryAccountDepth = 16 };
+
+static const char *const MemoryAccountNames [MEMORY_ACCOUNT_COUNT] = {
+	"other", "reader", "parser", "regex", "entry", "sort"
+};
+static memoryUsage MemoryUsage [MEMORY_ACCOUNT_COUNT];
+static memoryUsage MemoryTotal;
+static memoryAccount MemoryAccounts [MemoryAccountDepth];
+static unsigned int MemoryAccountLevel = 0;
+
+static memoryAccount currentMemoryAccount (void)
+{
+	memoryAccount account = MEMORY_OTHER;
+	if (MemoryAccountLevel > MemoryAccountDepth)
+		account = MemoryAccounts [MemoryAccountDepth - 1];
+	else if (MemoryAccountLevel > 0)
+		account = MemoryAccounts [MemoryAccountLevel - 1];
+	return account;
+}
+
+extern void pushMemoryAccount (const memoryAccount account)
+{
+	if (MemoryAccountLevel < MemoryAccountDepth)
+		MemoryAccounts [MemoryAccountLevel] = account;
+	++MemoryAccountLevel;
+}
+
+extern void popMemoryAccount (void)
+{
+	Assert (MemoryAccountLevel > 0);
+	--MemoryAccountLevel;
+}
+
+static void noteUsage (memoryUsage *const usage, const size_t size)
+{
+	++usage->calls;
+	usage->bytes += size;
+	usage->live += size;
+	if (usage->live > usage->peak)
+		usage->peak = usage->live;
+}
+
+/*  Charges a block of "size" bytes to the current account, recording both
+ *  in its header.
+ */
+static void *chargeBlock (memoryHeader *const header, const size_t size)
+{
+	const memoryAccount account = currentMemoryAccount ();
+	header->block.size = size;
+	header->block.account = account;
+	noteUsage (&MemoryUsage [account], size);
+	noteUsage (&MemoryTotal, size);
+	return header + 1;
+}
+
+/*  Returns the header of a block, crediting its account with its size.
+ */
+static memoryHeader *creditBlock (void *const ptr)
+{
+	memoryHeader *const header = (memoryHeader *) ptr - 1;
+	MemoryUsage [header->block.account].live -= header->block.size;
+	MemoryTotal.live -= header->block.size;
+	return header;
+}
+
+static size_t blockSize (const size_t size)
+{
+	if (size > (size_t) -1 - sizeof (memoryHeader))
+		error (FATAL, "out of memory");
+	return sizeof (memoryHeader) + size;
+}
+
+/*  Forgets what has been counted so far, but for the memory in use, so that
+ *  what a worker process reports is only what it adds.
+ */
+extern void clearMemoryTotals (void)
+{
+	unsigned int i;
+	for (i = 0  ;  i < MEMORY_ACCOUNT_COUNT  ;  ++i)
+	{
+		MemoryUsage [i].calls = 0;
+		MemoryUsage [i].bytes = 0;
+		MemoryUsage [i].peak = MemoryUsage [i].live;
+	}
+	MemoryTotal.calls = 0;
+	MemoryTotal.bytes = 0;
+	MemoryTotal.peak = MemoryTotal.live;
+}
+
+/*  Writes the memory counted to "fp", for readMemoryTotals () in another
+ *  process.
+ */
+extern void writeMemoryTotals (FILE *const fp)
+{
+	if (fwrite (MemoryUsage, sizeof (MemoryUsage), 1, fp) != 1  ||
+		fwrite (&MemoryTotal, sizeof (MemoryTotal), 1, fp) != 1)
+		error (FATAL | PERROR, "cannot write memory totals");
+}
+
+static void addMemoryUsage (memoryUsage *const to, const memoryUsage *const from)
+{
+	to->calls += from->calls;
+	to->bytes += from->bytes;
+	if (from->peak > to->peak)
+		to->peak = from->peak;
+}
+
+/*  Adds the memory counted by another process, written by
+ *  writeMemoryTotals () to "fp", to our own, returning whether it was read.
+ *  The peak reported is that of the process which used most memory.
+ */
+extern boolean readMemoryTotals (FILE *const fp)
+{
+	memoryUsage usage [MEMORY_ACCOUNT_COUNT];
+	memoryUsage total;
+	boolean ok = (boolean) (fread (usage, sizeof (usage), 1, fp) == 1  &&
+			fread (&total, sizeof (total), 1, fp) == 1);
+	if (ok)
+	{
+		unsigned int i;
+		for (i = 0  ;  i < MEMORY_ACCOUNT_COUNT  ;  ++i)
+			addMemoryUsage (&MemoryUsage [i], &usage [i]);
+		addMemoryUsage (&MemoryTotal, &total);
+	}
+	return ok;
+}
+
+#endif
+
+/*  Returns the number of blocks of memory allocated (or reallocated) so far.
+ */
+extern unsigned long allocationCount (void)
+{
+	return Allocations;
+}
+
+/*  Prints the memory allocated by each part of ctags, for --totals, where it
+ *  is counted.
+ */
+extern void printMemoryTotals (FILE *const fp __unused__)
+{
+#ifdef MEMORY_ACCOUNTING
+	unsigned int i;
+	fprintf (fp, "memory: %lu kB peak in use\n",
+			(MemoryTotal.peak + 1023) / 1024);
+	for (i = 0  ;  i < MEMORY_ACCOUNT_COUNT  ;  ++i)
+	{
+		const memoryUsage *const usage = &MemoryUsage [i];
+		if (usage->calls > 0)
+			fprintf (fp, "  %-8s %10lu allocation%s %10lu kB, %lu kB peak\n",
+					MemoryAccountNames [i], usage->calls,
+					usage->calls == 1 ? " " : "s",
+					(usage->bytes + 1023) / 1024, (usage->peak + 1023) / 1024);
+	}
+#endif
+}
+
+/*  Prints the memory allocated by each part of ctags as a member of the
+ *  object written by --totals=json, where it is counted.
+ */
+extern void printMemoryTotalsJson (FILE *const fp __unused__)
+{
+#ifdef MEMORY_ACCOUNTING
+	const char *separator = "";
+	unsigned int i;
+	fprintf (fp, "  \"memory\": {\"peak\": %lu, \"accounts\": [",
+			MemoryTotal.peak);
+	for (i = 0  ;  i < MEMORY_ACCOUNT_COUNT  ;  ++i)
+	{
+		const memoryUsage *const usage = &MemoryUsage [i];
+		fprintf (fp, "%s\n    {\"account\": ", separator);
+		printJsonString (fp, MemoryAccountNames [i]);
+		fprintf (fp, ", \"calls\": %lu, \"bytes\": %lu, \"peak\": %lu}",
+				usage->calls, usage->bytes, usage->peak);
+		separator = ",";
+	}
+	fputs ("\n  ]},\n", fp);
+#endif
+}
+
 extern void *eMalloc (const size_t size)
 {
+#ifdef MEMORY_ACCOUNTING
+	void *buffer = malloc (blockSize (size));
+#else
 	void *buffer = malloc (size);
+#endif
 
+	++Allocations;
 	if (buffer == NULL)
 		error (FATAL, "out of memory");
 
+#ifdef MEMORY_ACCOUNTING
+	buffer = chargeBlock ((memoryHeader *) buffer, size);
+#endif
 	return buffer;
 }
 
 extern void *eCalloc (const size_t count, const size_t size)
 {
+#ifdef MEMORY_ACCOUNTING
+	void *buffer;
+	if (size != 0  &&  count > (size_t) -1 / size)
+		error (FATAL, "out of memory");
+	buffer = eMalloc (count * size);
+	memset (buffer, 0, count * size);
+#else
 	void *buffer = calloc (count, size);
 
+	++Allocations;
 	if (buffer == NULL)
 		error (FATAL, "out of memory");
+#endif
 
 	return buffer;
 }
@@ -260,9 +551,18 @@ extern void *eRealloc (void *const ptr, const size_t size)
 		buffer = eMalloc (size);
 	else
 	{
+#ifdef MEMORY_ACCOUNTING
+		/*  The block is charged anew to the current account. */
+		buffer = realloc (creditBlock (ptr), blockSize (size));
+#else
 		buffer = realloc (ptr, size);
+#endif
+		++Allocations;
 		if (buffer == NULL)
 			error (FATAL, "out of memory");
+#ifdef MEMORY_ACCOUNTING
+		buffer = chargeBlock ((memoryHeader *) buffer, size);
+#endif
 	}
 	return buffer;
 }
@@ -270,7 +570,11 @@ extern void *eRealloc (void *const ptr, const size_t size)
 extern void eFree (void *const ptr)
 {
 	Assert (ptr != NULL);
+#ifdef MEMORY_ACCOUNTING
+	free (creditBlock (ptr));
+#else
 	free (ptr);
+#endif
 }
 
 /*
@@ -325,6 +629,21 @@ extern char* eStrdup (const char* str)
 	return result;
 }
 
+/*  Extends a 32-bit FNV-1a hash with the bytes "p" of "length". Start with
+ *  INITIAL_HASH.
+ */
+extern unsigned long hashBytes (
+		unsigned long hash, const unsigned char *p, const size_t length)
+{
+	const unsigned char *const end = p + length;
+	while (p < end)
+	{
+		hash ^= *p++;
+		hash = (hash * 16777619UL) & 0xffffffffUL;
+	}
+	return hash;
+}
+
 extern void toLowerString (char* str)
 {
 	while (*str != '\0')
@@ -443,6 +762,7 @@ extern fileStatus *eStat (const char *const fileName)
 					(S_IXUSR | S_IXGRP | S_IXOTH)) != 0);
 				file.isSetuid = (boolean) ((status.st_mode & S_ISUID) != 0);
 				file.size = status.st_size;
+				file.modified = (unsigned long) status.st_mtime;
 			}
 		}
 	}
@@ -557,8 +877,8 @@ extern boolean isSameFile (const char *const name1, const char *const name2)
 #else
 		result = (boolean) (strcmp (n1, n2) == 0);
 #endif
-		free (n1);
-		free (n2);
+		eFree (n1);
+		eFree (n2);
 	}
 #endif
 	return result;
@@ -843,7 +1163,7 @@ extern char* relativeFilename (const char *file, const char *dir)
 
 	/* Add the file name relative to the common root of file and dir. */
 	strcat (res, fp + 1);
-	free (absdir);
+	eFree (absdir);
 
 	return res;
 }
@@ -866,9 +1186,14 @@ extern FILE *tempFile (const char *const mode, char **const pName)
 	fd = mkstemp (name);
 	eStatFree (file);
 #elif defined(HAVE_TEMPNAM)
-	name = tempnam (TMPDIR, "tags");
-	if (name == NULL)
-		error (FATAL | PERROR, "cannot allocate temporary file name");
+	{
+		/*  Copied, since the name is freed by eFree (). */
+		char *const tempName = tempnam (TMPDIR, "tags");
+		if (tempName == NULL)
+			error (FATAL | PERROR, "cannot allocate temporary file name");
+		name = eStrdup (tempName);
+		free (tempName);
+	}
 	fd = open (name, O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
 #else
 	name = xMalloc (L_tmpnam, char);
@@ -23,6 +23,8 @@
 #define xCalloc(n,Type)    (Type *)eCalloc((size_t)(n), sizeof (Type))
 #define xRealloc(p,n,Type) (Type *)eRealloc((p), (n) * sizeof (Type))
 
+#define INITIAL_HASH  2166136261UL  /* FNV offset basis, for hashBytes() */
+
 /*
  *  Portability macros
  */
@@ -42,6 +44,17 @@
 # define OUTPUT_PATH_SEPARATOR	PATH_SEPARATOR
 #endif
 
+/*  Charges the memory allocated until the matching PopMemoryAccount () to
+ *  an account, where memory is counted.
+ */
+#ifdef MEMORY_ACCOUNTING
+# define PushMemoryAccount(a)  pushMemoryAccount (a)
+# define PopMemoryAccount()    popMemoryAccount ()
+#else
+# define PushMemoryAccount(a)
+# define PopMemoryAccount()
+#endif
+
 /*
 *   DATA DECLARATIONS
 */
@@ -52,6 +65,14 @@ extern char *CurrentDirectory;
 typedef int errorSelection;
 enum eErrorTypes { FATAL = 1, WARNING = 2, PERROR = 4 };
 
+/*  The parts of ctags to which memory allocated is charged, where it is
+ *  counted (see MEMORY_ACCOUNTING).
+ */
+typedef enum eMemoryAccount {
+	MEMORY_OTHER, MEMORY_READER, MEMORY_PARSER, MEMORY_REGEX, MEMORY_ENTRY,
+	MEMORY_SORT, MEMORY_ACCOUNT_COUNT
+} memoryAccount;
+
 typedef struct {
 		/* Name of file for which status is valid */
 	char* name;
@@ -76,6 +97,9 @@ typedef struct {
 
 		/* Size of file (pointed to) */
 	unsigned long size;
+
+		/* Time of last modification of file (pointed to) */
+	unsigned long modified;
 } fileStatus; 
 
 /*
@@ -86,16 +110,30 @@ extern void setExecutableName (const char *const path);
 extern const char *getExecutableName (void);
 extern const char *getExecutablePath (void);
 extern void error (const errorSelection selection, const char *const format, ...) __printf__ (2, 3);
+extern double elapsedTime (void);
+extern double processorTime (void);
+extern unsigned long peakResidentSize (void);
+extern void printJsonString (FILE *const fp, const char *const string);
 
 /* Memory allocation functions */
 #ifdef NEED_PROTO_MALLOC
 extern void *malloc (size_t);
 extern void *realloc (void *ptr, size_t);
 #endif
+extern unsigned long allocationCount (void);
 extern void *eMalloc (const size_t size);
 extern void *eCalloc (const size_t count, const size_t size);
 extern void *eRealloc (void *const ptr, const size_t size);
 extern void eFree (void *const ptr);
+#ifdef MEMORY_ACCOUNTING
+extern void pushMemoryAccount (const memoryAccount account);
+extern void popMemoryAccount (void);
+extern void clearMemoryTotals (void);
+extern void writeMemoryTotals (FILE *const fp);
+extern boolean readMemoryTotals (FILE *const fp);
+#endif
+extern void printMemoryTotals (FILE *const fp);
+extern void printMemoryTotalsJson (FILE *const fp);
 
 /* String manipulation functions */
 extern int struppercmp (const char *s1, const char *s2);
@@ -104,6 +142,7 @@ extern int strnuppercmp (const char *s1, const char *s2, size_t n);
 extern char* strstr (const char *str, const char *substr);
 #endif
 extern char* eStrdup (const char* str);
+extern unsigned long hashBytes (unsigned long hash, const unsigned char *p, const size_t length);
 extern void toLowerString (char* str);
 extern void toUpperString (char* str);
 extern char* newLowerString (const char* str);
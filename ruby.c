@@ -31,6 +31,18 @@ typedef enum {
     K_UNDEFINED = -1, K_CLASS, K_METHOD, K_MODULE, K_SINGLETON
 } rubyKind;
 
+typedef enum {
+    KEYWORD_NONE = -1,
+    KEYWORD_begin, KEYWORD_case, KEYWORD_class, KEYWORD_def, KEYWORD_do,
+    KEYWORD_end, KEYWORD_for, KEYWORD_if, KEYWORD_module, KEYWORD_unless,
+    KEYWORD_while
+} rubyKeyword;
+
+typedef struct {
+    const char* name;
+    rubyKeyword id;
+} keywordDesc;
+
 /*
 *   DATA DEFINITIONS
 */
@@ -41,6 +53,21 @@ static kindOption RubyKinds [] = {
     { TRUE, 'F', "singleton method", "singleton methods" }
 };
 
+/* The keywords which open or close scopes, by their first letter. */
+static const keywordDesc RubyKeywordTable [] = {
+    { "begin",  KEYWORD_begin  },
+    { "case",   KEYWORD_case   },
+    { "class",  KEYWORD_class  },
+    { "def",    KEYWORD_def    },
+    { "do",     KEYWORD_do     },
+    { "end",    KEYWORD_end    },
+    { "for",    KEYWORD_for    },
+    { "if",     KEYWORD_if     },
+    { "module", KEYWORD_module },
+    { "unless", KEYWORD_unless },
+    { "while",  KEYWORD_while  }
+};
+
 static stringList* nesting = 0;
 
 /*
@@ -73,58 +100,104 @@ static vString* stringListToScope (const stringList* list)
     return result;
 }
 
+/* Tests whether 'c' ends a keyword or an operator method name. */
+static boolean isTokenEnd (const unsigned char c)
+{
+    return (boolean) (c == 0 || isspace (c) || c == '(');
+}
+
 /*
-* Attempts to advance 's' past 'literal'.
-* Returns TRUE if it did, FALSE (and leaves 's' where
-* it was) otherwise.
+* Recognizes the keyword, if any, at 'cp', which must end the token there.
+* Returns the keyword and sets 'length' to its length, or returns
+* KEYWORD_NONE.
 */
-static boolean canMatch (const unsigned char** s, const char* literal)
+static rubyKeyword lookupRubyKeyword (const unsigned char* cp, size_t* length)
 {
-    const int literal_length = strlen (literal);
-    const unsigned char next_char = *(*s + literal_length);
-    if (strncmp ((const char*) *s, literal, literal_length) != 0)
+    size_t n = 0;
+    size_t i;
+
+    while (cp[n] >= 'a' && cp[n] <= 'z')
+        ++n;
+    if (n < 2 || ! isTokenEnd (cp[n]))
     {
-        return FALSE;
+        return KEYWORD_NONE;
     }
-    /* Additionally check that we're at the end of a token. */
-    if ( ! (next_char == 0 || isspace (next_char) || next_char == '('))
+    for (i = 0; i < sizeof (RubyKeywordTable) / sizeof (RubyKeywordTable [0]);
+         ++i)
     {
-        return FALSE;
+        const keywordDesc* kw = &RubyKeywordTable[i];
+        if (kw->name[0] > (char) cp[0])
+        {
+            break;
+        }
+        if (strncmp (kw->name, (const char*) cp, n) == 0 &&
+            kw->name[n] == '\0')
+        {
+            *length = n;
+            return kw->id;
+        }
     }
-    *s += literal_length;
-    return TRUE;
+    return KEYWORD_NONE;
 }
 
 /*
 * Attempts to advance 'cp' past a Ruby operator method name. Returns
 * TRUE if successful (and copies the name into 'name'), FALSE otherwise.
+* The operator must end the token, so it is the text up to the first
+* space, parenthesis or end of line, which is then checked by its first
+* character against the operators:
+*
+*   [] []= ** ! ~ +@ -@ * / % + - >> << & ^ | <= < > >= <=> == === != =~ !~ `
 */
 static boolean parseRubyOperator (vString* name, const unsigned char** cp)
 {
-    static const char* RUBY_OPERATORS[] = {
-        "[]", "[]=",
-        "**",
-        "!", "~", "+@", "-@",
-        "*", "/", "%",
-        "+", "-",
-        ">>", "<<",
-        "&",
-        "^", "|",
-        "<=", "<", ">", ">=",
-        "<=>", "==", "===", "!=", "=~", "!~",
-        "`",
-        0
-    };
-    int i;
-    for (i = 0; RUBY_OPERATORS[i] != 0; ++i)
+    const unsigned char* const s = *cp;
+    size_t length = 0;
+    boolean found = FALSE;
+
+    while (length < 4 && ! isTokenEnd (s[length]))
+        ++length;
+    switch (length == 4 ? '\0' : s[0])
     {
-        if (canMatch (cp, RUBY_OPERATORS[i]))
-        {
-            vStringCatS (name, RUBY_OPERATORS[i]);
-            return TRUE;
-        }
+        case '~': case '/': case '%': case '&': case '^': case '|': case '`':
+            found = (boolean) (length == 1);
+            break;
+        case '*':
+            found = (boolean) (length == 1 || (length == 2 && s[1] == '*'));
+            break;
+        case '+': case '-':
+            found = (boolean) (length == 1 || (length == 2 && s[1] == '@'));
+            break;
+        case '!':
+            found = (boolean) (length == 1 ||
+                    (length == 2 && (s[1] == '=' || s[1] == '~')));
+            break;
+        case '[':
+            found = (boolean) (s[1] == ']' &&
+                    (length == 2 || (length == 3 && s[2] == '=')));
+            break;
+        case '>':
+            found = (boolean) (length == 1 ||
+                    (length == 2 && (s[1] == '>' || s[1] == '=')));
+            break;
+        case '<':
+            found = (boolean) (length == 1 ||
+                    (length == 2 && (s[1] == '<' || s[1] == '=')) ||
+                    (length == 3 && s[1] == '=' && s[2] == '>'));
+            break;
+        case '=':
+            found = (boolean) ((length == 2 && (s[1] == '=' || s[1] == '~')) ||
+                    (length == 3 && s[1] == '=' && s[2] == '='));
+            break;
+        default:
+            break;
     }
-    return FALSE;
+    if (found)
+    {
+        vStringNCatS (name, (const char*) s, length);
+        *cp += length;
+    }
+    return found;
 }
 
 /*
@@ -289,16 +362,22 @@ static void findRubyTags (void)
     while ((line = fileReadLine ()) != NULL)
     {
         const unsigned char *cp = line;
+        rubyKeyword keyword;
+        size_t length = 0;
 
-        if (canMatch (&cp, "=begin"))
-        {
-            inMultiLineComment = TRUE;
-            continue;
-        }
-        if (canMatch (&cp, "=end"))
+        if (*cp == '=')
         {
-            inMultiLineComment = FALSE;
-            continue;
+            keyword = lookupRubyKeyword (cp + 1, &length);
+            if (keyword == KEYWORD_begin)
+            {
+                inMultiLineComment = TRUE;
+                continue;
+            }
+            if (keyword == KEYWORD_end)
+            {
+                inMultiLineComment = FALSE;
+                continue;
+            }
         }
 
         skipWhitespace (&cp);
@@ -319,29 +398,32 @@ static void findRubyTags (void)
         *
         *   puts("hello") \
         *       unless <exp>
-        */
-        if (canMatch (&cp, "case") || canMatch (&cp, "for") ||
-            canMatch (&cp, "if") || canMatch (&cp, "unless") ||
-            canMatch (&cp, "while"))
-        {
-            enterUnnamedScope ();
-        }
-
-        /*
+        *
         * "module M", "class C" and "def m" should only be at the beginning
         * of a line.
         */
-        if (canMatch (&cp, "module"))
+        keyword = lookupRubyKeyword (cp, &length);
+        switch (keyword)
         {
-            readAndEmitTag (&cp, K_MODULE);
-        }
-        else if (canMatch (&cp, "class"))
-        {
-            readAndEmitTag (&cp, K_CLASS);
-        }
-        else if (canMatch (&cp, "def"))
-        {
-            readAndEmitTag (&cp, K_METHOD);
+            case KEYWORD_case: case KEYWORD_for: case KEYWORD_if:
+            case KEYWORD_unless: case KEYWORD_while:
+                cp += length;
+                enterUnnamedScope ();
+                break;
+            case KEYWORD_module:
+                cp += length;
+                readAndEmitTag (&cp, K_MODULE);
+                break;
+            case KEYWORD_class:
+                cp += length;
+                readAndEmitTag (&cp, K_CLASS);
+                break;
+            case KEYWORD_def:
+                cp += length;
+                readAndEmitTag (&cp, K_METHOD);
+                break;
+            default:
+                break;
         }
 
         while (*cp != '\0')
@@ -364,15 +446,28 @@ static void findRubyTags (void)
                 */
                 break;
             }
-            else if (canMatch (&cp, "begin") || canMatch (&cp, "do"))
+            else if ((keyword = lookupRubyKeyword (cp, &length)) ==
+                        KEYWORD_begin || keyword == KEYWORD_do)
             {
+                cp += length;
                 enterUnnamedScope ();
             }
-            else if (canMatch (&cp, "end") && stringListCount (nesting) > 0)
+            else if (keyword == KEYWORD_end)
             {
-                /* Leave the most recent scope. */
-                vStringDelete (stringListLast (nesting));
-                stringListRemoveLast (nesting);
+                cp += length;
+                if (stringListCount (nesting) > 0)
+                {
+                    /* Leave the most recent scope. */
+                    vStringDelete (stringListLast (nesting));
+                    stringListRemoveLast (nesting);
+                }
+                else if (*cp != '\0')
+                {
+                    /* A stray "end" is skipped with the token after it. */
+                    do
+                        ++cp;
+                    while (isalnum (*cp) || *cp == '_');
+                }
             }
             else if (*cp == '"')
             {
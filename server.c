@@ -0,0 +1,167 @@
+/*
+*   $Id$
+*
+*   Copyright (c) 2026, Exuberant Ctags contributors
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License.
+*
+*   This module contains functions to answer requests for the tags of source
+*   files whose contents are sent with the requests (see --server), as from
+*   an editor holding unsaved changes. One process answers every request,
+*   so that options, parsers and regex patterns are prepared only once.
+*
+*   Each request, read from standard input, is a header line followed by
+*   the contents of the file:
+*
+*     <length> <language> <path>\n
+*     <length bytes of contents>
+*
+*   where the language is a name as for --language-force, or "-" to
+*   determine it from the path as usual. The answer, written to standard
+*   output, is the tags of the contents, as a tag file would hold them,
+*   followed by an empty line, which no tag line can be.
+*/
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#ifdef HAVE_STDLIB_H
+# include <stdlib.h>  /* to declare strtoul () */
+#endif
+
+#include "debug.h"
+#include "entry.h"
+#include "options.h"
+#include "parse.h"
+#include "read.h"
+#include "routines.h"
+#include "server.h"
+#include "vstring.h"
+
+/*
+*   FUNCTION DEFINITIONS
+*/
+
+/*  Reads a header line from "fp" into "line", without its newline. Returns
+ *  FALSE at the end of input.
+ */
+static boolean readHeader (vString *const line, FILE *const fp)
+{
+	int c = getc (fp);
+	vStringClear (line);
+	while (c != EOF  &&  c != '\n')
+	{
+		vStringPut (line, c);
+		c = getc (fp);
+	}
+	if (vStringLength (line) > 0  &&  vStringLast (line) == '\r')
+		vStringChop (line);
+	vStringTerminate (line);
+	return (boolean) (c != EOF  ||  vStringLength (line) > 0);
+}
+
+/*  Reads the length of a request, which must be unsigned decimal digits
+ *  alone, and small enough that a buffer one byte longer can be allocated.
+ */
+static boolean parseLength (const char *const text, unsigned long *const length)
+{
+	boolean result = FALSE;
+	if (*text >= '0'  &&  *text <= '9')
+	{
+		char *end = NULL;
+		errno = 0;
+		*length = strtoul (text, &end, 10);
+		result = (boolean) (errno == 0  &&  *end == '\0'  &&
+				*length < (unsigned long) ((size_t) -1)  &&
+				(size_t) *length == *length);
+	}
+	return result;
+}
+
+/*  Splits a header line into its length, language and path, which points
+ *  into the line. The language is LANG_AUTO if it is to be determined from
+ *  the path. Returns FALSE if the header is not well formed.
+ */
+static boolean parseHeader (
+		vString *const line, unsigned long *const length,
+		langType *const language, const char **const path)
+{
+	char *const text = vStringValue (line);
+	char *const space1 = strchr (text, ' ');
+	char *const space2 = space1 == NULL ? NULL : strchr (space1 + 1, ' ');
+	boolean result = FALSE;
+
+	if (space2 != NULL  &&  space2 [1] != '\0')
+	{
+		*space1 = '\0';
+		*space2 = '\0';
+		if (parseLength (text, length))
+		{
+			const char *const name = space1 + 1;
+			result = TRUE;
+			*path = space2 + 1;
+			if (strcmp (name, "-") == 0)
+				*language = Option.language;
+			else
+			{
+				*language = getNamedLanguage (name);
+				if (*language == LANG_IGNORE)
+					error (WARNING, "Unknown language \"%s\" in request", name);
+			}
+		}
+	}
+	return result;
+}
+
+/*  Answers requests read from standard input until its end.
+ */
+extern void serveRequests (void)
+{
+	vString *const header = vStringNew ();
+	unsigned char *contents = NULL;
+	size_t size = 0;
+
+	if (sizeof (fpos_t) < sizeof (size_t))
+		error (FATAL, "server mode is not supported on this host");
+	while (readHeader (header, stdin))
+	{
+		unsigned long length = 0;
+		langType language = LANG_IGNORE;
+		const char *path = NULL;
+
+		if (! parseHeader (header, &length, &language, &path))
+			error (FATAL, "Malformed request \"%s\"", vStringValue (header));
+		if (length + 1 > size)
+		{
+			size = length + 1;
+			contents = xRealloc (contents, size, unsigned char);
+		}
+		if (fread (contents, 1, length, stdin) != length)
+			error (FATAL, "Request for \"%s\" ends early", path);
+		contents [length] = '\0';
+
+		/*  The language is determined only once the contents are supplied,
+		 *  so that any "#!" line is read from them rather than the file.
+		 */
+		fileSupplyContents (path, contents, length);
+		if (language == LANG_AUTO)
+			language = getFileLanguage (path);
+		openTagFile ();
+		parseFileAs (path, language);
+		closeTagFile (FALSE);
+		fileReleaseContents ();
+		putchar ('\n');
+		fflush (stdout);
+	}
+	if (contents != NULL)
+		eFree (contents);
+	vStringDelete (header);
+}
+
+/* vi:set tabstop=4 shiftwidth=4: */
@@ -0,0 +1,26 @@
+/*
+*   $Id$
+*
+*   Copyright (c) 2026, Exuberant Ctags contributors
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License.
+*
+*   External interface to server.c
+*/
+#ifndef _SERVER_H
+#define _SERVER_H
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+/*
+*   FUNCTION PROTOTYPES
+*/
+extern void serveRequests (void);
+
+#endif  /* _SERVER_H */
+
+/* vi:set tabstop=4 shiftwidth=4: */
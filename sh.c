@@ -33,6 +33,11 @@ static kindOption ShKinds [] = {
 	{ TRUE, 'f', "function", "functions"}
 };
 
+/*  Every function definition is begun by "function" or followed by "()".
+ */
+static const char *const ShTriggerWords [] = { "function", "(", NULL };
+static lineTriggers ShTriggers = { ShTriggerWords, 0, 0, { 0 } };
+
 /*
 *   FUNCTION DEFINITIONS
 */
@@ -55,7 +60,7 @@ static void findShTags (void)
 	vString *name = vStringNew ();
 	const unsigned char *line;
 
-	while ((line = fileReadLine ()) != NULL)
+	while ((line = fileReadLineContaining (&ShTriggers)) != NULL)
 	{
 		const unsigned char* cp = line;
 		boolean functionFound = FALSE;
@@ -15,27 +15,129 @@
  *   INCLUDE FILES
  */
 #include "general.h"  /* must always come first */
+
+#include <string.h>
+
 #include "parse.h"
+#include "read.h"
+#include "vstring.h"
+
+/*
+ *   DATA DEFINITIONS
+ */
+typedef enum {
+	K_FUNCTION, K_NAMESPACE
+} slangKind;
+
+static kindOption SlangKinds [] = {
+	{ TRUE, 'f', "function",  "functions" },
+	{ TRUE, 'n', "namespace", "namespaces" }
+};
 
 /*
  *   FUNCTION DEFINITIONS
  */
-static void installSlangRegex (const langType language)
+
+static boolean isBlank (const int c)
+{
+	return (boolean) (c == ' '  ||  c == '\t');
+}
+
+static boolean isNameInitial (const int c)
+{
+	return (boolean) ((c >= 'A'  &&  c <= 'Z')  ||  (c >= 'a'  &&  c <= 'z')  ||
+			c == '_');
+}
+
+static const unsigned char *skipBlanks (const unsigned char *cp)
 {
-	addTagRegex (language,
-		"^.*define[ \t]+([A-Z_][A-Z0-9_]*)[^;]*$",
-		"\\1", "f,function,functions", "i");
-	addTagRegex (language,
-		"^[ \t]*implements[ \t]+\\([ \t]*\"([^\"]*)\"[ \t]*\\)[ \t]*;",
-		"\\1", "n,namespace,namespaces", NULL);
+	while (isBlank ((int) *cp))
+		++cp;
+	return cp;
+}
+
+/*  Makes a tag for the last "define name" of a line with no ";" following
+ *  it, the word "define" being of either case.
+ */
+static void findFunction (const unsigned char *const line, vString *const name)
+{
+	const unsigned char *start = NULL;
+	const unsigned char *cp;
+	for (cp = line  ;  *cp != '\0'  ;  ++cp)
+	{
+		if ((*cp == 'd'  ||  *cp == 'D')  &&
+			strncasecmp ((const char*) cp, "define", (size_t) 6) == 0  &&
+			isBlank ((int) cp [6]))
+		{
+			const unsigned char *const p = skipBlanks (cp + 6);
+			if (isNameInitial ((int) *p))
+				start = p;
+		}
+	}
+	if (start != NULL  &&  strchr ((const char*) start, ';') == NULL)
+	{
+		cp = start;
+		while (isNameInitial ((int) *cp)  ||  (*cp >= '0'  &&  *cp <= '9'))
+			++cp;
+		vStringNCopyS (name, (const char*) start, cp - start);
+		makeSimpleTag (name, SlangKinds, K_FUNCTION);
+	}
+}
+
+/*  Makes a tag for a line of the form
+ *  implements ("namespace");
+ */
+static void findNamespace (const unsigned char *cp, vString *const name)
+{
+	cp = skipBlanks (cp);
+	if (strncmp ((const char*) cp, "implements", (size_t) 10) == 0  &&
+		isBlank ((int) cp [10]))
+	{
+		cp = skipBlanks (cp + 10);
+		if (*cp == '(')
+		{
+			cp = skipBlanks (cp + 1);
+			if (*cp == '"')
+			{
+				const unsigned char *const start = cp + 1;
+				const unsigned char *const end = (const unsigned char*)
+						strchr ((const char*) start, '"');
+				if (end != NULL)
+				{
+					cp = skipBlanks (end + 1);
+					if (*cp == ')'  &&  *skipBlanks (cp + 1) == ';')
+					{
+						vStringNCopyS (name, (const char*) start, end - start);
+						vStringStripLeading (name);
+						vStringStripTrailing (name);
+						makeSimpleTag (name, SlangKinds, K_NAMESPACE);
+					}
+				}
+			}
+		}
+	}
+}
+
+static void findSlangTags (void)
+{
+	vString *const name = vStringNew ();
+	const unsigned char *line;
+
+	while ((line = fileReadLine ()) != NULL)
+	{
+		findFunction (line, name);
+		findNamespace (line, name);
+	}
+	vStringDelete (name);
 }
 
 extern parserDefinition* SlangParser (void)
 {
 	static const char *const extensions [] = { "sl", NULL };
 	parserDefinition* const def = parserNew ("SLang");
+	def->kinds      = SlangKinds;
+	def->kindCount  = KIND_COUNT (SlangKinds);
 	def->extensions = extensions;
-	def->initialize = installSlangRegex;
-	def->regex      = TRUE;
+	def->parser     = findSlangTags;
 	return def;
 }
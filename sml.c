@@ -156,6 +156,7 @@ static void findSmlTags (void)
 	const unsigned char *line;
 	smlKind lastTag = K_NONE;
 
+	CommentLevel = 0;
 	while ((line = fileReadLine ()) != NULL)
 	{
 		const unsigned char *cp = skipSpace (line);
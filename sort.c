@@ -19,13 +19,43 @@
 #endif
 #include <string.h>
 #include <stdio.h>
+#include <ctype.h>  /* to declare toupper () */
+
+#if defined (JOBS_SUPPORTED) && \
+	defined (HAVE_MMAP) && defined (HAVE_SYS_MMAN_H)
+# ifdef HAVE_SYS_TYPES_H
+#  include <sys/types.h>
+# endif
+# include <sys/mman.h>  /* to declare mmap () */
+# if ! defined (MAP_ANONYMOUS) && defined (MAP_ANON)
+#  define MAP_ANONYMOUS MAP_ANON
+# endif
+# ifdef MAP_ANONYMOUS
+#  define PARALLEL_SORT 1
+# endif
+#endif
 
 #include "debug.h"
 #include "entry.h"
+#include "jobs.h"
 #include "options.h"
 #include "read.h"
 #include "routines.h"
 #include "sort.h"
+#include "strlist.h"
+
+/*
+*   DATA DECLARATIONS
+*/
+
+/*  A tag file being merged, along with its next unwritten line.
+ */
+typedef struct sMergeInput {
+	const char *name;
+	FILE *fp;
+	vString *line;
+	boolean atEnd;
+} mergeInput;
 
 /*
 *   FUNCTION DEFINITIONS
@@ -45,99 +75,395 @@ extern void catFile (const char *const name)
 	}
 }
 
-#ifdef EXTERNAL_SORT
+/*
+ *  These functions sort the tag lines held in memory (see entry.c) together
+ *  with the lines of the tag file. The internal sort holds all of them in
+ *  memory at once. The external merge sort holds no more than allowed by
+ *  --sort-memory, sorting each such run of lines into a temporary file, then
+ *  merges the runs. Like the sort utility it replaces ("sort -u [-f]"), it
+ *  writes only one of lines which compare equal.
+ */
 
-#ifdef NON_CONST_PUTENV_PROTOTYPE
-# define PE_CONST
-#else
-# define PE_CONST const
-#endif
+static void failedSort (FILE *const fp, const char* msg)
+{
+	const char* const cannotSort = "cannot sort tag file";
+	if (fp != NULL)
+		fclose (fp);
+	if (msg == NULL)
+		error (FATAL | PERROR, cannotSort);
+	else
+		error (FATAL, "%s: %s", msg, cannotSort);
+}
 
-extern void externalSortTags (const boolean toStdout)
+/*  The tag lines are sorted using a multikey quicksort, which partitions
+ *  the lines on one character position at a time, so that the characters
+ *  preceding it, shared by all lines in the partition, are never compared
+ *  again. The first characters of each line are found in its table entry,
+ *  sparing a visit to the line itself, and the file field in the held file
+ *  name to which the entry points (see holdTagLine ()). The order is the
+ *  same as that of strcmp () or, when folding case, struppercmp (), by
+ *  which each character is mapped to the value of its sort key. Lines
+ *  equal but for case are ordered by strcmp (), so that identical lines
+ *  are adjacent.
+ */
+
+enum eSortLimits {
+	SmallPartition = 10,  /* partition size sorted by insertion */
+	ParallelSortMinimum = 100000,  /* fewest lines sorted by several jobs */
+	SortKeyCount = 257,   /* number of distinct sort keys, from -1 to 255 */
+	SortBucketCount = SortKeyCount * SortKeyCount,
+	MinimumSortMemory = 4,  /* fewest megabytes held for each sorted run */
+	MaximumSortRuns = 32,   /* most sorted runs merged at once */
+	SortOutputChunk = 1024 * 1024  /* bytes of sorted lines written at once */
+};
+
+static int SortKey [256];  /* sort key of each character */
+static boolean SortConcurrently = TRUE;  /* may jobs sort held lines? */
+
+static void initSortKeys (const boolean foldCase)
 {
-	const char *const sortNormalCommand = "sort -u -o";
-	const char *const sortFoldedCommand = "sort -u -f -o";
-	const char *sortCommand =
-		Option.sorted == SO_FOLDSORTED ? sortFoldedCommand : sortNormalCommand;
-	PE_CONST char *const sortOrder1 = "LC_COLLATE=C";
-	PE_CONST char *const sortOrder2 = "LC_ALL=C";
-	const size_t length = 4 + strlen (sortOrder1) + strlen (sortOrder2) +
-			strlen (sortCommand) + (2 * strlen (tagFileName ()));
-	char *const cmd = (char *) malloc (length + 1);
-	int ret = -1;
+	int c;
+	for (c = 0  ;  c < 256  ;  ++c)
+	{
+		if (foldCase)
+			SortKey [c] = toupper ((int) (char) c);
+		else
+			SortKey [c] = c;
+	}
+}
 
-	if (cmd != NULL)
+/*  Returns the character at offset "d" of a held line, as it is written.
+ */
+static char tagLineChar (const tagLine *const t, size_t d)
+{
+	if (d >= t->split)
 	{
-		/*  Ensure ASCII value sort order.
-		 */
-#ifdef HAVE_SETENV
-		setenv ("LC_COLLATE", "C", 1);
-		setenv ("LC_ALL", "C", 1);
-		sprintf (cmd, "%s %s %s", sortCommand, tagFileName (), tagFileName ());
-#else
-# ifdef HAVE_PUTENV
-		putenv (sortOrder1);
-		putenv (sortOrder2);
-		sprintf (cmd, "%s %s %s", sortCommand, tagFileName (), tagFileName ());
-# else
-		sprintf (cmd, "%s %s %s %s %s", sortOrder1, sortOrder2, sortCommand,
-				tagFileName (), tagFileName ());
-# endif
-#endif
-		verbose ("system (\"%s\")\n", cmd);
-		ret = system (cmd);
-		free (cmd);
+		if (d - t->split < t->file->length)
+			return t->file->text [d - t->split];
+		d -= t->file->length;
+	}
+	return t->line [d];
+}
+
+#define sortKeyAt(t,d) \
+	SortKey [(unsigned char) ((d) < TAG_LINE_PREFIX_LENGTH ? \
+		(t)->prefix [d] : tagLineChar ((t), (d)))]
 
+/*  Determines whether two held lines have the same file field at the same
+ *  offset, or none, so that their held text compares as the whole lines do.
+ */
+static boolean shareFileField (const tagLine *const one, const tagLine *const two)
+{
+	return (boolean) (one->file == two->file  &&
+			(one->file == NULL  ||  one->split == two->split));
+}
+
+/*  Compares two held lines like strcmp ().
+ */
+static int compareTagLines (const tagLine *const one, const tagLine *const two)
+{
+	int result;
+	size_t d;
+	if (shareFileField (one, two))
+		return strcmp (one->line, two->line);
+	for (d = 0  ;  ;  ++d)
+	{
+		const unsigned char c1 = (unsigned char) tagLineChar (one, d);
+		const unsigned char c2 = (unsigned char) tagLineChar (two, d);
+		result = (int) c1 - (int) c2;
+		if (result != 0  ||  c1 == '\0')
+			break;
 	}
-	if (ret != 0)
-		error (FATAL | PERROR, "cannot sort tag file");
-	else if (toStdout)
-		catFile (tagFileName ());
+	return result;
 }
 
-#else
+static void swapTagLines (tagLine *const one, tagLine *const two)
+{
+	const tagLine temp = *one;
+	*one = *two;
+	*two = temp;
+}
 
-/*
- *  These functions provide a basic internal sort. No great memory
- *  optimization is performed (e.g. recursive subdivided sorts),
- *  so have lots of memory if you have large tag files.
+/*  Compares two lines whose first "depth" characters have equal keys.
  */
+static int compareFromDepth (
+		const tagLine *const one, const tagLine *const two, size_t depth)
+{
+	int result;
+	if (shareFileField (one, two))
+	{
+		/*  Compare the held text from the offset of "depth" within it.
+		 */
+		const unsigned char *p1, *p2;
+		if (depth >= one->split)
+			depth = (depth - one->split < one->file->length) ?
+					one->split : depth - one->file->length;
+		p1 = (const unsigned char *) one->line + depth;
+		p2 = (const unsigned char *) two->line + depth;
+		while ((result = SortKey [*p1] - SortKey [*p2]) == 0  &&  *p1 != '\0')
+		{
+			++p1;
+			++p2;
+		}
+	}
+	else for (;;)
+	{
+		const int key = sortKeyAt (one, depth);
+		result = key - sortKeyAt (two, depth);
+		if (result != 0  ||  key == 0)
+			break;
+		++depth;
+	}
+	if (result == 0)
+		result = compareTagLines (one, two);
+	return result;
+}
 
-static void failedSort (FILE *const fp, const char* msg)
+static int compareTags (const void *const one, const void *const two)
 {
-	const char* const cannotSort = "cannot sort tag file";
-	if (fp != NULL)
-		fclose (fp);
-	if (msg == NULL)
-		error (FATAL | PERROR, cannotSort);
+	return compareTagLines ((const tagLine *) one, (const tagLine *) two);
+}
+
+static void insertionSortTagLines (
+		tagLine *const table, const size_t count, const size_t depth)
+{
+	size_t i, j;
+	for (i = 1  ;  i < count  ;  ++i)
+	{
+		for (j = i  ;  j > 0  &&
+				compareFromDepth (&table [j - 1], &table [j], depth) > 0  ;  --j)
+			swapTagLines (&table [j - 1], &table [j]);
+	}
+}
+
+static int medianKey (const int a, const int b, const int c)
+{
+	int result;
+	if (a < b)
+		result = (b < c) ? b : (a < c) ? c : a;
 	else
-		error (FATAL, "%s: %s", msg, cannotSort);
+		result = (a < c) ? a : (b < c) ? c : b;
+	return result;
 }
 
-static int compareTagsFolded(const void *const one, const void *const two)
+/*  Sorts lines whose first "depth" characters have equal keys.
+ */
+static void sortTagLines (tagLine *table, size_t count, size_t depth)
 {
-	const char *const line1 = *(const char* const*) one;
-	const char *const line2 = *(const char* const*) two;
+	while (count > SmallPartition)
+	{
+		const int pivot = medianKey (sortKeyAt (&table [0], depth),
+				sortKeyAt (&table [count / 2], depth),
+				sortKeyAt (&table [count - 1], depth));
+		size_t lt = 0, i = 0, gt = count;
 
-	return struppercmp (line1, line2);
+		/*  Partition into lines whose key is less than, equal to and greater
+		 *  than the pivot.
+		 */
+		while (i < gt)
+		{
+			const int key = sortKeyAt (&table [i], depth);
+			if (key < pivot)
+				swapTagLines (&table [lt++], &table [i++]);
+			else if (key > pivot)
+				swapTagLines (&table [i], &table [--gt]);
+			else
+				++i;
+		}
+		sortTagLines (table, lt, depth);
+		sortTagLines (table + gt, count - gt, depth);
+		table += lt;
+		count = gt - lt;
+		if (pivot == 0)
+		{
+			/*  The lines are equal, at least but for case.
+			 */
+			if (Option.sorted == SO_FOLDSORTED)
+				qsort (table, count, sizeof (*table), compareTags);
+			count = 0;
+		}
+		else
+			++depth;
+	}
+	insertionSortTagLines (table, count, depth);
 }
 
-static int compareTags (const void *const one, const void *const two)
+#ifdef PARALLEL_SORT
+
+/*  The lines may also be sorted by several jobs. They are distributed into
+ *  buckets by their first two sort keys, in a table in memory shared with
+ *  the jobs, and each job sorts a run of whole buckets holding about an
+ *  equal share of the lines. Since no line in one run sorts after any line
+ *  of the next, nothing remains to be merged, and duplicate lines are
+ *  eliminated while writing the table as usual.
+ */
+
+static tagLine *SharedTable;
+static unsigned long *JobShares;  /* first line of each job's run, and end */
+
+static unsigned int sortBucket (const tagLine *const t)
 {
-	const char *const line1 = *(const char* const*) one;
-	const char *const line2 = *(const char* const*) two;
+	return (unsigned int) ((sortKeyAt (t, 0) + 1) * SortKeyCount +
+			sortKeyAt (t, 1) + 1);
+}
 
-	return strcmp (line1, line2);
+static void sortJobShare (const unsigned int job)
+{
+	sortTagLines (SharedTable + JobShares [job],
+			JobShares [job + 1] - JobShares [job], 0);
 }
 
-static void writeSortedTags (
-		char **const table, const size_t numTags, const boolean toStdout)
+/*  Sorts the held lines using several jobs, returning the sorted table, or
+ *  NULL, having done nothing, if the shared table is unavailable.
+ */
+static tagLine *sortConcurrently (void)
 {
-	FILE *fp;
-	size_t i;
+	const unsigned long count = TagFile.held.count;
+	const unsigned int jobs = Option.jobs;
+	unsigned long *starts;
+	unsigned long i;
+	unsigned int b, j;
+	void *const table = mmap (NULL, count * sizeof (tagLine),
+			PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
 
-	/*  Write the sorted lines back into the tag file.
+	if (table == MAP_FAILED)
+		return NULL;
+	SharedTable = (tagLine *) table;
+	starts = xCalloc (SortBucketCount + 1, unsigned long);
+	JobShares = xMalloc (jobs + 1, unsigned long);
+
+	/*  Find where each bucket starts, then divide the buckets among jobs.
 	 */
+	for (i = 0  ;  i < count  ;  ++i)
+		++starts [sortBucket (&TagFile.held.lines [i]) + 1];
+	for (b = 1  ;  b <= SortBucketCount  ;  ++b)
+		starts [b] += starts [b - 1];
+	JobShares [0] = 0;
+	for (b = 0, j = 1  ;  b < SortBucketCount  &&  j < jobs  ;  ++b)
+	{
+		if (starts [b] >= j * (count / jobs))
+			JobShares [j++] = starts [b];
+	}
+	while (j <= jobs)
+		JobShares [j++] = count;
+
+	/*  Place the lines into their buckets.
+	 */
+	for (i = 0  ;  i < count  ;  ++i)
+	{
+		const tagLine *const line = &TagFile.held.lines [i];
+		SharedTable [starts [sortBucket (line)]++] = *line;
+	}
+	eFree (starts);
+	verbose ("sorting %lu tags using %u jobs\n", count, jobs);
+	if (! runConcurrentTasks (jobs, sortJobShare))
+		failedSort (NULL, "sort job failed");
+	eFree (JobShares);
+	return SharedTable;
+}
+
+#endif
+
+/*  Sorts the held lines, returning the sorted table, which is released by
+ *  releaseSortedLines ().
+ */
+static tagLine *sortHeldLines (void)
+{
+	tagLine *table = NULL;
+
+	initSortKeys ((boolean) (Option.sorted == SO_FOLDSORTED));
+#ifdef PARALLEL_SORT
+	if (Option.jobs > 1  &&  SortConcurrently  &&
+		TagFile.held.count >= ParallelSortMinimum)
+		table = sortConcurrently ();
+#endif
+	if (table == NULL)
+	{
+		sortTagLines (TagFile.held.lines, TagFile.held.count, 0);
+		table = TagFile.held.lines;
+	}
+	return table;
+}
+
+static void releaseSortedLines (tagLine *const table)
+{
+	PrintStatus (("sort memory: %ld bytes\n", (long) TagFile.held.memory));
+#ifdef PARALLEL_SORT
+	if (table != TagFile.held.lines)
+		munmap ((void *) table, TagFile.held.count * sizeof (tagLine));
+#endif
+	discardHeldTags ();
+}
+
+/*  Determines whether a sorted line duplicates the one before it, and so is
+ *  not to be written. Only identical tag *lines* (including search pattern)
+ *  are filtered out, never lines equal but for case, and by the internal
+ *  sort only if this is not an xref file.
+ */
+static boolean isDuplicateLine (const char *const line, const char *const previous)
+{
+#ifdef EXTERNAL_SORT
+	return (boolean) (strcmp (line, previous) == 0);
+#else
+	return (boolean) (! Option.xref  &&  strcmp (line, previous) == 0);
+#endif
+}
+
+/*  Returns the length of a held line as it is written.
+ */
+static size_t heldLineLength (const tagLine *const line)
+{
+	return line->length + (line->file == NULL ? 0 : line->file->length);
+}
+
+/*  Determines, like isDuplicateLine (), whether a sorted held line
+ *  duplicates the one before it.
+ */
+static boolean isDuplicateTagLine (
+		const tagLine *const line, const tagLine *const previous)
+{
+#ifndef EXTERNAL_SORT
+	if (Option.xref)
+		return FALSE;
+#endif
+	if (heldLineLength (line) != heldLineLength (previous))
+		return FALSE;
+	return (boolean) (compareTagLines (line, previous) == 0);
+}
+
+static void writeSortedChunk (FILE *const fp, vString *const chunk)
+{
+	if (fwrite (vStringValue (chunk), 1, vStringLength (chunk), fp) !=
+			vStringLength (chunk))
+		failedSort (fp, NULL);
+	vStringClear (chunk);
+}
+
+/*  Writes the sorted lines, less duplicates, formatting them into chunks
+ *  written at once, rather than passing each line through the buffer of
+ *  "fp" in pieces.
+ */
+static void writeSortedLines (
+		FILE *const fp, const tagLine *const table, const size_t count)
+{
+	vString *const chunk = vStringNew ();
+	size_t i;
+	for (i = 0 ; i < count ; ++i)
+	{
+		if (i == 0  ||  ! isDuplicateTagLine (&table [i], &table [i-1]))
+		{
+			appendHeldLine (chunk, &table [i]);
+			if (vStringLength (chunk) >= SortOutputChunk)
+				writeSortedChunk (fp, chunk);
+		}
+	}
+	writeSortedChunk (fp, chunk);
+	vStringDelete (chunk);
+}
+
+static FILE *openSortOutput (const boolean toStdout)
+{
+	FILE *fp;
 	if (toStdout)
 		fp = stdout;
 	else
@@ -146,85 +472,512 @@ static void writeSortedTags (
 		if (fp == NULL)
 			failedSort (fp, NULL);
 	}
-	for (i = 0 ; i < numTags ; ++i)
-	{
-		/*  Here we filter out identical tag *lines* (including search
-		 *  pattern) if this is not an xref file.
-		 */
-		if (i == 0  ||  Option.xref  ||  strcmp (table [i], table [i-1]) != 0)
-			if (fputs (table [i], fp) == EOF)
-				failedSort (fp, NULL);
-	}
+	return fp;
+}
+
+static void closeSortOutput (FILE *const fp, const boolean toStdout)
+{
 	if (toStdout)
 		fflush (fp);
 	else
 		fclose (fp);
 }
 
-extern void internalSortTags (const boolean toStdout)
+/*  A sorted run of tag lines in a temporary file, being merged.
+ */
+typedef struct sSortRun {
+	char *name;    /* temporary file, or NULL if not to be removed */
+	FILE *fp;
+	long left;     /* bytes left to be read, or -1 to read to the end */
+	boolean (*isObsolete) (const char *const line);  /* lines to skip */
+	vString *line;
+	boolean atEnd;
+} sortRun;
+
+static sortRun *SortRuns = NULL;
+static unsigned int SortRunCount = 0;
+
+static void addSortRun (FILE *const fp, char *const name)
 {
-	vString *vLine = vStringNew ();
-	FILE *fp = NULL;
-	const char *line;
-	size_t i;
-	int (*cmpFunc)(const void *, const void *);
+	sortRun *run;
 
-	/*  Allocate a table of line pointers to be sorted.
-	 */
-	size_t numTags = TagFile.numTags.added + TagFile.numTags.prev;
-	const size_t tableSize = numTags * sizeof (char *);
-	char **const table = (char **) malloc (tableSize);  /* line pointers */
-	DebugStatement ( size_t mallocSize = tableSize; )  /* cumulative total */
+	if (fflush (fp) != 0)
+		failedSort (NULL, NULL);
+	rewind (fp);
+	SortRuns = xRealloc (SortRuns, SortRunCount + 1, sortRun);
+	run = &SortRuns [SortRunCount++];
+	run->name = name;
+	run->fp = fp;
+	run->left = -1;
+	run->isObsolete = NULL;
+	run->line = vStringNew ();
+	run->atEnd = FALSE;
+}
+
+static void readRunLine (sortRun *const run)
+{
+	boolean found = FALSE;
+	while (! run->atEnd  &&  ! found)
+	{
+		if (run->left == 0)
+			run->atEnd = TRUE;
+		else if (readLine (run->line, run->fp) == NULL)
+		{
+			if (ferror (run->fp))
+				failedSort (NULL, NULL);
+			run->atEnd = TRUE;
+		}
+		else
+		{
+			if (run->left > 0)
+			{
+				const long length = (long) vStringLength (run->line);
+				run->left = length < run->left ? run->left - length : 0;
+			}
+			if (vStringLast (run->line) != '\n')
+				vStringPut (run->line, '\n');
+			found = (boolean) (run->isObsolete == NULL  ||
+				! (*run->isObsolete) (vStringValue (run->line)));
+		}
+	}
+}
 
+/*  Compares two lines in the order in which sortTagLines () places them.
+ */
+static int compareRunLines (const char *const line1, const char *const line2)
+{
+	int result = 0;
+	if (Option.sorted == SO_FOLDSORTED)
+		result = struppercmp (line1, line2);
+	if (result == 0)
+		result = strcmp (line1, line2);
+	return result;
+}
 
-	cmpFunc = Option.sorted == SO_FOLDSORTED ? compareTagsFolded : compareTags;
-	if (table == NULL)
-		failedSort (fp, "out of memory");
+/*  Merges the sorted runs into "fp", then deletes them. Ties go to the
+ *  earliest run.
+ */
+static void mergeSortRuns (FILE *const fp)
+{
+	vString *const previous = vStringNew ();
+	boolean first = TRUE;
+	sortRun *next;
+	unsigned int i;
 
-	/*  Open the tag file and place its lines into allocated buffers.
-	 */
-	fp = fopen (tagFileName (), "r");
-	if (fp == NULL)
-		failedSort (fp, NULL);
-	for (i = 0  ;  i < numTags  &&  ! feof (fp)  ;  )
+	verbose ("merging %u sorted runs\n", SortRunCount);
+	for (i = 0  ;  i < SortRunCount  ;  ++i)
+		readRunLine (&SortRuns [i]);
+	do
 	{
-		line = readLine (vLine, fp);
-		if (line == NULL)
+		next = NULL;
+		for (i = 0  ;  i < SortRunCount  ;  ++i)
 		{
-			if (! feof (fp))
-				failedSort (fp, NULL);
-			break;
+			sortRun *const run = &SortRuns [i];
+			if (! run->atEnd  &&  (next == NULL  ||
+				compareRunLines (vStringValue (run->line),
+								 vStringValue (next->line)) < 0))
+				next = run;
+		}
+		if (next != NULL)
+		{
+			const char *const line = vStringValue (next->line);
+			if (first  ||  ! isDuplicateLine (line, vStringValue (previous)))
+			{
+				if (fputs (line, fp) == EOF)
+					failedSort (fp, NULL);
+				vStringCopy (previous, next->line);
+				first = FALSE;
+			}
+			readRunLine (next);
+		}
+	} while (next != NULL);
+
+	for (i = 0  ;  i < SortRunCount  ;  ++i)
+	{
+		fclose (SortRuns [i].fp);
+		if (SortRuns [i].name != NULL)
+		{
+			remove (SortRuns [i].name);
+			eFree (SortRuns [i].name);
 		}
-		else if (*line == '\0'  ||  strcmp (line, "\n") == 0)
+		vStringDelete (SortRuns [i].line);
+	}
+	eFree (SortRuns);
+	SortRuns = NULL;
+	SortRunCount = 0;
+	vStringDelete (previous);
+}
+
+/*  Sorts the held lines into a new run. To keep few files open, the runs
+ *  are first merged into one when there are too many.
+ */
+static void writeSortRun (void)
+{
+	tagLine *const table = sortHeldLines ();
+	char *name = NULL;
+	FILE *fp;
+
+	if (SortRunCount == MaximumSortRuns)
+	{
+		fp = tempFile ("w+", &name);
+		mergeSortRuns (fp);
+		addSortRun (fp, name);
+		name = NULL;
+	}
+	fp = tempFile ("w+", &name);
+	verbose ("writing sorted run of %lu tags\n", TagFile.held.count);
+	writeSortedLines (fp, table, TagFile.held.count);
+	releaseSortedLines (table);
+	addSortRun (fp, name);
+}
+
+/*  Adds the lines read from "fp" to those held in memory. For the external
+ *  sort, held lines are sorted into a run whenever they reach "limit" bytes.
+ */
+static void loadTagLines (FILE *const fp, const size_t limit __unused__)
+{
+	vString *const vLine = vStringNew ();
+	const char *line;
+
+	while ((line = readLine (vLine, fp)) != NULL)
+	{
+		if (*line == '\0'  ||  strcmp (line, "\n") == 0)
 			;  /* ignore blank lines */
 		else
+			holdTagLine (line, vStringLength (vLine));
+#ifdef EXTERNAL_SORT
+		if (TagFile.held.memory >= limit)
+			writeSortRun ();
+#endif
+	}
+	if (! feof (fp))
+		failedSort (fp, NULL);
+	vStringDelete (vLine);
+}
+
+static void loadTagFile (const size_t limit)
+{
+	FILE *const fp = fopen (tagFileName (), "r");
+	if (fp == NULL)
+		failedSort (fp, NULL);
+	loadTagLines (fp, limit);
+	fclose (fp);
+}
+
+/*  Returns the memory in which lines may be sorted at once.
+ */
+static size_t sortMemoryLimit (void)
+{
+	const unsigned long megabytes = Option.sortMemory > MinimumSortMemory ?
+			Option.sortMemory : MinimumSortMemory;
+	return (size_t) megabytes * 1024 * 1024;
+}
+
+static void writeHeldLines (const boolean toStdout)
+{
+	FILE *const fp = openSortOutput (toStdout);
+	tagLine *const table = sortHeldLines ();
+	writeSortedLines (fp, table, TagFile.held.count);
+	releaseSortedLines (table);
+	closeSortOutput (fp, toStdout);
+}
+
+/*  Writes the held lines straight to the standard output, sorted unless
+ *  tags are not to be sorted, as for each file parsed in filter or server
+ *  mode.
+ */
+extern void writeHeldTags (void)
+{
+	if (Option.sorted != SO_UNSORTED)
+		writeHeldLines (TRUE);
+	else
+	{
+		unsigned long i;
+		for (i = 0  ;  i < TagFile.held.count  ;  ++i)
+			if (! writeHeldLine (&TagFile.held.lines [i], stdout))
+				failedSort (stdout, NULL);
+		discardHeldTags ();
+		fflush (stdout);
+	}
+}
+
+/*  Writes the held lines to "fp", sorted and merged with the sorted runs,
+ *  if any.
+ */
+static void writeSortedTags (FILE *const fp)
+{
+	if (SortRunCount == 0)
+	{
+		tagLine *const table = sortHeldLines ();
+		writeSortedLines (fp, table, TagFile.held.count);
+		releaseSortedLines (table);
+	}
+	else
+	{
+		if (TagFile.held.count > 0)
+			writeSortRun ();
+		mergeSortRuns (fp);
+	}
+}
+
+/*  Sorts in place the file "name" of tags written by a job, so that it may
+ *  be merged as a sorted run into the tag file (see addSortedRun ()). This
+ *  is done by each job as it finishes, while others are still tagging.
+ */
+extern void sortJobTags (const char *const name)
+{
+	FILE *fp = fopen (name, "r");
+	if (fp == NULL)
+		failedSort (fp, NULL);
+	SortConcurrently = FALSE;  /* other jobs are busy */
+	loadTagLines (fp, sortMemoryLimit ());
+	fclose (fp);
+	fp = fopen (name, "w");
+	if (fp == NULL)
+		failedSort (fp, NULL);
+	writeSortedTags (fp);
+	if (fclose (fp) != 0)
+		failedSort (NULL, NULL);
+}
+
+/*  Adds the file "name" of sorted tags, which is removed once merged, to
+ *  the runs merged into the tag file when it is sorted, taking ownership
+ *  of "name". An empty file is removed at once.
+ */
+extern void addSortedRun (char *const name)
+{
+	FILE *const fp = fopen (name, "r");
+	if (fp == NULL)
+		failedSort (fp, NULL);
+	if (fgetc (fp) == EOF)
+	{
+		fclose (fp);
+		remove (name);
+		eFree (name);
+	}
+	else
+	{
+		if (SortRunCount == MaximumSortRuns)
 		{
-			const size_t stringSize = strlen (line) + 1;
-
-			table [i] = (char *) malloc (stringSize);
-			if (table [i] == NULL)
-				failedSort (fp, "out of memory");
-			DebugStatement ( mallocSize += stringSize; )
-			strcpy (table [i], line);
-			++i;
+			char *mergedName = NULL;
+			FILE *const merged = tempFile ("w+", &mergedName);
+			mergeSortRuns (merged);
+			addSortRun (merged, mergedName);
 		}
+		addSortRun (fp, name);
 	}
-	numTags = i;
-	fclose (fp);
-	vStringDelete (vLine);
+}
 
-	/*  Sort the lines.
-	 */
-	qsort (table, numTags, sizeof (*table), cmpFunc);
+#ifdef EXTERNAL_SORT
 
-	writeSortedTags (table, numTags, toStdout);
+extern void externalSortTags (const boolean toStdout)
+{
+	FILE *fp;
+	loadTagFile (sortMemoryLimit ());
+	fp = openSortOutput (toStdout);
+	writeSortedTags (fp);
+	closeSortOutput (fp, toStdout);
+}
+
+#else
 
-	PrintStatus (("sort memory: %ld bytes\n", (long) mallocSize));
-	for (i = 0 ; i < numTags ; ++i)
-		free (table [i]);
-	free (table);
+extern void internalSortTags (const boolean toStdout)
+{
+	FILE *fp;
+	loadTagFile (0);
+	fp = openSortOutput (toStdout);
+	writeSortedTags (fp);
+	closeSortOutput (fp, toStdout);
 }
 
 #endif
 
+/*  Merges the tags appended to a tag file, whose previous contents were
+ *  already sorted, with those contents, which end at "start". Only the
+ *  appended tags, whether held in memory or written to the tag file, are
+ *  sorted. Previous lines for which "isObsolete", if not NULL, returns TRUE
+ *  are dropped.
+ */
+extern void mergeAppendedTags (
+		const long start, boolean (*const isObsolete) (const char *const line))
+{
+	FILE *const fp = fopen (tagFileName (), "r");
+	FILE *out;
+
+	if (fp == NULL)
+		failedSort (fp, NULL);
+	if (fseek (fp, start, SEEK_SET) != 0)
+		failedSort (fp, NULL);
+	loadTagLines (fp, sortMemoryLimit ());
+	if (TagFile.held.count > 0)
+		writeSortRun ();
+	addSortRun (fp, NULL);
+	SortRuns [SortRunCount - 1].left = start;
+	SortRuns [SortRunCount - 1].isObsolete = isObsolete;
+
+	if (Option.daemon)
+	{
+		/*  Replace the tag file at once, so that it is never read while
+		 *  incomplete.
+		 */
+		vString *const newName = vStringNewInit (tagFileName ());
+		vStringCatS (newName, ".new");
+		out = fopen (vStringValue (newName), "w");
+		if (out == NULL)
+			failedSort (out, NULL);
+		mergeSortRuns (out);
+		if (fclose (out) != 0  ||
+			rename (vStringValue (newName), tagFileName ()) != 0)
+			failedSort (NULL, NULL);
+		vStringDelete (newName);
+	}
+	else
+	{
+		char *name = NULL;
+		out = tempFile ("w", &name);
+		mergeSortRuns (out);
+		if (fclose (out) != 0)
+			failedSort (NULL, NULL);
+		copyFile (name, tagFileName (), WHOLE_FILE);
+		remove (name);
+		eFree (name);
+	}
+}
+
+/*
+ *  These functions merge tag files which are already sorted (such as those
+ *  produced using --shard), producing a sorted tag file without sorting its
+ *  contents again.
+ */
+
+static void failedMerge (const char *const fileName)
+{
+	error (FATAL | PERROR, "cannot merge tag file \"%s\"", fileName);
+}
+
+/*  Compares two tag lines the same way as the sort used for the tag file.
+ */
+static int compareMergeLines (const char *const line1, const char *const line2)
+{
+	int result;
+	if (Option.sorted == SO_FOLDSORTED)
+		result = struppercmp (line1, line2);
+	else
+		result = strcmp (line1, line2);
+	return result;
+}
+
+static void checkMergeSortOrder (const mergeInput *const input)
+{
+	const char *const line = vStringValue (input->line);
+	const char *const pseudo = "!_TAG_FILE_SORTED\t";
+	if (strncmp (line, pseudo, strlen (pseudo)) == 0)
+	{
+		const int sorted = line [strlen (pseudo)] - '0';
+		if (Option.sorted != SO_UNSORTED  &&  sorted != (int) Option.sorted)
+			error (FATAL, "\"%s\" is not sorted as required for merging",
+					input->name);
+	}
+}
+
+/*  Advances to the next tag line of an input, skipping its pseudo-tags,
+ *  which are replaced by those of the merged tag file. Lines keep their
+ *  newlines, so that they compare as they do in the internal sort.
+ */
+static void readMergeLine (mergeInput *const input)
+{
+	boolean found = FALSE;
+	while (! input->atEnd  &&  ! found)
+	{
+		if (readLine (input->line, input->fp) == NULL)
+		{
+			if (ferror (input->fp))
+				failedMerge (input->name);
+			input->atEnd = TRUE;
+		}
+		else
+		{
+			const char *const line = vStringValue (input->line);
+			if (strncmp (line, "!_TAG_", 6) == 0)
+				checkMergeSortOrder (input);
+			else if (*line != '\0'  &&  strcmp (line, "\n") != 0)
+			{
+				if (vStringLast (input->line) != '\n')
+					vStringPut (input->line, '\n');
+				found = TRUE;
+			}
+		}
+	}
+}
+
+/*  Returns the input holding the line to be written next, or NULL when all
+ *  inputs are exhausted. Ties go to the earliest input.
+ */
+static mergeInput *nextMergeInput (
+		mergeInput *const inputs, const unsigned int count)
+{
+	mergeInput *result = NULL;
+	unsigned int i;
+	for (i = 0  ;  i < count  ;  ++i)
+	{
+		if (! inputs [i].atEnd  &&  (result == NULL  ||
+			(Option.sorted != SO_UNSORTED  &&
+			 compareMergeLines (vStringValue (inputs [i].line),
+								vStringValue (result->line)) < 0)))
+		{
+			result = &inputs [i];
+		}
+	}
+	return result;
+}
+
+/*  Merges the named tag files into the tag file, which must already be
+ *  open with its pseudo-tags written. When tags are sorted, the inputs are
+ *  merged line by line, otherwise they are simply concatenated. Identical
+ *  lines are written only once, as when sorting.
+ */
+extern void mergeTagFiles (const stringList *const fileNames)
+{
+	const unsigned int count = stringListCount (fileNames);
+	mergeInput *const inputs = xMalloc (count, mergeInput);
+	vString *const previous = vStringNew ();
+	mergeInput *input;
+	unsigned int i;
+
+	for (i = 0  ;  i < count  ;  ++i)
+	{
+		inputs [i].name = vStringValue (stringListItem (fileNames, i));
+		inputs [i].fp = fopen (inputs [i].name, "r");
+		if (inputs [i].fp == NULL)
+			failedMerge (inputs [i].name);
+		inputs [i].line = vStringNew ();
+		inputs [i].atEnd = FALSE;
+		verbose ("merging tag file \"%s\"\n", inputs [i].name);
+		readMergeLine (&inputs [i]);
+	}
+	while ((input = nextMergeInput (inputs, count)) != NULL)
+	{
+		const char *const line = vStringValue (input->line);
+		if (Option.sorted == SO_UNSORTED  ||
+			TagFile.numTags.added == 0  ||
+			strcmp (line, vStringValue (previous)) != 0)
+		{
+			fputs (line, TagFile.fp);
+			++TagFile.numTags.added;
+			if (vStringLength (input->line) > TagFile.max.line)
+				TagFile.max.line = vStringLength (input->line);
+			if (Option.sorted != SO_UNSORTED)
+				vStringCopy (previous, input->line);
+		}
+		readMergeLine (input);
+	}
+	for (i = 0  ;  i < count  ;  ++i)
+	{
+		fclose (inputs [i].fp);
+		vStringDelete (inputs [i].line);
+	}
+	vStringDelete (previous);
+	eFree (inputs);
+}
+
 /* vi:set tabstop=4 shiftwidth=4: */
@@ -16,10 +16,17 @@
 */
 #include "general.h"  /* must always come first */
 
+#include "strlist.h"
+
 /*
 *   FUNCTION PROTOTYPES
 */
 extern void catFile (const char *const name);
+extern void mergeTagFiles (const stringList *const fileNames);
+extern void mergeAppendedTags (const long start, boolean (*const isObsolete) (const char *const line));
+extern void writeHeldTags (void);
+extern void sortJobTags (const char *const name);
+extern void addSortedRun (char *const name);
 
 #ifdef EXTERNAL_SORT
 extern void externalSortTags (const boolean toStdout);
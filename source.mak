@@ -3,20 +3,25 @@
 # Shared macros
 
 HEADERS = \
-	args.h ctags.h debug.h entry.h general.h get.h keyword.h \
-	main.h options.h parse.h parsers.h read.h routines.h sort.h \
-	strlist.h vstring.h
+	archive.h args.h cache.h compress.h ctags.h daemon.h debug.h entry.h \
+	general.h get.h gitindex.h globset.h jobs.h keyword.h lexer.h main.h \
+	manifest.h options.h parse.h parsers.h read.h routines.h server.h sort.h \
+	strlist.h synthetic.h tagindex.h trace.h vstring.h
 
 SOURCES = \
 	args.c \
 	ant.c \
+	archive.c \
 	asm.c \
 	asp.c \
 	awk.c \
 	basic.c \
 	beta.c \
 	c.c \
+	cache.c \
 	cobol.c \
+	compress.c \
+	daemon.c \
 	dosbatch.c \
 	eiffel.c \
 	entry.c \
@@ -25,15 +30,20 @@ SOURCES = \
 	flex.c \
 	fortran.c \
 	get.c \
+	gitindex.c \
+	globset.c \
 	go.c \
 	html.c \
+	jobs.c \
 	jscript.c \
 	keyword.c \
+	lexer.c \
 	lisp.c \
 	lregex.c \
 	lua.c \
 	main.c \
 	make.c \
+	manifest.c \
 	matlab.c \
 	ocaml.c \
 	options.c \
@@ -47,12 +57,15 @@ SOURCES = \
 	routines.c \
 	ruby.c \
 	scheme.c \
+	server.c \
 	sh.c \
 	slang.c \
 	sml.c \
 	sort.c \
 	sql.c \
 	strlist.c \
+	synthetic.c \
+	tagindex.c \
 	tcl.c \
 	tex.c \
 	verilog.c \
@@ -74,13 +87,17 @@ REGEX_HEADERS = gnu_regex/regex.h
 OBJECTS = \
 	args.$(OBJEXT) \
 	ant.$(OBJEXT) \
+	archive.$(OBJEXT) \
 	asm.$(OBJEXT) \
 	asp.$(OBJEXT) \
 	awk.$(OBJEXT) \
 	basic.$(OBJEXT) \
 	beta.$(OBJEXT) \
 	c.$(OBJEXT) \
+	cache.$(OBJEXT) \
 	cobol.$(OBJEXT) \
+	compress.$(OBJEXT) \
+	daemon.$(OBJEXT) \
 	dosbatch.$(OBJEXT) \
 	eiffel.$(OBJEXT) \
 	entry.$(OBJEXT) \
@@ -89,15 +106,20 @@ OBJECTS = \
 	flex.$(OBJEXT) \
 	fortran.$(OBJEXT) \
 	get.$(OBJEXT) \
+	gitindex.$(OBJEXT) \
+	globset.$(OBJEXT) \
 	go.$(OBJEXT) \
 	html.$(OBJEXT) \
+	jobs.$(OBJEXT) \
 	jscript.$(OBJEXT) \
 	keyword.$(OBJEXT) \
+	lexer.$(OBJEXT) \
 	lisp.$(OBJEXT) \
 	lregex.$(OBJEXT) \
 	lua.$(OBJEXT) \
 	main.$(OBJEXT) \
 	make.$(OBJEXT) \
+	manifest.$(OBJEXT) \
 	matlab.$(OBJEXT) \
 	ocaml.$(OBJEXT) \
 	options.$(OBJEXT) \
@@ -111,12 +133,15 @@ OBJECTS = \
 	routines.$(OBJEXT) \
 	ruby.$(OBJEXT) \
 	scheme.$(OBJEXT) \
+	server.$(OBJEXT) \
 	sh.$(OBJEXT) \
 	slang.$(OBJEXT) \
 	sml.$(OBJEXT) \
 	sort.$(OBJEXT) \
 	sql.$(OBJEXT) \
 	strlist.$(OBJEXT) \
+	synthetic.$(OBJEXT) \
+	tagindex.$(OBJEXT) \
 	tcl.$(OBJEXT) \
 	tex.$(OBJEXT) \
 	verilog.$(OBJEXT) \
@@ -17,6 +17,7 @@
 
 #include <ctype.h>	/* to define isalpha () */
 #include <setjmp.h>
+#include <string.h>
 #ifdef DEBUG
 #include <stdio.h>
 #endif
@@ -24,6 +25,7 @@
 #include "debug.h"
 #include "entry.h"
 #include "keyword.h"
+#include "lexer.h"
 #include "parse.h"
 #include "read.h"
 #include "routines.h"
@@ -172,6 +174,7 @@ typedef struct sTokenInfoSQL {
  */
 
 static langType Lang_sql;
+static lexClasses SqlClasses;
 
 static jmp_buf Exception;
 
@@ -318,15 +321,7 @@ static boolean isIdentChar1 (const int c)
 	 * isIdentChar1 is used to identify the first character of an 
 	 * identifier, so we are removing some restrictions.
 	 */
-	return (boolean)
-		(isalpha (c) || c == '@' || c == '_' );
-}
-
-static boolean isIdentChar (const int c)
-{
-	return (boolean)
-		(isalpha (c) || isdigit (c) || c == '$' || 
-		 c == '@' || c == '_' || c == '#');
+	return (boolean) lexIsIdentStartChar (&SqlClasses, c);
 }
 
 static boolean isCmdTerm (tokenInfo *const token)
@@ -473,39 +468,16 @@ static void makeSqlTag (tokenInfo *const token, const sqlKind kind)
 
 static void parseString (vString *const string, const int delimiter)
 {
-	boolean end = FALSE;
-	while (! end)
-	{
-		int c = fileGetc ();
-		if (c == EOF)
-			end = TRUE;
-		/*
-		else if (c == '\\')
-		{
-			c = fileGetc(); // This maybe a ' or ". //
-			vStringPut(string, c);
-		}
-		*/
-		else if (c == delimiter)
-			end = TRUE;
-		else
-			vStringPut (string, c);
-	}
-	vStringTerminate (string);
+	lexReadString (string, delimiter, '\0');  /* no escapes */
 }
 
 /*	Read a C identifier beginning with "firstChar" and places it into "name".
 */
 static void parseIdentifier (vString *const string, const int firstChar)
 {
-	int c = firstChar;
-	Assert (isIdentChar1 (c));
-	do
-	{
-		vStringPut (string, c);
-		c = fileGetc ();
-	} while (isIdentChar (c));
-	vStringTerminate (string);
+	int c;
+	Assert (isIdentChar1 (firstChar));
+	c = lexReadIdentifier (&SqlClasses, string, firstChar);
 	if (!isspace (c))
 		fileUngetc (c);		/* unget non-identifier character */
 }
@@ -519,22 +491,18 @@ static void readToken (tokenInfo *const token)
 	vStringClear (token->string);
 
 getNextChar:
-	do
-	{
-		c = fileGetc ();
-		token->lineNumber   = getSourceLineNumber ();
-		token->filePosition = getInputFilePosition ();
-		/* 
-		 * Added " to the list of ignores, not sure what this 
-		 * might break but it gets by this issue:
-		 *	  create table "t1" (...)
-		 *
-		 * Darren, the code passes all my tests for both 
-		 * Oracle and SQL Anywhere, but maybe you can tell me
-		 * what this may effect.
-		 */
-	}
-	while (c == '\t'  ||  c == ' ' ||  c == '\n');
+	c = lexSkipSpace (&SqlClasses);
+	token->lineNumber   = getSourceLineNumber ();
+	token->filePosition = getInputFilePosition ();
+	/* 
+	 * Added " to the list of ignores, not sure what this 
+	 * might break but it gets by this issue:
+	 *	  create table "t1" (...)
+	 *
+	 * Darren, the code passes all my tests for both 
+	 * Oracle and SQL Anywhere, but maybe you can tell me
+	 * what this may effect.
+	 */
 
 	switch (c)
 	{
@@ -764,6 +732,106 @@ static void skipToMatched(tokenInfo *const token)
 	}
 }
 
+/*
+ * Skips a comment begun by "c", which is '-' or '/', as readToken would,
+ * returning whether there was one. If there was not, the character
+ * following "c" is put back, but "c" itself is not.
+ */
+static boolean skipComment (const int c)
+{
+	boolean skipped = TRUE;
+	int d = fileGetc ();
+
+	if (c == '-' && d == '-')
+		fileSkipToCharacter ('\n');
+	else if (c == '/' && d == '/')
+		fileSkipToCharacter ('\n');
+	else if (c == '/' && d == '*')
+	{
+		do
+		{
+			fileSkipToCharacter ('*');
+			d = fileGetc ();
+			if (d != '/')
+				fileUngetc (d);
+		} while (d != '/' && d != EOF && d != '\0');
+	}
+	else
+	{
+		fileUngetc (d);
+		skipped = FALSE;
+	}
+	return skipped;
+}
+
+/*
+ * Skips the rest of a parenthesized row of data, after its opening
+ * parenthesis, without making tokens of what it holds. Strings, comments
+ * and backslashes are passed over just as readToken would pass over them,
+ * so that the row ends at the same closing parenthesis.
+ */
+static void skipDataRow (void)
+{
+	int nest_level = 1;
+
+	while (nest_level > 0)
+	{
+		size_t length;
+		const unsigned char *const span = fileLineSpan (&length);
+		int c;
+		int d;
+
+		if (span != NULL)
+			fileSkipBytes (strcspn ((const char *) span, "()'\"-/\\"));
+		c = fileGetc ();
+		switch (c)
+		{
+			case EOF: return;
+			case '(': nest_level++;						break;
+			case ')': nest_level--;						break;
+			case '\'':
+			case '"': lexSkipString (c, '\0');			break;
+			case '-':
+			case '/': skipComment (c);					break;
+
+			case '\\':
+					  d = fileGetc ();
+					  if (d != '\\'  && d != '"'  && d != '\''  &&  !isspace (d))
+						  fileUngetc (d);
+					  break;
+
+			default:  break;
+		}
+	}
+}
+
+/*
+ * Skips the rows of data following VALUES, as in
+ *	   insert into t values (1, 'a'), (2, 'b');
+ * Generated scripts may hold a great many such rows, none of which
+ * can define anything. This is only done outside any block, where a
+ * '-' or '/' read in looking for a comment between rows has no meaning.
+ */
+static void skipValues (void)
+{
+	boolean more = TRUE;
+
+	while (more)
+	{
+		int c = lexSkipSpace (&SqlClasses);
+
+		if (c == '(')
+			skipDataRow ();
+		else if (c == '-' || c == '/')
+			more = skipComment (c);
+		else if (c != ',')
+		{
+			fileUngetc (c);
+			more = FALSE;
+		}
+	}
+}
+
 static void skipArgumentList (tokenInfo *const token)
 {
 	/*
@@ -2074,6 +2142,9 @@ static void parseSqlFile (tokenInfo *const token)
 
 		if (isType (token, TOKEN_BLOCK_LABEL_BEGIN))
 			parseLabel (token);
+		else if (isType (token, TOKEN_IDENTIFIER) &&
+				strcasecmp (vStringValue (token->string), "values") == 0)
+			skipValues ();
 		else 
 			parseKeywords (token);
 	} while (! isKeyword (token, KEYWORD_end));
@@ -2083,6 +2154,8 @@ static void initialize (const langType language)
 {
 	Assert (sizeof (SqlKinds) / sizeof (SqlKinds [0]) == SQLTAG_COUNT);
 	Lang_sql = language;
+	lexInitClasses (&SqlClasses, "$@_#", " \t\n");
+	lexRemoveClass (&SqlClasses, "$#", LEX_IDENT_START);
 	buildSqlKeywordHash ();
 }
 
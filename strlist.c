@@ -15,6 +15,7 @@
 #include "general.h"  /* must always come first */
 
 #include <string.h>
+#include <ctype.h>  /* to declare tolower () */
 #ifdef HAVE_FNMATCH_H
 # include <fnmatch.h>
 #endif
@@ -28,12 +29,70 @@
 *   FUNCTION DEFINITIONS
 */
 
+/*
+ *  An indexed list keeps its items in hash chains as well, so that looking
+ *  up a string costs a single probe however long the list grows. Since the
+ *  hash is of the string folded to lower case, the same chains serve for
+ *  lookups ignoring case. Items of an indexed list must not be changed once
+ *  added.
+ */
+
+static unsigned int stringChain (
+		const stringList *const current, const char *const string)
+{
+	unsigned long hash = INITIAL_HASH;
+	const char *p;
+	for (p = string  ;  *p != '\0'  ;  ++p)
+	{
+		const unsigned char c =
+				(unsigned char) tolower ((int) (unsigned char) *p);
+		hash = hashBytes (hash, &c, 1);
+	}
+	return (unsigned int) (hash & (current->chainCount - 1));
+}
+
+static void chainItem (stringList *const current, const unsigned int indx)
+{
+	const unsigned int k = stringChain (current,
+			vStringValue (current->list [indx]));
+	current->next [indx] = current->chains [k];
+	current->chains [k] = (int) indx;
+}
+
+static void rebuildChains (stringList *const current)
+{
+	unsigned int i;
+	if (current->chainCount == 0)
+		current->chainCount = 16;
+	while (current->chainCount < current->count)
+		current->chainCount *= 2;
+	if (current->chains != NULL)
+		eFree (current->chains);
+	current->chains = xMalloc (current->chainCount, int);
+	for (i = 0  ;  i < current->chainCount  ;  ++i)
+		current->chains [i] = -1;
+	for (i = 0  ;  i < current->count  ;  ++i)
+		chainItem (current, i);
+}
+
 extern stringList *stringListNew (void)
 {
 	stringList* const result = xMalloc (1, stringList);
 	result->max   = 0;
 	result->count = 0;
 	result->list  = NULL;
+	result->chains = NULL;
+	result->next  = NULL;
+	result->chainCount = 0;
+	result->indexed = FALSE;
+	return result;
+}
+
+extern stringList *stringListNewIndexed (void)
+{
+	stringList* const result = stringListNew ();
+	result->indexed = TRUE;
+	rebuildChains (result);
 	return result;
 }
 
@@ -50,10 +109,20 @@ extern void stringListAdd (stringList *const current, vString *string)
 	}
 	else if (current->count == current->max)
 	{
-		current->max += incrementalIncrease;
+		/*  Indexed lists may grow large, so grow them geometrically.
+		 */
+		current->max += current->indexed ? current->max : incrementalIncrease;
 		current->list = xRealloc (current->list, current->max, vString*);
 	}
 	current->list [current->count++] = string;
+	if (current->indexed)
+	{
+		current->next = xRealloc (current->next, current->max, int);
+		if (current->count > current->chainCount)
+			rebuildChains (current);
+		else
+			chainItem (current, current->count - 1);
+	}
 }
 
 extern void stringListRemoveLast (stringList *const current)
@@ -61,6 +130,15 @@ extern void stringListRemoveLast (stringList *const current)
 	Assert (current != NULL);
 	Assert (current->count > 0);
 	--current->count;
+	if (current->indexed)
+	{
+		/*  The last item added heads its chain.
+		 */
+		const unsigned int k = stringChain (current,
+				vStringValue (current->list [current->count]));
+		Assert (current->chains [k] == (int) current->count);
+		current->chains [k] = current->next [current->count];
+	}
 	current->list [current->count] = NULL;
 }
 
@@ -140,6 +218,8 @@ extern void stringListClear (stringList *const current)
 		current->list [i] = NULL;
 	}
 	current->count = 0;
+	if (current->indexed)
+		rebuildChains (current);
 }
 
 extern void stringListDelete (stringList *const current)
@@ -152,6 +232,10 @@ extern void stringListDelete (stringList *const current)
 			eFree (current->list);
 			current->list = NULL;
 		}
+		if (current->chains != NULL)
+			eFree (current->chains);
+		if (current->next != NULL)
+			eFree (current->next);
 		current->max   = 0;
 		current->count = 0;
 		eFree (current);
@@ -180,7 +264,18 @@ static int stringListIndex (
 	Assert (current != NULL);
 	Assert (string != NULL);
 	Assert (test != NULL);
-	for (i = 0  ;  result == -1  &&  i < current->count  ;  ++i)
+	if (current->indexed)
+	{
+		/*  Chains run from the latest item, so the whole chain is searched
+		 *  for the earliest match.
+		 */
+		int j;
+		for (j = current->chains [stringChain (current, string)]  ;
+				j != -1  ;  j = current->next [j])
+			if ((*test)(string, current->list [j]))
+				result = j;
+	}
+	else for (i = 0  ;  result == -1  &&  i < current->count  ;  ++i)
 		if ((*test)(string, current->list [i]))
 			result = i;
 	return result;
@@ -232,6 +327,8 @@ extern boolean stringListRemoveExtension (
 				(current->count - where) * sizeof (*current->list));
 		current->list [current->count - 1] = NULL;
 		--current->count;
+		if (current->indexed)
+			rebuildChains (current);
 		result = TRUE;
 	}
 	return result;
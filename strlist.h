@@ -25,12 +25,17 @@ typedef struct sStringList {
 	unsigned int max;
 	unsigned int count;
 	vString    **list;
+	int        *chains;   /* hash chains of an indexed list, or NULL */
+	int        *next;     /* next item in the chain of each item */
+	unsigned int chainCount;
+	boolean    indexed;   /* are items looked up by hash? */
 } stringList;
 
 /*
 *   FUNCTION PROTOTYPES
 */
 extern stringList *stringListNew (void);
+extern stringList *stringListNewIndexed (void);
 extern void stringListAdd (stringList *const current, vString *string);
 extern void stringListRemoveLast (stringList *const current);
 extern void stringListCombine (stringList *const current, stringList *const from);
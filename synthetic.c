@@ -0,0 +1,228 @@
+/*
+*   $Id$
+*
+*   Copyright (c) 2026, Exuberant Ctags contributors
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License.
+*
+*   This module contains functions to make synthetic tags (see
+*   --synthetic-tags), so that making, holding, sorting and writing tags may
+*   be measured apart from parsing. The tags are made through makeTagEntry ()
+*   as a parser would make them, with patterns taken from the lines of a
+*   generated source file. Their names follow a skewed distribution: a few
+*   common names recur often, and the rest share long prefixes, as do the
+*   names of a large project. The same count always makes the same tags.
+*/
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "debug.h"
+#include "entry.h"
+#include "parse.h"
+#include "read.h"
+#include "routines.h"
+#include "synthetic.h"
+#include "vstring.h"
+
+/*
+*   DATA DECLARATIONS
+*/
+enum eSyntheticLimits {
+	SourceLines = 8192,  /* lines of the source file from which patterns come */
+	TagsPerFile = 50,    /* tags attributed to each source file named */
+	Directories = 64,    /* directories in which those files are named */
+	Prefixes    = 256    /* prefixes shared by uncommon names */
+};
+
+/*
+*   DATA DEFINITIONS
+*/
+static unsigned long Seed;
+
+/*  Names found in many files of a large project, most common first. */
+static const char *const CommonNames [] = {
+	"init", "get", "set", "main", "run", "update", "reset", "close", "open",
+	"read", "write", "size", "name", "value", "data", "next", "__init__",
+	"toString", "create", "parse"
+};
+
+static const char *const Words [] = {
+	"Buffer", "Cache", "Channel", "Config", "Context", "Decoder", "Encoder",
+	"Entry", "Event", "Handler", "Index", "Iterator", "Listener", "Manager",
+	"Node", "Parser", "Queue", "Reader", "Record", "Request", "Response",
+	"Scanner", "Session", "Stream", "Table", "Token", "Tree", "Writer"
+};
+
+static const char *const Verbs [] = {
+	"add", "apply", "build", "check", "clear", "copy", "find", "flush",
+	"format", "free", "insert", "load", "lookup", "merge", "remove", "resize",
+	"save", "scan", "split", "store"
+};
+
+static const struct sSyntheticKind {
+	char letter;
+	const char *name;
+} Kinds [] = {
+	{ 'f', "function" }, { 'v', "variable" }, { 'm', "member" },
+	{ 'm', "member" }, { 's', "struct" }, { 'c', "class" }, { 'd', "macro" },
+	{ 'f', "function" }
+};
+
+/*
+*   FUNCTION DEFINITIONS
+*/
+
+#define countOf(array)  (sizeof (array) / sizeof (array [0]))
+
+/*  Returns the next of a sequence of pseudo-random numbers less than 2^23,
+ *  which is the same on every host.
+ */
+static unsigned long nextRandom (void)
+{
+	Seed = (Seed * 1103515245UL + 12345UL) & 0x7fffffffUL;
+	return Seed >> 8;
+}
+
+/*  Returns a pseudo-random number less than "limit", favouring small ones.
+ */
+static unsigned long skewedRandom (const unsigned long limit)
+{
+	const unsigned long a = nextRandom () % limit;
+	const unsigned long b = nextRandom () % limit;
+	return a < b ? a : b;
+}
+
+static void makeName (vString *const name)
+{
+	vStringClear (name);
+	if (nextRandom () % 5 == 0)
+		vStringCatS (name, CommonNames [skewedRandom (countOf (CommonNames))]);
+	else
+	{
+		const unsigned long prefix = skewedRandom (Prefixes);
+		char number [24];
+		sprintf (number, "%02lu", prefix);
+		vStringCatS (name, "Synthetic_Project_Module");
+		vStringCatS (name, number);
+		vStringCatS (name, "_");
+		vStringCatS (name, Words [prefix % countOf (Words)]);
+		vStringCatS (name, "_");
+		vStringCatS (name, Verbs [nextRandom () % countOf (Verbs)]);
+		vStringCatS (name, Words [nextRandom () % countOf (Words)]);
+		if (nextRandom () % 2 == 0)
+		{
+			sprintf (number, "%lu", nextRandom () % 1000);
+			vStringCatS (name, number);
+		}
+	}
+}
+
+/*  Writes the lines of the source file from which the patterns of the tags
+ *  are taken. Most are short, some are long, and some hold characters which
+ *  must be escaped in a pattern.
+ */
+static void writeSourceLines (FILE *const fp)
+{
+	unsigned int i;
+	for (i = 0  ;  i < SourceLines  ;  ++i)
+	{
+		const unsigned long shape = nextRandom () % 20;
+		unsigned long length = (shape < 14) ? 20 + nextRandom () % 60 :
+				(shape < 19) ? 80 + nextRandom () % 120 :
+				200 + nextRandom () % 400;
+		unsigned long written = 0;
+		fputs ((i % 3 == 0) ? "" : "\t", fp);
+		while (written < length)
+		{
+			const char *const word = (nextRandom () % 4 == 0) ?
+					Verbs [nextRandom () % countOf (Verbs)] :
+					Words [nextRandom () % countOf (Words)];
+			const unsigned long kind = nextRandom () % 16;
+			const char *const separator = (kind == 0) ? " / " :
+					(kind == 1) ? "\\\\" : (kind < 5) ? " (" : " ";
+			fputs (word, fp);
+			fputs (separator, fp);
+			written += strlen (word) + strlen (separator);
+		}
+		fputs ((i % 7 == 0) ? ";$\n" : ";\n", fp);
+	}
+}
+
+/*  Makes "count" synthetic tags, as though they had been found in source
+ *  files by a parser.
+ */
+extern void makeSyntheticTags (const unsigned long count)
+{
+	char *sourceName = NULL;
+	FILE *const fp = tempFile ("w", &sourceName);
+	vString *const name = vStringNew ();
+	vString *const parent = vStringNew ();
+	vString *const fileName = vStringNew ();
+	fpos_t *const positions = xMalloc (SourceLines, fpos_t);
+	unsigned int lines = 0;
+	unsigned long i;
+
+	Seed = 1;
+	writeSourceLines (fp);
+	if (fclose (fp) != 0)
+		error (FATAL | PERROR, "cannot write synthetic source file");
+	if (! fileOpen (sourceName, getNamedLanguage ("c")))
+		error (FATAL, "cannot read synthetic source file");
+	while (lines < SourceLines  &&  fileReadLine () != NULL)
+		positions [lines++] = getInputFilePosition ();
+	Assert (lines == SourceLines);
+
+	vStringCopyS (parent, "Synthetic_Project_Base");
+	for (i = 0  ;  i < count  ;  ++i)
+	{
+		const struct sSyntheticKind *const kind =
+				&Kinds [nextRandom () % countOf (Kinds)];
+		const unsigned long line = nextRandom () % lines;
+		const unsigned long file = i / TagsPerFile;
+		tagEntryInfo tag;
+
+		if (i % TagsPerFile == 0)
+		{
+			char path [64];
+			sprintf (path, "src/lib%02lu/module%06lu.c",
+					file % Directories, file);
+			vStringCopyS (fileName, path);
+		}
+		makeName (name);
+		memset (&tag, 0, sizeof (tag));
+		tag.lineNumberEntry = FALSE;
+		tag.lineNumber      = line + 1;
+		tag.filePosition    = positions [line];
+		tag.language        = "C";
+		tag.sourceFileName  = vStringValue (fileName);
+		tag.name            = vStringValue (name);
+		tag.kind            = kind->letter;
+		tag.kindName        = kind->name;
+		tag.isFileScope     = (boolean) (kind->letter == 'v'  &&  line % 2 == 0);
+		if (kind->letter == 'm')
+		{
+			tag.extensionFields.scope [0] = "struct";
+			tag.extensionFields.scope [1] = vStringValue (parent);
+		}
+		makeTagEntry (&tag);
+		if (kind->letter == 's'  ||  kind->letter == 'c')
+			vStringCopy (parent, name);
+	}
+
+	fileClose ();
+	remove (sourceName);
+	eFree (sourceName);
+	eFree (positions);
+	vStringDelete (fileName);
+	vStringDelete (parent);
+	vStringDelete (name);
+}
+
+/* vi:set tabstop=4 shiftwidth=4: */
@@ -0,0 +1,26 @@
+/*
+*   $Id$
+*
+*   Copyright (c) 2026, Exuberant Ctags contributors
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License.
+*
+*   External interface to synthetic.c
+*/
+#ifndef _SYNTHETIC_H
+#define _SYNTHETIC_H
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+/*
+*   FUNCTION PROTOTYPES
+*/
+extern void makeSyntheticTags (const unsigned long count);
+
+#endif  /* _SYNTHETIC_H */
+
+/* vi:set tabstop=4 shiftwidth=4: */
@@ -0,0 +1,767 @@
+/*
+*   $Id$
+*
+*   Copyright (c) 2026, Exuberant Ctags contributors
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License.
+*
+*   This module contains functions to write a binary index of the tag file
+*   (see --tag-index), through which readtags finds tags without searching
+*   or parsing the tag file itself, and a Bloom filter of the names of its
+*   tags (see --tag-bloom), through which readtags passes over tag files
+*   which cannot hold a name without searching them. Each is written beside
+*   the tag file, under its name with INDEX_SUFFIX or BLOOM_SUFFIX appended,
+*   once the tag file is complete.
+*
+*   All numbers in the index are unsigned and stored least significant byte
+*   first, in 4 bytes unless noted otherwise. The index begins with a header
+*   of:
+*
+*       magic     8 bytes, INDEX_MAGIC
+*       version   IndexVersion
+*       count     number of sections described after the header
+*       size      8 bytes, size of the tag file indexed
+*       modified  8 bytes, modification time of the tag file indexed
+*
+*   followed by a table describing each section by an identifier of 4
+*   characters, and its offset and its length within the index in 8 bytes
+*   each. Readers ignore sections they do not know. The sections are:
+*
+*       STRS  the names, file paths and kinds of the tags, each stored once
+*             and terminated by a null; the first is empty
+*       RECS  a record of RecordSize bytes for each tag, in the order of the
+*             tag file, holding the offsets within STRS of its name, file and
+*             kind, its line number (0 if not known), its flags (1 if of file
+*             scope), and in 8 bytes the offset of its line in the tag file
+*       NAME  the numbers of the records in order of name, as by strcmp(),
+*             those of equal names in the order of the tag file
+*       HASH  an open addressed hash table of the names, of a power of 2
+*             slots, each being empty (0) or 1 + the position within NAME of
+*             the first record of a name; the probe for a name starts at its
+*             32-bit FNV-1a hash modulo the number of slots, moving on to the
+*             next slot, and back to the first after the last
+*       FOLD  the numbers of the records in order of name ignoring case, as
+*             for --sort=foldcase, comparing characters folded to upper case,
+*             those of equal names in the order of the tag file
+*       TRIG  an entry of 8 bytes for each trigram (3 consecutive characters,
+*             folded to upper case) of the names, in order of the number
+*             made of its characters, the first most significant, each being
+*             that number and the position within POST of its postings; a
+*             final entry, numbered 0xffffffff, gives the number of postings
+*       POST  the postings of each trigram: the positions within NAME of the
+*             first records of the names in which it occurs, in increasing
+*             order
+*
+*   The Bloom filter begins with a header of:
+*
+*       magic     8 bytes, BLOOM_MAGIC
+*       version   BloomVersion
+*       probes    number of bits set for each name
+*       size      8 bytes, size of the tag file described
+*       modified  8 bytes, modification time of the tag file described
+*
+*   followed by the bits of the filter, of a power of 2 in number, the least
+*   significant bit of each byte first. The bits set for a name, folded to
+*   upper case, are numbered h1 + i * h2 modulo the number of bits for each
+*   i less than the number of probes, where h1 is the 32-bit FNV-1a hash of
+*   the folded name, and h2 is that hash continued over the folded name a
+*   second time, its least significant bit then set.
+*/
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#include <string.h>
+#include <stdio.h>
+#include <ctype.h>
+#ifdef HAVE_STDLIB_H
+# include <stdlib.h>  /* to declare qsort () and strtoul () */
+#endif
+#ifdef HAVE_UNISTD_H
+# include <unistd.h>  /* to declare getpid () */
+#endif
+
+#include "debug.h"
+#include "options.h"
+#include "routines.h"
+#include "tagindex.h"
+#include "vstring.h"
+
+/*
+*   MACROS
+*/
+#define INDEX_SUFFIX  ".idx"
+#define INDEX_MAGIC   "CTAGSIDX"
+#define BLOOM_SUFFIX  ".bloom"
+#define BLOOM_MAGIC   "CTAGSBLM"
+
+/*
+*   DATA DECLARATIONS
+*/
+enum eIndexLimits {
+	IndexVersion = 1,          /* format of index */
+	HeaderSize = 32,           /* bytes in header */
+	SectionEntrySize = 20,     /* bytes describing each section */
+	RecordSize = 28,           /* bytes in each record of RECS */
+	InitialTableSize = 1024,   /* must be a power of 2 */
+	TrigramLength = 3,         /* characters in each trigram */
+	BloomVersion = 1,          /* format of Bloom filter */
+	BloomBitsPerName = 10,     /* when 1% of misses pass the filter */
+	BloomProbes = 7,           /* bits set for each name */
+	BloomMinimumBits = 512
+};
+
+typedef enum eIndexSection {
+	SECTION_STRS, SECTION_RECS, SECTION_NAME, SECTION_HASH, SECTION_FOLD,
+	SECTION_TRIG, SECTION_POST, SECTION_COUNT
+} indexSection;
+
+typedef struct sIndexRecord {
+	unsigned long name;    /* offsets within Strings */
+	unsigned long file;
+	unsigned long kind;
+	unsigned long line;    /* line number, or 0 if not known */
+	boolean fileScope;
+	unsigned long offset;  /* of line in tag file */
+} indexRecord;
+
+typedef struct sTrigramPosting {
+	unsigned long trigram;   /* characters of trigram, first most significant */
+	unsigned long position;  /* within NameOrder of first record of name */
+} trigramPosting;
+
+/*
+*   DATA DEFINITIONS
+*/
+static const char *const SectionIds [SECTION_COUNT] = {
+	"STRS", "RECS", "NAME", "HASH", "FOLD", "TRIG", "POST"
+};
+
+static char *Strings = NULL;            /* string table */
+static unsigned long StringsLength = 0;
+static unsigned long StringsSize = 0;
+static unsigned long *Interned = NULL;  /* hash table of 1 + offsets */
+static unsigned long InternedSize = 0;
+static unsigned long InternedCount = 0;
+static indexRecord *Records = NULL;
+static unsigned long RecordCount = 0;
+static unsigned long RecordMax = 0;
+static unsigned long *NameOrder = NULL; /* record numbers in order of name */
+static unsigned long *FoldOrder = NULL; /* and ignoring case */
+static boolean NamesSorted = TRUE;      /* are records in order of name? */
+static trigramPosting *Postings = NULL; /* in order of trigram and position */
+static unsigned long PostingCount = 0;
+static unsigned long TrigramCount = 0;  /* distinct trigrams in Postings */
+
+/*
+*   FUNCTION DEFINITIONS
+*/
+
+static void freeIndex (void)
+{
+	if (Strings != NULL)
+		eFree (Strings);
+	if (Interned != NULL)
+		eFree (Interned);
+	if (Records != NULL)
+		eFree (Records);
+	if (NameOrder != NULL)
+		eFree (NameOrder);
+	if (FoldOrder != NULL)
+		eFree (FoldOrder);
+	if (Postings != NULL)
+		eFree (Postings);
+	Strings = NULL;
+	StringsLength = StringsSize = 0;
+	Interned = NULL;
+	InternedSize = InternedCount = 0;
+	Records = NULL;
+	RecordCount = RecordMax = 0;
+	NameOrder = NULL;
+	FoldOrder = NULL;
+	NamesSorted = TRUE;
+	Postings = NULL;
+	PostingCount = TrigramCount = 0;
+}
+
+static unsigned long stringHash (const char *const s, const size_t length)
+{
+	return hashBytes (INITIAL_HASH, (const unsigned char *) s, length);
+}
+
+static void insertInterned (const unsigned long offset)
+{
+	const char *const s = Strings + offset;
+	unsigned long i = stringHash (s, strlen (s)) & (InternedSize - 1);
+	while (Interned [i] != 0)
+		i = (i + 1) & (InternedSize - 1);
+	Interned [i] = offset + 1;
+}
+
+static void growInterned (void)
+{
+	unsigned long *const old = Interned;
+	const unsigned long oldSize = InternedSize;
+	unsigned long i;
+
+	InternedSize = (InternedSize == 0) ? InitialTableSize : InternedSize * 2;
+	Interned = xCalloc (InternedSize, unsigned long);
+	for (i = 0  ;  i < oldSize  ;  ++i)
+	{
+		if (old [i] != 0)
+			insertInterned (old [i] - 1);
+	}
+	if (old != NULL)
+		eFree (old);
+}
+
+/*  Returns the offset within the string table of the "length" characters at
+ *  "s", adding them to it unless already there.
+ */
+static unsigned long internString (const char *const s, const size_t length)
+{
+	unsigned long result = 0;
+	boolean found = FALSE;
+	unsigned long i;
+
+	if (2 * (InternedCount + 1) > InternedSize)
+		growInterned ();
+	i = stringHash (s, length) & (InternedSize - 1);
+	while (! found  &&  Interned [i] != 0)
+	{
+		const char *const interned = Strings + Interned [i] - 1;
+		if (strncmp (interned, s, length) == 0  &&  interned [length] == '\0')
+		{
+			result = Interned [i] - 1;
+			found = TRUE;
+		}
+		else
+			i = (i + 1) & (InternedSize - 1);
+	}
+	if (! found)
+	{
+		while (StringsLength + length + 1 > StringsSize)
+		{
+			StringsSize = (StringsSize == 0) ? 4096 : 2 * StringsSize;
+			Strings = xRealloc (Strings, StringsSize, char);
+		}
+		result = StringsLength;
+		memcpy (Strings + StringsLength, s, length);
+		Strings [StringsLength + length] = '\0';
+		StringsLength += length + 1;
+		Interned [i] = result + 1;
+		++InternedCount;
+	}
+	return result;
+}
+
+static indexRecord *newRecord (void)
+{
+	indexRecord *record;
+	if (RecordCount == RecordMax)
+	{
+		RecordMax = (RecordMax == 0) ? 1024 : 2 * RecordMax;
+		Records = xRealloc (Records, RecordMax, indexRecord);
+	}
+	record = &Records [RecordCount++];
+	record->name = 0;
+	record->file = 0;
+	record->kind = 0;
+	record->line = 0;
+	record->fileScope = FALSE;
+	record->offset = 0;
+	return record;
+}
+
+/*  Reads the line next in "fp" whole, unlike readLine(), leaving its line
+ *  terminator in place so that its length is its extent in the file.
+ */
+static boolean readRawLine (vString *const vLine, FILE *const fp)
+{
+	char buffer [BUFSIZ];
+	boolean more = TRUE;
+
+	vStringClear (vLine);
+	while (more  &&  fgets (buffer, (int) sizeof (buffer), fp) != NULL)
+	{
+		const size_t length = strlen (buffer);
+		vStringNCatS (vLine, buffer, length);
+		more = (boolean) (length == 0  ||  buffer [length - 1] != '\n');
+	}
+	return (boolean) (vStringLength (vLine) > 0);
+}
+
+static void parseExtensionFields (char *field, indexRecord *const record)
+{
+	while (field != NULL)
+	{
+		char *const tab = strchr (field, '\t');
+		char *colon;
+		if (tab != NULL)
+			*tab = '\0';
+		colon = strchr (field, ':');
+		if (*field != '\0')
+		{
+			if (colon == NULL)
+				record->kind = internString (field, strlen (field));
+			else if (strncmp (field, "kind:", 5) == 0)
+				record->kind = internString (colon + 1, strlen (colon + 1));
+			else if (strncmp (field, "line:", 5) == 0)
+				record->line = strtoul (colon + 1, NULL, 10);
+			else if (strncmp (field, "file:", 5) == 0)
+				record->fileScope = TRUE;
+		}
+		field = (tab == NULL) ? NULL : tab + 1;
+	}
+}
+
+/*  Records the tag on "line", whose line terminator has been removed, which
+ *  starts at "offset" within the tag file. Pseudo-tags are passed over.
+ */
+static void recordTagLine (char *const line, const unsigned long offset)
+{
+	char *const nameEnd = strchr (line, '\t');
+	char *const file = (nameEnd == NULL) ? NULL : nameEnd + 1;
+	char *const fileEnd = (file == NULL) ? NULL : strchr (file, '\t');
+
+	if (fileEnd != NULL  &&  nameEnd != line  &&  strncmp (line, "!_", 2) != 0)
+	{
+		indexRecord *const record = newRecord ();
+		char *const address = fileEnd + 1;
+		char *end = NULL;  /* of address */
+
+		record->name = internString (line, (size_t) (nameEnd - line));
+		record->file = internString (file, (size_t) (fileEnd - file));
+		record->offset = offset;
+		if (*address == '/'  ||  *address == '?')
+		{
+			end = address;
+			do
+				end = strchr (end + 1, *address);
+			while (end != NULL  &&  end [-1] == '\\');
+			if (end != NULL)
+				++end;
+		}
+		else if (isdigit ((int) *(unsigned char *) address))
+			record->line = strtoul (address, &end, 10);
+		if (end != NULL  &&  strncmp (end, ";\"", 2) == 0)
+			parseExtensionFields (end + 2, record);
+		if (RecordCount > 1  &&  NamesSorted  &&  strcmp (
+				Strings + Records [RecordCount - 2].name,
+				Strings + record->name) > 0)
+			NamesSorted = FALSE;
+	}
+}
+
+static void readTagFile (FILE *const fp)
+{
+	vString *const vLine = vStringNew ();
+	unsigned long offset = 0;
+
+	internString ("", 0);
+	while (readRawLine (vLine, fp))
+	{
+		char *const line = vStringValue (vLine);
+		const size_t length = vStringLength (vLine);
+		line [strcspn (line, "\r\n")] = '\0';
+		recordTagLine (line, offset);
+		offset += length;
+	}
+	vStringDelete (vLine);
+}
+
+static int compareNames (const void *const a, const void *const b)
+{
+	const unsigned long r1 = *(const unsigned long *) a;
+	const unsigned long r2 = *(const unsigned long *) b;
+	int result = strcmp (Strings + Records [r1].name,
+						 Strings + Records [r2].name);
+	if (result == 0)
+		result = (r1 < r2) ? -1 : (r1 > r2);
+	return result;
+}
+
+static int compareFoldedNames (const void *const a, const void *const b)
+{
+	const unsigned long r1 = *(const unsigned long *) a;
+	const unsigned long r2 = *(const unsigned long *) b;
+	const unsigned char *s1 = (const unsigned char *) Strings + Records [r1].name;
+	const unsigned char *s2 = (const unsigned char *) Strings + Records [r2].name;
+	int result;
+	while (*s1 != '\0'  &&  toupper ((int) *s1) == toupper ((int) *s2))
+		++s1, ++s2;
+	result = toupper ((int) *s1) - toupper ((int) *s2);
+	if (result == 0)
+		result = (r1 < r2) ? -1 : (r1 > r2);
+	return result;
+}
+
+static void orderNames (void)
+{
+	unsigned long i;
+	NameOrder = xMalloc (RecordCount + 1, unsigned long);
+	FoldOrder = xMalloc (RecordCount + 1, unsigned long);
+	for (i = 0  ;  i < RecordCount  ;  ++i)
+		NameOrder [i] = i;
+	if (! NamesSorted)
+		qsort (NameOrder, (size_t) RecordCount, sizeof (unsigned long),
+				compareNames);
+	memcpy (FoldOrder, NameOrder, RecordCount * sizeof (unsigned long));
+	qsort (FoldOrder, (size_t) RecordCount, sizeof (unsigned long),
+			compareFoldedNames);
+}
+
+/*  Returns the number of slots in the hash table of names, a power of 2 at
+ *  least twice the number of distinct names.
+ */
+static unsigned long hashSlotCount (void)
+{
+	unsigned long distinct = 0;
+	unsigned long result = 16;
+	unsigned long i;
+	for (i = 0  ;  i < RecordCount  ;  ++i)
+	{
+		if (i == 0  ||  Records [NameOrder [i]].name !=
+						Records [NameOrder [i - 1]].name)
+			++distinct;
+	}
+	while (result < 2 * distinct)
+		result *= 2;
+	return result;
+}
+
+static unsigned long *makeNameHash (const unsigned long slots)
+{
+	unsigned long *const table = xCalloc (slots, unsigned long);
+	unsigned long i;
+	for (i = 0  ;  i < RecordCount  ;  ++i)
+	{
+		const unsigned long name = Records [NameOrder [i]].name;
+		if (i == 0  ||  name != Records [NameOrder [i - 1]].name)
+		{
+			const char *const s = Strings + name;
+			unsigned long slot = stringHash (s, strlen (s)) & (slots - 1);
+			while (table [slot] != 0)
+				slot = (slot + 1) & (slots - 1);
+			table [slot] = i + 1;
+		}
+	}
+	return table;
+}
+
+static int comparePostings (const void *const a, const void *const b)
+{
+	const trigramPosting *const p1 = (const trigramPosting *) a;
+	const trigramPosting *const p2 = (const trigramPosting *) b;
+	int result;
+	if (p1->trigram != p2->trigram)
+		result = (p1->trigram < p2->trigram) ? -1 : 1;
+	else
+		result = (p1->position < p2->position) ? -1 : (p1->position > p2->position);
+	return result;
+}
+
+/*  Lists the trigrams of each distinct name against its first position in
+ *  NameOrder, sorted by trigram, each name listed once under each trigram.
+ */
+static void makePostings (void)
+{
+	unsigned long count = 0;
+	unsigned long i;
+
+	for (i = 0  ;  i < RecordCount  ;  ++i)
+	{
+		const unsigned long name = Records [NameOrder [i]].name;
+		if (i == 0  ||  name != Records [NameOrder [i - 1]].name)
+		{
+			const size_t length = strlen (Strings + name);
+			if (length >= TrigramLength)
+				count += length - TrigramLength + 1;
+		}
+	}
+	Postings = xMalloc (count + 1, trigramPosting);
+	for (i = 0  ;  i < RecordCount  ;  ++i)
+	{
+		const unsigned long name = Records [NameOrder [i]].name;
+		if (i == 0  ||  name != Records [NameOrder [i - 1]].name)
+		{
+			const unsigned char *p = (const unsigned char *) Strings + name;
+			for ( ;  p [0] != '\0'  &&  p [1] != '\0'  &&  p [2] != '\0'  ;  ++p)
+			{
+				trigramPosting *const posting = &Postings [PostingCount++];
+				posting->trigram = ((unsigned long) toupper ((int) p [0]) << 16) |
+						((unsigned long) toupper ((int) p [1]) << 8) |
+						(unsigned long) toupper ((int) p [2]);
+				posting->position = i;
+			}
+		}
+	}
+	Assert (PostingCount == count);
+	qsort (Postings, (size_t) PostingCount, sizeof (trigramPosting),
+			comparePostings);
+
+	/*  Drop the repeated postings of trigrams occurring more than once in a
+	 *  name, counting the distinct trigrams.
+	 */
+	count = 0;
+	for (i = 0  ;  i < PostingCount  ;  ++i)
+	{
+		if (count == 0  ||  comparePostings (&Postings [i],
+											 &Postings [count - 1]) != 0)
+		{
+			if (count == 0  ||  Postings [i].trigram != Postings [count - 1].trigram)
+				++TrigramCount;
+			Postings [count++] = Postings [i];
+		}
+	}
+	PostingCount = count;
+}
+
+static void writeNumber (FILE *const fp, unsigned long value,
+						 const unsigned int bytes)
+{
+	unsigned int i;
+	for (i = 0  ;  i < bytes  ;  ++i)
+	{
+		putc ((int) (value & 0xff), fp);
+		value >>= 8;
+	}
+}
+
+static void writeStatus (FILE *const fp, const fileStatus *const status)
+{
+	writeNumber (fp, status->size, 8);
+	writeNumber (fp, status->modified, 8);
+}
+
+static void writeIndex (FILE *const fp, const fileStatus *const status)
+{
+	const unsigned long slots = hashSlotCount ();
+	unsigned long *const table = makeNameHash (slots);
+	unsigned long lengths [SECTION_COUNT];
+	unsigned long offset = HeaderSize + SECTION_COUNT * SectionEntrySize;
+	unsigned long i;
+	int s;
+
+	lengths [SECTION_STRS] = StringsLength;
+	lengths [SECTION_RECS] = RecordCount * RecordSize;
+	lengths [SECTION_NAME] = RecordCount * 4;
+	lengths [SECTION_HASH] = slots * 4;
+	lengths [SECTION_FOLD] = RecordCount * 4;
+	lengths [SECTION_TRIG] = (TrigramCount + 1) * 8;
+	lengths [SECTION_POST] = PostingCount * 4;
+
+	fputs (INDEX_MAGIC, fp);
+	writeNumber (fp, IndexVersion, 4);
+	writeNumber (fp, SECTION_COUNT, 4);
+	writeStatus (fp, status);
+	for (s = 0  ;  s < SECTION_COUNT  ;  ++s)
+	{
+		fputs (SectionIds [s], fp);
+		writeNumber (fp, offset, 8);
+		writeNumber (fp, lengths [s], 8);
+		offset += lengths [s];
+	}
+	fwrite (Strings, 1, (size_t) StringsLength, fp);
+	for (i = 0  ;  i < RecordCount  ;  ++i)
+	{
+		const indexRecord *const record = &Records [i];
+		writeNumber (fp, record->name, 4);
+		writeNumber (fp, record->file, 4);
+		writeNumber (fp, record->kind, 4);
+		writeNumber (fp, record->line, 4);
+		writeNumber (fp, record->fileScope ? 1 : 0, 4);
+		writeNumber (fp, record->offset, 8);
+	}
+	for (i = 0  ;  i < RecordCount  ;  ++i)
+		writeNumber (fp, NameOrder [i], 4);
+	for (i = 0  ;  i < slots  ;  ++i)
+		writeNumber (fp, table [i], 4);
+	for (i = 0  ;  i < RecordCount  ;  ++i)
+		writeNumber (fp, FoldOrder [i], 4);
+	for (i = 0  ;  i < PostingCount  ;  ++i)
+	{
+		if (i == 0  ||  Postings [i].trigram != Postings [i - 1].trigram)
+		{
+			writeNumber (fp, Postings [i].trigram, 4);
+			writeNumber (fp, i, 4);
+		}
+	}
+	writeNumber (fp, 0xffffffffUL, 4);
+	writeNumber (fp, PostingCount, 4);
+	for (i = 0  ;  i < PostingCount  ;  ++i)
+		writeNumber (fp, Postings [i].position, 4);
+	eFree (table);
+}
+
+static unsigned long foldedHash (unsigned long hash, const char *s)
+{
+	for ( ;  *s != '\0'  ;  ++s)
+	{
+		hash ^= (unsigned long) toupper ((int) *(const unsigned char *) s);
+		hash = (hash * 16777619UL) & 0xffffffffUL;
+	}
+	return hash;
+}
+
+static void writeBloom (FILE *const fp, const fileStatus *const status)
+{
+	unsigned long bits = BloomMinimumBits;
+	unsigned char *filter;
+	unsigned long i;
+
+	while (bits < BloomBitsPerName * RecordCount)
+		bits *= 2;
+	filter = xCalloc (bits / 8, unsigned char);
+	for (i = 0  ;  i < RecordCount  ;  ++i)
+	{
+		const char *const name = Strings + Records [i].name;
+		const unsigned long h1 = foldedHash (INITIAL_HASH, name);
+		const unsigned long h2 = foldedHash (h1, name) | 1;
+		unsigned long bit = h1;
+		int probe;
+		for (probe = 0  ;  probe < BloomProbes  ;  ++probe)
+		{
+			const unsigned long b = bit & (bits - 1);
+			filter [b / 8] |= (unsigned char) (1 << (b % 8));
+			bit = (bit + h2) & 0xffffffffUL;
+		}
+	}
+	fputs (BLOOM_MAGIC, fp);
+	writeNumber (fp, BloomVersion, 4);
+	writeNumber (fp, BloomProbes, 4);
+	writeStatus (fp, status);
+	fwrite (filter, 1, (size_t) (bits / 8), fp);
+	eFree (filter);
+}
+
+static vString *sidecarName (const char *const tagFileName,
+							 const char *const suffix)
+{
+	vString *const name = vStringNewInit (tagFileName);
+	vStringCatS (name, suffix);
+	return name;
+}
+
+/*  Names the file under which a sidecar is written before being renamed,
+ *  so that readers never see it incomplete.
+ */
+static vString *writtenName (const vString *const name)
+{
+	vString *const written = vStringNewCopy (name);
+	char number [24];
+#ifdef HAVE_UNISTD_H
+	sprintf (number, ".%lu", (unsigned long) getpid ());
+#else
+	strcpy (number, ".new");
+#endif
+	vStringCatS (written, number);
+	return written;
+}
+
+/*  Writes the file beside the named tag file with "suffix" appended to its
+ *  name, described as "what", using "writer".
+ */
+static void writeSidecar (const char *const tagFileName,
+		const char *const suffix, const char *const what,
+		void (*writer) (FILE *const, const fileStatus *const),
+		const fileStatus *const status)
+{
+	vString *const name = sidecarName (tagFileName, suffix);
+	vString *const written = writtenName (name);
+	FILE *const fp = fopen (vStringValue (written), "wb");
+
+	verbose ("writing %s \"%s\"\n", what, vStringValue (name));
+	if (fp == NULL)
+		error (WARNING | PERROR, "cannot write %s \"%s\"", what,
+				vStringValue (written));
+	else
+	{
+		boolean ok;
+		writer (fp, status);
+		ok = (boolean) (! ferror (fp));
+		if (fclose (fp) != 0)
+			ok = FALSE;
+		if (ok  &&  rename (vStringValue (written), vStringValue (name)) != 0)
+		{
+			/* some hosts will not rename over an existing file */
+			remove (vStringValue (name));
+			ok = (boolean) (rename (vStringValue (written),
+						vStringValue (name)) == 0);
+		}
+		if (! ok)
+		{
+			error (WARNING | PERROR, "cannot write %s \"%s\"", what,
+					vStringValue (name));
+			remove (vStringValue (written));
+		}
+	}
+	vStringDelete (written);
+	vStringDelete (name);
+}
+
+/*  Removes any file left beside the named tag file by an earlier run with
+ *  "suffix" appended to its name, which no longer describes it.
+ */
+static void removeSidecar (const char *const tagFileName,
+		const char *const suffix, const char *const what)
+{
+	vString *const name = sidecarName (tagFileName, suffix);
+	if (doesFileExist (vStringValue (name)))
+	{
+		verbose ("removing out of date %s \"%s\"\n", what, vStringValue (name));
+		remove (vStringValue (name));
+	}
+	vStringDelete (name);
+}
+
+/*  Writes the index and Bloom filter of the named tag file, once it has
+ *  been written, as selected by --tag-index and --tag-bloom, removing any
+ *  left by an earlier run which are not.
+ */
+extern void writeTagIndex (const char *const tagFileName)
+{
+	FILE *const tagFp = fopen (tagFileName, "rb");
+	fileStatus *status;
+
+	/*  Discard any status of the tag file obtained before it was written.
+	 */
+	eStatFree (eStat (tagFileName));
+	status = eStat (tagFileName);
+	if (tagFp == NULL)
+		error (WARNING | PERROR, "cannot read \"%s\" to index it", tagFileName);
+	else
+	{
+		readTagFile (tagFp);
+		fclose (tagFp);
+		if (! Option.tagIndex)
+			removeSidecar (tagFileName, INDEX_SUFFIX, "tag index");
+		else
+		{
+			orderNames ();
+			makePostings ();
+			writeSidecar (tagFileName, INDEX_SUFFIX, "tag index",
+					writeIndex, status);
+		}
+		if (! Option.tagBloom)
+			removeSidecar (tagFileName, BLOOM_SUFFIX, "tag Bloom filter");
+		else
+			writeSidecar (tagFileName, BLOOM_SUFFIX, "tag Bloom filter",
+					writeBloom, status);
+		freeIndex ();
+	}
+}
+
+/*  Removes any index or Bloom filter left beside the named tag file by an
+ *  earlier run, which no longer describe it.
+ */
+extern void removeTagIndex (const char *const tagFileName)
+{
+	removeSidecar (tagFileName, INDEX_SUFFIX, "tag index");
+	removeSidecar (tagFileName, BLOOM_SUFFIX, "tag Bloom filter");
+}
+
+/* vi:set tabstop=4 shiftwidth=4: */
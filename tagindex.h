@@ -0,0 +1,27 @@
+/*
+*   $Id$
+*
+*   Copyright (c) 2026, Exuberant Ctags contributors
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License.
+*
+*   External interface to tagindex.c
+*/
+#ifndef _TAGINDEX_H
+#define _TAGINDEX_H
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+/*
+*   FUNCTION PROTOTYPES
+*/
+extern void writeTagIndex (const char *const tagFileName);
+extern void removeTagIndex (const char *const tagFileName);
+
+#endif  /* _TAGINDEX_H */
+
+/* vi:set tabstop=4 shiftwidth=4: */
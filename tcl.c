@@ -33,6 +33,14 @@ static kindOption TclKinds [] = {
 	{ TRUE, 'p', "procedure", "procedures" }
 };
 
+/*  Every line tagged contains one of these words, as in "itcl::class" or
+ *  "public method".
+ */
+static const char *const TclTriggerWords [] = {
+	"proc", "class", "method", NULL
+};
+static lineTriggers TclTriggers = { TclTriggerWords, 0, 0, { 0 } };
+
 /*
 *   FUNCTION DEFINITIONS
 */
@@ -63,7 +71,7 @@ static void findTclTags (void)
 	vString *name = vStringNew ();
 	const unsigned char *line;
 
-	while ((line = fileReadLine ()) != NULL)
+	while ((line = fileReadLineContaining (&TclTriggers)) != NULL)
 	{
 		const unsigned char *cp;
 
@@ -25,6 +25,7 @@
 #include "debug.h"
 #include "entry.h"
 #include "keyword.h"
+#include "lexer.h"
 #include "parse.h"
 #include "read.h"
 #include "routines.h"
@@ -107,6 +108,7 @@ typedef struct sTokenInfo {
  */
 
 static langType Lang_js;
+static lexClasses TexClasses;
 
 static jmp_buf Exception;
 
@@ -148,9 +150,7 @@ static const keywordDesc TexKeywordTable [] = {
 
 static boolean isIdentChar (const int c)
 {
-	return (boolean)
-		(isalpha (c) || isdigit (c) || c == '$' || 
-		  c == '_' || c == '#');
+	return (boolean) lexIsIdentChar (&TexClasses, c);
 }
 
 static void buildTexKeywordHash (void)
@@ -237,23 +237,7 @@ static void makeTexTag (tokenInfo *const token, texKind kind)
 
 static void parseString (vString *const string, const int delimiter)
 {
-	boolean end = FALSE;
-	while (! end)
-	{
-		int c = fileGetc ();
-		if (c == EOF)
-			end = TRUE;
-		else if (c == '\\')
-		{
-			c = fileGetc(); /* This maybe a ' or ". */
-			vStringPut (string, c);
-		}
-		else if (c == delimiter)
-			end = TRUE;
-		else
-			vStringPut (string, c);
-	}
-	vStringTerminate (string);
+	lexReadString (string, delimiter, '\\');
 }
 
 /*	
@@ -262,15 +246,9 @@ static void parseString (vString *const string, const int delimiter)
  */
 static void parseIdentifier (vString *const string, const int firstChar)
 {
-	int c = firstChar;
-	Assert (isIdentChar (c));
-	do
-	{
-		vStringPut (string, c);
-		c = fileGetc ();
-	} while (isIdentChar (c));
-
-	vStringTerminate (string);
+	int c;
+	Assert (isIdentChar (firstChar));
+	c = lexReadIdentifier (&TexClasses, string, firstChar);
 	if (!isspace (c))
 		fileUngetc (c);		/* unget non-identifier character */
 }
@@ -284,13 +262,9 @@ static void readToken (tokenInfo *const token)
 	vStringClear (token->string);
 
 getNextChar:
-	do
-	{
-		c = fileGetc ();
-		token->lineNumber   = getSourceLineNumber ();
-		token->filePosition = getInputFilePosition ();
-	}
-	while (c == '\t'  ||  c == ' ' ||  c == '\n');
+	c = lexSkipSpace (&TexClasses);
+	token->lineNumber   = getSourceLineNumber ();
+	token->filePosition = getInputFilePosition ();
 
 	switch (c)
 	{
@@ -490,6 +464,7 @@ static void initialize (const langType language)
 {
 	Assert (sizeof (TexKinds) / sizeof (TexKinds [0]) == TEXTAG_COUNT);
 	Lang_js = language;
+	lexInitClasses (&TexClasses, "$_#", " \t\n");
 	buildTexKeywordHash ();
 }
 
@@ -0,0 +1,53 @@
+/*
+*   $Id$
+*
+*   Copyright (c) 2026, Exuberant Ctags contributors
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License.
+*
+*   Static probes at the main steps of tagging (see --enable-tracing), for
+*   use with DTrace, SystemTap, bpftrace or perf. Each probe belongs to the
+*   provider "ctags". Where tracing is not enabled, probes compile to
+*   nothing, and their arguments are not even evaluated. When it is, an idle
+*   probe costs a single no-op instruction.
+*
+*   Probes and their arguments:
+*     file__open (name, language)    source file opened
+*     file__close (name, lines)      source file closed
+*     parse__begin (name, language)  parsing of a file begins
+*     parse__end (name, tags)        parsing of a file ends
+*     parse__retry (name, pass)      file is parsed again by its parser
+*     tag__entry (name, file)        tag made
+*     regex__match (line, language)  line matched against regex patterns
+*     sort__begin (tag file)         tag file is sorted and written
+*     sort__end (tag file)
+*     index__begin (tag file)        index of tag file is written
+*     index__end (tag file)
+*/
+#ifndef _TRACE_H
+#define _TRACE_H
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#ifdef ENABLE_TRACING
+# include <sys/sdt.h>
+#endif
+
+/*
+*   MACROS
+*/
+#ifdef ENABLE_TRACING
+# define TracePoint1(probe,a)    DTRACE_PROBE1 (ctags, probe, a)
+# define TracePoint2(probe,a,b)  DTRACE_PROBE2 (ctags, probe, a, b)
+#else
+# define TracePoint1(probe,a)
+# define TracePoint2(probe,a,b)
+#endif
+
+#endif  /* _TRACE_H */
+
+/* vi:set tabstop=4 shiftwidth=4: */
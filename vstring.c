@@ -22,10 +22,25 @@
 #include "routines.h"
 #include "vstring.h"
 
+/*
+*   DATA DECLARATIONS
+*/
+enum eVStringSpares {
+	/*  Most deleted vStrings kept to be reused by vStringNew ().
+	 */
+	vStringSpareCount = 64
+};
+
 /*
 *   DATA DEFINITIONS
 */
-static const size_t vStringInitialSize = 32;
+
+/*  vStrings deleted since the last input file was closed, so that a parser
+ *  which makes and deletes a vString for each token or scope reuses them
+ *  rather than allocating each anew.
+ */
+static vString *Spares [vStringSpareCount];
+static unsigned int SpareCount = 0;
 
 /*
 *   FUNCTION DEFINITIONS
@@ -33,8 +48,15 @@ static const size_t vStringInitialSize = 32;
 
 static void vStringResize (vString *const string, const size_t newSize)
 {
-	char *const newBuffer = xRealloc (string->buffer, newSize, char);
+	char *newBuffer;
 
+	if (string->buffer != string->local)
+		newBuffer = xRealloc (string->buffer, newSize, char);
+	else
+	{
+		newBuffer = xMalloc (newSize, char);
+		memcpy (newBuffer, string->local, string->size);
+	}
 	string->size = newSize;
 	string->buffer = newBuffer;
 }
@@ -67,19 +89,23 @@ extern void vStringDelete (vString *const string)
 {
 	if (string != NULL)
 	{
-		if (string->buffer != NULL)
+		if (string->buffer != string->local)
 			eFree (string->buffer);
-		eFree (string);
+		if (SpareCount < vStringSpareCount)
+			Spares [SpareCount++] = string;
+		else
+			eFree (string);
 	}
 }
 
 extern vString *vStringNew (void)
 {
-	vString *const string = xMalloc (1, vString);
+	vString *const string =
+			(SpareCount > 0) ? Spares [--SpareCount] : xMalloc (1, vString);
 
 	string->length = 0;
 	string->size   = vStringInitialSize;
-	string->buffer = xMalloc (string->size, char);
+	string->buffer = string->local;
 
 	vStringClear (string);
 
@@ -131,16 +157,17 @@ extern vString *vStringNewInit (const char *const s)
 extern void vStringNCatS (
 		vString *const string, const char *const s, const size_t length)
 {
-	const char *p = s;
-	size_t remain = length;
+	const char *const end = memchr (s, '\0', length);
+	const size_t count = (end == NULL) ? length : (size_t) (end - s);
+	size_t newSize = string->size;
 
-	while (*p != '\0'  &&  remain > 0)
-	{
-		vStringPut (string, *p);
-		--remain;
-		++p;
-	}
-	vStringTerminate (string);
+	while (string->length + count + 1 > newSize)
+		newSize *= 2;
+	if (newSize > string->size)
+		vStringResize (string, newSize);
+	memcpy (string->buffer + string->length, s, count);
+	string->length += count;
+	string->buffer [string->length] = '\0';
 }
 
 /*  Strip trailing newline from string.
@@ -229,4 +256,13 @@ extern void vStringSetLength (vString *const string)
 	string->length = strlen (string->buffer);
 }
 
+/*  Frees the vStrings kept for reuse, as when an input file is closed, so
+ *  that they hold no memory between files.
+ */
+extern void vStringReleaseSpares (void)
+{
+	while (SpareCount > 0)
+		eFree (Spares [--SpareCount]);
+}
+
 /* vi:set tabstop=4 shiftwidth=4: */
@@ -51,10 +51,15 @@
 *   DATA DECLARATIONS
 */
 
+enum eVStringLimits {
+	vStringInitialSize = 32  /* of buffer held within a vString */
+};
+
 typedef struct sVString {
 	size_t  length;  /* size of buffer used */
 	size_t  size;    /* allocated size of buffer */
 	char   *buffer;  /* location of buffer */
+	char    local [vStringInitialSize];  /* buffer, until a larger is needed */
 } vString;
 
 /*
@@ -79,6 +84,7 @@ extern void vStringCopyS (vString *const string, const char *const s);
 extern void vStringNCopyS (vString *const string, const char *const s, const size_t length);
 extern void vStringCopyToLower (vString *const dest, const vString *const src);
 extern void vStringSetLength (vString *const string);
+extern void vStringReleaseSpares (void);
 
 #endif  /* _VSTRING_H */
 
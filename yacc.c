@@ -16,24 +16,68 @@
 
 #include <string.h>
 #include "parse.h"
+#include "read.h"
+#include "vstring.h"
+
+/*
+*   DATA DEFINITIONS
+*/
+typedef enum {
+	K_LABEL
+} yaccKind;
+
+static kindOption YaccKinds [] = {
+	{ TRUE, 'l', "label", "labels" }
+};
 
 /*
 *   FUNCTION DEFINITIONS
 */
 
-static void installYaccRegex (const langType language)
+static boolean isLetter (const int c)
 {
-	addTagRegex (language,
-		"^([A-Za-z][A-Za-z_0-9]+)[ \t]*:", "\\1", "l,label,labels", NULL);
+	return (boolean) ((c >= 'A'  &&  c <= 'Z')  ||  (c >= 'a'  &&  c <= 'z'));
+}
+
+/*  Makes a tag for a line beginning with a rule of the form
+ *  label:
+ *  where the label is at least two characters long.
+ */
+static void findYaccTags (void)
+{
+	vString *const name = vStringNew ();
+	const unsigned char *line;
+
+	while ((line = fileReadLine ()) != NULL)
+	{
+		const unsigned char *cp = line;
+		if (isLetter ((int) *cp))
+		{
+			++cp;
+			while (isLetter ((int) *cp)  ||  (*cp >= '0'  &&  *cp <= '9')  ||
+					*cp == '_')
+				++cp;
+		}
+		if (cp - line >= 2)
+		{
+			vStringNCopyS (name, (const char*) line, cp - line);
+			while (*cp == ' '  ||  *cp == '\t')
+				++cp;
+			if (*cp == ':')
+				makeSimpleTag (name, YaccKinds, K_LABEL);
+		}
+	}
+	vStringDelete (name);
 }
 
 extern parserDefinition* YaccParser ()
 {
 	static const char *const extensions [] = { "y", NULL };
 	parserDefinition* const def = parserNew ("YACC");
+	def->kinds      = YaccKinds;
+	def->kindCount  = KIND_COUNT (YaccKinds);
 	def->extensions = extensions;
-	def->initialize = installYaccRegex;
-	def->regex      = TRUE;
+	def->parser     = findYaccTags;
 	return def;
 }
 